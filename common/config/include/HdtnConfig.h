@@ -79,7 +79,18 @@ public:
     uint64_t m_maxBundleSizeBytes;
     uint64_t m_maxIngressBundleWaitOnEgressMilliseconds;
     bool m_bufferRxToStorageOnLinkUpSaturation;
+    uint64_t m_numIngressBundleProcessingWorkers; //if non-zero, ingress decodes and routes induct bundles on up to this many worker threads instead of on the induct threads
     uint64_t m_maxLtpReceiveUdpPacketSizeBytes;
+    uint64_t m_maxLtpUdpPacketsToReceivePerSystemCall; //if greater than 1, LTP udp sockets pull up to this many packets per recvmmsg system call
+    bool m_ltpUdpSegmentationOffload; //linux only: if true, LTP udp sockets use UDP_SEGMENT (GSO, batch senders only) and UDP_GRO
+    uint64_t m_numLtpUdpReceiveThreadsPerPort; //linux only: if greater than 1, each LTP bound udp port gets this many SO_REUSEPORT sockets, each with its own receive thread
+    uint64_t m_oneProcessBundleRingCapacity; //hdtn-one-process only: if non-zero, bundles move between modules over rings of this capacity instead of inproc zmq sockets
+    std::string m_sharedMemoryBundleArenaName; //separate processes only: if non-empty, the name of the shared memory bundle arena used by the links selected below
+    uint64_t m_sharedMemoryBundleArenaNumSlots;
+    uint64_t m_sharedMemoryBundleArenaSlotSizeBytes; //larger bundles are sent over zmq
+    bool m_sharedMemoryIngressToEgress;
+    bool m_sharedMemoryIngressToStorage;
+    bool m_sharedMemoryStorageToEgress;
 
     std::string m_zmqIngressAddress;
     std::string m_zmqEgressAddress;
@@ -54,6 +54,11 @@ struct induct_element_config_t {
     uint64_t ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     uint64_t ltpMaxExpectedSimultaneousSessions;
     uint64_t ltpMaxUdpPacketsToSendPerSystemCall;
+    uint64_t ltpRxRedPartSpillThresholdBytes; //red parts larger than this are received into a file (0 to disable)
+    std::string ltpRxRedPartSpillDirectory;
+
+    //specific to udp
+    bool udpGenericReceiveOffload; //linux only: enable UDP_GRO and split coalesced datagrams back into bundles
 
     //specific to stcp and tcpcl
     uint32_t keepAliveIntervalSeconds;
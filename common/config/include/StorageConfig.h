@@ -96,7 +96,15 @@ public:
     std::string m_storageImplementation;
     bool m_tryToRestoreFromDisk;
     bool m_autoDeleteFilesOnExit;
+    bool m_useDirectIo; //open disk files with O_DIRECT (only used by the io_uring implementation)
+    bool m_useLockFreeSegmentAllocator; //MemoryManagerTreeArray lock-free allocation mode
+    uint32_t m_diskQueueDepth; //max concurrent segment operations per disk (asio_single_threaded and io_uring implementations)
     uint64_t m_totalStorageCapacityBytes;
+    std::string m_catalogJournalFilePath; //if not empty, path to a memory mapped catalog journal used for fast restore (full disk scan is the fallback)
+    uint64_t m_hotTierCacheBytes; //if nonzero, max bytes of recently stored bundles kept in memory so that they are released without a disk round trip
+    uint64_t m_hotTierWriteBackDelayMilliseconds; //bundles still in the hot tier after this long are written to disk (evictions are written sooner)
+    uint64_t m_slabSlotSizeBytes; //if nonzero, bundles that fit in a slot of this size (including a 24 byte slot header) are packed several per segment
+    uint64_t m_largeBundleExtentMinBytes; //if nonzero, bundles of at least this size are allocated in whole 64 segment extents (the last one trimmed)
     storage_disk_config_vector_t m_storageDiskConfigVector;
 };
 
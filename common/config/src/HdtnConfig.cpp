@@ -2,7 +2,7 @@
  * @file HdtnConfig.cpp
  * @author  Brian Tomko <brian.j.tomko@nasa.gov>
  *
- * @copyright Copyright  2021 United States Government as represented by
+ * @copyright Copyright � 2021 United States Government as represented by
  * the National Aeronautics and Space Administration.
  * No copyright is claimed in the United States under Title 17, U.S.Code.
  * All Other Rights Reserved.
@@ -38,7 +38,18 @@ HdtnConfig::HdtnConfig() :
     m_maxBundleSizeBytes(10000000), //10MB
     m_maxIngressBundleWaitOnEgressMilliseconds(2000),
     m_bufferRxToStorageOnLinkUpSaturation(false),
+    m_numIngressBundleProcessingWorkers(0),
     m_maxLtpReceiveUdpPacketSizeBytes(65536),
+    m_maxLtpUdpPacketsToReceivePerSystemCall(1),
+    m_ltpUdpSegmentationOffload(false),
+    m_numLtpUdpReceiveThreadsPerPort(1),
+    m_oneProcessBundleRingCapacity(0),
+    m_sharedMemoryBundleArenaName(""),
+    m_sharedMemoryBundleArenaNumSlots(0),
+    m_sharedMemoryBundleArenaSlotSizeBytes(65536),
+    m_sharedMemoryIngressToEgress(false),
+    m_sharedMemoryIngressToStorage(false),
+    m_sharedMemoryStorageToEgress(false),
     m_zmqIngressAddress("localhost"),
     m_zmqEgressAddress("localhost"),
     m_zmqStorageAddress("localhost"),
@@ -78,7 +89,18 @@ HdtnConfig::HdtnConfig(const HdtnConfig& o) :
     m_maxBundleSizeBytes(o.m_maxBundleSizeBytes),
     m_maxIngressBundleWaitOnEgressMilliseconds(o.m_maxIngressBundleWaitOnEgressMilliseconds),
     m_bufferRxToStorageOnLinkUpSaturation(o.m_bufferRxToStorageOnLinkUpSaturation),
+    m_numIngressBundleProcessingWorkers(o.m_numIngressBundleProcessingWorkers),
     m_maxLtpReceiveUdpPacketSizeBytes(o.m_maxLtpReceiveUdpPacketSizeBytes),
+    m_maxLtpUdpPacketsToReceivePerSystemCall(o.m_maxLtpUdpPacketsToReceivePerSystemCall),
+    m_ltpUdpSegmentationOffload(o.m_ltpUdpSegmentationOffload),
+    m_numLtpUdpReceiveThreadsPerPort(o.m_numLtpUdpReceiveThreadsPerPort),
+    m_oneProcessBundleRingCapacity(o.m_oneProcessBundleRingCapacity),
+    m_sharedMemoryBundleArenaName(o.m_sharedMemoryBundleArenaName),
+    m_sharedMemoryBundleArenaNumSlots(o.m_sharedMemoryBundleArenaNumSlots),
+    m_sharedMemoryBundleArenaSlotSizeBytes(o.m_sharedMemoryBundleArenaSlotSizeBytes),
+    m_sharedMemoryIngressToEgress(o.m_sharedMemoryIngressToEgress),
+    m_sharedMemoryIngressToStorage(o.m_sharedMemoryIngressToStorage),
+    m_sharedMemoryStorageToEgress(o.m_sharedMemoryStorageToEgress),
     m_zmqIngressAddress(o.m_zmqIngressAddress),
     m_zmqEgressAddress(o.m_zmqEgressAddress),
     m_zmqStorageAddress(o.m_zmqStorageAddress),
@@ -115,7 +137,18 @@ HdtnConfig::HdtnConfig(HdtnConfig&& o) :
     m_maxBundleSizeBytes(o.m_maxBundleSizeBytes),
     m_maxIngressBundleWaitOnEgressMilliseconds(o.m_maxIngressBundleWaitOnEgressMilliseconds),
     m_bufferRxToStorageOnLinkUpSaturation(o.m_bufferRxToStorageOnLinkUpSaturation),
+    m_numIngressBundleProcessingWorkers(o.m_numIngressBundleProcessingWorkers),
     m_maxLtpReceiveUdpPacketSizeBytes(o.m_maxLtpReceiveUdpPacketSizeBytes),
+    m_maxLtpUdpPacketsToReceivePerSystemCall(o.m_maxLtpUdpPacketsToReceivePerSystemCall),
+    m_ltpUdpSegmentationOffload(o.m_ltpUdpSegmentationOffload),
+    m_numLtpUdpReceiveThreadsPerPort(o.m_numLtpUdpReceiveThreadsPerPort),
+    m_oneProcessBundleRingCapacity(o.m_oneProcessBundleRingCapacity),
+    m_sharedMemoryBundleArenaName(std::move(o.m_sharedMemoryBundleArenaName)),
+    m_sharedMemoryBundleArenaNumSlots(o.m_sharedMemoryBundleArenaNumSlots),
+    m_sharedMemoryBundleArenaSlotSizeBytes(o.m_sharedMemoryBundleArenaSlotSizeBytes),
+    m_sharedMemoryIngressToEgress(o.m_sharedMemoryIngressToEgress),
+    m_sharedMemoryIngressToStorage(o.m_sharedMemoryIngressToStorage),
+    m_sharedMemoryStorageToEgress(o.m_sharedMemoryStorageToEgress),
     m_zmqIngressAddress(std::move(o.m_zmqIngressAddress)),
     m_zmqEgressAddress(std::move(o.m_zmqEgressAddress)),
     m_zmqStorageAddress(std::move(o.m_zmqStorageAddress)),
@@ -152,7 +185,18 @@ HdtnConfig& HdtnConfig::operator=(const HdtnConfig& o) {
     m_maxBundleSizeBytes = o.m_maxBundleSizeBytes;
     m_maxIngressBundleWaitOnEgressMilliseconds = o.m_maxIngressBundleWaitOnEgressMilliseconds;
     m_bufferRxToStorageOnLinkUpSaturation = o.m_bufferRxToStorageOnLinkUpSaturation;
+    m_numIngressBundleProcessingWorkers = o.m_numIngressBundleProcessingWorkers;
     m_maxLtpReceiveUdpPacketSizeBytes = o.m_maxLtpReceiveUdpPacketSizeBytes;
+    m_maxLtpUdpPacketsToReceivePerSystemCall = o.m_maxLtpUdpPacketsToReceivePerSystemCall;
+    m_ltpUdpSegmentationOffload = o.m_ltpUdpSegmentationOffload;
+    m_numLtpUdpReceiveThreadsPerPort = o.m_numLtpUdpReceiveThreadsPerPort;
+    m_oneProcessBundleRingCapacity = o.m_oneProcessBundleRingCapacity;
+    m_sharedMemoryBundleArenaName = o.m_sharedMemoryBundleArenaName;
+    m_sharedMemoryBundleArenaNumSlots = o.m_sharedMemoryBundleArenaNumSlots;
+    m_sharedMemoryBundleArenaSlotSizeBytes = o.m_sharedMemoryBundleArenaSlotSizeBytes;
+    m_sharedMemoryIngressToEgress = o.m_sharedMemoryIngressToEgress;
+    m_sharedMemoryIngressToStorage = o.m_sharedMemoryIngressToStorage;
+    m_sharedMemoryStorageToEgress = o.m_sharedMemoryStorageToEgress;
     m_zmqIngressAddress = o.m_zmqIngressAddress;
     m_zmqEgressAddress = o.m_zmqEgressAddress;
     m_zmqStorageAddress = o.m_zmqStorageAddress;
@@ -190,7 +234,18 @@ HdtnConfig& HdtnConfig::operator=(HdtnConfig&& o) {
     m_maxBundleSizeBytes = o.m_maxBundleSizeBytes;
     m_maxIngressBundleWaitOnEgressMilliseconds = o.m_maxIngressBundleWaitOnEgressMilliseconds;
     m_bufferRxToStorageOnLinkUpSaturation = o.m_bufferRxToStorageOnLinkUpSaturation;
+    m_numIngressBundleProcessingWorkers = o.m_numIngressBundleProcessingWorkers;
     m_maxLtpReceiveUdpPacketSizeBytes = o.m_maxLtpReceiveUdpPacketSizeBytes;
+    m_maxLtpUdpPacketsToReceivePerSystemCall = o.m_maxLtpUdpPacketsToReceivePerSystemCall;
+    m_ltpUdpSegmentationOffload = o.m_ltpUdpSegmentationOffload;
+    m_numLtpUdpReceiveThreadsPerPort = o.m_numLtpUdpReceiveThreadsPerPort;
+    m_oneProcessBundleRingCapacity = o.m_oneProcessBundleRingCapacity;
+    m_sharedMemoryBundleArenaName = std::move(o.m_sharedMemoryBundleArenaName);
+    m_sharedMemoryBundleArenaNumSlots = o.m_sharedMemoryBundleArenaNumSlots;
+    m_sharedMemoryBundleArenaSlotSizeBytes = o.m_sharedMemoryBundleArenaSlotSizeBytes;
+    m_sharedMemoryIngressToEgress = o.m_sharedMemoryIngressToEgress;
+    m_sharedMemoryIngressToStorage = o.m_sharedMemoryIngressToStorage;
+    m_sharedMemoryStorageToEgress = o.m_sharedMemoryStorageToEgress;
     m_zmqIngressAddress = std::move(o.m_zmqIngressAddress);
     m_zmqEgressAddress = std::move(o.m_zmqEgressAddress);
     m_zmqStorageAddress = std::move(o.m_zmqStorageAddress);
@@ -230,7 +285,18 @@ bool HdtnConfig::operator==(const HdtnConfig & o) const {
         (m_maxBundleSizeBytes == o.m_maxBundleSizeBytes) &&
         (m_maxIngressBundleWaitOnEgressMilliseconds == o.m_maxIngressBundleWaitOnEgressMilliseconds) &&
         (m_bufferRxToStorageOnLinkUpSaturation == o.m_bufferRxToStorageOnLinkUpSaturation) &&
+        (m_numIngressBundleProcessingWorkers == o.m_numIngressBundleProcessingWorkers) &&
         (m_maxLtpReceiveUdpPacketSizeBytes == o.m_maxLtpReceiveUdpPacketSizeBytes) &&
+        (m_maxLtpUdpPacketsToReceivePerSystemCall == o.m_maxLtpUdpPacketsToReceivePerSystemCall) &&
+        (m_ltpUdpSegmentationOffload == o.m_ltpUdpSegmentationOffload) &&
+        (m_numLtpUdpReceiveThreadsPerPort == o.m_numLtpUdpReceiveThreadsPerPort) &&
+        (m_oneProcessBundleRingCapacity == o.m_oneProcessBundleRingCapacity) &&
+        (m_sharedMemoryBundleArenaName == o.m_sharedMemoryBundleArenaName) &&
+        (m_sharedMemoryBundleArenaNumSlots == o.m_sharedMemoryBundleArenaNumSlots) &&
+        (m_sharedMemoryBundleArenaSlotSizeBytes == o.m_sharedMemoryBundleArenaSlotSizeBytes) &&
+        (m_sharedMemoryIngressToEgress == o.m_sharedMemoryIngressToEgress) &&
+        (m_sharedMemoryIngressToStorage == o.m_sharedMemoryIngressToStorage) &&
+        (m_sharedMemoryStorageToEgress == o.m_sharedMemoryStorageToEgress) &&
         (m_zmqSchedulerAddress == o.m_zmqSchedulerAddress) &&
         (m_zmqRouterAddress == o.m_zmqRouterAddress) &&
         (m_zmqBoundIngressToConnectingEgressPortPath == o.m_zmqBoundIngressToConnectingEgressPortPath) &&
@@ -272,7 +338,26 @@ bool HdtnConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree & p
         m_maxBundleSizeBytes = pt.get<uint64_t>("maxBundleSizeBytes");
         m_maxIngressBundleWaitOnEgressMilliseconds = pt.get<uint64_t>("maxIngressBundleWaitOnEgressMilliseconds");
         m_bufferRxToStorageOnLinkUpSaturation = pt.get<bool>("bufferRxToStorageOnLinkUpSaturation");
+        m_numIngressBundleProcessingWorkers = pt.get<uint64_t>("numIngressBundleProcessingWorkers", 0); //non-throw version
         m_maxLtpReceiveUdpPacketSizeBytes = pt.get<uint64_t>("maxLtpReceiveUdpPacketSizeBytes");
+        m_maxLtpUdpPacketsToReceivePerSystemCall = pt.get<uint64_t>("maxLtpUdpPacketsToReceivePerSystemCall", 1); //non-throw version
+        if (m_maxLtpUdpPacketsToReceivePerSystemCall == 0) {
+            LOG_ERROR(subprocess) << "parsing JSON HDTN config: maxLtpUdpPacketsToReceivePerSystemCall must be non-zero";
+            return false;
+        }
+        m_ltpUdpSegmentationOffload = pt.get<bool>("ltpUdpSegmentationOffload", false); //non-throw version
+        m_numLtpUdpReceiveThreadsPerPort = pt.get<uint64_t>("numLtpUdpReceiveThreadsPerPort", 1); //non-throw version
+        if (m_numLtpUdpReceiveThreadsPerPort == 0) {
+            LOG_ERROR(subprocess) << "parsing JSON HDTN config: numLtpUdpReceiveThreadsPerPort must be non-zero";
+            return false;
+        }
+        m_oneProcessBundleRingCapacity = pt.get<uint64_t>("oneProcessBundleRingCapacity", 0); //non-throw version
+        m_sharedMemoryBundleArenaName = pt.get<std::string>("sharedMemoryBundleArenaName", ""); //non-throw version
+        m_sharedMemoryBundleArenaNumSlots = pt.get<uint64_t>("sharedMemoryBundleArenaNumSlots", 0); //non-throw version
+        m_sharedMemoryBundleArenaSlotSizeBytes = pt.get<uint64_t>("sharedMemoryBundleArenaSlotSizeBytes", 65536); //non-throw version
+        m_sharedMemoryIngressToEgress = pt.get<bool>("sharedMemoryIngressToEgress", false); //non-throw version
+        m_sharedMemoryIngressToStorage = pt.get<bool>("sharedMemoryIngressToStorage", false); //non-throw version
+        m_sharedMemoryStorageToEgress = pt.get<bool>("sharedMemoryStorageToEgress", false); //non-throw version
 
         m_zmqIngressAddress = pt.get<std::string>("zmqIngressAddress");
         m_zmqEgressAddress = pt.get<std::string>("zmqEgressAddress");
@@ -414,7 +499,18 @@ boost::property_tree::ptree HdtnConfig::GetNewPropertyTree() const {
     pt.put("maxBundleSizeBytes", m_maxBundleSizeBytes);
     pt.put("maxIngressBundleWaitOnEgressMilliseconds", m_maxIngressBundleWaitOnEgressMilliseconds);
     pt.put("bufferRxToStorageOnLinkUpSaturation", m_bufferRxToStorageOnLinkUpSaturation);
+    pt.put("numIngressBundleProcessingWorkers", m_numIngressBundleProcessingWorkers);
     pt.put("maxLtpReceiveUdpPacketSizeBytes", m_maxLtpReceiveUdpPacketSizeBytes);
+    pt.put("maxLtpUdpPacketsToReceivePerSystemCall", m_maxLtpUdpPacketsToReceivePerSystemCall);
+    pt.put("ltpUdpSegmentationOffload", m_ltpUdpSegmentationOffload);
+    pt.put("numLtpUdpReceiveThreadsPerPort", m_numLtpUdpReceiveThreadsPerPort);
+    pt.put("oneProcessBundleRingCapacity", m_oneProcessBundleRingCapacity);
+    pt.put("sharedMemoryBundleArenaName", m_sharedMemoryBundleArenaName);
+    pt.put("sharedMemoryBundleArenaNumSlots", m_sharedMemoryBundleArenaNumSlots);
+    pt.put("sharedMemoryBundleArenaSlotSizeBytes", m_sharedMemoryBundleArenaSlotSizeBytes);
+    pt.put("sharedMemoryIngressToEgress", m_sharedMemoryIngressToEgress);
+    pt.put("sharedMemoryIngressToStorage", m_sharedMemoryIngressToStorage);
+    pt.put("sharedMemoryStorageToEgress", m_sharedMemoryStorageToEgress);
 
     pt.put("zmqIngressAddress", m_zmqIngressAddress);
     pt.put("zmqEgressAddress", m_zmqEgressAddress);
@@ -45,6 +45,10 @@ induct_element_config_t::induct_element_config_t() :
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(0),
     ltpMaxExpectedSimultaneousSessions(0),
     ltpMaxUdpPacketsToSendPerSystemCall(0),
+    ltpRxRedPartSpillThresholdBytes(0),
+    ltpRxRedPartSpillDirectory(""),
+
+    udpGenericReceiveOffload(false),
 
     keepAliveIntervalSeconds(0),
 
@@ -80,6 +84,10 @@ induct_element_config_t::induct_element_config_t(const induct_element_config_t&
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
     ltpMaxExpectedSimultaneousSessions(o.ltpMaxExpectedSimultaneousSessions),
     ltpMaxUdpPacketsToSendPerSystemCall(o.ltpMaxUdpPacketsToSendPerSystemCall),
+    ltpRxRedPartSpillThresholdBytes(o.ltpRxRedPartSpillThresholdBytes),
+    ltpRxRedPartSpillDirectory(o.ltpRxRedPartSpillDirectory),
+
+    udpGenericReceiveOffload(o.udpGenericReceiveOffload),
 
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
@@ -112,6 +120,10 @@ induct_element_config_t::induct_element_config_t(induct_element_config_t&& o) :
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
     ltpMaxExpectedSimultaneousSessions(o.ltpMaxExpectedSimultaneousSessions),
     ltpMaxUdpPacketsToSendPerSystemCall(o.ltpMaxUdpPacketsToSendPerSystemCall),
+    ltpRxRedPartSpillThresholdBytes(o.ltpRxRedPartSpillThresholdBytes),
+    ltpRxRedPartSpillDirectory(std::move(o.ltpRxRedPartSpillDirectory)),
+
+    udpGenericReceiveOffload(o.udpGenericReceiveOffload),
 
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
@@ -144,6 +156,10 @@ induct_element_config_t& induct_element_config_t::operator=(const induct_element
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     ltpMaxExpectedSimultaneousSessions = o.ltpMaxExpectedSimultaneousSessions;
     ltpMaxUdpPacketsToSendPerSystemCall = o.ltpMaxUdpPacketsToSendPerSystemCall;
+    ltpRxRedPartSpillThresholdBytes = o.ltpRxRedPartSpillThresholdBytes;
+    ltpRxRedPartSpillDirectory = o.ltpRxRedPartSpillDirectory;
+
+    udpGenericReceiveOffload = o.udpGenericReceiveOffload;
 
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
@@ -178,6 +194,10 @@ induct_element_config_t& induct_element_config_t::operator=(induct_element_confi
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
     ltpMaxExpectedSimultaneousSessions = o.ltpMaxExpectedSimultaneousSessions;
     ltpMaxUdpPacketsToSendPerSystemCall = o.ltpMaxUdpPacketsToSendPerSystemCall;
+    ltpRxRedPartSpillThresholdBytes = o.ltpRxRedPartSpillThresholdBytes;
+    ltpRxRedPartSpillDirectory = std::move(o.ltpRxRedPartSpillDirectory);
+
+    udpGenericReceiveOffload = o.udpGenericReceiveOffload;
 
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
@@ -211,6 +231,9 @@ bool induct_element_config_t::operator==(const induct_element_config_t & o) cons
         (ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize == o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize) &&
         (ltpMaxExpectedSimultaneousSessions == o.ltpMaxExpectedSimultaneousSessions) &&
         (ltpMaxUdpPacketsToSendPerSystemCall == o.ltpMaxUdpPacketsToSendPerSystemCall) &&
+        (ltpRxRedPartSpillThresholdBytes == o.ltpRxRedPartSpillThresholdBytes) &&
+        (ltpRxRedPartSpillDirectory == o.ltpRxRedPartSpillDirectory) &&
+        (udpGenericReceiveOffload == o.udpGenericReceiveOffload) &&
 
         (keepAliveIntervalSeconds == o.keepAliveIntervalSeconds) &&
         
@@ -334,11 +357,18 @@ bool InductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                     return false;
                 }
 #endif //UIO_MAXIOV
+                inductElementConfig.ltpRxRedPartSpillThresholdBytes = inductElementConfigPt.second.get<uint64_t>("ltpRxRedPartSpillThresholdBytes", 0); //non-throw version
+                inductElementConfig.ltpRxRedPartSpillDirectory = inductElementConfigPt.second.get<std::string>("ltpRxRedPartSpillDirectory", ""); //non-throw version
+                if (inductElementConfig.ltpRxRedPartSpillThresholdBytes && inductElementConfig.ltpRxRedPartSpillDirectory.empty()) {
+                    LOG_ERROR(subprocess) << "error parsing JSON inductVector[" << (vectorIndex - 1) << "]: ltpRxRedPartSpillThresholdBytes ("
+                        << inductElementConfig.ltpRxRedPartSpillThresholdBytes << ") is non-zero but ltpRxRedPartSpillDirectory is not specified.";
+                    return false;
+                }
             }
             else {
                 static const std::vector<std::string> LTP_ONLY_VALUES = { "thisLtpEngineId" , "remoteLtpEngineId", "ltpReportSegmentMtu", "oneWayLightTimeMs", "oneWayMarginTimeMs",
                     "clientServiceId", "preallocatedRedDataBytes", "ltpMaxRetriesPerSerialNumber", "ltpRandomNumberSizeBits", "ltpRemoteUdpHostname", "ltpRemoteUdpPort",
-                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize"
+                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", "ltpRxRedPartSpillThresholdBytes", "ltpRxRedPartSpillDirectory"
                 };
                 for (std::size_t i = 0; i < LTP_ONLY_VALUES.size(); ++i) {
                     if (inductElementConfigPt.second.count(LTP_ONLY_VALUES[i]) != 0) {
@@ -349,6 +379,15 @@ bool InductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 }
             }
 
+            if (inductElementConfig.convergenceLayer == "udp") {
+                inductElementConfig.udpGenericReceiveOffload = inductElementConfigPt.second.get<bool>("udpGenericReceiveOffload", false); //non-throw version
+            }
+            else if (inductElementConfigPt.second.count("udpGenericReceiveOffload") != 0) {
+                LOG_ERROR(subprocess) << "error parsing JSON inductVector[" << (vectorIndex - 1) << "]: induct convergence layer  " << inductElementConfig.convergenceLayer
+                    << " has a udp induct only configuration parameter of \"udpGenericReceiveOffload\".. please remove";
+                return false;
+            }
+
             if ((inductElementConfig.convergenceLayer == "stcp") || (inductElementConfig.convergenceLayer == "tcpcl_v3") || (inductElementConfig.convergenceLayer == "tcpcl_v4")) {
                 inductElementConfig.keepAliveIntervalSeconds = inductElementConfigPt.second.get<uint32_t>("keepAliveIntervalSeconds");
             }
@@ -459,6 +498,11 @@ boost::property_tree::ptree InductsConfig::GetNewPropertyTree() const {
             inductElementConfigPt.put("ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", inductElementConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize);
             inductElementConfigPt.put("ltpMaxExpectedSimultaneousSessions", inductElementConfig.ltpMaxExpectedSimultaneousSessions);
             inductElementConfigPt.put("ltpMaxUdpPacketsToSendPerSystemCall", inductElementConfig.ltpMaxUdpPacketsToSendPerSystemCall);
+            inductElementConfigPt.put("ltpRxRedPartSpillThresholdBytes", inductElementConfig.ltpRxRedPartSpillThresholdBytes);
+            inductElementConfigPt.put("ltpRxRedPartSpillDirectory", inductElementConfig.ltpRxRedPartSpillDirectory);
+        }
+        if (inductElementConfig.convergenceLayer == "udp") {
+            inductElementConfigPt.put("udpGenericReceiveOffload", inductElementConfig.udpGenericReceiveOffload);
         }
         if ((inductElementConfig.convergenceLayer == "stcp") || (inductElementConfig.convergenceLayer == "tcpcl_v3") || (inductElementConfig.convergenceLayer == "tcpcl_v4")) {
             inductElementConfigPt.put("keepAliveIntervalSeconds", inductElementConfig.keepAliveIntervalSeconds);
@@ -19,7 +19,7 @@
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
 
-static const std::vector<std::string> VALID_STORAGE_IMPLEMENTATION_NAMES = { "stdio_multi_threaded", "asio_single_threaded" };
+static const std::vector<std::string> VALID_STORAGE_IMPLEMENTATION_NAMES = { "stdio_multi_threaded", "asio_single_threaded", "io_uring" };
 
 storage_disk_config_t::storage_disk_config_t() : name(""), storeFilePath("") {}
 storage_disk_config_t::~storage_disk_config_t() {}
@@ -57,7 +57,15 @@ StorageConfig::StorageConfig() :
     m_storageImplementation("stdio_multi_threaded"),
     m_tryToRestoreFromDisk(false),
     m_autoDeleteFilesOnExit(true),
+    m_useDirectIo(false),
+    m_useLockFreeSegmentAllocator(false),
+    m_diskQueueDepth(8),
     m_totalStorageCapacityBytes(1),
+    m_catalogJournalFilePath(),
+    m_hotTierCacheBytes(0),
+    m_hotTierWriteBackDelayMilliseconds(5000),
+    m_slabSlotSizeBytes(0),
+    m_largeBundleExtentMinBytes(0),
     m_storageDiskConfigVector() { }
 
 StorageConfig::~StorageConfig() {
@@ -68,7 +76,15 @@ StorageConfig::StorageConfig(const StorageConfig& o) :
     m_storageImplementation(o.m_storageImplementation),
     m_tryToRestoreFromDisk(o.m_tryToRestoreFromDisk),
     m_autoDeleteFilesOnExit(o.m_autoDeleteFilesOnExit),
+    m_useDirectIo(o.m_useDirectIo),
+    m_useLockFreeSegmentAllocator(o.m_useLockFreeSegmentAllocator),
+    m_diskQueueDepth(o.m_diskQueueDepth),
     m_totalStorageCapacityBytes(o.m_totalStorageCapacityBytes),
+    m_catalogJournalFilePath(o.m_catalogJournalFilePath),
+    m_hotTierCacheBytes(o.m_hotTierCacheBytes),
+    m_hotTierWriteBackDelayMilliseconds(o.m_hotTierWriteBackDelayMilliseconds),
+    m_slabSlotSizeBytes(o.m_slabSlotSizeBytes),
+    m_largeBundleExtentMinBytes(o.m_largeBundleExtentMinBytes),
     m_storageDiskConfigVector(o.m_storageDiskConfigVector) { }
 
 //a move constructor: X(X&&)
@@ -76,7 +92,15 @@ StorageConfig::StorageConfig(StorageConfig&& o) :
     m_storageImplementation(std::move(o.m_storageImplementation)),
     m_tryToRestoreFromDisk(o.m_tryToRestoreFromDisk),
     m_autoDeleteFilesOnExit(o.m_autoDeleteFilesOnExit),
+    m_useDirectIo(o.m_useDirectIo),
+    m_useLockFreeSegmentAllocator(o.m_useLockFreeSegmentAllocator),
+    m_diskQueueDepth(o.m_diskQueueDepth),
     m_totalStorageCapacityBytes(o.m_totalStorageCapacityBytes),
+    m_catalogJournalFilePath(std::move(o.m_catalogJournalFilePath)),
+    m_hotTierCacheBytes(o.m_hotTierCacheBytes),
+    m_hotTierWriteBackDelayMilliseconds(o.m_hotTierWriteBackDelayMilliseconds),
+    m_slabSlotSizeBytes(o.m_slabSlotSizeBytes),
+    m_largeBundleExtentMinBytes(o.m_largeBundleExtentMinBytes),
     m_storageDiskConfigVector(std::move(o.m_storageDiskConfigVector)) { }
 
 //a copy assignment: operator=(const X&)
@@ -84,7 +108,15 @@ StorageConfig& StorageConfig::operator=(const StorageConfig& o) {
     m_storageImplementation = o.m_storageImplementation;
     m_tryToRestoreFromDisk = o.m_tryToRestoreFromDisk;
     m_autoDeleteFilesOnExit = o.m_autoDeleteFilesOnExit;
+    m_useDirectIo = o.m_useDirectIo;
+    m_useLockFreeSegmentAllocator = o.m_useLockFreeSegmentAllocator;
+    m_diskQueueDepth = o.m_diskQueueDepth;
     m_totalStorageCapacityBytes = o.m_totalStorageCapacityBytes;
+    m_catalogJournalFilePath = o.m_catalogJournalFilePath;
+    m_hotTierCacheBytes = o.m_hotTierCacheBytes;
+    m_hotTierWriteBackDelayMilliseconds = o.m_hotTierWriteBackDelayMilliseconds;
+    m_slabSlotSizeBytes = o.m_slabSlotSizeBytes;
+    m_largeBundleExtentMinBytes = o.m_largeBundleExtentMinBytes;
     m_storageDiskConfigVector = o.m_storageDiskConfigVector;
     return *this;
 }
@@ -94,7 +126,15 @@ StorageConfig& StorageConfig::operator=(StorageConfig&& o) {
     m_storageImplementation = std::move(o.m_storageImplementation);
     m_tryToRestoreFromDisk = o.m_tryToRestoreFromDisk;
     m_autoDeleteFilesOnExit = o.m_autoDeleteFilesOnExit;
+    m_useDirectIo = o.m_useDirectIo;
+    m_useLockFreeSegmentAllocator = o.m_useLockFreeSegmentAllocator;
+    m_diskQueueDepth = o.m_diskQueueDepth;
     m_totalStorageCapacityBytes = o.m_totalStorageCapacityBytes;
+    m_catalogJournalFilePath = std::move(o.m_catalogJournalFilePath);
+    m_hotTierCacheBytes = o.m_hotTierCacheBytes;
+    m_hotTierWriteBackDelayMilliseconds = o.m_hotTierWriteBackDelayMilliseconds;
+    m_slabSlotSizeBytes = o.m_slabSlotSizeBytes;
+    m_largeBundleExtentMinBytes = o.m_largeBundleExtentMinBytes;
     m_storageDiskConfigVector = std::move(o.m_storageDiskConfigVector);
     return *this;
 }
@@ -104,7 +144,15 @@ bool StorageConfig::operator==(const StorageConfig & other) const {
         (m_storageImplementation == other.m_storageImplementation) &&
         (m_tryToRestoreFromDisk == other.m_tryToRestoreFromDisk) &&
         (m_autoDeleteFilesOnExit == other.m_autoDeleteFilesOnExit) &&
+        (m_useDirectIo == other.m_useDirectIo) &&
+        (m_useLockFreeSegmentAllocator == other.m_useLockFreeSegmentAllocator) &&
+        (m_diskQueueDepth == other.m_diskQueueDepth) &&
         (m_totalStorageCapacityBytes == other.m_totalStorageCapacityBytes) &&
+        (m_catalogJournalFilePath == other.m_catalogJournalFilePath) &&
+        (m_hotTierCacheBytes == other.m_hotTierCacheBytes) &&
+        (m_hotTierWriteBackDelayMilliseconds == other.m_hotTierWriteBackDelayMilliseconds) &&
+        (m_slabSlotSizeBytes == other.m_slabSlotSizeBytes) &&
+        (m_largeBundleExtentMinBytes == other.m_largeBundleExtentMinBytes) &&
         (m_storageDiskConfigVector == other.m_storageDiskConfigVector);
 }
 
@@ -126,7 +174,15 @@ bool StorageConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
         }
         m_tryToRestoreFromDisk = pt.get<bool>("tryToRestoreFromDisk");
         m_autoDeleteFilesOnExit = pt.get<bool>("autoDeleteFilesOnExit");
+        m_useDirectIo = pt.get<bool>("useDirectIo", false); //non-throw version
+        m_useLockFreeSegmentAllocator = pt.get<bool>("useLockFreeSegmentAllocator", false); //non-throw version
+        m_diskQueueDepth = pt.get<uint32_t>("diskQueueDepth", 8); //non-throw version
         m_totalStorageCapacityBytes = pt.get<uint64_t>("totalStorageCapacityBytes");
+        m_catalogJournalFilePath = pt.get<std::string>("catalogJournalFilePath", ""); //non-throw version
+        m_hotTierCacheBytes = pt.get<uint64_t>("hotTierCacheBytes", 0); //non-throw version
+        m_hotTierWriteBackDelayMilliseconds = pt.get<uint64_t>("hotTierWriteBackDelayMilliseconds", 5000); //non-throw version
+        m_slabSlotSizeBytes = pt.get<uint64_t>("slabSlotSizeBytes", 0); //non-throw version
+        m_largeBundleExtentMinBytes = pt.get<uint64_t>("largeBundleExtentMinBytes", 0); //non-throw version
     }
     catch (const boost::property_tree::ptree_error & e) {
         LOG_ERROR(subprocess) << "error parsing JSON Storage config: " << e.what();
@@ -137,6 +193,10 @@ bool StorageConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
         LOG_ERROR(subprocess) << "error parsing JSON Storage config: totalStorageCapacityBytes must be defined and non-zero";
         return false;
     }
+    if (m_diskQueueDepth == 0) {
+        LOG_ERROR(subprocess) << "error parsing JSON Storage config: diskQueueDepth must be non-zero";
+        return false;
+    }
 
     //for non-throw versions of get_child which return a reference to the second parameter
     static const boost::property_tree::ptree EMPTY_PTREE;
@@ -203,7 +263,15 @@ boost::property_tree::ptree StorageConfig::GetNewPropertyTree() const {
     pt.put("storageImplementation", m_storageImplementation);
     pt.put("tryToRestoreFromDisk", m_tryToRestoreFromDisk);
     pt.put("autoDeleteFilesOnExit", m_autoDeleteFilesOnExit);
+    pt.put("useDirectIo", m_useDirectIo);
+    pt.put("useLockFreeSegmentAllocator", m_useLockFreeSegmentAllocator);
+    pt.put("diskQueueDepth", m_diskQueueDepth);
     pt.put("totalStorageCapacityBytes", m_totalStorageCapacityBytes);
+    pt.put("catalogJournalFilePath", m_catalogJournalFilePath);
+    pt.put("hotTierCacheBytes", m_hotTierCacheBytes);
+    pt.put("hotTierWriteBackDelayMilliseconds", m_hotTierWriteBackDelayMilliseconds);
+    pt.put("slabSlotSizeBytes", m_slabSlotSizeBytes);
+    pt.put("largeBundleExtentMinBytes", m_largeBundleExtentMinBytes);
     boost::property_tree::ptree & storageDiskConfigVectorPt = pt.put_child("storageDiskConfigVector", m_storageDiskConfigVector.empty() ? boost::property_tree::ptree("[]") : boost::property_tree::ptree());
     for (storage_disk_config_vector_t::const_iterator storageDiskConfigVectorIt = m_storageDiskConfigVector.cbegin(); storageDiskConfigVectorIt != m_storageDiskConfigVector.cend(); ++storageDiskConfigVectorIt) {
         const storage_disk_config_t & storageDiskConfig = *storageDiskConfigVectorIt;
@@ -0,0 +1,103 @@
+/**
+ * @file bundle_rings.hpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The OneProcessBundleRings struct holds the rings which, in hdtn-one-process with a non-zero oneProcessBundleRingCapacity,
+ * carry bundles from ingress to egress, from ingress to storage, and from storage to egress in place of the inproc zmq sockets.
+ * Each ring is a SlotQueueSingleProducerSingleConsumer of BundleHandle (the module header plus the zmq message owning the bundle),
+ * so a bundle changes hands by moving its zmq message into and out of a preallocated slot, without a copy or a lock.
+ * When the consumer may have found a ring empty, the producer sends a HDTN_MSGTYPE_BUNDLE_RING_WAKE message over the inproc socket
+ * the bundle would have otherwise been sent on (which still carries the link messages), so the consumer's zmq::poll loop is unchanged.
+ */
+
+#ifndef _HDTN_BUNDLE_RINGS_H
+#define _HDTN_BUNDLE_RINGS_H 1
+
+#include <boost/core/noncopyable.hpp>
+#include "message.hpp"
+#include "zmq.hpp"
+#include "SlotQueueSingleProducerSingleConsumer.h"
+
+namespace hdtn {
+
+template <typename HdrType>
+struct BundleHandle {
+    HdrType hdr;
+    zmq::message_t bundle; //move-only, so a bundle has exactly one owner
+};
+typedef SlotQueueSingleProducerSingleConsumer<BundleHandle<ToEgressHdr> > to_egress_bundle_ring_t;
+typedef SlotQueueSingleProducerSingleConsumer<BundleHandle<ToStorageHdr> > to_storage_bundle_ring_t;
+
+struct OneProcessBundleRings : private boost::noncopyable {
+    OneProcessBundleRings(const unsigned int capacity) :
+        ingressToEgress(capacity), ingressToStorage(capacity), storageToEgress(capacity) {}
+
+    to_egress_bundle_ring_t ingressToEgress;
+    to_storage_bundle_ring_t ingressToStorage;
+    to_egress_bundle_ring_t storageToEgress;
+};
+
+//Producer: moves the bundle into the ring without waiting, or returns false (leaving the bundle unmoved) if the ring is full.
+//Sets needsWake to true if the consumer may have found the ring empty, in which case the caller must call SendBundleRingWake.
+template <typename HdrType>
+static bool PushToBundleRing(SlotQueueSingleProducerSingleConsumer<BundleHandle<HdrType> > & ring,
+    const HdrType & hdr, zmq::message_t & bundle, bool & needsWake)
+{
+    static const boost::posix_time::time_duration noWait = boost::posix_time::seconds(0);
+    BundleHandle<HdrType> * const handlePtr = ring.GetSlotForWrite(noWait);
+    if (handlePtr == NULL) {
+        return false;
+    }
+    handlePtr->hdr = hdr;
+    handlePtr->bundle = std::move(bundle);
+    if (ring.CommitWrite()) {
+        needsWake = true;
+    }
+    return true;
+}
+
+//Consumer: moves the oldest bundle out of the ring (so its slot no longer holds the bundle's buffer), or returns false if the ring is empty.
+template <typename HdrType>
+static bool PopFromBundleRing(SlotQueueSingleProducerSingleConsumer<BundleHandle<HdrType> > & ring,
+    HdrType & hdr, zmq::message_t & bundle)
+{
+    BundleHandle<HdrType> * const handlePtr = ring.GetSlotForRead();
+    if (handlePtr == NULL) {
+        return false;
+    }
+    hdr = handlePtr->hdr;
+    bundle = std::move(handlePtr->bundle);
+    ring.CommitRead();
+    return true;
+}
+
+static inline bool SendBundleRingWake(zmq::socket_t & sock) {
+    CommonHdr wakeHdr;
+    wakeHdr.type = HDTN_MSGTYPE_BUNDLE_RING_WAKE;
+    wakeHdr.flags = 0;
+    return static_cast<bool>(sock.send(zmq::const_buffer(&wakeHdr, sizeof(wakeHdr)), zmq::send_flags::dontwait));
+}
+
+static inline bool IsBundleRingWake(const zmq::message_t & message) {
+    CommonHdr commonHdr;
+    if (message.size() != sizeof(CommonHdr)) {
+        return false;
+    }
+    memcpy(&commonHdr, message.data(), sizeof(CommonHdr));
+    return (commonHdr.type == HDTN_MSGTYPE_BUNDLE_RING_WAKE);
+}
+
+}  // namespace hdtn
+
+#endif //_HDTN_BUNDLE_RINGS_H
@@ -2,6 +2,8 @@
 #define _HDTN_MSG_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <cstring>
 
 #include "stats.hpp"
 #include "codec/bpv6.h"
@@ -12,6 +14,7 @@
 #define HDTN_FLAG_CUSTODY_REQ (0x01)
 #define HDTN_FLAG_CUSTODY_OK (0x02)
 #define HDTN_FLAG_CUSTODY_FAIL (0x04)
+#define HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY (0x08) //ToEgressHdr/ToStorageHdr: the bundle frame is a SharedMemoryBundleArena::Descriptor
 
 // Common message types shared by all components
 #define HDTN_MSGTYPE_EGRESS (0x0004)
@@ -20,6 +23,9 @@
 #define HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK (0x0007)
 #define HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK (0x0008)
 #define HDTN_MSGTYPE_STORAGE_REMOVE_OPPORTUNISTIC_LINK (0x0009)
+#define HDTN_MSGTYPE_EGRESS_BATCH (0x000A) //BatchHdr + ToEgressHdr[numHeaders] frame, followed by numHeaders bundle frames
+#define HDTN_MSGTYPE_STORE_BATCH (0x000B) //BatchHdr + ToStorageHdr[numHeaders] frame, followed by numHeaders bundle frames
+#define HDTN_MSGTYPE_BUNDLE_RING_WAKE (0x000C) //CommonHdr only, the sender pushed to an empty bundle ring (see bundle_rings.hpp)
 
 // Egress Messages range is 0xE000 to 0xEAFF
 #define HDTN_MSGTYPE_ENOTIMPL (0xE000)  // convergence layer type not  // implemented
@@ -55,6 +61,8 @@
 #define HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS (0x5556)
 #define HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS (0x5557)
 #define HDTN_MSGTYPE_ALL_OUTDUCT_CAPABILITIES_TELEMETRY (0x5558)
+#define HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS (0x5559) //batched acks, one header per acked bundle: BatchHdr + EgressAckHdr[numHeaders] in one frame
+#define HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS (0x555A) //batched acks, one header per acked bundle: BatchHdr + StorageAckHdr[numHeaders] in one frame
 
 namespace hdtn {
 //#pragma pack (push, 1)
@@ -123,6 +131,51 @@ struct StorageAckHdr {
     uint64_t outductIndex; //for bundle pipeline limiting on a per outduct basis
 };
 
+//Batched messages coalesce many bundles (or acks) into one zmq multipart message under load.
+//The first frame is a BatchHdr immediately followed by numHeaders headers (8-byte aligned since sizeof(BatchHdr) == 8),
+//and bundle batches follow that frame with one bundle frame per header, in header order.
+struct BatchHdr {
+    CommonHdr base;
+    uint32_t numHeaders;
+};
+
+//Returns the number of HdrType headers in a message that is either a single HdrType of type singleType
+//or a batch of type batchType, and sets firstHdrPtr to the first of them (which may be unaligned, so memcpy them out).
+//Returns 0 if the message is neither.
+template <typename HdrType>
+static inline uint32_t GetHeadersOfSingleOrBatchMessage(const void * data, const std::size_t size,
+    const uint16_t singleType, const uint16_t batchType, const uint8_t *& firstHdrPtr)
+{
+    CommonHdr commonHdr;
+    if (size < sizeof(CommonHdr)) {
+        return 0;
+    }
+    memcpy(&commonHdr, data, sizeof(CommonHdr));
+    if ((commonHdr.type == singleType) && (size == sizeof(HdrType))) {
+        firstHdrPtr = static_cast<const uint8_t*>(data);
+        return 1;
+    }
+    else if ((commonHdr.type == batchType) && (size >= sizeof(BatchHdr))) {
+        BatchHdr batchHdr;
+        memcpy(&batchHdr, data, sizeof(BatchHdr));
+        if ((batchHdr.numHeaders != 0) && (size == (sizeof(BatchHdr) + (batchHdr.numHeaders * sizeof(HdrType))))) {
+            firstHdrPtr = static_cast<const uint8_t*>(data) + sizeof(BatchHdr);
+            return batchHdr.numHeaders;
+        }
+    }
+    return 0;
+}
+
+//Writes a BatchHdr of type batchType to the start of data, returning where its numHeaders headers are to be written.
+static inline uint8_t * WriteBatchHdr(void * data, const uint16_t batchType, const uint32_t numHeaders) {
+    BatchHdr batchHdr;
+    batchHdr.base.type = batchType;
+    batchHdr.base.flags = 0;
+    batchHdr.numHeaders = numHeaders;
+    memcpy(data, &batchHdr, sizeof(BatchHdr));
+    return static_cast<uint8_t*>(data) + sizeof(BatchHdr);
+}
+
 struct TelemStorageHdr {
     CommonHdr base;
     StorageStats stats;
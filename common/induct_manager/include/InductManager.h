@@ -3,6 +3,7 @@
 
 #include "Induct.h"
 #include <list>
+#include <vector>
 
 class InductManager {
 public:
@@ -11,6 +12,10 @@ public:
     INDUCT_MANAGER_LIB_EXPORT void LoadInductsFromConfig(const InductProcessBundleCallback_t & inductProcessBundleCallback, const InductsConfig & inductsConfig,
         const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
         const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback);
+    //same as above except that the induct of inductsConfig.m_inductElementConfigVector[i] delivers its bundles to inductProcessBundleCallbacks[i]
+    INDUCT_MANAGER_LIB_EXPORT void LoadInductsFromConfig(const std::vector<InductProcessBundleCallback_t> & inductProcessBundleCallbacks, const InductsConfig & inductsConfig,
+        const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
+        const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback);
     INDUCT_MANAGER_LIB_EXPORT void Clear();
 public:
 
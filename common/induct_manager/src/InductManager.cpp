@@ -15,12 +15,22 @@ InductManager::~InductManager() {}
 void InductManager::LoadInductsFromConfig(const InductProcessBundleCallback_t & inductProcessBundleCallback, const InductsConfig & inductsConfig,
     const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
     const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback)
+{
+    const std::vector<InductProcessBundleCallback_t> inductProcessBundleCallbacks(inductsConfig.m_inductElementConfigVector.size(), inductProcessBundleCallback);
+    LoadInductsFromConfig(inductProcessBundleCallbacks, inductsConfig, myNodeId, maxUdpRxPacketSizeBytesForAllLtp, maxBundleSizeBytes,
+        onNewOpportunisticLinkCallback, onDeletedOpportunisticLinkCallback);
+}
+
+void InductManager::LoadInductsFromConfig(const std::vector<InductProcessBundleCallback_t> & inductProcessBundleCallbacks, const InductsConfig & inductsConfig,
+    const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
+    const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback)
 {
     LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(maxUdpRxPacketSizeBytesForAllLtp); //MUST BE CALLED BEFORE ANY USAGE OF LTP
     m_inductsList.clear();
     const induct_element_config_vector_t & configsVec = inductsConfig.m_inductElementConfigVector;
-    for (induct_element_config_vector_t::const_iterator it = configsVec.cbegin(); it != configsVec.cend(); ++it) {
-        const induct_element_config_t & thisInductConfig = *it;
+    for (std::size_t inductIndex = 0; inductIndex < configsVec.size(); ++inductIndex) {
+        const induct_element_config_t & thisInductConfig = configsVec[inductIndex];
+        const InductProcessBundleCallback_t & inductProcessBundleCallback = inductProcessBundleCallbacks[inductIndex];
         if (thisInductConfig.convergenceLayer == "tcpcl_v3") {
             m_inductsList.emplace_back(boost::make_unique<TcpclInduct>(inductProcessBundleCallback, thisInductConfig,
                 myNodeId, maxBundleSizeBytes, onNewOpportunisticLinkCallback, onDeletedOpportunisticLinkCallback));
@@ -16,7 +16,8 @@ LtpOverUdpInduct::LtpOverUdpInduct(const InductProcessBundleCallback_t & inductP
         (inductConfig.ltpRandomNumberSizeBits == 32), inductConfig.ltpRemoteUdpHostname, inductConfig.ltpRemoteUdpPort, maxBundleSizeBytes,
         inductConfig.ltpMaxExpectedSimultaneousSessions, inductConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize,
         inductConfig.ltpMaxUdpPacketsToSendPerSystemCall,
-        20); //todo const uint64_t delaySendingOfReportSegmentsTimeMsOrZeroToDisable
+        20, //todo const uint64_t delaySendingOfReportSegmentsTimeMsOrZeroToDisable
+        inductConfig.ltpRxRedPartSpillThresholdBytes, inductConfig.ltpRxRedPartSpillDirectory);
 
 }
 LtpOverUdpInduct::~LtpOverUdpInduct() {
@@ -11,7 +11,8 @@ UdpInduct::UdpInduct(const InductProcessBundleCallback_t & inductProcessBundleCa
         m_inductProcessBundleCallback,
         m_inductConfig.numRxCircularBufferElements,
         m_inductConfig.numRxCircularBufferBytesPerElement,
-        boost::bind(&UdpInduct::ConnectionReadyToBeDeletedNotificationReceived, this));
+        boost::bind(&UdpInduct::ConnectionReadyToBeDeletedNotificationReceived, this),
+        m_inductConfig.udpGenericReceiveOffload);
     
 
     m_ioServiceThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioService));
@@ -74,6 +74,11 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
         uint32_t maxRetriesPerSerialNumber;
         uint64_t maxSendRateBitsPerSecOrZeroToDisable;
         uint64_t maxUdpPacketsToSendPerSystemCall;
+        uint64_t maxUdpPacketsToReceivePerSystemCall;
+        bool useUdpSegmentationOffload;
+        uint64_t numUdpReceiveThreadsPerPort;
+        uint64_t rxRedPartSpillThresholdBytes;
+        boost::filesystem::path rxRedPartSpillDirectory;
         unsigned int numUdpRxPacketsCircularBufferSize;
         unsigned int maxRxUdpPacketSizeBytes;
 
@@ -103,6 +108,11 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
                 ("max-retries-per-serial-number", boost::program_options::value<uint32_t>()->default_value(5), "Try to resend a serial number up to this many times. (default 5).")
                 ("max-send-rate-bits-per-sec", boost::program_options::value<uint64_t>()->default_value(0), "Send rate in bits-per-second FOR SENDERS ONLY (zero disables). (default 0)")
                 ("max-udp-packets-to-send-per-system-call", boost::program_options::value<uint64_t>()->default_value(1), "Max udp packets to send per system call (senders and receivers). (default 1)")
+                ("max-udp-packets-to-receive-per-system-call", boost::program_options::value<uint64_t>()->default_value(1), "Max udp packets to receive per recvmmsg system call (senders and receivers). (default 1)")
+                ("udp-segmentation-offload", "Use UDP_SEGMENT (GSO) for batch sends and UDP_GRO for receives (Linux only).")
+                ("num-udp-receive-threads-per-port", boost::program_options::value<uint64_t>()->default_value(1), "Number of SO_REUSEPORT sockets/receive threads on the bound udp port (Linux only). (default 1)")
+                ("rx-red-part-spill-threshold-bytes", boost::program_options::value<uint64_t>()->default_value(0), "When receiving, a red part larger than this is received into a memory mapped file instead of RAM (zero disables). (default 0)")
+                ("rx-red-part-spill-directory", boost::program_options::value<std::string>()->default_value(""), "Directory of the memory mapped red part files (default is the directory of receive-file).")
                 ;
 
             boost::program_options::variables_map vm;
@@ -165,6 +175,33 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
                 return false;
             }
 #endif //UIO_MAXIOV
+            maxUdpPacketsToReceivePerSystemCall = vm["max-udp-packets-to-receive-per-system-call"].as<uint64_t>();
+            if (maxUdpPacketsToReceivePerSystemCall == 0) {
+                LOG_ERROR(subprocess) << "max-udp-packets-to-receive-per-system-call ("
+                    << maxUdpPacketsToReceivePerSystemCall << ") must be non-zero.";
+                return false;
+            }
+#ifdef UIO_MAXIOV
+            if (maxUdpPacketsToReceivePerSystemCall > UIO_MAXIOV) {
+                LOG_ERROR(subprocess) << "max-udp-packets-to-receive-per-system-call ("
+                    << maxUdpPacketsToReceivePerSystemCall << ") must be <= UIO_MAXIOV (" << UIO_MAXIOV << ").";
+                return false;
+            }
+#endif //UIO_MAXIOV
+            useUdpSegmentationOffload = (vm.count("udp-segmentation-offload") != 0);
+            numUdpReceiveThreadsPerPort = vm["num-udp-receive-threads-per-port"].as<uint64_t>();
+            if (numUdpReceiveThreadsPerPort == 0) {
+                LOG_ERROR(subprocess) << "num-udp-receive-threads-per-port must be non-zero.";
+                return false;
+            }
+            rxRedPartSpillThresholdBytes = vm["rx-red-part-spill-threshold-bytes"].as<uint64_t>();
+            rxRedPartSpillDirectory = vm["rx-red-part-spill-directory"].as<std::string>();
+            if (rxRedPartSpillDirectory.empty()) {
+                rxRedPartSpillDirectory = boost::filesystem::path(receiveFilePath).parent_path();
+                if (rxRedPartSpillDirectory.empty()) {
+                    rxRedPartSpillDirectory = ".";
+                }
+            }
             numUdpRxPacketsCircularBufferSize = vm["num-rx-udp-packets-buffer-size"].as<unsigned int>();
             maxRxUdpPacketSizeBytes = vm["max-rx-udp-packet-size-bytes"].as<unsigned int>();
         }
@@ -183,6 +220,9 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
         }
 
         LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(maxRxUdpPacketSizeBytes);
+        LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(maxUdpPacketsToReceivePerSystemCall);
+        LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(useUdpSegmentationOffload);
+        LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(numUdpReceiveThreadsPerPort);
         const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME = (boost::posix_time::milliseconds(oneWayLightTimeMs));
         const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME = (boost::posix_time::milliseconds(oneWayMarginTimeMs));
         if (useSendFile) {
@@ -309,6 +349,14 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
                     cvMutex.unlock();
                     cv.notify_one();
                 }
+                void RedPartFileReceptionCallback(const Ltp::session_id_t & sessionId, std::unique_ptr<MemoryMappedFileBuffer> & movableRedPartFileBufferPtr, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock) {
+                    finishedTime = boost::posix_time::microsec_clock::universal_time();
+                    receivedFileBufferPtr = std::move(movableRedPartFileBufferPtr);
+                    cvMutex.lock();
+                    finished = true;
+                    cvMutex.unlock();
+                    cv.notify_one();
+                }
                 void ReceptionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode) {
                     cvMutex.lock();
                     cancelled = true;
@@ -328,6 +376,7 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
                 bool finished;
                 bool cancelled;
                 padded_vector_uint8_t receivedFileContents;
+                std::unique_ptr<MemoryMappedFileBuffer> receivedFileBufferPtr; //when the red part was spilled to disk
 
             };
             ReceiverHelper receiverHelper;
@@ -344,6 +393,9 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
             
             ltpUdpEngineDestPtr->SetRedPartReceptionCallback(boost::bind(&ReceiverHelper::RedPartReceptionCallback, &receiverHelper, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
                 boost::placeholders::_4, boost::placeholders::_5));
+            ltpUdpEngineDestPtr->SetRedPartFileReceptionCallback(boost::bind(&ReceiverHelper::RedPartFileReceptionCallback, &receiverHelper, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5));
+            ltpUdpEngineDestPtr->SetRedPartSpillToDisk(rxRedPartSpillDirectory, rxRedPartSpillThresholdBytes);
             ltpUdpEngineDestPtr->SetReceptionSessionCancelledCallback(boost::bind(&ReceiverHelper::ReceptionSessionCancelledCallback, &receiverHelper, boost::placeholders::_1, boost::placeholders::_2));
             
             LOG_INFO(subprocess) << "this ltp receiver/server for engine ID " << thisLtpEngineId << " will receive on port "
@@ -362,12 +414,30 @@ bool LtpFileTransferRunner::Run(int argc, const char* const argv[], volatile boo
                 }
             }
             if (receiverHelper.finished) {
-                LOG_INFO(subprocess) << "received file of size " << receiverHelper.receivedFileContents.size();
+                const bool receivedIntoFile = (receiverHelper.receivedFileBufferPtr != NULL);
+                const uint8_t * const receivedData = (receivedIntoFile) ? receiverHelper.receivedFileBufferPtr->data() : receiverHelper.receivedFileContents.data();
+                const std::size_t receivedSize = static_cast<std::size_t>((receivedIntoFile) ? receiverHelper.receivedFileBufferPtr->size() : receiverHelper.receivedFileContents.size());
+                LOG_INFO(subprocess) << "received file of size " << receivedSize << ((receivedIntoFile) ? " (spilled to disk)" : "");
                 LOG_INFO(subprocess) << "computing sha1..";
                 std::string sha1Str;
-                GetSha1(receiverHelper.receivedFileContents.data(), receiverHelper.receivedFileContents.size(), sha1Str);
+                GetSha1(receivedData, receivedSize, sha1Str);
                 LOG_INFO(subprocess) << "SHA1: " << sha1Str;
-                if (!dontSaveFile) {
+                if (dontSaveFile) {
+                    receiverHelper.receivedFileBufferPtr.reset(); //deletes the spill file
+                }
+                else if (receivedIntoFile) { //keep the spill file as the received file (no copy)
+                    const boost::filesystem::path spillFilePath = receiverHelper.receivedFileBufferPtr->GetFilePath();
+                    receiverHelper.receivedFileBufferPtr->SetDeleteFileOnDestruction(false);
+                    receiverHelper.receivedFileBufferPtr.reset(); //unmap before renaming
+                    boost::system::error_code ec;
+                    boost::filesystem::rename(spillFilePath, receiveFilePath, ec);
+                    if (ec) {
+                        LOG_ERROR(subprocess) << "unable to rename " << spillFilePath << " to " << receiveFilePath << ": " << ec.message();
+                        return false;
+                    }
+                    LOG_INFO(subprocess) << "wrote " << receiveFilePath;
+                }
+                else {
                     std::ofstream ofs(receiveFilePath, std::ofstream::out | std::ofstream::binary);
                     if (!ofs.good()) {
                         LOG_ERROR(subprocess) << "unable to open file " << receiveFilePath << " for writing";
@@ -248,6 +248,10 @@ public:
 	typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
         std::vector<uint8_t> & clientServiceDataVec, const data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> DataSegmentContentsReadCallback_t;
+    //clientServiceData points into the buffer given to HandleReceivedChars and is only valid for the duration of the callback
+    typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
+        const uint8_t * clientServiceData, const data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> RedDataSegmentContentsViewReadCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, const report_segment_t & reportSegment,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> ReportSegmentContentsReadCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, uint64_t reportSerialNumberBeingAcknowledged,
@@ -263,6 +267,9 @@ public:
     LTP_LIB_EXPORT ~Ltp();
     
     LTP_LIB_EXPORT void SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback);
+    //if set, red data segments wholly contained in one HandleReceivedChars call (and with no trailer extensions)
+    //are passed to this callback as a view rather than copied into a vector for the DataSegmentContentsReadCallback_t
+    LTP_LIB_EXPORT void SetRedDataSegmentContentsViewReadCallback(const RedDataSegmentContentsViewReadCallback_t & callback);
     LTP_LIB_EXPORT void SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetReportAcknowledgementSegmentContentsReadCallback(const ReportAcknowledgementSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetCancelSegmentContentsReadCallback(const CancelSegmentContentsReadCallback_t & callback);
@@ -325,6 +332,7 @@ public:
         
 	//callback functions
 	DataSegmentContentsReadCallback_t m_dataSegmentContentsReadCallback;
+    RedDataSegmentContentsViewReadCallback_t m_redDataSegmentContentsViewReadCallback;
     ReportSegmentContentsReadCallback_t m_reportSegmentContentsReadCallback;
     ReportAcknowledgementSegmentContentsReadCallback_t m_reportAcknowledgementSegmentContentsReadCallback;
     CancelSegmentContentsReadCallback_t m_cancelSegmentContentsReadCallback;
@@ -43,7 +43,8 @@ public:
         uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
         const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxBundleSizeBytes, const uint64_t maxSimultaneousSessions,
         const uint64_t rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable,
-        const uint64_t maxUdpPacketsToSendPerSystemCall, const uint64_t delaySendingOfReportSegmentsTimeMsOrZeroToDisable);
+        const uint64_t maxUdpPacketsToSendPerSystemCall, const uint64_t delaySendingOfReportSegmentsTimeMsOrZeroToDisable,
+        const uint64_t rxRedPartSpillThresholdBytesOrZeroToDisable = 0, const std::string & rxRedPartSpillDirectory = "");
     LTP_LIB_EXPORT ~LtpBundleSink();
     LTP_LIB_EXPORT bool ReadyToBeDeleted();
 private:
@@ -66,6 +66,11 @@ public:
     LTP_LIB_EXPORT virtual void Reset();
     LTP_LIB_EXPORT void SetCheckpointEveryNthDataPacketForSenders(uint64_t checkpointEveryNthDataPacketSender);
     LTP_LIB_EXPORT void SetMtuReportSegment(uint64_t mtuReportSegment);
+    //Receiving sessions whose red part grows beyond thresholdBytesOrZeroToDisable move it out of RAM into a sparse memory mapped file
+    //(one per session) in the existing directory spillDirectory.  The received fragment tracking stays in RAM.
+    //Completed spilled red parts are delivered to the RedPartFileReceptionCallback_t if set (see LtpNoticesToClientService.h).
+    //Set before any data segments are received.
+    LTP_LIB_EXPORT void SetRedPartSpillToDisk(const boost::filesystem::path & spillDirectory, const uint64_t thresholdBytesOrZeroToDisable);
 
     LTP_LIB_EXPORT void TransmissionRequest(std::shared_ptr<transmission_request_t> & transmissionRequest);
     LTP_LIB_EXPORT void TransmissionRequest_ThreadSafe(std::shared_ptr<transmission_request_t> && transmissionRequest);
@@ -81,6 +86,7 @@ public:
     
     LTP_LIB_EXPORT void SetSessionStartCallback(const SessionStartCallback_t & callback);
     LTP_LIB_EXPORT void SetRedPartReceptionCallback(const RedPartReceptionCallback_t & callback);
+    LTP_LIB_EXPORT void SetRedPartFileReceptionCallback(const RedPartFileReceptionCallback_t & callback);
     LTP_LIB_EXPORT void SetGreenPartSegmentArrivalCallback(const GreenPartSegmentArrivalCallback_t & callback);
     LTP_LIB_EXPORT void SetReceptionSessionCancelledCallback(const ReceptionSessionCancelledCallback_t & callback);
     LTP_LIB_EXPORT void SetTransmissionSessionCompletedCallback(const TransmissionSessionCompletedCallback_t & callback);
@@ -139,6 +145,12 @@ private:
     LTP_LIB_NO_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
         std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    LTP_LIB_NO_EXPORT void RedDataSegmentViewReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+        const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    LTP_LIB_NO_EXPORT void DataSegmentReceived(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+        const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
 
     LTP_LIB_NO_EXPORT void CancelSegmentTimerExpiredCallback(Ltp::session_id_t cancelSegmentTimerSerialNumber, std::vector<uint8_t> & userData);
     LTP_LIB_NO_EXPORT void NotifyEngineThatThisSenderNeedsDeletedCallback(const Ltp::session_id_t & sessionId, bool wasCancelled, CANCEL_SEGMENT_REASON_CODES reasonCode, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
@@ -159,6 +171,8 @@ private:
     LtpRandomNumberGenerator m_rng;
     const uint64_t M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION;
     const uint64_t M_MAX_RED_RX_BYTES_PER_SESSION;
+    uint64_t m_redPartSpillThresholdBytesOrZeroToDisable;
+    boost::filesystem::path m_redPartSpillDirectory;
     const uint64_t M_THIS_ENGINE_ID;
     const uint64_t M_MTU_CLIENT_SERVICE_DATA;
 protected:
@@ -194,6 +208,7 @@ private:
 
     SessionStartCallback_t m_sessionStartCallback;
     RedPartReceptionCallback_t m_redPartReceptionCallback;
+    RedPartFileReceptionCallback_t m_redPartFileReceptionCallback;
     GreenPartSegmentArrivalCallback_t m_greenPartSegmentArrivalCallback;
     ReceptionSessionCancelledCallback_t m_receptionSessionCancelledCallback;
     TransmissionSessionCompletedCallback_t m_transmissionSessionCompletedCallback;
@@ -22,8 +22,10 @@
 
 #include "Ltp.h"
 #include <vector>
+#include <memory>
 #include <boost/function.hpp>
 #include "PaddedVectorUint8.h"
+#include "MemoryMappedFileBuffer.h"
 
 //add a way to associate data with the specific outgoing LTP session
 struct LtpTransmissionRequestUserData {
@@ -81,6 +83,14 @@ typedef boost::function<void(const Ltp::session_id_t & sessionId,
 typedef boost::function<void(const Ltp::session_id_t & sessionId,
     padded_vector_uint8_t & movableClientServiceDataVec, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)> RedPartReceptionCallback_t;
 
+//Red-Part Reception of a block whose red part was spilled to disk (see LtpEngine::SetRedPartSpillToDisk):
+//same as RedPartReceptionCallback_t except the red part is delivered in a memory mapped file (resized to lengthOfRedPart)
+//which the client service may take (std::move) and keep.
+//If this callback is not set, spilled red parts are copied into RAM and delivered to the RedPartReceptionCallback_t.
+//Red parts that were not spilled are always delivered to the RedPartReceptionCallback_t.
+typedef boost::function<void(const Ltp::session_id_t & sessionId,
+    std::unique_ptr<MemoryMappedFileBuffer> & movableRedPartFileBufferPtr, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)> RedPartFileReceptionCallback_t;
+
 //7.4.Transmission - Session Completion
 //The sole parameter provided by the LTP engine when a transmission -
 //session completion notice is delivered is the session ID of the
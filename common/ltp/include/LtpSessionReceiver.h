@@ -27,7 +27,9 @@
 #include <queue>
 #include <set>
 #include <map>
+#include <memory>
 #include <boost/asio.hpp>
+#include <boost/filesystem/path.hpp>
 #include "LtpNoticesToClientService.h"
 
 typedef boost::function<void(const Ltp::session_id_t & sessionId, bool wasCancelled, CANCEL_SEGMENT_REASON_CODES reasonCode)> NotifyEngineThatThisReceiverNeedsDeletedCallback_t;
@@ -47,6 +49,7 @@ public:
     
     LTP_LIB_EXPORT LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS,
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
+        const uint64_t redPartSpillThresholdBytesOrZeroToDisable, const boost::filesystem::path & redPartSpillDirectory,
         const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
         LtpTimerManager<Ltp::session_id_t, Ltp::hash_session_id_t> & timeManagerOfReportSerialNumbersRef,
@@ -61,11 +64,19 @@ public:
     LTP_LIB_EXPORT std::size_t GetNumActiveTimers() const; //stagnant rx session detection in ltp engine with periodic housekeeping timer
     LTP_LIB_EXPORT void ReportAcknowledgementSegmentReceivedCallback(uint64_t reportSerialNumberBeingAcknowledged,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    //clientServiceDataVecPtr is NULL when clientServiceData is a view into the udp receive buffer (red data only)
     LTP_LIB_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
-        std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
-        const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
+        const RedPartFileReceptionCallback_t & redPartFileReceptionCallback, const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
 private:
+    //returns where the red data of [0, offsetPlusLength) is stored (in RAM or spilled to a file), or NULL on failure
+    LTP_LIB_NO_EXPORT uint8_t * GetRedDataStorage(const uint64_t offsetPlusLength, const bool isEndOfRedPart, bool & neededResize);
+    LTP_LIB_NO_EXPORT void SpillRedDataToFile(const uint64_t offsetPlusLength, const bool isEndOfRedPart);
+    LTP_LIB_NO_EXPORT bool AllocateRedDataFileSpace(const uint64_t offset, const uint64_t length);
+    LTP_LIB_NO_EXPORT void DeliverRedPart(const uint64_t clientServiceId, const bool isEndOfBlock,
+        const RedPartReceptionCallback_t & redPartReceptionCallback, const RedPartFileReceptionCallback_t & redPartFileReceptionCallback);
+
     std::set<LtpFragmentSet::data_fragment_t> m_receivedDataFragmentsSet;
     typedef std::map<uint64_t, Ltp::report_segment_t> report_segments_sent_map_t;
     report_segments_sent_map_t m_mapAllReportSegmentsSent;
@@ -95,9 +106,16 @@ private:
     
     uint64_t m_nextReportSegmentReportSerialNumber;
     padded_vector_uint8_t m_dataReceivedRed;
+    std::unique_ptr<MemoryMappedFileBuffer> m_dataReceivedRedFileBufferPtr; //non-null once the red part has been spilled to disk
+    uint64_t m_dataReceivedRedFileSize; //like m_dataReceivedRed.size() (the file size is like the capacity)
+    uint64_t m_dataReceivedRedFileAllocatedBegin; //[begin, end) of the spill file known to have its disk space allocated
+    uint64_t m_dataReceivedRedFileAllocatedEnd;
+    bool m_redPartSpillFailed; //don't retry every segment, keep the red part in RAM
     const uint64_t M_MAX_RECEPTION_CLAIMS;
     const uint64_t M_ESTIMATED_BYTES_TO_RECEIVE;
     const uint64_t M_MAX_RED_RX_BYTES;
+    const uint64_t M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE;
+    const boost::filesystem::path & M_RED_PART_SPILL_DIRECTORY; //owned by the LtpEngine
     const Ltp::session_id_t M_SESSION_ID;
     const uint64_t M_CLIENT_SERVICE_ID;
     const uint32_t M_MAX_RETRIES_PER_SERIAL_NUMBER;
@@ -28,6 +28,7 @@
 #include <vector>
 #include <map>
 #include <queue>
+#include <atomic>
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "LtpEngine.h"
 #include "UdpBatchSender.h"
@@ -53,12 +54,20 @@ public:
     LTP_LIB_EXPORT virtual void Reset();
     
     LTP_LIB_EXPORT void PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size);
+    //batched version of PostPacketFromManager_ThreadSafe: queue packets (from the manager's thread) then post them all to the LtpEngine thread at once
+    LTP_LIB_EXPORT bool QueuePacketFromManager_NotThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size); //returns true if this was the first packet queued since the last post
+    LTP_LIB_EXPORT void PostQueuedPacketsFromManager_ThreadSafe();
+
+    //send runs of equal-size packets as single UDP_SEGMENT (GSO) super-packets; only applies to the dedicated batch sender
+    //(i.e. maxUdpPacketsToSendPerSystemCall > 1).  Call before any sessions are started.  Returns false if not enabled.
+    LTP_LIB_EXPORT bool SetUseUdpSegmentationOffload(const bool useUdpSegmentationOffload);
 
     LTP_LIB_EXPORT void SetEndpoint_ThreadSafe(const boost::asio::ip::udp::endpoint& remoteEndpoint);
     LTP_LIB_EXPORT void SetEndpoint_ThreadSafe(const std::string& remoteHostname, const uint16_t remotePort);
 
 private:
     LTP_LIB_NO_EXPORT virtual void PacketInFullyProcessedCallback(bool success);
+    LTP_LIB_NO_EXPORT void PacketsInFromManager(unsigned int readIndex, const unsigned int numPackets);
     LTP_LIB_NO_EXPORT virtual void SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec,
         std::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback,
         std::shared_ptr<LtpClientServiceDataToSend>& underlyingCsDataToDeleteOnSentCallback);
@@ -86,6 +95,9 @@ private:
     const uint64_t M_MAX_UDP_RX_PACKET_SIZE_BYTES;
     CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
     std::vector<std::vector<boost::uint8_t> > m_udpReceiveBuffersCbVec;
+    std::vector<std::size_t> m_udpReceiveBytesTransferredCbVec; //only used by queued packets from the manager
+    unsigned int m_firstQueuedFromManagerCbIndex;
+    unsigned int m_numQueuedFromManager;
 
     bool m_printedCbTooSmallNotice;
 
@@ -104,6 +116,9 @@ public:
 
     uint64_t m_countCircularBufferOverruns;
     uint64_t m_countUdpPacketsReceived;
+
+    //index of the LtpUdpEngineManager udp receive thread allowed to write m_circularIndexBuffer (single producer)
+    std::atomic<unsigned int> m_ownerUdpReceiveThreadIndex;
 };
 
 
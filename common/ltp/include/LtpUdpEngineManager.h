@@ -18,6 +18,10 @@
  * It manages a bidirectional udp socket paired with its own boost::asio::io_service and thread.
  * It quickly examines the first few bytes of incoming UDP packets so that it can
  * route them to their proper LtpUdpEngine.
+ * On POSIX, the socket can optionally pull a batch of UDP packets per recvmmsg system call
+ * (see SetMaxUdpPacketsToReceivePerSystemCallForAllLtp) and hand them to each LtpUdpEngine in bulk.
+ * The bound port can also be opened several times with SO_REUSEPORT, one receive thread per socket
+ * (see SetNumUdpReceiveThreadsPerPortForAllLtp), so that demultiplexing scales across cores.
  */
 
 #ifndef _LTP_UDP_ENGINE_MANAGER_H
@@ -28,7 +32,11 @@
 #include <boost/asio.hpp>
 #include <vector>
 #include <map>
+#include <atomic>
 #include "LtpUdpEngine.h"
+#ifndef _WIN32
+#include <sys/socket.h> //for recvmmsg
+#endif
 
 //Every "link" should have a unique engine ID, managed by using the remote eid that the link will be connecting to as the engine id for LTP
 //We track a link as a paired induct/outduct and for each link there is one engine id
@@ -127,18 +135,88 @@ public:
     
     LTP_LIB_EXPORT bool ReadyToForward();
 private:
-    LTP_LIB_NO_EXPORT void StartUdpReceive();
-    LTP_LIB_NO_EXPORT void HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred);
+    //One bound udp socket plus the state needed to receive on it.  The first one uses m_udpSocket/m_ioServiceUdp/m_ioServiceUdpThreadPtr.
+    //When more than one receive thread is used, the others each own an SO_REUSEPORT socket bound to the same port and an io_service/thread.
+    struct udp_receive_thread_t {
+        udp_receive_thread_t(const unsigned int index, boost::asio::io_service * ioServicePtr, boost::asio::ip::udp::socket * udpSocketPtr);
+        udp_receive_thread_t(const unsigned int index); //creates and owns its io_service and socket
+
+        const unsigned int m_index;
+        std::unique_ptr<boost::asio::io_service> m_ioServiceOwnedPtr;
+        std::unique_ptr<boost::asio::ip::udp::socket> m_udpSocketOwnedPtr;
+        std::unique_ptr<boost::asio::deadline_timer> m_retryAfterSocketErrorTimerOwnedPtr;
+        std::unique_ptr<boost::thread> m_threadOwnedPtr;
+        boost::asio::io_service * const m_ioServicePtr;
+        boost::asio::ip::udp::socket * const m_udpSocketPtr;
+
+        std::vector<boost::uint8_t> m_udpReceiveBuffer;
+        boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
+        std::vector<std::vector<boost::uint8_t> > m_udpReceiveBuffersBatchVec; //ring of recvmmsg buffers that get swapped (not copied) into the engines (GRO: 64KB, split by copy)
+#ifndef _WIN32
+        std::vector<struct mmsghdr> m_recvMmsgHeadersVec;
+        std::vector<struct iovec> m_recvMmsgIovecsVec;
+        std::vector<uint64_t> m_recvMmsgControlBuffersVec; //UDP_GRO cmsg storage (uint64_t for cmsghdr alignment)
+#endif
+        std::vector<LtpUdpEngine*> m_enginesWithQueuedPacketsFromBatchVec;
+    };
+
+    LTP_LIB_NO_EXPORT void InitUdpReceiveBuffers(udp_receive_thread_t & rxThread);
+    LTP_LIB_NO_EXPORT bool OpenAndBindUdpSocket(boost::asio::ip::udp::socket & udpSocket, const uint16_t udpPort);
+    LTP_LIB_NO_EXPORT void StartUdpReceive(udp_receive_thread_t & rxThread);
+    LTP_LIB_NO_EXPORT void HandleUdpReceive(udp_receive_thread_t & rxThread, const boost::system::error_code & error, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT void HandleUdpReceiveBatch(udp_receive_thread_t & rxThread, const boost::system::error_code & error);
+    LTP_LIB_NO_EXPORT void HandleUdpReceiveError(udp_receive_thread_t & rxThread, const boost::system::error_code & error);
+    LTP_LIB_NO_EXPORT void HandleUdpReceiveFatalError(udp_receive_thread_t & rxThread);
+    LTP_LIB_NO_EXPORT bool QueueReceivedPacketFromBatch(udp_receive_thread_t & rxThread, std::vector<uint8_t> & packet, std::size_t bytesTransferred); //returns false on fatal error
+    LTP_LIB_NO_EXPORT bool ClaimLtpUdpEngineForUdpReceiveThread(LtpUdpEngine * ltpUdpEnginePtr, const udp_receive_thread_t & rxThread, unsigned int & ownerIndex);
+    LTP_LIB_NO_EXPORT void ForwardPacketToUdpReceiveThread(const unsigned int ownerIndex, const std::vector<uint8_t> & packet, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT void HandleForwardedPacket(udp_receive_thread_t & rxThread, std::shared_ptr<std::vector<uint8_t> > & packetPtr, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT LtpUdpEngine * GetLtpUdpEnginePtrForReceivedPacket(const std::vector<uint8_t> & packet, std::size_t bytesTransferred, bool & isFatalError);
     LTP_LIB_NO_EXPORT void OnRetryAfterSocketError_TimerExpired(const boost::system::error_code& e);
+    LTP_LIB_NO_EXPORT void OnRetryAfterSocketErrorAdditionalThread_TimerExpired(udp_receive_thread_t & rxThread, const boost::system::error_code& e);
     LTP_LIB_NO_EXPORT void SocketRestored_TimerExpired(const boost::system::error_code& e);
+    LTP_LIB_NO_EXPORT void DoUdpShutdownAdditionalThread(udp_receive_thread_t & rxThread);
 public:
     LTP_LIB_EXPORT static std::shared_ptr<LtpUdpEngineManager> GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart);
     LTP_LIB_EXPORT static void SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t maxUdpRxPacketSizeBytesForAllLtp);
+    /** Set the max number of udp packets to receive per system call for all LtpUdpEngineManager(s) created after this call.
+     * If 1 is used (the default), one boost::asio::async_receive_from is called per one udp packet received.
+     * If more than 1 is used, the manager waits for the socket to become readable and then pulls up to this many
+     * udp packets with a single recvmmsg into a ring of preallocated receive buffers (POSIX only, Windows always uses 1).
+     * The received packets are then handed to their LtpUdpEngine(s) with one post per engine per system call.
+     *
+     * @param maxUdpPacketsToReceivePerSystemCallForAllLtp The max number of udp packets to receive per system call (must be non-zero and <= UIO_MAXIOV).
+     */
+    LTP_LIB_EXPORT static void SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(const uint64_t maxUdpPacketsToReceivePerSystemCallForAllLtp);
+    /** Enable UDP segmentation offload for all LtpUdpEngineManager(s) created after this call (Linux only).
+     * On send, engines using a dedicated batch sender (maxUdpPacketsToSendPerSystemCall > 1) coalesce runs of equal-size
+     * LTP segments into UDP_SEGMENT (GSO) super-packets that the kernel or NIC splits back into normal udp datagrams.
+     * On receive, UDP_GRO is enabled on the bound socket so the kernel may hand up several coalesced datagrams per super-packet,
+     * which are then split back into individual LTP segments in user space (this forces the recvmmsg receive path even if
+     * the max udp packets to receive per system call is 1).
+     *
+     * @param useUdpSegmentationOffloadForAllLtp True to enable GSO/GRO, false (the default) to disable.
+     */
+    LTP_LIB_EXPORT static void SetUdpSegmentationOffloadForAllLtp(const bool useUdpSegmentationOffloadForAllLtp);
+    /** Set the number of udp receive threads per bound port for all LtpUdpEngineManager(s) created after this call.
+     * If 1 is used (the default), one socket and one thread receive and demultiplex all LTP traffic for the bound port.
+     * If more than 1 is used (POSIX with SO_REUSEPORT only), the bound port is opened this many times with SO_REUSEPORT,
+     * each socket getting its own io_service and thread.  The kernel spreads remote peers across the sockets by their
+     * address/port hash, so LTP receive processing for many remote engines scales across cores.
+     * Each LtpUdpEngine is owned by the first receive thread that delivers it a packet (keeping its circular buffer single producer);
+     * the occasional packet for that engine arriving on another socket is copied and handed off to the owning thread.
+     *
+     * @param numUdpReceiveThreadsPerPortForAllLtp The number of receive sockets/threads per bound udp port (must be non-zero).
+     */
+    LTP_LIB_EXPORT static void SetNumUdpReceiveThreadsPerPortForAllLtp(const uint64_t numUdpReceiveThreadsPerPortForAllLtp);
 private:
     //LtpUdpEngineManager(); 
     static std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> > m_staticMapBoundPortToLtpUdpEngineManagerPtr;
     static boost::mutex m_staticMutex;
     static uint64_t M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES;
+    static uint64_t M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES;
+    static bool M_STATIC_USE_UDP_SEGMENTATION_OFFLOAD_FOR_ALL_LTP_UDP_ENGINES;
+    static uint64_t M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES;
     
 
 
@@ -152,8 +230,12 @@ private:
     std::unique_ptr<boost::thread> m_ioServiceUdpThreadPtr;
 
     
-    std::vector<boost::uint8_t> m_udpReceiveBuffer;
-    boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
+    const unsigned int M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL;
+    const bool M_USE_UDP_SEGMENTATION_OFFLOAD;
+    const bool M_USE_BATCH_RECEIVE;
+    const unsigned int M_NUM_UDP_RECEIVE_THREADS;
+    std::vector<std::unique_ptr<udp_receive_thread_t> > m_udpReceiveThreadsVec; //element 0 is the m_udpSocket/m_ioServiceUdp thread
+    boost::shared_mutex m_enginesSharedMutex; //only used with more than one receive thread: engine maps are read by all receive threads
     //std::map<std::pair<uint64_t, bool>, std::unique_ptr<LtpUdpEngine> > m_mapSessionOriginatorEngineIdPlusIsInductToLtpUdpEnginePtr;
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr; //inducts (differentiate by remote engine id using this map)
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr; //outducts (differentiate by engine index encoded into the session number, cannot use this map)
@@ -162,6 +244,12 @@ private:
 
     volatile bool m_readyToForward;
 public:
+    //updated by all receive threads (once per receive operation)
+    std::atomic<uint64_t> m_countUdpReceiveSystemCalls;
+    std::atomic<uint64_t> m_countUdpPacketsReceived;
+    std::atomic<uint64_t> m_countUdpGroSuperPacketsReceived; //udp packets that were coalesced by UDP_GRO (each counted once in m_countUdpPacketsReceived per segment)
+    std::atomic<uint64_t> m_countUdpPacketsForwardedBetweenReceiveThreads;
+    //udp packets received per system call is m_countUdpPacketsReceived / m_countUdpReceiveSystemCalls
 };
 
 
@@ -329,6 +329,9 @@ Ltp::~Ltp() {
 void Ltp::SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback) {
     m_dataSegmentContentsReadCallback = callback;
 }
+void Ltp::SetRedDataSegmentContentsViewReadCallback(const RedDataSegmentContentsViewReadCallback_t & callback) {
+    m_redDataSegmentContentsViewReadCallback = callback;
+}
 void Ltp::SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback) {
     m_reportSegmentContentsReadCallback = callback;
 }
@@ -1101,7 +1104,21 @@ const uint8_t * Ltp::TryShortcutReadDataSegmentSdnvs(const uint8_t * rxVals, std
         }
     }
     numChars -= numBytesTakenToDecodeThisSdnvArray;
-    return (rxVals + numBytesTakenToDecodeThisSdnvArray);
+    rxVals += numBytesTakenToDecodeThisSdnvArray;
+
+    //zero copy shortcut for red data: the whole client service data is already in rxVals, so skip m_dataSegment_clientServiceData
+    if ((m_dataSegmentRxState == LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_DATA)
+        && (m_segmentTypeFlags <= 3)
+        && (m_numTrailerExtensionTlvs == 0)
+        && (numChars >= m_dataSegmentMetadata.length)
+        && m_redDataSegmentContentsViewReadCallback)
+    {
+        m_redDataSegmentContentsViewReadCallback(m_segmentTypeFlags, m_sessionId, rxVals, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+        numChars -= m_dataSegmentMetadata.length;
+        rxVals += m_dataSegmentMetadata.length;
+        SetBeginningState();
+    }
+    return rxVals;
 
 #else //below is the working non-batch read version
     uint8_t sdnvSize;
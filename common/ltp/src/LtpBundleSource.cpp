@@ -276,5 +276,7 @@ void LtpBundleSource::SyncTelemetry() {
         m_ltpOutductTelemetry.countUdpPacketsSent = m_ltpUdpEnginePtr->m_countAsyncSendCallbackCalls + m_ltpUdpEnginePtr->m_countBatchUdpPacketsSent;
         m_ltpOutductTelemetry.countRxUdpCircularBufferOverruns = m_ltpUdpEnginePtr->m_countCircularBufferOverruns;
         m_ltpOutductTelemetry.countTxUdpPacketsLimitedByRate = m_ltpUdpEnginePtr->m_countAsyncSendsLimitedByRate;
+        m_ltpOutductTelemetry.countRxUdpSystemCalls = m_ltpUdpEngineManagerPtr->m_countUdpReceiveSystemCalls;
+        m_ltpOutductTelemetry.countRxUdpPacketsFromSystemCalls = m_ltpUdpEngineManagerPtr->m_countUdpPacketsReceived;
     }
 }
@@ -33,6 +33,7 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     const uint64_t delaySendingOfDataSegmentsTimeMsOrZeroToDisable) :
     M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION(ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION),
     M_MAX_RED_RX_BYTES_PER_SESSION(maxRedRxBytesPerSession),
+    m_redPartSpillThresholdBytesOrZeroToDisable(0),
     M_THIS_ENGINE_ID(thisEngineId),
     M_MTU_CLIENT_SERVICE_DATA(mtuClientServiceData),
     M_MAX_UDP_PACKETS_TO_SEND_PER_SYSTEM_CALL(maxUdpPacketsToSendPerSystemCall),
@@ -90,6 +91,9 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     m_ltpRxStateMachine.SetDataSegmentContentsReadCallback(boost::bind(&LtpEngine::DataSegmentReceivedCallback, this,
         boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
         boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+    m_ltpRxStateMachine.SetRedDataSegmentContentsViewReadCallback(boost::bind(&LtpEngine::RedDataSegmentViewReceivedCallback, this,
+        boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+        boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
 
     m_rng.SetEngineIndex(engineIndexForEncodingIntoRandomSessionNumber);
     SetMtuReportSegment(mtuReportSegment);
@@ -189,6 +193,14 @@ void LtpEngine::SetMtuReportSegment(uint64_t mtuReportSegment) {
     LOG_INFO(subprocess) << "max reception claims = " << m_maxReceptionClaims;
 }
 
+void LtpEngine::SetRedPartSpillToDisk(const boost::filesystem::path & spillDirectory, const uint64_t thresholdBytesOrZeroToDisable) {
+    m_redPartSpillDirectory = spillDirectory;
+    m_redPartSpillThresholdBytesOrZeroToDisable = thresholdBytesOrZeroToDisable;
+    if (thresholdBytesOrZeroToDisable) {
+        LOG_INFO(subprocess) << "red parts larger than " << thresholdBytesOrZeroToDisable << " bytes will be spilled to disk in " << spillDirectory;
+    }
+}
+
 bool LtpEngine::PacketIn(const uint8_t * data, const std::size_t size, Ltp::SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr) {
     std::string errorMessage;
     const bool success = m_ltpRxStateMachine.HandleReceivedChars(data, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
@@ -935,6 +947,21 @@ void LtpEngine::ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionI
 void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
     std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
     Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+{
+    DataSegmentReceived(segmentTypeFlags, sessionId, clientServiceDataVec.data(), &clientServiceDataVec, dataSegmentMetadata, headerExtensions, trailerExtensions);
+}
+
+//zero copy version: clientServiceData points into the received udp packet and is copied once into the session's red part
+void LtpEngine::RedDataSegmentViewReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+    const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+{
+    DataSegmentReceived(segmentTypeFlags, sessionId, clientServiceData, NULL, dataSegmentMetadata, headerExtensions, trailerExtensions);
+}
+
+void LtpEngine::DataSegmentReceived(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+    const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
 {
     if (sessionId.sessionOriginatorEngineId == M_THIS_ENGINE_ID) {
         //Github issue 26: Allow same-engine transfers
@@ -967,7 +994,7 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
         }
         const uint64_t randomNextReportSegmentReportSerialNumber = (M_FORCE_32_BIT_RANDOM_NUMBERS) ? m_rng.GetRandomSerialNumber32(m_randomDevice) : m_rng.GetRandomSerialNumber64(m_randomDevice); //incremented by 1 for new
         std::unique_ptr<LtpSessionReceiver> session = boost::make_unique<LtpSessionReceiver>(randomNextReportSegmentReportSerialNumber, m_maxReceptionClaims,
-            M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, M_MAX_RED_RX_BYTES_PER_SESSION,
+            M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, M_MAX_RED_RX_BYTES_PER_SESSION, m_redPartSpillThresholdBytesOrZeroToDisable, m_redPartSpillDirectory,
             sessionId, dataSegmentMetadata.clientServiceId, M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_timeManagerOfReportSerialNumbers, m_timeManagerOfSendingDelayedReceptionReports,
             boost::bind(&LtpEngine::NotifyEngineThatThisReceiverNeedsDeletedCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3),
             boost::bind(&LtpEngine::NotifyEngineThatThisReceiversTimersHasProducibleData, this, boost::placeholders::_1), m_maxRetriesPerSerialNumber);
@@ -984,7 +1011,7 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
             m_sessionStartCallback(sessionId);
         }
     }
-    rxSessionIt->second->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceDataVec, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_greenPartSegmentArrivalCallback);
+    rxSessionIt->second->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceData, clientServiceDataVecPtr, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_redPartFileReceptionCallback, m_greenPartSegmentArrivalCallback);
     TrySendPacketIfAvailable();
 }
 
@@ -994,6 +1021,9 @@ void LtpEngine::SetSessionStartCallback(const SessionStartCallback_t & callback)
 void LtpEngine::SetRedPartReceptionCallback(const RedPartReceptionCallback_t & callback) {
     m_redPartReceptionCallback = callback;
 }
+void LtpEngine::SetRedPartFileReceptionCallback(const RedPartFileReceptionCallback_t & callback) {
+    m_redPartFileReceptionCallback = callback;
+}
 void LtpEngine::SetGreenPartSegmentArrivalCallback(const GreenPartSegmentArrivalCallback_t & callback) {
     m_greenPartSegmentArrivalCallback = callback;
 }
@@ -16,11 +16,14 @@
 #include "Logger.h"
 #include <inttypes.h>
 #include <boost/bind/bind.hpp>
+#include <boost/lexical_cast.hpp>
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
+static constexpr uint64_t RED_PART_SPILL_FILE_ALLOCATION_CHUNK_BYTES = 1048576;
 
 LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
+    const uint64_t redPartSpillThresholdBytesOrZeroToDisable, const boost::filesystem::path & redPartSpillDirectory,
     const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
     LtpTimerManager<Ltp::session_id_t, Ltp::hash_session_id_t> & timeManagerOfReportSerialNumbersRef,
@@ -33,9 +36,15 @@ LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSer
     m_timeManagerOfReportSerialNumbersRef(timeManagerOfReportSerialNumbersRef),
     m_timeManagerOfSendingDelayedReceptionReportsRef(timeManagerOfSendingDelayedReceptionReportsRef),
     m_nextReportSegmentReportSerialNumber(randomNextReportSegmentReportSerialNumber),
+    m_dataReceivedRedFileSize(0),
+    m_dataReceivedRedFileAllocatedBegin(0),
+    m_dataReceivedRedFileAllocatedEnd(0),
+    m_redPartSpillFailed(false),
     M_MAX_RECEPTION_CLAIMS(MAX_RECEPTION_CLAIMS),
     M_ESTIMATED_BYTES_TO_RECEIVE(ESTIMATED_BYTES_TO_RECEIVE),
     M_MAX_RED_RX_BYTES(maxRedRxBytes),
+    M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE(redPartSpillThresholdBytesOrZeroToDisable),
+    M_RED_PART_SPILL_DIRECTORY(redPartSpillDirectory),
     M_SESSION_ID(sessionId),
     M_CLIENT_SERVICE_ID(clientServiceId),
     M_MAX_RETRIES_PER_SERIAL_NUMBER(maxRetriesPerSerialNumber),
@@ -61,7 +70,8 @@ LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSer
 {
     m_timerExpiredCallback = boost::bind(&LtpSessionReceiver::LtpReportSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2);
     m_delayedReceptionReportTimerExpiredCallback = boost::bind(&LtpSessionReceiver::LtpDelaySendReportSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2);
-    m_dataReceivedRed.reserve(ESTIMATED_BYTES_TO_RECEIVE);
+    m_dataReceivedRed.reserve((redPartSpillThresholdBytesOrZeroToDisable) ?
+        std::min(ESTIMATED_BYTES_TO_RECEIVE, redPartSpillThresholdBytesOrZeroToDisable) : ESTIMATED_BYTES_TO_RECEIVE);
 }
 
 LtpSessionReceiver::~LtpSessionReceiver() {
@@ -95,6 +105,129 @@ LtpSessionReceiver::~LtpSessionReceiver() {
             LOG_ERROR(subprocess) << "LtpSessionReceiver::~LtpSessionReceiver: did not delete timer in m_timeManagerOfSendingDelayedReceptionReportsRef";
         }
     }
+    //a spill file not taken by the client service is deleted by m_dataReceivedRedFileBufferPtr
+}
+
+//Move the red part received so far out of RAM into a sparse memory mapped file.
+//The file is sized to the red part length when known (EORP), otherwise to M_MAX_RED_RX_BYTES
+//(only the pages written occupy disk space), so it is resized at most once more (shrunk to the red part length on delivery).
+void LtpSessionReceiver::SpillRedDataToFile(const uint64_t offsetPlusLength, const bool isEndOfRedPart) {
+    const uint64_t fileSize = (isEndOfRedPart) ? offsetPlusLength : M_MAX_RED_RX_BYTES;
+    const boost::filesystem::path filePath = M_RED_PART_SPILL_DIRECTORY /
+        ("ltp_rx_red_part_" + boost::lexical_cast<std::string>(M_SESSION_ID.sessionOriginatorEngineId)
+            + "_" + boost::lexical_cast<std::string>(M_SESSION_ID.sessionNumber) + ".bin");
+    m_dataReceivedRedFileBufferPtr = MemoryMappedFileBuffer::Create(filePath, fileSize);
+    if (!m_dataReceivedRedFileBufferPtr) {
+        LOG_ERROR(subprocess) << "LtpSessionReceiver: unable to spill red part of session " << M_SESSION_ID
+            << " to disk, keeping it in RAM";
+        m_redPartSpillFailed = true;
+        return;
+    }
+    m_dataReceivedRedFileAllocatedBegin = 0;
+    m_dataReceivedRedFileAllocatedEnd = 0;
+    if (!m_dataReceivedRed.empty()) {
+        if (!AllocateRedDataFileSpace(0, m_dataReceivedRed.size())) {
+            LOG_ERROR(subprocess) << "LtpSessionReceiver: no disk space to spill red part of session " << M_SESSION_ID
+                << ", keeping it in RAM";
+            m_dataReceivedRedFileBufferPtr.reset();
+            m_redPartSpillFailed = true;
+            return;
+        }
+        memcpy(m_dataReceivedRedFileBufferPtr->data(), m_dataReceivedRed.data(), m_dataReceivedRed.size());
+    }
+    m_dataReceivedRedFileSize = m_dataReceivedRed.size();
+    padded_vector_uint8_t().swap(m_dataReceivedRed); //free the RAM
+}
+
+//The spill file is sparse, so a write through the mapping into a hole on a full disk raises SIGBUS.
+//Allocate the disk space of a range before writing it (in chunks, so in order segments cost one posix_fallocate per chunk).
+bool LtpSessionReceiver::AllocateRedDataFileSpace(const uint64_t offset, const uint64_t length) {
+    const uint64_t end = offset + length;
+    if ((offset >= m_dataReceivedRedFileAllocatedBegin) && (end <= m_dataReceivedRedFileAllocatedEnd)) {
+        return true;
+    }
+    const uint64_t chunkBegin = offset - (offset % RED_PART_SPILL_FILE_ALLOCATION_CHUNK_BYTES);
+    const uint64_t chunkEnd = std::min(
+        ((end + (RED_PART_SPILL_FILE_ALLOCATION_CHUNK_BYTES - 1)) / RED_PART_SPILL_FILE_ALLOCATION_CHUNK_BYTES) * RED_PART_SPILL_FILE_ALLOCATION_CHUNK_BYTES,
+        m_dataReceivedRedFileBufferPtr->size());
+    if (!m_dataReceivedRedFileBufferPtr->AllocateDiskSpace(chunkBegin, chunkEnd - chunkBegin)) {
+        return false;
+    }
+    if ((chunkBegin >= m_dataReceivedRedFileAllocatedBegin) && (chunkBegin <= m_dataReceivedRedFileAllocatedEnd)) {
+        m_dataReceivedRedFileAllocatedEnd = std::max(m_dataReceivedRedFileAllocatedEnd, chunkEnd); //extends the contiguous range
+    }
+    else {
+        m_dataReceivedRedFileAllocatedBegin = chunkBegin;
+        m_dataReceivedRedFileAllocatedEnd = chunkEnd;
+    }
+    return true;
+}
+
+uint8_t * LtpSessionReceiver::GetRedDataStorage(const uint64_t offsetPlusLength, const bool isEndOfRedPart, bool & neededResize) {
+    if ((!m_dataReceivedRedFileBufferPtr) && (M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) && (!m_redPartSpillFailed)
+        && (offsetPlusLength > M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE))
+    {
+        SpillRedDataToFile(offsetPlusLength, isEndOfRedPart);
+    }
+    if (m_dataReceivedRedFileBufferPtr) {
+        neededResize = (m_dataReceivedRedFileSize < offsetPlusLength);
+        if (neededResize) {
+            if ((offsetPlusLength > m_dataReceivedRedFileBufferPtr->size()) && (!m_dataReceivedRedFileBufferPtr->Resize(offsetPlusLength))) {
+                return NULL;
+            }
+            m_dataReceivedRedFileSize = offsetPlusLength;
+        }
+        return m_dataReceivedRedFileBufferPtr->data();
+    }
+    neededResize = (m_dataReceivedRed.size() < offsetPlusLength);
+    if (neededResize) {
+        if (offsetPlusLength > m_dataReceivedRed.capacity()) {
+            //grow once to the exact red part length when the EORP bound is known, otherwise geometrically but never past M_MAX_RED_RX_BYTES
+            //(or past the spill threshold, beyond which the red part moves to disk).
+            //Grow by 8x rather than 2x: every regrowth copies the red part received so far.  The larger capacity is not free memory:
+            //resize() below zero fills every byte up to offsetPlusLength (before the segments are copied in), so those pages are always resident,
+            //and the reserved tail beyond stays non-resident only where the allocator hands back fresh pages (e.g. a large mmap'ed allocation).
+            const uint64_t maxCapacity = ((M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE) && (!m_redPartSpillFailed)) ?
+                std::min(M_RED_PART_SPILL_THRESHOLD_BYTES_OR_ZERO_TO_DISABLE, M_MAX_RED_RX_BYTES) : M_MAX_RED_RX_BYTES;
+            const uint64_t newCapacity = (isEndOfRedPart) ? offsetPlusLength :
+                std::min(std::max(static_cast<uint64_t>(m_dataReceivedRed.capacity()) * 8, offsetPlusLength), maxCapacity);
+            m_dataReceivedRed.reserve(newCapacity);
+        }
+        m_dataReceivedRed.resize(offsetPlusLength);
+    }
+    return m_dataReceivedRed.data();
+}
+
+void LtpSessionReceiver::DeliverRedPart(const uint64_t clientServiceId, const bool isEndOfBlock,
+    const RedPartReceptionCallback_t & redPartReceptionCallback, const RedPartFileReceptionCallback_t & redPartFileReceptionCallback)
+{
+    if (!m_dataReceivedRedFileBufferPtr) {
+        if (redPartReceptionCallback) {
+            redPartReceptionCallback(M_SESSION_ID,
+                m_dataReceivedRed, m_lengthOfRedPart, clientServiceId, isEndOfBlock);
+        }
+    }
+    else if (redPartFileReceptionCallback) {
+        if (!m_dataReceivedRedFileBufferPtr->Resize(m_lengthOfRedPart)) { //give the client service a file of exactly the red part
+            //the failed resize unmapped the red part, so it can no longer be delivered in RAM either
+            LOG_ERROR(subprocess) << "LtpSessionReceiver: unable to deliver spilled red part of session " << M_SESSION_ID;
+            m_dataReceivedRedFileBufferPtr.reset();
+            if (!m_didNotifyForDeletion) {
+                m_didNotifyForDeletion = true;
+                m_notifyEngineThatThisReceiverNeedsDeletedCallback(M_SESSION_ID, true, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED); //close session (cancelled)
+            }
+            return;
+        }
+        redPartFileReceptionCallback(M_SESSION_ID,
+            m_dataReceivedRedFileBufferPtr, m_lengthOfRedPart, clientServiceId, isEndOfBlock);
+    }
+    else if (redPartReceptionCallback) { //client service only accepts red parts in RAM
+        const uint8_t * const redData = m_dataReceivedRedFileBufferPtr->data();
+        m_dataReceivedRed.assign(redData, redData + m_lengthOfRedPart);
+        m_dataReceivedRedFileBufferPtr.reset();
+        redPartReceptionCallback(M_SESSION_ID,
+            m_dataReceivedRed, m_lengthOfRedPart, clientServiceId, isEndOfBlock);
+    }
 }
 
 std::size_t LtpSessionReceiver::GetNumActiveTimers() const {
@@ -266,15 +399,15 @@ void LtpSessionReceiver::ReportAcknowledgementSegmentReceivedCallback(uint64_t r
 
 
 void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
-    std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
     Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
-    const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
+    const RedPartFileReceptionCallback_t & redPartFileReceptionCallback, const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
 {
     m_lastSegmentReceivedTimestamp = boost::posix_time::microsec_clock::universal_time();
 
     const uint64_t offsetPlusLength = dataSegmentMetadata.offset + dataSegmentMetadata.length;
     
-    if (dataSegmentMetadata.length != clientServiceDataVec.size()) {
+    if (clientServiceDataVecPtr && (dataSegmentMetadata.length != clientServiceDataVecPtr->size())) {
         LOG_ERROR(subprocess) << "dataSegmentMetadata.length != clientServiceDataVec.size()";
     }
     
@@ -324,14 +457,22 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
             }
             return;
         }
-        const bool neededResize = (m_dataReceivedRed.size() < offsetPlusLength);
-        if (neededResize) {
-            m_dataReceivedRed.resize(offsetPlusLength);
+        bool neededResize;
+        uint8_t * const redDataStorage = GetRedDataStorage(offsetPlusLength, ((segmentTypeFlags & 2) != 0), neededResize);
+        if ((redDataStorage == NULL) || ((m_dataReceivedRedFileBufferPtr)
+            && (!AllocateRedDataFileSpace(dataSegmentMetadata.offset, dataSegmentMetadata.length))))
+        {
+            LOG_ERROR(subprocess) << "LtpSessionReceiver::DataSegmentReceivedCallback: unable to store red data of session " << M_SESSION_ID;
+            if (!m_didNotifyForDeletion) {
+                m_didNotifyForDeletion = true;
+                m_notifyEngineThatThisReceiverNeedsDeletedCallback(M_SESSION_ID, true, CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED); //close session (cancelled)
+            }
+            return;
         }
         const bool dataReceivedWasNew = LtpFragmentSet::InsertFragment(m_receivedDataFragmentsSet, 
             LtpFragmentSet::data_fragment_t(dataSegmentMetadata.offset, offsetPlusLength - 1));
         if (dataReceivedWasNew) {
-            memcpy(m_dataReceivedRed.data() + dataSegmentMetadata.offset, clientServiceDataVec.data(), dataSegmentMetadata.length);
+            memcpy(redDataStorage + dataSegmentMetadata.offset, clientServiceData, dataSegmentMetadata.length); //the only copy when clientServiceData is a view
         }
         bool rsWasJustNowSentWithFullRedBounds = false;
         const bool gapsWereFilled = (dataReceivedWasNew && (!neededResize));
@@ -537,10 +678,7 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
                 }
 
                 m_didRedPartReceptionCallback = true;
-                if (redPartReceptionCallback) {
-                    redPartReceptionCallback(M_SESSION_ID,
-                        m_dataReceivedRed, m_lengthOfRedPart, dataSegmentMetadata.clientServiceId, isEndOfBlock);
-                }
+                DeliverRedPart(dataSegmentMetadata.clientServiceId, isEndOfBlock, redPartReceptionCallback, redPartFileReceptionCallback);
             }
         }
     }
@@ -570,7 +708,13 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
         }
 
         if (greenPartSegmentArrivalCallback) {
-            greenPartSegmentArrivalCallback(M_SESSION_ID, clientServiceDataVec, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            if (clientServiceDataVecPtr) {
+                greenPartSegmentArrivalCallback(M_SESSION_ID, *clientServiceDataVecPtr, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            }
+            else { //not expected (views are red only)
+                std::vector<uint8_t> clientServiceDataVec(clientServiceData, clientServiceData + dataSegmentMetadata.length);
+                greenPartSegmentArrivalCallback(M_SESSION_ID, clientServiceDataVec, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            }
         }
         
         if (isEndOfBlock) { //a green EOB
@@ -41,6 +41,9 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     M_MAX_UDP_RX_PACKET_SIZE_BYTES(maxUdpRxPacketSizeBytes),
     m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_udpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_firstQueuedFromManagerCbIndex(0),
+    m_numQueuedFromManager(0),
     m_printedCbTooSmallNotice(false),
     m_countAsyncSendCalls(0),
     m_countAsyncSendCallbackCalls(0),
@@ -48,7 +51,8 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     m_countBatchSendCallbackCalls(0),
     m_countBatchUdpPacketsSent(0),
     m_countCircularBufferOverruns(0),
-    m_countUdpPacketsReceived(0)
+    m_countUdpPacketsReceived(0),
+    m_ownerUdpReceiveThreadIndex(0)
 {
     for (unsigned int i = 0; i < M_NUM_CIRCULAR_BUFFER_VECTORS; ++i) {
         m_udpReceiveBuffersCbVec[i].resize(maxUdpRxPacketSizeBytes);
@@ -116,6 +120,46 @@ void LtpUdpEngine::PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packe
     }
 }
 
+bool LtpUdpEngine::QueuePacketFromManager_NotThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size) {
+    //called by the LtpUdpEngineManager thread only
+    ++m_countUdpPacketsReceived;
+    const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
+    if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+        ++m_countCircularBufferOverruns;
+        if (!m_printedCbTooSmallNotice) {
+            m_printedCbTooSmallNotice = true;
+            LOG_WARNING(subprocess) << "LtpUdpEngine::QueuePacketFromManager_NotThreadSafe(): buffers full.. you might want to increase the circular buffer size! Next UDP packet will be dropped!";
+        }
+        return false;
+    }
+    packetIn_thenSwappedForAnotherSameSizeVector.swap(m_udpReceiveBuffersCbVec[writeIndex]);
+    m_udpReceiveBytesTransferredCbVec[writeIndex] = size;
+    m_circularIndexBuffer.CommitWrite(); //write complete at this point
+    if (m_numQueuedFromManager == 0) {
+        m_firstQueuedFromManagerCbIndex = writeIndex;
+    }
+    return ((m_numQueuedFromManager++) == 0);
+}
+
+void LtpUdpEngine::PostQueuedPacketsFromManager_ThreadSafe() {
+    //called by the LtpUdpEngineManager thread only
+    if (m_numQueuedFromManager) {
+        //one post for the whole batch: the written indices are contiguous (mod size) starting at m_firstQueuedFromManagerCbIndex
+        boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpUdpEngine::PacketsInFromManager, this, m_firstQueuedFromManagerCbIndex, m_numQueuedFromManager));
+        m_numQueuedFromManager = 0;
+    }
+}
+
+void LtpUdpEngine::PacketsInFromManager(unsigned int readIndex, const unsigned int numPackets) {
+    //Called by LTP Engine thread
+    for (unsigned int i = 0; i < numPackets; ++i) {
+        PacketIn(m_udpReceiveBuffersCbVec[readIndex].data(), m_udpReceiveBytesTransferredCbVec[readIndex]); //calls PacketInFullyProcessedCallback which will CommitRead
+        if ((++readIndex) >= M_NUM_CIRCULAR_BUFFER_VECTORS) {
+            readIndex = 0;
+        }
+    }
+}
+
 void LtpUdpEngine::SendPacket(
     std::vector<boost::asio::const_buffer> & constBufferVec,
     std::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback,
@@ -186,6 +230,17 @@ void LtpUdpEngine::OnSentPacketsCallback(bool success, std::vector<std::vector<b
     }
 }
 
+bool LtpUdpEngine::SetUseUdpSegmentationOffload(const bool useUdpSegmentationOffload) {
+    if (M_MAX_UDP_PACKETS_TO_SEND_PER_SYSTEM_CALL > 1) { //using dedicated connected sender socket
+        return m_udpBatchSenderConnected.SetUseUdpSegmentationOffload(useUdpSegmentationOffload);
+    }
+    if (useUdpSegmentationOffload) {
+        LOG_WARNING(subprocess) << "LtpUdpEngine::SetUseUdpSegmentationOffload: udp segmentation offload requires maxUdpPacketsToSendPerSystemCall > 1";
+        return false;
+    }
+    return true;
+}
+
 void LtpUdpEngine::SetEndpoint_ThreadSafe(const boost::asio::ip::udp::endpoint& remoteEndpoint) {
     //m_ioServiceLtpEngine is the only running thread that uses m_remoteEndpoint
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpUdpEngine::SetEndpoint, this, remoteEndpoint));
@@ -17,6 +17,16 @@
 #include <boost/make_unique.hpp>
 #include <boost/lexical_cast.hpp>
 #include "Sdnv.h"
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#ifndef UDP_GRO
+# define UDP_GRO 104 //linux/udp.h (kernel 5.0+), not yet in all libc headers
+#endif
+#endif
 
 //c++ shared singleton using weak pointer
 //https://codereview.stackexchange.com/questions/14343/c-shared-singleton
@@ -26,6 +36,18 @@ static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess:
 std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> > LtpUdpEngineManager::m_staticMapBoundPortToLtpUdpEngineManagerPtr;
 boost::mutex LtpUdpEngineManager::m_staticMutex;
 uint64_t LtpUdpEngineManager::M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES = 0;
+uint64_t LtpUdpEngineManager::M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES = 1;
+bool LtpUdpEngineManager::M_STATIC_USE_UDP_SEGMENTATION_OFFLOAD_FOR_ALL_LTP_UDP_ENGINES = false;
+uint64_t LtpUdpEngineManager::M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES = 1;
+
+//LtpUdpEngine::m_ownerUdpReceiveThreadIndex value for an engine that no receive thread has delivered a packet to yet
+static constexpr unsigned int UDP_RECEIVE_THREAD_INDEX_UNCLAIMED = UINT_MAX;
+
+#ifndef _WIN32
+//a UDP_GRO super-packet can hold up to a full (max size) udp datagram worth of coalesced segments
+static constexpr std::size_t UDP_GRO_RX_BUFFER_SIZE_BYTES = 65535;
+static constexpr std::size_t UDP_GRO_CMSG_SPACE_UINT64S = (CMSG_SPACE(sizeof(int)) + (sizeof(uint64_t) - 1)) / sizeof(uint64_t);
+#endif
 
 //static function
 void LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t maxUdpRxPacketSizeBytesForAllLtp) {
@@ -46,6 +68,67 @@ void LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t max
     }
 }
 
+//static function
+void LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(const uint64_t maxUdpPacketsToReceivePerSystemCallForAllLtp) {
+    boost::mutex::scoped_lock theLock(m_staticMutex);
+    if (maxUdpPacketsToReceivePerSystemCallForAllLtp == 0) {
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp: must be non-zero";
+        return;
+    }
+#ifdef UIO_MAXIOV
+    //recvmmsg() is Linux-specific. The value specified in vlen is capped to UIO_MAXIOV (1024).
+    if (maxUdpPacketsToReceivePerSystemCallForAllLtp > UIO_MAXIOV) {
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp: ("
+            << maxUdpPacketsToReceivePerSystemCallForAllLtp << ") must be <= UIO_MAXIOV (" << UIO_MAXIOV << ").";
+        return;
+    }
+#endif //UIO_MAXIOV
+#ifdef _WIN32
+    if (maxUdpPacketsToReceivePerSystemCallForAllLtp > 1) {
+        LOG_WARNING(subprocess) << "LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp: recvmmsg not available on Windows.. using 1 udp packet per system call";
+        return;
+    }
+#endif
+    if (M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES != maxUdpPacketsToReceivePerSystemCallForAllLtp) {
+        M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES = maxUdpPacketsToReceivePerSystemCallForAllLtp;
+        LOG_INFO(subprocess) << "All new LTP UDP engine managers will receive up to " << M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES << " udp packets per system call";
+    }
+}
+
+//static function
+void LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(const bool useUdpSegmentationOffloadForAllLtp) {
+    boost::mutex::scoped_lock theLock(m_staticMutex);
+#ifdef _WIN32
+    if (useUdpSegmentationOffloadForAllLtp) {
+        LOG_WARNING(subprocess) << "LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp: UDP_SEGMENT/UDP_GRO not available on Windows.. ignoring";
+        return;
+    }
+#endif
+    if (M_STATIC_USE_UDP_SEGMENTATION_OFFLOAD_FOR_ALL_LTP_UDP_ENGINES != useUdpSegmentationOffloadForAllLtp) {
+        M_STATIC_USE_UDP_SEGMENTATION_OFFLOAD_FOR_ALL_LTP_UDP_ENGINES = useUdpSegmentationOffloadForAllLtp;
+        LOG_INFO(subprocess) << "All new LTP UDP engine managers will " << ((useUdpSegmentationOffloadForAllLtp) ? "use" : "not use") << " udp segmentation offload (GSO/GRO)";
+    }
+}
+
+//static function
+void LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(const uint64_t numUdpReceiveThreadsPerPortForAllLtp) {
+    boost::mutex::scoped_lock theLock(m_staticMutex);
+    if (numUdpReceiveThreadsPerPortForAllLtp == 0) {
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp: must be non-zero";
+        return;
+    }
+#if defined(_WIN32) || !defined(SO_REUSEPORT)
+    if (numUdpReceiveThreadsPerPortForAllLtp > 1) {
+        LOG_WARNING(subprocess) << "LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp: SO_REUSEPORT not available.. using 1 udp receive thread per port";
+        return;
+    }
+#endif
+    if (M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES != numUdpReceiveThreadsPerPortForAllLtp) {
+        M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES = numUdpReceiveThreadsPerPortForAllLtp;
+        LOG_INFO(subprocess) << "All new LTP UDP engine managers will use " << M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES << " udp receive threads per bound port";
+    }
+}
+
 //static function
 std::shared_ptr<LtpUdpEngineManager> LtpUdpEngineManager::GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart) {
     boost::mutex::scoped_lock theLock(m_staticMutex);
@@ -73,40 +156,139 @@ LtpUdpEngineManager::LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bo
     m_udpSocket(m_ioServiceUdp),
     m_retryAfterSocketErrorTimer(m_ioServiceUdp),
     m_socketRestoredTimer(m_ioServiceUdp),
-    m_udpReceiveBuffer(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES),
+    M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL(static_cast<unsigned int>(M_STATIC_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL_FOR_ALL_LTP_UDP_ENGINES)), //m_staticMutex locked by GetOrCreateInstance
+    M_USE_UDP_SEGMENTATION_OFFLOAD(M_STATIC_USE_UDP_SEGMENTATION_OFFLOAD_FOR_ALL_LTP_UDP_ENGINES),
+    M_USE_BATCH_RECEIVE((M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL > 1) || M_USE_UDP_SEGMENTATION_OFFLOAD),
+    M_NUM_UDP_RECEIVE_THREADS(static_cast<unsigned int>(M_STATIC_NUM_UDP_RECEIVE_THREADS_PER_PORT_FOR_ALL_LTP_UDP_ENGINES)),
     m_vecEngineIndexToLtpUdpEngineTransmitterPtr(256, NULL),
     m_nextEngineIndex(1),
-    m_readyToForward(false)
+    m_readyToForward(false),
+    m_countUdpReceiveSystemCalls(0),
+    m_countUdpPacketsReceived(0),
+    m_countUdpGroSuperPacketsReceived(0),
+    m_countUdpPacketsForwardedBetweenReceiveThreads(0)
 {
+    m_udpReceiveThreadsVec.reserve(M_NUM_UDP_RECEIVE_THREADS);
+    m_udpReceiveThreadsVec.emplace_back(boost::make_unique<udp_receive_thread_t>(0, &m_ioServiceUdp, &m_udpSocket));
+    for (unsigned int i = 1; i < M_NUM_UDP_RECEIVE_THREADS; ++i) {
+        m_udpReceiveThreadsVec.emplace_back(boost::make_unique<udp_receive_thread_t>(i));
+    }
+    for (unsigned int i = 0; i < M_NUM_UDP_RECEIVE_THREADS; ++i) {
+        InitUdpReceiveBuffers(*m_udpReceiveThreadsVec[i]);
+    }
     if (autoStart) {
         StartIfNotAlreadyRunning(); //TODO EVALUATE IF AUTO START SAFE
     }
 }
 
+LtpUdpEngineManager::udp_receive_thread_t::udp_receive_thread_t(const unsigned int index, boost::asio::io_service * ioServicePtr, boost::asio::ip::udp::socket * udpSocketPtr) :
+    m_index(index),
+    m_ioServicePtr(ioServicePtr),
+    m_udpSocketPtr(udpSocketPtr) {}
+
+LtpUdpEngineManager::udp_receive_thread_t::udp_receive_thread_t(const unsigned int index) :
+    m_index(index),
+    m_ioServiceOwnedPtr(boost::make_unique<boost::asio::io_service>()),
+    m_udpSocketOwnedPtr(boost::make_unique<boost::asio::ip::udp::socket>(*m_ioServiceOwnedPtr)),
+    m_retryAfterSocketErrorTimerOwnedPtr(boost::make_unique<boost::asio::deadline_timer>(*m_ioServiceOwnedPtr)),
+    m_ioServicePtr(m_ioServiceOwnedPtr.get()),
+    m_udpSocketPtr(m_udpSocketOwnedPtr.get()) {}
+
+void LtpUdpEngineManager::InitUdpReceiveBuffers(udp_receive_thread_t & rxThread) {
+    rxThread.m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+#ifndef _WIN32
+    if (M_USE_BATCH_RECEIVE) {
+        rxThread.m_udpReceiveBuffersBatchVec.resize(M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL);
+        rxThread.m_recvMmsgHeadersVec.resize(M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL);
+        rxThread.m_recvMmsgIovecsVec.resize(M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL);
+        rxThread.m_enginesWithQueuedPacketsFromBatchVec.reserve(M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL);
+        memset(rxThread.m_recvMmsgHeadersVec.data(), 0, rxThread.m_recvMmsgHeadersVec.size() * sizeof(struct mmsghdr));
+        if (M_USE_UDP_SEGMENTATION_OFFLOAD) {
+            rxThread.m_recvMmsgControlBuffersVec.assign(M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL * UDP_GRO_CMSG_SPACE_UINT64S, 0);
+        }
+        for (unsigned int i = 0; i < M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL; ++i) {
+            rxThread.m_udpReceiveBuffersBatchVec[i].resize((M_USE_UDP_SEGMENTATION_OFFLOAD) ? UDP_GRO_RX_BUFFER_SIZE_BYTES : M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+            rxThread.m_recvMmsgIovecsVec[i].iov_base = rxThread.m_udpReceiveBuffersBatchVec[i].data();
+            rxThread.m_recvMmsgIovecsVec[i].iov_len = rxThread.m_udpReceiveBuffersBatchVec[i].size();
+            rxThread.m_recvMmsgHeadersVec[i].msg_hdr.msg_iov = &rxThread.m_recvMmsgIovecsVec[i];
+            rxThread.m_recvMmsgHeadersVec[i].msg_hdr.msg_iovlen = 1;
+            if (M_USE_UDP_SEGMENTATION_OFFLOAD) {
+                rxThread.m_recvMmsgHeadersVec[i].msg_hdr.msg_control = &rxThread.m_recvMmsgControlBuffersVec[i * UDP_GRO_CMSG_SPACE_UINT64S];
+                rxThread.m_recvMmsgHeadersVec[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(int));
+            }
+        }
+    }
+#endif
+}
+
 //call Start after all UDP engines have been added
 bool LtpUdpEngineManager::StartIfNotAlreadyRunning() {
     if (!m_ioServiceUdpThreadPtr) {
         //Receiver UDP
-        try {
-            m_udpSocket.open(boost::asio::ip::udp::v4());
-            m_udpSocket.bind(boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), M_MY_BOUND_UDP_PORT)); // //if udpPort is 0 then bind to random ephemeral port
-        }
-        catch (const boost::system::system_error & e) {
-            LOG_ERROR(subprocess) << "Could not bind on UDP port " << M_MY_BOUND_UDP_PORT;
-            LOG_ERROR(subprocess) << e.what();
-
+        if (!OpenAndBindUdpSocket(m_udpSocket, M_MY_BOUND_UDP_PORT)) {
             return false;
         }
-        LOG_INFO(subprocess) << "LtpUdpEngineManager bound successfully on UDP port " << m_udpSocket.local_endpoint().port();
+        const uint16_t boundPort = m_udpSocket.local_endpoint().port(); //if M_MY_BOUND_UDP_PORT is 0, the additional sockets share the ephemeral port
+        for (std::size_t i = 1; i < m_udpReceiveThreadsVec.size(); ++i) {
+            if (!OpenAndBindUdpSocket(*m_udpReceiveThreadsVec[i]->m_udpSocketPtr, boundPort)) {
+                for (std::size_t j = 0; j <= i; ++j) {
+                    boost::system::error_code ec;
+                    m_udpReceiveThreadsVec[j]->m_udpSocketPtr->close(ec);
+                }
+                return false;
+            }
+        }
+        LOG_INFO(subprocess) << "LtpUdpEngineManager bound successfully on UDP port " << boundPort
+            << " with " << M_NUM_UDP_RECEIVE_THREADS << " udp receive thread(s)";
 
-        StartUdpReceive(); //call before creating io_service thread so that it has "work"
+        for (std::size_t i = 0; i < m_udpReceiveThreadsVec.size(); ++i) {
+            StartUdpReceive(*m_udpReceiveThreadsVec[i]); //call before creating io_service thread so that it has "work"
+        }
 
+        for (std::size_t i = 1; i < m_udpReceiveThreadsVec.size(); ++i) {
+            udp_receive_thread_t & rxThread = *m_udpReceiveThreadsVec[i];
+            rxThread.m_threadOwnedPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, rxThread.m_ioServicePtr));
+        }
         m_ioServiceUdpThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioServiceUdp));
         m_readyToForward = true;
     }
     return true;
 }
 
+bool LtpUdpEngineManager::OpenAndBindUdpSocket(boost::asio::ip::udp::socket & udpSocket, const uint16_t udpPort) {
+    try {
+        udpSocket.open(boost::asio::ip::udp::v4());
+#if !defined(_WIN32) && defined(SO_REUSEPORT)
+        if (M_NUM_UDP_RECEIVE_THREADS > 1) { //each receive thread opens the same port, the kernel spreads peers across the sockets
+            const int enableReusePort = 1;
+            if (setsockopt(udpSocket.native_handle(), SOL_SOCKET, SO_REUSEPORT, &enableReusePort, sizeof(enableReusePort)) != 0) {
+                LOG_ERROR(subprocess) << "LtpUdpEngineManager: could not set SO_REUSEPORT on UDP port " << udpPort << " (errno " << errno << ")";
+                return false;
+            }
+        }
+#endif
+        udpSocket.bind(boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), udpPort)); // //if udpPort is 0 then bind to random ephemeral port
+    }
+    catch (const boost::system::system_error & e) {
+        LOG_ERROR(subprocess) << "Could not bind on UDP port " << udpPort;
+        LOG_ERROR(subprocess) << e.what();
+
+        return false;
+    }
+#ifndef _WIN32
+    if (M_USE_UDP_SEGMENTATION_OFFLOAD) {
+        const int enableGro = 1;
+        if (setsockopt(udpSocket.native_handle(), IPPROTO_UDP, UDP_GRO, &enableGro, sizeof(enableGro)) != 0) {
+            LOG_WARNING(subprocess) << "LtpUdpEngineManager: UDP_GRO not supported by this kernel (errno " << errno << ").. receiving without GRO";
+        }
+        else {
+            LOG_INFO(subprocess) << "LtpUdpEngineManager using UDP generic receive offload on UDP port " << udpSocket.local_endpoint().port();
+        }
+    }
+#endif
+    return true;
+}
+
 LtpUdpEngine * LtpUdpEngineManager::GetLtpUdpEnginePtrByRemoteEngineId(const uint64_t remoteEngineId, const bool isInduct) {
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > * const whichMap = (isInduct) ? &m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr : &m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr;
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = whichMap->find(remoteEngineId);
@@ -118,15 +300,25 @@ void LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(const ui
 }
 void LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_NotThreadSafe(const uint64_t remoteEngineId, const bool isInduct, const boost::function<void()> & callback) {
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > * const whichMap = (isInduct) ? &m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr : &m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr;
+    boost::unique_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex, boost::defer_lock);
+    if (M_NUM_UDP_RECEIVE_THREADS > 1) {
+        enginesLock.lock(); //the other receive threads may be reading the engine maps
+    }
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = whichMap->find(remoteEngineId);
     if (it == whichMap->end()) {
         LOG_ERROR(subprocess) << "LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_NotThreadSafe: remoteEngineId " << remoteEngineId
             << " for type " << ((isInduct) ? "induct" : "outduct") << " does not exist";
     }
     else {
+        if (!isInduct) {
+            std::replace(m_vecEngineIndexToLtpUdpEngineTransmitterPtr.begin(), m_vecEngineIndexToLtpUdpEngineTransmitterPtr.end(), it->second.get(), (LtpUdpEngine*)NULL);
+        }
         whichMap->erase(it);
         LOG_INFO(subprocess) << "remoteEngineId " << remoteEngineId << " for type " << ((isInduct) ? "induct" : "outduct") << " successfully removed";
     }
+    if (enginesLock.owns_lock()) {
+        enginesLock.unlock();
+    }
     if (callback) {
         callback();
     }
@@ -197,6 +389,14 @@ bool LtpUdpEngineManager::AddLtpUdpEngine(const uint64_t thisEngineId, const uin
         maxRetriesPerSerialNumber, force32BitRandomNumbers, M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES, maxSendRateBitsPerSecOrZeroToDisable, maxSimultaneousSessions,
         rxDataSegmentSessionNumberRecreationPreventerHistorySizeOrZeroToDisable, maxUdpPacketsToSendPerSystemCall, senderPingSecondsOrZeroToDisable,
         delaySendingOfReportSegmentsTimeMsOrZeroToDisable, delaySendingOfDataSegmentsTimeMsOrZeroToDisable);
+    if (M_USE_UDP_SEGMENTATION_OFFLOAD && (maxUdpPacketsToSendPerSystemCall > 1)) { //GSO needs the dedicated batch sender
+        newLtpUdpEnginePtr->SetUseUdpSegmentationOffload(true); //logs a warning and falls back to plain sendmmsg if unsupported
+    }
+    boost::unique_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex, boost::defer_lock);
+    if (M_NUM_UDP_RECEIVE_THREADS > 1) {
+        newLtpUdpEnginePtr->m_ownerUdpReceiveThreadIndex = UDP_RECEIVE_THREAD_INDEX_UNCLAIMED; //claimed by the first receive thread to get a packet for it
+        enginesLock.lock(); //the receive threads may be reading the engine maps
+    }
     if (!isInduct) {
         ++m_nextEngineIndex;
         m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex] = newLtpUdpEnginePtr.get();
@@ -216,116 +416,336 @@ void LtpUdpEngineManager::Stop() {
         boost::asio::post(m_ioServiceUdp, boost::bind(&LtpUdpEngineManager::DoUdpShutdown, this));
         m_ioServiceUdpThreadPtr->join();
         m_ioServiceUdpThreadPtr.reset(); //delete it
-    }
+        for (std::size_t i = 1; i < m_udpReceiveThreadsVec.size(); ++i) {
+            udp_receive_thread_t & rxThread = *m_udpReceiveThreadsVec[i];
+            if (rxThread.m_threadOwnedPtr) {
+                rxThread.m_threadOwnedPtr->join(); //DoUdpShutdown posted the closing of its socket
+                rxThread.m_threadOwnedPtr.reset(); //delete it
+            }
+        }
 
-    //print stats
-    
+        //print stats
+        LOG_INFO(subprocess) << "LtpUdpEngineManager on UDP port " << M_MY_BOUND_UDP_PORT << ": m_countUdpPacketsReceived " << m_countUdpPacketsReceived.load()
+            << " m_countUdpReceiveSystemCalls " << m_countUdpReceiveSystemCalls.load()
+            << " m_countUdpGroSuperPacketsReceived " << m_countUdpGroSuperPacketsReceived.load()
+            << " m_countUdpPacketsForwardedBetweenReceiveThreads " << m_countUdpPacketsForwardedBetweenReceiveThreads.load()
+            << " (max " << M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL << " udp packets per system call, "
+            << M_NUM_UDP_RECEIVE_THREADS << " udp receive thread(s))";
+    }
 }
 
 
-void LtpUdpEngineManager::StartUdpReceive() {
-    m_udpSocket.async_receive_from(
-        boost::asio::buffer(m_udpReceiveBuffer),
-        m_remoteEndpointReceived,
-        boost::bind(&LtpUdpEngineManager::HandleUdpReceive, this,
+void LtpUdpEngineManager::StartUdpReceive(udp_receive_thread_t & rxThread) {
+#ifndef _WIN32
+    if (M_USE_BATCH_RECEIVE) {
+        //wait for the socket to become readable, then HandleUdpReceiveBatch drains it with recvmmsg
+        rxThread.m_udpSocketPtr->async_wait(boost::asio::ip::udp::socket::wait_read,
+            boost::bind(&LtpUdpEngineManager::HandleUdpReceiveBatch, this, boost::ref(rxThread),
+                boost::asio::placeholders::error));
+        return;
+    }
+#endif
+    rxThread.m_udpSocketPtr->async_receive_from(
+        boost::asio::buffer(rxThread.m_udpReceiveBuffer),
+        rxThread.m_remoteEndpointReceived,
+        boost::bind(&LtpUdpEngineManager::HandleUdpReceive, this, boost::ref(rxThread),
             boost::asio::placeholders::error,
             boost::asio::placeholders::bytes_transferred));
 }
 
+LtpUdpEngine * LtpUdpEngineManager::GetLtpUdpEnginePtrForReceivedPacket(const std::vector<uint8_t> & packet, std::size_t bytesTransferred, bool & isFatalError) {
+    isFatalError = false;
+    if (bytesTransferred <= 2) {
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): bytesTransferred <= 2 .. ignoring packet";
+        return NULL;
+    }
+
+    const uint8_t segmentTypeFlags = packet[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
+    bool isSenderToReceiver;
+    if (!Ltp::GetMessageDirectionFromSegmentFlags(segmentTypeFlags, isSenderToReceiver)) {
+        LOG_FATAL(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): received invalid ltp packet with segment type flag " << (int)segmentTypeFlags;
+        isFatalError = true;
+        return NULL;
+    }
+#if defined(USE_SDNV_FAST) && defined(SDNV_SUPPORT_AVX2_FUNCTIONS)
+    uint64_t decodedValues[2];
+    const unsigned int numSdnvsToDecode = 2u - isSenderToReceiver;
+    uint8_t totalBytesDecoded;
+    unsigned int numValsDecodedThisIteration = SdnvDecodeMultiple256BitU64Fast(&packet[1], &totalBytesDecoded, decodedValues, numSdnvsToDecode);
+    if (numValsDecodedThisIteration != numSdnvsToDecode) { //all required sdnvs were not decoded, possibly due to a decode error
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read 1 or more of sessionOriginatorEngineId or sessionNumber.. ignoring packet";
+        return NULL;
+    }
+    const uint64_t & sessionOriginatorEngineId = decodedValues[0];
+    const uint64_t & sessionNumber = decodedValues[1];
+#else
+    uint8_t sdnvSize;
+    const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&packet[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+    if (sdnvSize == 0) {
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionOriginatorEngineId.. ignoring packet";
+        return NULL;
+    }
+    uint64_t sessionNumber;
+    if (!isSenderToReceiver) {
+        sessionNumber = SdnvDecodeU64(&packet[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+        if (sdnvSize == 0) {
+            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet";
+            return NULL;
+        }
+    }
+#endif
+
+    LtpUdpEngine * ltpUdpEnginePtr;
+    if (isSenderToReceiver) { //received an isSenderToReceiver message type => isInduct (this ltp engine received a message type that only travels from an outduct (sender) to an induct (receiver))
+        //sessionOriginatorEngineId is the remote engine id in the case of an induct
+        std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.find(sessionOriginatorEngineId);
+        if (it == m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.end()) {
+            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: an induct received packet with unknown remote engine Id "
+                << sessionOriginatorEngineId << ".. ignoring packet";
+            return NULL;
+        }
+        ltpUdpEnginePtr = it->second.get();
+    }
+    else { //received an isReceiverToSender message type => isOutduct (this ltp engine received a message type that only travels from an induct (receiver) to an outduct (sender))
+        //sessionOriginatorEngineId is my engine id in the case of an outduct.. need to get the session number to find the proper LtpUdpEngine
+        const uint8_t engineIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionNumber);
+        ltpUdpEnginePtr = m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex];
+        if (ltpUdpEnginePtr == NULL) {
+            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: an outduct received packet of type " << (int)segmentTypeFlags << " with unknown session number "
+                << sessionNumber << ".. ignoring packet";
+            return NULL;
+        }
+    }
+    return ltpUdpEnginePtr;
+}
 
-void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
+void LtpUdpEngineManager::HandleUdpReceive(udp_receive_thread_t & rxThread, const boost::system::error_code & error, std::size_t bytesTransferred) {
     if (!error) {
-        if (bytesTransferred <= 2) {
-            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): bytesTransferred <= 2 .. ignoring packet";
-            StartUdpReceive();
-            return;
+        ++m_countUdpReceiveSystemCalls;
+        ++m_countUdpPacketsReceived;
+        boost::shared_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex, boost::defer_lock);
+        if (M_NUM_UDP_RECEIVE_THREADS > 1) {
+            enginesLock.lock();
         }
-        
-        const uint8_t segmentTypeFlags = m_udpReceiveBuffer[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
-        bool isSenderToReceiver;
-        if (!Ltp::GetMessageDirectionFromSegmentFlags(segmentTypeFlags, isSenderToReceiver)) {
-            LOG_FATAL(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): received invalid ltp packet with segment type flag " << (int)segmentTypeFlags;
-            DoUdpShutdown();
+        bool isFatalError;
+        LtpUdpEngine * const ltpUdpEnginePtr = GetLtpUdpEnginePtrForReceivedPacket(rxThread.m_udpReceiveBuffer, bytesTransferred, isFatalError);
+        if (isFatalError) {
+            if (enginesLock.owns_lock()) {
+                enginesLock.unlock();
+            }
+            HandleUdpReceiveFatalError(rxThread);
             return;
         }
-#if defined(USE_SDNV_FAST) && defined(SDNV_SUPPORT_AVX2_FUNCTIONS)
-        uint64_t decodedValues[2];
-        const unsigned int numSdnvsToDecode = 2u - isSenderToReceiver;
-        uint8_t totalBytesDecoded;
-        unsigned int numValsDecodedThisIteration = SdnvDecodeMultiple256BitU64Fast(&m_udpReceiveBuffer[1], &totalBytesDecoded, decodedValues, numSdnvsToDecode);
-        if (numValsDecodedThisIteration != numSdnvsToDecode) { //all required sdnvs were not decoded, possibly due to a decode error
-            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read 1 or more of sessionOriginatorEngineId or sessionNumber.. ignoring packet";
-            StartUdpReceive();
-            return;
+        if (ltpUdpEnginePtr) {
+            unsigned int ownerIndex;
+            if (ClaimLtpUdpEngineForUdpReceiveThread(ltpUdpEnginePtr, rxThread, ownerIndex)) {
+                ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(rxThread.m_udpReceiveBuffer, bytesTransferred);
+                if (rxThread.m_udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
+                    LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: swapped packet not size "
+                        << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing";
+                    rxThread.m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+                }
+            }
+            else {
+                ForwardPacketToUdpReceiveThread(ownerIndex, rxThread.m_udpReceiveBuffer, bytesTransferred);
+            }
         }
-        const uint64_t & sessionOriginatorEngineId = decodedValues[0];
-        const uint64_t & sessionNumber = decodedValues[1];
-#else
-        uint8_t sdnvSize;
-        const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&m_udpReceiveBuffer[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
-        if (sdnvSize == 0) {
-            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionOriginatorEngineId.. ignoring packet";
-            StartUdpReceive();
+        StartUdpReceive(rxThread); //restart operation only if there was no error
+    }
+    else if (error != boost::asio::error::operation_aborted) {
+        HandleUdpReceiveError(rxThread, error);
+    }
+}
+
+void LtpUdpEngineManager::HandleUdpReceiveBatch(udp_receive_thread_t & rxThread, const boost::system::error_code & error) {
+#ifndef _WIN32
+    if (!error) {
+        //socket is readable, pull as many packets as are available (up to M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL) without blocking
+        const int retval = recvmmsg(rxThread.m_udpSocketPtr->native_handle(), rxThread.m_recvMmsgHeadersVec.data(), M_MAX_UDP_PACKETS_TO_RECEIVE_PER_SYSTEM_CALL, MSG_DONTWAIT, NULL);
+        ++m_countUdpReceiveSystemCalls;
+        if (retval < 0) {
+            const int errnoCopy = errno;
+            if ((errnoCopy == EAGAIN) || (errnoCopy == EWOULDBLOCK) || (errnoCopy == EINTR)) { //spurious wakeup
+                StartUdpReceive(rxThread);
+            }
+            else {
+                HandleUdpReceiveError(rxThread, boost::system::error_code(errnoCopy, boost::system::system_category()));
+            }
             return;
         }
-        uint64_t sessionNumber;
-        if (!isSenderToReceiver) {
-            sessionNumber = SdnvDecodeU64(&m_udpReceiveBuffer[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
-            if (sdnvSize == 0) {
-                LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet";
-                StartUdpReceive();
-                return;
+        boost::shared_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex, boost::defer_lock);
+        if (M_NUM_UDP_RECEIVE_THREADS > 1) {
+            enginesLock.lock();
+        }
+        uint64_t countUdpPacketsReceived = 0;
+        uint64_t countUdpGroSuperPacketsReceived = 0;
+        bool isFatalError = false;
+        const unsigned int numPacketsReceived = static_cast<unsigned int>(retval);
+        for (unsigned int i = 0; (i < numPacketsReceived) && (!isFatalError); ++i) {
+            std::vector<uint8_t> & packet = rxThread.m_udpReceiveBuffersBatchVec[i];
+            const std::size_t bytesTransferred = rxThread.m_recvMmsgHeadersVec[i].msg_len;
+            if (M_USE_UDP_SEGMENTATION_OFFLOAD) {
+                //a UDP_GRO super-packet is a run of gsoSize byte segments (the last one possibly shorter)
+                struct msghdr & msgHeader = rxThread.m_recvMmsgHeadersVec[i].msg_hdr;
+                std::size_t gsoSize = bytesTransferred;
+                for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msgHeader); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgHeader, cmsg)) {
+                    if ((cmsg->cmsg_level == IPPROTO_UDP) && (cmsg->cmsg_type == UDP_GRO)) {
+                        int gsoSizeInt;
+                        memcpy(&gsoSizeInt, CMSG_DATA(cmsg), sizeof(gsoSizeInt));
+                        if (gsoSizeInt > 0) {
+                            gsoSize = static_cast<std::size_t>(gsoSizeInt);
+                        }
+                        break;
+                    }
+                }
+                msgHeader.msg_controllen = CMSG_SPACE(sizeof(int)); //kernel overwrote it with the length used
+                if (gsoSize < bytesTransferred) {
+                    ++countUdpGroSuperPacketsReceived;
+                }
+                //the super-packet buffer is larger than the engines' buffers, so copy each segment out rather than swapping
+                for (std::size_t offset = 0; offset < bytesTransferred; offset += gsoSize) {
+                    const std::size_t segmentSize = std::min(gsoSize, bytesTransferred - offset);
+                    ++countUdpPacketsReceived;
+                    if (segmentSize > rxThread.m_udpReceiveBuffer.size()) {
+                        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceiveBatch: received udp segment of size " << segmentSize
+                            << " exceeds the max LTP udp rx packet size of " << rxThread.m_udpReceiveBuffer.size() << ".. ignoring packet";
+                        continue;
+                    }
+                    memcpy(rxThread.m_udpReceiveBuffer.data(), packet.data() + offset, segmentSize);
+                    if (!QueueReceivedPacketFromBatch(rxThread, rxThread.m_udpReceiveBuffer, segmentSize)) {
+                        isFatalError = true;
+                        break;
+                    }
+                }
             }
+            else {
+                ++countUdpPacketsReceived;
+                if (!QueueReceivedPacketFromBatch(rxThread, packet, bytesTransferred)) {
+                    isFatalError = true;
+                    break;
+                }
+                rxThread.m_recvMmsgIovecsVec[i].iov_base = packet.data(); //the engine may have swapped in a different (same size) vector
+            }
+        }
+        m_countUdpPacketsReceived += countUdpPacketsReceived;
+        m_countUdpGroSuperPacketsReceived += countUdpGroSuperPacketsReceived;
+        //demultiplex in bulk: one post per engine per system call
+        for (std::size_t i = 0; i < rxThread.m_enginesWithQueuedPacketsFromBatchVec.size(); ++i) {
+            rxThread.m_enginesWithQueuedPacketsFromBatchVec[i]->PostQueuedPacketsFromManager_ThreadSafe();
+        }
+        rxThread.m_enginesWithQueuedPacketsFromBatchVec.clear();
+        if (isFatalError) {
+            if (enginesLock.owns_lock()) {
+                enginesLock.unlock();
+            }
+            HandleUdpReceiveFatalError(rxThread);
+            return;
         }
+        StartUdpReceive(rxThread); //restart operation only if there was no error
+    }
+    else if (error != boost::asio::error::operation_aborted) {
+        HandleUdpReceiveError(rxThread, error);
+    }
 #endif
+}
 
-        LtpUdpEngine * ltpUdpEnginePtr;
-        if (isSenderToReceiver) { //received an isSenderToReceiver message type => isInduct (this ltp engine received a message type that only travels from an outduct (sender) to an induct (receiver))
-            //sessionOriginatorEngineId is the remote engine id in the case of an induct
-            std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.find(sessionOriginatorEngineId);
-            if (it == m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.end()) {
-                LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: an induct received packet with unknown remote engine Id "
-                    << sessionOriginatorEngineId << ".. ignoring packet";
-                StartUdpReceive();
-                return;
-            }
-            ltpUdpEnginePtr = it->second.get();
-        }
-        else { //received an isReceiverToSender message type => isOutduct (this ltp engine received a message type that only travels from an induct (receiver) to an outduct (sender))
-            //sessionOriginatorEngineId is my engine id in the case of an outduct.. need to get the session number to find the proper LtpUdpEngine
-            const uint8_t engineIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionNumber);
-            ltpUdpEnginePtr = m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex];
-            if (ltpUdpEnginePtr == NULL) {
-                LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: an outduct received packet of type " << (int)segmentTypeFlags << " with unknown session number "
-                    << sessionNumber << ".. ignoring packet";
-                StartUdpReceive();
-                return;
-            }
+bool LtpUdpEngineManager::QueueReceivedPacketFromBatch(udp_receive_thread_t & rxThread, std::vector<uint8_t> & packet, std::size_t bytesTransferred) {
+    bool isFatalError;
+    LtpUdpEngine * const ltpUdpEnginePtr = GetLtpUdpEnginePtrForReceivedPacket(packet, bytesTransferred, isFatalError);
+    if (isFatalError) {
+        return false;
+    }
+    if (ltpUdpEnginePtr) {
+        unsigned int ownerIndex;
+        if (!ClaimLtpUdpEngineForUdpReceiveThread(ltpUdpEnginePtr, rxThread, ownerIndex)) {
+            ForwardPacketToUdpReceiveThread(ownerIndex, packet, bytesTransferred);
+            return true;
         }
-        
-        ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(m_udpReceiveBuffer, bytesTransferred);
-        if (m_udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
-            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive: swapped packet not size " 
+        if (ltpUdpEnginePtr->QueuePacketFromManager_NotThreadSafe(packet, bytesTransferred)) { //first packet queued for this engine in this batch
+            rxThread.m_enginesWithQueuedPacketsFromBatchVec.push_back(ltpUdpEnginePtr);
+        }
+        if (packet.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
+            LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceiveBatch: swapped packet not size "
                 << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing";
-            m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+            packet.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
         }
-        StartUdpReceive(); //restart operation only if there was no error
     }
-    else if (error != boost::asio::error::operation_aborted) {
-        //this happens with windows loopback (localhost) peer udp sockets being terminated
-        m_readyToForward = false;
-        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): " << error.message() << std::endl
-            << "Will try to Receive after 2 seconds";
-        for (std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.begin();
-            it != m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.end(); ++it)
-        {
-            it->second->PostExternalLinkDownEvent_ThreadSafe();
+    return true;
+}
+
+//An LtpUdpEngine's receive circular buffer is single producer, so the first receive thread to get a packet for an engine
+//becomes its only writer.  The kernel's SO_REUSEPORT hash normally keeps a peer on the same socket, so handoffs are rare.
+bool LtpUdpEngineManager::ClaimLtpUdpEngineForUdpReceiveThread(LtpUdpEngine * ltpUdpEnginePtr, const udp_receive_thread_t & rxThread, unsigned int & ownerIndex) {
+    ownerIndex = ltpUdpEnginePtr->m_ownerUdpReceiveThreadIndex.load(std::memory_order_acquire);
+    if (ownerIndex == rxThread.m_index) {
+        return true;
+    }
+    if (ownerIndex == UDP_RECEIVE_THREAD_INDEX_UNCLAIMED) {
+        if (ltpUdpEnginePtr->m_ownerUdpReceiveThreadIndex.compare_exchange_strong(ownerIndex, rxThread.m_index, std::memory_order_acq_rel)) {
+            ownerIndex = rxThread.m_index;
+            return true;
         }
-        m_socketRestoredTimer.cancel();
-        m_retryAfterSocketErrorTimer.expires_from_now(boost::posix_time::seconds(2));
-        m_retryAfterSocketErrorTimer.async_wait(boost::bind(&LtpUdpEngineManager::OnRetryAfterSocketError_TimerExpired, this, boost::asio::placeholders::error));
-        //DoUdpShutdown();
+        //another thread claimed it first, ownerIndex now holds that thread's index
     }
+    return false;
+}
+
+void LtpUdpEngineManager::ForwardPacketToUdpReceiveThread(const unsigned int ownerIndex, const std::vector<uint8_t> & packet, std::size_t bytesTransferred) {
+    std::shared_ptr<std::vector<uint8_t> > packetPtr = std::make_shared<std::vector<uint8_t> >(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+    memcpy(packetPtr->data(), packet.data(), bytesTransferred);
+    ++m_countUdpPacketsForwardedBetweenReceiveThreads;
+    udp_receive_thread_t & ownerRxThread = *m_udpReceiveThreadsVec[ownerIndex];
+    boost::asio::post(*ownerRxThread.m_ioServicePtr,
+        boost::bind(&LtpUdpEngineManager::HandleForwardedPacket, this, boost::ref(ownerRxThread), packetPtr, bytesTransferred));
+}
+
+void LtpUdpEngineManager::HandleForwardedPacket(udp_receive_thread_t & rxThread, std::shared_ptr<std::vector<uint8_t> > & packetPtr, std::size_t bytesTransferred) {
+    boost::shared_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex);
+    bool isFatalError;
+    LtpUdpEngine * const ltpUdpEnginePtr = GetLtpUdpEnginePtrForReceivedPacket(*packetPtr, bytesTransferred, isFatalError);
+    if (ltpUdpEnginePtr) { //engine may have been removed while the packet was in flight
+        unsigned int ownerIndex;
+        if (ClaimLtpUdpEngineForUdpReceiveThread(ltpUdpEnginePtr, rxThread, ownerIndex)) {
+            ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(*packetPtr, bytesTransferred);
+        }
+        else {
+            ForwardPacketToUdpReceiveThread(ownerIndex, *packetPtr, bytesTransferred);
+        }
+    }
+}
+
+void LtpUdpEngineManager::HandleUdpReceiveFatalError(udp_receive_thread_t & rxThread) {
+    if (rxThread.m_index == 0) {
+        DoUdpShutdown();
+    }
+    else {
+        boost::asio::post(m_ioServiceUdp, boost::bind(&LtpUdpEngineManager::DoUdpShutdown, this));
+    }
+}
+
+void LtpUdpEngineManager::HandleUdpReceiveError(udp_receive_thread_t & rxThread, const boost::system::error_code & error) {
+    if (rxThread.m_index != 0) {
+        //link down events and the socket restored timer are owned by the primary receive thread
+        LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive() on udp receive thread " << rxThread.m_index << ": " << error.message() << std::endl
+            << "Will try to Receive after 2 seconds";
+        rxThread.m_retryAfterSocketErrorTimerOwnedPtr->expires_from_now(boost::posix_time::seconds(2));
+        rxThread.m_retryAfterSocketErrorTimerOwnedPtr->async_wait(boost::bind(&LtpUdpEngineManager::OnRetryAfterSocketErrorAdditionalThread_TimerExpired,
+            this, boost::ref(rxThread), boost::asio::placeholders::error));
+        return;
+    }
+    //this happens with windows loopback (localhost) peer udp sockets being terminated
+    m_readyToForward = false;
+    LOG_ERROR(subprocess) << "LtpUdpEngineManager::HandleUdpReceive(): " << error.message() << std::endl
+        << "Will try to Receive after 2 seconds";
+    for (std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.begin();
+        it != m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.end(); ++it)
+    {
+        it->second->PostExternalLinkDownEvent_ThreadSafe();
+    }
+    m_socketRestoredTimer.cancel();
+    m_retryAfterSocketErrorTimer.expires_from_now(boost::posix_time::seconds(2));
+    m_retryAfterSocketErrorTimer.async_wait(boost::bind(&LtpUdpEngineManager::OnRetryAfterSocketError_TimerExpired, this, boost::asio::placeholders::error));
+    //DoUdpShutdown();
 }
 
 void LtpUdpEngineManager::OnRetryAfterSocketError_TimerExpired(const boost::system::error_code& e) {
@@ -334,7 +754,14 @@ void LtpUdpEngineManager::OnRetryAfterSocketError_TimerExpired(const boost::syst
         LOG_INFO(subprocess) << "Trying to receive...";
         m_socketRestoredTimer.expires_from_now(boost::posix_time::seconds(5));
         m_socketRestoredTimer.async_wait(boost::bind(&LtpUdpEngineManager::SocketRestored_TimerExpired, this, boost::asio::placeholders::error));
-        StartUdpReceive();
+        StartUdpReceive(*m_udpReceiveThreadsVec[0]);
+    }
+}
+
+void LtpUdpEngineManager::OnRetryAfterSocketErrorAdditionalThread_TimerExpired(udp_receive_thread_t & rxThread, const boost::system::error_code& e) {
+    if (e != boost::asio::error::operation_aborted) {
+        LOG_INFO(subprocess) << "Trying to receive on udp receive thread " << rxThread.m_index << "...";
+        StartUdpReceive(rxThread);
     }
 }
 
@@ -363,8 +790,28 @@ void LtpUdpEngineManager::DoUdpShutdown() {
             LOG_WARNING(subprocess) << "LtpUdpEngineManager::DoUdpShutdown calling udpSocket.close: " << e.what();
         }
     }
+    for (std::size_t i = 1; i < m_udpReceiveThreadsVec.size(); ++i) {
+        udp_receive_thread_t & rxThread = *m_udpReceiveThreadsVec[i];
+        boost::asio::post(*rxThread.m_ioServicePtr, boost::bind(&LtpUdpEngineManager::DoUdpShutdownAdditionalThread, this, boost::ref(rxThread)));
+    }
+    boost::unique_lock<boost::shared_mutex> enginesLock(m_enginesSharedMutex, boost::defer_lock);
+    if (M_NUM_UDP_RECEIVE_THREADS > 1) {
+        enginesLock.lock(); //wait for the other receive threads to finish with the engines
+    }
     m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.clear();
     m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr.clear();
+    std::fill(m_vecEngineIndexToLtpUdpEngineTransmitterPtr.begin(), m_vecEngineIndexToLtpUdpEngineTransmitterPtr.end(), (LtpUdpEngine*)NULL);
+}
+
+void LtpUdpEngineManager::DoUdpShutdownAdditionalThread(udp_receive_thread_t & rxThread) {
+    rxThread.m_retryAfterSocketErrorTimerOwnedPtr->cancel();
+    if (rxThread.m_udpSocketPtr->is_open()) {
+        boost::system::error_code ec;
+        rxThread.m_udpSocketPtr->close(ec);
+        if (ec) {
+            LOG_WARNING(subprocess) << "LtpUdpEngineManager::DoUdpShutdownAdditionalThread calling udpSocket.close: " << ec.message();
+        }
+    }
 }
 
 bool LtpUdpEngineManager::ReadyToForward() {
@@ -225,6 +225,7 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
         uint64_t m_numReportAcknowledgementSegmentCallbackCount;
         uint64_t m_numCancelAcknowledgementSegmentCallbackCount;
         uint64_t m_numCancelSegmentCallbackCount;
+        uint64_t m_numRedDataSegmentViewCallbackCount;
         TestLtp()
         {
 
@@ -1303,6 +1304,84 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
             }
         }
 
+        //header, data segment, and trailer all in one HandleReceivedChars call (i.e. one udp packet)
+        void ReceiveWholeDataSegmentPacket(const bool expectView) {
+            m_numDataSegmentCallbackCount = 0;
+            m_numRedDataSegmentViewCallbackCount = 0;
+            std::vector<uint8_t> packet;
+            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(packet, m_desired_dataSegmentTypeFlags,
+                m_desired_sessionId, m_desired_dataSegmentMetadata,
+                (m_desired_headerExtensions.extensionsVec.empty()) ? NULL : &m_desired_headerExtensions,
+                static_cast<uint8_t>(m_desired_trailerExtensions.extensionsVec.size()));
+            packet.insert(packet.end(), m_desired_clientServiceDataVec.begin(), m_desired_clientServiceDataVec.end());
+            if (!m_desired_trailerExtensions.extensionsVec.empty()) {
+                std::vector<uint8_t> trailerSerialization(m_desired_trailerExtensions.GetMaximumDataRequiredForSerialization());
+                const uint64_t bytesSerialized = m_desired_trailerExtensions.Serialize(trailerSerialization.data());
+                packet.insert(packet.end(), trailerSerialization.begin(), trailerSerialization.begin() + bytesSerialized);
+            }
+            std::vector<uint8_t> twoPackets(packet);
+            twoPackets.insert(twoPackets.end(), packet.begin(), packet.end()); //make sure the parser resumes right after a view
+            std::string errorMessage;
+            BOOST_REQUIRE(m_ltp.HandleReceivedChars(twoPackets.data(), twoPackets.size(), errorMessage));
+            BOOST_REQUIRE_EQUAL(errorMessage.size(), 0);
+            BOOST_REQUIRE(m_ltp.IsAtBeginningState());
+            BOOST_REQUIRE_EQUAL(m_numRedDataSegmentViewCallbackCount, (expectView) ? 2 : 0);
+            BOOST_REQUIRE_EQUAL(m_numDataSegmentCallbackCount, (expectView) ? 0 : 2);
+        }
+
+        void DoRedDataSegmentView() {
+            m_ltp.SetDataSegmentContentsReadCallback(boost::bind(&TestLtp::DataSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+            m_ltp.SetRedDataSegmentContentsViewReadCallback(boost::bind(&TestLtp::RedDataSegmentViewCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+
+            m_desired_sessionId = Ltp::session_id_t(5555, 6666);
+            m_desired_clientServiceDataVec.assign(1000, 'r');
+            m_desired_dataSegmentMetadata.clientServiceId = 7777;
+            m_desired_dataSegmentMetadata.offset = 8888;
+            m_desired_dataSegmentMetadata.length = m_desired_clientServiceDataVec.size();
+            m_desired_headerExtensions.extensionsVec.clear();
+            m_desired_trailerExtensions.extensionsVec.clear();
+
+            //RED, NO CHECKPOINT => VIEW
+            {
+                m_desired_dataSegmentTypeFlags = LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA;
+                m_desired_dataSegmentMetadata.checkpointSerialNumber = NULL;
+                m_desired_dataSegmentMetadata.reportSerialNumber = NULL;
+                ReceiveWholeDataSegmentPacket(true);
+            }
+
+            //RED CHECKPOINT EORP => VIEW
+            uint64_t cp = 1000;
+            uint64_t rp = 2000;
+            {
+                m_desired_dataSegmentTypeFlags = LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART;
+                m_desired_dataSegmentMetadata.checkpointSerialNumber = &cp;
+                m_desired_dataSegmentMetadata.reportSerialNumber = &rp;
+                ReceiveWholeDataSegmentPacket(true);
+            }
+
+            //RED CHECKPOINT WITH 1 TRAILER EXTENSION => VECTOR
+            {
+                Ltp::ltp_extension_t e;
+                e.tag = 0x55;
+                e.valueVec.assign(10, 'd');
+                m_desired_trailerExtensions.extensionsVec.push_back(std::move(e));
+                ReceiveWholeDataSegmentPacket(false);
+                m_desired_trailerExtensions.extensionsVec.clear();
+            }
+
+            //GREEN => VECTOR
+            {
+                m_desired_dataSegmentTypeFlags = LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA;
+                m_desired_dataSegmentMetadata.checkpointSerialNumber = NULL;
+                m_desired_dataSegmentMetadata.reportSerialNumber = NULL;
+                ReceiveWholeDataSegmentPacket(false);
+            }
+        }
+
 
 
 
@@ -1326,6 +1405,19 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
             BOOST_REQUIRE(clientServiceDataVec == m_desired_clientServiceDataVec);
         }
 
+        void RedDataSegmentViewCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            ++m_numRedDataSegmentViewCallbackCount;
+            BOOST_REQUIRE_EQUAL(segmentTypeFlags, static_cast<uint8_t>(m_desired_dataSegmentTypeFlags));
+            BOOST_REQUIRE_EQUAL(sessionId, m_desired_sessionId);
+            BOOST_REQUIRE(dataSegmentMetadata == m_desired_dataSegmentMetadata);
+            BOOST_REQUIRE(headerExtensions == m_desired_headerExtensions);
+            BOOST_REQUIRE(trailerExtensions == m_desired_trailerExtensions);
+            BOOST_REQUIRE(memcmp(clientServiceData, m_desired_clientServiceDataVec.data(), dataSegmentMetadata.length) == 0);
+        }
+
 
     };
 
@@ -1333,6 +1425,7 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
 
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
     t.DoDataSegment();
+    t.DoRedDataSegmentView();
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
 
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
@@ -15,6 +15,8 @@
 #include <boost/test/unit_test.hpp>
 #include "LtpEngine.h"
 #include <boost/bind/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/timer/timer.hpp>
 
 BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
 {
@@ -32,6 +34,7 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
         const std::string DESIRED_FULLY_GREEN_DATA_TO_SEND;
 
         uint64_t numRedPartReceptionCallbacks;
+        uint64_t numRedPartFileReceptionCallbacks;
         uint64_t numSessionStartSenderCallbacks;
         uint64_t numSessionStartReceiverCallbacks;
         uint64_t numGreenPartReceptionCallbacks;
@@ -44,6 +47,7 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
         CANCEL_SEGMENT_REASON_CODES lastRxCancelSegmentReasonCode;
         CANCEL_SEGMENT_REASON_CODES lastTxCancelSegmentReasonCode;
         Ltp::session_id_t sessionIdFromSessionStartSender;
+        std::unique_ptr<MemoryMappedFileBuffer> redPartFileBufferPtr;
 
         Test() :
             ONE_WAY_LIGHT_TIME(boost::posix_time::seconds(10)),
@@ -90,6 +94,15 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             //std::cout << "receivedMessage: " << receivedMessage << std::endl;
             //std::cout << "here\n";
         }
+        void RedPartFileReceptionCallback(const Ltp::session_id_t & sessionId, std::unique_ptr<MemoryMappedFileBuffer> & movableRedPartFileBufferPtr, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock) {
+            ++numRedPartFileReceptionCallbacks;
+            BOOST_REQUIRE(movableRedPartFileBufferPtr);
+            BOOST_REQUIRE_EQUAL(movableRedPartFileBufferPtr->size(), lengthOfRedPart);
+            std::string receivedMessage(movableRedPartFileBufferPtr->data(), movableRedPartFileBufferPtr->data() + movableRedPartFileBufferPtr->size());
+            BOOST_REQUIRE_EQUAL(receivedMessage, DESIRED_RED_DATA_TO_SEND);
+            BOOST_REQUIRE(sessionId == sessionIdFromSessionStartSender);
+            redPartFileBufferPtr = std::move(movableRedPartFileBufferPtr); //take the file
+        }
         void GreenPartSegmentArrivalCallback(const Ltp::session_id_t & sessionId, std::vector<uint8_t> & movableClientServiceDataVec, uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock) {
             ++numGreenPartReceptionCallbacks;
             BOOST_REQUIRE_EQUAL(movableClientServiceDataVec.size(), 1);
@@ -146,6 +159,7 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             numSrcToDestDataExchanged = 0;
             numDestToSrcDataExchanged = 0;
             numRedPartReceptionCallbacks = 0;
+            numRedPartFileReceptionCallbacks = 0;
             numSessionStartSenderCallbacks = 0;
             numSessionStartReceiverCallbacks = 0;
             numGreenPartReceptionCallbacks = 0;
@@ -435,6 +449,75 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
             BOOST_REQUIRE_EQUAL(numTransmissionSessionCancelledCallbacks, 1);
             BOOST_REQUIRE(lastTxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
         }
+
+        //red part spilled to disk after 10 bytes (of 44), with two out of order segments filled in after the spill
+        void DoTestRedPartSpillToDisk(bool useFileCallback) {
+            const boost::filesystem::path spillDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("LtpEngineSpillTest_%%%%%%%%");
+            BOOST_REQUIRE(boost::filesystem::create_directory(spillDirectory));
+            Reset();
+            engineDest.SetRedPartSpillToDisk(spillDirectory, 10);
+            if (useFileCallback) {
+                engineDest.SetRedPartFileReceptionCallback(boost::bind(&Test::RedPartFileReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                    boost::placeholders::_4, boost::placeholders::_5));
+            }
+            AssertNoActiveSendersAndReceivers();
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            AssertOneActiveSenderOnly();
+            unsigned int count = 0;
+            while (ExchangeData((count == 10) || (count == 13), false)) {
+                ++count;
+            }
+            AssertNoActiveSendersAndReceivers();
+            BOOST_REQUIRE_EQUAL(numSrcToDestDataExchanged, DESIRED_RED_DATA_TO_SEND.size() + 4); //+4 for 2 Report acks and 2 resends
+            BOOST_REQUIRE_EQUAL(numDestToSrcDataExchanged, 2); //2 for 2 Report segments
+            BOOST_REQUIRE_EQUAL(numRedPartReceptionCallbacks, (useFileCallback) ? 0 : 1);
+            BOOST_REQUIRE_EQUAL(numRedPartFileReceptionCallbacks, (useFileCallback) ? 1 : 0);
+            BOOST_REQUIRE_EQUAL(numReceptionSessionCancelledCallbacks, 0);
+            BOOST_REQUIRE_EQUAL(numTransmissionSessionCompletedCallbacks, 1);
+            if (useFileCallback) {
+                //the client service owns the file until it releases the buffer
+                BOOST_REQUIRE(redPartFileBufferPtr);
+                const boost::filesystem::path filePath = redPartFileBufferPtr->GetFilePath();
+                BOOST_REQUIRE(filePath.parent_path() == spillDirectory);
+                BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), DESIRED_RED_DATA_TO_SEND.size());
+                redPartFileBufferPtr.reset();
+                BOOST_REQUIRE(!boost::filesystem::exists(filePath));
+            }
+            BOOST_REQUIRE(boost::filesystem::is_empty(spillDirectory)); //spill file deleted after the copy into RAM
+
+            engineDest.SetRedPartSpillToDisk(boost::filesystem::path(), 0);
+            engineDest.SetRedPartFileReceptionCallback(RedPartFileReceptionCallback_t());
+            boost::filesystem::remove_all(spillDirectory);
+        }
+
+        //spill directory removed before the end of the red part, so the spilled red part cannot be resized for delivery
+        void DoTestRedPartSpillToDiskDeliveryFailure() {
+            const boost::filesystem::path spillDirectory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("LtpEngineSpillTest_%%%%%%%%");
+            BOOST_REQUIRE(boost::filesystem::create_directory(spillDirectory));
+            Reset();
+            engineDest.SetRedPartSpillToDisk(spillDirectory, 10);
+            engineDest.SetRedPartFileReceptionCallback(boost::bind(&Test::RedPartFileReceptionCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5));
+            AssertNoActiveSendersAndReceivers();
+            engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, (uint8_t*)DESIRED_RED_DATA_TO_SEND.data(), DESIRED_RED_DATA_TO_SEND.size(), DESIRED_RED_DATA_TO_SEND.size());
+            AssertOneActiveSenderOnly();
+            unsigned int count = 0;
+            while (ExchangeData()) {
+                if (++count == 20) {
+                    BOOST_REQUIRE_EQUAL(engineDest.NumActiveReceivers(), 1);
+                    boost::filesystem::remove_all(spillDirectory); //the mapping stays valid but the file can no longer be resized
+                }
+            }
+            AssertNoActiveSendersAndReceivers();
+            BOOST_REQUIRE_EQUAL(numRedPartReceptionCallbacks, 0);
+            BOOST_REQUIRE_EQUAL(numRedPartFileReceptionCallbacks, 0);
+            BOOST_REQUIRE(!redPartFileBufferPtr);
+            BOOST_REQUIRE_EQUAL(numReceptionSessionCancelledCallbacks, 1);
+            BOOST_REQUIRE(lastRxCancelSegmentReasonCode == CANCEL_SEGMENT_REASON_CODES::SYSTEM_CANCELLED);
+
+            engineDest.SetRedPartSpillToDisk(boost::filesystem::path(), 0);
+            engineDest.SetRedPartFileReceptionCallback(RedPartFileReceptionCallback_t());
+        }
     };
 
     Test t;
@@ -449,4 +532,83 @@ BOOST_AUTO_TEST_CASE(LtpEngineTestCase, *boost::unit_test::enabled())
     t.DoTestMiscoloredRed();
     t.DoTestMiscoloredGreen();
     t.DoTestTooMuchRedData();
+    t.DoTestRedPartSpillToDisk(false);
+    t.DoTestRedPartSpillToDisk(true);
+    t.DoTestRedPartSpillToDiskDeliveryFailure();
+}
+
+//receiver side only: a red part whose data segments were generated up front is fed to an LtpEngine,
+//each segment either contiguous (one packet per PacketIn, the udp case, parsed as a view into the packet)
+//or split after its header (parsed through the client service data vector, i.e. copied twice)
+BOOST_AUTO_TEST_CASE(LtpEngineRedPartReceiveSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t RED_PART_BYTES = 256 * 1024 * 1024;
+    static const uint64_t MTU_CLIENT_SERVICE_DATA = 1360;
+    static const unsigned int NUM_RUNS = 5;
+    static const uint64_t ENGINE_ID_SRC = 100;
+    static const uint64_t ENGINE_ID_DEST = 200;
+    static const uint64_t CLIENT_SERVICE_ID_DEST = 300;
+    const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME(boost::posix_time::seconds(10));
+    const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(2000));
+
+    std::vector<uint8_t> redData(RED_PART_BYTES);
+    for (std::size_t i = 0; i < redData.size(); ++i) {
+        redData[i] = static_cast<uint8_t>(i * 7);
+    }
+    for (unsigned int estimatedIsExact = 0; estimatedIsExact < 2; ++estimatedIsExact) {
+        const uint64_t estimatedBytesToReceive = (estimatedIsExact) ? RED_PART_BYTES : 200000;
+        LtpEngine engineSrc(ENGINE_ID_SRC, 1, MTU_CLIENT_SERVICE_DATA, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, 0, RED_PART_BYTES, false, 0, 5, false, 0, 100, 0, 1, 0, 0, 0);
+        LtpEngine engineDest(ENGINE_ID_DEST, 1, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, estimatedBytesToReceive, RED_PART_BYTES, false, 0, 5, false, 0, 100, 1000, 1, 0, 0, 0);
+        uint64_t numRedPartBytesReceived = 0;
+        engineDest.SetRedPartReceptionCallback([&numRedPartBytesReceived](const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec,
+            uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock)
+        {
+            numRedPartBytesReceived += movableClientServiceDataVec.size();
+        });
+        double secondsPerMode[2] = { 0, 0 };
+        for (unsigned int run = 0; run < NUM_RUNS; ++run) {
+            for (unsigned int splitAfterHeader = 0; splitAfterHeader < 2; ++splitAfterHeader) {
+                engineSrc.TransmissionRequest(CLIENT_SERVICE_ID_DEST, ENGINE_ID_DEST, redData.data(), redData.size(), redData.size());
+                std::vector<uint8_t> packets;
+                packets.reserve(RED_PART_BYTES + (RED_PART_BYTES / 16));
+                std::vector<std::pair<std::size_t, std::size_t> > packetEndAndHeaderSizes;
+                std::vector<boost::asio::const_buffer> constBufferVec;
+                std::shared_ptr<std::vector<std::vector<uint8_t> > > underlyingDataToDeleteOnSentCallback;
+                std::shared_ptr<LtpClientServiceDataToSend> underlyingCsDataToDeleteOnSentCallback;
+                uint64_t sessionOriginatorEngineId;
+                while (engineSrc.GetNextPacketToSend(constBufferVec, underlyingDataToDeleteOnSentCallback, underlyingCsDataToDeleteOnSentCallback, sessionOriginatorEngineId)) {
+                    for (std::size_t i = 0; i < constBufferVec.size(); ++i) {
+                        const uint8_t * const data = static_cast<const uint8_t*>(constBufferVec[i].data());
+                        packets.insert(packets.end(), data, data + constBufferVec[i].size());
+                    }
+                    packetEndAndHeaderSizes.emplace_back(packets.size(), constBufferVec[0].size());
+                }
+                numRedPartBytesReceived = 0;
+                boost::timer::cpu_timer timer;
+                std::size_t packetBegin = 0;
+                for (std::size_t i = 0; i < packetEndAndHeaderSizes.size(); ++i) {
+                    const std::size_t packetEnd = packetEndAndHeaderSizes[i].first;
+                    if (splitAfterHeader) {
+                        const std::size_t headerEnd = packetBegin + packetEndAndHeaderSizes[i].second;
+                        engineDest.PacketIn(&packets[packetBegin], headerEnd - packetBegin);
+                        engineDest.PacketIn(&packets[headerEnd], packetEnd - headerEnd);
+                    }
+                    else {
+                        engineDest.PacketIn(&packets[packetBegin], packetEnd - packetBegin);
+                    }
+                    packetBegin = packetEnd;
+                }
+                secondsPerMode[splitAfterHeader] += timer.elapsed().wall * 1e-9;
+                BOOST_REQUIRE_EQUAL(numRedPartBytesReceived, RED_PART_BYTES);
+                engineSrc.Reset();
+                engineDest.Reset();
+            }
+        }
+        for (unsigned int splitAfterHeader = 0; splitAfterHeader < 2; ++splitAfterHeader) {
+            std::cout << ((splitAfterHeader) ? "client service data copied into a vector: " : "client service data as a view: ")
+                << "estimated bytes to receive " << estimatedBytesToReceive << ": "
+                << ((RED_PART_BYTES * NUM_RUNS * 8) / secondsPerMode[splitAfterHeader]) * 1e-6 << " Mbit/s ("
+                << NUM_RUNS << " runs of " << RED_PART_BYTES << " bytes)" << std::endl;
+        }
+    }
 }
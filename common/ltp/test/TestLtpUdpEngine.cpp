@@ -2,7 +2,7 @@
  * @file TestLtpUdpEngine.cpp
  * @author  Brian Tomko <brian.j.tomko@nasa.gov>
  *
- * @copyright Copyright  2021 United States Government as represented by
+ * @copyright Copyright � 2021 United States Government as represented by
  * the National Aeronautics and Space Administration.
  * No copyright is claimed in the United States under Title 17, U.S.Code.
  * All Other Rights Reserved.
@@ -1540,4 +1540,52 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
         t.DoTestFullyGreenData();
     }
     std::cout << "+++END 500 PACKETS PER SYSTEM CALL+++\n";
+#ifndef _WIN32
+    std::cout << "+++START 500 PACKETS PER RECEIVE SYSTEM CALL+++\n";
+    {
+        LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE Test Constructor
+        LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(500); //MUST BE CALLED BEFORE Test Constructor
+        Test t(500); //500 => maxUdpPacketsToSendPerSystemCall
+        t.DoTest();
+        t.DoTestRedAndGreenData();
+        t.DoTestFullyGreenData();
+        t.DoTestOneDropDataSegmentSrcToDest();
+        BOOST_REQUIRE_GT(t.ltpUdpEngineManagerDestPtr->m_countUdpReceiveSystemCalls.load(), 0);
+        BOOST_REQUIRE_GT(t.ltpUdpEngineManagerDestPtr->m_countUdpPacketsReceived.load(), 0);
+        std::cout << "dest udp packets per receive system call: "
+            << (static_cast<double>(t.ltpUdpEngineManagerDestPtr->m_countUdpPacketsReceived.load()) / t.ltpUdpEngineManagerDestPtr->m_countUdpReceiveSystemCalls.load()) << "\n";
+        LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(1); //restore default for other tests
+    }
+    std::cout << "+++END 500 PACKETS PER RECEIVE SYSTEM CALL+++\n";
+    std::cout << "+++START UDP SEGMENTATION OFFLOAD (GSO/GRO)+++\n";
+    {
+        LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE Test Constructor
+        LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(true); //MUST BE CALLED BEFORE Test Constructor
+        Test t(500); //500 => maxUdpPacketsToSendPerSystemCall (GSO requires the batch sender)
+        t.DoTest();
+        t.DoTestRedAndGreenData();
+        t.DoTestFullyGreenData();
+        t.DoTestOneDropDataSegmentSrcToDest();
+        BOOST_REQUIRE_GT(t.ltpUdpEngineManagerDestPtr->m_countUdpPacketsReceived.load(), 0);
+        std::cout << "dest udp GRO super-packets received: " << t.ltpUdpEngineManagerDestPtr->m_countUdpGroSuperPacketsReceived.load() << "\n";
+        LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(false); //restore default for other tests
+    }
+    std::cout << "+++END UDP SEGMENTATION OFFLOAD (GSO/GRO)+++\n";
+    std::cout << "+++START 4 RECEIVE THREADS PER PORT+++\n";
+    {
+        LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE Test Constructor
+        LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(500); //MUST BE CALLED BEFORE Test Constructor
+        LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(4); //MUST BE CALLED BEFORE Test Constructor
+        Test t(500); //500 => maxUdpPacketsToSendPerSystemCall
+        t.DoTest();
+        t.DoTestRedAndGreenData();
+        t.DoTestFullyGreenData();
+        t.DoTestOneDropDataSegmentSrcToDest();
+        BOOST_REQUIRE_GT(t.ltpUdpEngineManagerDestPtr->m_countUdpPacketsReceived.load(), 0);
+        std::cout << "dest udp packets forwarded between receive threads: " << t.ltpUdpEngineManagerDestPtr->m_countUdpPacketsForwardedBetweenReceiveThreads.load() << "\n";
+        LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(1); //restore default for other tests
+        LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(1); //restore default for other tests
+    }
+    std::cout << "+++END 4 RECEIVE THREADS PER PORT+++\n";
+#endif
 }
@@ -57,6 +57,12 @@ struct StorageTelemetry_t{
     uint64_t type;
     uint64_t totalBundlesErasedFromStorage;
     uint64_t totalBundlesSentToEgressFromStorage;
+    uint64_t totalBundlesExpiredFromStorage; //deleted by the expired bundle reaper
+    uint64_t totalBytesReclaimedFromExpiredBundles;
+    uint64_t hotTierHits; //bundles released from the storage RAM hot tier
+    uint64_t hotTierMisses; //bundles released from disk while the hot tier is enabled
+    uint64_t hotTierEvictions; //bundles written back from the hot tier to disk
+    uint64_t hotTierWriteBacksCancelled; //bundles deleted while in the hot tier (never written to disk)
 
     TELEMETRY_DEFINITIONS_EXPORT uint64_t SerializeToLittleEndian(uint8_t* data, uint64_t bufferSize) const;
 };
@@ -121,6 +127,10 @@ struct LtpOutductTelemetry_t : public OutductTelemetry_t {
 
     uint64_t countTxUdpPacketsLimitedByRate;
 
+    //ltp udp engine manager (shared by all ltp engines bound to the same udp port)
+    uint64_t countRxUdpSystemCalls;
+    uint64_t countRxUdpPacketsFromSystemCalls; //divide by countRxUdpSystemCalls for udp packets received per system call
+
     TELEMETRY_DEFINITIONS_EXPORT uint64_t SerializeToLittleEndian(uint8_t* data, uint64_t bufferSize) const;
 };
 
@@ -43,7 +43,8 @@ StcpOutductTelemetry_t::StcpOutductTelemetry_t() : OutductTelemetry_t(), totalSt
     convergenceLayerType = 1;
 }
 LtpOutductTelemetry_t::LtpOutductTelemetry_t() : OutductTelemetry_t(),
-    numCheckpointsExpired(0), numDiscretionaryCheckpointsNotResent(0), countUdpPacketsSent(0), countRxUdpCircularBufferOverruns(0), countTxUdpPacketsLimitedByRate(0)
+    numCheckpointsExpired(0), numDiscretionaryCheckpointsNotResent(0), countUdpPacketsSent(0), countRxUdpCircularBufferOverruns(0), countTxUdpPacketsLimitedByRate(0),
+    countRxUdpSystemCalls(0), countRxUdpPacketsFromSystemCalls(0)
 {
     convergenceLayerType = 2;
 }
@@ -425,9 +426,27 @@ bool PrintSerializedTelemetry(const uint8_t* serialized, uint64_t size) {
             serialized += sizeof(uint64_t);
             const uint64_t totalBundlesSentToEgressFromStorage = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
             serialized += sizeof(uint64_t);
+            const uint64_t totalBundlesExpiredFromStorage = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
+            const uint64_t totalBytesReclaimedFromExpiredBundles = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
+            const uint64_t hotTierHits = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
+            const uint64_t hotTierMisses = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
+            const uint64_t hotTierEvictions = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
+            const uint64_t hotTierWriteBacksCancelled = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+            serialized += sizeof(uint64_t);
 
             LOG_INFO(subprocess) << " totalBundlesErasedFromStorage: " << totalBundlesErasedFromStorage;
             LOG_INFO(subprocess) << " totalBundlesSentToEgressFromStorage: " << totalBundlesSentToEgressFromStorage;
+            LOG_INFO(subprocess) << " totalBundlesExpiredFromStorage: " << totalBundlesExpiredFromStorage;
+            LOG_INFO(subprocess) << " totalBytesReclaimedFromExpiredBundles: " << totalBytesReclaimedFromExpiredBundles;
+            LOG_INFO(subprocess) << " hotTierHits: " << hotTierHits;
+            LOG_INFO(subprocess) << " hotTierMisses: " << hotTierMisses;
+            LOG_INFO(subprocess) << " hotTierEvictions: " << hotTierEvictions;
+            LOG_INFO(subprocess) << " hotTierWriteBacksCancelled: " << hotTierWriteBacksCancelled;
         }
         else if (type == 10) { //StorageExpiringBeforeThresholdTelemetry_t
             LOG_INFO(subprocess) << "StorageExpiringBeforeThreshold Telem:";
@@ -518,12 +537,21 @@ bool PrintSerializedTelemetry(const uint8_t* serialized, uint64_t size) {
                 serialized += sizeof(uint64_t);
                 const uint64_t countTxUdpPacketsLimitedByRate = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
                 serialized += sizeof(uint64_t);
+                const uint64_t countRxUdpSystemCalls = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+                serialized += sizeof(uint64_t);
+                const uint64_t countRxUdpPacketsFromSystemCalls = boost::endian::little_to_native(*(reinterpret_cast<const uint64_t*>(serialized)));
+                serialized += sizeof(uint64_t);
                 LOG_INFO(subprocess) << "  Specific to LTP:";
                 LOG_INFO(subprocess) << "  numCheckpointsExpired: " << numCheckpointsExpired;
                 LOG_INFO(subprocess) << "  numDiscretionaryCheckpointsNotResent: " << numDiscretionaryCheckpointsNotResent;
                 LOG_INFO(subprocess) << "  countUdpPacketsSent: " << countUdpPacketsSent;
                 LOG_INFO(subprocess) << "  countRxUdpCircularBufferOverruns: " << countRxUdpCircularBufferOverruns;
                 LOG_INFO(subprocess) << "  countTxUdpPacketsLimitedByRate: " << countTxUdpPacketsLimitedByRate;
+                LOG_INFO(subprocess) << "  countRxUdpSystemCalls: " << countRxUdpSystemCalls;
+                LOG_INFO(subprocess) << "  countRxUdpPacketsFromSystemCalls: " << countRxUdpPacketsFromSystemCalls;
+                if (countRxUdpSystemCalls) {
+                    LOG_INFO(subprocess) << "  rxUdpPacketsPerSystemCall: " << (static_cast<double>(countRxUdpPacketsFromSystemCalls) / countRxUdpSystemCalls);
+                }
             }
             //else if (convergenceLayerType == 3) { //a single tcpclv4 outduct
             //else if (convergenceLayerType == 4) { //a single ltp outduct
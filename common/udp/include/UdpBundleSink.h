@@ -18,6 +18,8 @@
  * and calls the user defined function WholeBundleReadyCallback_t when a new bundle
  * is received.
  * This class assumes an entire bundle is small enough to fit entirely in one UDP datagram.
+ * On Linux, UDP_GRO can optionally be enabled, in which case the kernel may hand up several
+ * equal-size datagrams coalesced into one super-packet, which is split back into bundles here.
  */
 
 #ifndef _UDP_BUNDLE_SINK_H
@@ -44,13 +46,15 @@ public:
         const WholeBundleReadyCallbackUdp_t & wholeBundleReadyCallback,
         const unsigned int numCircularBufferVectors,
         const unsigned int maxUdpPacketSizeBytes,
-        const NotifyReadyToDeleteCallback_t & notifyReadyToDeleteCallback = NotifyReadyToDeleteCallback_t());
+        const NotifyReadyToDeleteCallback_t & notifyReadyToDeleteCallback = NotifyReadyToDeleteCallback_t(),
+        const bool useUdpGenericReceiveOffload = false);
     UDP_LIB_EXPORT ~UdpBundleSink();
     UDP_LIB_EXPORT bool ReadyToBeDeleted();
 private:
 
     UDP_LIB_NO_EXPORT void StartUdpReceive();
     UDP_LIB_NO_EXPORT void HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred);
+    UDP_LIB_NO_EXPORT void HandleUdpReceiveGro(const boost::system::error_code & error);
     UDP_LIB_NO_EXPORT void PopCbThreadFunc();
     UDP_LIB_NO_EXPORT void DoUdpShutdown();
     UDP_LIB_NO_EXPORT void HandleSocketShutdown();
@@ -72,6 +76,9 @@ private:
     std::vector<padded_vector_uint8_t > m_udpReceiveBuffersCbVec;
     std::vector<boost::asio::ip::udp::endpoint> m_remoteEndpointsCbVec;
     std::vector<std::size_t> m_udpReceiveBytesTransferredCbVec;
+    bool m_useUdpGenericReceiveOffload;
+    std::vector<uint8_t> m_udpGroReceiveBuffer; //one coalesced super-packet, copied out per segment into the circular buffer
+    std::vector<uint64_t> m_udpGroControlBuffer; //UDP_GRO cmsg storage (uint64_t for cmsghdr alignment)
     boost::condition_variable m_conditionVariableCb;
     boost::mutex m_mutexCb;
     std::unique_ptr<boost::thread> m_threadCbReaderPtr;
@@ -79,6 +86,7 @@ private:
     volatile bool m_safeToDelete;
     uint32_t m_incomingBundleSize;
     uint64_t m_countCircularBufferOverruns;
+    uint64_t m_countUdpGroSuperPacketsReceived;
     bool m_printedCbTooSmallNotice;
 };
 
@@ -18,6 +18,16 @@
 #include "Logger.h"
 #include <boost/endian/conversion.hpp>
 #include <boost/make_unique.hpp>
+#include <cstring>
+#include <algorithm>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#ifndef UDP_GRO
+# define UDP_GRO 104 //linux/udp.h (kernel 5.0+), not yet in all libc headers
+#endif
+#endif
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
 
@@ -26,7 +36,8 @@ UdpBundleSink::UdpBundleSink(boost::asio::io_service & ioService,
     const WholeBundleReadyCallbackUdp_t & wholeBundleReadyCallback,
     const unsigned int numCircularBufferVectors,
     const unsigned int maxUdpPacketSizeBytes,
-    const NotifyReadyToDeleteCallback_t & notifyReadyToDeleteCallback) :
+    const NotifyReadyToDeleteCallback_t & notifyReadyToDeleteCallback,
+    const bool useUdpGenericReceiveOffload) :
     m_wholeBundleReadyCallback(wholeBundleReadyCallback),
     m_notifyReadyToDeleteCallback(notifyReadyToDeleteCallback),
     m_udpSocket(ioService),
@@ -38,9 +49,11 @@ UdpBundleSink::UdpBundleSink(boost::asio::io_service & ioService,
     m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_remoteEndpointsCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_udpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_useUdpGenericReceiveOffload(false),
     m_running(false),
     m_safeToDelete(false),
     m_countCircularBufferOverruns(0),
+    m_countUdpGroSuperPacketsReceived(0),
     m_printedCbTooSmallNotice(false)
 {
     for (unsigned int i = 0; i < M_NUM_CIRCULAR_BUFFER_VECTORS; ++i) {
@@ -68,6 +81,22 @@ UdpBundleSink::UdpBundleSink(boost::asio::io_service & ioService,
         return;
     }
     LOG_INFO(subprocess) << "UdpBundleSink bound successfully on UDP port " << udpPort << "...";
+    if (useUdpGenericReceiveOffload) {
+#ifdef _WIN32
+        LOG_WARNING(subprocess) << "UdpBundleSink: UDP_GRO not available on Windows.. receiving without GRO";
+#else
+        const int enableGro = 1;
+        if (setsockopt(m_udpSocket.native_handle(), IPPROTO_UDP, UDP_GRO, &enableGro, sizeof(enableGro)) != 0) {
+            LOG_WARNING(subprocess) << "UdpBundleSink: UDP_GRO not supported by this kernel (errno " << errno << ").. receiving without GRO";
+        }
+        else {
+            m_useUdpGenericReceiveOffload = true;
+            m_udpGroReceiveBuffer.resize(65535); //max udp datagram
+            m_udpGroControlBuffer.resize((CMSG_SPACE(sizeof(int)) + (sizeof(uint64_t) - 1)) / sizeof(uint64_t));
+            LOG_INFO(subprocess) << "UdpBundleSink using UDP generic receive offload on UDP port " << udpPort;
+        }
+#endif
+    }
     StartUdpReceive(); //call before creating io_service thread so that it has "work"
 }
 
@@ -91,9 +120,19 @@ UdpBundleSink::~UdpBundleSink() {
         m_threadCbReaderPtr.reset(); //delete it
     }
     LOG_INFO(subprocess) << "UdpBundleSink m_countCircularBufferOverruns: " << m_countCircularBufferOverruns;
+    if (m_useUdpGenericReceiveOffload) {
+        LOG_INFO(subprocess) << "UdpBundleSink m_countUdpGroSuperPacketsReceived: " << m_countUdpGroSuperPacketsReceived;
+    }
 }
 
 void UdpBundleSink::StartUdpReceive() {
+    if (m_useUdpGenericReceiveOffload) {
+        //wait for the socket to become readable, then HandleUdpReceiveGro reads one (possibly coalesced) datagram with recvmsg
+        m_udpSocket.async_wait(boost::asio::ip::udp::socket::wait_read,
+            boost::bind(&UdpBundleSink::HandleUdpReceiveGro, this,
+                boost::asio::placeholders::error));
+        return;
+    }
     m_udpSocket.async_receive_from(
         boost::asio::buffer(m_udpReceiveBuffer),
         m_remoteEndpoint,
@@ -132,6 +171,88 @@ void UdpBundleSink::HandleUdpReceive(const boost::system::error_code & error, st
 
 
 
+void UdpBundleSink::HandleUdpReceiveGro(const boost::system::error_code & error) {
+#ifndef _WIN32
+    if (!error) {
+        struct sockaddr_in remoteAddress;
+        struct iovec iov;
+        iov.iov_base = m_udpGroReceiveBuffer.data();
+        iov.iov_len = m_udpGroReceiveBuffer.size();
+        struct msghdr msgHeader;
+        memset(&msgHeader, 0, sizeof(msgHeader));
+        msgHeader.msg_name = &remoteAddress;
+        msgHeader.msg_namelen = sizeof(remoteAddress);
+        msgHeader.msg_iov = &iov;
+        msgHeader.msg_iovlen = 1;
+        msgHeader.msg_control = m_udpGroControlBuffer.data();
+        msgHeader.msg_controllen = CMSG_SPACE(sizeof(int));
+        const ssize_t retval = recvmsg(m_udpSocket.native_handle(), &msgHeader, MSG_DONTWAIT);
+        if (retval < 0) {
+            const int errnoCopy = errno;
+            if ((errnoCopy == EAGAIN) || (errnoCopy == EWOULDBLOCK) || (errnoCopy == EINTR)) { //spurious wakeup
+                StartUdpReceive();
+            }
+            else {
+                LOG_FATAL(subprocess) << "UdpBundleSink::HandleUdpReceiveGro(): recvmsg failed with errno " << errnoCopy;
+                DoUdpShutdown();
+            }
+            return;
+        }
+        const std::size_t bytesTransferred = static_cast<std::size_t>(retval);
+        std::size_t gsoSize = bytesTransferred;
+        for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msgHeader); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgHeader, cmsg)) {
+            if ((cmsg->cmsg_level == IPPROTO_UDP) && (cmsg->cmsg_type == UDP_GRO)) {
+                int gsoSizeInt;
+                memcpy(&gsoSizeInt, CMSG_DATA(cmsg), sizeof(gsoSizeInt));
+                if (gsoSizeInt > 0) {
+                    gsoSize = static_cast<std::size_t>(gsoSizeInt);
+                }
+                break;
+            }
+        }
+        if (gsoSize < bytesTransferred) {
+            ++m_countUdpGroSuperPacketsReceived;
+        }
+        const boost::asio::ip::udp::endpoint remoteEndpoint(boost::asio::ip::address_v4(ntohl(remoteAddress.sin_addr.s_addr)), ntohs(remoteAddress.sin_port));
+
+        //each segment of the super-packet is one whole bundle
+        bool committedAny = false;
+        for (std::size_t offset = 0; offset < bytesTransferred; offset += gsoSize) {
+            const std::size_t segmentSize = std::min(gsoSize, bytesTransferred - offset);
+            if (segmentSize > M_MAX_UDP_PACKET_SIZE_BYTES) {
+                LOG_ERROR(subprocess) << "UdpBundleSink::HandleUdpReceiveGro(): received udp datagram of size " << segmentSize
+                    << " exceeds the max udp packet size of " << M_MAX_UDP_PACKET_SIZE_BYTES << ".. dropping";
+                continue;
+            }
+            const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
+            if (writeIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+                ++m_countCircularBufferOverruns;
+                if (!m_printedCbTooSmallNotice) {
+                    m_printedCbTooSmallNotice = true;
+                    LOG_INFO(subprocess) << "UdpBundleSink::HandleUdpReceiveGro(): buffers full.. you might want to increase the circular buffer size! This UDP packet will be dropped!";
+                }
+                continue;
+            }
+            memcpy(m_udpReceiveBuffersCbVec[writeIndex].data(), m_udpGroReceiveBuffer.data() + offset, segmentSize);
+            m_udpReceiveBytesTransferredCbVec[writeIndex] = segmentSize;
+            m_remoteEndpointsCbVec[writeIndex] = remoteEndpoint;
+            m_mutexCb.lock();
+            m_circularIndexBuffer.CommitWrite(); //write complete at this point
+            m_mutexCb.unlock();
+            committedAny = true;
+        }
+        if (committedAny) {
+            m_conditionVariableCb.notify_one();
+        }
+        StartUdpReceive(); //restart operation only if there was no error
+    }
+    else if (error != boost::asio::error::operation_aborted) {
+        LOG_FATAL(subprocess) << "UdpBundleSink::HandleUdpReceiveGro(): " << error.message();
+        DoUdpShutdown();
+    }
+#endif
+}
+
 void UdpBundleSink::PopCbThreadFunc() {
 
     while (true) { //keep thread alive if running or cb not empty, i.e. "while (m_running || (m_circularIndexBuffer.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY))"
@@ -0,0 +1,89 @@
+/**
+ * @file CoalescingQueue.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The CoalescingQueue class template lets many producer threads share one sender (e.g. a zmq socket)
+ * without a dedicated sending thread.  The producer whose Push() finds no flush in progress becomes the
+ * flusher and sends its own item immediately, so an idle sender adds no latency and sends single items.
+ * Items pushed by other threads while the flusher is busy sending are picked up by the flusher's
+ * next TakeAll() all at once, so under load the items coalesce into batches.
+ * A max number of passes per flush keeps one producer from being held sending everyone else's items
+ * for as long as the load lasts: the flusher then hands the role back, and the items left behind are taken
+ * by the next Push(), or by TryBeginFlush() from a thread that checks periodically (so they are never stranded).
+ */
+
+#ifndef _COALESCING_QUEUE_H
+#define _COALESCING_QUEUE_H 1
+
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/core/noncopyable.hpp>
+
+template <typename T>
+class CoalescingQueue : private boost::noncopyable {
+public:
+    CoalescingQueue() : CoalescingQueue(0) {}
+    //maxPassesPerFlush of 0 means unlimited (the flusher flushes until there are no items left)
+    explicit CoalescingQueue(const unsigned int maxPassesPerFlush) :
+        M_MAX_PASSES_PER_FLUSH(maxPassesPerFlush), m_numPassesThisFlush(0), m_isFlushing(false) {}
+
+    //returns true if the caller became the flusher and must now call TakeAll() until it returns NULL,
+    //or false if another thread is flushing (and that thread will take this item)
+    bool Push(T && item) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_pendingItems.push_back(std::move(item));
+        if (m_isFlushing) {
+            return false;
+        }
+        m_isFlushing = true;
+        return true;
+    }
+
+    //flusher only: every item pushed since the last call (in push order), or NULL (ending the flush) if there are none
+    //or the max passes per flush were taken (handing the remaining items to the next Push() or TryBeginFlush()).
+    //The returned items may be moved from, and stay valid until the next call.
+    std::vector<T> * TakeAll() {
+        m_flushingItems.clear(); //keeps the capacity, so the two vectors swapped below stop allocating
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_pendingItems.empty() || (M_MAX_PASSES_PER_FLUSH && (m_numPassesThisFlush == M_MAX_PASSES_PER_FLUSH))) {
+            m_isFlushing = false;
+            m_numPassesThisFlush = 0;
+            return NULL;
+        }
+        ++m_numPassesThisFlush;
+        m_pendingItems.swap(m_flushingItems);
+        return &m_flushingItems;
+    }
+
+    //returns true if the caller became the flusher of items left behind by a flusher that reached its max passes
+    //(and must now call TakeAll() until it returns NULL), or false if there are none or another thread is flushing
+    bool TryBeginFlush() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_isFlushing || m_pendingItems.empty()) {
+            return false;
+        }
+        m_isFlushing = true;
+        return true;
+    }
+
+private:
+    boost::mutex m_mutex;
+    std::vector<T> m_pendingItems;
+    std::vector<T> m_flushingItems; //used only by the flusher
+    const unsigned int M_MAX_PASSES_PER_FLUSH;
+    unsigned int m_numPassesThisFlush;
+    bool m_isFlushing;
+};
+
+#endif //_COALESCING_QUEUE_H
@@ -0,0 +1,76 @@
+/**
+ * @file MemoryMappedFileBuffer.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The MemoryMappedFileBuffer class is a resizable byte buffer backed by a (sparse) file mapped read/write into memory,
+ * for holding data too large to keep in RAM (such as the red part of a very large LTP block).
+ * Only the pages that are written occupy disk space, and the operating system pages the data in and out as needed.
+ * The file is deleted when the buffer is destroyed unless the owner takes the file with SetDeleteFileOnDestruction(false).
+ */
+
+#ifndef _MEMORY_MAPPED_FILE_BUFFER_H
+#define _MEMORY_MAPPED_FILE_BUFFER_H 1
+
+#include <cstdint>
+#include <memory>
+#include <boost/core/noncopyable.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "hdtn_util_export.h"
+
+class MemoryMappedFileBuffer : private boost::noncopyable {
+public:
+    //Creates (or truncates) the file at filePath as a zero filled sparse file of sizeBytes (must be non-zero) and maps it.
+    //Returns NULL on failure.
+    HDTN_UTIL_EXPORT static std::unique_ptr<MemoryMappedFileBuffer> Create(const boost::filesystem::path & filePath, const uint64_t sizeBytes);
+    HDTN_UTIL_EXPORT ~MemoryMappedFileBuffer();
+
+    //Grows or shrinks the file (and mapping) to newSizeBytes (must be non-zero), preserving the first min(old, new) bytes.
+    //data() may change.  Returns false (with the buffer no longer mapped, size() == 0) on failure.
+    HDTN_UTIL_EXPORT bool Resize(const uint64_t newSizeBytes);
+    //Allocates the disk blocks backing [offsetBytes, offsetBytes + lengthBytes) of the sparse file, so that a later write
+    //of that range through data() cannot run out of disk space (which raises SIGBUS rather than returning an error).
+    //Returns false if the range is not within size() or the space cannot be allocated (e.g. the disk is full).
+    HDTN_UTIL_EXPORT bool AllocateDiskSpace(const uint64_t offsetBytes, const uint64_t lengthBytes);
+    //Synchronously writes the modified pages to the file.
+    HDTN_UTIL_EXPORT bool Flush();
+    HDTN_UTIL_EXPORT void SetDeleteFileOnDestruction(const bool deleteFileOnDestruction);
+    HDTN_UTIL_EXPORT const boost::filesystem::path & GetFilePath() const;
+
+    uint8_t * data() noexcept {
+        return m_data;
+    }
+    const uint8_t * data() const noexcept {
+        return m_data;
+    }
+    uint64_t size() const noexcept {
+        return m_sizeBytes;
+    }
+
+private:
+    MemoryMappedFileBuffer() = delete;
+    HDTN_UTIL_NO_EXPORT explicit MemoryMappedFileBuffer(const boost::filesystem::path & filePath);
+    HDTN_UTIL_NO_EXPORT bool ResizeFileAndMap(const uint64_t sizeBytes);
+    HDTN_UTIL_NO_EXPORT void Unmap();
+
+    const boost::filesystem::path m_filePath;
+    boost::interprocess::file_mapping m_fileMapping;
+    boost::interprocess::mapped_region m_region;
+    uint8_t * m_data;
+    uint64_t m_sizeBytes;
+    bool m_deleteFileOnDestruction;
+};
+
+#endif //_MEMORY_MAPPED_FILE_BUFFER_H
@@ -0,0 +1,104 @@
+/**
+ * @file SharedMemoryBundleArena.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The SharedMemoryBundleArena class is a named shared memory object of fixed size slots that lets HDTN modules running as
+ * separate processes on one host (hdtn-ingress, hdtn-storage and hdtn-egress-async) pass a bundle between them as a small
+ * Descriptor (slot index, generation and size) over their existing zmq sockets instead of sending the bundle's bytes over tcp.
+ * The producer writes the bundle into a slot it allocated, sends the slot's Descriptor, and hands the slot off to the receiving process;
+ * the receiving process turns the Descriptor into a zmq::message_t pointing into the slot, which frees the slot once destroyed.
+ * Each slot records (in one atomic word) the pid of the process responsible for it and a generation counter,
+ * so slots left behind by a process that died (or was restarted) are reclaimed by the survivors,
+ * and a Descriptor that outlived its slot's reclamation is detected by its generation and rejected.
+ */
+
+#ifndef _SHARED_MEMORY_BUNDLE_ARENA_H
+#define _SHARED_MEMORY_BUNDLE_ARENA_H 1
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <boost/core/noncopyable.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "zmq.hpp"
+#include "hdtn_util_export.h"
+
+class SharedMemoryBundleArena : private boost::noncopyable {
+public:
+    enum class PROCESS : uint8_t {
+        INGRESS = 0,
+        STORAGE,
+        EGRESS,
+        NUM_PROCESSES
+    };
+    struct Descriptor {
+        uint32_t slotIndex;
+        uint32_t generation;
+        uint64_t bundleSizeBytes;
+    };
+    struct ArenaHeader;
+    struct SlotHeader;
+
+    //Opens the arena of the given name, creating it if no process has yet.  All processes must agree on numSlots and slotSizeBytes.
+    //Reclaims the slots of processes that are no longer running (including a previous instance of myProcess).
+    //Returns NULL on failure.
+    HDTN_UTIL_EXPORT static std::unique_ptr<SharedMemoryBundleArena> Open(const std::string & name,
+        const uint64_t numSlots, const uint64_t slotSizeBytes, const PROCESS myProcess);
+    HDTN_UTIL_EXPORT static bool Remove(const std::string & name);
+    //must outlive every zmq::message_t returned by DescriptorMessageToBundle
+    HDTN_UTIL_EXPORT ~SharedMemoryBundleArena();
+
+    //Producer: returns a slot of at least bundleSizeBytes for the caller to write the bundle into, or NULL if the bundle
+    //is larger than a slot or no slot is free.  The slot must then be either sent with SendDescriptor or returned with Free.
+    HDTN_UTIL_EXPORT uint8_t * Allocate(const std::size_t bundleSizeBytes, Descriptor & descriptor);
+    //Allocate followed by a copy of the bundle into the slot
+    HDTN_UTIL_EXPORT bool CopyIn(const zmq::message_t & bundle, Descriptor & descriptor);
+    HDTN_UTIL_EXPORT void Free(const Descriptor & descriptor);
+    //Producer: sends the descriptor as one frame and, if sent, hands the slot off to the receiving process.
+    //If not sent, the slot is still the caller's (to retry or Free).
+    HDTN_UTIL_EXPORT bool SendDescriptor(zmq::socket_t & sock, const Descriptor & descriptor, const PROCESS toProcess, const zmq::send_flags flags);
+
+    //Consumer: replaces a received descriptor frame with a zmq::message_t of the bundle in its slot (no copy), which frees the slot when destroyed.
+    //Returns false (leaving the message unmodified) if the frame is not a descriptor or if its slot was reclaimed.
+    HDTN_UTIL_EXPORT bool DescriptorMessageToBundle(zmq::message_t & messageInOut);
+
+    //Frees the slots of processes that are no longer running, returning the number of slots freed.
+    HDTN_UTIL_EXPORT std::size_t ReclaimSlotsOfDeadProcesses();
+    HDTN_UTIL_EXPORT std::size_t GetNumSlotsInUse() const;
+    HDTN_UTIL_EXPORT uint64_t GetNumSlots() const;
+    HDTN_UTIL_EXPORT uint64_t GetSlotSizeBytes() const;
+
+private:
+    SharedMemoryBundleArena() = delete;
+    HDTN_UTIL_NO_EXPORT SharedMemoryBundleArena(boost::interprocess::mapped_region && region, const uint64_t numSlots,
+        const uint64_t slotSizeBytes, const PROCESS myProcess, const uint32_t myPid);
+    HDTN_UTIL_NO_EXPORT static bool IsProcessRunning(const uint32_t pid);
+    HDTN_UTIL_NO_EXPORT void ReleaseSlot(const uint8_t * slotData);
+    HDTN_UTIL_NO_EXPORT static void ReleaseSlotCallback(void *data, void *hint);
+
+    boost::interprocess::mapped_region m_region;
+    ArenaHeader * m_arenaHeaderPtr;
+    SlotHeader * m_slotHeaders;
+    uint8_t * m_slotsData;
+    const uint64_t m_numSlots;
+    const uint64_t m_slotSizeBytes;
+    const uint64_t m_slotStrideBytes;
+    const PROCESS m_myProcess;
+    const uint32_t m_myPid;
+    std::atomic<uint64_t> m_lastReclaimMilliseconds; //for limiting reclaim scans when the arena is full
+};
+
+#endif //_SHARED_MEMORY_BUNDLE_ARENA_H
@@ -0,0 +1,103 @@
+/**
+ * @file SlotQueueSingleProducerSingleConsumer.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The SlotQueueSingleProducerSingleConsumer class template is a bounded single producer single consumer queue linking two
+ * threads (e.g. two stages of the storage pipeline).  Messages are written into and read out of preallocated slots
+ * in place (slots are reused, so large members keep their capacity), and the lock-free fast path only
+ * shares the two indices of a CircularIndexBufferSingleProducerSingleConsumerConfigurable.
+ * A producer only locks a mutex when the queue is full, and CommitWrite() reports when the consumer
+ * may have gone to sleep on an empty queue so that the producer can wake it by whatever means the consumer waits on
+ * (e.g. a zmq inproc socket included in the consumer's zmq::poll).
+ */
+
+#ifndef _SLOT_QUEUE_SINGLE_PRODUCER_SINGLE_CONSUMER_H
+#define _SLOT_QUEUE_SINGLE_PRODUCER_SINGLE_CONSUMER_H 1
+
+#include <memory>
+#include <atomic>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/core/noncopyable.hpp>
+#include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
+
+template <typename T>
+class SlotQueueSingleProducerSingleConsumer : private boost::noncopyable {
+private:
+    SlotQueueSingleProducerSingleConsumer();
+public:
+    SlotQueueSingleProducerSingleConsumer(const unsigned int capacity) :
+        m_circularIndexBuffer(capacity + 1), //circular index buffer holds one less than its size
+        m_slots(new T[capacity + 1]),
+        m_producerWaiting(false) {}
+
+    //producer: the slot to fill, waiting up to timeout while the queue is full, or NULL if still full
+    T * GetSlotForWrite(const boost::posix_time::time_duration & timeout) {
+        unsigned int produceIndex = m_circularIndexBuffer.GetIndexForWrite();
+        if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+            const boost::posix_time::ptime expiry = boost::posix_time::microsec_clock::universal_time() + timeout;
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_producerWaiting = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst); //publish m_producerWaiting before rechecking the consumer's index
+            while ((produceIndex = m_circularIndexBuffer.GetIndexForWrite()) == CIRCULAR_INDEX_BUFFER_FULL) {
+                if (!m_conditionVariable.timed_wait(lock, expiry)) {
+                    produceIndex = m_circularIndexBuffer.GetIndexForWrite();
+                    break;
+                }
+            }
+            m_producerWaiting = false;
+            if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) {
+                return NULL;
+            }
+        }
+        return &m_slots[produceIndex];
+    }
+
+    //producer: publish the slot from GetSlotForWrite,
+    //returns true if the consumer may have found the queue empty (i.e. the consumer may need woken up)
+    bool CommitWrite() {
+        m_circularIndexBuffer.CommitWrite();
+        std::atomic_thread_fence(std::memory_order_seq_cst); //publish the write before checking the consumer's index
+        return (m_circularIndexBuffer.NumInBuffer() <= 1);
+    }
+
+    //consumer: the oldest slot, or NULL if empty
+    T * GetSlotForRead() {
+        const unsigned int consumeIndex = m_circularIndexBuffer.GetIndexForRead();
+        return (consumeIndex == CIRCULAR_INDEX_BUFFER_EMPTY) ? NULL : &m_slots[consumeIndex];
+    }
+
+    //consumer: release the slot from GetSlotForRead back to the producer
+    void CommitRead() {
+        m_circularIndexBuffer.CommitRead();
+        std::atomic_thread_fence(std::memory_order_seq_cst); //publish the read before checking m_producerWaiting
+        if (m_producerWaiting) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_conditionVariable.notify_one();
+        }
+    }
+
+    unsigned int Size() {
+        return m_circularIndexBuffer.NumInBuffer();
+    }
+
+private:
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
+    std::unique_ptr<T[]> m_slots;
+    boost::mutex m_mutex;
+    boost::condition_variable m_conditionVariable;
+    volatile bool m_producerWaiting;
+};
+
+#endif //_SLOT_QUEUE_SINGLE_PRODUCER_SINGLE_CONSUMER_H
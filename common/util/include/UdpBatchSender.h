@@ -18,6 +18,8 @@
  * This UdpBatchSender class encapsulates the appropriate UDP functionality
  * to send multiple UDP packets in one system call in order to increase UDP throughput.
  * It also benefits in performance because the UDP socket must be "connected".
+ * On Linux, UDP generic segmentation offload (UDP_SEGMENT) can optionally be enabled so that
+ * a run of consecutive equal-size packets is handed to the kernel as one large send.
  */
 
 #ifndef _UDP_BATCH_SENDER_H
@@ -48,6 +50,18 @@ public:
     HDTN_UTIL_EXPORT void SetOnSentPacketsCallback(const OnSentPacketsCallback_t& callback);
     HDTN_UTIL_EXPORT void SetEndpointAndReconnect_ThreadSafe(const boost::asio::ip::udp::endpoint& remoteEndpoint);
     HDTN_UTIL_EXPORT void SetEndpointAndReconnect_ThreadSafe(const std::string& remoteHostname, const uint16_t remotePort);
+    /** Enable or disable UDP generic segmentation offload (Linux UDP_SEGMENT).
+     * When enabled, each run of consecutive equal-size packets (optionally followed by one shorter packet)
+     * within a QueueSendPacketsOperation_ThreadSafe call is sent as one sendmmsg message with a UDP_SEGMENT control message,
+     * and the kernel (or NIC) splits it back into the individual UDP packets.
+     * Call after Init() and before queuing send operations.
+     * If a GSO send later fails with EIO or EINVAL (the route or device cannot segment), GSO is disabled
+     * and the unsent rest of that batch (and every later batch) is sent as individual datagrams.
+     *
+     * @param useUdpSegmentationOffload True to enable GSO.
+     * @return True if the requested setting is now in effect, or false if GSO was requested but is not supported by this system.
+     */
+    HDTN_UTIL_EXPORT bool SetUseUdpSegmentationOffload(const bool useUdpSegmentationOffload);
 
 private:
     HDTN_UTIL_NO_EXPORT bool SetEndpointAndReconnect(const boost::asio::ip::udp::endpoint& remoteEndpoint);
@@ -56,6 +70,10 @@ private:
         std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs,
         std::vector<std::shared_ptr<std::vector<std::vector<uint8_t> > > >& underlyingDataToDeleteOnSentCallbackVec,
         std::vector<std::shared_ptr<LtpClientServiceDataToSend> >& underlyingCsDataToDeleteOnSentCallbackVec);
+#ifndef _WIN32
+    HDTN_UTIL_NO_EXPORT void AppendDatagramMessages(std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs, const std::size_t firstPacketIndex);
+    HDTN_UTIL_NO_EXPORT void AppendUdpGsoMessages(std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs);
+#endif
     HDTN_UTIL_NO_EXPORT void DoUdpShutdown();
     HDTN_UTIL_NO_EXPORT void DoHandleSocketShutdown();
 private:
@@ -74,7 +92,11 @@ private:
     std::vector<TRANSMIT_PACKETS_ELEMENT> m_transmitPacketsElementVec;
 #else //not #ifdef _WIN32
     std::vector<struct mmsghdr> m_transmitPacketsElementVec;
+    std::vector<struct iovec> m_udpGsoIovecsVec;
+    std::vector<uint64_t> m_udpGsoControlMessagesVec; //UDP_SEGMENT cmsg storage (uint64_t for cmsghdr alignment)
+    std::vector<std::size_t> m_udpGsoFirstPacketIndexVec; //per GSO message, its first index into constBufferVecs (to resend without GSO)
 #endif
+    volatile bool m_useUdpSegmentationOffload;
     
     OnSentPacketsCallback_t m_onSentPacketsCallback;
 };
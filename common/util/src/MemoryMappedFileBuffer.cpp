@@ -0,0 +1,136 @@
+/**
+ * @file MemoryMappedFileBuffer.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "MemoryMappedFileBuffer.h"
+#include "Logger.h"
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+#include <boost/filesystem/operations.hpp>
+
+static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
+
+MemoryMappedFileBuffer::MemoryMappedFileBuffer(const boost::filesystem::path & filePath) :
+    m_filePath(filePath),
+    m_data(NULL),
+    m_sizeBytes(0),
+    m_deleteFileOnDestruction(true) {}
+
+std::unique_ptr<MemoryMappedFileBuffer> MemoryMappedFileBuffer::Create(const boost::filesystem::path & filePath, const uint64_t sizeBytes) {
+    if (sizeBytes == 0) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer::Create: size of " << filePath << " must be non-zero";
+        return std::unique_ptr<MemoryMappedFileBuffer>();
+    }
+    FILE * fileHandle = fopen(filePath.string().c_str(), "wb");
+    if (fileHandle == NULL) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer::Create: cannot create file " << filePath;
+        return std::unique_ptr<MemoryMappedFileBuffer>();
+    }
+    fclose(fileHandle);
+    std::unique_ptr<MemoryMappedFileBuffer> bufferPtr(new MemoryMappedFileBuffer(filePath)); //private constructor
+    if (!bufferPtr->ResizeFileAndMap(sizeBytes)) {
+        return std::unique_ptr<MemoryMappedFileBuffer>(); //destructor removes the file
+    }
+    return bufferPtr;
+}
+
+MemoryMappedFileBuffer::~MemoryMappedFileBuffer() {
+    Unmap();
+    if (m_deleteFileOnDestruction) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(m_filePath, ec);
+        if (ec) {
+            LOG_ERROR(subprocess) << "MemoryMappedFileBuffer: cannot remove file " << m_filePath << ": " << ec.message();
+        }
+    }
+}
+
+void MemoryMappedFileBuffer::Unmap() {
+    //the mapping must be released before the file can be resized (or removed) on Windows
+    boost::interprocess::mapped_region().swap(m_region);
+    boost::interprocess::file_mapping().swap(m_fileMapping);
+    m_data = NULL;
+    m_sizeBytes = 0;
+}
+
+bool MemoryMappedFileBuffer::ResizeFileAndMap(const uint64_t sizeBytes) {
+    Unmap();
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(m_filePath, sizeBytes, ec); //zero filled, sparse where supported
+    if (ec) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer: cannot resize file " << m_filePath << " to " << sizeBytes << " bytes: " << ec.message();
+        return false;
+    }
+    try {
+        boost::interprocess::file_mapping(m_filePath.string().c_str(), boost::interprocess::read_write).swap(m_fileMapping);
+        boost::interprocess::mapped_region(m_fileMapping, boost::interprocess::read_write, 0, static_cast<std::size_t>(sizeBytes)).swap(m_region);
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer: cannot map file " << m_filePath << " of " << sizeBytes << " bytes: " << e.what();
+        Unmap();
+        return false;
+    }
+    m_data = static_cast<uint8_t*>(m_region.get_address());
+    m_sizeBytes = sizeBytes;
+    return true;
+}
+
+bool MemoryMappedFileBuffer::Resize(const uint64_t newSizeBytes) {
+    if (newSizeBytes == 0) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer::Resize: size of " << m_filePath << " must be non-zero";
+        return false;
+    }
+    if (newSizeBytes == m_sizeBytes) {
+        return true;
+    }
+    return ResizeFileAndMap(newSizeBytes);
+}
+
+bool MemoryMappedFileBuffer::AllocateDiskSpace(const uint64_t offsetBytes, const uint64_t lengthBytes) {
+    if ((m_data == NULL) || (offsetBytes > m_sizeBytes) || (lengthBytes > (m_sizeBytes - offsetBytes))) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer::AllocateDiskSpace: range (offset=" << offsetBytes << ", length=" << lengthBytes
+            << ") is not within " << m_filePath << " of " << m_sizeBytes << " bytes";
+        return false;
+    }
+    if (lengthBytes == 0) {
+        return true;
+    }
+#if defined(_WIN32) || defined(__APPLE__)
+    //resize_file does not create a sparse file on Windows (the space is already allocated), and there is no posix_fallocate on Apple
+    return true;
+#else
+    const int ret = posix_fallocate(m_fileMapping.get_mapping_handle().handle,
+        static_cast<off_t>(offsetBytes), static_cast<off_t>(lengthBytes));
+    if (ret != 0) {
+        LOG_ERROR(subprocess) << "MemoryMappedFileBuffer::AllocateDiskSpace: cannot allocate " << lengthBytes << " bytes at offset "
+            << offsetBytes << " of " << m_filePath << ": " << strerror(ret);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool MemoryMappedFileBuffer::Flush() {
+    return (m_data != NULL) && m_region.flush(0, 0, false);
+}
+
+void MemoryMappedFileBuffer::SetDeleteFileOnDestruction(const bool deleteFileOnDestruction) {
+    m_deleteFileOnDestruction = deleteFileOnDestruction;
+}
+
+const boost::filesystem::path & MemoryMappedFileBuffer::GetFilePath() const {
+    return m_filePath;
+}
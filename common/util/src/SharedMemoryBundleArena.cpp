@@ -0,0 +1,340 @@
+/**
+ * @file SharedMemoryBundleArena.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "SharedMemoryBundleArena.h"
+#include "Logger.h"
+#include <cstring>
+#include <new>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
+
+//Shared memory layout: ArenaHeader, then one SlotHeader per slot, then the slots (each starting on a cache line).
+static constexpr uint64_t ARENA_MAGIC = 0x48444e5441524e31; //"HDNTARN1"
+static constexpr uint64_t CACHE_LINE_SIZE = 64;
+static constexpr unsigned int NUM_PROCESSES = static_cast<unsigned int>(SharedMemoryBundleArena::PROCESS::NUM_PROCESSES);
+
+struct SharedMemoryBundleArena::ArenaHeader {
+    std::atomic<uint64_t> magic; //set last by the creator
+    uint64_t numSlots;
+    uint64_t slotSizeBytes;
+    std::atomic<uint64_t> nextSlotToTry;
+    std::atomic<uint32_t> processPids[NUM_PROCESSES]; //0 if not running
+};
+
+//Owner pid (0 if free) in the upper 32 bits, generation (incremented on each allocation) in the lower 32 bits.
+struct SharedMemoryBundleArena::SlotHeader {
+    std::atomic<uint64_t> ownerPidAndGeneration;
+};
+
+static_assert(sizeof(SharedMemoryBundleArena::Descriptor) == 16, "Descriptor must be 16 bytes");
+
+static inline uint64_t RoundUpToCacheLine(const uint64_t n) {
+    return ((n + (CACHE_LINE_SIZE - 1)) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+}
+static inline uint64_t MakeOwnerPidAndGeneration(const uint32_t pid, const uint32_t generation) {
+    return (static_cast<uint64_t>(pid) << 32) | generation;
+}
+static inline uint32_t GetOwnerPid(const uint64_t ownerPidAndGeneration) {
+    return static_cast<uint32_t>(ownerPidAndGeneration >> 32);
+}
+static inline uint32_t GetGeneration(const uint64_t ownerPidAndGeneration) {
+    return static_cast<uint32_t>(ownerPidAndGeneration);
+}
+static uint64_t GetTotalBytes(const uint64_t numSlots, const uint64_t slotSizeBytes) {
+    return RoundUpToCacheLine(sizeof(SharedMemoryBundleArena::ArenaHeader))
+        + RoundUpToCacheLine(numSlots * sizeof(SharedMemoryBundleArena::SlotHeader))
+        + (numSlots * RoundUpToCacheLine(slotSizeBytes));
+}
+static uint32_t GetMyPid() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+static uint64_t GetMillisecondsNow() {
+    return static_cast<uint64_t>((boost::posix_time::microsec_clock::universal_time() - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_milliseconds());
+}
+
+bool SharedMemoryBundleArena::IsProcessRunning(const uint32_t pid) {
+#ifdef _WIN32
+    HANDLE processHandle = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (processHandle == NULL) {
+        return (GetLastError() == ERROR_ACCESS_DENIED); //exists but owned by someone else
+    }
+    const bool running = (WaitForSingleObject(processHandle, 0) == WAIT_TIMEOUT);
+    CloseHandle(processHandle);
+    return running;
+#else
+    return (kill(static_cast<pid_t>(pid), 0) == 0) || (errno != ESRCH);
+#endif
+}
+
+SharedMemoryBundleArena::SharedMemoryBundleArena(boost::interprocess::mapped_region && region, const uint64_t numSlots,
+    const uint64_t slotSizeBytes, const PROCESS myProcess, const uint32_t myPid) :
+    m_region(std::move(region)),
+    m_arenaHeaderPtr(static_cast<ArenaHeader*>(m_region.get_address())),
+    m_slotHeaders(reinterpret_cast<SlotHeader*>(static_cast<uint8_t*>(m_region.get_address()) + RoundUpToCacheLine(sizeof(ArenaHeader)))),
+    m_slotsData(reinterpret_cast<uint8_t*>(m_slotHeaders) + RoundUpToCacheLine(numSlots * sizeof(SlotHeader))),
+    m_numSlots(numSlots),
+    m_slotSizeBytes(slotSizeBytes),
+    m_slotStrideBytes(RoundUpToCacheLine(slotSizeBytes)),
+    m_myProcess(myProcess),
+    m_myPid(myPid),
+    m_lastReclaimMilliseconds(0) {}
+
+SharedMemoryBundleArena::~SharedMemoryBundleArena() {
+    uint32_t expectedPid = m_myPid;
+    m_arenaHeaderPtr->processPids[static_cast<unsigned int>(m_myProcess)].compare_exchange_strong(expectedPid, 0);
+}
+
+std::unique_ptr<SharedMemoryBundleArena> SharedMemoryBundleArena::Open(const std::string & name,
+    const uint64_t numSlots, const uint64_t slotSizeBytes, const PROCESS myProcess)
+{
+    namespace bip = boost::interprocess;
+    if ((numSlots == 0) || (numSlots > UINT32_MAX) || (slotSizeBytes == 0)) {
+        LOG_ERROR(subprocess) << "SharedMemoryBundleArena::Open: invalid numSlots=" << numSlots << " slotSizeBytes=" << slotSizeBytes;
+        return std::unique_ptr<SharedMemoryBundleArena>();
+    }
+    const uint64_t totalBytes = GetTotalBytes(numSlots, slotSizeBytes);
+    static const boost::posix_time::time_duration maxWaitForCreator = boost::posix_time::seconds(5);
+    const boost::posix_time::ptime waitExpiry = boost::posix_time::microsec_clock::universal_time() + maxWaitForCreator;
+    std::unique_ptr<SharedMemoryBundleArena> arenaPtr;
+    bool created = false;
+    try {
+        bip::shared_memory_object shm;
+        try {
+            shm = bip::shared_memory_object(bip::create_only, name.c_str(), bip::read_write);
+            created = true;
+        }
+        catch (const bip::interprocess_exception & e) {
+            if (e.get_error_code() != bip::already_exists_error) {
+                throw;
+            }
+            shm = bip::shared_memory_object(bip::open_only, name.c_str(), bip::read_write);
+        }
+        if (created) {
+            shm.truncate(static_cast<bip::offset_t>(totalBytes)); //zero filled
+        }
+        else { //the creator truncates it right after creating it
+            bip::offset_t size = 0;
+            while (shm.get_size(size) && (size == 0) && (boost::posix_time::microsec_clock::universal_time() < waitExpiry)) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            }
+            if (static_cast<uint64_t>(size) != totalBytes) {
+                LOG_ERROR(subprocess) << "shared memory bundle arena " << name << " exists with a size of " << size << " bytes instead of "
+                    << totalBytes << " bytes (from a different configuration?), remove it and restart";
+                return std::unique_ptr<SharedMemoryBundleArena>();
+            }
+        }
+        bip::mapped_region region(shm, bip::read_write);
+        ArenaHeader * const arenaHeaderPtr = static_cast<ArenaHeader*>(region.get_address());
+        if (created) {
+            new (arenaHeaderPtr) ArenaHeader();
+            arenaHeaderPtr->numSlots = numSlots;
+            arenaHeaderPtr->slotSizeBytes = slotSizeBytes;
+            arenaHeaderPtr->nextSlotToTry = 0;
+            for (unsigned int i = 0; i < NUM_PROCESSES; ++i) {
+                arenaHeaderPtr->processPids[i] = 0;
+            }
+            SlotHeader * const slotHeaders = reinterpret_cast<SlotHeader*>(static_cast<uint8_t*>(region.get_address()) + RoundUpToCacheLine(sizeof(ArenaHeader)));
+            for (uint64_t i = 0; i < numSlots; ++i) {
+                new (&slotHeaders[i]) SlotHeader();
+                slotHeaders[i].ownerPidAndGeneration = 0;
+            }
+            arenaHeaderPtr->magic.store(ARENA_MAGIC, std::memory_order_release);
+        }
+        else {
+            while ((arenaHeaderPtr->magic.load(std::memory_order_acquire) != ARENA_MAGIC) && (boost::posix_time::microsec_clock::universal_time() < waitExpiry)) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            }
+            if (arenaHeaderPtr->magic.load(std::memory_order_acquire) != ARENA_MAGIC) {
+                LOG_ERROR(subprocess) << "shared memory bundle arena " << name << " was never initialized by its creator, remove it and restart";
+                return std::unique_ptr<SharedMemoryBundleArena>();
+            }
+            if ((arenaHeaderPtr->numSlots != numSlots) || (arenaHeaderPtr->slotSizeBytes != slotSizeBytes)) {
+                LOG_ERROR(subprocess) << "shared memory bundle arena " << name << " exists with numSlots=" << arenaHeaderPtr->numSlots
+                    << " slotSizeBytes=" << arenaHeaderPtr->slotSizeBytes << " instead of numSlots=" << numSlots << " slotSizeBytes=" << slotSizeBytes
+                    << ", remove it and restart";
+                return std::unique_ptr<SharedMemoryBundleArena>();
+            }
+        }
+        arenaPtr.reset(new SharedMemoryBundleArena(std::move(region), numSlots, slotSizeBytes, myProcess, GetMyPid()));
+    }
+    catch (const bip::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "cannot open shared memory bundle arena " << name << ": " << e.what();
+        return std::unique_ptr<SharedMemoryBundleArena>();
+    }
+    arenaPtr->m_arenaHeaderPtr->processPids[static_cast<unsigned int>(myProcess)].store(arenaPtr->m_myPid);
+    const std::size_t numReclaimed = arenaPtr->ReclaimSlotsOfDeadProcesses();
+    LOG_INFO(subprocess) << "opened shared memory bundle arena " << name << " of " << numSlots << " slots of " << slotSizeBytes
+        << " bytes (" << (created ? "created" : "existing") << "), reclaimed " << numReclaimed << " slots of processes no longer running";
+    return arenaPtr;
+}
+
+bool SharedMemoryBundleArena::Remove(const std::string & name) {
+    return boost::interprocess::shared_memory_object::remove(name.c_str());
+}
+
+uint8_t * SharedMemoryBundleArena::Allocate(const std::size_t bundleSizeBytes, Descriptor & descriptor) {
+    if (bundleSizeBytes > m_slotSizeBytes) {
+        return NULL;
+    }
+    for (unsigned int attempt = 0; attempt < 2; ++attempt) {
+        const uint64_t firstSlotToTry = m_arenaHeaderPtr->nextSlotToTry.fetch_add(1, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < m_numSlots; ++i) {
+            const uint64_t slotIndex = (firstSlotToTry + i) % m_numSlots;
+            std::atomic<uint64_t> & ownerPidAndGeneration = m_slotHeaders[slotIndex].ownerPidAndGeneration;
+            uint64_t expected = ownerPidAndGeneration.load(std::memory_order_relaxed);
+            if (GetOwnerPid(expected) != 0) {
+                continue;
+            }
+            const uint32_t generation = GetGeneration(expected) + 1;
+            if (ownerPidAndGeneration.compare_exchange_strong(expected, MakeOwnerPidAndGeneration(m_myPid, generation), std::memory_order_acquire)) {
+                if (i) { //skip the slots found in use for the next allocation
+                    m_arenaHeaderPtr->nextSlotToTry.store(slotIndex + 1, std::memory_order_relaxed);
+                }
+                descriptor.slotIndex = static_cast<uint32_t>(slotIndex);
+                descriptor.generation = generation;
+                descriptor.bundleSizeBytes = bundleSizeBytes;
+                return m_slotsData + (slotIndex * m_slotStrideBytes);
+            }
+        }
+        //full, so look for slots of dead processes (at most once per second)
+        const uint64_t nowMilliseconds = GetMillisecondsNow();
+        uint64_t lastReclaimMilliseconds = m_lastReclaimMilliseconds.load(std::memory_order_relaxed);
+        if ((attempt != 0) || (nowMilliseconds < (lastReclaimMilliseconds + 1000))
+            || (!m_lastReclaimMilliseconds.compare_exchange_strong(lastReclaimMilliseconds, nowMilliseconds))
+            || (ReclaimSlotsOfDeadProcesses() == 0))
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+bool SharedMemoryBundleArena::CopyIn(const zmq::message_t & bundle, Descriptor & descriptor) {
+    uint8_t * const slotData = Allocate(bundle.size(), descriptor);
+    if (slotData == NULL) {
+        return false;
+    }
+    memcpy(slotData, bundle.data(), bundle.size());
+    return true;
+}
+
+void SharedMemoryBundleArena::Free(const Descriptor & descriptor) {
+    uint64_t expected = MakeOwnerPidAndGeneration(m_myPid, descriptor.generation);
+    m_slotHeaders[descriptor.slotIndex].ownerPidAndGeneration.compare_exchange_strong(expected, descriptor.generation, std::memory_order_release);
+}
+
+bool SharedMemoryBundleArena::SendDescriptor(zmq::socket_t & sock, const Descriptor & descriptor, const PROCESS toProcess, const zmq::send_flags flags) {
+    if (!sock.send(zmq::const_buffer(&descriptor, sizeof(descriptor)), flags)) {
+        return false;
+    }
+    //Hand off so the slot is reclaimed if the receiving process dies before freeing it.  If the receiving process already
+    //took the slot (or isn't running yet, in which case it takes the slot when it receives the descriptor), this does nothing.
+    const uint32_t toPid = m_arenaHeaderPtr->processPids[static_cast<unsigned int>(toProcess)].load(std::memory_order_relaxed);
+    if (toPid != 0) {
+        uint64_t expected = MakeOwnerPidAndGeneration(m_myPid, descriptor.generation);
+        m_slotHeaders[descriptor.slotIndex].ownerPidAndGeneration.compare_exchange_strong(expected,
+            MakeOwnerPidAndGeneration(toPid, descriptor.generation), std::memory_order_release);
+    }
+    return true;
+}
+
+bool SharedMemoryBundleArena::DescriptorMessageToBundle(zmq::message_t & messageInOut) {
+    Descriptor descriptor;
+    if (messageInOut.size() != sizeof(descriptor)) {
+        return false;
+    }
+    memcpy(&descriptor, messageInOut.data(), sizeof(descriptor));
+    if ((descriptor.slotIndex >= m_numSlots) || (descriptor.bundleSizeBytes > m_slotSizeBytes)) {
+        return false;
+    }
+    std::atomic<uint64_t> & ownerPidAndGeneration = m_slotHeaders[descriptor.slotIndex].ownerPidAndGeneration;
+    uint64_t expected = ownerPidAndGeneration.load(std::memory_order_relaxed);
+    do {
+        if ((GetGeneration(expected) != descriptor.generation) || (GetOwnerPid(expected) == 0)) { //reclaimed (and maybe reallocated)
+            return false;
+        }
+    } while (!ownerPidAndGeneration.compare_exchange_weak(expected, MakeOwnerPidAndGeneration(m_myPid, descriptor.generation), std::memory_order_acquire));
+    messageInOut = zmq::message_t(m_slotsData + (descriptor.slotIndex * m_slotStrideBytes),
+        static_cast<std::size_t>(descriptor.bundleSizeBytes), ReleaseSlotCallback, this);
+    return true;
+}
+
+void SharedMemoryBundleArena::ReleaseSlotCallback(void *data, void *hint) {
+    static_cast<SharedMemoryBundleArena*>(hint)->ReleaseSlot(static_cast<const uint8_t*>(data));
+}
+
+void SharedMemoryBundleArena::ReleaseSlot(const uint8_t * slotData) {
+    std::atomic<uint64_t> & ownerPidAndGeneration = m_slotHeaders[(slotData - m_slotsData) / m_slotStrideBytes].ownerPidAndGeneration;
+    uint64_t expected = ownerPidAndGeneration.load(std::memory_order_relaxed);
+    do {
+        if (GetOwnerPid(expected) != m_myPid) {
+            return;
+        }
+    } while (!ownerPidAndGeneration.compare_exchange_weak(expected, GetGeneration(expected), std::memory_order_release));
+}
+
+std::size_t SharedMemoryBundleArena::ReclaimSlotsOfDeadProcesses() {
+    std::size_t numReclaimed = 0;
+    uint32_t lastRunningPid = m_myPid;
+    uint32_t lastDeadPid = 0;
+    for (uint64_t i = 0; i < m_numSlots; ++i) {
+        std::atomic<uint64_t> & ownerPidAndGeneration = m_slotHeaders[i].ownerPidAndGeneration;
+        uint64_t expected = ownerPidAndGeneration.load(std::memory_order_relaxed);
+        const uint32_t pid = GetOwnerPid(expected);
+        if ((pid == 0) || (pid == lastRunningPid)) {
+            continue;
+        }
+        if (pid != lastDeadPid) {
+            if (IsProcessRunning(pid)) {
+                lastRunningPid = pid;
+                continue;
+            }
+            lastDeadPid = pid;
+        }
+        if (ownerPidAndGeneration.compare_exchange_strong(expected, GetGeneration(expected), std::memory_order_relaxed)) {
+            ++numReclaimed;
+        }
+    }
+    return numReclaimed;
+}
+
+std::size_t SharedMemoryBundleArena::GetNumSlotsInUse() const {
+    std::size_t numInUse = 0;
+    for (uint64_t i = 0; i < m_numSlots; ++i) {
+        numInUse += (GetOwnerPid(m_slotHeaders[i].ownerPidAndGeneration.load(std::memory_order_relaxed)) != 0);
+    }
+    return numInUse;
+}
+
+uint64_t SharedMemoryBundleArena::GetNumSlots() const {
+    return m_numSlots;
+}
+
+uint64_t SharedMemoryBundleArena::GetSlotSizeBytes() const {
+    return m_slotSizeBytes;
+}
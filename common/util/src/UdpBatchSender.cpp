@@ -19,10 +19,34 @@
 #include <memory>
 #include <boost/make_unique.hpp>
 #include <boost/endian/conversion.hpp>
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/uio.h>
+#include <cstring>
+#ifndef UDP_SEGMENT
+# define UDP_SEGMENT 103 //linux/udp.h (kernel 4.18+), not yet in all libc headers
+#endif
+#endif
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::none;
 
-UdpBatchSender::UdpBatchSender() : m_udpSocketConnectedSenderOnly(m_ioService) {}
+#ifndef _WIN32
+//The kernel limits one UDP_SEGMENT send to 64 segments (UDP_MAX_SEGMENTS)
+//and to the max IPv4 UDP payload of 65507 bytes (65535 - 20 byte IP header - 8 byte UDP header).
+static constexpr std::size_t UDP_GSO_MAX_SEGMENTS = 64;
+static constexpr std::size_t UDP_GSO_MAX_PAYLOAD_BYTES = 65507;
+#ifdef UIO_MAXIOV
+static constexpr std::size_t UDP_GSO_MAX_IOVECS = UIO_MAXIOV;
+#else
+static constexpr std::size_t UDP_GSO_MAX_IOVECS = 1024;
+#endif
+static constexpr std::size_t UDP_GSO_CMSG_SPACE_UINT64S = (CMSG_SPACE(sizeof(uint16_t)) + (sizeof(uint64_t) - 1)) / sizeof(uint64_t);
+#endif
+
+UdpBatchSender::UdpBatchSender() :
+    m_udpSocketConnectedSenderOnly(m_ioService),
+    m_useUdpSegmentationOffload(false) {}
 
 UdpBatchSender::~UdpBatchSender() {
     Stop();
@@ -178,6 +202,32 @@ void UdpBatchSender::SetOnSentPacketsCallback(const OnSentPacketsCallback_t& cal
     m_onSentPacketsCallback = callback;
 }
 
+bool UdpBatchSender::SetUseUdpSegmentationOffload(const bool useUdpSegmentationOffload) {
+    if (!useUdpSegmentationOffload) {
+        m_useUdpSegmentationOffload = false;
+        return true;
+    }
+#ifdef _WIN32
+    LOG_WARNING(subprocess) << "UdpBatchSender::SetUseUdpSegmentationOffload: UDP_SEGMENT not supported on Windows";
+    return false;
+#else
+    if (!m_udpSocketConnectedSenderOnly.is_open()) {
+        LOG_ERROR(subprocess) << "UdpBatchSender::SetUseUdpSegmentationOffload: call Init() first";
+        return false;
+    }
+    //probe the kernel for UDP_SEGMENT support (getsockopt returns the socket's default gso size, normally 0)
+    int gsoSize = 0;
+    socklen_t gsoSizeLen = sizeof(gsoSize);
+    if (getsockopt(m_udpSocketConnectedSenderOnly.native_handle(), IPPROTO_UDP, UDP_SEGMENT, &gsoSize, &gsoSizeLen) != 0) {
+        LOG_WARNING(subprocess) << "UdpBatchSender::SetUseUdpSegmentationOffload: UDP_SEGMENT not supported by this kernel (errno " << errno << ")";
+        return false;
+    }
+    m_useUdpSegmentationOffload = true;
+    LOG_INFO(subprocess) << "UdpBatchSender using UDP generic segmentation offload";
+    return true;
+#endif
+}
+
 void UdpBatchSender::QueueSendPacketsOperation_ThreadSafe(
     std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs,
     std::vector<std::shared_ptr<std::vector<std::vector<uint8_t> > > >& underlyingDataToDeleteOnSentCallbackVec,
@@ -196,12 +246,19 @@ void UdpBatchSender::PerformSendPacketsOperation(
 
     m_transmitPacketsElementVec.resize(0); //reserved 100 elements in Init()
     
-
+#ifndef _WIN32
+    bool usedUdpSegmentationOffload = m_useUdpSegmentationOffload; //read once, since it may be changed from another thread
+    if (usedUdpSegmentationOffload) {
+        AppendUdpGsoMessages(constBufferVecs);
+    }
+    else {
+        AppendDatagramMessages(constBufferVecs, 0);
+    }
+#else //_WIN32
     for (std::size_t i = 0; i < constBufferVecs.size(); ++i) {
         std::vector<boost::asio::const_buffer>& currentPacketConstBuffers = constBufferVecs[i];
         const std::size_t currentPacketConstBuffersSize = currentPacketConstBuffers.size();
         if (currentPacketConstBuffersSize) {
-#ifdef _WIN32
             std::size_t j = 0;
             while(true) {
                 m_transmitPacketsElementVec.emplace_back();
@@ -216,49 +273,10 @@ void UdpBatchSender::PerformSendPacketsOperation(
                 }
             }
             m_transmitPacketsElementVec.back().dwElFlags |= TP_ELEMENT_EOP;
-#else //not _WIN32
-            /*
-            the following two data structures are equivalent so a cast will work
-            struct iovec {
-                ptr_t iov_base; // Starting address
-                size_t iov_len; // Length in bytes
-            };
-            class const_buffer
-            {
-            private:
-                const void* data_;
-                std::size_t size_;
-            };
-            */
-            m_transmitPacketsElementVec.emplace_back();
-            struct mmsghdr & mmsgHeader = m_transmitPacketsElementVec.back();
-            /*
-            struct msghdr {
-                void    *   msg_name;   // Socket name
-                int     msg_namelen;    // Length of name
-                struct iovec* msg_iov;    // Data blocks
-                __kernel_size_t msg_iovlen; // Number of blocks
-                void* msg_control;    // Per protocol magic (eg BSD file descriptor passing)
-                __kernel_size_t msg_controllen; // Length of cmsg list
-                unsigned int    msg_flags;
-            };
-        
-            // For recvmmsg/sendmmsg
-            struct mmsghdr {
-                struct msghdr msg_hdr;
-                unsigned int  msg_len; //The msg_len field is used to return the number of
-                                       //bytes sent from the message in msg_hdr (i.e., the same as the
-                                       //return value from a single sendmsg(2) call).
-            };
-            */
-            memset(&mmsgHeader, 0, sizeof(struct mmsghdr));
-            mmsgHeader.msg_hdr.msg_iov = reinterpret_cast<struct iovec*>(currentPacketConstBuffers.data());
-            mmsgHeader.msg_hdr.msg_iovlen = currentPacketConstBuffersSize;
-                
-#endif //#ifdef _WIN32
         }
         else {}
     }
+#endif //#ifndef _WIN32
 
     bool successfulSend = true;
 
@@ -305,32 +323,55 @@ void UdpBatchSender::PerformSendPacketsOperation(
 
 #else //not #ifdef _WIN32
         const int sockfd = m_udpSocketConnectedSenderOnly.native_handle();
-        const unsigned int vlen = static_cast<unsigned int>(m_transmitPacketsElementVec.size());
-
-        
-        //A blocking sendmmsg() call (WHICH THIS IS) blocks until vlen messages have been
-        //sent.  A nonblocking call sends as many messages as possible (up
-        //to the limit specified by vlen) and returns immediately.
-        const int retval = sendmmsg(sockfd, m_transmitPacketsElementVec.data(), vlen, 0);
-
-        //On success, sendmmsg() returns the number of messages sent from
-        //msgvec; if this is less than vlen, the caller can retry with a
-        //further sendmmsg() call to send the remaining messages.
-        //
-        //On error, -1 is returned, and errno is set to indicate the error.
-        if (retval == -1) {
-            successfulSend = false;
-            LOG_ERROR(subprocess) << __FILE__ << ":" << __LINE__ << " - sendmmsg failed with errno " << errno;
-            perror("sendmmsg()");
-        }
-        else if (retval != vlen) {
+        std::size_t numMessagesSent = 0;
+        while (numMessagesSent < m_transmitPacketsElementVec.size()) {
+            const unsigned int vlen = static_cast<unsigned int>(m_transmitPacketsElementVec.size() - numMessagesSent);
+
+            //A blocking sendmmsg() call (WHICH THIS IS) blocks until vlen messages have been
+            //sent.  A nonblocking call sends as many messages as possible (up
+            //to the limit specified by vlen) and returns immediately.
+            const int retval = sendmmsg(sockfd, &m_transmitPacketsElementVec[numMessagesSent], vlen, 0);
+
+            //On success, sendmmsg() returns the number of messages sent from
+            //msgvec; if this is less than vlen, the caller can retry with a
+            //further sendmmsg() call to send the remaining messages
+            //(which reports the error, if any, of the first message not sent).
+            //
+            //On error, -1 is returned, and errno is set to indicate the error.
+            if (retval == -1) {
+                const int errnoValue = errno;
+                if (usedUdpSegmentationOffload && ((errnoValue == EIO) || (errnoValue == EINVAL))) {
+                    //The UDP_SEGMENT setsockopt succeeded but this route/device cannot segment
+                    //(e.g. no checksum offload, xfrm, or a path mtu smaller than the segment size),
+                    //so stop using GSO and send the unsent rest of this batch as individual datagrams.
+                    LOG_WARNING(subprocess) << "UdpBatchSender: UDP GSO send failed with errno " << errnoValue
+                        << ", disabling UDP segmentation offload and resending as individual datagrams";
+                    m_useUdpSegmentationOffload = false;
+                    usedUdpSegmentationOffload = false;
+                    const std::size_t firstUnsentPacketIndex = m_udpGsoFirstPacketIndexVec[numMessagesSent];
+                    m_transmitPacketsElementVec.resize(0);
+                    AppendDatagramMessages(constBufferVecs, firstUnsentPacketIndex);
+                    numMessagesSent = 0;
+                    continue;
+                }
+                successfulSend = false;
+                LOG_ERROR(subprocess) << __FILE__ << ":" << __LINE__ << " - sendmmsg failed with errno " << errnoValue;
+                errno = errnoValue;
+                perror("sendmmsg()");
+                break;
+            }
+            else if (retval == 0) { //not expected of a blocking call, but don't spin
+                successfulSend = false;
+                LOG_ERROR(subprocess) << __FILE__ << ":" << __LINE__ << " - sendmmsg failed by only sending " << numMessagesSent << " out of "
+                    << m_transmitPacketsElementVec.size() << " packets";
+                break;
+            }
             //On return from sendmmsg(), the msg_len fields of successive
             //elements of msgvec are updated to contain the number of bytes
             //transmitted from the corresponding msg_hdr.  The return value of
             //the call indicates the number of elements of msgvec that have
             //been updated.
-            successfulSend = false;
-            LOG_ERROR(subprocess) << __FILE__ << ":" << __LINE__ << " - sendmmsg failed by only sending " << retval << " out of " << vlen << " packets";
+            numMessagesSent += static_cast<std::size_t>(retval);
         }
 
 #endif //#ifdef _WIN32
@@ -341,6 +382,120 @@ void UdpBatchSender::PerformSendPacketsOperation(
     }
 }
 
+#ifndef _WIN32
+void UdpBatchSender::AppendDatagramMessages(std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs, const std::size_t firstPacketIndex) {
+    for (std::size_t i = firstPacketIndex; i < constBufferVecs.size(); ++i) {
+        std::vector<boost::asio::const_buffer>& currentPacketConstBuffers = constBufferVecs[i];
+        const std::size_t currentPacketConstBuffersSize = currentPacketConstBuffers.size();
+        if (currentPacketConstBuffersSize) {
+            /*
+            the following two data structures are equivalent so a cast will work
+            struct iovec {
+                ptr_t iov_base; // Starting address
+                size_t iov_len; // Length in bytes
+            };
+            class const_buffer
+            {
+            private:
+                const void* data_;
+                std::size_t size_;
+            };
+            */
+            m_transmitPacketsElementVec.emplace_back();
+            struct mmsghdr & mmsgHeader = m_transmitPacketsElementVec.back();
+            /*
+            struct msghdr {
+                void    *   msg_name;   // Socket name
+                int     msg_namelen;    // Length of name
+                struct iovec* msg_iov;    // Data blocks
+                __kernel_size_t msg_iovlen; // Number of blocks
+                void* msg_control;    // Per protocol magic (eg BSD file descriptor passing)
+                __kernel_size_t msg_controllen; // Length of cmsg list
+                unsigned int    msg_flags;
+            };
+        
+            // For recvmmsg/sendmmsg
+            struct mmsghdr {
+                struct msghdr msg_hdr;
+                unsigned int  msg_len; //The msg_len field is used to return the number of
+                                       //bytes sent from the message in msg_hdr (i.e., the same as the
+                                       //return value from a single sendmsg(2) call).
+            };
+            */
+            memset(&mmsgHeader, 0, sizeof(struct mmsghdr));
+            mmsgHeader.msg_hdr.msg_iov = reinterpret_cast<struct iovec*>(currentPacketConstBuffers.data());
+            mmsgHeader.msg_hdr.msg_iovlen = currentPacketConstBuffersSize;
+        }
+    }
+}
+
+void UdpBatchSender::AppendUdpGsoMessages(std::vector<std::vector<boost::asio::const_buffer> >& constBufferVecs) {
+    //A GSO send is a run of equal-size segments, optionally followed by one shorter final segment.
+    //LTP data segments from one session share the same size (the data segment mtu) except for
+    //checkpoints and the final segment, so most of a batch collapses into a few messages.
+    std::size_t totalIovecs = 0;
+    for (std::size_t i = 0; i < constBufferVecs.size(); ++i) {
+        totalIovecs += constBufferVecs[i].size();
+    }
+    m_udpGsoIovecsVec.resize(0);
+    m_udpGsoIovecsVec.reserve(totalIovecs); //no reallocation below so msg_iov pointers stay valid
+    m_udpGsoControlMessagesVec.assign(constBufferVecs.size() * UDP_GSO_CMSG_SPACE_UINT64S, 0);
+    m_udpGsoFirstPacketIndexVec.resize(0);
+
+    std::size_t i = 0;
+    while (i < constBufferVecs.size()) {
+        std::vector<boost::asio::const_buffer>& firstPacketConstBuffers = constBufferVecs[i];
+        if (firstPacketConstBuffers.empty()) {
+            ++i;
+            continue;
+        }
+        const std::size_t segmentSize = boost::asio::buffer_size(firstPacketConstBuffers);
+        const std::size_t iovecStartIndex = m_udpGsoIovecsVec.size();
+        m_udpGsoFirstPacketIndexVec.push_back(i);
+        std::size_t numSegments = 0;
+        std::size_t runBytes = 0;
+        while ((i < constBufferVecs.size()) && (numSegments < UDP_GSO_MAX_SEGMENTS)) {
+            std::vector<boost::asio::const_buffer>& currentPacketConstBuffers = constBufferVecs[i];
+            const std::size_t currentPacketSize = boost::asio::buffer_size(currentPacketConstBuffers);
+            if (numSegments && ((currentPacketSize == 0) || (currentPacketSize > segmentSize) || ((runBytes + currentPacketSize) > UDP_GSO_MAX_PAYLOAD_BYTES)
+                || ((m_udpGsoIovecsVec.size() - iovecStartIndex + currentPacketConstBuffers.size()) > UDP_GSO_MAX_IOVECS)))
+            {
+                break; //the first packet always starts a run (even if oversized, in which case it is sent on its own)
+            }
+            for (std::size_t j = 0; j < currentPacketConstBuffers.size(); ++j) {
+                m_udpGsoIovecsVec.emplace_back();
+                struct iovec& iov = m_udpGsoIovecsVec.back();
+                iov.iov_base = const_cast<void*>(currentPacketConstBuffers[j].data());
+                iov.iov_len = currentPacketConstBuffers[j].size();
+            }
+            ++numSegments;
+            runBytes += currentPacketSize;
+            ++i;
+            if (currentPacketSize < segmentSize) { //a shorter segment can only be the last one of a run
+                break;
+            }
+        }
+
+        m_transmitPacketsElementVec.emplace_back();
+        struct mmsghdr& mmsgHeader = m_transmitPacketsElementVec.back();
+        memset(&mmsgHeader, 0, sizeof(struct mmsghdr));
+        mmsgHeader.msg_hdr.msg_iov = &m_udpGsoIovecsVec[iovecStartIndex];
+        mmsgHeader.msg_hdr.msg_iovlen = m_udpGsoIovecsVec.size() - iovecStartIndex;
+        if (numSegments > 1) {
+            uint64_t* const controlBuffer = &m_udpGsoControlMessagesVec[(m_transmitPacketsElementVec.size() - 1) * UDP_GSO_CMSG_SPACE_UINT64S];
+            mmsgHeader.msg_hdr.msg_control = controlBuffer;
+            mmsgHeader.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mmsgHeader.msg_hdr);
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t gsoSize = static_cast<uint16_t>(segmentSize);
+            memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+        }
+    }
+}
+#endif //#ifndef _WIN32
+
 void UdpBatchSender::SetEndpointAndReconnect_ThreadSafe(const boost::asio::ip::udp::endpoint& remoteEndpoint) {
     boost::asio::post(m_ioService, boost::bind(&UdpBatchSender::SetEndpointAndReconnect, this, remoteEndpoint));
 }
@@ -0,0 +1,159 @@
+/**
+ * @file TestBundleRings.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <iostream>
+#include <boost/thread.hpp>
+#include <boost/timer/timer.hpp>
+#include "bundle_rings.hpp"
+
+static hdtn::ToEgressHdr MakeToEgressHdr(const uint64_t custodyId) {
+    hdtn::ToEgressHdr toEgressHdr;
+    memset(&toEgressHdr, 0, sizeof(toEgressHdr));
+    toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+    toEgressHdr.isCutThroughFromIngress = 1;
+    toEgressHdr.custodyId = custodyId;
+    return toEgressHdr;
+}
+
+BOOST_AUTO_TEST_CASE(BundleRingsTestCase)
+{
+    hdtn::OneProcessBundleRings rings(2);
+    hdtn::to_egress_bundle_ring_t& ring = rings.ingressToEgress;
+    hdtn::ToEgressHdr toEgressHdr;
+    zmq::message_t bundle;
+    BOOST_REQUIRE(!hdtn::PopFromBundleRing(ring, toEgressHdr, bundle));
+
+    //only the push into an empty ring needs to wake the consumer
+    bool needsWake = false;
+    const void* bundleDatas[2];
+    for (uint64_t i = 0; i < 2; ++i) {
+        zmq::message_t bundleToPush(100 + i);
+        bundleDatas[i] = bundleToPush.data();
+        BOOST_REQUIRE(hdtn::PushToBundleRing(ring, MakeToEgressHdr(i), bundleToPush, needsWake));
+        BOOST_REQUIRE_EQUAL(needsWake, (i == 0));
+        needsWake = false;
+        BOOST_REQUIRE_EQUAL(bundleToPush.size(), 0); //moved into the ring
+    }
+
+    //full, so the bundle is left with the caller
+    {
+        zmq::message_t bundleToPush(50);
+        BOOST_REQUIRE(!hdtn::PushToBundleRing(ring, MakeToEgressHdr(2), bundleToPush, needsWake));
+        BOOST_REQUIRE(!needsWake);
+        BOOST_REQUIRE_EQUAL(bundleToPush.size(), 50);
+    }
+
+    for (uint64_t i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(hdtn::PopFromBundleRing(ring, toEgressHdr, bundle));
+        BOOST_REQUIRE_EQUAL(toEgressHdr.custodyId, i);
+        BOOST_REQUIRE_EQUAL(bundle.size(), 100 + i);
+        BOOST_REQUIRE(bundle.data() == bundleDatas[i]); //moved, not copied
+    }
+    BOOST_REQUIRE(!hdtn::PopFromBundleRing(ring, toEgressHdr, bundle));
+    BOOST_REQUIRE_EQUAL(ring.Size(), 0);
+
+    //wake messages are distinguishable from the other messages sent over the same socket
+    zmq::context_t ctx(0);
+    zmq::socket_t producerSock(ctx, zmq::socket_type::pair);
+    zmq::socket_t consumerSock(ctx, zmq::socket_type::pair);
+    producerSock.bind("inproc://test_bundle_rings");
+    consumerSock.connect("inproc://test_bundle_rings");
+    BOOST_REQUIRE(hdtn::SendBundleRingWake(producerSock));
+    BOOST_REQUIRE(producerSock.send(zmq::const_buffer(&toEgressHdr, sizeof(toEgressHdr)), zmq::send_flags::dontwait));
+    zmq::message_t message;
+    BOOST_REQUIRE(consumerSock.recv(message, zmq::recv_flags::none));
+    BOOST_REQUIRE(hdtn::IsBundleRingWake(message));
+    BOOST_REQUIRE(consumerSock.recv(message, zmq::recv_flags::none));
+    BOOST_REQUIRE(!hdtn::IsBundleRingWake(message));
+}
+
+//Moves bundles from one thread to another over an inproc zmq pair socket (header and bundle frames, as hdtn-one-process does
+//without bundle rings) and then over a bundle ring (waking the consumer over the same kind of socket), the same number of
+//bundles each way with the same zmq message allocation per bundle.
+BOOST_AUTO_TEST_CASE(BundleRingsBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_BUNDLES = 2000000;
+    static const std::size_t BUNDLE_SIZE_BYTES = 1000;
+    static const unsigned int RING_CAPACITY = 1000; //the default zmq high water mark
+    zmq::context_t ctx(0);
+    double zmqSeconds, ringSeconds;
+    {
+        zmq::socket_t producerSock(ctx, zmq::socket_type::pair);
+        zmq::socket_t consumerSock(ctx, zmq::socket_type::pair);
+        producerSock.bind("inproc://benchmark_zmq_bundles");
+        consumerSock.connect("inproc://benchmark_zmq_bundles");
+        boost::timer::cpu_timer timer;
+        boost::thread producerThread([&producerSock]() {
+            for (uint64_t i = 0; i < NUM_BUNDLES; ++i) {
+                const hdtn::ToEgressHdr toEgressHdr = MakeToEgressHdr(i);
+                producerSock.send(zmq::const_buffer(&toEgressHdr, sizeof(toEgressHdr)), zmq::send_flags::sndmore);
+                producerSock.send(zmq::message_t(BUNDLE_SIZE_BYTES), zmq::send_flags::none);
+            }
+        });
+        hdtn::ToEgressHdr toEgressHdr;
+        zmq::message_t hdrMessage;
+        zmq::message_t bundle;
+        for (uint64_t i = 0; i < NUM_BUNDLES; ++i) {
+            BOOST_REQUIRE(consumerSock.recv(hdrMessage, zmq::recv_flags::none));
+            BOOST_REQUIRE(consumerSock.recv(bundle, zmq::recv_flags::none));
+            memcpy(&toEgressHdr, hdrMessage.data(), sizeof(toEgressHdr));
+            BOOST_REQUIRE_EQUAL(toEgressHdr.custodyId, i);
+        }
+        producerThread.join();
+        zmqSeconds = timer.elapsed().wall * 1e-9;
+    }
+    {
+        hdtn::OneProcessBundleRings rings(RING_CAPACITY);
+        hdtn::to_egress_bundle_ring_t& ring = rings.ingressToEgress;
+        zmq::socket_t producerSock(ctx, zmq::socket_type::pair);
+        zmq::socket_t consumerSock(ctx, zmq::socket_type::pair);
+        producerSock.bind("inproc://benchmark_ring_bundles");
+        consumerSock.connect("inproc://benchmark_ring_bundles");
+        boost::timer::cpu_timer timer;
+        boost::thread producerThread([&ring, &producerSock]() {
+            for (uint64_t i = 0; i < NUM_BUNDLES; ++i) {
+                zmq::message_t bundle(BUNDLE_SIZE_BYTES);
+                bool needsWake = false;
+                while (!hdtn::PushToBundleRing(ring, MakeToEgressHdr(i), bundle, needsWake)) {
+                    boost::this_thread::yield(); //full, as a blocking zmq send would be
+                }
+                if (needsWake) {
+                    hdtn::SendBundleRingWake(producerSock);
+                }
+            }
+        });
+        zmq::pollitem_t pollItems[1] = { {consumerSock.handle(), 0, ZMQ_POLLIN, 0} };
+        hdtn::ToEgressHdr toEgressHdr;
+        zmq::message_t wakeMessage;
+        zmq::message_t bundle;
+        uint64_t numReceived = 0;
+        while (numReceived < NUM_BUNDLES) {
+            if ((zmq::poll(pollItems, 1, 10) > 0) && (pollItems[0].revents & ZMQ_POLLIN)) {
+                BOOST_REQUIRE(consumerSock.recv(wakeMessage, zmq::recv_flags::none));
+                BOOST_REQUIRE(hdtn::IsBundleRingWake(wakeMessage));
+            }
+            while (hdtn::PopFromBundleRing(ring, toEgressHdr, bundle)) {
+                BOOST_REQUIRE_EQUAL(toEgressHdr.custodyId, numReceived);
+                ++numReceived;
+            }
+        }
+        producerThread.join();
+        ringSeconds = timer.elapsed().wall * 1e-9;
+    }
+    std::cout << "moving " << NUM_BUNDLES << " bundles of " << BUNDLE_SIZE_BYTES << " bytes between threads: inproc zmq "
+        << (NUM_BUNDLES / zmqSeconds) * 1e-6 << " Mbundles/s, bundle ring " << (NUM_BUNDLES / ringSeconds) * 1e-6
+        << " Mbundles/s (" << (zmqSeconds / ringSeconds) << "x)" << std::endl;
+}
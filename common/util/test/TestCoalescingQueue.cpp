@@ -0,0 +1,135 @@
+/**
+ * @file TestCoalescingQueue.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <boost/thread.hpp>
+#include "CoalescingQueue.h"
+
+BOOST_AUTO_TEST_CASE(CoalescingQueueTestCase)
+{
+    //single thread: the pusher flushes its own item alone, and items pushed while flushing come out together
+    {
+        CoalescingQueue<std::unique_ptr<int> > q;
+        BOOST_REQUIRE(q.Push(std::unique_ptr<int>(new int(1))));
+        std::vector<std::unique_ptr<int> >* itemsPtr = q.TakeAll();
+        BOOST_REQUIRE(itemsPtr);
+        BOOST_REQUIRE_EQUAL(itemsPtr->size(), 1);
+        BOOST_REQUIRE_EQUAL(*((*itemsPtr)[0]), 1);
+        BOOST_REQUIRE(!q.Push(std::unique_ptr<int>(new int(2)))); //still flushing
+        BOOST_REQUIRE(!q.Push(std::unique_ptr<int>(new int(3))));
+        itemsPtr = q.TakeAll();
+        BOOST_REQUIRE(itemsPtr);
+        BOOST_REQUIRE_EQUAL(itemsPtr->size(), 2);
+        BOOST_REQUIRE_EQUAL(*((*itemsPtr)[0]), 2);
+        BOOST_REQUIRE_EQUAL(*((*itemsPtr)[1]), 3);
+        BOOST_REQUIRE(q.TakeAll() == NULL); //ends the flush
+        BOOST_REQUIRE(q.Push(std::unique_ptr<int>(new int(4))));
+        itemsPtr = q.TakeAll();
+        BOOST_REQUIRE(itemsPtr);
+        BOOST_REQUIRE_EQUAL(itemsPtr->size(), 1);
+        BOOST_REQUIRE(q.TakeAll() == NULL);
+    }
+
+    //max passes per flush: the flusher hands the role back with items left, which the next Push() or TryBeginFlush() takes
+    {
+        CoalescingQueue<int> q(2);
+        BOOST_REQUIRE(!q.TryBeginFlush()); //nothing queued
+        BOOST_REQUIRE(q.Push(1));
+        BOOST_REQUIRE(!q.TryBeginFlush()); //already flushing
+        BOOST_REQUIRE(q.TakeAll());
+        BOOST_REQUIRE(!q.Push(2));
+        BOOST_REQUIRE(q.TakeAll());
+        BOOST_REQUIRE(!q.Push(3));
+        BOOST_REQUIRE(q.TakeAll() == NULL); //max passes reached, with 3 left behind
+        BOOST_REQUIRE(q.TryBeginFlush());
+        std::vector<int>* itemsPtr = q.TakeAll();
+        BOOST_REQUIRE(itemsPtr);
+        BOOST_REQUIRE_EQUAL(itemsPtr->size(), 1);
+        BOOST_REQUIRE_EQUAL((*itemsPtr)[0], 3);
+        BOOST_REQUIRE(q.TakeAll() == NULL);
+        BOOST_REQUIRE(!q.TryBeginFlush());
+
+        BOOST_REQUIRE(q.Push(4));
+        BOOST_REQUIRE(q.TakeAll());
+        BOOST_REQUIRE(!q.Push(5));
+        BOOST_REQUIRE(q.TakeAll());
+        BOOST_REQUIRE(!q.Push(6));
+        BOOST_REQUIRE(q.TakeAll() == NULL); //max passes reached, with 6 left behind
+        BOOST_REQUIRE(q.Push(7)); //the next pusher becomes the flusher and takes 6 too
+        itemsPtr = q.TakeAll();
+        BOOST_REQUIRE(itemsPtr);
+        BOOST_REQUIRE_EQUAL(itemsPtr->size(), 2);
+        BOOST_REQUIRE_EQUAL((*itemsPtr)[0], 6);
+        BOOST_REQUIRE_EQUAL((*itemsPtr)[1], 7);
+        BOOST_REQUIRE(q.TakeAll() == NULL);
+    }
+
+    //many threads: every item is flushed exactly once, by one thread at a time, in per-thread push order
+    //(with a max passes per flush, any items left behind by the last flusher are taken by TryBeginFlush())
+    for (unsigned int maxPassesPerFlush = 0; maxPassesPerFlush <= 3; maxPassesPerFlush += 3) {
+        static constexpr unsigned int NUM_THREADS = 4;
+        static constexpr unsigned int NUM_ITEMS_PER_THREAD = 20000;
+        CoalescingQueue<unsigned int> q(maxPassesPerFlush);
+        std::vector<unsigned int> flushedItems;
+        std::atomic<unsigned int> numFlushers(0); //threads currently flushing
+        std::atomic<bool> flushersOverlapped(false);
+        boost::mutex flushedItemsMutex;
+        std::vector<std::unique_ptr<boost::thread> > threads;
+        for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+            threads.emplace_back(new boost::thread([&, t]() {
+                for (unsigned int i = 0; i < NUM_ITEMS_PER_THREAD; ++i) {
+                    if (q.Push((t * NUM_ITEMS_PER_THREAD) + i)) {
+                        while (std::vector<unsigned int>* itemsPtr = q.TakeAll()) {
+                            if (++numFlushers != 1) {
+                                flushersOverlapped = true;
+                            }
+                            {
+                                boost::mutex::scoped_lock lock(flushedItemsMutex);
+                                flushedItems.insert(flushedItems.end(), itemsPtr->begin(), itemsPtr->end());
+                            }
+                            boost::this_thread::yield(); //give the other threads a chance to push while this one is flushing
+                            --numFlushers;
+                        }
+                    }
+                }
+            }));
+        }
+        for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+            threads[t]->join();
+        }
+        if (q.TryBeginFlush()) {
+            while (std::vector<unsigned int>* itemsPtr = q.TakeAll()) {
+                flushedItems.insert(flushedItems.end(), itemsPtr->begin(), itemsPtr->end());
+            }
+        }
+        BOOST_REQUIRE(!flushersOverlapped);
+        BOOST_REQUIRE_EQUAL(flushedItems.size(), NUM_THREADS * NUM_ITEMS_PER_THREAD);
+        std::vector<unsigned int> nextExpectedItem(NUM_THREADS);
+        for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+            nextExpectedItem[t] = t * NUM_ITEMS_PER_THREAD;
+        }
+        bool inOrder = true;
+        for (std::size_t i = 0; i < flushedItems.size(); ++i) {
+            const unsigned int item = flushedItems[i];
+            unsigned int& expected = nextExpectedItem[item / NUM_ITEMS_PER_THREAD];
+            inOrder &= (item == expected);
+            ++expected;
+        }
+        BOOST_REQUIRE(inOrder);
+        BOOST_REQUIRE(q.TakeAll() == NULL);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file TestMemoryMappedFileBuffer.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include "MemoryMappedFileBuffer.h"
+
+BOOST_AUTO_TEST_CASE(MemoryMappedFileBufferTestCase)
+{
+    const boost::filesystem::path filePath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("MemoryMappedFileBufferTest_%%%%%%%%.bin");
+
+    BOOST_REQUIRE(!MemoryMappedFileBuffer::Create(filePath, 0));
+    BOOST_REQUIRE(!boost::filesystem::exists(filePath));
+    {
+        std::unique_ptr<MemoryMappedFileBuffer> bufPtr = MemoryMappedFileBuffer::Create(filePath, 1000000);
+        BOOST_REQUIRE(bufPtr);
+        BOOST_REQUIRE_EQUAL(bufPtr->size(), 1000000);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 1000000);
+        BOOST_REQUIRE_EQUAL(bufPtr->GetFilePath(), filePath);
+        //zero filled
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[0], 0);
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[999999], 0);
+
+        for (uint64_t i = 0; i < 1000; ++i) {
+            bufPtr->data()[i] = static_cast<uint8_t>(i);
+        }
+        bufPtr->data()[999999] = 0xab;
+
+        //grow preserves contents and zero fills
+        BOOST_REQUIRE(bufPtr->Resize(3000000));
+        BOOST_REQUIRE_EQUAL(bufPtr->size(), 3000000);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 3000000);
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[999999], 0xab);
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[2999999], 0);
+
+        //allocating disk space only within the file, and without changing its contents
+        BOOST_REQUIRE(bufPtr->AllocateDiskSpace(1000000, 2000000));
+        BOOST_REQUIRE(bufPtr->AllocateDiskSpace(0, 0));
+        BOOST_REQUIRE(!bufPtr->AllocateDiskSpace(2999999, 2));
+        BOOST_REQUIRE(!bufPtr->AllocateDiskSpace(3000001, 0));
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 3000000);
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[999999], 0xab);
+        BOOST_REQUIRE_EQUAL(bufPtr->data()[1000000], 0);
+
+        //shrink preserves contents
+        BOOST_REQUIRE(bufPtr->Resize(1000));
+        BOOST_REQUIRE_EQUAL(bufPtr->size(), 1000);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(filePath), 1000);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            BOOST_REQUIRE_EQUAL(bufPtr->data()[i], static_cast<uint8_t>(i));
+        }
+        BOOST_REQUIRE(!bufPtr->Resize(0));
+        BOOST_REQUIRE(bufPtr->Flush());
+    }
+    //deleted on destruction by default
+    BOOST_REQUIRE(!boost::filesystem::exists(filePath));
+
+    //owner takes the file
+    {
+        std::unique_ptr<MemoryMappedFileBuffer> bufPtr = MemoryMappedFileBuffer::Create(filePath, 5);
+        BOOST_REQUIRE(bufPtr);
+        memcpy(bufPtr->data(), "hello", 5);
+        bufPtr->SetDeleteFileOnDestruction(false);
+    }
+    BOOST_REQUIRE(boost::filesystem::exists(filePath));
+    {
+        boost::filesystem::ifstream ifs(filePath, std::ifstream::in | std::ifstream::binary);
+        char contents[6] = { 0 };
+        ifs.read(contents, 5);
+        BOOST_REQUIRE_EQUAL(std::string(contents), "hello");
+    }
+    boost::filesystem::remove(filePath);
+
+    //cannot create a file in a non-existent directory
+    BOOST_REQUIRE(!MemoryMappedFileBuffer::Create(filePath / "nonexistent" / "file.bin", 10));
+}
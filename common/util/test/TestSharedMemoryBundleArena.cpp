@@ -0,0 +1,226 @@
+/**
+ * @file TestSharedMemoryBundleArena.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/timer/timer.hpp>
+#include <boost/lexical_cast.hpp>
+#include "SharedMemoryBundleArena.h"
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+typedef SharedMemoryBundleArena::PROCESS PROCESS;
+
+static std::string GetTestArenaName(const std::string & testName) {
+#ifdef _WIN32
+    return testName;
+#else
+    return testName + boost::lexical_cast<std::string>(getpid()); //unique on the host
+#endif
+}
+
+static zmq::message_t MakeBundle(const std::size_t size, const uint8_t firstByte) {
+    zmq::message_t bundle(size);
+    uint8_t* const data = static_cast<uint8_t*>(bundle.data());
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(firstByte + i);
+    }
+    return bundle;
+}
+
+static zmq::message_t MakeDescriptorMessage(const SharedMemoryBundleArena::Descriptor & descriptor) {
+    return zmq::message_t(&descriptor, sizeof(descriptor));
+}
+
+BOOST_AUTO_TEST_CASE(SharedMemoryBundleArenaTestCase)
+{
+    const std::string arenaName = GetTestArenaName("hdtn_test_arena_");
+    SharedMemoryBundleArena::Remove(arenaName);
+    //two mappings of the same arena, as two processes would have
+    std::unique_ptr<SharedMemoryBundleArena> producerArenaPtr = SharedMemoryBundleArena::Open(arenaName, 4, 1000, PROCESS::INGRESS);
+    BOOST_REQUIRE(producerArenaPtr);
+    std::unique_ptr<SharedMemoryBundleArena> consumerArenaPtr = SharedMemoryBundleArena::Open(arenaName, 4, 1000, PROCESS::EGRESS);
+    BOOST_REQUIRE(consumerArenaPtr);
+    BOOST_REQUIRE(!SharedMemoryBundleArena::Open(arenaName, 5, 1000, PROCESS::STORAGE)); //configurations must agree
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 0);
+
+    //a bundle goes through as a descriptor and comes out of the consumer's mapping without a copy
+    {
+        zmq::context_t ctx(0);
+        zmq::socket_t producerSock(ctx, zmq::socket_type::pair);
+        zmq::socket_t consumerSock(ctx, zmq::socket_type::pair);
+        producerSock.bind("inproc://test_shared_memory_bundle_arena");
+        consumerSock.connect("inproc://test_shared_memory_bundle_arena");
+        const zmq::message_t bundle = MakeBundle(500, 7);
+        SharedMemoryBundleArena::Descriptor descriptor;
+        BOOST_REQUIRE(producerArenaPtr->CopyIn(bundle, descriptor));
+        BOOST_REQUIRE_EQUAL(descriptor.bundleSizeBytes, 500);
+        BOOST_REQUIRE(producerArenaPtr->SendDescriptor(producerSock, descriptor, PROCESS::EGRESS, zmq::send_flags::dontwait));
+        zmq::message_t message;
+        BOOST_REQUIRE(consumerSock.recv(message, zmq::recv_flags::none));
+        BOOST_REQUIRE_EQUAL(message.size(), sizeof(SharedMemoryBundleArena::Descriptor));
+        BOOST_REQUIRE(consumerArenaPtr->DescriptorMessageToBundle(message));
+        BOOST_REQUIRE(message == bundle);
+        BOOST_REQUIRE(message.data() != bundle.data());
+        BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 1);
+        message.rebuild(); //frees the slot
+        BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 0);
+    }
+
+    //too large for a slot
+    {
+        SharedMemoryBundleArena::Descriptor descriptor;
+        BOOST_REQUIRE(!producerArenaPtr->CopyIn(MakeBundle(1001, 0), descriptor));
+        BOOST_REQUIRE(producerArenaPtr->Allocate(1001, descriptor) == NULL);
+    }
+
+    //full
+    {
+        SharedMemoryBundleArena::Descriptor descriptors[4];
+        for (unsigned int i = 0; i < 4; ++i) {
+            BOOST_REQUIRE(producerArenaPtr->Allocate(1000, descriptors[i]) != NULL);
+            for (unsigned int j = 0; j < i; ++j) {
+                BOOST_REQUIRE_NE(descriptors[i].slotIndex, descriptors[j].slotIndex);
+            }
+        }
+        SharedMemoryBundleArena::Descriptor descriptor;
+        BOOST_REQUIRE(producerArenaPtr->Allocate(1, descriptor) == NULL);
+        BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 4);
+        for (unsigned int i = 0; i < 4; ++i) {
+            producerArenaPtr->Free(descriptors[i]);
+        }
+        BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 0);
+    }
+
+    //descriptors of freed (and maybe reallocated) slots are rejected, as are frames that aren't descriptors
+    {
+        SharedMemoryBundleArena::Descriptor descriptor;
+        BOOST_REQUIRE(producerArenaPtr->CopyIn(MakeBundle(10, 0), descriptor));
+        producerArenaPtr->Free(descriptor);
+        zmq::message_t message = MakeDescriptorMessage(descriptor);
+        BOOST_REQUIRE(!consumerArenaPtr->DescriptorMessageToBundle(message));
+        BOOST_REQUIRE_EQUAL(message.size(), sizeof(SharedMemoryBundleArena::Descriptor));
+        for (unsigned int i = 0; i < 4; ++i) {
+            SharedMemoryBundleArena::Descriptor newDescriptor;
+            BOOST_REQUIRE(producerArenaPtr->Allocate(10, newDescriptor) != NULL);
+        }
+        BOOST_REQUIRE(!consumerArenaPtr->DescriptorMessageToBundle(message));
+        zmq::message_t notDescriptorMessage(sizeof(SharedMemoryBundleArena::Descriptor) + 1);
+        BOOST_REQUIRE(!consumerArenaPtr->DescriptorMessageToBundle(notDescriptorMessage));
+    }
+
+    //slots held by this (running) process are never reclaimed
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->ReclaimSlotsOfDeadProcesses(), 0);
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 4);
+    consumerArenaPtr.reset();
+    producerArenaPtr.reset();
+    BOOST_REQUIRE(SharedMemoryBundleArena::Remove(arenaName));
+}
+
+#ifndef _WIN32
+//A child process takes a bundle and dies without freeing its slot, which the parent then reclaims.
+BOOST_AUTO_TEST_CASE(SharedMemoryBundleArenaReclaimTestCase)
+{
+    const std::string arenaName = GetTestArenaName("hdtn_test_arena_reclaim_");
+    SharedMemoryBundleArena::Remove(arenaName);
+    std::unique_ptr<SharedMemoryBundleArena> producerArenaPtr = SharedMemoryBundleArena::Open(arenaName, 2, 100, PROCESS::STORAGE);
+    BOOST_REQUIRE(producerArenaPtr);
+    SharedMemoryBundleArena::Descriptor descriptor;
+    BOOST_REQUIRE(producerArenaPtr->CopyIn(MakeBundle(100, 3), descriptor));
+    const pid_t childPid = fork();
+    BOOST_REQUIRE(childPid >= 0);
+    if (childPid == 0) {
+        std::unique_ptr<SharedMemoryBundleArena> consumerArenaPtr = SharedMemoryBundleArena::Open(arenaName, 2, 100, PROCESS::EGRESS);
+        zmq::message_t message = MakeDescriptorMessage(descriptor);
+        const bool took = consumerArenaPtr && consumerArenaPtr->DescriptorMessageToBundle(message)
+            && (static_cast<const uint8_t*>(message.data())[0] == 3);
+        _exit(took ? 0 : 1); //without freeing the slot
+    }
+    int status = 0;
+    BOOST_REQUIRE_EQUAL(waitpid(childPid, &status, 0), childPid);
+    BOOST_REQUIRE(WIFEXITED(status));
+    BOOST_REQUIRE_EQUAL(WEXITSTATUS(status), 0);
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 1);
+    zmq::message_t message = MakeDescriptorMessage(descriptor);
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->ReclaimSlotsOfDeadProcesses(), 1);
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 0);
+    BOOST_REQUIRE(!producerArenaPtr->DescriptorMessageToBundle(message)); //the dead process's descriptor is stale
+    producerArenaPtr.reset();
+    BOOST_REQUIRE(SharedMemoryBundleArena::Remove(arenaName));
+}
+#endif
+
+//Sends bundles from one thread to another over tcp loopback (as separate hdtn processes do), first as bytes
+//and then as descriptors of a shared memory bundle arena, the consumer reading every bundle once either way.
+BOOST_AUTO_TEST_CASE(SharedMemoryBundleArenaBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_BUNDLES = 50000;
+    static const std::size_t BUNDLE_SIZE_BYTES = 65000;
+    static const uint64_t NUM_SLOTS = 1000;
+    const std::string arenaName = GetTestArenaName("hdtn_benchmark_arena_");
+    SharedMemoryBundleArena::Remove(arenaName);
+    std::unique_ptr<SharedMemoryBundleArena> producerArenaPtr = SharedMemoryBundleArena::Open(arenaName, NUM_SLOTS, BUNDLE_SIZE_BYTES, PROCESS::INGRESS);
+    std::unique_ptr<SharedMemoryBundleArena> consumerArenaPtr = SharedMemoryBundleArena::Open(arenaName, NUM_SLOTS, BUNDLE_SIZE_BYTES, PROCESS::EGRESS);
+    BOOST_REQUIRE(producerArenaPtr && consumerArenaPtr);
+    const zmq::message_t bundle = MakeBundle(BUNDLE_SIZE_BYTES, 0);
+    zmq::context_t ctx;
+    double seconds[2];
+    for (unsigned int useArena = 0; useArena < 2; ++useArena) {
+        zmq::socket_t producerSock(ctx, zmq::socket_type::push);
+        zmq::socket_t consumerSock(ctx, zmq::socket_type::pull);
+        producerSock.bind(std::string("tcp://127.0.0.1:") + boost::lexical_cast<std::string>(10900 + useArena));
+        consumerSock.connect(std::string("tcp://127.0.0.1:") + boost::lexical_cast<std::string>(10900 + useArena));
+        boost::timer::cpu_timer timer;
+        boost::thread producerThread([&]() {
+            for (uint64_t i = 0; i < NUM_BUNDLES; ++i) {
+                SharedMemoryBundleArena::Descriptor descriptor;
+                if (useArena) {
+                    while (!producerArenaPtr->CopyIn(bundle, descriptor)) {
+                        boost::this_thread::yield(); //full
+                    }
+                    producerArenaPtr->SendDescriptor(producerSock, descriptor, PROCESS::EGRESS, zmq::send_flags::none);
+                }
+                else {
+                    producerSock.send(zmq::const_buffer(bundle.data(), bundle.size()), zmq::send_flags::none);
+                }
+            }
+        });
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_BUNDLES; ++i) {
+            zmq::message_t message;
+            BOOST_REQUIRE(consumerSock.recv(message, zmq::recv_flags::none));
+            if (useArena) {
+                BOOST_REQUIRE(consumerArenaPtr->DescriptorMessageToBundle(message));
+            }
+            BOOST_REQUIRE_EQUAL(message.size(), BUNDLE_SIZE_BYTES);
+            sum += static_cast<const uint8_t*>(message.data())[BUNDLE_SIZE_BYTES - 1];
+        }
+        producerThread.join();
+        seconds[useArena] = timer.elapsed().wall * 1e-9;
+        BOOST_REQUIRE_EQUAL(sum, NUM_BUNDLES * static_cast<uint8_t>(BUNDLE_SIZE_BYTES - 1));
+    }
+    BOOST_REQUIRE_EQUAL(producerArenaPtr->GetNumSlotsInUse(), 0);
+    std::cout << "sending " << NUM_BUNDLES << " bundles of " << BUNDLE_SIZE_BYTES << " bytes over tcp loopback: as bytes "
+        << (NUM_BUNDLES * BUNDLE_SIZE_BYTES * 8) / (seconds[0] * 1e9) << " Gbit/s, as shared memory descriptors "
+        << (NUM_BUNDLES * BUNDLE_SIZE_BYTES * 8) / (seconds[1] * 1e9) << " Gbit/s (" << (seconds[0] / seconds[1]) << "x)" << std::endl;
+    consumerArenaPtr.reset();
+    producerArenaPtr.reset();
+    SharedMemoryBundleArena::Remove(arenaName);
+}
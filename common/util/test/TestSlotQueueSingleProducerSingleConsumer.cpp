@@ -0,0 +1,73 @@
+/**
+ * @file TestSlotQueueSingleProducerSingleConsumer.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <vector>
+#include <boost/thread.hpp>
+#include "SlotQueueSingleProducerSingleConsumer.h"
+
+BOOST_AUTO_TEST_CASE(SlotQueueSingleProducerSingleConsumerTestCase)
+{
+    {
+        SlotQueueSingleProducerSingleConsumer<std::vector<uint64_t> > queue(3);
+        BOOST_REQUIRE(queue.GetSlotForRead() == NULL);
+        for (uint64_t i = 0; i < 3; ++i) {
+            std::vector<uint64_t>* slotPtr = queue.GetSlotForWrite(boost::posix_time::milliseconds(0));
+            BOOST_REQUIRE(slotPtr != NULL);
+            slotPtr->assign(1, i);
+            //only the first write into an empty queue needs to wake the consumer
+            BOOST_REQUIRE_EQUAL(queue.CommitWrite(), (i == 0));
+        }
+        BOOST_REQUIRE_EQUAL(queue.Size(), 3);
+        //full
+        BOOST_REQUIRE(queue.GetSlotForWrite(boost::posix_time::milliseconds(10)) == NULL);
+        for (uint64_t i = 0; i < 3; ++i) {
+            std::vector<uint64_t>* slotPtr = queue.GetSlotForRead();
+            BOOST_REQUIRE(slotPtr != NULL);
+            BOOST_REQUIRE_EQUAL(slotPtr->size(), 1);
+            BOOST_REQUIRE_EQUAL((*slotPtr)[0], i);
+            queue.CommitRead();
+        }
+        BOOST_REQUIRE(queue.GetSlotForRead() == NULL);
+        BOOST_REQUIRE_EQUAL(queue.Size(), 0);
+    }
+
+    //a producer blocked on a full queue is woken by the consumer, and messages arrive in order
+    {
+        static const uint64_t NUM_MESSAGES = 100000;
+        SlotQueueSingleProducerSingleConsumer<uint64_t> queue(10);
+        boost::thread producerThread([&queue]() {
+            for (uint64_t i = 0; i < NUM_MESSAGES; ++i) {
+                uint64_t* slotPtr;
+                while ((slotPtr = queue.GetSlotForWrite(boost::posix_time::seconds(1))) == NULL) {}
+                *slotPtr = i;
+                queue.CommitWrite();
+            }
+        });
+        uint64_t expected = 0;
+        while (expected < NUM_MESSAGES) {
+            if (uint64_t* slotPtr = queue.GetSlotForRead()) {
+                BOOST_REQUIRE_EQUAL(*slotPtr, expected);
+                ++expected;
+                queue.CommitRead();
+            }
+            else {
+                boost::this_thread::yield();
+            }
+        }
+        producerThread.join();
+        BOOST_REQUIRE_EQUAL(queue.Size(), 0);
+    }
+}
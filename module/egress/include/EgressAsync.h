@@ -34,13 +34,15 @@
 
 namespace hdtn {
 
+struct OneProcessBundleRings;
 
 class Egress : private boost::noncopyable {
 public:
     EGRESS_ASYNC_LIB_EXPORT Egress();
     EGRESS_ASYNC_LIB_EXPORT ~Egress();
     EGRESS_ASYNC_LIB_EXPORT void Stop();
-    EGRESS_ASYNC_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+    EGRESS_ASYNC_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+        OneProcessBundleRings * hdtnOneProcessBundleRingsPtr = NULL);
 
 private:
 
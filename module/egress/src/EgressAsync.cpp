@@ -25,9 +25,13 @@
 #include <boost/make_unique.hpp>
 #include <boost/date_time.hpp>
 #include "OutductManager.h"
+#include "LtpUdpEngineManager.h"
 #include "Logger.h"
 #include "Uri.h"
 #include "TimestampUtil.h"
+#include "CoalescingQueue.h"
+#include "bundle_rings.hpp"
+#include "SharedMemoryBundleArena.h"
 
 namespace hdtn {
 
@@ -38,11 +42,16 @@ struct Egress::Impl : private boost::noncopyable {
     Impl();
     ~Impl();
     void Stop();
-    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr);
+    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr);
 
 private:
     void RouterEventHandler();
     void ReadZmqThreadFunc();
+    bool ProcessBundle(const hdtn::ToEgressHdr& toEgressHeader, zmq::message_t& zmqMessageBundle, const bool isFromStorage,
+        const std::set<uint64_t>& availableDestOpportunisticNodeIdsSet);
+    void ProcessBundleRing(hdtn::to_egress_bundle_ring_t& ring, const bool isFromStorage,
+        const std::set<uint64_t>& availableDestOpportunisticNodeIdsSet);
+    void SendAckToIngress(const hdtn::EgressAckHdr& egressAck);
     void WholeBundleReadyCallback(padded_vector_uint8_t& wholeBundleVec);
     void OnFailedBundleZmqSendCallback(zmq::message_t& movableBundle, std::vector<uint8_t>& userData, uint64_t outductUuid);
     void OnSuccessfulBundleSendCallback(std::vector<uint8_t>& userData, uint64_t outductUuid);
@@ -60,6 +69,7 @@ private:
     std::unique_ptr<zmq::socket_t> m_zmqPullSock_boundIngressToConnectingEgressPtr;
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_connectingEgressToBoundIngressPtr;
     boost::mutex m_mutex_zmqPushSock_connectingEgressToBoundIngress;
+    CoalescingQueue<hdtn::EgressAckHdr> m_acksToIngressQueue; //acks from the outduct threads, coalesced into batched acks under load
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr;
     std::unique_ptr<zmq::socket_t> m_zmqPullSock_connectingStorageToBoundEgressPtr;
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_boundEgressToConnectingStoragePtr;
@@ -68,6 +78,8 @@ private:
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_boundEgressToConnectingSchedulerPtr;
 
     std::unique_ptr<zmq::socket_t> m_zmqRepSock_connectingGuiToFromBoundEgressPtr;
+    OneProcessBundleRings* m_bundleRingsPtr; //if not NULL, bundles from ingress and storage arrive over these instead of the inproc sockets
+    std::unique_ptr<SharedMemoryBundleArena> m_sharedMemoryBundleArenaPtr; //separate processes only, declared before m_outductManager to outlive the bundles it holds
 
     OutductManager m_outductManager;
     HdtnConfig m_hdtnConfig;
@@ -79,7 +91,7 @@ private:
     volatile bool m_running;
 };
 
-Egress::Impl::Impl() : m_running(false) {
+Egress::Impl::Impl() : m_bundleRingsPtr(NULL), m_running(false) {
     //m_flags = 0;
     //_next = NULL;
 }
@@ -109,10 +121,10 @@ void Egress::Impl::Stop() {
     }
 }
 
-bool Egress::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr) {
-    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr);
+bool Egress::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
+    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr, hdtnOneProcessBundleRingsPtr);
 }
-bool Egress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+bool Egress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
     
     if (m_running) {
         LOG_ERROR(subprocess) << "HegrManagerAsync::Init called while Egress is already running";
@@ -120,7 +132,20 @@ bool Egress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneP
     }
 
     m_hdtnConfig = hdtnConfig;
+    m_bundleRingsPtr = (hdtnOneProcessZmqInprocContextPtr) ? hdtnOneProcessBundleRingsPtr : NULL;
+    if ((!hdtnOneProcessZmqInprocContextPtr) && (!m_hdtnConfig.m_sharedMemoryBundleArenaName.empty())
+        && (m_hdtnConfig.m_sharedMemoryIngressToEgress || m_hdtnConfig.m_sharedMemoryStorageToEgress) && (!m_sharedMemoryBundleArenaPtr))
+    {
+        m_sharedMemoryBundleArenaPtr = SharedMemoryBundleArena::Open(m_hdtnConfig.m_sharedMemoryBundleArenaName,
+            m_hdtnConfig.m_sharedMemoryBundleArenaNumSlots, m_hdtnConfig.m_sharedMemoryBundleArenaSlotSizeBytes, SharedMemoryBundleArena::PROCESS::EGRESS);
+        if (!m_sharedMemoryBundleArenaPtr) {
+            return false;
+        }
+    }
 
+    LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(m_hdtnConfig.m_maxLtpUdpPacketsToReceivePerSystemCall); //before any ltp outducts are created
+    LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(m_hdtnConfig.m_ltpUdpSegmentationOffload);
+    LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(m_hdtnConfig.m_numLtpUdpReceiveThreadsPerPort);
     if (!m_outductManager.LoadOutductsFromConfig(m_hdtnConfig.m_outductsConfig, m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
         boost::bind(&Egress::Impl::WholeBundleReadyCallback, this, boost::placeholders::_1),
         OnFailedBundleVecSendCallback_t(), //egress only sends zmq bundles (not vec8) so this will never be needed
@@ -315,6 +340,79 @@ void Egress::Impl::RouterEventHandler() {
     }
 }
 
+//returns false if storage could not be acked (in which case the remaining received bundles are dropped)
+bool Egress::Impl::ProcessBundle(const hdtn::ToEgressHdr& toEgressHeader, zmq::message_t& zmqMessageBundle, const bool isFromStorage,
+    const std::set<uint64_t>& availableDestOpportunisticNodeIdsSet)
+{
+    m_telemetry.egressBundleData += zmqMessageBundle.size();
+    ++m_telemetry.egressBundleCount;
+
+    const cbhe_eid_t & finalDestEid = toEgressHeader.finalDestEid;
+    //TODO DERMINE IF availableDestOpportunisticNodeIdsSet IS NEEDED
+    if (isFromStorage && (availableDestOpportunisticNodeIdsSet.count(finalDestEid.nodeId) || toEgressHeader.isOpportunisticFromStorage)) { //from storage and opportunistic link available in ingress
+        hdtn::EgressAckHdr * egressAckPtr = new hdtn::EgressAckHdr();
+        //memset 0 not needed because all values set below
+        egressAckPtr->base.type = HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
+        egressAckPtr->base.flags = 0;
+        egressAckPtr->nextHopNodeId = toEgressHeader.nextHopNodeId;
+        egressAckPtr->finalDestEid = finalDestEid;
+        egressAckPtr->error = 0; //can set later before sending this ack if error
+        egressAckPtr->deleteNow = (toEgressHeader.hasCustody == 0);
+        egressAckPtr->isToStorage = 1;
+        egressAckPtr->isResponseToStorageCutThrough = toEgressHeader.isCutThroughFromStorage;
+        egressAckPtr->isOpportunisticFromStorage = toEgressHeader.isOpportunisticFromStorage;
+        egressAckPtr->custodyId = toEgressHeader.custodyId;
+        egressAckPtr->outductIndex = toEgressHeader.outductIndex;
+
+        zmq::message_t messageWithDataStolen(egressAckPtr, sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //storage can be acked right away since bundle transferred
+        {
+            boost::mutex::scoped_lock lock(m_mutex_zmqPushSock_boundEgressToConnectingStorage);
+            if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
+                LOG_ERROR(subprocess) << "m_zmqPushSock_boundEgressToConnectingStoragePtr could not send";
+                return false;
+            }
+            ++m_totalCustodyTransfersSentToStorage;
+        }
+
+        boost::mutex::scoped_lock lock(m_mutexPushBundleToIngress);
+        static const char messageFlags = 0; //0 => from storage and needs no processing
+        static const zmq::const_buffer messageFlagsConstBuf(&messageFlags, sizeof(messageFlags));
+        if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(messageFlagsConstBuf, zmq::send_flags::sndmore)) { //blocks if above 5 high water mark
+            LOG_ERROR(subprocess) << "WholeBundleReadyCallback: zmq could not send messageFlagsConstBuf to ingress";
+        }
+        else if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(std::move(zmqMessageBundle), zmq::send_flags::none)) { //blocks if above 5 high water mark
+            LOG_ERROR(subprocess) << "WholeBundleReadyCallback: zmq could not forward bundle to ingress";
+        }
+    }
+    else if (Outduct * outduct = m_outductManager.GetOutductByFinalDestinationEid_ThreadSafe(finalDestEid)) {
+        std::vector<uint8_t> userData(sizeof(hdtn::EgressAckHdr));
+        hdtn::EgressAckHdr* egressAckPtr = (hdtn::EgressAckHdr*)userData.data();
+        //memset 0 not needed because all values set below
+        egressAckPtr->base.type = (toEgressHeader.isCutThroughFromIngress) ? HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS : HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
+        egressAckPtr->base.flags = 0;
+        egressAckPtr->nextHopNodeId = toEgressHeader.nextHopNodeId;
+        egressAckPtr->finalDestEid = finalDestEid;
+        egressAckPtr->error = 0; //can set later before sending this ack if error
+        egressAckPtr->deleteNow = (toEgressHeader.hasCustody == 0);
+        egressAckPtr->isToStorage = (toEgressHeader.isCutThroughFromIngress == 0);
+        egressAckPtr->isResponseToStorageCutThrough = toEgressHeader.isCutThroughFromStorage;
+        egressAckPtr->isOpportunisticFromStorage = toEgressHeader.isOpportunisticFromStorage;
+        egressAckPtr->custodyId = toEgressHeader.custodyId;
+        egressAckPtr->outductIndex = toEgressHeader.outductIndex;
+        outduct->Forward(zmqMessageBundle, std::move(userData));
+        if (zmqMessageBundle.size() != 0) {
+            LOG_ERROR(subprocess) << "hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved.. bundle shall remain in storage";
+
+            OnFailedBundleZmqSendCallback(zmqMessageBundle, userData, outduct->GetOutductUuid()); //todo is this correct?.. verify userdata not moved
+        }
+    }
+    else {
+        LOG_FATAL(subprocess) << "HegrManagerAsync::ProcessZmqMessagesThreadFunc: no outduct for " 
+            << Uri::GetIpnUriString(finalDestEid.nodeId, finalDestEid.serviceId);
+    }
+    return true;
+}
+
 void Egress::Impl::ReadZmqThreadFunc() {
 
     while (m_running) {
@@ -364,121 +462,81 @@ void Egress::Impl::ReadZmqThreadFunc() {
             LOG_ERROR(subprocess) << "caught zmq::error_t in hdtn::HegrManagerAsync::ReadZmqThreadFunc: " << e.what();
             continue;
         }
+        if ((rc == 0) && m_bundleRingsPtr) { //a wake message is dropped if its socket is full, so also drain the rings on every poll timeout
+            ProcessBundleRing(m_bundleRingsPtr->ingressToEgress, false, availableDestOpportunisticNodeIdsSet);
+            ProcessBundleRing(m_bundleRingsPtr->storageToEgress, true, availableDestOpportunisticNodeIdsSet);
+        }
         if (rc > 0) {
             for (unsigned int itemIndex = 0; itemIndex < 2; ++itemIndex) { //skip m_zmqPullSignalInprocSockPtr in this loop
                 if ((items[itemIndex].revents & ZMQ_POLLIN) == 0) {
                     continue;
                 }
 
-                hdtn::ToEgressHdr toEgressHeader;
-                const zmq::recv_buffer_result_t res = firstTwoSockets[itemIndex]->recv(zmq::mutable_buffer(&toEgressHeader, sizeof(hdtn::ToEgressHdr)), zmq::recv_flags::none);
-                if (!res) {
+                //either a single or (from ingress under load) a batch of HDTN_MSGTYPE_EGRESS headers
+                //(each followed by its bundle frame), or an opportunistic link message
+                zmq::message_t zmqHeadersMessage;
+                if (!firstTwoSockets[itemIndex]->recv(zmqHeadersMessage, zmq::recv_flags::none)) {
                     LOG_ERROR(subprocess) << "HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr";
                     continue;
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::ToEgressHdr))) {
-                    LOG_ERROR(subprocess) << "blockhdr message mismatch: untruncated = " << res->untruncated_size 
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::ToEgressHdr);
-                    continue;
-                }
-                else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK)) {
-                    LOG_INFO(subprocess) << "adding opportunistic link " << toEgressHeader.finalDestEid.nodeId;
-                    availableDestOpportunisticNodeIdsSet.insert(toEgressHeader.finalDestEid.nodeId);
-                    continue;
-                }
-                else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK)) {
-                    LOG_INFO(subprocess) << "removing opportunistic link " << toEgressHeader.finalDestEid.nodeId;
-                    availableDestOpportunisticNodeIdsSet.erase(toEgressHeader.finalDestEid.nodeId);
-                    continue;
-                }
-                else if (toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS) {
-                    LOG_ERROR(subprocess) << "toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS";
-                    continue;
-                }
-                else if ((itemIndex == 1) && (toEgressHeader.isCutThroughFromIngress)) {
-                    LOG_ERROR(subprocess) << "received on storage socket but cut through flag set";
+                const uint8_t* firstToEgressHdrPtr;
+                const uint32_t numToEgressHdrs = hdtn::GetHeadersOfSingleOrBatchMessage<hdtn::ToEgressHdr>(zmqHeadersMessage.data(), zmqHeadersMessage.size(),
+                    HDTN_MSGTYPE_EGRESS, HDTN_MSGTYPE_EGRESS_BATCH, firstToEgressHdrPtr);
+                if ((numToEgressHdrs == 0) && m_bundleRingsPtr && hdtn::IsBundleRingWake(zmqHeadersMessage)) {
+                    ProcessBundleRing((itemIndex == 0) ? m_bundleRingsPtr->ingressToEgress : m_bundleRingsPtr->storageToEgress,
+                        (itemIndex == 1), availableDestOpportunisticNodeIdsSet);
                     continue;
                 }
-                else if ((itemIndex == 0) && (!toEgressHeader.isCutThroughFromIngress)) {
-                    LOG_ERROR(subprocess) << "received on ingress socket but cut through flag not set";
-                    continue;
-                }
-                ++m_telemetry.egressMessageCount;
-                
-                zmq::message_t zmqMessageBundle;
-                //message guaranteed to be there due to the zmq::send_flags::sndmore
-                if (!firstTwoSockets[itemIndex]->recv(zmqMessageBundle, zmq::recv_flags::none)) {
-                    LOG_ERROR(subprocess) << "error on sockets[itemIndex]->recv";
+                if (numToEgressHdrs == 0) {
+                    if (zmqHeadersMessage.size() != sizeof(hdtn::ToEgressHdr)) {
+                        LOG_ERROR(subprocess) << "blockhdr message mismatch: size = " << zmqHeadersMessage.size()
+                            << " expected = " << sizeof(hdtn::ToEgressHdr);
+                        continue;
+                    }
+                    hdtn::ToEgressHdr toEgressHeader;
+                    memcpy(&toEgressHeader, zmqHeadersMessage.data(), sizeof(hdtn::ToEgressHdr));
+                    if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK)) {
+                        LOG_INFO(subprocess) << "adding opportunistic link " << toEgressHeader.finalDestEid.nodeId;
+                        availableDestOpportunisticNodeIdsSet.insert(toEgressHeader.finalDestEid.nodeId);
+                    }
+                    else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK)) {
+                        LOG_INFO(subprocess) << "removing opportunistic link " << toEgressHeader.finalDestEid.nodeId;
+                        availableDestOpportunisticNodeIdsSet.erase(toEgressHeader.finalDestEid.nodeId);
+                    }
+                    else {
+                        LOG_ERROR(subprocess) << "toEgressHeader.base.type != HDTN_MSGTYPE_EGRESS";
+                    }
                     continue;
                 }
-                       
-                m_telemetry.egressBundleData += zmqMessageBundle.size();
-                ++m_telemetry.egressBundleCount;
-
-                const cbhe_eid_t & finalDestEid = toEgressHeader.finalDestEid;
-                //TODO DERMINE IF availableDestOpportunisticNodeIdsSet IS NEEDED
-                if ((itemIndex == 1) && (availableDestOpportunisticNodeIdsSet.count(finalDestEid.nodeId) || toEgressHeader.isOpportunisticFromStorage)) { //from storage and opportunistic link available in ingress
-                    hdtn::EgressAckHdr * egressAckPtr = new hdtn::EgressAckHdr();
-                    //memset 0 not needed because all values set below
-                    egressAckPtr->base.type = HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
-                    egressAckPtr->base.flags = 0;
-                    egressAckPtr->nextHopNodeId = toEgressHeader.nextHopNodeId;
-                    egressAckPtr->finalDestEid = finalDestEid;
-                    egressAckPtr->error = 0; //can set later before sending this ack if error
-                    egressAckPtr->deleteNow = (toEgressHeader.hasCustody == 0);
-                    egressAckPtr->isToStorage = 1;
-                    egressAckPtr->isResponseToStorageCutThrough = toEgressHeader.isCutThroughFromStorage;
-                    egressAckPtr->isOpportunisticFromStorage = toEgressHeader.isOpportunisticFromStorage;
-                    egressAckPtr->custodyId = toEgressHeader.custodyId;
-                    egressAckPtr->outductIndex = toEgressHeader.outductIndex;
-
-                    zmq::message_t messageWithDataStolen(egressAckPtr, sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //storage can be acked right away since bundle transferred
-                    {
-                        boost::mutex::scoped_lock lock(m_mutex_zmqPushSock_boundEgressToConnectingStorage);
-                        if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                            LOG_ERROR(subprocess) << "m_zmqPushSock_boundEgressToConnectingStoragePtr could not send";
-                            break;
+                for (uint32_t i = 0; i < numToEgressHdrs; ++i) {
+                    hdtn::ToEgressHdr toEgressHeader;
+                    memcpy(&toEgressHeader, firstToEgressHdrPtr + (i * sizeof(hdtn::ToEgressHdr)), sizeof(hdtn::ToEgressHdr));
+                    zmq::message_t zmqMessageBundle;
+                    //message guaranteed to be there due to the zmq::send_flags::sndmore
+                    if (!firstTwoSockets[itemIndex]->recv(zmqMessageBundle, zmq::recv_flags::none)) {
+                        LOG_ERROR(subprocess) << "error on sockets[itemIndex]->recv";
+                        break;
+                    }
+                    if (toEgressHeader.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) { //the frame is a descriptor of the bundle in the arena
+                        if ((!m_sharedMemoryBundleArenaPtr) || (!m_sharedMemoryBundleArenaPtr->DescriptorMessageToBundle(zmqMessageBundle))) {
+                            LOG_ERROR(subprocess) << "cannot get bundle from the shared memory bundle arena, this bundle will be lost";
+                            continue;
                         }
-                        ++m_totalCustodyTransfersSentToStorage;
+                        toEgressHeader.base.flags &= ~HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
                     }
-
-                    boost::mutex::scoped_lock lock(m_mutexPushBundleToIngress);
-                    static const char messageFlags = 0; //0 => from storage and needs no processing
-                    static const zmq::const_buffer messageFlagsConstBuf(&messageFlags, sizeof(messageFlags));
-                    if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(messageFlagsConstBuf, zmq::send_flags::sndmore)) { //blocks if above 5 high water mark
-                        LOG_ERROR(subprocess) << "WholeBundleReadyCallback: zmq could not send messageFlagsConstBuf to ingress";
+                    if ((itemIndex == 1) && (toEgressHeader.isCutThroughFromIngress)) {
+                        LOG_ERROR(subprocess) << "received on storage socket but cut through flag set";
+                        continue;
                     }
-                    else if (!m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->send(std::move(zmqMessageBundle), zmq::send_flags::none)) { //blocks if above 5 high water mark
-                        LOG_ERROR(subprocess) << "WholeBundleReadyCallback: zmq could not forward bundle to ingress";
+                    else if ((itemIndex == 0) && (!toEgressHeader.isCutThroughFromIngress)) {
+                        LOG_ERROR(subprocess) << "received on ingress socket but cut through flag not set";
+                        continue;
                     }
-                }
-                else if (Outduct * outduct = m_outductManager.GetOutductByFinalDestinationEid_ThreadSafe(finalDestEid)) {
-                    std::vector<uint8_t> userData(sizeof(hdtn::EgressAckHdr));
-                    hdtn::EgressAckHdr* egressAckPtr = (hdtn::EgressAckHdr*)userData.data();
-                    //memset 0 not needed because all values set below
-                    egressAckPtr->base.type = (toEgressHeader.isCutThroughFromIngress) ? HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS : HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
-                    egressAckPtr->base.flags = 0;
-                    egressAckPtr->nextHopNodeId = toEgressHeader.nextHopNodeId;
-                    egressAckPtr->finalDestEid = finalDestEid;
-                    egressAckPtr->error = 0; //can set later before sending this ack if error
-                    egressAckPtr->deleteNow = (toEgressHeader.hasCustody == 0);
-                    egressAckPtr->isToStorage = (toEgressHeader.isCutThroughFromIngress == 0);
-                    egressAckPtr->isResponseToStorageCutThrough = toEgressHeader.isCutThroughFromStorage;
-                    egressAckPtr->isOpportunisticFromStorage = toEgressHeader.isOpportunisticFromStorage;
-                    egressAckPtr->custodyId = toEgressHeader.custodyId;
-                    egressAckPtr->outductIndex = toEgressHeader.outductIndex;
-                    outduct->Forward(zmqMessageBundle, std::move(userData));
-                    if (zmqMessageBundle.size() != 0) {
-                        LOG_ERROR(subprocess) << "hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved.. bundle shall remain in storage";
-
-                        OnFailedBundleZmqSendCallback(zmqMessageBundle, userData, outduct->GetOutductUuid()); //todo is this correct?.. verify userdata not moved
+                    ++m_telemetry.egressMessageCount;
+                    if (!ProcessBundle(toEgressHeader, zmqMessageBundle, (itemIndex == 1), availableDestOpportunisticNodeIdsSet)) {
+                        break;
                     }
                 }
-                else {
-                    LOG_FATAL(subprocess) << "HegrManagerAsync::ProcessZmqMessagesThreadFunc: no outduct for " 
-                        << Uri::GetIpnUriString(finalDestEid.nodeId, finalDestEid.serviceId);
-                }
-
             }
 
             if (items[2].revents & ZMQ_POLLIN) { //events from Router
@@ -534,6 +592,18 @@ void Egress::Impl::ReadZmqThreadFunc() {
     LOG_DEBUG(subprocess) << "m_totalCustodyTransfersSentToIngress: " << m_totalCustodyTransfersSentToIngress;
 }
 
+//bundles in a ring were sent by the ring's only producer, so unlike bundles received on a socket they need no cut-through flag check
+void Egress::Impl::ProcessBundleRing(hdtn::to_egress_bundle_ring_t& ring, const bool isFromStorage,
+    const std::set<uint64_t>& availableDestOpportunisticNodeIdsSet)
+{
+    hdtn::ToEgressHdr toEgressHeader;
+    zmq::message_t zmqMessageBundle;
+    while (hdtn::PopFromBundleRing(ring, toEgressHeader, zmqMessageBundle)) {
+        ++m_telemetry.egressMessageCount;
+        ProcessBundle(toEgressHeader, zmqMessageBundle, isFromStorage, availableDestOpportunisticNodeIdsSet);
+    }
+}
+
 void Egress::Impl::ResendOutductCapabilities() {
     AllOutductCapabilitiesTelemetry_t allOutductCapabilitiesTelemetry;
     m_outductManager.GetAllOutductCapabilitiesTelemetry_ThreadSafe(allOutductCapabilitiesTelemetry);
@@ -658,13 +728,7 @@ void Egress::Impl::OnFailedBundleZmqSendCallback(zmq::message_t& movableBundle,
         
         
         //send ack message to ingress
-        {
-            boost::mutex::scoped_lock lock(m_mutex_zmqPushSock_connectingEgressToBoundIngress);
-            if (!m_zmqPushSock_connectingEgressToBoundIngressPtr->send(std::move(zmqUserDataMessageWithDataStolen), zmq::send_flags::dontwait)) {
-                LOG_ERROR(subprocess) << "zmq could not send ingress an ack from egress";
-            }
-            ++m_totalCustodyTransfersSentToIngress;
-        }
+        SendAckToIngress(*egressAckPtr);
 
         //Send HDTN_MSGTYPE_EGRESS_FAILED_BUNDLE_TO_STORAGE message plus the bundle to storage.
         hdtn::EgressAckHdr* egressAckPtr = new hdtn::EgressAckHdr();
@@ -719,11 +783,33 @@ void Egress::Impl::OnSuccessfulBundleSendCallback(std::vector<uint8_t>& userData
     }
     else {
         //send ack message by echoing back the block
+        SendAckToIngress(*egressAckPtr);
+    }
+}
+
+//Called from the outduct threads.  The thread whose ack finds no send in progress sends it right away as a single ack;
+//acks arriving from other threads while it sends go to ingress together as one batched ack message.
+void Egress::Impl::SendAckToIngress(const hdtn::EgressAckHdr & egressAck) {
+    if (!m_acksToIngressQueue.Push(hdtn::EgressAckHdr(egressAck))) {
+        return; //another thread is sending and will send this ack
+    }
+    while (std::vector<hdtn::EgressAckHdr>* acksPtr = m_acksToIngressQueue.TakeAll()) {
+        const std::vector<hdtn::EgressAckHdr>& acks = *acksPtr;
+        zmq::message_t zmqAckMessage;
+        if (acks.size() == 1) {
+            zmqAckMessage.rebuild(&acks[0], sizeof(hdtn::EgressAckHdr));
+        }
+        else {
+            const std::size_t acksSize = acks.size() * sizeof(hdtn::EgressAckHdr);
+            zmqAckMessage.rebuild(sizeof(hdtn::BatchHdr) + acksSize);
+            memcpy(hdtn::WriteBatchHdr(zmqAckMessage.data(), HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS, static_cast<uint32_t>(acks.size())),
+                acks.data(), acksSize);
+        }
         boost::mutex::scoped_lock lock(m_mutex_zmqPushSock_connectingEgressToBoundIngress);
-        if (!m_zmqPushSock_connectingEgressToBoundIngressPtr->send(std::move(zmqUserDataMessageWithDataStolen), zmq::send_flags::dontwait)) {
-            LOG_ERROR(subprocess) << "zmq could not send ingress an ack from egress";
+        if (!m_zmqPushSock_connectingEgressToBoundIngressPtr->send(std::move(zmqAckMessage), zmq::send_flags::dontwait)) {
+            LOG_ERROR(subprocess) << "zmq could not send ingress " << acks.size() << " acks from egress";
         }
-        ++m_totalCustodyTransfersSentToIngress;
+        m_totalCustodyTransfersSentToIngress += acks.size();
     }
 }
 void Egress::Impl::OnOutductLinkStatusChangedCallback(bool isLinkDownEvent, uint64_t outductUuid) {
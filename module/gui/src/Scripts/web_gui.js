@@ -197,8 +197,26 @@ window.addEventListener("load", function(event){
                 var totalBundlesErasedFromStorage = dv.getUint64(byteIndex, littleEndian);
                 byteIndex += 8;
                 var totalBundlesSentToEgressFromStorage = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var totalBundlesExpiredFromStorage = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var totalBytesReclaimedFromExpiredBundles = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var hotTierHits = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var hotTierMisses = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var hotTierEvictions = dv.getUint64(byteIndex, littleEndian);
+                byteIndex += 8;
+                var hotTierWriteBacksCancelled = dv.getUint64(byteIndex, littleEndian);
                 document.getElementById("totalBundlesErasedFromStorage").innerHTML = totalBundlesErasedFromStorage;
                 document.getElementById("totalBundlesSentToEgressFromStorage").innerHTML = totalBundlesSentToEgressFromStorage;
+                document.getElementById("totalBundlesExpiredFromStorage").innerHTML = totalBundlesExpiredFromStorage;
+                document.getElementById("totalBytesReclaimedFromExpiredBundles").innerHTML = totalBytesReclaimedFromExpiredBundles;
+                document.getElementById("hotTierHits").innerHTML = hotTierHits;
+                document.getElementById("hotTierMisses").innerHTML = hotTierMisses;
+                document.getElementById("hotTierEvictions").innerHTML = hotTierEvictions;
+                document.getElementById("hotTierWriteBacksCancelled").innerHTML = hotTierWriteBacksCancelled;
             }
 
 
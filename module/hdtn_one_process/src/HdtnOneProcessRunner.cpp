@@ -24,6 +24,7 @@
 #include <iostream>
 #include "Logger.h"
 #include "message.hpp"
+#include "bundle_rings.hpp"
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <boost/lexical_cast.hpp>
@@ -130,23 +131,30 @@ bool HdtnOneProcessRunner::Run(int argc, const char* const argv[], volatile bool
         //If your application is using only the inproc transport for messaging you may set this to zero, otherwise set it to at least one.     
         std::unique_ptr<zmq::context_t> hdtnOneProcessZmqInprocContextPtr = boost::make_unique<zmq::context_t>(0);// 0 Threads
 
+        //optionally move bundles between the modules over rings instead of the inproc sockets (must outlive the modules)
+        std::unique_ptr<hdtn::OneProcessBundleRings> bundleRingsPtr;
+        if (hdtnConfig->m_oneProcessBundleRingCapacity) {
+            LOG_INFO(subprocess) << "using bundle rings of capacity " << hdtnConfig->m_oneProcessBundleRingCapacity << " between modules";
+            bundleRingsPtr = boost::make_unique<hdtn::OneProcessBundleRings>(static_cast<unsigned int>(hdtnConfig->m_oneProcessBundleRingCapacity));
+        }
+
         LOG_INFO(subprocess) << "starting EgressAsync..";
 
         //No need to create Egress, Ingress, and Storage on heap with unique_ptr to prevent stack overflows because they use the pimpl pattern
         hdtn::Egress egress;
-        if (!egress.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get())) {
+        if (!egress.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get(), bundleRingsPtr.get())) {
             return false;
         }
 
         LOG_INFO(subprocess) << "starting ingress..";
         hdtn::Ingress ingress;
-        if (!ingress.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get())) {
+        if (!ingress.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get(), bundleRingsPtr.get())) {
             return false;
         }
 
         ZmqStorageInterface storage;
         LOG_INFO(subprocess) << "Initializing storage manager ...";
-        if (!storage.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get())) {
+        if (!storage.Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get(), bundleRingsPtr.get())) {
             return false;
         }
 
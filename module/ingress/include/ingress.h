@@ -32,13 +32,15 @@
 
 namespace hdtn {
 
+struct OneProcessBundleRings;
 
 class Ingress : private boost::noncopyable {
 public:
     INGRESS_ASYNC_LIB_EXPORT Ingress();  // initialize message buffers
     INGRESS_ASYNC_LIB_EXPORT ~Ingress();
     INGRESS_ASYNC_LIB_EXPORT void Stop();
-    INGRESS_ASYNC_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+    INGRESS_ASYNC_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+        OneProcessBundleRings * hdtnOneProcessBundleRingsPtr = NULL);
 private:
 
     // Internal implementation class
@@ -34,7 +34,11 @@
 #include "codec/BundleViewV7.h"
 #include "TcpclInduct.h"
 #include "TcpclV4Induct.h"
+#include "LtpUdpEngineManager.h"
 #include "Telemetry.h"
+#include "CoalescingQueue.h"
+#include "bundle_rings.hpp"
+#include "SharedMemoryBundleArena.h"
 #include <unordered_map>
 #if (__cplusplus >= 201703L)
 #include <shared_mutex>
@@ -44,13 +48,17 @@ namespace hdtn {
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::ingress;
 static constexpr uint64_t STORAGE_MAX_BUNDLES_IN_PIPELINE = 5;//"zmq-path-to-storage" up to zmqMaxMessageSizeBytes or 5 bundles,
+//with processing workers, each induct may have up to this many received bundles (of up to maxBundleSizeBytes each) waiting for its worker
+static constexpr unsigned int INDUCT_TO_PROCESSING_WORKER_QUEUE_CAPACITY = 5;
+//an induct thread that became the flusher of the bundles to egress or storage sends at most this many batches before returning to its own bundles
+static constexpr unsigned int MAX_BUNDLE_FLUSH_PASSES_PER_CALL = 8;
 
 struct Ingress::Impl : private boost::noncopyable {
 
     Impl();
     ~Impl();
     void Stop();
-    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr);
+    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr);
 
 private:
     void ReadZmqAcksThreadFunc();
@@ -58,8 +66,18 @@ private:
     bool ProcessPaddedData(uint8_t* bundleDataBegin, std::size_t bundleCurrentSize,
         std::unique_ptr<zmq::message_t>& zmqPaddedMessageUnderlyingDataUniquePtr, padded_vector_uint8_t& paddedVecMessageUnderlyingData,
         const bool usingZmqData, const bool needsProcessing);
+    void SendBundleToStorage(zmq::message_t& bundle, const uint64_t fromIngressUniqueId, uint64_t outductIndex,
+        const bool reservedStorageCutThroughPipelineAvailability, const bool isCustodyOrAdminRecord, const cbhe_eid_t& finalDestEid);
+    void FlushBundlesToEgress();
+    void FlushBundlesToStorage();
     void ReadTcpclOpportunisticBundlesFromEgressThreadFunc();
     void WholeBundleReadyCallback(padded_vector_uint8_t& wholeBundleVec);
+    void WholeBundleReadyToProcessingWorkerCallback(padded_vector_uint8_t& wholeBundleVec, const std::size_t inductIndex);
+    void StartProcessingWorkers();
+    void StopProcessingWorkers();
+    void LoadInducts();
+    struct ProcessingWorker;
+    void ProcessingWorkerThreadFunc(ProcessingWorker* workerPtr);
     void OnNewOpportunisticLinkCallback(const uint64_t remoteNodeId, Induct* thisInductPtr);
     void OnDeletedOpportunisticLinkCallback(const uint64_t remoteNodeId);
     void SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable);
@@ -104,6 +122,24 @@ private:
         bool m_linkIsUp;
     };
     typedef std::unique_ptr<BundlePipelineAckingSet> BundlePipelineAckingSetPtr;
+    //received bundles of one induct waiting for the one processing worker that serves that induct
+    struct InductBundleQueue : private boost::noncopyable {
+        InductBundleQueue(ProcessingWorker* paramWorkerPtr) : m_queue(INDUCT_TO_PROCESSING_WORKER_QUEUE_CAPACITY), m_workerPtr(paramWorkerPtr) {}
+        SlotQueueSingleProducerSingleConsumer<padded_vector_uint8_t> m_queue;
+        boost::mutex m_producerMutex; //an induct may deliver bundles from more than one thread (e.g. one per tcpcl connection)
+        ProcessingWorker* const m_workerPtr;
+    };
+    struct ProcessingWorker : private boost::noncopyable {
+        ProcessingWorker() : m_wakeRequested(false) {}
+        std::vector<InductBundleQueue*> m_inductBundleQueues;
+        std::unique_ptr<boost::thread> m_threadPtr;
+        boost::mutex m_mutex;
+        boost::condition_variable m_conditionVariable;
+        bool m_wakeRequested;
+    };
+    //a bundle waiting to be sent to egress or storage, batched with others queued by other threads meanwhile
+    typedef hdtn::BundleHandle<hdtn::ToEgressHdr> queued_bundle_to_egress_t;
+    typedef hdtn::BundleHandle<hdtn::ToStorageHdr> queued_bundle_to_storage_t;
 
     std::unique_ptr<zmq::context_t> m_zmqCtxPtr;
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_boundIngressToConnectingEgressPtr;
@@ -114,6 +150,10 @@ private:
     std::unique_ptr<zmq::socket_t> m_zmqSubSock_boundSchedulerToConnectingIngressPtr;
 
     std::unique_ptr<zmq::socket_t> m_zmqRepSock_connectingGuiToFromBoundIngressPtr;
+    OneProcessBundleRings* m_bundleRingsPtr; //if not NULL, bundles go to egress and storage over these instead of the inproc sockets
+    std::unique_ptr<SharedMemoryBundleArena> m_sharedMemoryBundleArenaPtr; //separate processes only
+    SharedMemoryBundleArena* m_sharedMemoryToEgressArenaPtr; //if not NULL, bundles to egress that fit in a slot are sent as descriptors of this arena
+    SharedMemoryBundleArena* m_sharedMemoryToStorageArenaPtr; //if not NULL, bundles to storage that fit in a slot are sent as descriptors of this arena
 
     //std::shared_ptr<zmq::context_t> m_zmqTelemCtx;
     //std::shared_ptr<zmq::socket_t> m_zmqTelemSock;
@@ -146,6 +186,10 @@ private:
 
     boost::mutex m_ingressToEgressZmqSocketMutex;
     boost::mutex m_ingressToStorageZmqSocketMutex;
+    CoalescingQueue<queued_bundle_to_egress_t> m_bundlesToEgressQueue;
+    CoalescingQueue<queued_bundle_to_storage_t> m_bundlesToStorageQueue;
+    std::vector<SharedMemoryBundleArena::Descriptor> m_descriptorsToEgress; //protected by m_ingressToEgressZmqSocketMutex
+    std::vector<SharedMemoryBundleArena::Descriptor> m_descriptorsToStorage; //protected by m_ingressToStorageZmqSocketMutex
     std::size_t m_eventsTooManyInStorageCutThroughQueue;
     std::size_t m_eventsTooManyInEgressCutThroughQueue;
     std::size_t m_eventsTooManyInAllCutThroughQueues;
@@ -155,6 +199,11 @@ private:
 
     std::map<uint64_t, Induct*> m_availableDestOpportunisticNodeIdToTcpclInductMap;
     boost::mutex m_availableDestOpportunisticNodeIdToTcpclInductMapMutex;
+
+    //if not empty, bundles from inducts are processed by these workers instead of on the induct threads
+    std::vector<std::unique_ptr<ProcessingWorker> > m_processingWorkers;
+    std::vector<std::unique_ptr<InductBundleQueue> > m_inductBundleQueues; //one per induct, in config order
+    volatile bool m_processingWorkersRunning;
 };
 
 Ingress::Impl::BundlePipelineAckingSet::BundlePipelineAckingSet(const uint64_t paramMaxBundlesInPipeline,
@@ -259,13 +308,19 @@ Ingress::Impl::Impl() :
     m_bundleCount(0),
     m_bundleData(0),
     m_elapsed(0),
+    m_bundleRingsPtr(NULL),
+    m_sharedMemoryToEgressArenaPtr(NULL),
+    m_sharedMemoryToStorageArenaPtr(NULL),
     m_singleStorageBundlePipelineAckingSet(10, 10, UINT64_MAX, false), //initial don't cares for a deleted default constructor, set later
+    m_bundlesToEgressQueue(MAX_BUNDLE_FLUSH_PASSES_PER_CALL),
+    m_bundlesToStorageQueue(MAX_BUNDLE_FLUSH_PASSES_PER_CALL),
     m_eventsTooManyInStorageCutThroughQueue(0),
     m_eventsTooManyInEgressCutThroughQueue(0),
     m_eventsTooManyInAllCutThroughQueues(0),
     m_running(false),
     m_egressFullyInitialized(false),
-    m_nextBundleUniqueIdAtomic(0) {}
+    m_nextBundleUniqueIdAtomic(0),
+    m_processingWorkersRunning(false) {}
 
 Ingress::Ingress() :
     m_pimpl(boost::make_unique<Ingress::Impl>()),
@@ -291,6 +346,7 @@ void Ingress::Stop() {
 }
 void Ingress::Impl::Stop() {
     m_inductManager.Clear();
+    StopProcessingWorkers(); //after the inducts (which may be waiting on a full queue) and before the ack reader (which the workers may be waiting on)
 
 
     m_running = false; //thread stopping criteria
@@ -310,10 +366,10 @@ void Ingress::Impl::Stop() {
     LOG_DEBUG(subprocess) << "m_eventsTooManyInAllCutThroughQueues: " << m_eventsTooManyInAllCutThroughQueues;
 }
 
-bool Ingress::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr) {
-    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr);
+bool Ingress::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
+    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr, hdtnOneProcessBundleRingsPtr);
 }
-bool Ingress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+bool Ingress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr, OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
 
     if (!m_running) {
         m_running = true;
@@ -329,6 +385,7 @@ bool Ingress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOne
         M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION = boost::posix_time::milliseconds(m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds);
 
         m_zmqCtxPtr = boost::make_unique<zmq::context_t>(); //needed at least by scheduler (and if one-process is not used)
+        m_bundleRingsPtr = (hdtnOneProcessZmqInprocContextPtr) ? hdtnOneProcessBundleRingsPtr : NULL;
         try {
             if (hdtnOneProcessZmqInprocContextPtr) {
 
@@ -393,6 +450,17 @@ bool Ingress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOne
             LOG_ERROR(subprocess) << "cannot connect bind zmq socket: " << ex.what();
             return false;
         }
+        if ((!hdtnOneProcessZmqInprocContextPtr) && (!m_hdtnConfig.m_sharedMemoryBundleArenaName.empty())
+            && (m_hdtnConfig.m_sharedMemoryIngressToEgress || m_hdtnConfig.m_sharedMemoryIngressToStorage))
+        {
+            m_sharedMemoryBundleArenaPtr = SharedMemoryBundleArena::Open(m_hdtnConfig.m_sharedMemoryBundleArenaName,
+                m_hdtnConfig.m_sharedMemoryBundleArenaNumSlots, m_hdtnConfig.m_sharedMemoryBundleArenaSlotSizeBytes, SharedMemoryBundleArena::PROCESS::INGRESS);
+            if (!m_sharedMemoryBundleArenaPtr) {
+                return false;
+            }
+            m_sharedMemoryToEgressArenaPtr = (m_hdtnConfig.m_sharedMemoryIngressToEgress) ? m_sharedMemoryBundleArenaPtr.get() : NULL;
+            m_sharedMemoryToStorageArenaPtr = (m_hdtnConfig.m_sharedMemoryIngressToStorage) ? m_sharedMemoryBundleArenaPtr.get() : NULL;
+        }
 
         //Caution: All options, with the exception of ZMQ_SUBSCRIBE, ZMQ_UNSUBSCRIBE and ZMQ_LINGER, only take effect for subsequent socket bind/connects.
         //The value of 0 specifies no linger period. Pending messages shall be discarded immediately when the socket is closed with zmq_close().
@@ -442,6 +510,13 @@ bool Ingress::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOne
 }
 
 
+//caller ensures message holds at least a CommonHdr
+static uint16_t GetCommonHdrType(const zmq::message_t & message) {
+    hdtn::CommonHdr commonHdr;
+    memcpy(&commonHdr, message.data(), sizeof(hdtn::CommonHdr));
+    return commonHdr.type;
+}
+
 void Ingress::Impl::ReadZmqAcksThreadFunc() {
 
     static constexpr unsigned int NUM_SOCKETS = 4;
@@ -458,6 +533,16 @@ void Ingress::Impl::ReadZmqAcksThreadFunc() {
     static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
 
     while (m_running) { //keep thread alive if running
+        {
+            //send any bundles left queued by a flusher that reached MAX_BUNDLE_FLUSH_PASSES_PER_CALL with no push since to take them
+            ingress_shared_lock_t lockShared(m_sharedMutexFinalDestsToOutductArrayIndexMaps);
+            if (m_bundlesToEgressQueue.TryBeginFlush()) {
+                FlushBundlesToEgress();
+            }
+            if (m_bundlesToStorageQueue.TryBeginFlush()) {
+                FlushBundlesToStorage();
+            }
+        }
         int rc = 0;
         try {
             rc = zmq::poll(&items[0], NUM_SOCKETS, DEFAULT_BIG_TIMEOUT_POLL);
@@ -467,39 +552,53 @@ void Ingress::Impl::ReadZmqAcksThreadFunc() {
             continue;
         }
         if (rc > 0) {
-            if (items[0].revents & ZMQ_POLLIN) { //ack from egress
-                EgressAckHdr receivedEgressAckHdr;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingEgressToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedEgressAckHdr, sizeof(hdtn::EgressAckHdr)), zmq::recv_flags::dontwait);
-                if (!res) {
+            if (items[0].revents & ZMQ_POLLIN) { //ack (single or batched) from egress
+                zmq::message_t zmqEgressAckMessage;
+                const uint8_t* firstEgressAckHdrPtr;
+                uint32_t numEgressAckHdrs;
+                if (!m_zmqPullSock_connectingEgressToBoundIngressPtr->recv(zmqEgressAckMessage, zmq::recv_flags::dontwait)) {
                     LOG_ERROR(subprocess) << "BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack";
-                        "Error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack";
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::EgressAckHdr))) {
-                    LOG_ERROR(subprocess) << "EgressAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::EgressAckHdr);
+                else if (zmqEgressAckMessage.size() < sizeof(hdtn::CommonHdr)) {
+                    LOG_ERROR(subprocess) << "EgressAckHdr message mismatch: size = " << zmqEgressAckMessage.size();
                 }
-                else if (receivedEgressAckHdr.base.type == HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS) {
+                else if ((numEgressAckHdrs = hdtn::GetHeadersOfSingleOrBatchMessage<hdtn::EgressAckHdr>(zmqEgressAckMessage.data(), zmqEgressAckMessage.size(),
+                    HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS, HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS, firstEgressAckHdrPtr)) != 0)
+                {
                     ingress_shared_lock_t lockShared(m_sharedMutexFinalDestsToOutductArrayIndexMaps);
-                    BundlePipelineAckingSet& bundlePipelineAckingSetObj = *(m_vectorBundlePipelineAckingSet[receivedEgressAckHdr.outductIndex]);
-                    if (receivedEgressAckHdr.error) {
-                        //trigger a link down event in ingress more quickly than waiting for scheduler.
-                        //egress shall send the failed bundle to storage.
-                        if (bundlePipelineAckingSetObj.m_linkIsUp) {
-                            bundlePipelineAckingSetObj.m_linkIsUp = false; //no mutex needed as this flag is only set from ReadZmqAcksThreadFunc
-                            LOG_INFO(subprocess) << "Got a link down notification from egress for outductIndex " 
-                                << receivedEgressAckHdr.outductIndex;
+                    BundlePipelineAckingSet* ackingSetToNotifyPtr = NULL;
+                    for (uint32_t i = 0; i < numEgressAckHdrs; ++i) {
+                        hdtn::EgressAckHdr receivedEgressAckHdr;
+                        memcpy(&receivedEgressAckHdr, firstEgressAckHdrPtr + (i * sizeof(hdtn::EgressAckHdr)), sizeof(hdtn::EgressAckHdr));
+                        BundlePipelineAckingSet& bundlePipelineAckingSetObj = *(m_vectorBundlePipelineAckingSet[receivedEgressAckHdr.outductIndex]);
+                        if (receivedEgressAckHdr.error) {
+                            //trigger a link down event in ingress more quickly than waiting for scheduler.
+                            //egress shall send the failed bundle to storage.
+                            if (bundlePipelineAckingSetObj.m_linkIsUp) {
+                                bundlePipelineAckingSetObj.m_linkIsUp = false; //no mutex needed as this flag is only set from ReadZmqAcksThreadFunc
+                                LOG_INFO(subprocess) << "Got a link down notification from egress for outductIndex "
+                                    << receivedEgressAckHdr.outductIndex;
+                            }
+                        }
+                        if (bundlePipelineAckingSetObj.CompareAndPop_ThreadSafe(receivedEgressAckHdr.custodyId, true)) { //true => isEgress
+                            //wake the waiting ingress threads once per run of acks to the same outduct rather than once per ack
+                            if (ackingSetToNotifyPtr != &bundlePipelineAckingSetObj) {
+                                if (ackingSetToNotifyPtr) {
+                                    ackingSetToNotifyPtr->NotifyAll();
+                                }
+                                ackingSetToNotifyPtr = &bundlePipelineAckingSetObj;
+                            }
+                            ++totalAcksFromEgress;
+                        }
+                        else {
+                            LOG_ERROR(subprocess) << "didn't receive expected egress ack";
                         }
                     }
-                    if (bundlePipelineAckingSetObj.CompareAndPop_ThreadSafe(receivedEgressAckHdr.custodyId, true)) { //true => isEgress
-                        bundlePipelineAckingSetObj.NotifyAll();
-                        ++totalAcksFromEgress;
-                    }
-                    else {
-                        LOG_ERROR(subprocess) << "didn't receive expected egress ack";
+                    if (ackingSetToNotifyPtr) {
+                        ackingSetToNotifyPtr->NotifyAll();
                     }
-
                 }
-                else if (receivedEgressAckHdr.base.type == HDTN_MSGTYPE_ALL_OUTDUCT_CAPABILITIES_TELEMETRY) {
+                else if (GetCommonHdrType(zmqEgressAckMessage) == HDTN_MSGTYPE_ALL_OUTDUCT_CAPABILITIES_TELEMETRY) {
                     AllOutductCapabilitiesTelemetry_t aoct;
                     uint64_t numBytesTakenToDecode;
                     
@@ -574,10 +673,7 @@ void Ingress::Impl::ReadZmqAcksThreadFunc() {
                                     m_threadTcpclOpportunisticBundlesFromEgressReaderPtr = boost::make_unique<boost::thread>(
                                         boost::bind(&Ingress::Impl::ReadTcpclOpportunisticBundlesFromEgressThreadFunc, this)); //create and start the worker thread
 
-                                    m_inductManager.LoadInductsFromConfig(boost::bind(&Ingress::Impl::WholeBundleReadyCallback, this, boost::placeholders::_1), m_hdtnConfig.m_inductsConfig,
-                                        m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
-                                        boost::bind(&Ingress::Impl::OnNewOpportunisticLinkCallback, this, boost::placeholders::_1, boost::placeholders::_2),
-                                        boost::bind(&Ingress::Impl::OnDeletedOpportunisticLinkCallback, this, boost::placeholders::_1));
+                                    LoadInducts();
 
                                     m_egressFullyInitialized = true;
 
@@ -591,27 +687,40 @@ void Ingress::Impl::ReadZmqAcksThreadFunc() {
                     LOG_ERROR(subprocess) << "message ack unknown";
                 }
             }
-            if (items[1].revents & ZMQ_POLLIN) { //ack from storage
-                StorageAckHdr receivedStorageAck;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingStorageToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedStorageAck, sizeof(hdtn::StorageAckHdr)), zmq::recv_flags::dontwait);
-                if (!res) {
+            if (items[1].revents & ZMQ_POLLIN) { //ack (single or batched) from storage
+                zmq::message_t zmqStorageAckMessage;
+                const uint8_t* firstStorageAckHdrPtr;
+                uint32_t numStorageAckHdrs;
+                if (!m_zmqPullSock_connectingStorageToBoundIngressPtr->recv(zmqStorageAckMessage, zmq::recv_flags::dontwait)) {
                     LOG_ERROR(subprocess) << "BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack";
 
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::StorageAckHdr))) {
-                    LOG_ERROR(subprocess) << "StorageAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::StorageAckHdr);
-                }
-                else if (receivedStorageAck.base.type != HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS) {
-                    LOG_ERROR(subprocess) << "message ack not HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS";
+                else if ((numStorageAckHdrs = hdtn::GetHeadersOfSingleOrBatchMessage<hdtn::StorageAckHdr>(zmqStorageAckMessage.data(), zmqStorageAckMessage.size(),
+                    HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS, HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS, firstStorageAckHdrPtr)) == 0)
+                {
+                    LOG_ERROR(subprocess) << "message ack not HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS or HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS, size = "
+                        << zmqStorageAckMessage.size();
                 }
                 else {
                     ingress_shared_lock_t lockShared(m_sharedMutexFinalDestsToOutductArrayIndexMaps);
-                    BundlePipelineAckingSet& bundlePipelineAckingSetObj = (receivedStorageAck.outductIndex == UINT64_MAX) ?
-                        m_singleStorageBundlePipelineAckingSet : (*(m_vectorBundlePipelineAckingSet[receivedStorageAck.outductIndex]));
-                    if (bundlePipelineAckingSetObj.CompareAndPop_ThreadSafe(receivedStorageAck.ingressUniqueId, false)) { //false => is Storage
-                        bundlePipelineAckingSetObj.NotifyAll();
-                        ++totalAcksFromStorage;
+                    BundlePipelineAckingSet* ackingSetToNotifyPtr = NULL;
+                    for (uint32_t i = 0; i < numStorageAckHdrs; ++i) {
+                        hdtn::StorageAckHdr receivedStorageAck;
+                        memcpy(&receivedStorageAck, firstStorageAckHdrPtr + (i * sizeof(hdtn::StorageAckHdr)), sizeof(hdtn::StorageAckHdr));
+                        BundlePipelineAckingSet& bundlePipelineAckingSetObj = (receivedStorageAck.outductIndex == UINT64_MAX) ?
+                            m_singleStorageBundlePipelineAckingSet : (*(m_vectorBundlePipelineAckingSet[receivedStorageAck.outductIndex]));
+                        if (bundlePipelineAckingSetObj.CompareAndPop_ThreadSafe(receivedStorageAck.ingressUniqueId, false)) { //false => is Storage
+                            if (ackingSetToNotifyPtr != &bundlePipelineAckingSetObj) {
+                                if (ackingSetToNotifyPtr) {
+                                    ackingSetToNotifyPtr->NotifyAll();
+                                }
+                                ackingSetToNotifyPtr = &bundlePipelineAckingSetObj;
+                            }
+                            ++totalAcksFromStorage;
+                        }
+                    }
+                    if (ackingSetToNotifyPtr) {
+                        ackingSetToNotifyPtr->NotifyAll();
                     }
                 }
             }
@@ -1052,41 +1161,23 @@ bool Ingress::Impl::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bun
                         }
                         else { //if(reservedEgressPipelineAvailability) //pipeline limits not exceeded for egress cut-through path, continue to send the bundle to egress
 
-                            //force natural/64-bit alignment
-                            hdtn::ToEgressHdr* toEgressHdr = new hdtn::ToEgressHdr();
-                            zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
+                            queued_bundle_to_egress_t queuedBundle;
+                            hdtn::ToEgressHdr& toEgressHdr = queuedBundle.hdr;
 
                             //memset 0 not needed because all values set below
-                            toEgressHdr->base.type = HDTN_MSGTYPE_EGRESS;
-                            toEgressHdr->base.flags = 0; //flags not used by egress // static_cast<uint16_t>(primary.flags);
-                            toEgressHdr->nextHopNodeId = bundleCutThroughPipelineAckingSetObj.GetNextHopNodeId();
-                            toEgressHdr->finalDestEid = finalDestEid;
-                            toEgressHdr->hasCustody = requestsCustody;
-                            toEgressHdr->isCutThroughFromIngress = 1;
-                            toEgressHdr->isOpportunisticFromStorage = 0;
-                            toEgressHdr->isCutThroughFromStorage = 0;
-                            toEgressHdr->custodyId = fromIngressUniqueId;
-                            toEgressHdr->outductIndex = outductIndex;
-                            {
-                                //zmq::message_t messageWithDataStolen(hdrPtr.get(), sizeof(hdtn::BlockHdr), CustomIgnoreCleanupBlockHdr); //cleanup will occur in the queue below
-                                boost::mutex::scoped_lock lock(m_ingressToEgressZmqSocketMutex);
-                                if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-                                    LOG_ERROR(subprocess) << "can't send toEgressHdr to egress";
-                                    bundleCutThroughPipelineAckingSetObj.CompareAndPop_ThreadSafe(fromIngressUniqueId, true);
-                                    useStorage = true;
-                                }
-                                else {
-
-                                    if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
-                                        LOG_ERROR(subprocess) << "can't send bundle to egress";
-                                        bundleCutThroughPipelineAckingSetObj.CompareAndPop_ThreadSafe(fromIngressUniqueId, true);
-                                        useStorage = true;
-                                    }
-                                    else {
-                                        //success                            
-                                        m_bundleCountEgress.fetch_add(1, boost::memory_order_relaxed);
-                                    }
-                                }
+                            toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+                            toEgressHdr.base.flags = 0; //flags not used by egress // static_cast<uint16_t>(primary.flags);
+                            toEgressHdr.nextHopNodeId = bundleCutThroughPipelineAckingSetObj.GetNextHopNodeId();
+                            toEgressHdr.finalDestEid = finalDestEid;
+                            toEgressHdr.hasCustody = requestsCustody;
+                            toEgressHdr.isCutThroughFromIngress = 1;
+                            toEgressHdr.isOpportunisticFromStorage = 0;
+                            toEgressHdr.isCutThroughFromStorage = 0;
+                            toEgressHdr.custodyId = fromIngressUniqueId;
+                            toEgressHdr.outductIndex = outductIndex;
+                            queuedBundle.bundle = std::move(*zmqMessageToSendUniquePtr);
+                            if (m_bundlesToEgressQueue.Push(std::move(queuedBundle))) { //no other thread is sending to egress, so send it (and whatever gets queued meanwhile) now
+                                FlushBundlesToEgress();
                             }
                         }
                     }
@@ -1098,52 +1189,8 @@ bool Ingress::Impl::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bun
             }
         
             if (useStorage) { //storage
-                bool storageModuleAvailable = true;
-                if (!reservedStorageCutThroughPipelineAvailability) { //cut through path was not available for egress or storage, time to store the bundle
-                    ++m_eventsTooManyInStorageCutThroughQueue;
-                    static const boost::posix_time::time_duration twoSeconds = boost::posix_time::seconds(2);
-                    storageModuleAvailable = m_singleStorageBundlePipelineAckingSet.WaitForStoragePipelineAvailabilityAndReserve(twoSeconds,
-                        fromIngressUniqueId, zmqMessageToSendUniquePtr->size());
-                    outductIndex = UINT64_MAX;
-                }
-                if (storageModuleAvailable) {
-
-                    BundlePipelineAckingSet& ackingSetObj = (outductIndex == UINT64_MAX) ?
-                        m_singleStorageBundlePipelineAckingSet : (*(m_vectorBundlePipelineAckingSet[outductIndex])); //only used to restore state if zmq fails
-                    
-                    //force natural/64-bit alignment
-                    hdtn::ToStorageHdr* toStorageHdr = new hdtn::ToStorageHdr();
-                    zmq::message_t zmqMessageToStorageHdrWithDataStolen(toStorageHdr, sizeof(hdtn::ToStorageHdr), CustomCleanupToStorageHdr, toStorageHdr);
-
-                    //memset 0 not needed because all values set below
-                    toStorageHdr->base.type = HDTN_MSGTYPE_STORE;
-                    toStorageHdr->base.flags = 0; //flags not used by storage // static_cast<uint16_t>(primary.flags);
-                    toStorageHdr->ingressUniqueId = fromIngressUniqueId;
-                    toStorageHdr->outductIndex = outductIndex;
-                    toStorageHdr->dontStoreBundle = reservedStorageCutThroughPipelineAvailability;
-                    toStorageHdr->isCustodyOrAdminRecord = (requestsCustody || isAdminRecordForHdtnStorage);
-                    toStorageHdr->finalDestEid = finalDestEid;
-
-                    //zmq threads not thread safe but protected by mutex below
-                    boost::mutex::scoped_lock lock(m_ingressToStorageZmqSocketMutex);
-                    if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(zmqMessageToStorageHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-                        LOG_ERROR(subprocess) << "can't send toStorageHdr to storage, this bundle will be lost";
-                        ackingSetObj.CompareAndPop_ThreadSafe(fromIngressUniqueId, false);
-                    }
-                    else {
-                        if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
-                            LOG_ERROR(subprocess) << "can't send bundle to storage, this bundle will be lost";
-                            ackingSetObj.CompareAndPop_ThreadSafe(fromIngressUniqueId, false);
-                        }
-                        else {
-                            //success                            
-                            ++m_bundleCountStorage; //protected by m_ingressToStorageZmqSocketMutex
-                        }
-                    }
-                }
-                else {
-                    LOG_ERROR(subprocess) << "storage module unresponsive, this bundle will be lost";
-                }
+                SendBundleToStorage(*zmqMessageToSendUniquePtr, fromIngressUniqueId, outductIndex,
+                    reservedStorageCutThroughPipelineAvailability, (requestsCustody || isAdminRecordForHdtnStorage), finalDestEid);
             }
         } //end scope for cut-through shared mutex lock
     }
@@ -1154,6 +1201,160 @@ bool Ingress::Impl::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bun
     return true;
 }
 
+//Sends a single bundle message if bundles holds one bundle, otherwise a batch message.
+//If arenaPtr is not NULL, the bundles that fit in a free slot of the arena are copied there and sent as descriptors
+//(with HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY set in their headers) in place of their bytes.
+//Returns the number of bundles sent; the bundles not sent are left unmoved.
+template <typename QueuedBundleType>
+static std::size_t SendQueuedBundles(zmq::socket_t & sock, std::vector<QueuedBundleType> & bundles, const uint16_t batchType,
+    SharedMemoryBundleArena * arenaPtr, const SharedMemoryBundleArena::PROCESS toProcess, std::vector<SharedMemoryBundleArena::Descriptor> & descriptors)
+{
+    const std::size_t hdrSize = sizeof(bundles[0].hdr);
+    if (arenaPtr) {
+        descriptors.resize(bundles.size());
+        for (std::size_t i = 0; i < bundles.size(); ++i) {
+            if (arenaPtr->CopyIn(bundles[i].bundle, descriptors[i])) {
+                bundles[i].hdr.base.flags |= HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+            }
+        }
+    }
+    bool sentHeaders;
+    if (bundles.size() == 1) {
+        sentHeaders = static_cast<bool>(sock.send(zmq::const_buffer(&bundles[0].hdr, hdrSize), zmq::send_flags::sndmore | zmq::send_flags::dontwait));
+    }
+    else {
+        zmq::message_t zmqHeadersMessage(sizeof(hdtn::BatchHdr) + (bundles.size() * hdrSize));
+        uint8_t* hdrPtr = hdtn::WriteBatchHdr(zmqHeadersMessage.data(), batchType, static_cast<uint32_t>(bundles.size()));
+        for (std::size_t i = 0; i < bundles.size(); ++i, hdrPtr += hdrSize) {
+            memcpy(hdrPtr, &bundles[i].hdr, hdrSize);
+        }
+        sentHeaders = static_cast<bool>(sock.send(std::move(zmqHeadersMessage), zmq::send_flags::sndmore | zmq::send_flags::dontwait));
+    }
+    //a multipart message is delivered atomically, so once its first frame is queued the remaining frames won't hit the high water mark
+    std::size_t numSent = 0;
+    for (; sentHeaders && (numSent < bundles.size()); ++numSent) {
+        const zmq::send_flags flags = ((numSent + 1) < bundles.size()) ? (zmq::send_flags::sndmore | zmq::send_flags::dontwait) : zmq::send_flags::dontwait;
+        QueuedBundleType& queuedBundle = bundles[numSent];
+        if (queuedBundle.hdr.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) {
+            if (!arenaPtr->SendDescriptor(sock, descriptors[numSent], toProcess, flags)) {
+                break;
+            }
+            queuedBundle.bundle.rebuild(); //its copy in the arena was sent
+        }
+        else if (!sock.send(std::move(queuedBundle.bundle), flags)) {
+            break;
+        }
+    }
+    for (std::size_t i = numSent; i < bundles.size(); ++i) {
+        if (bundles[i].hdr.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) {
+            arenaPtr->Free(descriptors[i]);
+            bundles[i].hdr.base.flags &= ~HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+        }
+    }
+    return numSent;
+}
+
+//Moves the bundles into the ring (instead of sending them over sock), and wakes the ring's consumer over sock if needed.
+//Returns the number of bundles pushed; the bundles not pushed because the ring is full are left unmoved.
+template <typename QueuedBundleType>
+static std::size_t PushQueuedBundles(SlotQueueSingleProducerSingleConsumer<QueuedBundleType> & ring, zmq::socket_t & sock,
+    std::vector<QueuedBundleType> & bundles)
+{
+    bool needsWake = false;
+    std::size_t numPushed = 0;
+    while ((numPushed < bundles.size()) && hdtn::PushToBundleRing(ring, bundles[numPushed].hdr, bundles[numPushed].bundle, needsWake)) {
+        ++numPushed;
+    }
+    if (needsWake && (!hdtn::SendBundleRingWake(sock))) {
+        LOG_ERROR(subprocess) << "can't send bundle ring wake message, consumer will drain the ring on its next poll timeout";
+    }
+    return numPushed;
+}
+
+//caller holds m_sharedMutexFinalDestsToOutductArrayIndexMaps (shared)
+void Ingress::Impl::SendBundleToStorage(zmq::message_t& bundle, const uint64_t fromIngressUniqueId, uint64_t outductIndex,
+    const bool reservedStorageCutThroughPipelineAvailability, const bool isCustodyOrAdminRecord, const cbhe_eid_t& finalDestEid)
+{
+    bool storageModuleAvailable = true;
+    if (!reservedStorageCutThroughPipelineAvailability) { //cut through path was not available for egress or storage, time to store the bundle
+        ++m_eventsTooManyInStorageCutThroughQueue;
+        static const boost::posix_time::time_duration twoSeconds = boost::posix_time::seconds(2);
+        storageModuleAvailable = m_singleStorageBundlePipelineAckingSet.WaitForStoragePipelineAvailabilityAndReserve(twoSeconds,
+            fromIngressUniqueId, bundle.size());
+        outductIndex = UINT64_MAX;
+    }
+    if (storageModuleAvailable) {
+        queued_bundle_to_storage_t queuedBundle;
+        hdtn::ToStorageHdr& toStorageHdr = queuedBundle.hdr;
+
+        //memset 0 not needed because all values set below
+        toStorageHdr.base.type = HDTN_MSGTYPE_STORE;
+        toStorageHdr.base.flags = 0; //flags not used by storage // static_cast<uint16_t>(primary.flags);
+        toStorageHdr.ingressUniqueId = fromIngressUniqueId;
+        toStorageHdr.outductIndex = outductIndex;
+        toStorageHdr.dontStoreBundle = reservedStorageCutThroughPipelineAvailability;
+        toStorageHdr.isCustodyOrAdminRecord = isCustodyOrAdminRecord;
+        toStorageHdr.finalDestEid = finalDestEid;
+        queuedBundle.bundle = std::move(bundle);
+        if (m_bundlesToStorageQueue.Push(std::move(queuedBundle))) { //no other thread is sending to storage, so send it (and whatever gets queued meanwhile) now
+            FlushBundlesToStorage();
+        }
+    }
+    else {
+        LOG_ERROR(subprocess) << "storage module unresponsive, this bundle will be lost";
+    }
+}
+
+//Called by the thread whose push found no flush in progress.  The first pass usually holds only that thread's own bundle,
+//which goes out as a single message; bundles queued by other threads while a pass is being sent go out together as one batch.
+//After MAX_BUNDLE_FLUSH_PASSES_PER_CALL passes the remaining bundles go to the next pushing thread (or ReadZmqAcksThreadFunc).
+//Caller holds m_sharedMutexFinalDestsToOutductArrayIndexMaps (shared).
+void Ingress::Impl::FlushBundlesToEgress() {
+    while (std::vector<queued_bundle_to_egress_t>* bundlesPtr = m_bundlesToEgressQueue.TakeAll()) {
+        std::vector<queued_bundle_to_egress_t>& bundles = *bundlesPtr;
+        std::size_t numSent;
+        {
+            boost::mutex::scoped_lock lock(m_ingressToEgressZmqSocketMutex);
+            numSent = (m_bundleRingsPtr) ?
+                PushQueuedBundles(m_bundleRingsPtr->ingressToEgress, *m_zmqPushSock_boundIngressToConnectingEgressPtr, bundles) :
+                SendQueuedBundles(*m_zmqPushSock_boundIngressToConnectingEgressPtr, bundles, HDTN_MSGTYPE_EGRESS_BATCH,
+                    m_sharedMemoryToEgressArenaPtr, SharedMemoryBundleArena::PROCESS::EGRESS, m_descriptorsToEgress);
+        }
+        m_bundleCountEgress.fetch_add(numSent, boost::memory_order_relaxed);
+        for (std::size_t i = numSent; i < bundles.size(); ++i) {
+            queued_bundle_to_egress_t& queuedBundle = bundles[i];
+            LOG_ERROR(subprocess) << "can't send bundle to egress, sending it to storage instead";
+            m_vectorBundlePipelineAckingSet[queuedBundle.hdr.outductIndex]->CompareAndPop_ThreadSafe(queuedBundle.hdr.custodyId, true);
+            //cut-through bundles never have custody and are never admin records for storage
+            SendBundleToStorage(queuedBundle.bundle, queuedBundle.hdr.custodyId, UINT64_MAX, false, false, queuedBundle.hdr.finalDestEid);
+        }
+    }
+}
+
+//see FlushBundlesToEgress
+void Ingress::Impl::FlushBundlesToStorage() {
+    while (std::vector<queued_bundle_to_storage_t>* bundlesPtr = m_bundlesToStorageQueue.TakeAll()) {
+        std::vector<queued_bundle_to_storage_t>& bundles = *bundlesPtr;
+        std::size_t numSent;
+        {
+            //zmq sockets not thread safe but protected by mutex below
+            boost::mutex::scoped_lock lock(m_ingressToStorageZmqSocketMutex);
+            numSent = (m_bundleRingsPtr) ?
+                PushQueuedBundles(m_bundleRingsPtr->ingressToStorage, *m_zmqPushSock_boundIngressToConnectingStoragePtr, bundles) :
+                SendQueuedBundles(*m_zmqPushSock_boundIngressToConnectingStoragePtr, bundles, HDTN_MSGTYPE_STORE_BATCH,
+                    m_sharedMemoryToStorageArenaPtr, SharedMemoryBundleArena::PROCESS::STORAGE, m_descriptorsToStorage);
+        }
+        m_bundleCountStorage += numSent; //only one thread flushes at a time
+        for (std::size_t i = numSent; i < bundles.size(); ++i) {
+            const hdtn::ToStorageHdr& toStorageHdr = bundles[i].hdr;
+            LOG_ERROR(subprocess) << "can't send bundle to storage, this bundle will be lost";
+            BundlePipelineAckingSet& ackingSetObj = (toStorageHdr.outductIndex == UINT64_MAX) ?
+                m_singleStorageBundlePipelineAckingSet : (*(m_vectorBundlePipelineAckingSet[toStorageHdr.outductIndex]));
+            ackingSetObj.CompareAndPop_ThreadSafe(toStorageHdr.ingressUniqueId, false);
+        }
+    }
+}
+
 
 void Ingress::Impl::WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec) {
     //if more than 1 BpSinkAsync context, must protect shared resources with mutex.  Each BpSinkAsync context has
@@ -1162,6 +1363,133 @@ void Ingress::Impl::WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundle
     ProcessPaddedData(wholeBundleVec.data(), wholeBundleVec.size(), unusedZmqPtr, wholeBundleVec, false, true);
 }
 
+void Ingress::Impl::LoadInducts() {
+    const OnNewOpportunisticLinkCallback_t onNewOpportunisticLinkCallback =
+        boost::bind(&Ingress::Impl::OnNewOpportunisticLinkCallback, this, boost::placeholders::_1, boost::placeholders::_2);
+    const OnDeletedOpportunisticLinkCallback_t onDeletedOpportunisticLinkCallback =
+        boost::bind(&Ingress::Impl::OnDeletedOpportunisticLinkCallback, this, boost::placeholders::_1);
+    LtpUdpEngineManager::SetMaxUdpPacketsToReceivePerSystemCallForAllLtp(m_hdtnConfig.m_maxLtpUdpPacketsToReceivePerSystemCall); //before any ltp inducts are created
+    LtpUdpEngineManager::SetUdpSegmentationOffloadForAllLtp(m_hdtnConfig.m_ltpUdpSegmentationOffload);
+    LtpUdpEngineManager::SetNumUdpReceiveThreadsPerPortForAllLtp(m_hdtnConfig.m_numLtpUdpReceiveThreadsPerPort);
+    StartProcessingWorkers();
+    if (m_processingWorkers.empty()) { //process on the induct threads
+        m_inductManager.LoadInductsFromConfig(boost::bind(&Ingress::Impl::WholeBundleReadyCallback, this, boost::placeholders::_1), m_hdtnConfig.m_inductsConfig,
+            m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
+            onNewOpportunisticLinkCallback, onDeletedOpportunisticLinkCallback);
+    }
+    else {
+        std::vector<InductProcessBundleCallback_t> inductProcessBundleCallbacks;
+        inductProcessBundleCallbacks.reserve(m_inductBundleQueues.size());
+        for (std::size_t inductIndex = 0; inductIndex < m_inductBundleQueues.size(); ++inductIndex) {
+            inductProcessBundleCallbacks.emplace_back(boost::bind(&Ingress::Impl::WholeBundleReadyToProcessingWorkerCallback, this, boost::placeholders::_1, inductIndex));
+        }
+        m_inductManager.LoadInductsFromConfig(inductProcessBundleCallbacks, m_hdtnConfig.m_inductsConfig,
+            m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
+            onNewOpportunisticLinkCallback, onDeletedOpportunisticLinkCallback);
+    }
+}
+
+//Each induct is served by one worker (round robin), so bundles from one induct stay in order
+//while bundles from different inducts are decoded, rewritten and routed in parallel.
+void Ingress::Impl::StartProcessingWorkers() {
+    const std::size_t numInducts = m_hdtnConfig.m_inductsConfig.m_inductElementConfigVector.size();
+    const std::size_t numWorkers = static_cast<std::size_t>(std::min<uint64_t>(m_hdtnConfig.m_numIngressBundleProcessingWorkers, numInducts)); //extra workers would have no induct
+    if (numWorkers == 0) {
+        return;
+    }
+    m_processingWorkers.reserve(numWorkers);
+    for (std::size_t i = 0; i < numWorkers; ++i) {
+        m_processingWorkers.emplace_back(boost::make_unique<ProcessingWorker>());
+    }
+    m_inductBundleQueues.reserve(numInducts);
+    for (std::size_t inductIndex = 0; inductIndex < numInducts; ++inductIndex) {
+        ProcessingWorker* const workerPtr = m_processingWorkers[inductIndex % numWorkers].get();
+        m_inductBundleQueues.emplace_back(boost::make_unique<InductBundleQueue>(workerPtr));
+        workerPtr->m_inductBundleQueues.push_back(m_inductBundleQueues.back().get());
+    }
+    m_processingWorkersRunning = true;
+    for (std::size_t i = 0; i < numWorkers; ++i) {
+        ProcessingWorker* const workerPtr = m_processingWorkers[i].get();
+        workerPtr->m_threadPtr = boost::make_unique<boost::thread>(
+            boost::bind(&Ingress::Impl::ProcessingWorkerThreadFunc, this, workerPtr)); //create and start the worker thread
+    }
+    LOG_INFO(subprocess) << "processing bundles from " << numInducts << " inducts on " << numWorkers << " worker threads";
+}
+
+//caller must stop the inducts first
+void Ingress::Impl::StopProcessingWorkers() {
+    m_processingWorkersRunning = false; //thread stopping criteria (once their queues are drained)
+    for (std::size_t i = 0; i < m_processingWorkers.size(); ++i) {
+        ProcessingWorker& worker = *m_processingWorkers[i];
+        {
+            boost::mutex::scoped_lock lock(worker.m_mutex);
+            worker.m_wakeRequested = true;
+            worker.m_conditionVariable.notify_one();
+        }
+        if (worker.m_threadPtr) {
+            worker.m_threadPtr->join();
+            worker.m_threadPtr.reset(); //delete it
+        }
+    }
+    m_processingWorkers.clear();
+    m_inductBundleQueues.clear();
+}
+
+//Called by the induct's thread(s).  Blocks while the induct's queue is full, so the induct's flow control still holds.
+void Ingress::Impl::WholeBundleReadyToProcessingWorkerCallback(padded_vector_uint8_t & wholeBundleVec, const std::size_t inductIndex) {
+    static const boost::posix_time::time_duration timeout = boost::posix_time::milliseconds(250);
+    InductBundleQueue& inductBundleQueue = *m_inductBundleQueues[inductIndex];
+    bool workerMayBeSleeping;
+    {
+        boost::mutex::scoped_lock lock(inductBundleQueue.m_producerMutex);
+        padded_vector_uint8_t* slotPtr;
+        while ((slotPtr = inductBundleQueue.m_queue.GetSlotForWrite(timeout)) == NULL) {
+            if (!m_processingWorkersRunning) {
+                LOG_ERROR(subprocess) << "ingress processing workers stopped, this bundle will be lost";
+                return;
+            }
+        }
+        *slotPtr = std::move(wholeBundleVec);
+        workerMayBeSleeping = inductBundleQueue.m_queue.CommitWrite();
+    }
+    if (workerMayBeSleeping) {
+        ProcessingWorker& worker = *inductBundleQueue.m_workerPtr;
+        boost::mutex::scoped_lock lock(worker.m_mutex);
+        worker.m_wakeRequested = true;
+        worker.m_conditionVariable.notify_one();
+    }
+}
+
+void Ingress::Impl::ProcessingWorkerThreadFunc(ProcessingWorker* workerPtr) {
+    ProcessingWorker& worker = *workerPtr;
+    static const boost::posix_time::time_duration timeout = boost::posix_time::milliseconds(250);
+    std::unique_ptr<zmq::message_t> unusedZmqPtr;
+    padded_vector_uint8_t bundleVec;
+    while (true) {
+        //one bundle per induct per pass so that a busy induct cannot starve the other inducts of this worker
+        bool processedABundle = false;
+        for (std::size_t i = 0; i < worker.m_inductBundleQueues.size(); ++i) {
+            SlotQueueSingleProducerSingleConsumer<padded_vector_uint8_t>& queue = worker.m_inductBundleQueues[i]->m_queue;
+            if (padded_vector_uint8_t* slotPtr = queue.GetSlotForRead()) {
+                bundleVec = std::move(*slotPtr);
+                queue.CommitRead();
+                ProcessPaddedData(bundleVec.data(), bundleVec.size(), unusedZmqPtr, bundleVec, false, true);
+                processedABundle = true;
+            }
+        }
+        if (!processedABundle) {
+            if (!m_processingWorkersRunning) {
+                break;
+            }
+            boost::mutex::scoped_lock lock(worker.m_mutex);
+            if (!worker.m_wakeRequested) {
+                worker.m_conditionVariable.timed_wait(lock, timeout);
+            }
+            worker.m_wakeRequested = false;
+        }
+    }
+}
+
 void Ingress::Impl::SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable) {
     //force natural/64-bit alignment
     hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
@@ -27,9 +27,10 @@
 #include <vector>
 #include <utility>
 #include <string>
+#include <memory>
 #include "MemoryManagerTreeArray.h"
 #include "codec/PrimaryBlock.h"
-#include "HashMap16BitFixedSize.h"
+#include "OpenAddressingHashMap.h"
 #include <boost/bimap.hpp>
 #include <boost/date_time.hpp>
 #include "CatalogEntry.h"
@@ -41,11 +42,35 @@ typedef std::forward_list<uint64_t> custids_flist_t;
 typedef std::pair<custids_flist_t, custids_flist_t::iterator> custids_flist_plus_lastiterator_t;
 typedef std::map<uint64_t, custids_flist_plus_lastiterator_t> expirations_to_custids_map_t;
 typedef std::array<expirations_to_custids_map_t, NUMBER_OF_PRIORITIES> priorities_to_expirations_array_t;
-typedef std::map<cbhe_eid_t, priorities_to_expirations_array_t> dest_eid_to_priorities_map_t;
 
-typedef HashMap16BitFixedSize<cbhe_bundle_uuid_t, uint64_t> uuid_to_custid_hashmap_t; //get the cteb custody id from fragmented bundle uuid
-typedef HashMap16BitFixedSize<cbhe_bundle_uuid_nofragment_t, uint64_t> uuidnofrag_to_custid_hashmap_t; //get the cteb custody id from non-fragmented bundle uuid
-typedef HashMap16BitFixedSize<uint64_t, catalog_entry_t> custid_to_catalog_entry_hashmap_t; //get the catalog entry from cteb custody id
+//Release index data structures
+//A release index is a set of final destinations (typically those of one outduct) registered once (e.g. on link up),
+//which keeps, per priority, a binary min-heap of its non-empty destinations keyed by each destination's earliest expiration.
+//The heaps are updated incrementally whenever a destination's earliest expiration changes, so that popping the next bundle
+//to release is O(log n) in the number of destinations rather than a scan of every available destination.
+struct awaiting_send_dest_t;
+struct release_index_t;
+struct release_index_membership_t {
+    release_index_t * releaseIndexPtr;
+    awaiting_send_dest_t * destPtr;
+    std::array<std::size_t, NUMBER_OF_PRIORITIES> heapPositions; //SIZE_MAX if not in that priority's heap
+};
+struct release_index_t {
+    std::vector<std::pair<cbhe_eid_t, bool> > dests; //bool = true for any service id
+    std::vector<std::unique_ptr<release_index_membership_t> > memberships;
+    std::array<std::vector<release_index_membership_t*>, NUMBER_OF_PRIORITIES> heaps;
+};
+struct awaiting_send_dest_t {
+    cbhe_eid_t destEid;
+    priorities_to_expirations_array_t priorityArray;
+    std::vector<release_index_membership_t*> releaseIndexMemberships; //usually 0 or 1 element
+};
+typedef std::map<cbhe_eid_t, awaiting_send_dest_t> dest_eid_to_priorities_map_t;
+typedef std::map<uint64_t, release_index_t> release_index_id_to_release_index_map_t;
+
+typedef OpenAddressingHashMap<cbhe_bundle_uuid_t, uint64_t> uuid_to_custid_hashmap_t; //get the cteb custody id from fragmented bundle uuid
+typedef OpenAddressingHashMap<cbhe_bundle_uuid_nofragment_t, uint64_t> uuidnofrag_to_custid_hashmap_t; //get the cteb custody id from non-fragmented bundle uuid
+typedef OpenAddressingHashMap<uint64_t, catalog_entry_t> custid_to_catalog_entry_hashmap_t; //get the catalog entry from cteb custody id
 typedef boost::bimap<uint64_t, boost::posix_time::ptime> custid_to_custody_xfer_expiry_bimap_t;
 
 class BundleStorageCatalog {
@@ -58,7 +83,10 @@ public:
     STORAGE_LIB_EXPORT BundleStorageCatalog();
     STORAGE_LIB_EXPORT ~BundleStorageCatalog();
 
+    //catalogEntryToTake must have been Init'ed from primary (custody and fragmentation flags come from the catalog entry)
     STORAGE_LIB_EXPORT bool CatalogIncomingBundleForStore(catalog_entry_t & catalogEntryToTake, const PrimaryBlock & primary, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order);
+    //for restoring (e.g. from a catalog journal) without the primary block (custody and fragmentation flags come from the catalog entry)
+    STORAGE_LIB_EXPORT bool CatalogIncomingBundleForStore(catalog_entry_t & catalogEntryToTake, const cbhe_bundle_uuid_t & bundleUuid, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order);
 
     STORAGE_LIB_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<cbhe_eid_t> & availableDestEids);
     STORAGE_LIB_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<uint64_t> & availableDestNodeIds);
@@ -73,9 +101,27 @@ public:
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
     STORAGE_LIB_EXPORT bool GetStorageExpiringBeforeThresholdTelemetry(StorageExpiringBeforeThresholdTelemetry_t & telem);
 
+    //release index (pair bool = true for any service ids), returns a nonzero releaseIndexId
+    STORAGE_LIB_EXPORT uint64_t CreateReleaseIndex(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests);
+    STORAGE_LIB_EXPORT bool DeleteReleaseIndex(const uint64_t releaseIndexId);
+    STORAGE_LIB_EXPORT catalog_entry_t * PopEntryFromReleaseIndex(uint64_t & custodyId, const uint64_t releaseIndexId);
+
+    //incrementally pop up to maxEntriesToPop awaiting send bundles that expire before the threshold (resuming at the destination
+    //where the previous call stopped), the popped bundles remain in the catalog, returns the number popped
+    STORAGE_LIB_EXPORT std::size_t PopExpiredEntriesFromAwaitingSend(const uint64_t thresholdSecondsSinceStartOfYear2000,
+        const std::size_t maxEntriesToPop, std::vector<uint64_t> & custodyIds);
+
 private:
-    STORAGE_LIB_NO_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId,
-        const std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > & destEidPlusPriorityArrayPtrs);
+    STORAGE_LIB_NO_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<awaiting_send_dest_t*> & destPtrs);
+    STORAGE_LIB_NO_EXPORT catalog_entry_t * PopFrontEntry(uint64_t & custodyId, awaiting_send_dest_t & dest, const unsigned int priorityIndex);
+    STORAGE_LIB_NO_EXPORT awaiting_send_dest_t & GetOrCreateAwaitingSendDest(const cbhe_eid_t & destEid);
+    STORAGE_LIB_NO_EXPORT void RemoveUuidFromMap(catalog_entry_t & catalogEntry, const cbhe_bundle_uuid_t & bundleUuid);
+    STORAGE_LIB_NO_EXPORT void AddReleaseIndexMembership(release_index_t & releaseIndex, awaiting_send_dest_t & dest);
+    STORAGE_LIB_NO_EXPORT void UpdateReleaseIndexes(awaiting_send_dest_t & dest, const unsigned int priorityIndex);
+    STORAGE_LIB_NO_EXPORT static bool HeapLess(const release_index_membership_t * a, const release_index_membership_t * b, const unsigned int priorityIndex);
+    STORAGE_LIB_NO_EXPORT static void HeapSiftUp(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex);
+    STORAGE_LIB_NO_EXPORT static void HeapSiftDown(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex);
+    STORAGE_LIB_NO_EXPORT static void HeapRemove(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex);
     STORAGE_LIB_NO_EXPORT bool Insert_OrderBySequence(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert, const uint64_t mySequence);
     STORAGE_LIB_NO_EXPORT void Insert_OrderByFifo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert);
     STORAGE_LIB_NO_EXPORT void Insert_OrderByFilo(custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt, const uint64_t custodyIdToInsert);
@@ -83,6 +129,11 @@ private:
 
 protected:
     dest_eid_to_priorities_map_t m_destEidToPrioritiesMap;
+    release_index_id_to_release_index_map_t m_releaseIndexIdToReleaseIndexMap;
+    std::map<cbhe_eid_t, std::vector<release_index_t*> > m_destEidToReleaseIndexPtrsMap; //fully qualified dests of release indexes
+    std::map<uint64_t, std::vector<release_index_t*> > m_nodeIdToReleaseIndexPtrsMap; //any service id dests of release indexes
+    uint64_t m_nextReleaseIndexId;
+    cbhe_eid_t m_nextDestEidToReap;
     uuid_to_custid_hashmap_t m_uuidToCustodyIdHashMap;
     uuidnofrag_to_custid_hashmap_t m_uuidNoFragToCustodyIdHashMap;
     custid_to_catalog_entry_hashmap_t m_custodyIdToCatalogEntryHashmap;
@@ -16,6 +16,11 @@
  * This BundleStorageManagerAsio class inherits from the BundleStorageManagerBase class and implements
  * writing and reading bundles to and from solid state disk drive(s) using 1 thread regardless of number of drives
  * and uses cross-platform asynchronous I/O operations.
+ * Every disk operation is positional (offset given with the operation rather than a prior seek), and up to
+ * StorageConfig::m_diskQueueDepth segment operations per disk are kept in flight at once.
+ * On Windows these are overlapped random access handle operations.  Elsewhere, the positional pread/pwrite calls
+ * are run on a pool of blocking I/O threads and their completions are handled by the single io_service thread.
+ * On non-Windows platforms, queued segments that are adjacent on a disk become one pwritev/preadv operation.
  */
 
 #ifndef _BUNDLE_STORAGE_MANAGER_ASIO_H
@@ -37,8 +42,13 @@ public:
 
 private:
     STORAGE_LIB_NO_EXPORT void TryDiskOperation_Consume_NotThreadSafe(const unsigned int diskId);
+    STORAGE_LIB_NO_EXPORT bool IsSegmentOperationInProgress_NotThreadSafe(const unsigned int diskId, const segment_id_t segmentId);
+#ifndef _WIN32
+    STORAGE_LIB_NO_EXPORT void DoBlockingDiskOperation(const unsigned int diskId, const unsigned int consumeIndex,
+        const unsigned int numSegments, const uint64_t offsetBytes, const bool isReadOperation);
+#endif
     STORAGE_LIB_NO_EXPORT void HandleDiskOperationCompleted(const boost::system::error_code& error, std::size_t bytes_transferred,
-        const unsigned int diskId, const unsigned int consumeIndex, const bool wasReadOperation);
+        const unsigned int diskId, const unsigned int consumeIndex, const unsigned int numSegments);
 
     STORAGE_LIB_NO_EXPORT virtual void CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId);
 
@@ -51,10 +61,16 @@ private:
 #ifdef _WIN32
     std::vector<std::unique_ptr<boost::asio::windows::random_access_handle> > m_asioHandlePtrsVec;
 #else
-    std::vector<std::unique_ptr<boost::asio::posix::stream_descriptor> > m_asioHandlePtrsVec;
+    std::vector<int> m_fileDescriptorsVec;
+    std::unique_ptr<boost::asio::thread_pool> m_diskIoThreadPoolPtr;
 #endif
+    const unsigned int M_DISK_QUEUE_DEPTH;
 
-    std::vector<bool> m_diskOperationInProgressVec;
+    //all below only accessed by the io_service thread
+    //circular buffer entries [cb.GetIndexForRead(), cb.GetIndexForRead() + m_numSlotsIssuedVec[diskId]) are in progress or completed but not committed
+    std::vector<unsigned int> m_numSlotsIssuedVec;
+    std::vector<unsigned int> m_numDiskOperationsInProgressVec;
+    std::vector<bool> m_slotCompletedVec; //size M_NUM_STORAGE_DISKS * CIRCULAR_INDEX_BUFFER_SIZE
 };
 
 
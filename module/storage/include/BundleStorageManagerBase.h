@@ -15,6 +15,18 @@
  *
  * This BundleStorageManagerBase class implements the basic methods for
  * writing and reading bundles to and from solid state disk drive(s).
+ * If StorageConfig::m_catalogJournalFilePath is set, every bundle stored and removed is also recorded in a CatalogJournal
+ * so that a restore replays the journal (validated against the segment headers of each bundle) rather than reading every segment.
+ * If StorageConfig::m_hotTierCacheBytes is nonzero, bundles pushed with PushAllSegments(WithoutCatalog) are first held in a
+ * bounded in-memory hot tier and are only written to their (already allocated) disk segments when evicted, when older than
+ * StorageConfig::m_hotTierWriteBackDelayMilliseconds, or when stopping, so that a bundle released and removed soon after
+ * being stored never makes a disk round trip.
+ * Bundles are stored in one of three size classes:  if StorageConfig::m_slabSlotSizeBytes is nonzero, small bundles (e.g. telemetry)
+ * are packed into fixed size slots of shared slab segments (several bundles per segment, written as a whole segment image),
+ * if StorageConfig::m_largeBundleExtentMinBytes is nonzero, large bundles are allocated as whole 64 segment extents
+ * (see MemoryManagerTreeArray), and all other bundles are allocated as before.  Slab bundles bypass the hot tier, and a slab
+ * is only refilled while it is the open slab of this run.  The segment images of the most recently used sealed slabs are cached
+ * (at most MAX_CACHED_SLAB_IMAGES segments of memory), and freeing a slot of any other slab reads its image back outside of the slab mutex.
  */
 
 #ifndef _BUNDLE_STORAGE_MANAGER_BASE_H
@@ -30,6 +42,8 @@
 #include <boost/integer.hpp>
 #include <stdint.h>
 #include <map>
+#include <list>
+#include <unordered_map>
 #include <forward_list>
 #include <array>
 #include <vector>
@@ -39,6 +53,7 @@
 #include <memory>
 #include <boost/thread.hpp>
 #include <boost/bimap.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "BundleStorageConfig.h"
 #include "Logger.h"
@@ -46,6 +61,10 @@
 #include "StorageConfig.h"
 #include "codec/bpv6.h"
 #include "BundleStorageCatalog.h"
+#include "CatalogJournal.h"
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 
 
@@ -53,6 +72,13 @@
 struct BundleStorageManagerSession_WriteToDisk {
     catalog_entry_t catalogEntry;
     uint32_t nextLogicalSegment;
+    segment_id_extent_cursor_t nextSegmentCursor; //segment id of nextLogicalSegment
+};
+
+//page aligned storage (required by O_DIRECT disk I/O)
+#define STORAGE_BUFFER_ALIGNMENT_BYTES 4096
+struct StorageAlignedBufferDeleter {
+    STORAGE_LIB_EXPORT void operator()(volatile uint8_t * p) const;
 };
 
 struct BundleStorageManagerSession_ReadFromDisk {
@@ -61,10 +87,12 @@ struct BundleStorageManagerSession_ReadFromDisk {
 
     uint32_t nextLogicalSegment;
     uint32_t nextLogicalSegmentToCache;
+    segment_id_extent_cursor_t nextSegmentCursor; //segment id of nextLogicalSegment
+    segment_id_extent_cursor_t nextSegmentToCacheCursor; //segment id of nextLogicalSegmentToCache
     uint32_t cacheReadIndex;
     uint32_t cacheWriteIndex;
 
-    std::unique_ptr<volatile uint8_t[]> readCache;// [READ_CACHE_NUM_SEGMENTS_PER_SESSION * SEGMENT_SIZE]; //may overflow stack, create on heap
+    std::unique_ptr<volatile uint8_t[], StorageAlignedBufferDeleter> readCache;// [READ_CACHE_NUM_SEGMENTS_PER_SESSION * SEGMENT_SIZE]; //may overflow stack, create on heap
     volatile bool readCacheIsSegmentReady[READ_CACHE_NUM_SEGMENTS_PER_SESSION];
 
     STORAGE_LIB_EXPORT BundleStorageManagerSession_ReadFromDisk();
@@ -90,34 +118,125 @@ public:
     STORAGE_LIB_EXPORT uint64_t PushAllSegments(BundleStorageManagerSession_WriteToDisk & session,
         const PrimaryBlock & bundlePrimaryBlock,
         const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize); //return total bytes pushed
+    //for a thread other than the one that owns the catalog: same as PushAllSegments but the bundle is left out of the catalog
+    //until the catalog owning thread passes session.catalogEntry to CatalogPushedBundle
+    STORAGE_LIB_EXPORT uint64_t PushAllSegmentsWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+        const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize); //return total bytes pushed
+    STORAGE_LIB_EXPORT bool CatalogPushedBundle(catalog_entry_t & catalogEntryToTake, const cbhe_bundle_uuid_t & bundleUuid, const uint64_t custodyId);
 
     //Read
     STORAGE_LIB_EXPORT uint64_t PopTop(BundleStorageManagerSession_ReadFromDisk & session, const std::vector<cbhe_eid_t> & availableDestinationEids); //0 if empty, size if entry
     STORAGE_LIB_EXPORT uint64_t PopTop(BundleStorageManagerSession_ReadFromDisk & session, const std::vector<uint64_t> & availableDestNodeIds); //0 if empty, size if entry
     STORAGE_LIB_EXPORT uint64_t PopTop(BundleStorageManagerSession_ReadFromDisk & session, const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests); //0 if empty, size if entry
+    STORAGE_LIB_EXPORT uint64_t PopTopFromReleaseIndex(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t releaseIndexId); //0 if empty, size if entry
+    STORAGE_LIB_EXPORT uint64_t CreateReleaseIndex(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests); //e.g. on link up, returns a nonzero releaseIndexId
+    STORAGE_LIB_EXPORT bool DeleteReleaseIndex(const uint64_t releaseIndexId); //e.g. on link down
     STORAGE_LIB_EXPORT bool ReturnTop(BundleStorageManagerSession_ReadFromDisk & session);
     STORAGE_LIB_EXPORT bool ReturnCustodyIdToAwaitingSend(const uint64_t custodyId); //for expired custody timers
     STORAGE_LIB_EXPORT catalog_entry_t * GetCatalogEntryPtrFromCustodyId(const uint64_t custodyId); //for deletion of custody timer
     STORAGE_LIB_EXPORT std::size_t TopSegment(BundleStorageManagerSession_ReadFromDisk & session, void * buf);
+    //read-ahead of a popped bundle: queue the reads of its first segments into the session's read cache without waiting
+    //(nor waiting for room in the disk queues), so that the later TopSegment or ReadAllSegments calls find them cached.
+    //A session with reads in flight must not be popped into again (or destroyed) until read or until WaitForReadAhead.
+    STORAGE_LIB_EXPORT void ReadAhead(BundleStorageManagerSession_ReadFromDisk & session);
+    STORAGE_LIB_EXPORT void WaitForReadAhead(BundleStorageManagerSession_ReadFromDisk & session); //e.g. before a ReturnTop of an unread session
     STORAGE_LIB_EXPORT bool ReadAllSegments(BundleStorageManagerSession_ReadFromDisk & session, std::vector<uint8_t> & buf);
+    //buf must hold the bundleSizeBytes of the session's catalog entry
+    STORAGE_LIB_EXPORT bool ReadAllSegments(BundleStorageManagerSession_ReadFromDisk & session, uint8_t * buf);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(const uint64_t custodyId);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(BundleStorageManagerSession_ReadFromDisk & sessionRead);
     STORAGE_LIB_EXPORT bool RemoveReadBundleFromDisk(const catalog_entry_t * catalogEntryPtr, const uint64_t custodyId);
+    //remove from disk up to maxBundlesToReap awaiting send bundles that expire before the threshold,
+    //returning the custody ids and destinations of the removed bundles and the number of bundle bytes reclaimed
+    STORAGE_LIB_EXPORT uint64_t ReapExpiredBundles(const uint64_t thresholdSecondsSinceStartOfYear2000, const std::size_t maxBundlesToReap,
+        std::vector<std::pair<uint64_t, cbhe_eid_t> > & reapedCustodyIdsAndDestEids);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
 
     STORAGE_LIB_EXPORT bool GetStorageExpiringBeforeThresholdTelemetry(StorageExpiringBeforeThresholdTelemetry_t& telem);
 
     STORAGE_LIB_EXPORT bool RestoreFromDisk(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored);
+    STORAGE_LIB_EXPORT bool RestoreFromCatalogJournal(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored);
 
     STORAGE_LIB_EXPORT const MemoryManagerTreeArray & GetMemoryManagerConstRef();
 
+    //hot tier: write to disk the bundles held longer than the write back delay (or all of them, e.g. before the disks are stopped),
+    //return the number of bundles written back
+    STORAGE_LIB_EXPORT std::size_t WriteBackAgedHotTierBundles();
+    STORAGE_LIB_EXPORT std::size_t WriteBackAllHotTierBundles();
+    STORAGE_LIB_EXPORT uint64_t GetNumHotTierHits() const; //bundles read from memory
+    STORAGE_LIB_EXPORT uint64_t GetNumHotTierMisses() const; //bundles read from disk while the hot tier is enabled
+    STORAGE_LIB_EXPORT uint64_t GetNumHotTierEvictions() const; //bundles written back to disk
+    STORAGE_LIB_EXPORT uint64_t GetNumHotTierWriteBacksCancelled() const; //bundles removed before being written to disk
+
 
 protected:
 
     
     virtual void CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) = 0;
 
+    //for disk producers: next circular buffer entry of the disk, waiting while the disk's circular buffer is full
+    //(the caller must hold the disk's m_circularIndexBufferProducerMutexes mutex until CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe)
+    STORAGE_LIB_EXPORT unsigned int GetCircularBufferIndexForWrite(const unsigned int diskId);
+    STORAGE_LIB_EXPORT bool PushSegmentWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+        const uint64_t custodyId, const uint8_t * buf, std::size_t size);
+    STORAGE_LIB_NO_EXPORT void QueueSegmentReads(BundleStorageManagerSession_ReadFromDisk & session, const bool waitWhileDiskQueueFull);
+    STORAGE_LIB_NO_EXPORT void WaitForCachedSegment(BundleStorageManagerSession_ReadFromDisk & session); //the segment at cacheReadIndex
+    STORAGE_LIB_EXPORT uint64_t PushAllSegmentsToDisk(BundleStorageManagerSession_WriteToDisk & session,
+        const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize); //return total bytes pushed
+
+    struct hot_tier_bundle_t {
+        BundleStorageManagerSession_WriteToDisk session; //the bundle's allocated segments, written to on write back
+        uint64_t custodyId;
+        std::vector<uint8_t> data;
+        boost::posix_time::ptime writeBackExpiry;
+    };
+    typedef std::list<hot_tier_bundle_t> hot_tier_fifo_t;
+    //return false (and leave the bundle to be written to disk) if the hot tier is disabled or the bundle is larger than the hot tier
+    STORAGE_LIB_NO_EXPORT bool InsertIntoHotTier(const BundleStorageManagerSession_WriteToDisk & session,
+        const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize);
+    STORAGE_LIB_NO_EXPORT void WriteBackHotTierBundle_NotThreadSafe(hot_tier_fifo_t::iterator it); //caller holds m_hotTierMutex
+    STORAGE_LIB_NO_EXPORT std::size_t WriteBackHotTierBundles(const bool writeBackAll);
+    STORAGE_LIB_NO_EXPORT bool WriteBackHotTierBundle(const segment_id_t headSegmentId); //return true if the bundle was in the hot tier
+    STORAGE_LIB_NO_EXPORT bool CancelHotTierWriteBack(const segment_id_t headSegmentId); //return true if the bundle was in the hot tier
+
+    //queue a whole segment write of size bytes of data (the rest of the segment is undefined)
+    STORAGE_LIB_NO_EXPORT void QueueSegmentWrite(const segment_id_t segmentId, const void * data, const std::size_t size);
+    //queue a whole segment read into a SEGMENT_SIZE buffer (aligned to STORAGE_BUFFER_ALIGNMENT_BYTES) and wait for it to complete
+    STORAGE_LIB_NO_EXPORT void ReadSegmentAndWait(const segment_id_t segmentId, volatile uint8_t * buf);
+
+    //small bundle size class: a slab segment holds a header followed by up to 64 slots of slotSizeBytes each
+    struct slab_t {
+        uint64_t slotSizeBytes;
+        unsigned int numSlots;
+        uint64_t liveSlotsMask; //slots allocated to a bundle
+        uint64_t unwrittenSlotsMask; //slots allocated but whose bundle has not yet been pushed
+        uint64_t freedWhileLoadingSlotsMask; //slots freed while the image is read back from the disk (marked once it arrives)
+        bool isLoadingImage;
+        bool isImageCached; //in m_cachedSlabImagesLru
+        std::list<segment_id_t>::iterator cachedImageIt;
+        std::vector<uint8_t> image; //the segment as last queued to disk, kept while open, while any slot is unwritten, or while cached
+    };
+    STORAGE_LIB_NO_EXPORT bool AllocateSlabSlot(catalog_entry_t & catalogEntry);
+    STORAGE_LIB_NO_EXPORT bool PushSlabSlotWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+        const uint64_t custodyId, const uint8_t * buf, std::size_t size);
+    STORAGE_LIB_NO_EXPORT bool FreeSlabSlot(const catalog_entry_t & catalogEntry);
+    STORAGE_LIB_NO_EXPORT bool RestoreSlabSlot_NotThreadSafe(const segment_id_t slabSegmentId, const uint32_t slabSlotOffset, const uint64_t slotSizeBytes);
+    STORAGE_LIB_NO_EXPORT void FreeAllSlabs_NotThreadSafe(); //undo of a failed restore
+    STORAGE_LIB_NO_EXPORT void CacheSlabImage_NotThreadSafe(const segment_id_t slabSegmentId, slab_t & slab); //caller holds m_slabMutex
+    STORAGE_LIB_NO_EXPORT bool DestroySlab_NotThreadSafe(std::unordered_map<segment_id_t, slab_t>::iterator it); //caller holds m_slabMutex
+    STORAGE_LIB_NO_EXPORT void DropCatalogJournal(); //after any failed journal write
+
+    //for disk consumers: number of circular buffer entries, beginning at firstIndex and limited to maxRunLength entries,
+    //that are all reads or all writes of segments at consecutive offsets on the disk (i.e. doable with one vectored operation)
+    STORAGE_LIB_EXPORT unsigned int GetContiguousSegmentRunLength_NotThreadSafe(const unsigned int diskId, const unsigned int firstIndex, const unsigned int maxRunLength) const;
+#ifndef _WIN32
+    //one preadv/pwritev of whole segments starting at offsetBytes (retried on partial transfers),
+    //returns the number of bytes transferred with errno set if less than requested (0 for end of file)
+    STORAGE_LIB_EXPORT static std::size_t DoPositionalVectoredSegmentIo(const int fileDescriptor, struct iovec * iovecs,
+        unsigned int numIovecs, uint64_t offsetBytes, const bool isReadOperation);
+#endif
+
 protected:
     StorageConfig_ptr m_storageConfigPtr;
 public:
@@ -132,6 +251,8 @@ protected:
     std::vector<boost::filesystem::path> m_filePathsVec;
     std::vector<std::string> m_filePathsAsStringVec;
     std::vector<CircularIndexBufferSingleProducerSingleConsumerConfigurable> m_circularIndexBuffersVec;
+    //serializes the (otherwise single) producers of each disk's circular buffer, e.g. storage writer and release threads
+    std::unique_ptr<boost::mutex[]> m_circularIndexBufferProducerMutexes;
 
     uint8_t * m_circularBufferBlockDataPtr;
     segment_id_t * m_circularBufferSegmentIdsPtr;
@@ -140,12 +261,37 @@ protected:
     volatile bool * volatile m_circularBufferIsReadCompletedPointers[CIRCULAR_INDEX_BUFFER_SIZE * MAX_NUM_STORAGE_THREADS];
     volatile uint8_t * volatile m_circularBufferReadFromStoragePointers[CIRCULAR_INDEX_BUFFER_SIZE * MAX_NUM_STORAGE_THREADS];
     volatile bool m_autoDeleteFilesOnExit;
+    std::unique_ptr<CatalogJournal> m_catalogJournalPtr; //NULL if no catalog journal
+
+    //hot tier, filled by the thread(s) pushing bundles and read and removed from by the thread releasing bundles
+    const uint64_t M_HOT_TIER_CACHE_BYTES; //0 if disabled
+    const boost::posix_time::time_duration M_HOT_TIER_WRITE_BACK_DELAY;
+    mutable boost::mutex m_hotTierMutex; //held while a write back is queued so that a subsequent disk read of the bundle is queued after it
+    hot_tier_fifo_t m_hotTierFifo; //oldest first
+    //keyed by head segment id, which (unlike a custody id which may be freed and reused before its bundle is removed)
+    //is unique while the bundle's segments are allocated
+    std::unordered_map<segment_id_t, hot_tier_fifo_t::iterator> m_hotTierHeadSegmentIdToFifoIteratorMap;
+    uint64_t m_hotTierBytes;
+    uint64_t m_numHotTierHits;
+    uint64_t m_numHotTierMisses;
+    uint64_t m_numHotTierEvictions;
+    uint64_t m_numHotTierWriteBacksCancelled;
+
+    //size classes
+    const uint64_t M_SLAB_SLOT_SIZE_BYTES; //0 if small bundles are not packed into slabs
+    const uint64_t M_LARGE_BUNDLE_EXTENT_MIN_BYTES; //0 if large bundles are not rounded up to whole 64 segment extents
+    boost::mutex m_slabMutex;
+    std::unordered_map<segment_id_t, slab_t> m_slabsMap;
+    segment_id_t m_openSlabSegmentId; //the slab new slots are allocated from, SEGMENT_ID_LAST if none
+    std::list<segment_id_t> m_cachedSlabImagesLru; //sealed and fully written slabs whose image is kept, least recently used first
     
 public:
     bool m_successfullyRestoredFromDisk;
+    bool m_restoredFromCatalogJournal;
     uint64_t m_totalBundlesRestored;
     uint64_t m_totalBytesRestored;
     uint64_t m_totalSegmentsRestored;
+    double m_restoreElapsedSeconds;
 };
 
 
@@ -0,0 +1,57 @@
+/**
+ * @file BundleStorageManagerIoUring.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This BundleStorageManagerIoUring class inherits from the BundleStorageManagerBase class and implements
+ * writing and reading bundles to and from solid state disk drive(s) using the Linux io_uring interface
+ * (1 submission/completion ring and 1 thread per disk drive).  Unlike BundleStorageManagerMT, which has only
+ * one segment operation outstanding per disk, this class keeps up to StorageConfig::m_diskQueueDepth segment reads
+ * and writes in flight per disk (bounded by the disk's circular buffer) without needing a thread per operation.
+ * Writes use io_uring registered (fixed) buffers drawn from the disk's portion of the circular buffer block data,
+ * and the files may optionally be opened with O_DIRECT (see StorageConfig::m_useDirectIo).
+ * This class is only available on Linux when compiled with STORAGE_IO_URING_SUPPORT_ENABLED.
+ */
+
+#ifndef _BUNDLE_STORAGE_MANAGER_IO_URING_H
+#define _BUNDLE_STORAGE_MANAGER_IO_URING_H 1
+
+#include "BundleStorageManagerBase.h"
+
+
+class CLASS_VISIBILITY_STORAGE_LIB BundleStorageManagerIoUring : public BundleStorageManagerBase {
+public:
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring();
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring(const std::string & jsonConfigFileName);
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring(const StorageConfig_ptr & storageConfigPtr);
+    STORAGE_LIB_EXPORT virtual ~BundleStorageManagerIoUring();
+    STORAGE_LIB_EXPORT virtual void Start();
+
+
+private:
+    struct DiskRing;
+    STORAGE_LIB_NO_EXPORT void StopAllDiskThreads();
+    STORAGE_LIB_NO_EXPORT void ThreadFunc(unsigned int diskId);
+    STORAGE_LIB_NO_EXPORT virtual void CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId);
+private:
+    const unsigned int M_DISK_QUEUE_DEPTH;
+
+    std::vector<std::unique_ptr<DiskRing> > m_diskRingPtrsVec;
+    std::vector<std::unique_ptr<boost::thread> > m_threadPtrsVec;
+
+    volatile bool m_running;
+    volatile bool m_noFatalErrorsOccurred;
+};
+
+
+#endif //_BUNDLE_STORAGE_MANAGER_IO_URING_H
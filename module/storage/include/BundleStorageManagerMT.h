@@ -16,6 +16,8 @@
  * This BundleStorageManagerMT class inherits from the BundleStorageManagerBase class and implements
  * writing and reading bundles to and from solid state disk drive(s) using 1 thread per disk drive (i.e. 1 thread per storeFilePath)
  * and uses cross-platform blocking synchronous I/O operations from stdio.h such as fwrite.
+ * On non-Windows platforms, queued segments that are adjacent on a disk are written or read with a single
+ * positional pwritev/preadv on the file's descriptor.
  */
 
 #ifndef _BUNDLE_STORAGE_MANAGER_MT_H
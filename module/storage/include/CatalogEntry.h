@@ -15,6 +15,9 @@
  *
  * This CatalogEntry class defines the data structures for storing key information
  * about bundles in memory and is used by the BundleStorageCatalog class.
+ * A bundle's segments are stored as a compact list of extents (runs of consecutive segment IDs)
+ * rather than one segment ID per segment, except for a small bundle packed into a slot of a shared slab segment,
+ * which has a single extent of that one segment and a nonzero slabSlotOffset.
  */
 
 #ifndef _CATALOG_ENTRY_H
@@ -27,11 +30,12 @@
 
 struct catalog_entry_t {
     uint64_t bundleSizeBytes;
-    segment_id_chain_vec_t segmentIdChainVec;
+    segment_id_extent_vec_t segmentIdExtentVec;
     cbhe_eid_t destEid;
     uint64_t encodedAbsExpirationAndCustodyAndPriority;
     uint64_t sequence;
     const void * ptrUuidKeyInMap;
+    uint32_t slabSlotOffset; //byte offset of the bundle's slot within its (one) slab segment, or 0 if the bundle owns its segments
 
     STORAGE_LIB_EXPORT catalog_entry_t(); //a default constructor: X()
     STORAGE_LIB_EXPORT ~catalog_entry_t(); //a destructor: ~X()
@@ -48,7 +52,9 @@ struct catalog_entry_t {
     STORAGE_LIB_EXPORT bool HasCustodyAndFragmentation() const;
     STORAGE_LIB_EXPORT bool HasCustodyAndNonFragmentation() const;
     STORAGE_LIB_EXPORT bool HasCustody() const;
-    STORAGE_LIB_EXPORT void Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, const uint64_t paramNumSegmentsRequired, void * paramPtrUuidKeyInMap);
+    STORAGE_LIB_EXPORT uint64_t GetNumSegments() const;
+    STORAGE_LIB_EXPORT bool IsInSlab() const;
+    STORAGE_LIB_EXPORT void Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, void * paramPtrUuidKeyInMap);
 };
 
 #endif //_CATALOG_ENTRY_H
@@ -0,0 +1,100 @@
+/**
+ * @file CatalogJournal.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This CatalogJournal class implements an optional append-only, memory mapped journal of the bundle storage catalog
+ * so that BundleStorageManagerBase can restore the catalog on startup by replaying the journal
+ * instead of reading the reserved header of every segment on every disk.
+ * The journal file is a header (storage geometry) followed by CRC32C protected records.
+ * It always begins with a checkpoint (the insert records of every live bundle followed by a checkpoint end record),
+ * after which bundle insert and remove records are appended.  A checkpoint is written to a temporary file
+ * which atomically replaces the journal on commit, and the journal is compacted (checkpointed) whenever
+ * it fills and at least half of it is removed bundles, so a crash leaves either the old or the new journal intact.
+ * On replay, the first record that fails validation after the checkpoint is treated as the torn end of the journal.
+ * The class is not thread safe and is driven by the same thread as the BundleStorageCatalog.
+ */
+
+#ifndef _CATALOG_JOURNAL_H
+#define _CATALOG_JOURNAL_H 1
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include "CatalogEntry.h"
+#include "OpenAddressingHashMap.h"
+#include "codec/Cbhe.h"
+#include "storage_lib_export.h"
+
+struct catalog_journal_entry_t {
+    uint64_t custodyId;
+    cbhe_bundle_uuid_t bundleUuid;
+    catalog_entry_t catalogEntry;
+};
+
+class CatalogJournal {
+private:
+    CatalogJournal();
+public:
+    STORAGE_LIB_EXPORT CatalogJournal(const std::string & filePath, const unsigned int numStorageDisks, const uint64_t totalStorageCapacityBytes);
+    STORAGE_LIB_EXPORT ~CatalogJournal();
+    CatalogJournal(const CatalogJournal &) = delete;
+    CatalogJournal & operator=(const CatalogJournal &) = delete;
+
+    //the live (inserted and not removed) bundles in the order they were inserted,
+    //return false if the journal doesn't exist, was written for a different storage geometry, or fails validation
+    STORAGE_LIB_EXPORT bool ReadLiveEntries(std::vector<catalog_journal_entry_t> & liveEntries) const;
+
+    //start a new (empty) journal in a temporary file, which replaces the journal once committed
+    STORAGE_LIB_EXPORT bool BeginCheckpoint();
+    STORAGE_LIB_EXPORT bool CommitCheckpoint();
+
+    STORAGE_LIB_EXPORT bool AppendInsert(const uint64_t custodyId, const catalog_entry_t & catalogEntry, const cbhe_bundle_uuid_t & bundleUuid);
+    STORAGE_LIB_EXPORT bool AppendRemove(const uint64_t custodyId);
+    STORAGE_LIB_EXPORT bool Flush(); //synchronously write dirty pages to the disk
+    //unmap and delete the journal (and any checkpoint in progress) once it no longer matches the catalog,
+    //so that the next start can never replay it and restores by reading every segment instead
+    STORAGE_LIB_EXPORT void Delete();
+
+    STORAGE_LIB_EXPORT std::size_t GetNumLiveEntries() const;
+    STORAGE_LIB_EXPORT uint64_t GetNumCompactions() const;
+    STORAGE_LIB_EXPORT uint64_t GetSizeBytes() const;
+    STORAGE_LIB_EXPORT uint64_t GetUsedBytes() const;
+    STORAGE_LIB_EXPORT const std::string & GetFilePath() const;
+
+private:
+    struct MappedFile;
+    STORAGE_LIB_NO_EXPORT bool AppendRecord(const uint8_t * record, const uint64_t recordLength, const uint64_t insertCustodyId);
+    STORAGE_LIB_NO_EXPORT bool MakeRoom(const uint64_t recordLength);
+    STORAGE_LIB_NO_EXPORT bool Compact();
+    STORAGE_LIB_NO_EXPORT bool Grow(const uint64_t minSizeBytes);
+    STORAGE_LIB_NO_EXPORT void WriteHeader(uint8_t * data) const;
+    STORAGE_LIB_NO_EXPORT bool IsHeaderValid(const uint8_t * data, const uint64_t sizeBytes) const;
+private:
+    const std::string M_FILE_PATH;
+    const std::string M_CHECKPOINT_FILE_PATH;
+    const unsigned int M_NUM_STORAGE_DISKS;
+    const uint64_t M_TOTAL_STORAGE_CAPACITY_BYTES;
+
+    std::unique_ptr<MappedFile> m_mappedFilePtr; //the journal, or the checkpoint while one is in progress
+    bool m_checkpointInProgress;
+    uint64_t m_appendOffset;
+    uint64_t m_liveRecordBytes;
+    uint64_t m_numRecordsSinceFlush;
+    uint64_t m_numCompactions;
+    OpenAddressingHashMap<uint64_t, uint64_t> m_liveCustodyIdToRecordOffsetMap;
+    std::vector<uint8_t> m_recordBuffer;
+};
+
+#endif //_CATALOG_JOURNAL_H
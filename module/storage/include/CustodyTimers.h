@@ -14,6 +14,12 @@
  * @section DESCRIPTION
  *
  * This CustodyTimers class defines methods for knowing when to retransmit a bundle from storage.
+ * Timers live in a hierarchical timer wheel (6 levels of 64 slots at a 1 millisecond tick) so that
+ * starting or cancelling a timer is O(1) and expiry is amortized O(1) regardless of the number of destinations.
+ * Each timer is also linked into a fifo list of its final destination so that the expired timers of
+ * just the currently available destinations can be polled.  Timer nodes are recycled from a pool and
+ * indexed by custody id in an OpenAddressingHashMap, so starting a timer does not allocate.
+ * A timer never fires early, but may fire up to 1 millisecond late.
  */
 
 #ifndef _CUSTODY_TIMERS_H
@@ -21,11 +27,12 @@
 
 #include <cstdint>
 #include <map>
-#include <list>
+#include <vector>
 #include <utility>
 #include <string>
 #include "codec/bpv6.h"
 #include <boost/date_time.hpp>
+#include "OpenAddressingHashMap.h"
 #include "storage_lib_export.h"
 
 class CustodyTimers {
@@ -44,15 +51,55 @@ public:
     STORAGE_LIB_EXPORT std::size_t GetNumCustodyTransferTimers(const cbhe_eid_t & finalDestEid);
 
 protected:
-    typedef std::pair<uint64_t, boost::posix_time::ptime> custid_ptime_pair_t;
-    typedef std::list<custid_ptime_pair_t> custid_ptime_list_t;
-    typedef std::map<uint64_t, custid_ptime_list_t::iterator> custid_to_listiterator_map_t;
-    typedef std::pair<uint64_t, custid_ptime_list_t::iterator> custid_to_listiterator_map_insertion_element_t;
-    typedef std::map<cbhe_eid_t, custid_ptime_list_t> desteid_to_custidexpirylist_map_t;
+    static constexpr unsigned int WHEEL_LEVEL_BITS = 6;
+    static constexpr unsigned int WHEEL_SLOTS_PER_LEVEL = 1u << WHEEL_LEVEL_BITS; //64 (one bit each in a uint64_t occupancy mask)
+    static constexpr unsigned int WHEEL_NUM_LEVELS = 6; //2^36 ms (about 2 years) horizon
+    static constexpr unsigned int EXPIRED_LIST_INDEX = WHEEL_NUM_LEVELS * WHEEL_SLOTS_PER_LEVEL;
+    static constexpr uint32_t NIL_INDEX = UINT32_MAX;
 
-    desteid_to_custidexpirylist_map_t m_mapDestEidToCustodyIdExpiryList;
-    custid_to_listiterator_map_t m_mapCustodyIdToListIterator;
+    struct eid_timers_t;
+    struct links_t {
+        uint32_t prev;
+        uint32_t next;
+    };
+    struct timer_t {
+        uint64_t custodyId;
+        uint64_t expiryTick;
+        eid_timers_t * eidTimersPtr;
+        uint32_t wheelListIndex; //wheel slot or EXPIRED_LIST_INDEX
+        links_t wheelLinks; //also links the free list
+        links_t eidLinks;
+    };
+    struct list_t {
+        uint32_t head;
+        uint32_t tail;
+        list_t() : head(NIL_INDEX), tail(NIL_INDEX) {}
+    };
+    struct eid_timers_t {
+        list_t list; //fifo (start order is expiry order)
+        std::size_t size;
+        eid_timers_t() : size(0) {}
+    };
+    typedef std::map<cbhe_eid_t, eid_timers_t> desteid_to_timers_map_t; //entries are never erased so that eidTimersPtr stays valid
 
+    STORAGE_LIB_NO_EXPORT void PushBack(list_t & list, const uint32_t timerIndex, links_t timer_t::* links);
+    STORAGE_LIB_NO_EXPORT void Unlink(list_t & list, const uint32_t timerIndex, links_t timer_t::* links);
+    STORAGE_LIB_NO_EXPORT void InsertIntoWheel(const uint32_t timerIndex);
+    STORAGE_LIB_NO_EXPORT void UnlinkFromWheel(const uint32_t timerIndex);
+    STORAGE_LIB_NO_EXPORT void AdvanceWheelTo(const uint64_t nowTick);
+    STORAGE_LIB_NO_EXPORT void RemoveTimer(const uint32_t timerIndex);
+    STORAGE_LIB_NO_EXPORT uint64_t PtimeToTick(const boost::posix_time::ptime & ptime, const bool roundUp) const;
+
+    std::vector<timer_t> m_timers;
+    uint32_t m_freeTimersHead;
+    OpenAddressingHashMap<uint64_t, uint64_t> m_mapCustodyIdToTimerIndex;
+    desteid_to_timers_map_t m_mapDestEidToTimers;
+    list_t m_wheelLists[EXPIRED_LIST_INDEX + 1];
+    uint64_t m_wheelOccupancyMasks[WHEEL_NUM_LEVELS];
+    uint64_t m_wheelCurrentTick; //every timer in the wheel (not the expired list) expires after this tick
+    std::size_t m_numTimersInWheel;
+
+    const boost::posix_time::ptime M_EPOCH; //tick 0
     const boost::posix_time::time_duration M_CUSTODY_TIMEOUT_DURATION;
 };
 
@@ -15,6 +15,13 @@
  *
  * The MemoryManagerTreeArray class is used for fast allocation/deallocation
  * of 4KByte segments for bundle storage.
+ * The thread safe allocate/free functions either serialize on one mutex (the default), or, in lock-free mode,
+ * claim and release bits of the same tree with atomic compare-and-swap/fetch operations and keep a small
+ * magazine of pre-claimed segment IDs per thread.  Both modes share the same bit layout, so the
+ * _NotThreadSafe functions (e.g. AllocateSegmentId_NotThreadSafe used by restore from disk) work with either mode.
+ * Large bundles should be allocated as extents (runs of consecutive segment IDs), which are claimed a whole free
+ * leaf uint64_t (64 segments) at a time, so that they are described compactly and read/written sequentially on disk
+ * (optionally rounded up to whole leaf uint64_t's so that the last partial run is contiguous too).
  */
 
 #ifndef _MEMORY_MANAGER_TREE_ARRAY_H
@@ -25,11 +32,51 @@
 #include "BundleStorageConfig.h"
 #include <boost/thread.hpp>
 #include <vector>
+#include <memory>
 #include "storage_lib_export.h"
 
 
 typedef std::vector<segment_id_t> segment_id_chain_vec_t;
 
+//a run of numSegments consecutive segment ids beginning at startSegmentId
+struct segment_id_extent_t {
+    segment_id_t startSegmentId;
+    segment_id_t numSegments;
+
+    segment_id_extent_t() : startSegmentId(0), numSegments(0) {}
+    segment_id_extent_t(const segment_id_t paramStartSegmentId, const segment_id_t paramNumSegments) :
+        startSegmentId(paramStartSegmentId), numSegments(paramNumSegments) {}
+    bool operator==(const segment_id_extent_t & o) const {
+        return (startSegmentId == o.startSegmentId) && (numSegments == o.numSegments);
+    }
+    bool operator!=(const segment_id_extent_t & o) const {
+        return (startSegmentId != o.startSegmentId) || (numSegments != o.numSegments);
+    }
+};
+typedef std::vector<segment_id_extent_t> segment_id_extent_vec_t;
+
+//walks the segment ids of a segment_id_extent_vec_t in logical order
+struct segment_id_extent_cursor_t {
+    std::size_t extentIndex;
+    segment_id_t offsetInExtent;
+
+    segment_id_extent_cursor_t() : extentIndex(0), offsetInExtent(0) {}
+    void Reset() {
+        extentIndex = 0;
+        offsetInExtent = 0;
+    }
+    //SEGMENT_ID_LAST once every segment id has been walked
+    segment_id_t Get(const segment_id_extent_vec_t & extentVec) const {
+        return (extentIndex < extentVec.size()) ? (extentVec[extentIndex].startSegmentId + offsetInExtent) : SEGMENT_ID_LAST;
+    }
+    void Advance(const segment_id_extent_vec_t & extentVec) {
+        if (++offsetInExtent >= extentVec[extentIndex].numSegments) {
+            ++extentIndex;
+            offsetInExtent = 0;
+        }
+    }
+};
+
 typedef std::vector< std::vector<uint64_t> > memmanager_t;
 
 class MemoryManagerTreeArray {
@@ -44,6 +91,17 @@ public:
     *        Memory requirements for this class is approximately 1 bit per segment.
     */
     STORAGE_LIB_EXPORT MemoryManagerTreeArray(const uint64_t maxSegments);
+
+    /**
+    * Constructor that sets the max number of segments that can be allocated, the thread safe allocation mode,
+    * and sets up internal data structures.
+    *
+    * @param maxSegments The max number of segments that can be allocated.
+    * @param useLockFreeAllocation If True, AllocateSegments_ThreadSafe and FreeSegments_ThreadSafe are lock-free (CAS at the leaf level
+    *        with per-thread magazines of pre-claimed segment IDs).  Segment IDs are then no longer guaranteed to be the
+    *        first available in numerical order, and segments held in magazines appear allocated until ReturnCachedSegments_ThreadSafe() is called.
+    */
+    STORAGE_LIB_EXPORT MemoryManagerTreeArray(const uint64_t maxSegments, const bool useLockFreeAllocation);
     STORAGE_LIB_EXPORT ~MemoryManagerTreeArray();
 
     /** Thread safe method to allocate a vector of the first available free segment numbers in numerical order.
@@ -64,6 +122,64 @@ public:
      */
     STORAGE_LIB_EXPORT bool FreeSegments_ThreadSafe(const segment_id_chain_vec_t & segmentVec);
 
+    /** Thread safe method to allocate the given number of segments as a list of extents (runs of consecutive segment IDs).
+     * Whole free leaf uint64_t's (64 free segments each) are claimed first, with neighboring ones merged into one extent,
+     * and any remainder is filled with the first available free segments.
+     *
+     * @param numSegments The number of segments to allocate.
+     * @param extentVec The extents, sorted by ascending startSegmentId with no two extents adjacent.  Will be cleared on failure.
+     * @return True if all numSegments segments were allocated, or False otherwise (the extentVec is then empty).
+     * @post The internal data structures are updated if and only if the MemoryManagerTreeArray was able to allocate all numSegments segments.
+     */
+    STORAGE_LIB_EXPORT bool AllocateSegmentExtents_ThreadSafe(const uint64_t numSegments, segment_id_extent_vec_t & extentVec);
+
+    /** Thread safe method to allocate the given number of segments as a list of extents (runs of consecutive segment IDs).
+     * If roundUpToWholeLeaves is True, the remainder is also taken from a whole free leaf uint64_t (whose unused tail is freed again),
+     * so that a large bundle only falls back to first available free segments when too few whole free leaf uint64_t's remain.
+     *
+     * @param numSegments The number of segments to allocate.
+     * @param extentVec The extents, sorted by ascending startSegmentId with no two extents adjacent.  Will be cleared on failure.
+     * @param roundUpToWholeLeaves If False, identical to AllocateSegmentExtents_ThreadSafe(numSegments, extentVec).
+     * @return True if all numSegments segments were allocated, or False otherwise (the extentVec is then empty).
+     * @post The internal data structures are updated if and only if the MemoryManagerTreeArray was able to allocate all numSegments segments.
+     */
+    STORAGE_LIB_EXPORT bool AllocateSegmentExtents_ThreadSafe(const uint64_t numSegments, segment_id_extent_vec_t & extentVec, const bool roundUpToWholeLeaves);
+
+    /** Thread safe method to free a list of extents.
+     *
+     * @param extentVec The extents of segments to mark as free in the internal data structure.
+     * @return True if every segment of every extent was freed, or False otherwise.
+     * @post The internal data structures are updated for only the segment IDs that were allocated (now they are marked free).
+     */
+    STORAGE_LIB_EXPORT bool FreeSegmentExtents_ThreadSafe(const segment_id_extent_vec_t & extentVec);
+
+    /** Append a segment ID to the end of a list of extents, growing the last extent if the segment ID immediately follows it.
+     *
+     * @param extentVec The extents to append to.
+     * @param segmentId The segment ID to append.
+     */
+    STORAGE_LIB_EXPORT static void AppendSegmentIdToExtents(segment_id_extent_vec_t & extentVec, const segment_id_t segmentId);
+
+    /** Get the total number of segments described by a list of extents.
+     *
+     * @param extentVec The extents to count.
+     * @return The sum of the numSegments of every extent.
+     */
+    STORAGE_LIB_EXPORT static uint64_t GetNumSegmentsInExtents(const segment_id_extent_vec_t & extentVec);
+
+    /** Thread safe method to return every pre-claimed segment held in the per-thread magazines back to the tree (lock-free mode only, no-op otherwise).
+     * Call this (with no concurrent allocations) before comparing or backing up the internal data structure.
+     *
+     * @post All segments not handed out by AllocateSegments_ThreadSafe are marked free in the internal data structures.
+     */
+    STORAGE_LIB_EXPORT void ReturnCachedSegments_ThreadSafe();
+
+    /** Get the thread safe allocation mode.
+     *
+     * @return True if AllocateSegments_ThreadSafe and FreeSegments_ThreadSafe are lock-free, or False if they use a mutex.
+     */
+    STORAGE_LIB_EXPORT bool IsLockFreeAllocation() const;
+
     /** Test if the specified segment is free.
      *
      * @param segmentId The segment to be tested.
@@ -116,13 +232,35 @@ public:
 private:
 
 
+    struct SegmentMagazine;
+
     STORAGE_LIB_NO_EXPORT bool GetAndSetFirstFreeSegmentId(const segment_id_t depthIndex, segment_id_t & segmentId);
     STORAGE_LIB_NO_EXPORT void AllocateRows(const segment_id_t largestSegmentId);
     STORAGE_LIB_NO_EXPORT void AllocateRowsMaxMemory();
+    STORAGE_LIB_NO_EXPORT void InitWholeFreeHints();
+
+    STORAGE_LIB_NO_EXPORT bool AllocateSegments_LockFree(segment_id_chain_vec_t & segmentVec);
+    STORAGE_LIB_NO_EXPORT bool FreeSegments_LockFree(const segment_id_chain_vec_t & segmentVec);
+    STORAGE_LIB_NO_EXPORT unsigned int ClaimSegmentsFromTree_LockFree(const std::size_t maxCount, segment_id_t * segmentIds);
+    STORAGE_LIB_NO_EXPORT bool FreeSegmentId_LockFree(const segment_id_t segmentId);
+    STORAGE_LIB_NO_EXPORT void ClearFullHintsUpward_LockFree(segment_id_t depthIndex, segment_id_t longIndex);
+    STORAGE_LIB_NO_EXPORT void SetHintsUpward_LockFree(segment_id_t depthIndex, segment_id_t longIndex);
+    STORAGE_LIB_NO_EXPORT SegmentMagazine & GetThisThreadsMagazine();
+
+    STORAGE_LIB_NO_EXPORT void SetWholeFreeHintsUpward(segment_id_t depthIndex, segment_id_t longIndex);
+    STORAGE_LIB_NO_EXPORT void SetWholeFreeHintIfWholeFree(const segment_id_t longIndex, const uint64_t leafLong);
+    STORAGE_LIB_NO_EXPORT void ClearWholeFreeHintsUpward(segment_id_t depthIndex, segment_id_t longIndex);
+    STORAGE_LIB_NO_EXPORT uint64_t ClaimWholeFreeLeafLongs(const uint64_t maxLongs, segment_id_extent_vec_t & extentVec);
+    STORAGE_LIB_NO_EXPORT bool FreeSegmentRun(const segment_id_t startSegmentId, const segment_id_t numSegments);
 private:
     const uint64_t M_MAX_SEGMENTS;
+    const bool M_USE_LOCK_FREE_ALLOCATION;
     std::vector<std::vector<uint64_t> > m_bitMasks;
+    //one bit per leaf uint64_t (in rows shaped like the upper rows of m_bitMasks), set if it may be whole free (all 64 segments free).
+    //Set by every free that makes a leaf uint64_t whole free, and cleared lazily by ClaimWholeFreeLeafLongs when found stale.
+    std::vector<std::vector<uint64_t> > m_wholeFreeHints;
     boost::mutex m_mutex;
+    std::unique_ptr<SegmentMagazine[]> m_magazines; //lock-free mode only
 };
 
 
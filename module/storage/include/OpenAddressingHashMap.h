@@ -0,0 +1,102 @@
+/**
+ * @file OpenAddressingHashMap.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * This templated OpenAddressingHashMap class is a drop in replacement for HashMap16BitFixedSize
+ * that scales to many millions of stored bundles.  The table is resizable (power of 2 capacity, max load of 7/8)
+ * and uses open addressing with linear probing over an array of 1-byte control codes (empty, deleted, or
+ * 7 bits of the key's 64-bit hash) so that a lookup almost never compares a key that doesn't match.
+ * The key/value pairs themselves live in a pool of fixed address nodes (allocated in large chunks and recycled)
+ * so that the pointers returned by Insert and GetValuePtr remain valid until that key is removed,
+ * which the BundleStorageCatalog relies on, and so that an insert does not require a heap allocation.
+ */
+
+#ifndef _OPEN_ADDRESSING_HASH_MAP_H
+#define _OPEN_ADDRESSING_HASH_MAP_H 1
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "codec/bpv6.h"
+#include "storage_lib_export.h"
+
+template <typename keyType, typename valueType>
+class OpenAddressingHashMap {
+public:
+    typedef std::pair<keyType, valueType> key_value_pair_t;
+
+
+    STORAGE_LIB_EXPORT OpenAddressingHashMap();
+    STORAGE_LIB_EXPORT ~OpenAddressingHashMap();
+    OpenAddressingHashMap(const OpenAddressingHashMap &) = delete;
+    OpenAddressingHashMap & operator=(const OpenAddressingHashMap &) = delete;
+
+    STORAGE_LIB_EXPORT static uint64_t GetHash(const cbhe_bundle_uuid_t & bundleUuid);
+    STORAGE_LIB_EXPORT static uint64_t GetHash(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
+    STORAGE_LIB_EXPORT static uint64_t GetHash(const uint64_t key);
+
+    //return ptr of inserted pair if inserted, NULL if already exists
+    STORAGE_LIB_EXPORT const key_value_pair_t * Insert(const keyType & key, const valueType & value);
+    STORAGE_LIB_EXPORT const key_value_pair_t * Insert(const keyType & key, valueType && value);
+    STORAGE_LIB_EXPORT const key_value_pair_t * Insert(const uint64_t hash, const keyType & key, const valueType & value);
+    STORAGE_LIB_EXPORT const key_value_pair_t * Insert(const uint64_t hash, const keyType & key, valueType && value);
+
+    //return true if exists, false if key doesn't exist in the map
+    STORAGE_LIB_EXPORT bool GetValueAndRemove(const keyType & key, valueType & value);
+    STORAGE_LIB_EXPORT bool GetValueAndRemove(const uint64_t hash, const keyType & key, valueType & value);
+
+    //return ptr if exists, NULL if key doesn't exist in the map
+    STORAGE_LIB_EXPORT valueType * GetValuePtr(const keyType & key);
+    STORAGE_LIB_EXPORT valueType * GetValuePtr(const uint64_t hash, const keyType & key);
+
+    STORAGE_LIB_EXPORT std::size_t GetSize() const;
+    STORAGE_LIB_EXPORT std::size_t GetCapacity() const;
+
+    STORAGE_LIB_EXPORT void Clear();
+
+
+private:
+    struct node_t {
+        key_value_pair_t keyValuePair;
+        uint64_t hash; //kept so the table can be rehashed even when the caller supplied the hash
+        template <typename valueArgType>
+        node_t(const uint64_t paramHash, const keyType & key, valueArgType && value) :
+            keyValuePair(key, std::forward<valueArgType>(value)), hash(paramHash) {}
+    };
+    typedef typename std::aligned_storage<sizeof(node_t), alignof(node_t)>::type node_storage_t;
+
+    STORAGE_LIB_NO_EXPORT std::size_t FindSlotIndex(const uint64_t hash, const keyType & key) const; //returns m_capacity if not found
+    STORAGE_LIB_NO_EXPORT void InitTable(const std::size_t capacity);
+    STORAGE_LIB_NO_EXPORT void Rehash(const std::size_t newCapacity);
+    STORAGE_LIB_NO_EXPORT void * AllocateNode();
+    STORAGE_LIB_NO_EXPORT void FreeNode(node_t * node);
+    STORAGE_LIB_NO_EXPORT void DestroyAllNodes();
+private:
+    std::size_t m_capacity; //power of 2
+    std::size_t m_size;
+    std::size_t m_numDeleted;
+    std::unique_ptr<uint8_t[]> m_controls;
+    std::unique_ptr<node_t*[]> m_slots;
+
+    //fixed address node pool
+    std::vector<std::unique_ptr<node_storage_t[]> > m_nodeChunks;
+    std::size_t m_numNodesUsedInLastChunk;
+    std::size_t m_lastChunkNumNodes;
+    std::vector<node_t*> m_freeNodes;
+};
+
+
+#endif //_OPEN_ADDRESSING_HASH_MAP_H
@@ -0,0 +1,67 @@
+/**
+ * @file ReadAheadSessions.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The ReadAheadSessions class holds the read sessions of the bundles that storage's release stage pops
+ * for its up links ahead of their release, so that their reads from disk are in flight before they are sent.
+ * Each link keeps the sessions it popped in a queue (in release order); the sessions themselves (each with
+ * its own read cache) are bounded in number and reused from a free list due to their expensive heap allocation.
+ * All functions must be called from the thread that owns the storage catalog.
+ */
+
+#ifndef _READ_AHEAD_SESSIONS_H
+#define _READ_AHEAD_SESSIONS_H 1
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "BundleStorageManagerBase.h"
+#include "storage_lib_export.h"
+
+class ReadAheadSessions {
+private:
+    ReadAheadSessions();
+public:
+    typedef std::unique_ptr<BundleStorageManagerSession_ReadFromDisk> session_ptr_t;
+    typedef std::deque<session_ptr_t> queue_t; //one per link, its popped bundles whose reads are in flight, in release order
+
+    STORAGE_LIB_EXPORT ReadAheadSessions(const std::size_t maxBundlesPerQueue, const std::size_t maxSessions);
+    STORAGE_LIB_EXPORT ~ReadAheadSessions();
+    ReadAheadSessions(const ReadAheadSessions &) = delete;
+    ReadAheadSessions & operator=(const ReadAheadSessions &) = delete;
+
+    //pop the next bundles of releaseIndexId into queue and start reading them, until the queue holds maxBundlesPerQueue
+    //or no session or bundle is left
+    STORAGE_LIB_EXPORT void Fill(BundleStorageManagerBase & bsm, queue_t & queue, const uint64_t releaseIndexId);
+    //back to the free sessions, a session taken from the front of a queue once it has been read
+    STORAGE_LIB_EXPORT void Free(session_ptr_t && sessionPtr);
+    //return the bundles of queue to the awaiting send (e.g. on link down), most recently popped first so that they keep their order
+    STORAGE_LIB_EXPORT void ReturnAll(BundleStorageManagerBase & bsm, queue_t & queue);
+    //drop the bundle of custodyId from queue (e.g. before a custody signal removes it from storage), waiting for its reads so that
+    //none lands in its freed segments; the bundle is not returned to the awaiting send.  Returns false if not in queue.
+    STORAGE_LIB_EXPORT bool Cancel(BundleStorageManagerBase & bsm, queue_t & queue, const uint64_t custodyId);
+
+    STORAGE_LIB_EXPORT std::size_t GetNumSessionsAllocated() const;
+    STORAGE_LIB_EXPORT std::size_t GetNumFreeSessions() const;
+
+private:
+    const std::size_t M_MAX_BUNDLES_PER_QUEUE;
+    const std::size_t M_MAX_SESSIONS;
+    std::vector<session_ptr_t> m_freeSessions;
+    std::size_t m_numSessionsAllocated;
+};
+
+#endif //_READ_AHEAD_SESSIONS_H
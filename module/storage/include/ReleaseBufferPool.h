@@ -0,0 +1,54 @@
+/**
+ * @file ReleaseBufferPool.h
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ *
+ * @section DESCRIPTION
+ *
+ * The ReleaseBufferPool class provides the zmq messages that bundles released from storage are read into.
+ * Each message owns a pooled, uninitialized buffer (rounded up to a power of 2 size class) which zmq
+ * returns to a free list of its size class when the message is freed, i.e. once egress is done with
+ * the bundle (sent and acked, or returned to storage after a failed send).
+ * Buffers may be returned from any thread, and may outlive the pool.
+ */
+
+#ifndef _RELEASE_BUFFER_POOL_H
+#define _RELEASE_BUFFER_POOL_H 1
+
+#include <cstdint>
+#include <cstddef>
+#include "zmq.hpp"
+#include "storage_lib_export.h"
+
+class ReleaseBufferPool {
+private:
+    ReleaseBufferPool();
+public:
+    //buffers are returned to the free lists until they hold maxFreeBytes, after which returned buffers are deleted
+    STORAGE_LIB_EXPORT ReleaseBufferPool(const uint64_t maxFreeBytes);
+    STORAGE_LIB_EXPORT ~ReleaseBufferPool();
+    ReleaseBufferPool(const ReleaseBufferPool &) = delete;
+    ReleaseBufferPool & operator=(const ReleaseBufferPool &) = delete;
+
+    //a message of exactly size bytes whose (uninitialized) data is a pooled buffer
+    STORAGE_LIB_EXPORT zmq::message_t AllocateMessage(const std::size_t size);
+
+    STORAGE_LIB_EXPORT uint64_t GetNumBuffersAllocated() const;
+    STORAGE_LIB_EXPORT uint64_t GetNumBuffersReused() const;
+    STORAGE_LIB_EXPORT uint64_t GetNumBuffersOutstanding() const;
+    STORAGE_LIB_EXPORT uint64_t GetFreeBytes() const;
+
+    struct Shared; //opaque, shared by the pool and its buffers
+private:
+    Shared * m_sharedPtr; //deleted by the pool or by the last outstanding buffer, whichever is later
+};
+
+#endif //_RELEASE_BUFFER_POOL_H
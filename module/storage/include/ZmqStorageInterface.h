@@ -31,13 +31,17 @@
 #define HDTN_STORAGE_TELEM_PATH "tcp://127.0.0.1:10460"
 #define HDTN_RELEASE_TELEM_PATH "tcp://127.0.0.1:10461"
 
+namespace hdtn {
+struct OneProcessBundleRings;
+}
 
 class ZmqStorageInterface : private boost::noncopyable {
 public:
     STORAGE_LIB_EXPORT ZmqStorageInterface();
     STORAGE_LIB_EXPORT ~ZmqStorageInterface();
     STORAGE_LIB_EXPORT void Stop();
-    STORAGE_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+    STORAGE_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+        hdtn::OneProcessBundleRings * hdtnOneProcessBundleRingsPtr = NULL);
     STORAGE_LIB_EXPORT std::size_t GetCurrentNumberOfBundlesDeletedFromStorage();
 
 
@@ -59,6 +63,8 @@ public:
     uint64_t& m_numRfc5050CustodyTransfers;
     uint64_t& m_numAcsCustodyTransfers;
     uint64_t& m_numAcsPacketsReceived;
+    uint64_t& m_totalBundlesExpiredFromStorage;
+    uint64_t& m_totalBytesReclaimedFromExpiredBundles;
 
 
 };
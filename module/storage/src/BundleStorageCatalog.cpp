@@ -14,10 +14,12 @@
 
 #include "BundleStorageCatalog.h"
 #include <string>
+#include <algorithm>
+#include <tuple>
 #include <boost/make_unique.hpp>
 
 
-BundleStorageCatalog::BundleStorageCatalog() {}
+BundleStorageCatalog::BundleStorageCatalog() : m_nextReleaseIndexId(1), m_nextDestEidToReap(0, 0) {}
 
 
 
@@ -119,49 +121,70 @@ bool BundleStorageCatalog::Remove(custids_flist_plus_lastiterator_t & custodyIdF
 }
 
 bool BundleStorageCatalog::CatalogIncomingBundleForStore(catalog_entry_t & catalogEntryToTake, const PrimaryBlock & primary, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
-    if (primary.HasCustodyFlagSet()) {
-        if (primary.HasFragmentationFlagSet()) {
-            const uuid_to_custid_hashmap_t::key_value_pair_t * p = m_uuidToCustodyIdHashMap.Insert(primary.GetCbheBundleUuidFromPrimary(), custodyId);
-            if (p == NULL) {
-                return false;
-            }
-            catalogEntryToTake.ptrUuidKeyInMap = &p->first;
+    //custody and fragmentation flags were copied into the catalog entry by catalog_entry_t::Init from this primary
+    return CatalogIncomingBundleForStore(catalogEntryToTake, primary.GetCbheBundleUuidFromPrimary(), custodyId, order);
+}
+bool BundleStorageCatalog::CatalogIncomingBundleForStore(catalog_entry_t & catalogEntryToTake, const cbhe_bundle_uuid_t & bundleUuid, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
+    if (catalogEntryToTake.HasCustodyAndFragmentation()) {
+        const uuid_to_custid_hashmap_t::key_value_pair_t * p = m_uuidToCustodyIdHashMap.Insert(bundleUuid, custodyId);
+        if (p == NULL) {
+            return false;
         }
-        else {
-            const uuidnofrag_to_custid_hashmap_t::key_value_pair_t * p = m_uuidNoFragToCustodyIdHashMap.Insert(primary.GetCbheBundleUuidNoFragmentFromPrimary(), custodyId);
-            if (p == NULL) {
-                return false;
-            }
-            catalogEntryToTake.ptrUuidKeyInMap = &p->first;
+        catalogEntryToTake.ptrUuidKeyInMap = &p->first;
+    }
+    else if (catalogEntryToTake.HasCustodyAndNonFragmentation()) {
+        const uuidnofrag_to_custid_hashmap_t::key_value_pair_t * p = m_uuidNoFragToCustodyIdHashMap.Insert(cbhe_bundle_uuid_nofragment_t(bundleUuid), custodyId);
+        if (p == NULL) {
+            return false;
         }
+        catalogEntryToTake.ptrUuidKeyInMap = &p->first;
     }
     if (!AddEntryToAwaitingSend(catalogEntryToTake, custodyId, order)) {
+        RemoveUuidFromMap(catalogEntryToTake, bundleUuid);
         return false;
     }
     if (!m_custodyIdToCatalogEntryHashmap.Insert(custodyId, std::move(catalogEntryToTake))) {
+        RemoveEntryFromAwaitingSend(catalogEntryToTake, custodyId);
+        RemoveUuidFromMap(catalogEntryToTake, bundleUuid);
         return false;
     }
-    
     return true;
 }
+void BundleStorageCatalog::RemoveUuidFromMap(catalog_entry_t & catalogEntry, const cbhe_bundle_uuid_t & bundleUuid) {
+    uint64_t cidInMap;
+    if (catalogEntry.HasCustodyAndFragmentation()) {
+        m_uuidToCustodyIdHashMap.GetValueAndRemove(bundleUuid, cidInMap);
+    }
+    else if (catalogEntry.HasCustodyAndNonFragmentation()) {
+        m_uuidNoFragToCustodyIdHashMap.GetValueAndRemove(cbhe_bundle_uuid_nofragment_t(bundleUuid), cidInMap);
+    }
+    catalogEntry.ptrUuidKeyInMap = NULL;
+}
 bool BundleStorageCatalog::AddEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId, const DUPLICATE_EXPIRY_ORDER order) {
-    priorities_to_expirations_array_t & priorityArray = m_destEidToPrioritiesMap[catalogEntry.destEid]; //created if not exist
-    expirations_to_custids_map_t & expirationMap = priorityArray[catalogEntry.GetPriorityIndex()];
+    awaiting_send_dest_t & dest = GetOrCreateAwaitingSendDest(catalogEntry.destEid); //created if not exist
+    const unsigned int priorityIndex = catalogEntry.GetPriorityIndex();
+    expirations_to_custids_map_t & expirationMap = dest.priorityArray[priorityIndex];
     custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt = expirationMap[catalogEntry.GetAbsExpiration()];
+    bool success;
     if (order == DUPLICATE_EXPIRY_ORDER::SEQUENCE_NUMBER) {
-        return Insert_OrderBySequence(custodyIdFlistPlusLastIt, custodyId, catalogEntry.sequence);
+        success = Insert_OrderBySequence(custodyIdFlistPlusLastIt, custodyId, catalogEntry.sequence);
     }
     else if (order == DUPLICATE_EXPIRY_ORDER::FIFO) {
         Insert_OrderByFifo(custodyIdFlistPlusLastIt, custodyId);
-        return true;
+        success = true;
     }
     else if (order == DUPLICATE_EXPIRY_ORDER::FILO) {
         Insert_OrderByFilo(custodyIdFlistPlusLastIt, custodyId);
-        return true;
+        success = true;
     }
     else {
-        return false;
+        success = false;
     }
+    if (custodyIdFlistPlusLastIt.first.empty()) { //don't leave an empty expiration in the map on failure
+        expirationMap.erase(catalogEntry.GetAbsExpiration());
+    }
+    UpdateReleaseIndexes(dest, priorityIndex);
+    return success;
 }
 bool BundleStorageCatalog::ReturnEntryToAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId) {
     //return what was popped off the front back to the front
@@ -170,12 +193,20 @@ bool BundleStorageCatalog::ReturnEntryToAwaitingSend(const catalog_entry_t & cat
 bool BundleStorageCatalog::RemoveEntryFromAwaitingSend(const catalog_entry_t & catalogEntry, const uint64_t custodyId) {
     dest_eid_to_priorities_map_t::iterator destEidIt = m_destEidToPrioritiesMap.find(catalogEntry.destEid);
     if (destEidIt != m_destEidToPrioritiesMap.end()) {
-        priorities_to_expirations_array_t & priorityArray = destEidIt->second; //created if not exist
-        expirations_to_custids_map_t & expirationMap = priorityArray[catalogEntry.GetPriorityIndex()];
+        awaiting_send_dest_t & dest = destEidIt->second;
+        const unsigned int priorityIndex = catalogEntry.GetPriorityIndex();
+        expirations_to_custids_map_t & expirationMap = dest.priorityArray[priorityIndex];
         expirations_to_custids_map_t::iterator expirationsIt = expirationMap.find(catalogEntry.GetAbsExpiration());
         if (expirationsIt != expirationMap.end()) {
             custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt = expirationsIt->second;
-            return Remove(custodyIdFlistPlusLastIt, custodyId);
+            if (!Remove(custodyIdFlistPlusLastIt, custodyId)) {
+                return false;
+            }
+            if (custodyIdFlistPlusLastIt.first.empty()) { //an empty expiration must not remain at the front of the map
+                expirationMap.erase(expirationsIt);
+                UpdateReleaseIndexes(dest, priorityIndex);
+            }
+            return true;
         }
     }
     return false;
@@ -183,23 +214,23 @@ bool BundleStorageCatalog::RemoveEntryFromAwaitingSend(const catalog_entry_t & c
 
 //this function requires fully qualified endpoint ids
 catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<cbhe_eid_t> & availableDestEids) {
-    std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > destEidPlusPriorityArrayPtrs;
-    destEidPlusPriorityArrayPtrs.reserve(availableDestEids.size());
+    std::vector<awaiting_send_dest_t*> destPtrs;
+    destPtrs.reserve(availableDestEids.size());
 
     for (std::size_t i = 0; i < availableDestEids.size(); ++i) {
         const cbhe_eid_t & currentAvailableLink = availableDestEids[i];
         dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.find(currentAvailableLink);
         if (dmIt != m_destEidToPrioritiesMap.end()) {
-            destEidPlusPriorityArrayPtrs.emplace_back(&currentAvailableLink, &(dmIt->second));
+            destPtrs.push_back(&(dmIt->second));
         }
     }
-    return PopEntryFromAwaitingSend(custodyId, destEidPlusPriorityArrayPtrs);
+    return PopEntryFromAwaitingSend(custodyId, destPtrs);
 }
 
 //this function ignores service ids
 catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<uint64_t> & availableDestNodeIds) {
-    std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > destEidPlusPriorityArrayPtrs;
-    destEidPlusPriorityArrayPtrs.reserve(availableDestNodeIds.size()); //todo
+    std::vector<awaiting_send_dest_t*> destPtrs;
+    destPtrs.reserve(availableDestNodeIds.size()); //todo
 
     for (std::size_t i = 0; i < availableDestNodeIds.size(); ++i) {
         const uint64_t nodeId = availableDestNodeIds[i];
@@ -209,17 +240,16 @@ catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & cust
             (dmIt != m_destEidToPrioritiesMap.end()) && (dmIt->first.nodeId == nodeId);
             ++dmIt)
         {
-            const cbhe_eid_t & currentAvailableLink = dmIt->first;
-            destEidPlusPriorityArrayPtrs.emplace_back(&currentAvailableLink, &(dmIt->second));
+            destPtrs.push_back(&(dmIt->second));
         }
     }
-    return PopEntryFromAwaitingSend(custodyId, destEidPlusPriorityArrayPtrs);
+    return PopEntryFromAwaitingSend(custodyId, destPtrs);
 }
 
 //this function uses the pair bool = true for any service ids
 catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests) {
-    std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > destEidPlusPriorityArrayPtrs;
-    destEidPlusPriorityArrayPtrs.reserve(availableDests.size()); //todo
+    std::vector<awaiting_send_dest_t*> destPtrs;
+    destPtrs.reserve(availableDests.size()); //todo
 
     for (std::size_t i = 0; i < availableDests.size(); ++i) {
         if (availableDests[i].second) { //wildcard * for any service id
@@ -230,55 +260,253 @@ catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & cust
                 (dmIt != m_destEidToPrioritiesMap.end()) && (dmIt->first.nodeId == nodeId);
                 ++dmIt)
             {
-                const cbhe_eid_t & currentAvailableLink = dmIt->first;
-                destEidPlusPriorityArrayPtrs.emplace_back(&currentAvailableLink, &(dmIt->second));
+                destPtrs.push_back(&(dmIt->second));
             }
         }
         else { //fully qualified eids
             const cbhe_eid_t & currentAvailableLink = availableDests[i].first;
             dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.find(currentAvailableLink);
             if (dmIt != m_destEidToPrioritiesMap.end()) {
-                destEidPlusPriorityArrayPtrs.emplace_back(&currentAvailableLink, &(dmIt->second));
+                destPtrs.push_back(&(dmIt->second));
             }
         }
     }
-    return PopEntryFromAwaitingSend(custodyId, destEidPlusPriorityArrayPtrs);
+    return PopEntryFromAwaitingSend(custodyId, destPtrs);
 }
-catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & custodyId,
-    const std::vector<std::pair<const cbhe_eid_t*, priorities_to_expirations_array_t *> > & destEidPlusPriorityArrayPtrs)
-{
-
-    //memset((uint8_t*)session.readCacheIsSegmentReady, 0, READ_CACHE_NUM_SEGMENTS_PER_SESSION);
+catalog_entry_t * BundleStorageCatalog::PopEntryFromAwaitingSend(uint64_t & custodyId, const std::vector<awaiting_send_dest_t*> & destPtrs) {
     for (int i = NUMBER_OF_PRIORITIES - 1; i >= 0; --i) { //00 = bulk, 01 = normal, 10 = expedited
         uint64_t lowestExpiration = UINT64_MAX;
-        expirations_to_custids_map_t * expirationMapPtr = NULL;
-        custids_flist_plus_lastiterator_t * custIdFlistPlusLastItPtr = NULL;
-        expirations_to_custids_map_t::iterator expirationMapIterator;
+        awaiting_send_dest_t * lowestDestPtr = NULL;
 
-        for (std::size_t j = 0; j < destEidPlusPriorityArrayPtrs.size(); ++j) {
-            priorities_to_expirations_array_t * priorityArray = destEidPlusPriorityArrayPtrs[j].second;
-            expirations_to_custids_map_t & expirationMap = (*priorityArray)[i];
+        for (std::size_t j = 0; j < destPtrs.size(); ++j) {
+            expirations_to_custids_map_t & expirationMap = destPtrs[j]->priorityArray[i];
             expirations_to_custids_map_t::iterator it = expirationMap.begin();
             if (it != expirationMap.end()) {
                 const uint64_t thisExpiration = it->first;
                 if (lowestExpiration > thisExpiration) {
                     lowestExpiration = thisExpiration;
-                    expirationMapPtr = &expirationMap;
-                    custIdFlistPlusLastItPtr = &it->second;
-                    expirationMapIterator = it;
+                    lowestDestPtr = destPtrs[j];
                 }
             }
         }
-        if (custIdFlistPlusLastItPtr) {
-            custids_flist_t & cidFlist = custIdFlistPlusLastItPtr->first;
-            custodyId = cidFlist.front();
-            cidFlist.pop_front();
+        if (lowestDestPtr) {
+            return PopFrontEntry(custodyId, *lowestDestPtr, static_cast<unsigned int>(i));
+        }
+    }
+    return NULL;
+}
+
+catalog_entry_t * BundleStorageCatalog::PopFrontEntry(uint64_t & custodyId, awaiting_send_dest_t & dest, const unsigned int priorityIndex) {
+    expirations_to_custids_map_t & expirationMap = dest.priorityArray[priorityIndex];
+    expirations_to_custids_map_t::iterator expirationMapIterator = expirationMap.begin();
+    custids_flist_t & cidFlist = expirationMapIterator->second.first;
+    custodyId = cidFlist.front();
+    cidFlist.pop_front();
 
-            if (cidFlist.empty()) {
-                expirationMapPtr->erase(expirationMapIterator);
+    if (cidFlist.empty()) {
+        expirationMap.erase(expirationMapIterator);
+        UpdateReleaseIndexes(dest, priorityIndex); //earliest expiration changed
+    }
+
+    return m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId);
+}
+
+awaiting_send_dest_t & BundleStorageCatalog::GetOrCreateAwaitingSendDest(const cbhe_eid_t & destEid) {
+    std::pair<dest_eid_to_priorities_map_t::iterator, bool> ret = m_destEidToPrioritiesMap.emplace(std::piecewise_construct,
+        std::forward_as_tuple(destEid), std::forward_as_tuple());
+    awaiting_send_dest_t & dest = ret.first->second;
+    if (ret.second) { //new destination, so add it to any existing release indexes that include it
+        dest.destEid = destEid;
+        std::map<cbhe_eid_t, std::vector<release_index_t*> >::iterator eidIt = m_destEidToReleaseIndexPtrsMap.find(destEid);
+        if (eidIt != m_destEidToReleaseIndexPtrsMap.end()) {
+            for (std::size_t i = 0; i < eidIt->second.size(); ++i) {
+                AddReleaseIndexMembership(*(eidIt->second[i]), dest);
+            }
+        }
+        std::map<uint64_t, std::vector<release_index_t*> >::iterator nodeIt = m_nodeIdToReleaseIndexPtrsMap.find(destEid.nodeId);
+        if (nodeIt != m_nodeIdToReleaseIndexPtrsMap.end()) {
+            for (std::size_t i = 0; i < nodeIt->second.size(); ++i) {
+                AddReleaseIndexMembership(*(nodeIt->second[i]), dest);
+            }
+        }
+    }
+    return dest;
+}
+
+void BundleStorageCatalog::AddReleaseIndexMembership(release_index_t & releaseIndex, awaiting_send_dest_t & dest) {
+    for (std::size_t i = 0; i < dest.releaseIndexMemberships.size(); ++i) {
+        if (dest.releaseIndexMemberships[i]->releaseIndexPtr == &releaseIndex) {
+            return; //already a member (e.g. listed both fully qualified and as any service id)
+        }
+    }
+    releaseIndex.memberships.emplace_back(boost::make_unique<release_index_membership_t>());
+    release_index_membership_t * const m = releaseIndex.memberships.back().get();
+    m->releaseIndexPtr = &releaseIndex;
+    m->destPtr = &dest;
+    m->heapPositions.fill(SIZE_MAX);
+    dest.releaseIndexMemberships.push_back(m);
+    for (unsigned int i = 0; i < NUMBER_OF_PRIORITIES; ++i) {
+        if (!dest.priorityArray[i].empty()) {
+            std::vector<release_index_membership_t*> & heap = releaseIndex.heaps[i];
+            heap.push_back(m);
+            HeapSiftUp(heap, heap.size() - 1, i);
+        }
+    }
+}
+
+//must be called whenever the earliest expiration (or emptiness) of dest.priorityArray[priorityIndex] may have changed
+void BundleStorageCatalog::UpdateReleaseIndexes(awaiting_send_dest_t & dest, const unsigned int priorityIndex) {
+    const bool isEmpty = dest.priorityArray[priorityIndex].empty();
+    for (std::size_t i = 0; i < dest.releaseIndexMemberships.size(); ++i) {
+        release_index_membership_t * const m = dest.releaseIndexMemberships[i];
+        std::vector<release_index_membership_t*> & heap = m->releaseIndexPtr->heaps[priorityIndex];
+        const std::size_t pos = m->heapPositions[priorityIndex];
+        if (pos == SIZE_MAX) {
+            if (!isEmpty) {
+                heap.push_back(m);
+                HeapSiftUp(heap, heap.size() - 1, priorityIndex);
             }
+        }
+        else if (isEmpty) {
+            HeapRemove(heap, pos, priorityIndex);
+        }
+        else {
+            HeapSiftUp(heap, pos, priorityIndex);
+            HeapSiftDown(heap, m->heapPositions[priorityIndex], priorityIndex);
+        }
+    }
+}
+
+//order by earliest expiration, then by destination eid so that ties are deterministic
+bool BundleStorageCatalog::HeapLess(const release_index_membership_t * a, const release_index_membership_t * b, const unsigned int priorityIndex) {
+    const uint64_t expirationA = a->destPtr->priorityArray[priorityIndex].cbegin()->first;
+    const uint64_t expirationB = b->destPtr->priorityArray[priorityIndex].cbegin()->first;
+    if (expirationA != expirationB) {
+        return (expirationA < expirationB);
+    }
+    return (a->destPtr->destEid < b->destPtr->destEid);
+}
 
-            return m_custodyIdToCatalogEntryHashmap.GetValuePtr(custodyId);
+void BundleStorageCatalog::HeapSiftUp(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex) {
+    release_index_membership_t * const m = heap[pos];
+    while (pos) {
+        const std::size_t parentPos = (pos - 1) >> 1;
+        if (!HeapLess(m, heap[parentPos], priorityIndex)) {
+            break;
+        }
+        heap[pos] = heap[parentPos];
+        heap[pos]->heapPositions[priorityIndex] = pos;
+        pos = parentPos;
+    }
+    heap[pos] = m;
+    m->heapPositions[priorityIndex] = pos;
+}
+
+void BundleStorageCatalog::HeapSiftDown(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex) {
+    release_index_membership_t * const m = heap[pos];
+    const std::size_t heapSize = heap.size();
+    while (true) {
+        std::size_t childPos = (pos << 1) + 1;
+        if (childPos >= heapSize) {
+            break;
+        }
+        if (((childPos + 1) < heapSize) && HeapLess(heap[childPos + 1], heap[childPos], priorityIndex)) {
+            ++childPos;
+        }
+        if (!HeapLess(heap[childPos], m, priorityIndex)) {
+            break;
+        }
+        heap[pos] = heap[childPos];
+        heap[pos]->heapPositions[priorityIndex] = pos;
+        pos = childPos;
+    }
+    heap[pos] = m;
+    m->heapPositions[priorityIndex] = pos;
+}
+
+void BundleStorageCatalog::HeapRemove(std::vector<release_index_membership_t*> & heap, std::size_t pos, const unsigned int priorityIndex) {
+    heap[pos]->heapPositions[priorityIndex] = SIZE_MAX;
+    release_index_membership_t * const last = heap.back();
+    heap.pop_back();
+    if (pos < heap.size()) { //move the last element into the hole
+        heap[pos] = last;
+        HeapSiftUp(heap, pos, priorityIndex);
+        HeapSiftDown(heap, last->heapPositions[priorityIndex], priorityIndex);
+    }
+}
+
+//this function uses the pair bool = true for any service ids
+uint64_t BundleStorageCatalog::CreateReleaseIndex(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests) {
+    const uint64_t releaseIndexId = m_nextReleaseIndexId++;
+    release_index_t & releaseIndex = m_releaseIndexIdToReleaseIndexMap[releaseIndexId];
+    releaseIndex.dests = availableDests;
+    for (std::size_t i = 0; i < availableDests.size(); ++i) {
+        if (availableDests[i].second) { //wildcard * for any service id
+            const uint64_t nodeId = availableDests[i].first.nodeId;
+            m_nodeIdToReleaseIndexPtrsMap[nodeId].push_back(&releaseIndex);
+            //lower bound points to equivalent or next greater
+            for (dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.lower_bound(cbhe_eid_t(nodeId, 0));
+                (dmIt != m_destEidToPrioritiesMap.end()) && (dmIt->first.nodeId == nodeId);
+                ++dmIt)
+            {
+                AddReleaseIndexMembership(releaseIndex, dmIt->second);
+            }
+        }
+        else { //fully qualified eids
+            const cbhe_eid_t & destEid = availableDests[i].first;
+            m_destEidToReleaseIndexPtrsMap[destEid].push_back(&releaseIndex);
+            dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.find(destEid);
+            if (dmIt != m_destEidToPrioritiesMap.end()) {
+                AddReleaseIndexMembership(releaseIndex, dmIt->second);
+            }
+        }
+    }
+    return releaseIndexId;
+}
+
+bool BundleStorageCatalog::DeleteReleaseIndex(const uint64_t releaseIndexId) {
+    release_index_id_to_release_index_map_t::iterator it = m_releaseIndexIdToReleaseIndexMap.find(releaseIndexId);
+    if (it == m_releaseIndexIdToReleaseIndexMap.end()) {
+        return false;
+    }
+    release_index_t & releaseIndex = it->second;
+    for (std::size_t i = 0; i < releaseIndex.memberships.size(); ++i) {
+        release_index_membership_t * const m = releaseIndex.memberships[i].get();
+        std::vector<release_index_membership_t*> & destMemberships = m->destPtr->releaseIndexMemberships;
+        destMemberships.erase(std::find(destMemberships.begin(), destMemberships.end(), m));
+    }
+    for (std::size_t i = 0; i < releaseIndex.dests.size(); ++i) {
+        const std::pair<cbhe_eid_t, bool> & dest = releaseIndex.dests[i];
+        std::vector<release_index_t*> & releaseIndexPtrs = (dest.second) ?
+            m_nodeIdToReleaseIndexPtrsMap[dest.first.nodeId] : m_destEidToReleaseIndexPtrsMap[dest.first];
+        std::vector<release_index_t*>::iterator ptrIt = std::find(releaseIndexPtrs.begin(), releaseIndexPtrs.end(), &releaseIndex);
+        if (ptrIt != releaseIndexPtrs.end()) {
+            releaseIndexPtrs.erase(ptrIt);
+        }
+        if (releaseIndexPtrs.empty()) {
+            if (dest.second) {
+                m_nodeIdToReleaseIndexPtrsMap.erase(dest.first.nodeId);
+            }
+            else {
+                m_destEidToReleaseIndexPtrsMap.erase(dest.first);
+            }
+        }
+    }
+    m_releaseIndexIdToReleaseIndexMap.erase(it);
+    return true;
+}
+
+//pops the highest priority, earliest expiring bundle of all the release index's destinations in O(log n) of the number of destinations
+catalog_entry_t * BundleStorageCatalog::PopEntryFromReleaseIndex(uint64_t & custodyId, const uint64_t releaseIndexId) {
+    release_index_id_to_release_index_map_t::iterator it = m_releaseIndexIdToReleaseIndexMap.find(releaseIndexId);
+    if (it == m_releaseIndexIdToReleaseIndexMap.end()) {
+        return NULL;
+    }
+    release_index_t & releaseIndex = it->second;
+    for (int i = NUMBER_OF_PRIORITIES - 1; i >= 0; --i) { //00 = bulk, 01 = normal, 10 = expedited
+        std::vector<release_index_membership_t*> & heap = releaseIndex.heaps[i];
+        if (!heap.empty()) {
+            return PopFrontEntry(custodyId, *(heap.front()->destPtr), static_cast<unsigned int>(i));
         }
     }
     return NULL;
@@ -344,6 +572,35 @@ uint64_t * BundleStorageCatalog::GetCustodyIdFromUuid(const cbhe_bundle_uuid_nof
     return m_uuidNoFragToCustodyIdHashMap.GetValuePtr(bundleUuid);
 }
 
+std::size_t BundleStorageCatalog::PopExpiredEntriesFromAwaitingSend(const uint64_t thresholdSecondsSinceStartOfYear2000,
+    const std::size_t maxEntriesToPop, std::vector<uint64_t> & custodyIds)
+{
+    custodyIds.clear();
+    if (m_destEidToPrioritiesMap.empty()) {
+        return 0;
+    }
+    dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.lower_bound(m_nextDestEidToReap);
+    for (std::size_t numDestsVisited = 0; numDestsVisited < m_destEidToPrioritiesMap.size(); ++numDestsVisited, ++dmIt) {
+        if (dmIt == m_destEidToPrioritiesMap.end()) {
+            dmIt = m_destEidToPrioritiesMap.begin();
+        }
+        awaiting_send_dest_t & dest = dmIt->second;
+        for (unsigned int priorityIndex = 0; priorityIndex < NUMBER_OF_PRIORITIES; ++priorityIndex) {
+            expirations_to_custids_map_t & expirationMap = dest.priorityArray[priorityIndex];
+            while ((!expirationMap.empty()) && (expirationMap.begin()->first < thresholdSecondsSinceStartOfYear2000)) {
+                if (custodyIds.size() >= maxEntriesToPop) {
+                    m_nextDestEidToReap = dmIt->first; //this destination may have more expired bundles
+                    return custodyIds.size();
+                }
+                uint64_t custodyId;
+                PopFrontEntry(custodyId, dest, priorityIndex);
+                custodyIds.push_back(custodyId);
+            }
+        }
+    }
+    return custodyIds.size();
+}
+
 bool BundleStorageCatalog::GetStorageExpiringBeforeThresholdTelemetry(StorageExpiringBeforeThresholdTelemetry_t & telem) {
     const uint64_t priorityIndex = telem.priority;
     if (priorityIndex >= NUMBER_OF_PRIORITIES) {
@@ -353,7 +610,7 @@ bool BundleStorageCatalog::GetStorageExpiringBeforeThresholdTelemetry(StorageExp
 
     for (dest_eid_to_priorities_map_t::iterator dmIt = m_destEidToPrioritiesMap.begin(); dmIt != m_destEidToPrioritiesMap.end(); ++dmIt) {
         const cbhe_eid_t& eid = dmIt->first;
-        priorities_to_expirations_array_t & priorityArray = dmIt->second;
+        priorities_to_expirations_array_t & priorityArray = dmIt->second.priorityArray;
         expirations_to_custids_map_t& expirationsMap = priorityArray[priorityIndex];
         for (expirations_to_custids_map_t::iterator expirationsIt = expirationsMap.begin(); expirationsIt != expirationsMap.end(); ++expirationsIt) {
             const uint64_t thisExpiration = expirationsIt->first;
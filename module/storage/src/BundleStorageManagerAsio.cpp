@@ -16,6 +16,7 @@
 #define _LARGEFILE64_SOURCE
 #define _FILE_OFFSET_BITS 64
 #include <fcntl.h>
+#include <cerrno>
 #endif
 
 #include "BundleStorageManagerAsio.h"
@@ -29,6 +30,13 @@
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
 
+static unsigned int GetDiskQueueDepth(const StorageConfig_ptr & storageConfigPtr) {
+    //a queue depth cannot exceed the number of usable entries of a disk's circular buffer
+    static constexpr unsigned int MAX_DISK_QUEUE_DEPTH = CIRCULAR_INDEX_BUFFER_SIZE - 1;
+    const unsigned int queueDepth = (storageConfigPtr) ? storageConfigPtr->m_diskQueueDepth : 1;
+    return std::max(1u, std::min(queueDepth, MAX_DISK_QUEUE_DEPTH));
+}
+
 BundleStorageManagerAsio::BundleStorageManagerAsio() : BundleStorageManagerAsio("storageConfig.json") {}
 
 BundleStorageManagerAsio::BundleStorageManagerAsio(const std::string & jsonConfigFileName) : BundleStorageManagerAsio(StorageConfig::CreateFromJsonFile(jsonConfigFileName)) {
@@ -42,8 +50,15 @@ BundleStorageManagerAsio::BundleStorageManagerAsio(const StorageConfig_ptr & sto
     BundleStorageManagerBase(storageConfigPtr),
 
     m_workPtr(boost::make_unique< boost::asio::io_service::work>(m_ioService)),
+#ifdef _WIN32
     m_asioHandlePtrsVec(M_NUM_STORAGE_DISKS),
-    m_diskOperationInProgressVec(M_NUM_STORAGE_DISKS)
+#else
+    m_fileDescriptorsVec(M_NUM_STORAGE_DISKS, -1),
+#endif
+    M_DISK_QUEUE_DEPTH(GetDiskQueueDepth(m_storageConfigPtr)),
+    m_numSlotsIssuedVec(M_NUM_STORAGE_DISKS, 0),
+    m_numDiskOperationsInProgressVec(M_NUM_STORAGE_DISKS, 0),
+    m_slotCompletedVec(M_NUM_STORAGE_DISKS * CIRCULAR_INDEX_BUFFER_SIZE, false)
 {
 
 
@@ -51,17 +66,46 @@ BundleStorageManagerAsio::BundleStorageManagerAsio(const StorageConfig_ptr & sto
 }
 
 BundleStorageManagerAsio::~BundleStorageManagerAsio() {
+    if (m_ioServiceThreadPtr) {
+        WriteBackAllHotTierBundles(); //queue the bundles only held in memory (before locking m_mutexMainThread, which a full disk queue waits on)
+        //like the BundleStorageManagerMT disk threads, finish every queued segment operation (e.g. the last writes or a bundle head deletion)
+        //before stopping, since queued operations beyond the disk queue depth are not yet known to the io_service or the I/O threads
+        boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+            while (cb.NumInBuffer()) {
+                const unsigned int numInBufferBeforeWait = cb.NumInBuffer();
+                if ((!m_conditionVariableMainThread.timed_wait(lockMainThread, boost::posix_time::seconds(2))) && (cb.NumInBuffer() == numInBufferBeforeWait)) {
+                    LOG_ERROR(subprocess) << "BundleStorageManagerAsio stopping with " << numInBufferBeforeWait << " unfinished operations on disk " << diskId;
+                    break; //no progress (disk error)
+                }
+            }
+        }
+    }
     if (m_ioServiceThreadPtr) {
         m_workPtr.reset(); //erase the work object (destructor is thread safe) so that io_service thread will exit when it runs out of work 
         m_ioServiceThreadPtr->join();
         m_ioServiceThreadPtr.reset(); //delete it
     }
+#ifndef _WIN32
+    if (m_diskIoThreadPoolPtr) {
+        m_diskIoThreadPoolPtr->join(); //finish any blocking disk operations
+        m_diskIoThreadPoolPtr.reset(); //delete it
+    }
+#endif
 
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+#ifdef _WIN32
         if (m_asioHandlePtrsVec[diskId]) {
             m_asioHandlePtrsVec[diskId]->close();
             m_asioHandlePtrsVec[diskId].reset(); //delete it
         }
+#else
+        if (m_fileDescriptorsVec[diskId] >= 0) {
+            close(m_fileDescriptorsVec[diskId]);
+            m_fileDescriptorsVec[diskId] = -1;
+        }
+#endif
     }
 
 }
@@ -102,72 +146,118 @@ void BundleStorageManagerAsio::Start() {
                 LOG_ERROR(subprocess) << "error opening " << filePath;
                 return;
             }
-            m_asioHandlePtrsVec[diskId] = boost::make_unique<boost::asio::posix::stream_descriptor>(m_ioService, file_desc);
+            m_fileDescriptorsVec[diskId] = file_desc;
 #endif
-            m_diskOperationInProgressVec[diskId] = false;
         }
+#ifndef _WIN32
+        //pread/pwrite block, so give every disk enough I/O threads to keep its full queue depth in flight
+        m_diskIoThreadPoolPtr = boost::make_unique<boost::asio::thread_pool>(M_NUM_STORAGE_DISKS * M_DISK_QUEUE_DEPTH);
+#endif
         m_ioServiceThreadPtr = boost::make_unique<boost::thread>(boost::bind(&boost::asio::io_service::run, &m_ioService));
     }
 }
 
-void BundleStorageManagerAsio::TryDiskOperation_Consume_NotThreadSafe(const unsigned int diskId) {
-    if (!m_diskOperationInProgressVec[diskId]) {
-        CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
-        const unsigned int consumeIndex = cb.GetIndexForRead(); //store the volatile
+bool BundleStorageManagerAsio::IsSegmentOperationInProgress_NotThreadSafe(const unsigned int diskId, const segment_id_t segmentId) {
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+    const segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+    const unsigned int startIndex = cb.GetIndexForRead();
+    for (unsigned int i = 0; i < m_numSlotsIssuedVec[diskId]; ++i) {
+        const unsigned int index = (startIndex + i) % CIRCULAR_INDEX_BUFFER_SIZE;
+        if ((!m_slotCompletedVec[diskId * CIRCULAR_INDEX_BUFFER_SIZE + index]) && (circularBufferSegmentIdsPtr[index] == segmentId)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        if (consumeIndex != CIRCULAR_INDEX_BUFFER_EMPTY) { //if not empty
-            m_diskOperationInProgressVec[diskId] = true;
+void BundleStorageManagerAsio::TryDiskOperation_Consume_NotThreadSafe(const unsigned int diskId) {
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+    unsigned int & numSlotsIssued = m_numSlotsIssuedVec[diskId];
+    unsigned int & numDiskOperationsInProgress = m_numDiskOperationsInProgressVec[diskId];
+    const unsigned int numInBuffer = cb.NumInBuffer(); //store the volatile
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
 
-            segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+    while ((numSlotsIssued < numInBuffer) && (numDiskOperationsInProgress < M_DISK_QUEUE_DEPTH)) {
+        const unsigned int consumeIndex = (cb.GetIndexForRead() + numSlotsIssued) % CIRCULAR_INDEX_BUFFER_SIZE;
 
-            const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
-            volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+        const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
+        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
 
-            const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
-            if (segmentId == SEGMENT_ID_LAST) {
-                LOG_ERROR(subprocess) << "error segmentId is last";
-                //continue;
-            }
-
-            const boost::uint64_t offsetBytes = static_cast<boost::uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+        const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
+        if (segmentId == SEGMENT_ID_LAST) {
+            LOG_ERROR(subprocess) << "error segmentId is last";
+            //continue;
+        }
 
 #ifdef _WIN32
-
+        const unsigned int maxRunLength = 1;
 #else
-            lseek64(m_asioHandlePtrsVec[diskId]->native_handle(), offsetBytes, SEEK_SET);
+        const unsigned int maxRunLength = GetContiguousSegmentRunLength_NotThreadSafe(diskId, consumeIndex, numInBuffer - numSlotsIssued);
 #endif
+        //concurrent operations may complete in any order, so an operation on a segment that is still in progress
+        //(e.g. reading back or deleting a bundle that was just written) must wait for it to finish
+        unsigned int runLength = 0;
+        while ((runLength < maxRunLength) && (!IsSegmentOperationInProgress_NotThreadSafe(diskId, circularBufferSegmentIdsPtr[(consumeIndex + runLength) % CIRCULAR_INDEX_BUFFER_SIZE]))) {
+            ++runLength;
+        }
+        if (runLength == 0) {
+            break; //HandleDiskOperationCompleted will try again
+        }
+        numSlotsIssued += runLength;
+        ++numDiskOperationsInProgress;
 
-            if (isWriteToDisk) {
-                boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
-                boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
-#ifdef _WIN32
-                boost::asio::async_write_at(*m_asioHandlePtrsVec[diskId], offsetBytes,
-#else
-                boost::asio::async_write(*m_asioHandlePtrsVec[diskId],
-#endif
-                    boost::asio::buffer(data, SEGMENT_SIZE),
-                    boost::bind(&BundleStorageManagerAsio::HandleDiskOperationCompleted, this,
-                        boost::asio::placeholders::error,
-                        boost::asio::placeholders::bytes_transferred,
-                        diskId, consumeIndex, false));
+        const boost::uint64_t offsetBytes = static_cast<boost::uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
 
-            }
-            else { //read from disk
 #ifdef _WIN32
-                boost::asio::async_read_at(*m_asioHandlePtrsVec[diskId], offsetBytes,
+        if (isWriteToDisk) {
+            boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+            boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
+            boost::asio::async_write_at(*m_asioHandlePtrsVec[diskId], offsetBytes,
+                boost::asio::buffer(data, SEGMENT_SIZE),
+                boost::bind(&BundleStorageManagerAsio::HandleDiskOperationCompleted, this,
+                    boost::asio::placeholders::error,
+                    boost::asio::placeholders::bytes_transferred,
+                    diskId, consumeIndex, 1));
+        }
+        else { //read from disk
+            boost::asio::async_read_at(*m_asioHandlePtrsVec[diskId], offsetBytes,
+                boost::asio::buffer((void*)readFromStorageDestPointer, SEGMENT_SIZE),
+                boost::bind(&BundleStorageManagerAsio::HandleDiskOperationCompleted, this,
+                    boost::asio::placeholders::error,
+                    boost::asio::placeholders::bytes_transferred,
+                    diskId, consumeIndex, 1));
+        }
 #else
-                boost::asio::async_read(*m_asioHandlePtrsVec[diskId],
+        boost::asio::post(*m_diskIoThreadPoolPtr, boost::bind(&BundleStorageManagerAsio::DoBlockingDiskOperation, this,
+            diskId, consumeIndex, runLength, offsetBytes, !isWriteToDisk));
 #endif
-                    boost::asio::buffer((void*)readFromStorageDestPointer, SEGMENT_SIZE),
-                    boost::bind(&BundleStorageManagerAsio::HandleDiskOperationCompleted, this,
-                        boost::asio::placeholders::error,
-                        boost::asio::placeholders::bytes_transferred,
-                        diskId, consumeIndex, true));
-            }
-        }
     }
 }
 
+#ifndef _WIN32
+//runs on a disk I/O thread pool thread
+void BundleStorageManagerAsio::DoBlockingDiskOperation(const unsigned int diskId, const unsigned int consumeIndex,
+    const unsigned int numSegments, const uint64_t offsetBytes, const bool isReadOperation)
+{
+    boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+    struct iovec iovecs[CIRCULAR_INDEX_BUFFER_SIZE];
+    for (unsigned int i = 0; i < numSegments; ++i) {
+        const unsigned int index = (consumeIndex + i) % CIRCULAR_INDEX_BUFFER_SIZE;
+        iovecs[i].iov_base = (isReadOperation) ?
+            (void*)m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + index] :
+            (void*)&circularBufferBlockDataPtr[index * SEGMENT_SIZE];
+        iovecs[i].iov_len = SEGMENT_SIZE;
+    }
+    const std::size_t bytesTransferred = DoPositionalVectoredSegmentIo(m_fileDescriptorsVec[diskId], iovecs, numSegments, offsetBytes, isReadOperation);
+    boost::system::error_code error;
+    if (bytesTransferred != (numSegments * SEGMENT_SIZE)) {
+        error = (errno) ? boost::system::error_code(errno, boost::system::system_category()) : boost::asio::error::eof;
+    }
+    boost::asio::post(m_ioService, boost::bind(&BundleStorageManagerAsio::HandleDiskOperationCompleted, this,
+        error, bytesTransferred, diskId, consumeIndex, numSegments));
+}
+#endif
+
 //virtual function to be called immediately after a disk's circular buffer CommitWrite();
 void BundleStorageManagerAsio::CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) {
     CircularIndexBufferSingleProducerSingleConsumerConfigurable& cb = m_circularIndexBuffersVec[diskId];
@@ -176,24 +266,39 @@ void BundleStorageManagerAsio::CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(con
 }
 
 
-void BundleStorageManagerAsio::HandleDiskOperationCompleted(const boost::system::error_code& error, std::size_t bytes_transferred, const unsigned int diskId, const unsigned int consumeIndex, const bool wasReadOperation) {
-    m_diskOperationInProgressVec[diskId] = false;
+void BundleStorageManagerAsio::HandleDiskOperationCompleted(const boost::system::error_code& error, std::size_t bytes_transferred, const unsigned int diskId, const unsigned int consumeIndex, const unsigned int numSegments) {
+    --m_numDiskOperationsInProgressVec[diskId];
     if (error) {
-        LOG_ERROR(subprocess) << "error in BundleStorageManagerMT::HandleDiskOperationCompleted: " << error.message();
+        LOG_ERROR(subprocess) << "error in BundleStorageManagerAsio::HandleDiskOperationCompleted: " << error.message();
     }
-    else if (bytes_transferred != SEGMENT_SIZE) {
-        LOG_ERROR(subprocess) << "error in BundleStorageManagerMT::HandleDiskOperationCompleted: bytes_transferred(" << bytes_transferred << ") != SEGMENT_SIZE(" << SEGMENT_SIZE << ")";
+    else if (bytes_transferred != (numSegments * SEGMENT_SIZE)) {
+        LOG_ERROR(subprocess) << "error in BundleStorageManagerAsio::HandleDiskOperationCompleted: bytes_transferred(" << bytes_transferred << ") != "
+            << numSegments << " * SEGMENT_SIZE(" << SEGMENT_SIZE << ")";
     }
     else {
-        volatile bool junk;
-        volatile bool * const isReadCompletedPointer = (wasReadOperation) ?
-            m_circularBufferIsReadCompletedPointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex] : &junk;
+        for (unsigned int i = 0; i < numSegments; ++i) {
+            m_slotCompletedVec[diskId * CIRCULAR_INDEX_BUFFER_SIZE + ((consumeIndex + i) % CIRCULAR_INDEX_BUFFER_SIZE)] = true;
+        }
+
+        //operations may complete out of order, but the circular buffer must be committed in order
         CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+        unsigned int & numSlotsIssued = m_numSlotsIssuedVec[diskId];
         m_mutexMainThread.lock();
-        *isReadCompletedPointer = true;
-        cb.CommitRead();
+        while (numSlotsIssued) {
+            const unsigned int readIndex = cb.GetIndexForRead();
+            std::vector<bool>::reference slotCompleted = m_slotCompletedVec[diskId * CIRCULAR_INDEX_BUFFER_SIZE + readIndex];
+            if (!slotCompleted) {
+                break;
+            }
+            slotCompleted = false;
+            if (m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + readIndex] != NULL) { //was read operation
+                *(m_circularBufferIsReadCompletedPointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + readIndex]) = true;
+            }
+            cb.CommitRead();
+            --numSlotsIssued;
+        }
         m_mutexMainThread.unlock();
-        m_conditionVariableMainThread.notify_one();
+        m_conditionVariableMainThread.notify_all(); //the storage writer and release threads may both be waiting
         TryDiskOperation_Consume_NotThreadSafe(diskId);
     }
 }
@@ -18,8 +18,18 @@
 #include <memory>
 #include <boost/make_unique.hpp>
 #include <boost/endian/conversion.hpp>
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/multiprecision/detail/bitscan.hpp>
 #include "codec/BundleViewV6.h"
 #include "codec/BundleViewV7.h"
+#include <algorithm>
+#include <boost/bind/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifndef _WIN32
+#include <unistd.h>
+#include <cerrno>
+#endif
 
  //#ifdef _MSC_VER //Windows tests
  //static const char * FILE_PATHS[NUM_STORAGE_THREADS] = { "map0.bin", "map1.bin", "map2.bin", "map3.bin" };
@@ -29,6 +39,12 @@
 
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
 
+#define RESTORE_READ_NUM_SEGMENTS 1024 //sequential read size of RestoreFromDisk (4MB with 4KB segments)
+#define STORAGE_SLAB_SEGMENT_MARKER (UINT64_MAX - 1) //bundleSizeBytes of a slab segment's header (whose custodyId is the slot size)
+#define MAX_SLAB_SLOTS 64 //one bit per slot in a uint64_t
+#define MIN_SLAB_SLOT_SIZE_BYTES 64
+#define MAX_CACHED_SLAB_IMAGES 1024 //segment images of sealed slabs kept in memory (4MB with 4KB segments)
+
 struct StorageSegmentHeader {
     StorageSegmentHeader();
     void ToLittleEndianInplace();
@@ -49,8 +65,30 @@ BOOST_FORCEINLINE void StorageSegmentHeader::ToNativeEndianInplace() {
     boost::endian::little_to_native_inplace(nextSegmentId);
 }
 
+static unsigned int GetNumSlabSlots(const uint64_t slotSizeBytes) {
+    return static_cast<unsigned int>(std::min<uint64_t>(MAX_SLAB_SLOTS, (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE) / slotSizeBytes));
+}
+
+//0 (small bundles not packed into slabs) if unset or if fewer than 2 slots would fit in a segment
+static uint64_t GetValidSlabSlotSizeBytes(const StorageConfig_ptr & storageConfigPtr) {
+    const uint64_t slotSizeBytes = (storageConfigPtr) ? storageConfigPtr->m_slabSlotSizeBytes : 0;
+    if (slotSizeBytes == 0) {
+        return 0;
+    }
+    if ((slotSizeBytes < MIN_SLAB_SLOT_SIZE_BYTES) || (GetNumSlabSlots(slotSizeBytes) < 2)) {
+        LOG_ERROR(subprocess) << "slabSlotSizeBytes " << slotSizeBytes << " must be at least " << MIN_SLAB_SLOT_SIZE_BYTES
+            << " and at most " << ((SEGMENT_SIZE - SEGMENT_RESERVED_SPACE) / 2) << ", small bundles will not be packed into slabs";
+        return 0;
+    }
+    return slotSizeBytes;
+}
+
+void StorageAlignedBufferDeleter::operator()(volatile uint8_t * p) const {
+    boost::alignment::aligned_free((void*)p);
+}
+
 BundleStorageManagerSession_ReadFromDisk::BundleStorageManagerSession_ReadFromDisk() :
-    readCache(new volatile uint8_t[READ_CACHE_NUM_SEGMENTS_PER_SESSION * SEGMENT_SIZE]) {}
+    readCache(static_cast<volatile uint8_t*>(boost::alignment::aligned_alloc(STORAGE_BUFFER_ALIGNMENT_BYTES, READ_CACHE_NUM_SEGMENTS_PER_SESSION * SEGMENT_SIZE))) {}
 
 BundleStorageManagerSession_ReadFromDisk::~BundleStorageManagerSession_ReadFromDisk() {}
 
@@ -68,22 +106,61 @@ BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & sto
     M_NUM_STORAGE_DISKS((m_storageConfigPtr) ? static_cast<unsigned int>(m_storageConfigPtr->m_storageDiskConfigVector.size()) : 1),
     M_TOTAL_STORAGE_CAPACITY_BYTES((m_storageConfigPtr) ? m_storageConfigPtr->m_totalStorageCapacityBytes : 1),
     M_MAX_SEGMENTS(M_TOTAL_STORAGE_CAPACITY_BYTES / SEGMENT_SIZE),
-    m_memoryManager(M_MAX_SEGMENTS),
+    m_memoryManager(M_MAX_SEGMENTS, (m_storageConfigPtr) ? m_storageConfigPtr->m_useLockFreeSegmentAllocator : false),
     m_filePathsVec(M_NUM_STORAGE_DISKS),
     m_filePathsAsStringVec(M_NUM_STORAGE_DISKS),
     m_circularIndexBuffersVec(M_NUM_STORAGE_DISKS, CircularIndexBufferSingleProducerSingleConsumerConfigurable(CIRCULAR_INDEX_BUFFER_SIZE)),
+    m_circularIndexBufferProducerMutexes(new boost::mutex[M_NUM_STORAGE_DISKS]),
+    m_circularBufferBlockDataPtr(NULL),
+    m_circularBufferSegmentIdsPtr(NULL),
     m_autoDeleteFilesOnExit((m_storageConfigPtr) ? m_storageConfigPtr->m_autoDeleteFilesOnExit : false),
+    M_HOT_TIER_CACHE_BYTES((m_storageConfigPtr) ? m_storageConfigPtr->m_hotTierCacheBytes : 0),
+    M_HOT_TIER_WRITE_BACK_DELAY(boost::posix_time::milliseconds((m_storageConfigPtr) ? m_storageConfigPtr->m_hotTierWriteBackDelayMilliseconds : 0)),
+    m_hotTierBytes(0),
+    m_numHotTierHits(0),
+    m_numHotTierMisses(0),
+    m_numHotTierEvictions(0),
+    m_numHotTierWriteBacksCancelled(0),
+    M_SLAB_SLOT_SIZE_BYTES(GetValidSlabSlotSizeBytes(m_storageConfigPtr)),
+    M_LARGE_BUNDLE_EXTENT_MIN_BYTES((m_storageConfigPtr) ? m_storageConfigPtr->m_largeBundleExtentMinBytes : 0),
+    m_openSlabSegmentId(SEGMENT_ID_LAST),
     m_successfullyRestoredFromDisk(false),
+    m_restoredFromCatalogJournal(false),
     m_totalBundlesRestored(0),
     m_totalBytesRestored(0),
-    m_totalSegmentsRestored(0)
+    m_totalSegmentsRestored(0),
+    m_restoreElapsedSeconds(0)
 {
     if (!m_storageConfigPtr) {
         return;
     }
 
+    if (!m_storageConfigPtr->m_catalogJournalFilePath.empty()) {
+        m_catalogJournalPtr = boost::make_unique<CatalogJournal>(m_storageConfigPtr->m_catalogJournalFilePath, M_NUM_STORAGE_DISKS, M_TOTAL_STORAGE_CAPACITY_BYTES);
+    }
+
     if (m_storageConfigPtr->m_tryToRestoreFromDisk) {
-        m_successfullyRestoredFromDisk = RestoreFromDisk(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+        const boost::posix_time::ptime restoreStartTime = boost::posix_time::microsec_clock::universal_time();
+        if (m_catalogJournalPtr) {
+            m_restoredFromCatalogJournal = RestoreFromCatalogJournal(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+            if (!m_restoredFromCatalogJournal) {
+                LOG_INFO(subprocess) << "unable to restore from the catalog journal, falling back to reading every segment";
+            }
+        }
+        m_successfullyRestoredFromDisk = m_restoredFromCatalogJournal || RestoreFromDisk(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+        m_restoreElapsedSeconds = (boost::posix_time::microsec_clock::universal_time() - restoreStartTime).total_microseconds() * 1e-6;
+        if (m_successfullyRestoredFromDisk && (m_restoreElapsedSeconds > 0)) {
+            LOG_INFO(subprocess) << "restored " << m_totalBundlesRestored << " bundles (" << m_totalBytesRestored << " bytes) in "
+                << m_restoreElapsedSeconds << " seconds: " << (m_totalBundlesRestored / m_restoreElapsedSeconds) << " bundles/s, "
+                << ((m_totalBytesRestored / m_restoreElapsedSeconds) * 1e-6) << " MB/s";
+        }
+    }
+
+    if (m_catalogJournalPtr) {
+        //start every run with a compacted journal holding exactly the restored bundles (none if the store files are about to be truncated)
+        if (((!m_successfullyRestoredFromDisk) && (!m_catalogJournalPtr->BeginCheckpoint())) || (!m_catalogJournalPtr->CommitCheckpoint())) {
+            DropCatalogJournal();
+        }
     }
 
 
@@ -98,7 +175,7 @@ BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & sto
         return;
     }
 
-    m_circularBufferBlockDataPtr = (uint8_t*)malloc(CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * SEGMENT_SIZE * sizeof(uint8_t));
+    m_circularBufferBlockDataPtr = (uint8_t*)boost::alignment::aligned_alloc(STORAGE_BUFFER_ALIGNMENT_BYTES, CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * SEGMENT_SIZE * sizeof(uint8_t));
     m_circularBufferSegmentIdsPtr = (segment_id_t*)malloc(CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * sizeof(segment_id_t));
 
 
@@ -106,9 +183,18 @@ BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & sto
 
 BundleStorageManagerBase::~BundleStorageManagerBase() {
 
-    free(m_circularBufferBlockDataPtr);
+    boost::alignment::aligned_free(m_circularBufferBlockDataPtr);
     free(m_circularBufferSegmentIdsPtr);
 
+    if (m_catalogJournalPtr) {
+        const boost::filesystem::path p(m_catalogJournalPtr->GetFilePath());
+        m_catalogJournalPtr.reset(); //flush and unmap
+        if (m_autoDeleteFilesOnExit && boost::filesystem::exists(p)) {
+            boost::filesystem::remove(p);
+            LOG_DEBUG(subprocess) << "deleted " << p.string();
+        }
+    }
+
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
         const boost::filesystem::path & p = m_filePathsVec[diskId];
 
@@ -120,6 +206,62 @@ BundleStorageManagerBase::~BundleStorageManagerBase() {
 }
 
 
+unsigned int BundleStorageManagerBase::GetContiguousSegmentRunLength_NotThreadSafe(const unsigned int diskId, const unsigned int firstIndex, const unsigned int maxRunLength) const {
+    if (maxRunLength == 0) {
+        return 0;
+    }
+    const segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+    const volatile uint8_t * const volatile * const readFromStoragePointers = &m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+    const bool isWriteToDisk = (readFromStoragePointers[firstIndex] == NULL);
+    segment_id_t expectedSegmentId = circularBufferSegmentIdsPtr[firstIndex];
+    unsigned int runLength = 1;
+    for (unsigned int index = firstIndex; runLength < maxRunLength; ++runLength) {
+        expectedSegmentId += M_NUM_STORAGE_DISKS; //next segment on the same disk is the adjacent SEGMENT_SIZE block of the file
+        index = (index + 1) % CIRCULAR_INDEX_BUFFER_SIZE;
+        if ((circularBufferSegmentIdsPtr[index] != expectedSegmentId) || ((readFromStoragePointers[index] == NULL) != isWriteToDisk)) {
+            break;
+        }
+    }
+    return runLength;
+}
+
+#ifndef _WIN32
+std::size_t BundleStorageManagerBase::DoPositionalVectoredSegmentIo(const int fileDescriptor, struct iovec * iovecs,
+    unsigned int numIovecs, uint64_t offsetBytes, const bool isReadOperation)
+{
+    std::size_t totalBytesTransferred = 0;
+    while (numIovecs) {
+        const ssize_t ret = (isReadOperation) ?
+            preadv(fileDescriptor, iovecs, static_cast<int>(numIovecs), static_cast<off_t>(offsetBytes)) :
+            pwritev(fileDescriptor, iovecs, static_cast<int>(numIovecs), static_cast<off_t>(offsetBytes));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        else if (ret == 0) { //end of file
+            errno = 0;
+            break;
+        }
+        std::size_t bytesTransferred = static_cast<std::size_t>(ret);
+        totalBytesTransferred += bytesTransferred;
+        offsetBytes += bytesTransferred;
+        //skip over the iovecs completed by a partial transfer
+        while (numIovecs && (bytesTransferred >= iovecs->iov_len)) {
+            bytesTransferred -= iovecs->iov_len;
+            ++iovecs;
+            --numIovecs;
+        }
+        if (numIovecs) {
+            iovecs->iov_base = static_cast<uint8_t*>(iovecs->iov_base) + bytesTransferred;
+            iovecs->iov_len -= bytesTransferred;
+        }
+    }
+    return totalBytesTransferred;
+}
+#endif
+
 const MemoryManagerTreeArray & BundleStorageManagerBase::GetMemoryManagerConstRef() {
     return m_memoryManager;
 }
@@ -127,14 +269,17 @@ const MemoryManagerTreeArray & BundleStorageManagerBase::GetMemoryManagerConstRe
 
 uint64_t BundleStorageManagerBase::Push(BundleStorageManagerSession_WriteToDisk & session, const PrimaryBlock & bundlePrimaryBlock, const uint64_t bundleSizeBytes) {
     catalog_entry_t & catalogEntry = session.catalogEntry;
-    segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
     const uint64_t totalSegmentsRequired = (bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
 
-    catalogEntry.Init(bundlePrimaryBlock, bundleSizeBytes, totalSegmentsRequired, NULL); //NULL replaced later at CatalogIncomingBundleForStore
+    catalogEntry.Init(bundlePrimaryBlock, bundleSizeBytes, NULL); //NULL replaced later at CatalogIncomingBundleForStore
     session.nextLogicalSegment = 0;
+    session.nextSegmentCursor.Reset();
 
-
-    if (m_memoryManager.AllocateSegments_ThreadSafe(segmentIdChainVec)) {
+    if (M_SLAB_SLOT_SIZE_BYTES && ((bundleSizeBytes + SEGMENT_RESERVED_SPACE) <= M_SLAB_SLOT_SIZE_BYTES)) {
+        return (AllocateSlabSlot(catalogEntry)) ? 1 : 0;
+    }
+    const bool isLargeBundle = (M_LARGE_BUNDLE_EXTENT_MIN_BYTES && (bundleSizeBytes >= M_LARGE_BUNDLE_EXTENT_MIN_BYTES));
+    if (m_memoryManager.AllocateSegmentExtents_ThreadSafe(totalSegmentsRequired, catalogEntry.segmentIdExtentVec, isLargeBundle)) {
         return totalSegmentsRequired;
     }
 
@@ -144,28 +289,40 @@ uint64_t BundleStorageManagerBase::Push(BundleStorageManagerSession_WriteToDisk
 int BundleStorageManagerBase::PushSegment(BundleStorageManagerSession_WriteToDisk & session, const PrimaryBlock & bundlePrimaryBlock,
     const uint64_t custodyId, const uint8_t * buf, std::size_t size)
 {
+    if (!PushSegmentWithoutCatalog(session, custodyId, buf, size)) {
+        return 0;
+    }
     catalog_entry_t & catalogEntry = session.catalogEntry;
-    segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
+    if (session.nextSegmentCursor.Get(catalogEntry.segmentIdExtentVec) == SEGMENT_ID_LAST) { //this was the last segment
+        CatalogPushedBundle(catalogEntry, bundlePrimaryBlock.GetCbheBundleUuidFromPrimary(), custodyId);
+    }
 
-    if (session.nextLogicalSegment >= segmentIdChainVec.size()) {
-        return 0;
+    return 1;
+}
+
+bool BundleStorageManagerBase::PushSegmentWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+    const uint64_t custodyId, const uint8_t * buf, std::size_t size)
+{
+    catalog_entry_t & catalogEntry = session.catalogEntry;
+    const segment_id_extent_vec_t & segmentIdExtentVec = catalogEntry.segmentIdExtentVec;
+
+    const segment_id_t segmentId = session.nextSegmentCursor.Get(segmentIdExtentVec);
+    if (segmentId == SEGMENT_ID_LAST) {
+        return false;
+    }
+    if (catalogEntry.IsInSlab()) {
+        return PushSlabSlotWithoutCatalog(session, custodyId, buf, size);
     }
     StorageSegmentHeader storageSegmentHeader;
     storageSegmentHeader.bundleSizeBytes = (session.nextLogicalSegment == 0) ? catalogEntry.bundleSizeBytes : UINT64_MAX;
-    const segment_id_t segmentId = segmentIdChainVec[session.nextLogicalSegment++];
+    ++session.nextLogicalSegment;
+    session.nextSegmentCursor.Advance(segmentIdExtentVec);
+    storageSegmentHeader.nextSegmentId = session.nextSegmentCursor.Get(segmentIdExtentVec); //SEGMENT_ID_LAST if this is the last segment
+    storageSegmentHeader.custodyId = custodyId;
+    storageSegmentHeader.ToLittleEndianInplace(); //should optimize out and do nothing
     const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
-    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
-    unsigned int produceIndex = cb.GetIndexForWrite();
-    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full, wait until not full	
-        //try again, but with the mutex
-        boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
-        produceIndex = cb.GetIndexForWrite();
-        if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full again (lock mutex (above) before checking condition)
-            m_conditionVariableMainThread.wait(lockMainThread); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
-            produceIndex = cb.GetIndexForWrite(); //should definitely have an index now (prevents an extra lock, unlock operation)
-        }
-    }
+    boost::mutex::scoped_lock lockProducer(m_circularIndexBufferProducerMutexes[diskIndex]);
+    const unsigned int produceIndex = GetCircularBufferIndexForWrite(diskIndex);
 
     uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
     segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE];
@@ -175,27 +332,41 @@ int BundleStorageManagerBase::PushSegment(BundleStorageManagerSession_WriteToDis
     circularBufferSegmentIdsPtr[produceIndex] = segmentId;
     m_circularBufferReadFromStoragePointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
 
-    storageSegmentHeader.nextSegmentId = (session.nextLogicalSegment == segmentIdChainVec.size()) ? SEGMENT_ID_LAST : segmentIdChainVec[session.nextLogicalSegment];
-    storageSegmentHeader.custodyId = custodyId;
-    storageSegmentHeader.ToLittleEndianInplace(); //should optimize out and do nothing
     memcpy(dataCb, &storageSegmentHeader, SEGMENT_RESERVED_SPACE);
     memcpy(dataCb + SEGMENT_RESERVED_SPACE, buf, size);
 
     CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
-    if (session.nextLogicalSegment == segmentIdChainVec.size()) {
-        m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, bundlePrimaryBlock, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
-    }
-
-    return 1;
+    return true;
 }
 
 //return total bytes pushed
 uint64_t BundleStorageManagerBase::PushAllSegments(BundleStorageManagerSession_WriteToDisk & session,
     const PrimaryBlock & bundlePrimaryBlock,
     const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize)
+{
+    const uint64_t totalBytesCopied = PushAllSegmentsWithoutCatalog(session, custodyId, allData, allDataSize);
+    if (totalBytesCopied == allDataSize) { //same as the last segment of PushSegment
+        CatalogPushedBundle(session.catalogEntry, bundlePrimaryBlock.GetCbheBundleUuidFromPrimary(), custodyId);
+    }
+    return totalBytesCopied;
+}
+
+//return total bytes pushed (to the hot tier, or else to the disks)
+uint64_t BundleStorageManagerBase::PushAllSegmentsWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+    const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize)
+{
+    if (InsertIntoHotTier(session, custodyId, allData, allDataSize)) {
+        return allDataSize;
+    }
+    return PushAllSegmentsToDisk(session, custodyId, allData, allDataSize);
+}
+
+//return total bytes pushed
+uint64_t BundleStorageManagerBase::PushAllSegmentsToDisk(BundleStorageManagerSession_WriteToDisk & session,
+    const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize)
 {
     uint64_t totalBytesCopied = 0;
-    const uint64_t totalSegmentsRequired = session.catalogEntry.segmentIdChainVec.size();
+    const uint64_t totalSegmentsRequired = session.catalogEntry.GetNumSegments();
     for (uint64_t i = 0; i < totalSegmentsRequired; ++i) {
         std::size_t bytesToCopy = BUNDLE_STORAGE_PER_SEGMENT_SIZE;
         if (i == totalSegmentsRequired - 1) {
@@ -205,7 +376,7 @@ uint64_t BundleStorageManagerBase::PushAllSegments(BundleStorageManagerSession_W
             }
         }
 
-        if (!PushSegment(session, bundlePrimaryBlock, custodyId, &allData[i*BUNDLE_STORAGE_PER_SEGMENT_SIZE], bytesToCopy)) {
+        if (!PushSegmentWithoutCatalog(session, custodyId, &allData[i*BUNDLE_STORAGE_PER_SEGMENT_SIZE], bytesToCopy)) {
             return 0;
         }
         totalBytesCopied += bytesToCopy;
@@ -213,6 +384,393 @@ uint64_t BundleStorageManagerBase::PushAllSegments(BundleStorageManagerSession_W
     return totalBytesCopied;
 }
 
+bool BundleStorageManagerBase::InsertIntoHotTier(const BundleStorageManagerSession_WriteToDisk & session,
+    const uint64_t custodyId, const uint8_t * allData, const std::size_t allDataSize)
+{
+    if ((allDataSize > M_HOT_TIER_CACHE_BYTES) || (session.nextLogicalSegment != 0) || (allDataSize != session.catalogEntry.bundleSizeBytes)
+        || session.catalogEntry.IsInSlab())
+    {
+        return false; //disabled, too large, already partially pushed to disk, or sharing its (head) segment with other bundles
+    }
+    const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    //make room (oldest first), also writing back any aged bundles while the lock is held
+    while ((!m_hotTierFifo.empty()) &&
+        (((m_hotTierBytes + allDataSize) > M_HOT_TIER_CACHE_BYTES) || (m_hotTierFifo.front().writeBackExpiry <= nowPtime)))
+    {
+        WriteBackHotTierBundle_NotThreadSafe(m_hotTierFifo.begin());
+    }
+    m_hotTierFifo.emplace_back();
+    hot_tier_fifo_t::iterator it = std::prev(m_hotTierFifo.end());
+    hot_tier_bundle_t & hotTierBundle = *it;
+    hotTierBundle.session = session;
+    hotTierBundle.custodyId = custodyId;
+    hotTierBundle.data.assign(allData, allData + allDataSize);
+    hotTierBundle.writeBackExpiry = nowPtime + M_HOT_TIER_WRITE_BACK_DELAY;
+    m_hotTierHeadSegmentIdToFifoIteratorMap[session.catalogEntry.segmentIdExtentVec[0].startSegmentId] = it;
+    m_hotTierBytes += allDataSize;
+    return true;
+}
+
+void BundleStorageManagerBase::WriteBackHotTierBundle_NotThreadSafe(hot_tier_fifo_t::iterator it) {
+    hot_tier_bundle_t & hotTierBundle = *it;
+    //queued to the disks while m_hotTierMutex is held so that any later read or head destroying write of this bundle is queued after it
+    if (PushAllSegmentsToDisk(hotTierBundle.session, hotTierBundle.custodyId, hotTierBundle.data.data(), hotTierBundle.data.size()) != hotTierBundle.data.size()) {
+        LOG_ERROR(subprocess) << "unable to write back hot tier bundle with custody id " << hotTierBundle.custodyId;
+    }
+    m_hotTierHeadSegmentIdToFifoIteratorMap.erase(hotTierBundle.session.catalogEntry.segmentIdExtentVec[0].startSegmentId);
+    m_hotTierBytes -= hotTierBundle.data.size();
+    ++m_numHotTierEvictions;
+    m_hotTierFifo.erase(it);
+}
+
+std::size_t BundleStorageManagerBase::WriteBackHotTierBundles(const bool writeBackAll) {
+    if (M_HOT_TIER_CACHE_BYTES == 0) {
+        return 0;
+    }
+    const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+    std::size_t numWrittenBack = 0;
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    while ((!m_hotTierFifo.empty()) && (writeBackAll || (m_hotTierFifo.front().writeBackExpiry <= nowPtime))) {
+        WriteBackHotTierBundle_NotThreadSafe(m_hotTierFifo.begin());
+        ++numWrittenBack;
+    }
+    return numWrittenBack;
+}
+
+std::size_t BundleStorageManagerBase::WriteBackAgedHotTierBundles() {
+    return WriteBackHotTierBundles(false);
+}
+
+std::size_t BundleStorageManagerBase::WriteBackAllHotTierBundles() {
+    return WriteBackHotTierBundles(true);
+}
+
+bool BundleStorageManagerBase::WriteBackHotTierBundle(const segment_id_t headSegmentId) {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    std::unordered_map<segment_id_t, hot_tier_fifo_t::iterator>::iterator mapIt = m_hotTierHeadSegmentIdToFifoIteratorMap.find(headSegmentId);
+    if (mapIt == m_hotTierHeadSegmentIdToFifoIteratorMap.end()) {
+        return false;
+    }
+    WriteBackHotTierBundle_NotThreadSafe(mapIt->second);
+    return true;
+}
+
+bool BundleStorageManagerBase::CancelHotTierWriteBack(const segment_id_t headSegmentId) {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    std::unordered_map<segment_id_t, hot_tier_fifo_t::iterator>::iterator mapIt = m_hotTierHeadSegmentIdToFifoIteratorMap.find(headSegmentId);
+    if (mapIt == m_hotTierHeadSegmentIdToFifoIteratorMap.end()) {
+        return false;
+    }
+    m_hotTierBytes -= mapIt->second->data.size();
+    ++m_numHotTierWriteBacksCancelled;
+    m_hotTierFifo.erase(mapIt->second);
+    m_hotTierHeadSegmentIdToFifoIteratorMap.erase(mapIt);
+    return true;
+}
+
+uint64_t BundleStorageManagerBase::GetNumHotTierHits() const {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    return m_numHotTierHits;
+}
+
+uint64_t BundleStorageManagerBase::GetNumHotTierMisses() const {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    return m_numHotTierMisses;
+}
+
+uint64_t BundleStorageManagerBase::GetNumHotTierEvictions() const {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    return m_numHotTierEvictions;
+}
+
+uint64_t BundleStorageManagerBase::GetNumHotTierWriteBacksCancelled() const {
+    boost::mutex::scoped_lock lock(m_hotTierMutex);
+    return m_numHotTierWriteBacksCancelled;
+}
+
+void BundleStorageManagerBase::QueueSegmentWrite(const segment_id_t segmentId, const void * data, const std::size_t size) {
+    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+    boost::mutex::scoped_lock lockProducer(m_circularIndexBufferProducerMutexes[diskIndex]);
+    const unsigned int produceIndex = GetCircularBufferIndexForWrite(diskIndex);
+    const unsigned int circularBufferIndex = diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex;
+    m_circularBufferSegmentIdsPtr[circularBufferIndex] = segmentId;
+    m_circularBufferReadFromStoragePointers[circularBufferIndex] = NULL; //isWriteToDisk = true
+    memcpy(&m_circularBufferBlockDataPtr[circularBufferIndex * SEGMENT_SIZE], data, size);
+    CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
+}
+
+void BundleStorageManagerBase::ReadSegmentAndWait(const segment_id_t segmentId, volatile uint8_t * buf) {
+    volatile bool readIsReady = false;
+    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+    {
+        boost::mutex::scoped_lock lockProducer(m_circularIndexBufferProducerMutexes[diskIndex]);
+        const unsigned int produceIndex = GetCircularBufferIndexForWrite(diskIndex);
+        const unsigned int circularBufferIndex = diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex;
+        m_circularBufferIsReadCompletedPointers[circularBufferIndex] = &readIsReady;
+        m_circularBufferReadFromStoragePointers[circularBufferIndex] = buf;
+        m_circularBufferSegmentIdsPtr[circularBufferIndex] = segmentId;
+        CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
+    }
+    while (!readIsReady) { //same wait as WaitForCachedSegment
+        boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
+        if (!readIsReady) {
+            m_conditionVariableMainThread.wait(lockMainThread);
+        }
+    }
+}
+
+static BOOST_FORCEINLINE uint64_t GetAllSlabSlotsMask(const unsigned int numSlots) {
+    return (numSlots >= 64) ? UINT64_MAX : ((((uint64_t)1) << numSlots) - 1);
+}
+
+//the lowest free slot of the open slab, opening a new slab (allocating one segment) if there is no open slab or it is full
+bool BundleStorageManagerBase::AllocateSlabSlot(catalog_entry_t & catalogEntry) {
+    boost::mutex::scoped_lock lock(m_slabMutex);
+    slab_t * slabPtr = NULL;
+    if (m_openSlabSegmentId != SEGMENT_ID_LAST) {
+        const segment_id_t sealedSlabSegmentId = m_openSlabSegmentId;
+        slab_t & openSlab = m_slabsMap[m_openSlabSegmentId];
+        if (openSlab.liveSlotsMask != GetAllSlabSlotsMask(openSlab.numSlots)) {
+            slabPtr = &openSlab;
+        }
+        else { //full, so seal it (its freed slots are no longer reused)
+            m_openSlabSegmentId = SEGMENT_ID_LAST;
+            if (openSlab.unwrittenSlotsMask == 0) {
+                CacheSlabImage_NotThreadSafe(sealedSlabSegmentId, openSlab);
+            }
+        }
+    }
+    if (slabPtr == NULL) {
+        segment_id_chain_vec_t segmentIdVec(1);
+        if (!m_memoryManager.AllocateSegments_ThreadSafe(segmentIdVec)) {
+            return false;
+        }
+        m_openSlabSegmentId = segmentIdVec[0];
+        slabPtr = &m_slabsMap[m_openSlabSegmentId];
+        slabPtr->slotSizeBytes = M_SLAB_SLOT_SIZE_BYTES;
+        slabPtr->numSlots = GetNumSlabSlots(M_SLAB_SLOT_SIZE_BYTES);
+        slabPtr->liveSlotsMask = 0;
+        slabPtr->unwrittenSlotsMask = 0;
+        slabPtr->freedWhileLoadingSlotsMask = 0;
+        slabPtr->isLoadingImage = false;
+        slabPtr->isImageCached = false;
+        slabPtr->image.assign(SEGMENT_SIZE, 0); //never written slots are all zero
+        StorageSegmentHeader slabHeader;
+        slabHeader.bundleSizeBytes = STORAGE_SLAB_SEGMENT_MARKER;
+        slabHeader.custodyId = M_SLAB_SLOT_SIZE_BYTES;
+        slabHeader.nextSegmentId = SEGMENT_ID_LAST;
+        slabHeader.ToLittleEndianInplace(); //should optimize out and do nothing
+        memcpy(slabPtr->image.data(), &slabHeader, SEGMENT_RESERVED_SPACE);
+    }
+    const unsigned int slotIndex = boost::multiprecision::detail::find_lsb<uint64_t>(~slabPtr->liveSlotsMask);
+    const uint64_t slotMask = ((uint64_t)1) << slotIndex;
+    slabPtr->liveSlotsMask |= slotMask;
+    slabPtr->unwrittenSlotsMask |= slotMask;
+    catalogEntry.segmentIdExtentVec.assign(1, segment_id_extent_t(m_openSlabSegmentId, 1));
+    catalogEntry.slabSlotOffset = static_cast<uint32_t>(SEGMENT_RESERVED_SPACE + (slotIndex * slabPtr->slotSizeBytes));
+    return true;
+}
+
+bool BundleStorageManagerBase::PushSlabSlotWithoutCatalog(BundleStorageManagerSession_WriteToDisk & session,
+    const uint64_t custodyId, const uint8_t * buf, std::size_t size)
+{
+    catalog_entry_t & catalogEntry = session.catalogEntry;
+    const segment_id_t slabSegmentId = catalogEntry.segmentIdExtentVec[0].startSegmentId;
+    StorageSegmentHeader slotHeader;
+    slotHeader.bundleSizeBytes = catalogEntry.bundleSizeBytes;
+    slotHeader.custodyId = custodyId;
+    slotHeader.nextSegmentId = SEGMENT_ID_LAST;
+    slotHeader.ToLittleEndianInplace(); //should optimize out and do nothing
+
+    boost::mutex::scoped_lock lock(m_slabMutex);
+    std::unordered_map<segment_id_t, slab_t>::iterator it = m_slabsMap.find(slabSegmentId);
+    if ((it == m_slabsMap.end()) || it->second.image.empty() || ((size + SEGMENT_RESERVED_SPACE) > it->second.slotSizeBytes)) {
+        LOG_ERROR(subprocess) << "cannot push custody id " << custodyId << " to slab segment " << slabSegmentId;
+        return false;
+    }
+    slab_t & slab = it->second;
+    uint8_t * const slotPtr = &slab.image[catalogEntry.slabSlotOffset];
+    memcpy(slotPtr, &slotHeader, SEGMENT_RESERVED_SPACE);
+    memcpy(slotPtr + SEGMENT_RESERVED_SPACE, buf, size);
+    //queued while m_slabMutex is held so that the disk receives this slab's images in order
+    QueueSegmentWrite(slabSegmentId, slab.image.data(), SEGMENT_SIZE);
+    slab.unwrittenSlotsMask &= ~(((uint64_t)1) << ((catalogEntry.slabSlotOffset - SEGMENT_RESERVED_SPACE) / slab.slotSizeBytes));
+    if ((slabSegmentId != m_openSlabSegmentId) && (slab.unwrittenSlotsMask == 0)) {
+        CacheSlabImage_NotThreadSafe(slabSegmentId, slab); //sealed and fully written
+    }
+    ++session.nextLogicalSegment;
+    session.nextSegmentCursor.Advance(catalogEntry.segmentIdExtentVec);
+    return true;
+}
+
+//mark the slot freed on the disk, or destroy the slab (like the head of a removed bundle) and free its segment once its last slot is freed
+bool BundleStorageManagerBase::FreeSlabSlot(const catalog_entry_t & catalogEntry) {
+    static const uint64_t bundleSizeBytesLittleEndian = UINT64_MAX;
+    const segment_id_t slabSegmentId = catalogEntry.segmentIdExtentVec[0].startSegmentId;
+    boost::mutex::scoped_lock lock(m_slabMutex);
+    std::unordered_map<segment_id_t, slab_t>::iterator it = m_slabsMap.find(slabSegmentId);
+    if (it == m_slabsMap.end()) {
+        LOG_ERROR(subprocess) << "slab segment " << slabSegmentId << " not found";
+        return false;
+    }
+    slab_t & slab = it->second;
+    const uint64_t slotMask = ((uint64_t)1) << ((catalogEntry.slabSlotOffset - SEGMENT_RESERVED_SPACE) / slab.slotSizeBytes);
+    if ((slab.liveSlotsMask & slotMask) == 0) {
+        LOG_ERROR(subprocess) << "slot at offset " << catalogEntry.slabSlotOffset << " of slab segment " << slabSegmentId << " is already free";
+        return false;
+    }
+    slab.liveSlotsMask &= ~slotMask;
+    slab.unwrittenSlotsMask &= ~slotMask; //e.g. removed before it was pushed
+    if (slab.isLoadingImage) {
+        slab.freedWhileLoadingSlotsMask |= slotMask; //marked (or the slab destroyed) by the thread reading the image back
+        return true;
+    }
+    if ((slab.liveSlotsMask == 0) && (slabSegmentId != m_openSlabSegmentId)) {
+        return DestroySlab_NotThreadSafe(it);
+    }
+    if (slab.image.empty()) {
+        //sealed slab whose image is not cached: read-modify-write with the read done outside of m_slabMutex
+        //so that allocating and pushing slots never waits on the disk (the slab can't be destroyed while loading)
+        slab.isLoadingImage = true;
+        slab.freedWhileLoadingSlotsMask = slotMask;
+        lock.unlock();
+        std::unique_ptr<volatile uint8_t[], StorageAlignedBufferDeleter> readBuffer(
+            static_cast<volatile uint8_t*>(boost::alignment::aligned_alloc(STORAGE_BUFFER_ALIGNMENT_BYTES, SEGMENT_SIZE)));
+        ReadSegmentAndWait(slabSegmentId, readBuffer.get());
+        lock.lock();
+        it = m_slabsMap.find(slabSegmentId);
+        slab_t & loadedSlab = it->second;
+        loadedSlab.image.assign(const_cast<const uint8_t*>(readBuffer.get()), const_cast<const uint8_t*>(readBuffer.get()) + SEGMENT_SIZE);
+        loadedSlab.isLoadingImage = false;
+        if (loadedSlab.liveSlotsMask == 0) {
+            return DestroySlab_NotThreadSafe(it);
+        }
+        for (uint64_t freedMask = loadedSlab.freedWhileLoadingSlotsMask; freedMask; freedMask &= (freedMask - 1)) {
+            const unsigned int slotIndex = boost::multiprecision::detail::find_lsb<uint64_t>(freedMask);
+            memcpy(&loadedSlab.image[SEGMENT_RESERVED_SPACE + (slotIndex * loadedSlab.slotSizeBytes)], &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
+        }
+        loadedSlab.freedWhileLoadingSlotsMask = 0;
+        QueueSegmentWrite(slabSegmentId, loadedSlab.image.data(), SEGMENT_SIZE);
+        CacheSlabImage_NotThreadSafe(slabSegmentId, loadedSlab);
+        return true;
+    }
+    memcpy(&slab.image[catalogEntry.slabSlotOffset], &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
+    QueueSegmentWrite(slabSegmentId, slab.image.data(), SEGMENT_SIZE);
+    if ((slabSegmentId != m_openSlabSegmentId) && (slab.unwrittenSlotsMask == 0)) {
+        CacheSlabImage_NotThreadSafe(slabSegmentId, slab);
+    }
+    return true;
+}
+
+//keep (or mark most recently used) the image of a sealed and fully written slab, dropping the least recently used images beyond MAX_CACHED_SLAB_IMAGES
+void BundleStorageManagerBase::CacheSlabImage_NotThreadSafe(const segment_id_t slabSegmentId, slab_t & slab) {
+    if (slab.isImageCached) {
+        m_cachedSlabImagesLru.splice(m_cachedSlabImagesLru.end(), m_cachedSlabImagesLru, slab.cachedImageIt);
+        return;
+    }
+    slab.cachedImageIt = m_cachedSlabImagesLru.insert(m_cachedSlabImagesLru.end(), slabSegmentId);
+    slab.isImageCached = true;
+    while (m_cachedSlabImagesLru.size() > MAX_CACHED_SLAB_IMAGES) {
+        slab_t & evictedSlab = m_slabsMap[m_cachedSlabImagesLru.front()];
+        std::vector<uint8_t>().swap(evictedSlab.image);
+        evictedSlab.isImageCached = false;
+        m_cachedSlabImagesLru.pop_front();
+    }
+}
+
+bool BundleStorageManagerBase::DestroySlab_NotThreadSafe(std::unordered_map<segment_id_t, slab_t>::iterator it) {
+    static const uint64_t bundleSizeBytesLittleEndian = UINT64_MAX;
+    const segment_id_t slabSegmentId = it->first;
+    QueueSegmentWrite(slabSegmentId, &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
+    if (it->second.isImageCached) {
+        m_cachedSlabImagesLru.erase(it->second.cachedImageIt);
+    }
+    m_slabsMap.erase(it);
+    const segment_id_chain_vec_t segmentIdVec(1, slabSegmentId);
+    return m_memoryManager.FreeSegments_ThreadSafe(segmentIdVec);
+}
+
+//restore: mark a slot live, allocating its slab segment (as a sealed slab) the first time one of its slots is restored
+bool BundleStorageManagerBase::RestoreSlabSlot_NotThreadSafe(const segment_id_t slabSegmentId, const uint32_t slabSlotOffset, const uint64_t slotSizeBytes) {
+    if ((slotSizeBytes < MIN_SLAB_SLOT_SIZE_BYTES) || (slotSizeBytes > (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE)) || (slabSlotOffset < SEGMENT_RESERVED_SPACE)
+        || (((slabSlotOffset - SEGMENT_RESERVED_SPACE) % slotSizeBytes) != 0) || (((slabSlotOffset - SEGMENT_RESERVED_SPACE) / slotSizeBytes) >= GetNumSlabSlots(slotSizeBytes)))
+    {
+        LOG_ERROR(subprocess) << "invalid slot at offset " << slabSlotOffset << " of slab segment " << slabSegmentId;
+        return false;
+    }
+    std::unordered_map<segment_id_t, slab_t>::iterator it = m_slabsMap.find(slabSegmentId);
+    if (it == m_slabsMap.end()) {
+        if ((slabSegmentId >= M_MAX_SEGMENTS) || (!m_memoryManager.AllocateSegmentId_NotThreadSafe(slabSegmentId))) {
+            LOG_ERROR(subprocess) << "slab segment " << slabSegmentId << " is invalid or already allocated";
+            return false;
+        }
+        slab_t & slab = m_slabsMap[slabSegmentId];
+        slab.slotSizeBytes = slotSizeBytes;
+        slab.numSlots = GetNumSlabSlots(slotSizeBytes);
+        slab.liveSlotsMask = 0;
+        slab.unwrittenSlotsMask = 0;
+        slab.freedWhileLoadingSlotsMask = 0;
+        slab.isLoadingImage = false;
+        slab.isImageCached = false; //no image until one of its slots is freed
+        it = m_slabsMap.find(slabSegmentId);
+    }
+    slab_t & slab = it->second;
+    const uint64_t slotMask = ((uint64_t)1) << ((slabSlotOffset - SEGMENT_RESERVED_SPACE) / slotSizeBytes);
+    if ((slab.slotSizeBytes != slotSizeBytes) || (slab.liveSlotsMask & slotMask)) {
+        LOG_ERROR(subprocess) << "slot at offset " << slabSlotOffset << " of slab segment " << slabSegmentId << " is restored twice";
+        return false;
+    }
+    slab.liveSlotsMask |= slotMask;
+    return true;
+}
+
+void BundleStorageManagerBase::FreeAllSlabs_NotThreadSafe() {
+    for (std::unordered_map<segment_id_t, slab_t>::const_iterator it = m_slabsMap.cbegin(); it != m_slabsMap.cend(); ++it) {
+        m_memoryManager.FreeSegmentId_NotThreadSafe(it->first);
+    }
+    m_slabsMap.clear();
+    m_cachedSlabImagesLru.clear();
+    m_openSlabSegmentId = SEGMENT_ID_LAST;
+}
+
+//journal the bundle only once the catalog holds it, so that the journal never lists a bundle the catalog rejected (e.g. a duplicate custody id or custody bundle uuid)
+bool BundleStorageManagerBase::CatalogPushedBundle(catalog_entry_t & catalogEntryToTake, const cbhe_bundle_uuid_t & bundleUuid, const uint64_t custodyId) {
+    if (!m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntryToTake, bundleUuid, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO)) {
+        return false;
+    }
+    if (m_catalogJournalPtr) {
+        const catalog_entry_t * const catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId); //catalogEntryToTake was moved from
+        if ((!catalogEntryPtr) || (!m_catalogJournalPtr->AppendInsert(custodyId, *catalogEntryPtr, bundleUuid))) {
+            DropCatalogJournal();
+        }
+    }
+    return true;
+}
+
+void BundleStorageManagerBase::DropCatalogJournal() {
+    LOG_ERROR(subprocess) << "unable to write the catalog journal " << m_catalogJournalPtr->GetFilePath()
+        << ", deleting it and continuing without it (the next start will read every segment)";
+    m_catalogJournalPtr->Delete();
+    m_catalogJournalPtr.reset();
+}
+
+unsigned int BundleStorageManagerBase::GetCircularBufferIndexForWrite(const unsigned int diskId) {
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+    unsigned int produceIndex = cb.GetIndexForWrite();
+    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full, wait until not full	
+        //try again, but with the mutex
+        boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
+        produceIndex = cb.GetIndexForWrite();
+        if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full again (lock mutex (above) before checking condition)
+            m_conditionVariableMainThread.wait(lockMainThread); // call lock.unlock() and blocks the current thread
+            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            produceIndex = cb.GetIndexForWrite(); //should definitely have an index now (prevents an extra lock, unlock operation)
+        }
+    }
+    return produceIndex;
+}
+
 
 uint64_t BundleStorageManagerBase::PopTop(BundleStorageManagerSession_ReadFromDisk & session, const std::vector<cbhe_eid_t> & availableDestinationEids) { //0 if empty, size if entry
 
@@ -222,6 +780,8 @@ uint64_t BundleStorageManagerBase::PopTop(BundleStorageManagerSession_ReadFromDi
     }
     session.nextLogicalSegment = 0;
     session.nextLogicalSegmentToCache = 0;
+    session.nextSegmentCursor.Reset();
+    session.nextSegmentToCacheCursor.Reset();
     session.cacheReadIndex = 0;
     session.cacheWriteIndex = 0;
 
@@ -235,6 +795,8 @@ uint64_t BundleStorageManagerBase::PopTop(BundleStorageManagerSession_ReadFromDi
     }
     session.nextLogicalSegment = 0;
     session.nextLogicalSegmentToCache = 0;
+    session.nextSegmentCursor.Reset();
+    session.nextSegmentToCacheCursor.Reset();
     session.cacheReadIndex = 0;
     session.cacheWriteIndex = 0;
 
@@ -248,12 +810,35 @@ uint64_t BundleStorageManagerBase::PopTop(BundleStorageManagerSession_ReadFromDi
     }
     session.nextLogicalSegment = 0;
     session.nextLogicalSegmentToCache = 0;
+    session.nextSegmentCursor.Reset();
+    session.nextSegmentToCacheCursor.Reset();
     session.cacheReadIndex = 0;
     session.cacheWriteIndex = 0;
 
     return session.catalogEntryPtr->bundleSizeBytes;
 }
 
+uint64_t BundleStorageManagerBase::PopTopFromReleaseIndex(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t releaseIndexId) { //0 if empty, size if entry
+
+    session.catalogEntryPtr = m_bundleStorageCatalog.PopEntryFromReleaseIndex(session.custodyId, releaseIndexId);
+    if (session.catalogEntryPtr == NULL) {
+        return 0;
+    }
+    session.nextLogicalSegment = 0;
+    session.nextLogicalSegmentToCache = 0;
+    session.nextSegmentCursor.Reset();
+    session.nextSegmentToCacheCursor.Reset();
+    session.cacheReadIndex = 0;
+    session.cacheWriteIndex = 0;
+
+    return session.catalogEntryPtr->bundleSizeBytes;
+}
+uint64_t BundleStorageManagerBase::CreateReleaseIndex(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests) {
+    return m_bundleStorageCatalog.CreateReleaseIndex(availableDests);
+}
+bool BundleStorageManagerBase::DeleteReleaseIndex(const uint64_t releaseIndexId) {
+    return m_bundleStorageCatalog.DeleteReleaseIndex(releaseIndexId);
+}
 
 bool BundleStorageManagerBase::ReturnTop(BundleStorageManagerSession_ReadFromDisk & session) { //0 if empty, size if entry
     return ((session.catalogEntryPtr != NULL) && m_bundleStorageCatalog.ReturnEntryToAwaitingSend(*session.catalogEntryPtr, session.custodyId));
@@ -269,26 +854,27 @@ catalog_entry_t * BundleStorageManagerBase::GetCatalogEntryPtrFromCustodyId(cons
     return m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
 }
 
-std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_ReadFromDisk & session, void * buf) {
-    const segment_id_chain_vec_t & segments = session.catalogEntryPtr->segmentIdChainVec;
+//queue reads of the session's next uncached segments while its read cache has room,
+//stopping early (leaving the rest to TopSegment) at a full disk queue unless waitWhileDiskQueueFull
+void BundleStorageManagerBase::QueueSegmentReads(BundleStorageManagerSession_ReadFromDisk & session, const bool waitWhileDiskQueueFull) {
+    const segment_id_extent_vec_t & segmentIdExtentVec = session.catalogEntryPtr->segmentIdExtentVec;
 
-    while (((session.nextLogicalSegmentToCache - session.nextLogicalSegment) < READ_CACHE_NUM_SEGMENTS_PER_SESSION)
-        && (session.nextLogicalSegmentToCache < segments.size()))
-    {
-        const segment_id_t segmentId = segments[session.nextLogicalSegmentToCache++];
+    while ((session.nextLogicalSegmentToCache - session.nextLogicalSegment) < READ_CACHE_NUM_SEGMENTS_PER_SESSION) {
+        const segment_id_t segmentId = session.nextSegmentToCacheCursor.Get(segmentIdExtentVec);
+        if (segmentId == SEGMENT_ID_LAST) {
+            break;
+        }
         const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
-        CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
-        unsigned int produceIndex = cb.GetIndexForWrite();
-        while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full, wait until not full	
-            //try again, but with the mutex
-            boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
-            produceIndex = cb.GetIndexForWrite();
-            if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full again (lock mutex (above) before checking condition)
-                m_conditionVariableMainThread.wait(lockMainThread); // call lock.unlock() and blocks the current thread
-                //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
-                produceIndex = cb.GetIndexForWrite(); //should definitely have an index now (prevents an extra lock, unlock operation)
-            }
+        boost::mutex::scoped_lock lockProducer(m_circularIndexBufferProducerMutexes[diskIndex]);
+        unsigned int produceIndex;
+        if (waitWhileDiskQueueFull) {
+            produceIndex = GetCircularBufferIndexForWrite(diskIndex);
+        }
+        else if ((produceIndex = m_circularIndexBuffersVec[diskIndex].GetIndexForWrite()) == CIRCULAR_INDEX_BUFFER_FULL) {
+            break;
         }
+        ++session.nextLogicalSegmentToCache;
+        session.nextSegmentToCacheCursor.Advance(segmentIdExtentVec);
 
         session.readCacheIsSegmentReady[session.cacheWriteIndex] = false;
         m_circularBufferIsReadCompletedPointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCacheIsSegmentReady[session.cacheWriteIndex];
@@ -298,7 +884,9 @@ std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_Rea
 
         CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
     }
+}
 
+void BundleStorageManagerBase::WaitForCachedSegment(BundleStorageManagerSession_ReadFromDisk & session) {
     volatile bool & readIsReadyRef = session.readCacheIsSegmentReady[session.cacheReadIndex];
     while (!readIsReadyRef) { //store the volatile, wait until read is ready		
         //try again, but with the mutex
@@ -308,9 +896,40 @@ std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_Rea
             //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
         }
     }
+}
+
+void BundleStorageManagerBase::ReadAhead(BundleStorageManagerSession_ReadFromDisk & session) {
+    if (M_HOT_TIER_CACHE_BYTES && (!session.catalogEntryPtr->IsInSlab())) {
+        boost::mutex::scoped_lock lock(m_hotTierMutex);
+        if (m_hotTierHeadSegmentIdToFifoIteratorMap.count(session.catalogEntryPtr->segmentIdExtentVec[0].startSegmentId)) {
+            return; //will be read from memory
+        }
+    }
+    QueueSegmentReads(session, false);
+}
+
+void BundleStorageManagerBase::WaitForReadAhead(BundleStorageManagerSession_ReadFromDisk & session) {
+    while (session.nextLogicalSegment < session.nextLogicalSegmentToCache) {
+        WaitForCachedSegment(session);
+        ++session.nextLogicalSegment;
+        session.cacheReadIndex = (session.cacheReadIndex + 1) % READ_CACHE_NUM_SEGMENTS_PER_SESSION;
+    }
+}
+
+std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_ReadFromDisk & session, void * buf) {
+    const segment_id_extent_vec_t & segmentIdExtentVec = session.catalogEntryPtr->segmentIdExtentVec;
+    const std::size_t headerOffset = session.catalogEntryPtr->slabSlotOffset; //the slot of a slab bundle, else the start of the segment
+
+    if ((session.nextLogicalSegmentToCache == 0) && M_HOT_TIER_CACHE_BYTES && (headerOffset == 0)) {
+        //segment by segment reads come from the disk, so write the bundle back (ahead of the reads below) if still in memory
+        WriteBackHotTierBundle(segmentIdExtentVec[0].startSegmentId);
+    }
+
+    QueueSegmentReads(session, true);
+    WaitForCachedSegment(session);
 
     StorageSegmentHeader storageSegmentHeader;
-    memcpy(&storageSegmentHeader, (void*)&session.readCache[session.cacheReadIndex * SEGMENT_SIZE + 0], SEGMENT_RESERVED_SPACE);
+    memcpy(&storageSegmentHeader, (void*)&session.readCache[session.cacheReadIndex * SEGMENT_SIZE + headerOffset], SEGMENT_RESERVED_SPACE);
     storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
     if ((session.nextLogicalSegment == 0) && (storageSegmentHeader.bundleSizeBytes != session.catalogEntryPtr->bundleSizeBytes)) {// ? chainInfo.first : UINT64_MAX;
         LOG_ERROR(subprocess) << "Error: read bundle size bytes = " << storageSegmentHeader.bundleSizeBytes <<
@@ -321,32 +940,49 @@ std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_Rea
     }
 
     ++session.nextLogicalSegment;
-    if ((session.nextLogicalSegment != segments.size()) && (storageSegmentHeader.nextSegmentId != segments[session.nextLogicalSegment])) {
+    session.nextSegmentCursor.Advance(segmentIdExtentVec);
+    const segment_id_t expectedNextSegmentId = session.nextSegmentCursor.Get(segmentIdExtentVec);
+    if ((expectedNextSegmentId != SEGMENT_ID_LAST) && (storageSegmentHeader.nextSegmentId != expectedNextSegmentId)) {
         LOG_ERROR(subprocess) << "Error: read nextSegmentId = " << (storageSegmentHeader.nextSegmentId) <<
-            " does not match segment = " << segments[session.nextLogicalSegment];
+            " does not match segment = " << expectedNextSegmentId;
     }
-    else if ((session.nextLogicalSegment == segments.size()) && (storageSegmentHeader.nextSegmentId != SEGMENT_ID_LAST)) {
+    else if ((expectedNextSegmentId == SEGMENT_ID_LAST) && (storageSegmentHeader.nextSegmentId != SEGMENT_ID_LAST)) {
         LOG_ERROR(subprocess) << "Error: read nextSegmentId = " << storageSegmentHeader.nextSegmentId << " is not SEGMENT_ID_LAST";
     }
 
     std::size_t size = BUNDLE_STORAGE_PER_SEGMENT_SIZE;
-    if (storageSegmentHeader.nextSegmentId == SEGMENT_ID_LAST) {
+    if ((storageSegmentHeader.nextSegmentId == SEGMENT_ID_LAST) || (headerOffset != 0)) { //(a slab bundle is always its one last segment)
         uint64_t modBytes = (session.catalogEntryPtr->bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE);
         if (modBytes != 0) {
             size = modBytes;
         }
     }
 
-    memcpy(buf, (void*)&session.readCache[session.cacheReadIndex * SEGMENT_SIZE + SEGMENT_RESERVED_SPACE], size);
+    memcpy(buf, (void*)&session.readCache[session.cacheReadIndex * SEGMENT_SIZE + headerOffset + SEGMENT_RESERVED_SPACE], size);
     session.cacheReadIndex = (session.cacheReadIndex + 1) % READ_CACHE_NUM_SEGMENTS_PER_SESSION;
 
 
     return size;
 }
 bool BundleStorageManagerBase::ReadAllSegments(BundleStorageManagerSession_ReadFromDisk & session, std::vector<uint8_t> & buf) {
-    const std::size_t numSegmentsToRead = session.catalogEntryPtr->segmentIdChainVec.size();
+    buf.resize(session.catalogEntryPtr->bundleSizeBytes);
+    return ReadAllSegments(session, buf.data());
+}
+bool BundleStorageManagerBase::ReadAllSegments(BundleStorageManagerSession_ReadFromDisk & session, uint8_t * buf) {
+    if (M_HOT_TIER_CACHE_BYTES && (!session.catalogEntryPtr->IsInSlab())) {
+        boost::mutex::scoped_lock lock(m_hotTierMutex);
+        std::unordered_map<segment_id_t, hot_tier_fifo_t::iterator>::iterator mapIt =
+            m_hotTierHeadSegmentIdToFifoIteratorMap.find(session.catalogEntryPtr->segmentIdExtentVec[0].startSegmentId);
+        if (mapIt != m_hotTierHeadSegmentIdToFifoIteratorMap.end()) {
+            const std::vector<uint8_t> & data = mapIt->second->data;
+            memcpy(buf, data.data(), data.size());
+            ++m_numHotTierHits;
+            return (data.size() == session.catalogEntryPtr->bundleSizeBytes);
+        }
+        ++m_numHotTierMisses;
+    }
+    const std::size_t numSegmentsToRead = session.catalogEntryPtr->GetNumSegments();
     const uint64_t totalBytesToRead = session.catalogEntryPtr->bundleSizeBytes;
-    buf.resize(totalBytesToRead);
     std::size_t totalBytesRead = 0;
     for (std::size_t i = 0; i < numSegmentsToRead; ++i) {
         totalBytesRead += TopSegment(session, &buf[i*BUNDLE_STORAGE_PER_SEGMENT_SIZE]);
@@ -364,43 +1000,52 @@ bool BundleStorageManagerBase::RemoveReadBundleFromDisk(BundleStorageManagerSess
     return RemoveReadBundleFromDisk(sessionRead.catalogEntryPtr, sessionRead.custodyId);
 }
 bool BundleStorageManagerBase::RemoveReadBundleFromDisk(const catalog_entry_t * catalogEntryPtr, const uint64_t custodyId) {
-    const segment_id_chain_vec_t & segmentIdChainVec = catalogEntryPtr->segmentIdChainVec;
+    const segment_id_extent_vec_t & segmentIdExtentVec = catalogEntryPtr->segmentIdExtentVec;
 
-    //destroy the head on the disk by writing UINT64_MAX to bundleSizeBytes of first logical segment
-
-
-    static const uint64_t bundleSizeBytesLittleEndian = UINT64_MAX;
-    const segment_id_t segmentId = segmentIdChainVec[0];
-    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
-    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
-    unsigned int produceIndex = cb.GetIndexForWrite();
-    while (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full, wait until not full	
-        //try again, but with the mutex
-        boost::mutex::scoped_lock lockMainThread(m_mutexMainThread);
-        produceIndex = cb.GetIndexForWrite();
-        if (produceIndex == CIRCULAR_INDEX_BUFFER_FULL) { //if full again (lock mutex (above) before checking condition)
-            m_conditionVariableMainThread.wait(lockMainThread); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
-            produceIndex = cb.GetIndexForWrite(); //should definitely have an index now (prevents an extra lock, unlock operation)
+    bool successFreedSegments;
+    if (catalogEntryPtr->IsInSlab()) {
+        successFreedSegments = FreeSlabSlot(*catalogEntryPtr);
+    }
+    else {
+        //destroy the head on the disk by writing UINT64_MAX to bundleSizeBytes of first logical segment
+        static const uint64_t bundleSizeBytesLittleEndian = UINT64_MAX;
+        const segment_id_t segmentId = segmentIdExtentVec[0].startSegmentId;
+        const bool wasNeverWrittenToDisk = (M_HOT_TIER_CACHE_BYTES && CancelHotTierWriteBack(segmentId)); //no head to destroy if still in the hot tier
+        if (!wasNeverWrittenToDisk) {
+            QueueSegmentWrite(segmentId, &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
         }
+        successFreedSegments = m_memoryManager.FreeSegmentExtents_ThreadSafe(segmentIdExtentVec);
+    }
+    if (m_catalogJournalPtr && (!m_catalogJournalPtr->AppendRemove(custodyId))) {
+        DropCatalogJournal();
     }
-
-    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
-    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE];
-
-
-    uint8_t * const dataCb = &circularBufferBlockDataPtr[produceIndex * SEGMENT_SIZE];
-    circularBufferSegmentIdsPtr[produceIndex] = segmentId;
-    m_circularBufferReadFromStoragePointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
-
-    memcpy(dataCb, &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
-
-
-    CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
-
-    const bool successFreedSegments = m_memoryManager.FreeSegments_ThreadSafe(segmentIdChainVec);
     return (m_bundleStorageCatalog.Remove(custodyId, false).first && successFreedSegments);
 }
+uint64_t BundleStorageManagerBase::ReapExpiredBundles(const uint64_t thresholdSecondsSinceStartOfYear2000, const std::size_t maxBundlesToReap,
+    std::vector<std::pair<uint64_t, cbhe_eid_t> > & reapedCustodyIdsAndDestEids)
+{
+    reapedCustodyIdsAndDestEids.clear();
+    std::vector<uint64_t> expiredCustodyIds;
+    m_bundleStorageCatalog.PopExpiredEntriesFromAwaitingSend(thresholdSecondsSinceStartOfYear2000, maxBundlesToReap, expiredCustodyIds);
+    uint64_t bytesReclaimed = 0;
+    for (std::size_t i = 0; i < expiredCustodyIds.size(); ++i) {
+        const uint64_t custodyId = expiredCustodyIds[i];
+        const catalog_entry_t * catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
+        if (catalogEntryPtr == NULL) {
+            LOG_ERROR(subprocess) << "expired custody id " << custodyId << " is not in the catalog";
+            continue;
+        }
+        const uint64_t bundleSizeBytes = catalogEntryPtr->bundleSizeBytes;
+        const cbhe_eid_t destEid = catalogEntryPtr->destEid;
+        if (!RemoveReadBundleFromDisk(catalogEntryPtr, custodyId)) { //already popped from awaiting send
+            LOG_ERROR(subprocess) << "unable to remove expired custody id " << custodyId << " from disk";
+            continue;
+        }
+        bytesReclaimed += bundleSizeBytes;
+        reapedCustodyIdsAndDestEids.emplace_back(custodyId, destEid);
+    }
+    return bytesReclaimed;
+}
 uint64_t * BundleStorageManagerBase::GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid) {
     return m_bundleStorageCatalog.GetCustodyIdFromUuid(bundleUuid);
 }
@@ -414,156 +1059,476 @@ bool BundleStorageManagerBase::GetStorageExpiringBeforeThresholdTelemetry(Storag
 //	return session.chainInfoVecPtr->front().second.size(); //use the front as new writes will be pushed back
 //}
 
-bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored) {
-    *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
-    uint8_t dataReadBuf[SEGMENT_SIZE];
-    std::vector<FILE *> fileHandlesVec(M_NUM_STORAGE_DISKS);
-    std::vector <uint64_t> fileSizesVec(M_NUM_STORAGE_DISKS);
-    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
-        const char * const filePath = m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath.c_str();
-        const boost::filesystem::path p(filePath);
-        if (boost::filesystem::exists(p)) {
-            fileSizesVec[diskId] = boost::filesystem::file_size(p);
-            LOG_DEBUG(subprocess) << "diskId " << diskId
-                << " has file size of " << fileSizesVec[diskId];
-        }
-        else {
-            LOG_ERROR(subprocess) << "Error: " << filePath << " does not exist";
+struct StorageFileCloser {
+    void operator()(FILE * fileHandle) const {
+        fclose(fileHandle);
+    }
+};
+
+//a run of consecutive segments on one disk (segment ids firstSegmentId, firstSegmentId + numDisks, ...) of the same custody id,
+//each linking to the segment following it in segment id order (i.e. on the next disk) except for the last segment of the run
+struct restore_segment_run_t {
+    segment_id_t firstSegmentId;
+    segment_id_t numSegments;
+    segment_id_t lastNextSegmentId;
+    uint64_t custodyId;
+};
+struct restore_head_segment_t {
+    segment_id_t headSegmentId;
+    uint64_t custodyId;
+    catalog_entry_t catalogEntry;
+    cbhe_bundle_uuid_t bundleUuid;
+    uint64_t slabSlotSizeBytes; //of the slab containing the bundle if catalogEntry.slabSlotOffset is nonzero
+};
+//the partial catalog of one disk
+struct restore_disk_scan_t {
+    restore_disk_scan_t() : success(false), numSegmentsScanned(0), elapsedSeconds(0) {}
+    bool success;
+    uint64_t numSegmentsScanned;
+    double elapsedSeconds;
+    std::vector<restore_segment_run_t> runsVec;
+    std::vector<restore_head_segment_t> headSegmentsVec;
+};
+
+//parse the primary block of a bundle beginning at bundleDataBegin into a new head of the disk scan
+static bool AddRestoredHead(BundleViewV6 & bv6, BundleViewV7 & bv7, uint8_t * bundleDataBegin, const std::size_t maxBundleBytes,
+    const segment_id_t segmentId, const StorageSegmentHeader & storageSegmentHeader, restore_disk_scan_t & diskScan)
+{
+    const uint8_t firstByte = bundleDataBegin[0];
+    const bool isBpVersion6 = (firstByte == 6);
+    const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+    PrimaryBlock * primaryBasePtr;
+    if (isBpVersion6) {
+        if (!bv6.LoadBundle(bundleDataBegin, maxBundleBytes, true)) { //load primary only
+            LOG_ERROR(subprocess) << "malformed bundle";
             return false;
         }
-        fileHandlesVec[diskId] = fopen(filePath, "rbR");
-        if (fileHandlesVec[diskId] == NULL) {
-            LOG_ERROR(subprocess) << "Error opening file " << filePath <<
-                " for reading and restoring";
+        primaryBasePtr = &bv6.m_primaryBlockView.header;
+    }
+    else if (isBpVersion7) {
+        if (!bv7.LoadBundle(bundleDataBegin, maxBundleBytes, true, true)) { //load primary only
+            LOG_ERROR(subprocess) << "malformed bundle";
             return false;
         }
+        primaryBasePtr = &bv7.m_primaryBlockView.header;
     }
+    else {
+        LOG_ERROR(subprocess) << "error in BundleStorageManagerBase::RestoreFromDisk: unknown bundle version detected";
+        return false;
+    }
+    diskScan.headSegmentsVec.emplace_back();
+    restore_head_segment_t & head = diskScan.headSegmentsVec.back();
+    head.headSegmentId = segmentId;
+    head.custodyId = storageSegmentHeader.custodyId;
+    head.catalogEntry.Init(*primaryBasePtr, storageSegmentHeader.bundleSizeBytes, NULL); //NULL replaced later at CatalogIncomingBundleForStore
+    head.bundleUuid = primaryBasePtr->GetCbheBundleUuidFromPrimary();
+    head.slabSlotSizeBytes = 0;
+    return true;
+}
 
-    bool restoreInProgress = true;
+//read a whole store file sequentially, RESTORE_READ_NUM_SEGMENTS at a time, keeping the segment headers as runs and parsing the primary of every head segment
+//(and of every live slot of a slab segment)
+static void ScanStorageDiskForRestore(const std::string & filePath, const unsigned int diskId, const unsigned int numDisks,
+    const uint64_t maxSegments, restore_disk_scan_t & diskScan)
+{
+    const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    std::unique_ptr<FILE, StorageFileCloser> fileHandle(fopen(filePath.c_str(), "rb"));
+    if (!fileHandle) {
+        LOG_ERROR(subprocess) << "Error opening file " << filePath << " for reading and restoring";
+        return;
+    }
+    std::vector<uint8_t> readBuf(RESTORE_READ_NUM_SEGMENTS * SEGMENT_SIZE);
     BundleViewV6 bv6;
     BundleViewV7 bv7;
-    for (segment_id_t potentialHeadSegmentId = 0; restoreInProgress; ++potentialHeadSegmentId) {
-        if (!m_memoryManager.IsSegmentFree(potentialHeadSegmentId)) continue;
-        segment_id_t segmentId = potentialHeadSegmentId;
-        BundleStorageManagerSession_WriteToDisk session;
-        catalog_entry_t & catalogEntry = session.catalogEntry;
-        segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
-        bool headSegmentFound = false;
-        uint64_t custodyIdHeadSegment;
-        PrimaryBlock * primaryBasePtr = NULL;
-        for (session.nextLogicalSegment = 0; ; ++session.nextLogicalSegment) {
-            const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
-            FILE * const fileHandle = fileHandlesVec[diskIndex];
-            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
-            const uint64_t fileSize = fileSizesVec[diskIndex];
-            if ((session.nextLogicalSegment == 0) && ((offsetBytes + SEGMENT_SIZE) > fileSize)) {
-                LOG_INFO(subprocess) << "end of restore";
-                restoreInProgress = false;
-                break;
+    restore_segment_run_t * currentRunPtr = NULL;
+    segment_id_t currentRunLastSegmentId = 0;
+    segment_id_t segmentId = diskId;
+    while (true) {
+        const std::size_t bytesReadFromFread = fread(readBuf.data(), 1, readBuf.size(), fileHandle.get());
+        const std::size_t numSegmentsRead = bytesReadFromFread / SEGMENT_SIZE; //ignore a partially written last segment
+        for (std::size_t i = 0; i < numSegmentsRead; ++i, segmentId += numDisks) {
+            if (segmentId >= maxSegments) {
+                LOG_ERROR(subprocess) << filePath << " is larger than the storage capacity";
+                return;
             }
-#ifdef _MSC_VER 
-            _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
-#elif defined __APPLE__ 
-            fseeko(fileHandle, offsetBytes, SEEK_SET);
-#else
-            fseeko64(fileHandle, offsetBytes, SEEK_SET);
-#endif
-
-            const std::size_t bytesReadFromFread = fread((void*)dataReadBuf, 1, SEGMENT_SIZE, fileHandle);
-            if (bytesReadFromFread != SEGMENT_SIZE) {
-                LOG_ERROR(subprocess) << "Error reading at offset " << offsetBytes <<
-                    " for disk " << diskIndex << " filesize " << fileSize << " logical segment "
-                    << session.nextLogicalSegment << " bytesread " << bytesReadFromFread;
-                return false;
-            }
-
+            uint8_t * const segmentData = &readBuf[i * SEGMENT_SIZE];
             StorageSegmentHeader storageSegmentHeader;
-            memcpy(&storageSegmentHeader, dataReadBuf, SEGMENT_RESERVED_SPACE);
+            memcpy(&storageSegmentHeader, segmentData, SEGMENT_RESERVED_SPACE);
             storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
+            ++diskScan.numSegmentsScanned;
 
-            
-            if ((session.nextLogicalSegment == 0) && (storageSegmentHeader.bundleSizeBytes != UINT64_MAX)) { //head segment
-                headSegmentFound = true;
-                custodyIdHeadSegment = storageSegmentHeader.custodyId;
-
-                uint8_t * bundleDataBegin = dataReadBuf + SEGMENT_RESERVED_SPACE;
-                
-                const uint8_t firstByte = bundleDataBegin[0];
-                const bool isBpVersion6 = (firstByte == 6);
-                const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
-                if (isBpVersion6) {
-                    if (!bv6.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true)) { //load primary only
-                        LOG_ERROR(subprocess) << "malformed bundle";
-                        return false;
-                    }
-                    Bpv6CbhePrimaryBlock & primary = bv6.m_primaryBlockView.header;
-                    primaryBasePtr = &primary;
+            if ((storageSegmentHeader.bundleSizeBytes == 0) && (storageSegmentHeader.custodyId == 0) && (storageSegmentHeader.nextSegmentId == 0)) {
+                currentRunPtr = NULL; //never written (sparse file hole)
+                continue;
+            }
+            if (storageSegmentHeader.bundleSizeBytes == STORAGE_SLAB_SEGMENT_MARKER) { //every live slot is a one segment bundle
+                currentRunPtr = NULL;
+                const uint64_t slotSizeBytes = storageSegmentHeader.custodyId;
+                if ((slotSizeBytes < MIN_SLAB_SLOT_SIZE_BYTES) || (slotSizeBytes > (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE))) {
+                    LOG_ERROR(subprocess) << "slab segment " << segmentId << " has an invalid slot size of " << slotSizeBytes;
+                    return;
                 }
-                else if (isBpVersion7) {
-                    if (!bv7.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true, true)) { //load primary only
-                        LOG_ERROR(subprocess) << "malformed bundle";
-                        return false;
+                const unsigned int numSlots = GetNumSlabSlots(slotSizeBytes);
+                for (unsigned int slotIndex = 0; slotIndex < numSlots; ++slotIndex) {
+                    const uint32_t slabSlotOffset = static_cast<uint32_t>(SEGMENT_RESERVED_SPACE + (slotIndex * slotSizeBytes));
+                    StorageSegmentHeader slotHeader;
+                    memcpy(&slotHeader, segmentData + slabSlotOffset, SEGMENT_RESERVED_SPACE);
+                    slotHeader.ToNativeEndianInplace(); //should optimize out and do nothing
+                    if ((slotHeader.bundleSizeBytes == 0) || (slotHeader.bundleSizeBytes == UINT64_MAX)) {
+                        continue; //never written or freed
+                    }
+                    if (((slotHeader.bundleSizeBytes + SEGMENT_RESERVED_SPACE) > slotSizeBytes) || (slotHeader.nextSegmentId != SEGMENT_ID_LAST)) {
+                        LOG_ERROR(subprocess) << "slot at offset " << slabSlotOffset << " of slab segment " << segmentId << " is malformed";
+                        return;
+                    }
+                    if (!AddRestoredHead(bv6, bv7, segmentData + slabSlotOffset + SEGMENT_RESERVED_SPACE, static_cast<std::size_t>(slotHeader.bundleSizeBytes),
+                        segmentId, slotHeader, diskScan))
+                    {
+                        return;
                     }
-                    Bpv7CbhePrimaryBlock & primary = bv7.m_primaryBlockView.header;
-                    primaryBasePtr = &primary;
+                    diskScan.headSegmentsVec.back().catalogEntry.slabSlotOffset = slabSlotOffset;
+                    diskScan.headSegmentsVec.back().slabSlotSizeBytes = slotSizeBytes;
                 }
-                else {
-                    LOG_ERROR(subprocess) << "error in BundleStorageManagerBase::RestoreFromDisk: unknown bundle version detected";
-                    return false;
+                continue;
+            }
+            const bool isHeadSegment = (storageSegmentHeader.bundleSizeBytes != UINT64_MAX);
+            if (isHeadSegment) {
+                if (!AddRestoredHead(bv6, bv7, segmentData + SEGMENT_RESERVED_SPACE, BUNDLE_STORAGE_PER_SEGMENT_SIZE, segmentId, storageSegmentHeader, diskScan)) {
+                    return;
                 }
-                const uint64_t totalSegmentsRequired = (storageSegmentHeader.bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((storageSegmentHeader.bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
+            }
+            if (currentRunPtr && (!isHeadSegment) && (currentRunPtr->custodyId == storageSegmentHeader.custodyId)
+                && (currentRunPtr->lastNextSegmentId == (currentRunLastSegmentId + 1)))
+            {
+                ++currentRunPtr->numSegments;
+            }
+            else {
+                diskScan.runsVec.emplace_back();
+                currentRunPtr = &diskScan.runsVec.back();
+                currentRunPtr->firstSegmentId = segmentId;
+                currentRunPtr->numSegments = 1;
+                currentRunPtr->custodyId = storageSegmentHeader.custodyId;
+            }
+            currentRunPtr->lastNextSegmentId = storageSegmentHeader.nextSegmentId;
+            currentRunLastSegmentId = segmentId;
+        }
+        if (bytesReadFromFread != readBuf.size()) {
+            if (ferror(fileHandle.get())) {
+                LOG_ERROR(subprocess) << "Error reading " << filePath << " at segment " << segmentId;
+                return;
+            }
+            break; //end of file
+        }
+    }
+    diskScan.elapsedSeconds = (boost::posix_time::microsec_clock::universal_time() - startTime).total_microseconds() * 1e-6;
+    diskScan.success = true;
+}
+
+//find the scanned header of segmentId, return false if it was never written
+static bool FindRestoredSegment(const std::vector<restore_disk_scan_t> & diskScansVec, const segment_id_t segmentId,
+    uint64_t & custodyId, segment_id_t & nextSegmentId)
+{
+    const unsigned int numDisks = static_cast<unsigned int>(diskScansVec.size());
+    const std::vector<restore_segment_run_t> & runsVec = diskScansVec[segmentId % numDisks].runsVec;
+    std::vector<restore_segment_run_t>::const_iterator it = std::upper_bound(runsVec.cbegin(), runsVec.cend(), segmentId,
+        [](const segment_id_t id, const restore_segment_run_t & run) { return id < run.firstSegmentId; });
+    if (it == runsVec.cbegin()) {
+        return false;
+    }
+    --it;
+    const segment_id_t indexInRun = (segmentId - it->firstSegmentId) / numDisks;
+    if (indexInRun >= it->numSegments) {
+        return false;
+    }
+    custodyId = it->custodyId;
+    nextSegmentId = ((indexInRun + 1) == it->numSegments) ? it->lastNextSegmentId : (segmentId + 1);
+    return true;
+}
+
+//scan every disk concurrently (one thread per disk), then link the segment chains of the head segments
+//found on all disks and catalog the bundles in head segment id order
+bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored) {
+    *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        const std::string & filePath = m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath;
+        if (!boost::filesystem::exists(filePath)) {
+            LOG_ERROR(subprocess) << "Error: " << filePath << " does not exist";
+            return false;
+        }
+        LOG_DEBUG(subprocess) << "diskId " << diskId << " has file size of " << boost::filesystem::file_size(filePath);
+    }
 
-                *totalBytesRestored += storageSegmentHeader.bundleSizeBytes;
-                *totalSegmentsRestored += totalSegmentsRequired;
-                catalogEntry.Init(*primaryBasePtr, storageSegmentHeader.bundleSizeBytes, totalSegmentsRequired, NULL); //NULL replaced later at CatalogIncomingBundleForStore
+    std::vector<restore_disk_scan_t> diskScansVec(M_NUM_STORAGE_DISKS);
+    {
+        std::vector<std::unique_ptr<boost::thread> > threadsVec(M_NUM_STORAGE_DISKS);
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            threadsVec[diskId] = boost::make_unique<boost::thread>(
+                boost::bind(&ScanStorageDiskForRestore, boost::cref(m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath),
+                    diskId, M_NUM_STORAGE_DISKS, M_MAX_SEGMENTS, boost::ref(diskScansVec[diskId])));
+        }
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            threadsVec[diskId]->join();
+        }
+    }
+    std::size_t totalHeadSegments = 0;
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        const restore_disk_scan_t & diskScan = diskScansVec[diskId];
+        if (!diskScan.success) {
+            return false;
+        }
+        totalHeadSegments += diskScan.headSegmentsVec.size();
+        const double bytesScanned = static_cast<double>(diskScan.numSegmentsScanned * SEGMENT_SIZE);
+        LOG_INFO(subprocess) << "diskId " << diskId << " scanned " << diskScan.numSegmentsScanned << " segments in " << diskScan.elapsedSeconds
+            << " seconds (" << ((diskScan.elapsedSeconds > 0) ? ((bytesScanned / diskScan.elapsedSeconds) * 1e-6) : 0) << " MB/s)";
+    }
+
+    //merge the per disk partial catalogs in head segment id order (the order a single threaded scan would catalog them)
+    std::vector<restore_head_segment_t *> headSegmentPtrsVec;
+    headSegmentPtrsVec.reserve(totalHeadSegments);
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        for (restore_head_segment_t & head : diskScansVec[diskId].headSegmentsVec) {
+            headSegmentPtrsVec.push_back(&head);
+        }
+    }
+    std::sort(headSegmentPtrsVec.begin(), headSegmentPtrsVec.end(), [](const restore_head_segment_t * a, const restore_head_segment_t * b) {
+        return (a->headSegmentId < b->headSegmentId) || ((a->headSegmentId == b->headSegmentId) && (a->catalogEntry.slabSlotOffset < b->catalogEntry.slabSlotOffset));
+    });
+
+    if (m_catalogJournalPtr && (!m_catalogJournalPtr->BeginCheckpoint())) { //committed by the constructor if this restore succeeds
+        DropCatalogJournal();
+    }
+
+    for (restore_head_segment_t * const headPtr : headSegmentPtrsVec) {
+        catalog_entry_t & catalogEntry = headPtr->catalogEntry;
+        if (catalogEntry.IsInSlab()) {
+            if (!RestoreSlabSlot_NotThreadSafe(headPtr->headSegmentId, catalogEntry.slabSlotOffset, headPtr->slabSlotSizeBytes)) {
+                return false;
             }
-            if (!headSegmentFound) break;
-            if (custodyIdHeadSegment != storageSegmentHeader.custodyId) { //shall be the same across all segments
-                LOG_ERROR(subprocess) << "error: custodyIdHeadSegment != custodyId";
+            catalogEntry.segmentIdExtentVec.assign(1, segment_id_extent_t(headPtr->headSegmentId, 1));
+            *totalBundlesRestored += 1;
+            *totalBytesRestored += catalogEntry.bundleSizeBytes;
+            CatalogPushedBundle(catalogEntry, headPtr->bundleUuid, headPtr->custodyId);
+            continue;
+        }
+        if (!m_memoryManager.IsSegmentFree(headPtr->headSegmentId)) {
+            continue; //already part of an earlier bundle's chain
+        }
+        const uint64_t totalSegmentsRequired = (catalogEntry.bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((catalogEntry.bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
+        segment_id_t segmentId = headPtr->headSegmentId;
+        for (uint64_t logicalSegment = 0; ; ++logicalSegment) {
+            uint64_t custodyId;
+            segment_id_t nextSegmentId;
+            if (!FindRestoredSegment(diskScansVec, segmentId, custodyId, nextSegmentId)) {
+                LOG_ERROR(subprocess) << "error: segmentId " << segmentId << " was never written";
                 return false;
             }
-            if ((session.nextLogicalSegment) >= segmentIdChainVec.size()) {
-                LOG_ERROR(subprocess) << "error: logical segment exceeds total segments required";
+            if (headPtr->custodyId != custodyId) { //shall be the same across all segments
+                LOG_ERROR(subprocess) << "error: custodyIdHeadSegment != custodyId";
                 return false;
             }
-            if (!m_memoryManager.IsSegmentFree(segmentId)) { //todo this is redundant per function below
-                LOG_ERROR(subprocess) << "error: segmentId is already allocated";
+            if (logicalSegment >= totalSegmentsRequired) {
+                LOG_ERROR(subprocess) << "error: logical segment exceeds total segments required";
                 return false;
             }
             if (!m_memoryManager.AllocateSegmentId_NotThreadSafe(segmentId)) {
                 LOG_ERROR(subprocess) << "error: AllocateSegmentId_NotThreadSafe: segmentId is already allocated";
                 return false;
             }
-            segmentIdChainVec[session.nextLogicalSegment] = segmentId;
+            MemoryManagerTreeArray::AppendSegmentIdToExtents(catalogEntry.segmentIdExtentVec, segmentId);
 
-
-
-            if ((session.nextLogicalSegment + 1) >= segmentIdChainVec.size()) { //==
-                if (storageSegmentHeader.nextSegmentId != SEGMENT_ID_LAST) { //there are more segments
+            if ((logicalSegment + 1) >= totalSegmentsRequired) { //==
+                if (nextSegmentId != SEGMENT_ID_LAST) { //there are more segments
                     LOG_ERROR(subprocess) << "error: at the last logical segment but nextSegmentId != SEGMENT_ID_LAST";
                     return false;
                 }
-                m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, *primaryBasePtr, storageSegmentHeader.custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
-                *totalBundlesRestored += 1;
                 break;
             }
-
-            if (storageSegmentHeader.nextSegmentId == SEGMENT_ID_LAST) { //there are more segments
+            if (nextSegmentId == SEGMENT_ID_LAST) { //there are more segments
                 LOG_ERROR(subprocess) << "error: there are more logical segments but nextSegmentId == SEGMENT_ID_LAST";
                 return false;
             }
-            segmentId = storageSegmentHeader.nextSegmentId;
-
+            segmentId = nextSegmentId;
         }
+        *totalBundlesRestored += 1;
+        *totalBytesRestored += catalogEntry.bundleSizeBytes;
+        CatalogPushedBundle(catalogEntry, headPtr->bundleUuid, headPtr->custodyId);
+        *totalSegmentsRestored += totalSegmentsRequired;
     }
+    *totalSegmentsRestored += m_slabsMap.size(); //one segment per slab, shared by its slots
+    LOG_INFO(subprocess) << "end of restore";
 
+    m_successfullyRestoredFromDisk = true;
+    return true;
+}
 
-    for (unsigned int tId = 0; tId < M_NUM_STORAGE_DISKS; ++tId) {
-        fclose(fileHandlesVec[tId]);
-    }
 
-    m_successfullyRestoredFromDisk = true;
+
+
+static bool ReadStorageSegmentHeader(FILE * fileHandle, const uint64_t offsetBytes, StorageSegmentHeader & storageSegmentHeader) {
+#ifdef _MSC_VER 
+    _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
+#elif defined __APPLE__ 
+    fseeko(fileHandle, offsetBytes, SEEK_SET);
+#else
+    fseeko64(fileHandle, offsetBytes, SEEK_SET);
+#endif
+    if (fread(&storageSegmentHeader, 1, SEGMENT_RESERVED_SPACE, fileHandle) != SEGMENT_RESERVED_SPACE) {
+        return false;
+    }
+    storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
     return true;
 }
 
+//replay the catalog journal, validating each bundle's first and last segment headers on the disks,
+//and leave the catalog and memory manager untouched (so a full restore can follow) if the journal is unusable
+bool BundleStorageManagerBase::RestoreFromCatalogJournal(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored) {
+    *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
+    std::vector<catalog_journal_entry_t> liveEntries;
+    if ((!m_catalogJournalPtr) || (!m_catalogJournalPtr->ReadLiveEntries(liveEntries))) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<FILE, StorageFileCloser> > fileHandlesVec(M_NUM_STORAGE_DISKS);
+    std::vector<uint64_t> fileSizesVec(M_NUM_STORAGE_DISKS);
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        const std::string & filePath = m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath;
+        if (!boost::filesystem::exists(filePath)) {
+            LOG_ERROR(subprocess) << "Error: " << filePath << " does not exist";
+            return false;
+        }
+        fileSizesVec[diskId] = boost::filesystem::file_size(filePath);
+        fileHandlesVec[diskId].reset(fopen(filePath.c_str(), "rbR"));
+        if (!fileHandlesVec[diskId]) {
+            LOG_ERROR(subprocess) << "Error opening file " << filePath << " for reading and restoring";
+            return false;
+        }
+    }
 
+    std::vector<bool> isRemovedVec(liveEntries.size(), false);
+    std::vector<uint64_t> slabSlotSizesVec(liveEntries.size(), 0);
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        const catalog_journal_entry_t & entry = liveEntries[i];
+        const segment_id_extent_vec_t & segmentIdExtentVec = entry.catalogEntry.segmentIdExtentVec;
+        const uint64_t bundleSizeBytes = entry.catalogEntry.bundleSizeBytes;
+        const uint64_t totalSegmentsRequired = (bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
+        bool hasEmptyExtent = false;
+        for (std::size_t e = 0; e < segmentIdExtentVec.size(); ++e) {
+            hasEmptyExtent |= (segmentIdExtentVec[e].numSegments == 0);
+        }
+        if (hasEmptyExtent || (totalSegmentsRequired == 0) || (entry.catalogEntry.GetNumSegments() != totalSegmentsRequired)) {
+            LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " has the wrong number of segments";
+            return false;
+        }
+        if (entry.catalogEntry.IsInSlab()) { //validate the slab header and the bundle's slot header
+            const segment_id_t slabSegmentId = segmentIdExtentVec[0].startSegmentId;
+            const unsigned int diskIndex = slabSegmentId % M_NUM_STORAGE_DISKS;
+            const uint64_t offsetBytes = static_cast<uint64_t>(slabSegmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            StorageSegmentHeader slabHeader;
+            StorageSegmentHeader slotHeader;
+            if (((offsetBytes + SEGMENT_SIZE) > fileSizesVec[diskIndex])
+                || (!ReadStorageSegmentHeader(fileHandlesVec[diskIndex].get(), offsetBytes, slabHeader))
+                || (entry.catalogEntry.slabSlotOffset > (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE))
+                || (!ReadStorageSegmentHeader(fileHandlesVec[diskIndex].get(), offsetBytes + entry.catalogEntry.slabSlotOffset, slotHeader))
+                || (slotHeader.custodyId != entry.custodyId))
+            {
+                LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " does not match the disk";
+                return false;
+            }
+            if ((slabHeader.bundleSizeBytes == UINT64_MAX) || (slotHeader.bundleSizeBytes == UINT64_MAX)) { //slab or slot freed on the disk but the journal remove record was lost
+                isRemovedVec[i] = true;
+                continue;
+            }
+            if ((slabHeader.bundleSizeBytes != STORAGE_SLAB_SEGMENT_MARKER) || ((bundleSizeBytes + SEGMENT_RESERVED_SPACE) > slabHeader.custodyId)
+                || (slotHeader.bundleSizeBytes != bundleSizeBytes) || (slotHeader.nextSegmentId != SEGMENT_ID_LAST))
+            {
+                LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " does not match its slab slot";
+                return false;
+            }
+            slabSlotSizesVec[i] = slabHeader.custodyId;
+            continue;
+        }
+        segment_id_extent_cursor_t cursor;
+        const segment_id_t headSegmentId = cursor.Get(segmentIdExtentVec);
+        cursor.Advance(segmentIdExtentVec);
+        const segment_id_t secondSegmentId = cursor.Get(segmentIdExtentVec); //SEGMENT_ID_LAST if only one segment
+        const segment_id_t lastSegmentId = segmentIdExtentVec.back().startSegmentId + (segmentIdExtentVec.back().numSegments - 1);
+        const segment_id_t segmentIdsToCheck[2] = { headSegmentId, lastSegmentId };
+        for (unsigned int j = 0; j < ((totalSegmentsRequired == 1) ? 1U : 2U); ++j) {
+            const segment_id_t segmentId = segmentIdsToCheck[j];
+            const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            StorageSegmentHeader storageSegmentHeader;
+            if (((offsetBytes + SEGMENT_SIZE) > fileSizesVec[diskIndex])
+                || (!ReadStorageSegmentHeader(fileHandlesVec[diskIndex].get(), offsetBytes, storageSegmentHeader))
+                || (storageSegmentHeader.custodyId != entry.custodyId))
+            {
+                LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " does not match the disk";
+                return false;
+            }
+            if (j == 0) { //head segment
+                if (storageSegmentHeader.bundleSizeBytes == UINT64_MAX) { //head destroyed on the disk but the journal remove record was lost
+                    isRemovedVec[i] = true;
+                    break;
+                }
+                if ((storageSegmentHeader.bundleSizeBytes != bundleSizeBytes) || (storageSegmentHeader.nextSegmentId != secondSegmentId)) {
+                    LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " does not match its head segment";
+                    return false;
+                }
+            }
+            else if ((storageSegmentHeader.bundleSizeBytes != UINT64_MAX) || (storageSegmentHeader.nextSegmentId != SEGMENT_ID_LAST)) {
+                LOG_ERROR(subprocess) << "catalog journal custody id " << entry.custodyId << " does not match its last segment";
+                return false;
+            }
+        }
+    }
+
+    //allocate every segment (each slab segment once), undoing all allocations if two bundles claim the same segment
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        if (isRemovedVec[i]) continue;
+        const catalog_entry_t & catalogEntry = liveEntries[i].catalogEntry;
+        if (catalogEntry.IsInSlab()) {
+            if (!RestoreSlabSlot_NotThreadSafe(catalogEntry.segmentIdExtentVec[0].startSegmentId, catalogEntry.slabSlotOffset, slabSlotSizesVec[i])) {
+                LOG_ERROR(subprocess) << "catalog journal custody id " << liveEntries[i].custodyId << " has an invalid or already allocated slab slot";
+                for (std::size_t k = 0; k < i; ++k) {
+                    if ((!isRemovedVec[k]) && (!liveEntries[k].catalogEntry.IsInSlab())) {
+                        m_memoryManager.FreeSegmentExtents_ThreadSafe(liveEntries[k].catalogEntry.segmentIdExtentVec);
+                    }
+                }
+                FreeAllSlabs_NotThreadSafe();
+                return false;
+            }
+            continue;
+        }
+        const segment_id_extent_vec_t & segmentIdExtentVec = catalogEntry.segmentIdExtentVec;
+        for (std::size_t e = 0; e < segmentIdExtentVec.size(); ++e) {
+            const segment_id_extent_t & extent = segmentIdExtentVec[e];
+            for (segment_id_t segmentId = extent.startSegmentId; segmentId < (extent.startSegmentId + extent.numSegments); ++segmentId) {
+                if ((segmentId >= M_MAX_SEGMENTS) || (!m_memoryManager.AllocateSegmentId_NotThreadSafe(segmentId))) {
+                    LOG_ERROR(subprocess) << "catalog journal custody id " << liveEntries[i].custodyId << " has an invalid or already allocated segment";
+                    for (std::size_t k = 0; k <= i; ++k) {
+                        if ((!isRemovedVec[k]) && (!liveEntries[k].catalogEntry.IsInSlab())) {
+                            m_memoryManager.FreeSegmentExtents_ThreadSafe(liveEntries[k].catalogEntry.segmentIdExtentVec);
+                        }
+                    }
+                    FreeAllSlabs_NotThreadSafe();
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (!m_catalogJournalPtr->BeginCheckpoint()) { //committed by the constructor
+        DropCatalogJournal();
+    }
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        if (isRemovedVec[i]) continue;
+        catalog_journal_entry_t & entry = liveEntries[i];
+        *totalBytesRestored += entry.catalogEntry.bundleSizeBytes;
+        *totalSegmentsRestored += (entry.catalogEntry.IsInSlab()) ? 0 : entry.catalogEntry.GetNumSegments();
+        *totalBundlesRestored += 1;
+        CatalogPushedBundle(entry.catalogEntry, entry.bundleUuid, entry.custodyId);
+    }
+    *totalSegmentsRestored += m_slabsMap.size(); //one segment per slab, shared by its slots
+    LOG_INFO(subprocess) << "restored " << *totalBundlesRestored << " bundles from the catalog journal";
+    return true;
+}
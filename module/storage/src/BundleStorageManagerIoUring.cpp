@@ -0,0 +1,447 @@
+/**
+ * @file BundleStorageManagerIoUring.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE //O_DIRECT
+#endif
+#define _LARGEFILE64_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <cerrno>
+#include <cstring>
+
+#include "BundleStorageManagerIoUring.h"
+#include <string>
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <boost/make_unique.hpp>
+
+static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
+
+//number of submission queue entries per disk ring (power of 2 at least as large as a disk's circular buffer)
+static constexpr unsigned int IO_URING_ENTRIES_PER_DISK = 32;
+static_assert(IO_URING_ENTRIES_PER_DISK >= CIRCULAR_INDEX_BUFFER_SIZE, "io_uring must hold a full disk circular buffer");
+
+/** One io_uring instance (submission ring, completion ring, and submission queue entries) plus the open file for a single disk.
+ * All members except the condition variable and mutex are only accessed by that disk's thread.
+ */
+struct BundleStorageManagerIoUring::DiskRing {
+    DiskRing();
+    ~DiskRing();
+    bool Init(const int paramFileDescriptor, void * registeredBuffer, const std::size_t registeredBufferSize);
+    void PrepareSqe(const uint8_t opcode, const uint64_t offsetBytes, void * buffer, const unsigned int numBytes, const unsigned int slot, const bool drainFirst);
+    bool SubmitAndWait(const unsigned int numToSubmit, const unsigned int minComplete);
+
+    boost::condition_variable m_conditionVariable;
+    boost::mutex m_mutex;
+
+    int m_ringFd;
+    int m_fileFd;
+    void * m_sqRingPtr;
+    std::size_t m_sqRingSize;
+    void * m_cqRingPtr;
+    std::size_t m_cqRingSize;
+    struct io_uring_sqe * m_sqes;
+    std::size_t m_sqesSize;
+
+    unsigned int * m_sqTailPtr;
+    unsigned int m_sqMask;
+    unsigned int * m_sqArray;
+    unsigned int * m_cqHeadPtr;
+    unsigned int * m_cqTailPtr;
+    unsigned int m_cqMask;
+    struct io_uring_cqe * m_cqes;
+
+    //per circular buffer slot
+    struct iovec m_readIovecs[CIRCULAR_INDEX_BUFFER_SIZE];
+    segment_id_t m_slotSegmentIds[CIRCULAR_INDEX_BUFFER_SIZE];
+    bool m_slotInFlight[CIRCULAR_INDEX_BUFFER_SIZE];
+    bool m_slotCompleted[CIRCULAR_INDEX_BUFFER_SIZE];
+    unsigned int m_slotBytesTransferred[CIRCULAR_INDEX_BUFFER_SIZE]; //so far (a short transfer is resubmitted for the remainder)
+};
+
+BundleStorageManagerIoUring::DiskRing::DiskRing() :
+    m_ringFd(-1),
+    m_fileFd(-1),
+    m_sqRingPtr(MAP_FAILED),
+    m_sqRingSize(0),
+    m_cqRingPtr(MAP_FAILED),
+    m_cqRingSize(0),
+    m_sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+    m_sqesSize(0)
+{
+    for (unsigned int i = 0; i < CIRCULAR_INDEX_BUFFER_SIZE; ++i) {
+        m_slotInFlight[i] = false;
+        m_slotCompleted[i] = false;
+        m_slotBytesTransferred[i] = 0;
+    }
+}
+
+BundleStorageManagerIoUring::DiskRing::~DiskRing() {
+    if (m_sqes != MAP_FAILED) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if ((m_cqRingPtr != MAP_FAILED) && (m_cqRingPtr != m_sqRingPtr)) {
+        munmap(m_cqRingPtr, m_cqRingSize);
+    }
+    if (m_sqRingPtr != MAP_FAILED) {
+        munmap(m_sqRingPtr, m_sqRingSize);
+    }
+    if (m_ringFd >= 0) {
+        close(m_ringFd); //also unregisters the buffers
+    }
+    if (m_fileFd >= 0) {
+        close(m_fileFd);
+    }
+}
+
+bool BundleStorageManagerIoUring::DiskRing::Init(const int paramFileDescriptor, void * registeredBuffer, const std::size_t registeredBufferSize) {
+    m_fileFd = paramFileDescriptor;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, IO_URING_ENTRIES_PER_DISK, &params));
+    if (m_ringFd < 0) {
+        LOG_ERROR(subprocess) << "io_uring_setup failed: " << strerror(errno);
+        return false;
+    }
+    m_sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+    m_cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    const bool isSingleMmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (isSingleMmap) {
+        m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+        m_cqRingSize = m_sqRingSize;
+    }
+    m_sqRingPtr = mmap(NULL, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRingPtr == MAP_FAILED) {
+        LOG_ERROR(subprocess) << "io_uring mmap of submission ring failed: " << strerror(errno);
+        return false;
+    }
+    m_cqRingPtr = (isSingleMmap) ? m_sqRingPtr :
+        mmap(NULL, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+    if (m_cqRingPtr == MAP_FAILED) {
+        LOG_ERROR(subprocess) << "io_uring mmap of completion ring failed: " << strerror(errno);
+        return false;
+    }
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = static_cast<struct io_uring_sqe *>(mmap(NULL, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED) {
+        LOG_ERROR(subprocess) << "io_uring mmap of submission queue entries failed: " << strerror(errno);
+        return false;
+    }
+    uint8_t * const sqBase = static_cast<uint8_t *>(m_sqRingPtr);
+    uint8_t * const cqBase = static_cast<uint8_t *>(m_cqRingPtr);
+    m_sqTailPtr = reinterpret_cast<unsigned int *>(sqBase + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<unsigned int *>(sqBase + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned int *>(sqBase + params.sq_off.array);
+    m_cqHeadPtr = reinterpret_cast<unsigned int *>(cqBase + params.cq_off.head);
+    m_cqTailPtr = reinterpret_cast<unsigned int *>(cqBase + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned int *>(cqBase + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe *>(cqBase + params.cq_off.cqes);
+
+    //pin this disk's circular buffer block data so writes don't need per operation page mapping
+    struct iovec registeredIovec;
+    registeredIovec.iov_base = registeredBuffer;
+    registeredIovec.iov_len = registeredBufferSize;
+    if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS, &registeredIovec, 1) < 0) {
+        LOG_ERROR(subprocess) << "io_uring_register of buffers failed: " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+/** Fill the next submission queue entry (the caller guarantees there is room, i.e. no more than IO_URING_ENTRIES_PER_DISK unsubmitted or in flight).
+ * Writes always come from the registered buffer (IORING_OP_WRITE_FIXED), and reads go to the session read cache (IORING_OP_READV).
+ * numBytes is SEGMENT_SIZE, or the remainder of a short transfer.
+ */
+void BundleStorageManagerIoUring::DiskRing::PrepareSqe(const uint8_t opcode, const uint64_t offsetBytes, void * buffer, const unsigned int numBytes, const unsigned int slot, const bool drainFirst) {
+    const unsigned int tail = *m_sqTailPtr; //only this thread modifies the tail
+    const unsigned int index = tail & m_sqMask;
+    struct io_uring_sqe * const sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->flags = (drainFirst) ? IOSQE_IO_DRAIN : 0;
+    sqe->fd = m_fileFd;
+    sqe->off = offsetBytes;
+    if (opcode == IORING_OP_WRITE_FIXED) {
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = numBytes;
+        sqe->buf_index = 0;
+    }
+    else { //IORING_OP_READV
+        struct iovec & iov = m_readIovecs[slot]; //must remain valid until completion
+        iov.iov_base = buffer;
+        iov.iov_len = numBytes;
+        sqe->addr = reinterpret_cast<uint64_t>(&iov);
+        sqe->len = 1;
+    }
+    sqe->user_data = slot;
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTailPtr, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool BundleStorageManagerIoUring::DiskRing::SubmitAndWait(const unsigned int numToSubmit, const unsigned int minComplete) {
+    while (true) {
+        const int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ringFd, numToSubmit, minComplete, (minComplete) ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+        if (ret >= 0) {
+            return true;
+        }
+        else if (errno != EINTR) {
+            LOG_ERROR(subprocess) << "io_uring_enter failed: " << strerror(errno);
+            return false;
+        }
+    }
+}
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring() : BundleStorageManagerIoUring("storageConfig.json") {}
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring(const std::string & jsonConfigFileName) : BundleStorageManagerIoUring(StorageConfig::CreateFromJsonFile(jsonConfigFileName)) {
+    if (!m_storageConfigPtr) {
+        LOG_ERROR(subprocess) << "cannot open storage json config file: " << jsonConfigFileName;
+        return;
+    }
+}
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring(const StorageConfig_ptr & storageConfigPtr) :
+    BundleStorageManagerBase(storageConfigPtr),
+
+    M_DISK_QUEUE_DEPTH((m_storageConfigPtr) ? std::max<unsigned int>(1, m_storageConfigPtr->m_diskQueueDepth) : 1),
+    m_diskRingPtrsVec(M_NUM_STORAGE_DISKS),
+    m_threadPtrsVec(M_NUM_STORAGE_DISKS),
+    m_running(false),
+    m_noFatalErrorsOccurred(true)
+{
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        m_diskRingPtrsVec[diskId] = boost::make_unique<DiskRing>();
+    }
+}
+
+void BundleStorageManagerIoUring::StopAllDiskThreads() {
+    m_running = false; //thread stopping criteria
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) { //only lock one mutex at a time to prevent deadlock (a worker may call this function on an error condition)
+        //lock then unlock each thread's mutex to prevent a missed notify after setting thread stopping criteria above
+        DiskRing & diskRing = *m_diskRingPtrsVec[diskId];
+        diskRing.m_mutex.lock();
+        diskRing.m_mutex.unlock();
+        diskRing.m_conditionVariable.notify_one();
+    }
+}
+
+BundleStorageManagerIoUring::~BundleStorageManagerIoUring() {
+    if (m_running && m_noFatalErrorsOccurred) {
+        WriteBackAllHotTierBundles(); //queue the bundles only held in memory while the disk threads are still running
+    }
+    StopAllDiskThreads();
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        if (m_threadPtrsVec[diskId]) {
+            m_threadPtrsVec[diskId]->join();
+            m_threadPtrsVec[diskId].reset(); //delete it
+        }
+    }
+}
+
+void BundleStorageManagerIoUring::Start() {
+    if ((!m_running) && (m_storageConfigPtr)) {
+        const bool useDirectIo = m_storageConfigPtr->m_useDirectIo;
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            const char * const filePath = m_filePathsAsStringVec[diskId].c_str();
+            LOG_INFO(subprocess) << ((m_successfullyRestoredFromDisk) ? "reopening " : "creating ") << filePath
+                << ((useDirectIo) ? " with O_DIRECT" : "");
+            const int baseFlags = (m_successfullyRestoredFromDisk) ? (O_RDWR | O_LARGEFILE) : (O_CREAT | O_RDWR | O_TRUNC | O_LARGEFILE);
+            int fileDescriptor = open(filePath, (useDirectIo) ? (baseFlags | O_DIRECT) : baseFlags, DEFFILEMODE);
+            if ((fileDescriptor < 0) && useDirectIo && (errno == EINVAL)) {
+                LOG_WARNING(subprocess) << "filesystem of " << filePath << " does not support O_DIRECT, falling back to buffered I/O";
+                fileDescriptor = open(filePath, baseFlags, DEFFILEMODE);
+            }
+            if (fileDescriptor < 0) {
+                LOG_ERROR(subprocess) << "error opening " << filePath;
+                return;
+            }
+            uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+            if (!m_diskRingPtrsVec[diskId]->Init(fileDescriptor, circularBufferBlockDataPtr, CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE)) {
+                LOG_ERROR(subprocess) << "error initializing io_uring for " << filePath;
+                return;
+            }
+        }
+        m_running = true;
+        m_noFatalErrorsOccurred = true;
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            m_threadPtrsVec[diskId] = boost::make_unique<boost::thread>(
+                boost::bind(&BundleStorageManagerIoUring::ThreadFunc, this, diskId)); //create and start the worker thread
+        }
+    }
+}
+
+void BundleStorageManagerIoUring::ThreadFunc(const unsigned int diskId) {
+    DiskRing & diskRing = *m_diskRingPtrsVec[diskId];
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
+    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+
+    //Slots [cb.GetIndexForRead(), cb.GetIndexForRead() + numSlotsSubmitted) are in flight or completed but not yet committed.
+    //Operations may complete out of order, but cb.CommitRead() must be called in order.
+    unsigned int numSlotsSubmitted = 0;
+    unsigned int numInFlight = 0;
+    unsigned int numResubmitted = 0; //remainders of short transfers, prepared while reaping and still in flight
+
+    while (m_noFatalErrorsOccurred) {
+        //queue up unsubmitted operations in the circular buffer, up to the configured queue depth
+        unsigned int numToSubmit = numResubmitted;
+        numResubmitted = 0;
+        const unsigned int numInBuffer = cb.NumInBuffer(); //store the volatile
+        while ((numSlotsSubmitted < numInBuffer) && (numInFlight < M_DISK_QUEUE_DEPTH)) {
+            const unsigned int slot = (cb.GetIndexForRead() + numSlotsSubmitted) % CIRCULAR_INDEX_BUFFER_SIZE;
+            const segment_id_t segmentId = circularBufferSegmentIdsPtr[slot];
+            if (segmentId == SEGMENT_ID_LAST) {
+                LOG_ERROR(subprocess) << "error segmentId is last";
+                m_noFatalErrorsOccurred = false; //a fatal error occurred
+                break;
+            }
+            volatile uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + slot];
+            const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
+
+            //A read or write to a segment that already has an operation in flight (e.g. a bundle read back or deleted immediately after
+            //being written) must not be reordered by the kernel, so wait for all previously submitted operations to finish first.
+            bool drainFirst = false;
+            for (unsigned int i = 0; i < CIRCULAR_INDEX_BUFFER_SIZE; ++i) {
+                if (diskRing.m_slotInFlight[i] && (diskRing.m_slotSegmentIds[i] == segmentId)) {
+                    drainFirst = true;
+                    break;
+                }
+            }
+
+            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            if (isWriteToDisk) {
+                diskRing.PrepareSqe(IORING_OP_WRITE_FIXED, offsetBytes, &circularBufferBlockDataPtr[slot * SEGMENT_SIZE], SEGMENT_SIZE, slot, drainFirst);
+            }
+            else { //read from disk
+                diskRing.PrepareSqe(IORING_OP_READV, offsetBytes, (void*)readFromStorageDestPointer, SEGMENT_SIZE, slot, drainFirst);
+            }
+            diskRing.m_slotBytesTransferred[slot] = 0;
+            diskRing.m_slotSegmentIds[slot] = segmentId;
+            diskRing.m_slotInFlight[slot] = true;
+            ++numSlotsSubmitted;
+            ++numInFlight;
+            ++numToSubmit;
+        }
+        if (!m_noFatalErrorsOccurred) {
+            break;
+        }
+
+        if (numInFlight == 0) { //empty
+            boost::mutex::scoped_lock lock(diskRing.m_mutex);
+            if (cb.NumInBuffer() == 0) { //if empty again (lock mutex (above) before checking condition)
+                if (!m_running) { //m_running is mutex protected, if it stopped running, exit the thread (lock mutex (above) before checking condition)
+                    break; //thread stopping criteria (empty and not running)
+                }
+                diskRing.m_conditionVariable.wait(lock); // call lock.unlock() and blocks the current thread
+                //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+            }
+            continue;
+        }
+
+        //submit the new operations and block until at least one operation completes
+        if (!diskRing.SubmitAndWait(numToSubmit, 1)) {
+            m_noFatalErrorsOccurred = false;
+            break;
+        }
+
+        //reap all completions
+        unsigned int cqHead = *diskRing.m_cqHeadPtr; //only this thread modifies the head
+        const unsigned int cqTail = __atomic_load_n(diskRing.m_cqTailPtr, __ATOMIC_ACQUIRE);
+        while (cqHead != cqTail) {
+            const struct io_uring_cqe & cqe = diskRing.m_cqes[cqHead & diskRing.m_cqMask];
+            const unsigned int slot = static_cast<unsigned int>(cqe.user_data);
+            const int res = cqe.res;
+            ++cqHead;
+            if ((res < 0) && (res != -EINTR) && (res != -EAGAIN)) {
+                //like the asio implementation, a failed operation is never committed (a read is never reported ready with garbage,
+                //a write is never treated as on the disk), and this disk stops
+                LOG_ERROR(subprocess) << "error in BundleStorageManagerIoUring disk operation: " << strerror(-res);
+                m_noFatalErrorsOccurred = false;
+                continue;
+            }
+            if (res == 0) { //no progress (e.g. a read past the end of the file)
+                LOG_ERROR(subprocess) << "error in BundleStorageManagerIoUring disk operation: bytes_transferred("
+                    << diskRing.m_slotBytesTransferred[slot] << ") != SEGMENT_SIZE(" << SEGMENT_SIZE << ")";
+                m_noFatalErrorsOccurred = false;
+                continue;
+            }
+            if (res > 0) {
+                diskRing.m_slotBytesTransferred[slot] += static_cast<unsigned int>(res);
+            }
+            const unsigned int bytesTransferred = diskRing.m_slotBytesTransferred[slot];
+            if (bytesTransferred < SEGMENT_SIZE) { //short transfer (or interrupted), so resubmit the remainder after everything already submitted
+                const segment_id_t segmentId = diskRing.m_slotSegmentIds[slot];
+                const uint64_t offsetBytes = (static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE) + bytesTransferred;
+                volatile uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + slot];
+                if (readFromStorageDestPointer == NULL) { //write
+                    diskRing.PrepareSqe(IORING_OP_WRITE_FIXED, offsetBytes, &circularBufferBlockDataPtr[(slot * SEGMENT_SIZE) + bytesTransferred],
+                        SEGMENT_SIZE - bytesTransferred, slot, true);
+                }
+                else {
+                    diskRing.PrepareSqe(IORING_OP_READV, offsetBytes, (void*)(readFromStorageDestPointer + bytesTransferred),
+                        SEGMENT_SIZE - bytesTransferred, slot, true);
+                }
+                ++numResubmitted; //still in flight
+                continue;
+            }
+            diskRing.m_slotInFlight[slot] = false;
+            diskRing.m_slotCompleted[slot] = true;
+            --numInFlight;
+        }
+        __atomic_store_n(diskRing.m_cqHeadPtr, cqHead, __ATOMIC_RELEASE);
+        if (!m_noFatalErrorsOccurred) {
+            break;
+        }
+
+        //commit completed operations in circular buffer order
+        m_mutexMainThread.lock();
+        while (numSlotsSubmitted) {
+            const unsigned int consumeIndex = cb.GetIndexForRead();
+            if (!diskRing.m_slotCompleted[consumeIndex]) {
+                break;
+            }
+            diskRing.m_slotCompleted[consumeIndex] = false;
+            const bool isWriteToDisk = (m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex] == NULL);
+            if (!isWriteToDisk) {
+                *(m_circularBufferIsReadCompletedPointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex]) = true;
+            }
+            cb.CommitRead();
+            --numSlotsSubmitted;
+        }
+        m_mutexMainThread.unlock();
+        m_conditionVariableMainThread.notify_all(); //the storage writer and release threads may both be waiting
+    }
+
+    if (!m_noFatalErrorsOccurred) {
+        StopAllDiskThreads(); //sets m_running = false;
+    }
+}
+
+//virtual function to be called immediately after a disk's circular buffer CommitWrite();
+void BundleStorageManagerIoUring::CommitWriteAndNotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) {
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable& cb = m_circularIndexBuffersVec[diskId];
+    DiskRing & diskRing = *m_diskRingPtrsVec[diskId];
+
+    diskRing.m_mutex.lock();
+    cb.CommitWrite();
+    diskRing.m_mutex.unlock();
+    diskRing.m_conditionVariable.notify_one();
+}
@@ -51,6 +51,9 @@ void BundleStorageManagerMT::StopAllDiskThreads() {
 }
 
 BundleStorageManagerMT::~BundleStorageManagerMT() {
+    if (m_running && m_noFatalErrorsOccurred) {
+        WriteBackAllHotTierBundles(); //queue the bundles only held in memory while the disk threads are still running
+    }
     StopAllDiskThreads();
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
         if (m_threadPtrsVec[diskId]) {
@@ -84,6 +87,10 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
     FILE * fileHandle = (m_successfullyRestoredFromDisk) ? fopen(filePath, "r+bR") : fopen(filePath, "w+bR");
     boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
     segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+#ifndef _WIN32
+    const int fileDescriptor = (fileHandle) ? fileno(fileHandle) : -1; //all I/O is positional on the descriptor (stdio buffering unused)
+    struct iovec iovecs[CIRCULAR_INDEX_BUFFER_SIZE];
+#endif
 
     while (m_noFatalErrorsOccurred) { //keep thread alive if running or cb not empty, i.e. "while (m_running || (m_circularIndexBuffer.GetIndexForRead() != CIRCULAR_INDEX_BUFFER_EMPTY))"
         unsigned int consumeIndex = cb.GetIndexForRead(); //store the volatile
@@ -101,13 +108,8 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
             }
         }
 
-        boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
         const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
-        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
-        const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
-        volatile bool junk;
-        volatile bool * const isReadCompletedPointer = (isWriteToDisk) ?
-            &junk : m_circularBufferIsReadCompletedPointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+        const bool isWriteToDisk = (m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex] == NULL);
         if (segmentId == SEGMENT_ID_LAST) {
             LOG_ERROR(subprocess) << "error segmentId is last";
             m_noFatalErrorsOccurred = false; //a fatal error occurred
@@ -116,10 +118,12 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
         }
 
         const boost::uint64_t offsetBytes = static_cast<boost::uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+#ifdef _WIN32
+        const unsigned int runLength = 1;
+        boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
+        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
 #ifdef _MSC_VER 
         _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
-#elif defined __APPLE__ 
-        fseeko(fileHandle, offsetBytes, SEEK_SET);
 #else
         fseeko64(fileHandle, offsetBytes, SEEK_SET);
 #endif
@@ -134,12 +138,30 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
                 LOG_ERROR(subprocess) << "error reading";
             }
         }
+#else
+        //coalesce the queued segments that are adjacent on this disk into one pwritev/preadv
+        const unsigned int runLength = GetContiguousSegmentRunLength_NotThreadSafe(threadIndex, consumeIndex, cb.NumInBuffer());
+        for (unsigned int i = 0; i < runLength; ++i) {
+            const unsigned int index = (consumeIndex + i) % CIRCULAR_INDEX_BUFFER_SIZE;
+            iovecs[i].iov_base = (isWriteToDisk) ?
+                (void*)&circularBufferBlockDataPtr[index * SEGMENT_SIZE] :
+                (void*)m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + index];
+            iovecs[i].iov_len = SEGMENT_SIZE;
+        }
+        if (DoPositionalVectoredSegmentIo(fileDescriptor, iovecs, runLength, offsetBytes, !isWriteToDisk) != (runLength * SEGMENT_SIZE)) {
+            LOG_ERROR(subprocess) << ((isWriteToDisk) ? "error writing" : "error reading");
+        }
+#endif
 
         m_mutexMainThread.lock();
-        *isReadCompletedPointer = true;
-        cb.CommitRead();
+        for (unsigned int i = 0; i < runLength; ++i) {
+            if (!isWriteToDisk) {
+                *(m_circularBufferIsReadCompletedPointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + cb.GetIndexForRead()]) = true;
+            }
+            cb.CommitRead();
+        }
         m_mutexMainThread.unlock();
-        m_conditionVariableMainThread.notify_one();
+        m_conditionVariableMainThread.notify_all(); //the storage writer and release threads may both be waiting
     }
 
     if (fileHandle) {
@@ -19,60 +19,70 @@ catalog_entry_t::catalog_entry_t() :
     bundleSizeBytes(0),
     encodedAbsExpirationAndCustodyAndPriority(0),
     sequence(0),
-    ptrUuidKeyInMap(NULL) { } //a default constructor: X()
+    ptrUuidKeyInMap(NULL),
+    slabSlotOffset(0) { } //a default constructor: X()
 catalog_entry_t::~catalog_entry_t() { } //a destructor: ~X()
 catalog_entry_t::catalog_entry_t(const catalog_entry_t& o) :
     bundleSizeBytes(o.bundleSizeBytes),
-    segmentIdChainVec(o.segmentIdChainVec),
+    segmentIdExtentVec(o.segmentIdExtentVec),
     destEid(o.destEid),
     encodedAbsExpirationAndCustodyAndPriority(o.encodedAbsExpirationAndCustodyAndPriority),
     sequence(o.sequence),
-    ptrUuidKeyInMap(o.ptrUuidKeyInMap) { } //a copy constructor: X(const X&)
+    ptrUuidKeyInMap(o.ptrUuidKeyInMap),
+    slabSlotOffset(o.slabSlotOffset) { } //a copy constructor: X(const X&)
 catalog_entry_t::catalog_entry_t(catalog_entry_t&& o) :
     bundleSizeBytes(o.bundleSizeBytes),
-    segmentIdChainVec(std::move(o.segmentIdChainVec)),
+    segmentIdExtentVec(std::move(o.segmentIdExtentVec)),
     destEid(o.destEid),
     encodedAbsExpirationAndCustodyAndPriority(o.encodedAbsExpirationAndCustodyAndPriority),
     sequence(o.sequence),
-    ptrUuidKeyInMap(o.ptrUuidKeyInMap) { } //a move constructor: X(X&&)
+    ptrUuidKeyInMap(o.ptrUuidKeyInMap),
+    slabSlotOffset(o.slabSlotOffset) { } //a move constructor: X(X&&)
 catalog_entry_t& catalog_entry_t::operator=(const catalog_entry_t& o) { //a copy assignment: operator=(const X&)
     bundleSizeBytes = o.bundleSizeBytes;
-    segmentIdChainVec = o.segmentIdChainVec;
+    segmentIdExtentVec = o.segmentIdExtentVec;
     destEid = o.destEid;
     encodedAbsExpirationAndCustodyAndPriority = o.encodedAbsExpirationAndCustodyAndPriority;
     sequence = o.sequence;
     ptrUuidKeyInMap = o.ptrUuidKeyInMap;
+    slabSlotOffset = o.slabSlotOffset;
     return *this;
 }
 catalog_entry_t& catalog_entry_t::operator=(catalog_entry_t && o) { //a move assignment: operator=(X&&)
     bundleSizeBytes = o.bundleSizeBytes;
-    segmentIdChainVec = std::move(o.segmentIdChainVec);
+    segmentIdExtentVec = std::move(o.segmentIdExtentVec);
     destEid = o.destEid;
     encodedAbsExpirationAndCustodyAndPriority = o.encodedAbsExpirationAndCustodyAndPriority;
     sequence = o.sequence;
     ptrUuidKeyInMap = o.ptrUuidKeyInMap;
+    slabSlotOffset = o.slabSlotOffset;
     return *this;
 }
 bool catalog_entry_t::operator==(const catalog_entry_t & o) const {
     return
         (bundleSizeBytes == o.bundleSizeBytes) &&
-        (segmentIdChainVec == o.segmentIdChainVec) &&
+        (segmentIdExtentVec == o.segmentIdExtentVec) &&
         (destEid == o.destEid) &&
         (encodedAbsExpirationAndCustodyAndPriority == o.encodedAbsExpirationAndCustodyAndPriority) &&
         (sequence == o.sequence) &&
-        (ptrUuidKeyInMap == o.ptrUuidKeyInMap);
+        (ptrUuidKeyInMap == o.ptrUuidKeyInMap) &&
+        (slabSlotOffset == o.slabSlotOffset);
 }
 bool catalog_entry_t::operator!=(const catalog_entry_t & o) const {
     return
         (bundleSizeBytes != o.bundleSizeBytes) ||
-        (segmentIdChainVec != o.segmentIdChainVec) ||
+        (segmentIdExtentVec != o.segmentIdExtentVec) ||
         (destEid != o.destEid) ||
         (encodedAbsExpirationAndCustodyAndPriority != o.encodedAbsExpirationAndCustodyAndPriority) ||
         (sequence != o.sequence) ||
-        (ptrUuidKeyInMap != o.ptrUuidKeyInMap);
+        (ptrUuidKeyInMap != o.ptrUuidKeyInMap) ||
+        (slabSlotOffset != o.slabSlotOffset);
 }
 bool catalog_entry_t::operator<(const catalog_entry_t & o) const {
-    return (segmentIdChainVec[0] < o.segmentIdChainVec[0]);
+    if (segmentIdExtentVec[0].startSegmentId == o.segmentIdExtentVec[0].startSegmentId) { //bundles sharing a slab segment
+        return (slabSlotOffset < o.slabSlotOffset);
+    }
+    return (segmentIdExtentVec[0].startSegmentId < o.segmentIdExtentVec[0].startSegmentId);
 }
 uint8_t catalog_entry_t::GetPriorityIndex() const {
     return static_cast<uint8_t>(encodedAbsExpirationAndCustodyAndPriority & 3);
@@ -89,7 +99,13 @@ bool catalog_entry_t::HasCustodyAndNonFragmentation() const {
 bool catalog_entry_t::HasCustody() const {
     return ((encodedAbsExpirationAndCustodyAndPriority & ((1U << 2) | (1U << 3)) ) != 0);
 }
-void catalog_entry_t::Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, const uint64_t paramNumSegmentsRequired, void * paramPtrUuidKeyInMap) {
+uint64_t catalog_entry_t::GetNumSegments() const {
+    return MemoryManagerTreeArray::GetNumSegmentsInExtents(segmentIdExtentVec);
+}
+bool catalog_entry_t::IsInSlab() const {
+    return (slabSlotOffset != 0);
+}
+void catalog_entry_t::Init(const PrimaryBlock & primary, const uint64_t paramBundleSizeBytes, void * paramPtrUuidKeyInMap) {
     bundleSizeBytes = paramBundleSizeBytes;
     destEid = primary.GetFinalDestinationEid();
     encodedAbsExpirationAndCustodyAndPriority = primary.GetPriority() | (primary.GetExpirationSeconds() << 4);
@@ -103,6 +119,7 @@ void catalog_entry_t::Init(const PrimaryBlock & primary, const uint64_t paramBun
     }
     ptrUuidKeyInMap = paramPtrUuidKeyInMap;
     sequence = primary.GetSequenceForSecondsScale();
-    segmentIdChainVec.resize(paramNumSegmentsRequired);
+    segmentIdExtentVec.clear(); //filled by the MemoryManagerTreeArray or restore from disk
+    slabSlotOffset = 0; //set if the bundle is packed into a slab segment
 }
 
@@ -0,0 +1,515 @@
+/**
+ * @file CatalogJournal.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "CatalogJournal.h"
+#include "BundleStorageConfig.h"
+#include "Logger.h"
+#include "codec/Bpv7Crc.h"
+#include <cstdio>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/make_unique.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
+
+//all fields are stored little endian
+#define CATALOG_JOURNAL_MAGIC 0x314c4e524a544143ULL //"CATJRNL1"
+#define CATALOG_JOURNAL_VERSION 2 //version 2 added the slab slot offset to insert records
+#define CATALOG_JOURNAL_HEADER_SIZE 64 //magic, version, num disks, capacity, segment size, segment id size, zero padding, header crc32c (last 4 bytes)
+#define RECORD_HEADER_SIZE 16 //crc32c (of the rest of the record), record length, record type, reserved
+#define INSERT_RECORD_FIXED_SIZE (RECORD_HEADER_SIZE + (14 * sizeof(uint64_t))) //followed by 2 uint64_t per extent
+#define REMOVE_RECORD_SIZE (RECORD_HEADER_SIZE + sizeof(uint64_t))
+#define CHECKPOINT_END_RECORD_SIZE (RECORD_HEADER_SIZE + sizeof(uint64_t))
+#define INITIAL_FILE_SIZE (1024 * 1024)
+#define NUM_RECORDS_PER_ASYNC_FLUSH 1024
+
+enum class JOURNAL_RECORD_TYPE : uint32_t {
+    INSERT = 1,
+    REMOVE,
+    CHECKPOINT_END
+};
+
+struct CatalogJournal::MappedFile {
+    boost::interprocess::file_mapping fileMapping;
+    boost::interprocess::mapped_region mappedRegion;
+    uint8_t * data;
+    uint64_t sizeBytes;
+
+    MappedFile(const std::string & filePath, const boost::interprocess::mode_t mode) :
+        fileMapping(filePath.c_str(), mode),
+        mappedRegion(fileMapping, mode),
+        data(static_cast<uint8_t*>(mappedRegion.get_address())),
+        sizeBytes(mappedRegion.get_size()) {}
+};
+
+static BOOST_FORCEINLINE void WriteU32(uint8_t * p, uint32_t v) {
+    boost::endian::native_to_little_inplace(v);
+    memcpy(p, &v, sizeof(v));
+}
+static BOOST_FORCEINLINE void WriteU64(uint8_t * p, uint64_t v) {
+    boost::endian::native_to_little_inplace(v);
+    memcpy(p, &v, sizeof(v));
+}
+static BOOST_FORCEINLINE uint32_t ReadU32(const uint8_t * p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return boost::endian::little_to_native(v);
+}
+static BOOST_FORCEINLINE uint64_t ReadU64(const uint8_t * p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return boost::endian::little_to_native(v);
+}
+
+static void WriteRecordHeader(uint8_t * record, const uint32_t recordLength, const JOURNAL_RECORD_TYPE type) {
+    WriteU32(record + 4, recordLength);
+    WriteU32(record + 8, static_cast<uint32_t>(type));
+    WriteU32(record + 12, 0);
+    WriteU32(record, Bpv7Crc::Crc32C_Unaligned(record + 4, recordLength - 4));
+}
+
+//return record length if the record at offset is complete with a valid crc, 0 otherwise
+static uint64_t GetValidRecordLength(const uint8_t * data, const uint64_t offset, const uint64_t endOffset) {
+    if ((offset + RECORD_HEADER_SIZE) > endOffset) {
+        return 0;
+    }
+    const uint8_t * const record = data + offset;
+    const uint64_t recordLength = ReadU32(record + 4);
+    if ((recordLength < (RECORD_HEADER_SIZE + sizeof(uint64_t))) || ((offset + recordLength) > endOffset)) {
+        return 0;
+    }
+    if (Bpv7Crc::Crc32C_Unaligned(record + 4, static_cast<std::size_t>(recordLength - 4)) != ReadU32(record)) {
+        return 0;
+    }
+    return recordLength;
+}
+
+static bool CreateFileOfSize(const std::string & filePath, const uint64_t sizeBytes) {
+    FILE * fileHandle = fopen(filePath.c_str(), "wb");
+    if (fileHandle == NULL) {
+        LOG_ERROR(subprocess) << "cannot create catalog journal file " << filePath;
+        return false;
+    }
+    fclose(fileHandle);
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(filePath, sizeBytes, ec); //zero filled
+    if (ec) {
+        LOG_ERROR(subprocess) << "cannot resize catalog journal file " << filePath << ": " << ec.message();
+        return false;
+    }
+    return true;
+}
+
+CatalogJournal::CatalogJournal(const std::string & filePath, const unsigned int numStorageDisks, const uint64_t totalStorageCapacityBytes) :
+    M_FILE_PATH(filePath),
+    M_CHECKPOINT_FILE_PATH(filePath + ".checkpoint"),
+    M_NUM_STORAGE_DISKS(numStorageDisks),
+    M_TOTAL_STORAGE_CAPACITY_BYTES(totalStorageCapacityBytes),
+    m_checkpointInProgress(false),
+    m_appendOffset(0),
+    m_liveRecordBytes(0),
+    m_numRecordsSinceFlush(0),
+    m_numCompactions(0) {}
+
+CatalogJournal::~CatalogJournal() {
+    if (m_mappedFilePtr && (!m_checkpointInProgress)) {
+        Flush();
+    }
+}
+
+void CatalogJournal::WriteHeader(uint8_t * data) const {
+    memset(data, 0, CATALOG_JOURNAL_HEADER_SIZE);
+    WriteU64(data, CATALOG_JOURNAL_MAGIC);
+    WriteU32(data + 8, CATALOG_JOURNAL_VERSION);
+    WriteU32(data + 12, M_NUM_STORAGE_DISKS);
+    WriteU64(data + 16, M_TOTAL_STORAGE_CAPACITY_BYTES);
+    WriteU64(data + 24, SEGMENT_SIZE);
+    WriteU32(data + 32, sizeof(segment_id_t));
+    WriteU32(data + (CATALOG_JOURNAL_HEADER_SIZE - 4), Bpv7Crc::Crc32C_Unaligned(data, CATALOG_JOURNAL_HEADER_SIZE - 4));
+}
+
+bool CatalogJournal::IsHeaderValid(const uint8_t * data, const uint64_t sizeBytes) const {
+    if (sizeBytes < CATALOG_JOURNAL_HEADER_SIZE) {
+        LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " is too small";
+        return false;
+    }
+    if (Bpv7Crc::Crc32C_Unaligned(data, CATALOG_JOURNAL_HEADER_SIZE - 4) != ReadU32(data + (CATALOG_JOURNAL_HEADER_SIZE - 4))) {
+        LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " has an invalid header crc";
+        return false;
+    }
+    if ((ReadU64(data) != CATALOG_JOURNAL_MAGIC) || (ReadU32(data + 8) != CATALOG_JOURNAL_VERSION)) {
+        LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " has an unknown format";
+        return false;
+    }
+    if ((ReadU32(data + 12) != M_NUM_STORAGE_DISKS) || (ReadU64(data + 16) != M_TOTAL_STORAGE_CAPACITY_BYTES)
+        || (ReadU64(data + 24) != SEGMENT_SIZE) || (ReadU32(data + 32) != sizeof(segment_id_t)))
+    {
+        LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " was written for a different storage configuration";
+        return false;
+    }
+    return true;
+}
+
+bool CatalogJournal::ReadLiveEntries(std::vector<catalog_journal_entry_t> & liveEntries) const {
+    liveEntries.clear();
+    if (!boost::filesystem::exists(M_FILE_PATH)) {
+        LOG_INFO(subprocess) << "catalog journal " << M_FILE_PATH << " does not exist";
+        return false;
+    }
+    std::unique_ptr<MappedFile> mappedFilePtr;
+    try {
+        mappedFilePtr = boost::make_unique<MappedFile>(M_FILE_PATH, boost::interprocess::read_only);
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "cannot map catalog journal " << M_FILE_PATH << ": " << e.what();
+        return false;
+    }
+    const uint8_t * const data = mappedFilePtr->data;
+    const uint64_t sizeBytes = mappedFilePtr->sizeBytes;
+    if (!IsHeaderValid(data, sizeBytes)) {
+        return false;
+    }
+
+    std::vector<bool> isLiveVec;
+    OpenAddressingHashMap<uint64_t, uint64_t> custodyIdToLiveEntryIndexMap;
+    bool checkpointEnded = false;
+    uint64_t offset = CATALOG_JOURNAL_HEADER_SIZE;
+    while (true) {
+        const uint64_t recordLength = GetValidRecordLength(data, offset, sizeBytes);
+        if (recordLength == 0) {
+            break; //end of journal (possibly torn by a crash mid append)
+        }
+        const uint8_t * const record = data + offset;
+        const JOURNAL_RECORD_TYPE type = static_cast<JOURNAL_RECORD_TYPE>(ReadU32(record + 8));
+        const uint8_t * const payload = record + RECORD_HEADER_SIZE;
+        const uint64_t custodyId = ReadU64(payload);
+        if (type == JOURNAL_RECORD_TYPE::INSERT) {
+            if (recordLength < INSERT_RECORD_FIXED_SIZE) {
+                break;
+            }
+            const uint64_t numExtents = ReadU64(payload + (12 * sizeof(uint64_t)));
+            if (recordLength != (INSERT_RECORD_FIXED_SIZE + (numExtents * 2 * sizeof(uint64_t)))) {
+                break;
+            }
+            if (!custodyIdToLiveEntryIndexMap.Insert(custodyId, liveEntries.size())) {
+                LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " inserts custody id " << custodyId << " twice";
+                return false;
+            }
+            liveEntries.emplace_back();
+            isLiveVec.push_back(true);
+            catalog_journal_entry_t & entry = liveEntries.back();
+            entry.custodyId = custodyId;
+            catalog_entry_t & catalogEntry = entry.catalogEntry;
+            catalogEntry.bundleSizeBytes = ReadU64(payload + (1 * sizeof(uint64_t)));
+            catalogEntry.destEid.nodeId = ReadU64(payload + (2 * sizeof(uint64_t)));
+            catalogEntry.destEid.serviceId = ReadU64(payload + (3 * sizeof(uint64_t)));
+            catalogEntry.encodedAbsExpirationAndCustodyAndPriority = ReadU64(payload + (4 * sizeof(uint64_t)));
+            catalogEntry.sequence = ReadU64(payload + (5 * sizeof(uint64_t)));
+            catalogEntry.ptrUuidKeyInMap = NULL;
+            catalogEntry.slabSlotOffset = static_cast<uint32_t>(ReadU64(payload + (13 * sizeof(uint64_t))));
+            entry.bundleUuid.creationSeconds = ReadU64(payload + (6 * sizeof(uint64_t)));
+            entry.bundleUuid.sequence = ReadU64(payload + (7 * sizeof(uint64_t)));
+            entry.bundleUuid.srcEid.nodeId = ReadU64(payload + (8 * sizeof(uint64_t)));
+            entry.bundleUuid.srcEid.serviceId = ReadU64(payload + (9 * sizeof(uint64_t)));
+            entry.bundleUuid.fragmentOffset = ReadU64(payload + (10 * sizeof(uint64_t)));
+            entry.bundleUuid.dataLength = ReadU64(payload + (11 * sizeof(uint64_t)));
+            catalogEntry.segmentIdExtentVec.resize(numExtents);
+            const uint8_t * extentPtr = record + INSERT_RECORD_FIXED_SIZE;
+            for (uint64_t i = 0; i < numExtents; ++i, extentPtr += (2 * sizeof(uint64_t))) {
+                catalogEntry.segmentIdExtentVec[i].startSegmentId = static_cast<segment_id_t>(ReadU64(extentPtr));
+                catalogEntry.segmentIdExtentVec[i].numSegments = static_cast<segment_id_t>(ReadU64(extentPtr + sizeof(uint64_t)));
+            }
+        }
+        else if ((type == JOURNAL_RECORD_TYPE::REMOVE) && checkpointEnded && (recordLength == REMOVE_RECORD_SIZE)) {
+            uint64_t index;
+            if (!custodyIdToLiveEntryIndexMap.GetValueAndRemove(custodyId, index)) {
+                LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " removes unknown custody id " << custodyId;
+                return false;
+            }
+            isLiveVec[index] = false;
+        }
+        else if ((type == JOURNAL_RECORD_TYPE::CHECKPOINT_END) && (!checkpointEnded) && (recordLength == CHECKPOINT_END_RECORD_SIZE)) {
+            if (ReadU64(payload) != liveEntries.size()) {
+                LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " checkpoint is missing entries";
+                return false;
+            }
+            checkpointEnded = true;
+        }
+        else {
+            break;
+        }
+        offset += recordLength;
+    }
+    if (!checkpointEnded) {
+        LOG_ERROR(subprocess) << "catalog journal " << M_FILE_PATH << " has an incomplete checkpoint";
+        liveEntries.clear();
+        return false;
+    }
+
+    //remove the dead entries while keeping insertion order
+    std::size_t numLive = 0;
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        if (isLiveVec[i]) {
+            if (numLive != i) {
+                liveEntries[numLive] = std::move(liveEntries[i]);
+            }
+            ++numLive;
+        }
+    }
+    liveEntries.resize(numLive);
+    LOG_INFO(subprocess) << "catalog journal " << M_FILE_PATH << " replayed " << (offset - CATALOG_JOURNAL_HEADER_SIZE)
+        << " bytes of records holding " << numLive << " live bundles";
+    return true;
+}
+
+bool CatalogJournal::BeginCheckpoint() {
+    m_mappedFilePtr.reset();
+    m_liveCustodyIdToRecordOffsetMap.Clear();
+    m_liveRecordBytes = 0;
+    m_numRecordsSinceFlush = 0;
+    m_checkpointInProgress = false;
+    if (!CreateFileOfSize(M_CHECKPOINT_FILE_PATH, INITIAL_FILE_SIZE)) {
+        return false;
+    }
+    try {
+        m_mappedFilePtr = boost::make_unique<MappedFile>(M_CHECKPOINT_FILE_PATH, boost::interprocess::read_write);
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "cannot map catalog journal checkpoint " << M_CHECKPOINT_FILE_PATH << ": " << e.what();
+        return false;
+    }
+    WriteHeader(m_mappedFilePtr->data);
+    m_appendOffset = CATALOG_JOURNAL_HEADER_SIZE;
+    m_checkpointInProgress = true;
+    return true;
+}
+
+bool CatalogJournal::CommitCheckpoint() {
+    if (!m_checkpointInProgress) {
+        return false;
+    }
+    uint8_t record[CHECKPOINT_END_RECORD_SIZE];
+    WriteU64(record + RECORD_HEADER_SIZE, m_liveCustodyIdToRecordOffsetMap.GetSize());
+    WriteRecordHeader(record, CHECKPOINT_END_RECORD_SIZE, JOURNAL_RECORD_TYPE::CHECKPOINT_END);
+    if (!AppendRecord(record, CHECKPOINT_END_RECORD_SIZE, 0)) {
+        return false;
+    }
+    //the checkpoint must be on the disk before it replaces the journal
+    if (!Flush()) {
+        return false;
+    }
+    m_mappedFilePtr.reset(); //unmap before the rename (required on Windows)
+    m_checkpointInProgress = false;
+    boost::system::error_code ec;
+    boost::filesystem::rename(M_CHECKPOINT_FILE_PATH, M_FILE_PATH, ec);
+    if (ec) {
+        LOG_ERROR(subprocess) << "cannot replace catalog journal " << M_FILE_PATH << ": " << ec.message();
+        return false;
+    }
+    try {
+        m_mappedFilePtr = boost::make_unique<MappedFile>(M_FILE_PATH, boost::interprocess::read_write);
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "cannot map catalog journal " << M_FILE_PATH << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+bool CatalogJournal::AppendInsert(const uint64_t custodyId, const catalog_entry_t & catalogEntry, const cbhe_bundle_uuid_t & bundleUuid) {
+    const segment_id_extent_vec_t & segmentIdExtentVec = catalogEntry.segmentIdExtentVec;
+    const uint64_t recordLength = INSERT_RECORD_FIXED_SIZE + (segmentIdExtentVec.size() * 2 * sizeof(uint64_t));
+    m_recordBuffer.resize(recordLength);
+    uint8_t * const record = m_recordBuffer.data();
+    uint8_t * const payload = record + RECORD_HEADER_SIZE;
+    WriteU64(payload, custodyId);
+    WriteU64(payload + (1 * sizeof(uint64_t)), catalogEntry.bundleSizeBytes);
+    WriteU64(payload + (2 * sizeof(uint64_t)), catalogEntry.destEid.nodeId);
+    WriteU64(payload + (3 * sizeof(uint64_t)), catalogEntry.destEid.serviceId);
+    WriteU64(payload + (4 * sizeof(uint64_t)), catalogEntry.encodedAbsExpirationAndCustodyAndPriority);
+    WriteU64(payload + (5 * sizeof(uint64_t)), catalogEntry.sequence);
+    WriteU64(payload + (6 * sizeof(uint64_t)), bundleUuid.creationSeconds);
+    WriteU64(payload + (7 * sizeof(uint64_t)), bundleUuid.sequence);
+    WriteU64(payload + (8 * sizeof(uint64_t)), bundleUuid.srcEid.nodeId);
+    WriteU64(payload + (9 * sizeof(uint64_t)), bundleUuid.srcEid.serviceId);
+    WriteU64(payload + (10 * sizeof(uint64_t)), bundleUuid.fragmentOffset);
+    WriteU64(payload + (11 * sizeof(uint64_t)), bundleUuid.dataLength);
+    WriteU64(payload + (12 * sizeof(uint64_t)), segmentIdExtentVec.size());
+    WriteU64(payload + (13 * sizeof(uint64_t)), catalogEntry.slabSlotOffset);
+    uint8_t * extentPtr = record + INSERT_RECORD_FIXED_SIZE;
+    for (std::size_t i = 0; i < segmentIdExtentVec.size(); ++i, extentPtr += (2 * sizeof(uint64_t))) {
+        WriteU64(extentPtr, segmentIdExtentVec[i].startSegmentId);
+        WriteU64(extentPtr + sizeof(uint64_t), segmentIdExtentVec[i].numSegments);
+    }
+    WriteRecordHeader(record, static_cast<uint32_t>(recordLength), JOURNAL_RECORD_TYPE::INSERT);
+    return AppendRecord(record, recordLength, custodyId);
+}
+
+bool CatalogJournal::AppendRemove(const uint64_t custodyId) {
+    uint64_t insertRecordOffset;
+    if (!m_liveCustodyIdToRecordOffsetMap.GetValueAndRemove(custodyId, insertRecordOffset)) {
+        LOG_ERROR(subprocess) << "catalog journal cannot remove unknown custody id " << custodyId;
+        return false;
+    }
+    m_liveRecordBytes -= ReadU32(m_mappedFilePtr->data + insertRecordOffset + 4);
+    uint8_t record[REMOVE_RECORD_SIZE];
+    WriteU64(record + RECORD_HEADER_SIZE, custodyId);
+    WriteRecordHeader(record, REMOVE_RECORD_SIZE, JOURNAL_RECORD_TYPE::REMOVE);
+    return AppendRecord(record, REMOVE_RECORD_SIZE, 0);
+}
+
+//insertCustodyId is only used for insert records
+bool CatalogJournal::AppendRecord(const uint8_t * record, const uint64_t recordLength, const uint64_t insertCustodyId) {
+    if (!m_mappedFilePtr) {
+        return false;
+    }
+    if ((m_appendOffset + recordLength) > m_mappedFilePtr->sizeBytes) {
+        if (!MakeRoom(recordLength)) {
+            return false;
+        }
+    }
+    if (static_cast<JOURNAL_RECORD_TYPE>(ReadU32(record + 8)) == JOURNAL_RECORD_TYPE::INSERT) {
+        if (!m_liveCustodyIdToRecordOffsetMap.Insert(insertCustodyId, m_appendOffset)) {
+            LOG_ERROR(subprocess) << "catalog journal cannot insert duplicate custody id " << insertCustodyId;
+            return false;
+        }
+        m_liveRecordBytes += recordLength;
+    }
+    memcpy(m_mappedFilePtr->data + m_appendOffset, record, recordLength);
+    m_appendOffset += recordLength;
+    if (++m_numRecordsSinceFlush >= NUM_RECORDS_PER_ASYNC_FLUSH) {
+        m_numRecordsSinceFlush = 0;
+        m_mappedFilePtr->mappedRegion.flush(0, static_cast<std::size_t>(m_appendOffset), true); //async
+    }
+    return true;
+}
+
+//compact if at least half of the journal is removed bundles, otherwise grow
+bool CatalogJournal::MakeRoom(const uint64_t recordLength) {
+    if ((!m_checkpointInProgress) && (m_liveRecordBytes <= ((m_appendOffset - CATALOG_JOURNAL_HEADER_SIZE) / 2))) {
+        if (!Compact()) {
+            return false;
+        }
+        if ((m_appendOffset + recordLength) <= m_mappedFilePtr->sizeBytes) {
+            return true;
+        }
+    }
+    uint64_t newSizeBytes = m_mappedFilePtr->sizeBytes * 2;
+    while ((m_appendOffset + recordLength) > newSizeBytes) {
+        newSizeBytes *= 2;
+    }
+    return Grow(newSizeBytes);
+}
+
+bool CatalogJournal::Grow(const uint64_t minSizeBytes) {
+    const std::string & filePath = (m_checkpointInProgress) ? M_CHECKPOINT_FILE_PATH : M_FILE_PATH;
+    m_mappedFilePtr.reset();
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(filePath, minSizeBytes, ec); //zero filled
+    if (ec) {
+        LOG_ERROR(subprocess) << "cannot grow catalog journal " << filePath << ": " << ec.message();
+        return false;
+    }
+    try {
+        m_mappedFilePtr = boost::make_unique<MappedFile>(filePath, boost::interprocess::read_write);
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        LOG_ERROR(subprocess) << "cannot map catalog journal " << filePath << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+//write a checkpoint of only the live insert records (in their original order)
+bool CatalogJournal::Compact() {
+    std::unique_ptr<MappedFile> oldMappedFilePtr(std::move(m_mappedFilePtr));
+    const uint64_t oldAppendOffset = m_appendOffset;
+    const uint64_t oldLiveRecordBytes = m_liveRecordBytes;
+    std::vector<uint64_t> liveRecordOffsets;
+    liveRecordOffsets.reserve(m_liveCustodyIdToRecordOffsetMap.GetSize());
+    for (uint64_t offset = CATALOG_JOURNAL_HEADER_SIZE; offset < oldAppendOffset; ) {
+        const uint8_t * const record = oldMappedFilePtr->data + offset;
+        if (static_cast<JOURNAL_RECORD_TYPE>(ReadU32(record + 8)) == JOURNAL_RECORD_TYPE::INSERT) {
+            const uint64_t * const liveOffsetPtr = m_liveCustodyIdToRecordOffsetMap.GetValuePtr(ReadU64(record + RECORD_HEADER_SIZE));
+            if (liveOffsetPtr && (*liveOffsetPtr == offset)) {
+                liveRecordOffsets.push_back(offset);
+            }
+        }
+        offset += ReadU32(record + 4);
+    }
+    if (!BeginCheckpoint()) {
+        return false;
+    }
+    //size the new journal so that it is at most half full after the compaction
+    uint64_t newSizeBytes = INITIAL_FILE_SIZE;
+    while (newSizeBytes < (2 * (CATALOG_JOURNAL_HEADER_SIZE + oldLiveRecordBytes + CHECKPOINT_END_RECORD_SIZE))) {
+        newSizeBytes *= 2;
+    }
+    if ((newSizeBytes > m_mappedFilePtr->sizeBytes) && (!Grow(newSizeBytes))) {
+        return false;
+    }
+    for (std::size_t i = 0; i < liveRecordOffsets.size(); ++i) {
+        const uint8_t * const record = oldMappedFilePtr->data + liveRecordOffsets[i];
+        if (!AppendRecord(record, ReadU32(record + 4), ReadU64(record + RECORD_HEADER_SIZE))) {
+            return false;
+        }
+    }
+    oldMappedFilePtr.reset();
+    if (!CommitCheckpoint()) {
+        return false;
+    }
+    ++m_numCompactions;
+    return true;
+}
+
+bool CatalogJournal::Flush() {
+    if (!m_mappedFilePtr) {
+        return false;
+    }
+    m_numRecordsSinceFlush = 0;
+    return m_mappedFilePtr->mappedRegion.flush(0, static_cast<std::size_t>(m_appendOffset), false);
+}
+
+void CatalogJournal::Delete() {
+    m_mappedFilePtr.reset(); //unmap before the removal (required on Windows), after which every append fails
+    m_checkpointInProgress = false;
+    m_liveCustodyIdToRecordOffsetMap.Clear();
+    m_liveRecordBytes = 0;
+    m_appendOffset = 0;
+    boost::system::error_code ec;
+    boost::filesystem::remove(M_CHECKPOINT_FILE_PATH, ec);
+    boost::filesystem::remove(M_FILE_PATH, ec);
+    if (ec) {
+        LOG_ERROR(subprocess) << "cannot delete catalog journal " << M_FILE_PATH << ": " << ec.message();
+    }
+}
+
+std::size_t CatalogJournal::GetNumLiveEntries() const {
+    return m_liveCustodyIdToRecordOffsetMap.GetSize();
+}
+uint64_t CatalogJournal::GetNumCompactions() const {
+    return m_numCompactions;
+}
+uint64_t CatalogJournal::GetSizeBytes() const {
+    return (m_mappedFilePtr) ? m_mappedFilePtr->sizeBytes : 0;
+}
+uint64_t CatalogJournal::GetUsedBytes() const {
+    return m_appendOffset;
+}
+const std::string & CatalogJournal::GetFilePath() const {
+    return M_FILE_PATH;
+}
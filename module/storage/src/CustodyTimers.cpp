@@ -16,92 +16,264 @@
 #include <string>
 #include <boost/make_unique.hpp>
 
+static inline uint64_t RotateRight64(const uint64_t x, const unsigned int n) {
+    return (n == 0) ? x : ((x >> n) | (x << (64 - n)));
+}
+
+static inline unsigned int CountTrailingZeros64(const uint64_t x) { //x must be nonzero
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(x));
+#else
+    unsigned int count = 0;
+    for (uint64_t v = x; (v & 1) == 0; v >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
 
-CustodyTimers::CustodyTimers(const boost::posix_time::time_duration & timeout) : M_CUSTODY_TIMEOUT_DURATION(timeout) {}
+CustodyTimers::CustodyTimers(const boost::posix_time::time_duration & timeout) :
+    m_freeTimersHead(NIL_INDEX),
+    m_wheelCurrentTick(0),
+    m_numTimersInWheel(0),
+    M_EPOCH(boost::posix_time::microsec_clock::universal_time()),
+    M_CUSTODY_TIMEOUT_DURATION(timeout)
+{
+    for (unsigned int level = 0; level < WHEEL_NUM_LEVELS; ++level) {
+        m_wheelOccupancyMasks[level] = 0;
+    }
+}
 
 
 
 CustodyTimers::~CustodyTimers() {}
 
+uint64_t CustodyTimers::PtimeToTick(const boost::posix_time::ptime & ptime, const bool roundUp) const {
+    if (ptime.is_special() || (ptime <= M_EPOCH)) {
+        return (ptime.is_pos_infinity()) ? UINT64_MAX : 0;
+    }
+    const uint64_t microseconds = static_cast<uint64_t>((ptime - M_EPOCH).total_microseconds());
+    return (roundUp) ? ((microseconds + 999) / 1000) : (microseconds / 1000);
+}
 
-bool CustodyTimers::PollOneAndPopExpiredCustodyTimer(uint64_t & custodyId, const std::vector<cbhe_eid_t> & availableDestEids, const boost::posix_time::ptime & nowPtime) {
-    boost::posix_time::ptime lowestExpiry = boost::posix_time::special_values::pos_infin;
-    desteid_to_custidexpirylist_map_t::iterator lowestExpiryIt;
-    for (std::size_t i = 0; i < availableDestEids.size(); ++i) {
-        const cbhe_eid_t & currentAvailableLink = availableDestEids[i];
-        desteid_to_custidexpirylist_map_t::iterator it = m_mapDestEidToCustodyIdExpiryList.find(currentAvailableLink);
-        if (it != m_mapDestEidToCustodyIdExpiryList.end()) {
-            custid_ptime_list_t & custIdPlusPtimeList = it->second;
-            if (!custIdPlusPtimeList.empty()) {
-                custid_ptime_pair_t & thisCustodyIdPlusPtimePair = custIdPlusPtimeList.front();
-                boost::posix_time::ptime & thisExpiry = thisCustodyIdPlusPtimePair.second;
-                if (lowestExpiry > thisExpiry) {
-                    lowestExpiry = thisExpiry;
-                    lowestExpiryIt = it;
+void CustodyTimers::PushBack(list_t & list, const uint32_t timerIndex, links_t timer_t::* links) {
+    links_t & l = m_timers[timerIndex].*links;
+    l.prev = list.tail;
+    l.next = NIL_INDEX;
+    if (list.tail == NIL_INDEX) {
+        list.head = timerIndex;
+    }
+    else {
+        (m_timers[list.tail].*links).next = timerIndex;
+    }
+    list.tail = timerIndex;
+}
+
+void CustodyTimers::Unlink(list_t & list, const uint32_t timerIndex, links_t timer_t::* links) {
+    const links_t & l = m_timers[timerIndex].*links;
+    if (l.prev == NIL_INDEX) {
+        list.head = l.next;
+    }
+    else {
+        (m_timers[l.prev].*links).next = l.next;
+    }
+    if (l.next == NIL_INDEX) {
+        list.tail = l.prev;
+    }
+    else {
+        (m_timers[l.next].*links).prev = l.prev;
+    }
+}
+
+//place the timer in the lowest level whose span covers the time remaining until its expiry
+void CustodyTimers::InsertIntoWheel(const uint32_t timerIndex) {
+    timer_t & timer = m_timers[timerIndex];
+    if (timer.expiryTick <= m_wheelCurrentTick) {
+        timer.wheelListIndex = EXPIRED_LIST_INDEX;
+        PushBack(m_wheelLists[EXPIRED_LIST_INDEX], timerIndex, &timer_t::wheelLinks);
+        return;
+    }
+    const uint64_t delta = timer.expiryTick - m_wheelCurrentTick;
+    unsigned int level = 0;
+    while ((level < (WHEEL_NUM_LEVELS - 1)) && ((delta >> (WHEEL_LEVEL_BITS * (level + 1))) != 0)) {
+        ++level;
+    }
+    uint64_t placementTick = timer.expiryTick;
+    if ((delta >> (WHEEL_LEVEL_BITS * WHEEL_NUM_LEVELS)) != 0) { //beyond the horizon, park in the farthest slot to be re-placed when cascaded
+        placementTick = m_wheelCurrentTick + ((static_cast<uint64_t>(1) << (WHEEL_LEVEL_BITS * WHEEL_NUM_LEVELS)) - 1);
+    }
+    const unsigned int slot = static_cast<unsigned int>((placementTick >> (WHEEL_LEVEL_BITS * level)) & (WHEEL_SLOTS_PER_LEVEL - 1));
+    timer.wheelListIndex = (level * WHEEL_SLOTS_PER_LEVEL) + slot;
+    PushBack(m_wheelLists[timer.wheelListIndex], timerIndex, &timer_t::wheelLinks);
+    m_wheelOccupancyMasks[level] |= (static_cast<uint64_t>(1) << slot);
+    ++m_numTimersInWheel;
+}
+
+void CustodyTimers::UnlinkFromWheel(const uint32_t timerIndex) {
+    const uint32_t listIndex = m_timers[timerIndex].wheelListIndex;
+    list_t & list = m_wheelLists[listIndex];
+    Unlink(list, timerIndex, &timer_t::wheelLinks);
+    if (listIndex != EXPIRED_LIST_INDEX) {
+        --m_numTimersInWheel;
+        if (list.head == NIL_INDEX) {
+            m_wheelOccupancyMasks[listIndex / WHEEL_SLOTS_PER_LEVEL] &= ~(static_cast<uint64_t>(1) << (listIndex % WHEEL_SLOTS_PER_LEVEL));
+        }
+    }
+}
+
+//jump from occupied slot to occupied slot (never visiting empty ticks), cascading higher levels down
+//and moving every timer expiring on or before nowTick onto the expired list
+void CustodyTimers::AdvanceWheelTo(const uint64_t nowTick) {
+    while (m_numTimersInWheel) {
+        uint64_t nextTick = UINT64_MAX;
+        for (unsigned int level = 0; level < WHEEL_NUM_LEVELS; ++level) {
+            const uint64_t mask = m_wheelOccupancyMasks[level];
+            if (mask) {
+                const unsigned int shift = WHEEL_LEVEL_BITS * level;
+                const uint64_t currentSlotNumber = m_wheelCurrentTick >> shift;
+                const unsigned int position = static_cast<unsigned int>(currentSlotNumber & (WHEEL_SLOTS_PER_LEVEL - 1));
+                //slots after the current position, wrapping around to (at most) the current slot itself
+                const uint64_t slotsAhead = CountTrailingZeros64(RotateRight64(mask, (position + 1) & (WHEEL_SLOTS_PER_LEVEL - 1))) + 1;
+                const uint64_t slotTick = (currentSlotNumber + slotsAhead) << shift;
+                if (slotTick < nextTick) {
+                    nextTick = slotTick;
                 }
             }
         }
-    }
-    if (lowestExpiry <= nowPtime) {
-        custid_ptime_list_t & custIdPlusPtimeList = lowestExpiryIt->second;
-        const custid_ptime_pair_t & thisCustodyIdPlusPtimePair = custIdPlusPtimeList.front();
-        custodyId = thisCustodyIdPlusPtimePair.first;
-        custIdPlusPtimeList.pop_front();
-        if (custIdPlusPtimeList.empty()) {
-            m_mapDestEidToCustodyIdExpiryList.erase(lowestExpiryIt);
+        if (nextTick > nowTick) {
+            break;
+        }
+        m_wheelCurrentTick = nextTick;
+        for (unsigned int level = WHEEL_NUM_LEVELS - 1; level >= 1; --level) {
+            const unsigned int shift = WHEEL_LEVEL_BITS * level;
+            if ((m_wheelCurrentTick & ((static_cast<uint64_t>(1) << shift) - 1)) == 0) {
+                const unsigned int slot = static_cast<unsigned int>((m_wheelCurrentTick >> shift) & (WHEEL_SLOTS_PER_LEVEL - 1));
+                const uint64_t slotBit = static_cast<uint64_t>(1) << slot;
+                if (m_wheelOccupancyMasks[level] & slotBit) {
+                    list_t cascadingList = m_wheelLists[(level * WHEEL_SLOTS_PER_LEVEL) + slot];
+                    m_wheelLists[(level * WHEEL_SLOTS_PER_LEVEL) + slot] = list_t();
+                    m_wheelOccupancyMasks[level] &= ~slotBit;
+                    for (uint32_t timerIndex = cascadingList.head; timerIndex != NIL_INDEX; ) {
+                        const uint32_t nextTimerIndex = m_timers[timerIndex].wheelLinks.next;
+                        --m_numTimersInWheel;
+                        InsertIntoWheel(timerIndex);
+                        timerIndex = nextTimerIndex;
+                    }
+                }
+            }
+        }
+        const unsigned int slot = static_cast<unsigned int>(m_wheelCurrentTick & (WHEEL_SLOTS_PER_LEVEL - 1));
+        const uint64_t slotBit = static_cast<uint64_t>(1) << slot;
+        if (m_wheelOccupancyMasks[0] & slotBit) {
+            for (uint32_t timerIndex = m_wheelLists[slot].head; timerIndex != NIL_INDEX; ) {
+                const uint32_t nextTimerIndex = m_timers[timerIndex].wheelLinks.next;
+                --m_numTimersInWheel;
+                m_timers[timerIndex].wheelListIndex = EXPIRED_LIST_INDEX;
+                PushBack(m_wheelLists[EXPIRED_LIST_INDEX], timerIndex, &timer_t::wheelLinks);
+                timerIndex = nextTimerIndex;
+            }
+            m_wheelLists[slot] = list_t();
+            m_wheelOccupancyMasks[0] &= ~slotBit;
         }
-        return (m_mapCustodyIdToListIterator.erase(custodyId) == 1);
     }
-    return false;
+    if (nowTick > m_wheelCurrentTick) {
+        m_wheelCurrentTick = nowTick;
+    }
 }
 
-bool CustodyTimers::PollOneAndPopAnyExpiredCustodyTimer(uint64_t & custodyId, const boost::posix_time::ptime & nowPtime) {
-    for (desteid_to_custidexpirylist_map_t::iterator it = m_mapDestEidToCustodyIdExpiryList.begin(); it != m_mapDestEidToCustodyIdExpiryList.end(); ++it) {
-        custid_ptime_list_t & custIdPlusPtimeList = it->second;
-        if (!custIdPlusPtimeList.empty()) {
-            custid_ptime_pair_t & thisCustodyIdPlusPtimePair = custIdPlusPtimeList.front();
-            boost::posix_time::ptime & thisExpiry = thisCustodyIdPlusPtimePair.second;
-            if (thisExpiry <= nowPtime) {
-                custid_ptime_list_t & custIdPlusPtimeList = it->second;
-                const custid_ptime_pair_t & thisCustodyIdPlusPtimePair = custIdPlusPtimeList.front();
-                custodyId = thisCustodyIdPlusPtimePair.first;
-                custIdPlusPtimeList.pop_front();
-                if (custIdPlusPtimeList.empty()) {
-                    m_mapDestEidToCustodyIdExpiryList.erase(it);
+void CustodyTimers::RemoveTimer(const uint32_t timerIndex) {
+    timer_t & timer = m_timers[timerIndex];
+    UnlinkFromWheel(timerIndex);
+    Unlink(timer.eidTimersPtr->list, timerIndex, &timer_t::eidLinks);
+    --(timer.eidTimersPtr->size);
+    uint64_t unusedTimerIndex;
+    m_mapCustodyIdToTimerIndex.GetValueAndRemove(timer.custodyId, unusedTimerIndex);
+    timer.eidTimersPtr = NULL;
+    timer.wheelLinks.next = m_freeTimersHead;
+    m_freeTimersHead = timerIndex;
+}
+
+
+bool CustodyTimers::PollOneAndPopExpiredCustodyTimer(uint64_t & custodyId, const std::vector<cbhe_eid_t> & availableDestEids, const boost::posix_time::ptime & nowPtime) {
+    const uint64_t nowTick = PtimeToTick(nowPtime, false);
+    uint64_t lowestExpiryTick = UINT64_MAX;
+    uint32_t lowestExpiryTimerIndex = NIL_INDEX;
+    for (std::size_t i = 0; i < availableDestEids.size(); ++i) {
+        desteid_to_timers_map_t::iterator it = m_mapDestEidToTimers.find(availableDestEids[i]);
+        if (it != m_mapDestEidToTimers.end()) {
+            const uint32_t headTimerIndex = it->second.list.head;
+            if (headTimerIndex != NIL_INDEX) {
+                const uint64_t thisExpiryTick = m_timers[headTimerIndex].expiryTick;
+                if (lowestExpiryTick > thisExpiryTick) {
+                    lowestExpiryTick = thisExpiryTick;
+                    lowestExpiryTimerIndex = headTimerIndex;
                 }
-                return (m_mapCustodyIdToListIterator.erase(custodyId) == 1);
             }
         }
     }
+    if ((lowestExpiryTimerIndex != NIL_INDEX) && (lowestExpiryTick <= nowTick)) {
+        custodyId = m_timers[lowestExpiryTimerIndex].custodyId;
+        RemoveTimer(lowestExpiryTimerIndex);
+        return true;
+    }
     return false;
 }
 
-bool CustodyTimers::StartCustodyTransferTimer(const cbhe_eid_t & finalDestEid, const uint64_t custodyId) {
-    //expiry will always be appended to list (always greater than previous) (duplicate expiries ok)
-    const boost::posix_time::ptime expiry = boost::posix_time::microsec_clock::universal_time() + M_CUSTODY_TIMEOUT_DURATION;
-
-    typename std::pair<custid_to_listiterator_map_t::iterator, bool> retVal =
-        m_mapCustodyIdToListIterator.insert(
-            custid_to_listiterator_map_insertion_element_t(custodyId, custid_ptime_list_t::iterator()));
-    if (retVal.second) {
-        //value was inserted
-        custid_ptime_list_t & listRef = m_mapDestEidToCustodyIdExpiryList[finalDestEid];
-        retVal.first->second = listRef.insert(listRef.end(), custid_ptime_pair_t(custodyId, expiry));
+bool CustodyTimers::PollOneAndPopAnyExpiredCustodyTimer(uint64_t & custodyId, const boost::posix_time::ptime & nowPtime) {
+    const uint64_t nowTick = PtimeToTick(nowPtime, false);
+    list_t & expiredList = m_wheelLists[EXPIRED_LIST_INDEX];
+    if (expiredList.head == NIL_INDEX) {
+        AdvanceWheelTo(nowTick);
+    }
+    const uint32_t timerIndex = expiredList.head;
+    if ((timerIndex != NIL_INDEX) && (m_timers[timerIndex].expiryTick <= nowTick)) {
+        custodyId = m_timers[timerIndex].custodyId;
+        RemoveTimer(timerIndex);
         return true;
     }
     return false;
 }
+
+bool CustodyTimers::StartCustodyTransferTimer(const cbhe_eid_t & finalDestEid, const uint64_t custodyId) {
+    //expiry will always be appended to the destination's list (always greater than previous) (duplicate expiries ok)
+    const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+    const uint64_t expiryTick = PtimeToTick(nowPtime + M_CUSTODY_TIMEOUT_DURATION, true);
+
+    uint32_t timerIndex = m_freeTimersHead;
+    if (timerIndex == NIL_INDEX) {
+        timerIndex = static_cast<uint32_t>(m_timers.size());
+    }
+    if (m_mapCustodyIdToTimerIndex.Insert(custodyId, timerIndex) == NULL) {
+        return false; //already exists
+    }
+    if (timerIndex == m_freeTimersHead) {
+        m_freeTimersHead = m_timers[timerIndex].wheelLinks.next;
+    }
+    else {
+        m_timers.emplace_back();
+    }
+    if (m_numTimersInWheel == 0) { //nothing to cascade, so skip ahead rather than placing the timer relative to a stale tick
+        const uint64_t nowTick = PtimeToTick(nowPtime, false);
+        if (nowTick > m_wheelCurrentTick) {
+            m_wheelCurrentTick = nowTick;
+        }
+    }
+    timer_t & timer = m_timers[timerIndex];
+    timer.custodyId = custodyId;
+    timer.expiryTick = expiryTick;
+    timer.eidTimersPtr = &m_mapDestEidToTimers[finalDestEid];
+    PushBack(timer.eidTimersPtr->list, timerIndex, &timer_t::eidLinks);
+    ++(timer.eidTimersPtr->size);
+    InsertIntoWheel(timerIndex);
+    return true;
+}
 bool CustodyTimers::CancelCustodyTransferTimer(const cbhe_eid_t & finalDestEid, const uint64_t custodyId) {
-    custid_to_listiterator_map_t::iterator itCidToListItMap = m_mapCustodyIdToListIterator.find(custodyId);
-    if (itCidToListItMap != m_mapCustodyIdToListIterator.end()) {
-        desteid_to_custidexpirylist_map_t::iterator itEidToCidExpiryListMap = m_mapDestEidToCustodyIdExpiryList.find(finalDestEid);
-        if (itEidToCidExpiryListMap != m_mapDestEidToCustodyIdExpiryList.end()) {
-            custid_ptime_list_t & listRef = itEidToCidExpiryListMap->second;
-            listRef.erase(itCidToListItMap->second);
-            if (listRef.empty()) {
-                m_mapDestEidToCustodyIdExpiryList.erase(itEidToCidExpiryListMap);
-            }
-            m_mapCustodyIdToListIterator.erase(itCidToListItMap);
+    uint64_t * timerIndexPtr = m_mapCustodyIdToTimerIndex.GetValuePtr(custodyId);
+    if (timerIndexPtr != NULL) {
+        const uint32_t timerIndex = static_cast<uint32_t>(*timerIndexPtr);
+        desteid_to_timers_map_t::iterator it = m_mapDestEidToTimers.find(finalDestEid);
+        if ((it != m_mapDestEidToTimers.end()) && (m_timers[timerIndex].eidTimersPtr == &it->second)) {
+            RemoveTimer(timerIndex);
             return true;
         }
         return false;
@@ -110,17 +282,13 @@ bool CustodyTimers::CancelCustodyTransferTimer(const cbhe_eid_t & finalDestEid,
 }
 
 std::size_t CustodyTimers::GetNumCustodyTransferTimers() {
-    std::size_t sum = 0;
-    for (desteid_to_custidexpirylist_map_t::iterator it = m_mapDestEidToCustodyIdExpiryList.begin(); it != m_mapDestEidToCustodyIdExpiryList.end(); ++it) {
-        sum += it->second.size();
-    }
-    return sum;
+    return m_mapCustodyIdToTimerIndex.GetSize();
 }
 
 std::size_t CustodyTimers::GetNumCustodyTransferTimers(const cbhe_eid_t & finalDestEid) {
-    desteid_to_custidexpirylist_map_t::iterator itEidToCidExpiryListMap = m_mapDestEidToCustodyIdExpiryList.find(finalDestEid);
-    if (itEidToCidExpiryListMap != m_mapDestEidToCustodyIdExpiryList.end()) {
-        return itEidToCidExpiryListMap->second.size();
+    desteid_to_timers_map_t::iterator it = m_mapDestEidToTimers.find(finalDestEid);
+    if (it != m_mapDestEidToTimers.end()) {
+        return it->second.size;
     }
     return 0;
 }
@@ -33,16 +33,81 @@
 #  include <ammintrin.h>
 # endif
 #endif //USE_BITTEST or USE_ANDN
+#include <algorithm>
+#include <atomic>
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+//lock-free mode atomic operations on the existing (naturally aligned) uint64_t words of the tree
+#ifdef _MSC_VER
+static BOOST_FORCEINLINE uint64_t AtomicLoad64(const uint64_t * p) {
+    return static_cast<uint64_t>(_InterlockedOr64((volatile __int64*)p, 0));
+}
+static BOOST_FORCEINLINE bool AtomicCompareExchange64(uint64_t * p, uint64_t & expected, const uint64_t desired) {
+    const uint64_t previous = static_cast<uint64_t>(_InterlockedCompareExchange64((volatile __int64*)p, static_cast<__int64>(desired), static_cast<__int64>(expected)));
+    if (previous == expected) {
+        return true;
+    }
+    expected = previous;
+    return false;
+}
+static BOOST_FORCEINLINE uint64_t AtomicFetchAnd64(uint64_t * p, const uint64_t mask64) {
+    return static_cast<uint64_t>(_InterlockedAnd64((volatile __int64*)p, static_cast<__int64>(mask64)));
+}
+static BOOST_FORCEINLINE uint64_t AtomicFetchOr64(uint64_t * p, const uint64_t mask64) {
+    return static_cast<uint64_t>(_InterlockedOr64((volatile __int64*)p, static_cast<__int64>(mask64)));
+}
+#else
+static BOOST_FORCEINLINE uint64_t AtomicLoad64(const uint64_t * p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static BOOST_FORCEINLINE bool AtomicCompareExchange64(uint64_t * p, uint64_t & expected, const uint64_t desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static BOOST_FORCEINLINE uint64_t AtomicFetchAnd64(uint64_t * p, const uint64_t mask64) {
+    return __atomic_fetch_and(p, mask64, __ATOMIC_SEQ_CST);
+}
+static BOOST_FORCEINLINE uint64_t AtomicFetchOr64(uint64_t * p, const uint64_t mask64) {
+    return __atomic_fetch_or(p, mask64, __ATOMIC_SEQ_CST);
+}
+#endif
 
-MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) : M_MAX_SEGMENTS(maxSegments), m_bitMasks(MAX_TREE_ARRAY_DEPTH) {
+//lock-free mode per-thread caches of pre-claimed segment ids
+#define NUM_SEGMENT_MAGAZINES 16
+#define SEGMENT_MAGAZINE_CAPACITY 64
+
+struct MemoryManagerTreeArray::SegmentMagazine {
+    boost::mutex m_mutex; //only ever try_lock'ed by allocators (so never blocks them), uncontended unless more threads than magazines
+    unsigned int m_size;
+    segment_id_t m_segmentIds[SEGMENT_MAGAZINE_CAPACITY];
+    uint8_t m_padding[64]; //keep magazines on separate cache lines
+    SegmentMagazine() : m_size(0) {}
+};
+
+MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) : MemoryManagerTreeArray(maxSegments, false) {}
+
+MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments, const bool useLockFreeAllocation) :
+    M_MAX_SEGMENTS(maxSegments),
+    M_USE_LOCK_FREE_ALLOCATION(useLockFreeAllocation),
+    m_bitMasks(MAX_TREE_ARRAY_DEPTH)
+{
 #if 0
     AllocateRowsMaxMemory();
 #else
     AllocateRows(static_cast<segment_id_t>(M_MAX_SEGMENTS));
 #endif
+    InitWholeFreeHints();
+    if (M_USE_LOCK_FREE_ALLOCATION) {
+        m_magazines.reset(new SegmentMagazine[NUM_SEGMENT_MAGAZINES]);
+    }
 }
 MemoryManagerTreeArray::~MemoryManagerTreeArray() {}
 
+bool MemoryManagerTreeArray::IsLockFreeAllocation() const {
+    return M_USE_LOCK_FREE_ALLOCATION;
+}
+
 
 void MemoryManagerTreeArray::BackupDataToVector(memmanager_t & backup) const {
     backup = m_bitMasks;
@@ -132,6 +197,7 @@ bool MemoryManagerTreeArray::FreeSegmentId_NotThreadSafe(const segment_id_t segm
         if (!success) {
             return false;
         }
+        SetWholeFreeHintIfWholeFree(longIndex, longRef);
     }
     for (segment_id_t depth = MAX_TREE_ARRAY_DEPTH - 1; depth != 0; --depth) {
         const segment_id_t bitIndex = longIndex & 63;
@@ -148,6 +214,30 @@ bool MemoryManagerTreeArray::FreeSegmentId_NotThreadSafe(const segment_id_t segm
     return true;
 }
 
+/** Private function to size the whole free hint rows like the upper rows of the tree, with every whole leaf uint64_t marked whole free.
+*
+* @post m_wholeFreeHints is resized with exactly the bits leading to the whole leaf uint64_t's set high.
+*/
+void MemoryManagerTreeArray::InitWholeFreeHints() {
+    static constexpr segment_id_t LEAF_DEPTH_INDEX = MAX_TREE_ARRAY_DEPTH - 1;
+    m_wholeFreeHints.resize(LEAF_DEPTH_INDEX);
+    for (segment_id_t depthIndex = 0; depthIndex < LEAF_DEPTH_INDEX; ++depthIndex) {
+        m_wholeFreeHints[depthIndex].assign(m_bitMasks[depthIndex].size(), 0);
+    }
+    const uint64_t numWholeLongs = M_MAX_SEGMENTS >> 6; //a partial last leaf uint64_t is never whole
+    for (uint64_t longIndex = 0; longIndex < numWholeLongs; ++longIndex) {
+        m_wholeFreeHints[LEAF_DEPTH_INDEX - 1][longIndex >> 6] |= (((uint64_t)1) << (longIndex & 63));
+    }
+    for (segment_id_t depthIndex = LEAF_DEPTH_INDEX - 1; depthIndex != 0; --depthIndex) {
+        const std::vector<uint64_t> & row = m_wholeFreeHints[depthIndex];
+        for (std::size_t longIndex = 0; longIndex < row.size(); ++longIndex) {
+            if (row[longIndex]) {
+                m_wholeFreeHints[depthIndex - 1][longIndex >> 6] |= (((uint64_t)1) << (longIndex & 63));
+            }
+        }
+    }
+}
+
 /** Private function to allocate just enough memory to accomodate up to the given largestSegmentId.
 *
 * @param largestSegmentId The maximum number of segment Ids this data structure will support.
@@ -221,6 +311,9 @@ bool MemoryManagerTreeArray::AllocateSegmentId_NotThreadSafe(const segment_id_t
 }
 
 bool MemoryManagerTreeArray::AllocateSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec) { //number of segments should be the vector size
+    if (M_USE_LOCK_FREE_ALLOCATION) {
+        return AllocateSegments_LockFree(segmentVec);
+    }
     boost::mutex::scoped_lock lock(m_mutex);
     const std::size_t size = segmentVec.size();
     for (std::size_t i = 0; i < size; ++i) {
@@ -240,6 +333,9 @@ bool MemoryManagerTreeArray::AllocateSegments_ThreadSafe(segment_id_chain_vec_t
 }
 
 bool MemoryManagerTreeArray::FreeSegments_ThreadSafe(const segment_id_chain_vec_t & segmentVec) {
+    if (M_USE_LOCK_FREE_ALLOCATION) {
+        return FreeSegments_LockFree(segmentVec);
+    }
     boost::mutex::scoped_lock lock(m_mutex);
     const std::size_t size = segmentVec.size();
     bool success = true;
@@ -251,4 +347,511 @@ bool MemoryManagerTreeArray::FreeSegments_ThreadSafe(const segment_id_chain_vec_
     return success;
 }
 
+/** Private function (lock-free mode) to get the magazine assigned to the calling thread.
+* Threads are assigned magazines round robin on their first allocation.
+*
+* @return The calling thread's magazine.
+*/
+MemoryManagerTreeArray::SegmentMagazine & MemoryManagerTreeArray::GetThisThreadsMagazine() {
+    static std::atomic<unsigned int> nextMagazineIndex(0);
+    static thread_local const unsigned int thisThreadsMagazineIndex = (nextMagazineIndex++) % NUM_SEGMENT_MAGAZINES;
+    return m_magazines[thisThreadsMagazineIndex];
+}
+
+/** Private function (lock-free mode) to mark the bits leading to a child word as not full all the way up to the root.
+*
+* @param depthIndex The tree row/depth index of the child word.
+* @param longIndex The index of the child word within its row.
+*/
+void MemoryManagerTreeArray::SetHintsUpward_LockFree(segment_id_t depthIndex, segment_id_t longIndex) {
+    for (; depthIndex != 0; --depthIndex) {
+        const segment_id_t bitIndex = longIndex & 63;
+        longIndex >>= 6; //divide by 64 bits per ui64
+        uint64_t * const longPtr = &m_bitMasks[depthIndex - 1][longIndex];
+        const uint64_t mask64 = (((uint64_t)1) << bitIndex);
+        if ((AtomicLoad64(longPtr) & mask64) == 0) { //avoid a read-modify-write (cache line contention at the root) if already set
+            AtomicFetchOr64(longPtr, mask64);
+        }
+    }
+}
+
+/** Private function (lock-free mode) to mark a child word observed as full (zero) as full in its parent, continuing upward while parents become full.
+* In lock-free mode only the leaf row is authoritative and the upper rows are hints.  A free always sets the leaf bit before the hints,
+* and a full marking always re-checks the child after clearing the hint, so a hint can never remain cleared while its child has free segments.
+* (A hint may transiently remain set for a full child, which allocators detect and repair.)
+*
+* @param depthIndex The tree row/depth index of the full child word.
+* @param longIndex The index of the full child word within its row.
+*/
+void MemoryManagerTreeArray::ClearFullHintsUpward_LockFree(segment_id_t depthIndex, segment_id_t longIndex) {
+    for (; depthIndex != 0; --depthIndex) {
+        const segment_id_t bitIndex = longIndex & 63;
+        const segment_id_t parentLongIndex = longIndex >> 6; //divide by 64 bits per ui64
+        uint64_t * const parentLongPtr = &m_bitMasks[depthIndex - 1][parentLongIndex];
+        const uint64_t mask64 = (((uint64_t)1) << bitIndex);
+        const uint64_t parentLong = AtomicFetchAnd64(parentLongPtr, ~mask64) & (~mask64);
+        if (AtomicLoad64(&m_bitMasks[depthIndex][longIndex]) != 0) { //child was freed concurrently, so undo
+            SetHintsUpward_LockFree(depthIndex, longIndex);
+            return;
+        }
+        if (parentLong != 0) {
+            return;
+        }
+        longIndex = parentLongIndex;
+    }
+}
+
+/** Private function (lock-free mode) to claim up to 64 free segments (all from one leaf word) with a single compare-and-swap.
+*
+* @param maxCount The max number of segments to claim.
+* @param segmentIds The array to write the claimed segment Ids to (must hold maxCount elements).
+* @return The number of segments claimed, which is zero if and only if the MemoryManagerTreeArray is full (or maxCount is zero).
+* @post The claimed segments are marked allocated in the internal data structures.
+*/
+unsigned int MemoryManagerTreeArray::ClaimSegmentsFromTree_LockFree(const std::size_t maxCount, segment_id_t * segmentIds) {
+    if (maxCount == 0) {
+        return 0;
+    }
+    static constexpr segment_id_t LEAF_DEPTH_INDEX = MAX_TREE_ARRAY_DEPTH - 1;
+    while (true) {
+        //descend by following the first not-full hint of each row
+        segment_id_t longIndex = 0;
+        bool restart = false;
+        for (segment_id_t depthIndex = 0; depthIndex < LEAF_DEPTH_INDEX; ++depthIndex) {
+            const uint64_t hintLong = AtomicLoad64(&m_bitMasks[depthIndex][longIndex]);
+            if (hintLong == 0) {
+                if (depthIndex == 0) {
+                    return 0; //full
+                }
+                ClearFullHintsUpward_LockFree(depthIndex, longIndex); //stale hint
+                restart = true;
+                break;
+            }
+            longIndex = (longIndex << 6) | boost::multiprecision::detail::find_lsb<uint64_t>(hintLong);
+        }
+        if (restart) {
+            continue;
+        }
 
+        //bits at or beyond M_MAX_SEGMENTS in the last leaf word are never allocated
+        const uint64_t firstSegmentIdOfLong = static_cast<uint64_t>(longIndex) << 6;
+        const uint64_t validMask64 = (firstSegmentIdOfLong + 64 <= M_MAX_SEGMENTS) ? UINT64_MAX :
+            (firstSegmentIdOfLong >= M_MAX_SEGMENTS) ? 0 : ((((uint64_t)1) << (M_MAX_SEGMENTS - firstSegmentIdOfLong)) - 1);
+        uint64_t * const leafLongPtr = &m_bitMasks[LEAF_DEPTH_INDEX][longIndex];
+        uint64_t leafLong = AtomicLoad64(leafLongPtr);
+        uint64_t claimMask64 = 0;
+        while (true) {
+            if (leafLong == 0) {
+                break; //stale hint
+            }
+            uint64_t availableMask64 = leafLong & validMask64;
+            if (availableMask64 == 0) {
+                return 0; //only the never allocated bits remain, so full
+            }
+            //take the lowest maxCount free bits
+            claimMask64 = 0;
+            for (std::size_t i = 0; (i < maxCount) && availableMask64; ++i) {
+                const uint64_t lowestBit64 = availableMask64 & (~availableMask64 + 1);
+                claimMask64 |= lowestBit64;
+                availableMask64 ^= lowestBit64;
+            }
+            if (AtomicCompareExchange64(leafLongPtr, leafLong, leafLong & (~claimMask64))) {
+                break;
+            }
+            //leafLong was updated with the current value, try again
+        }
+        if (leafLong == 0) {
+            ClearFullHintsUpward_LockFree(LEAF_DEPTH_INDEX, longIndex);
+            continue;
+        }
+        if ((leafLong & (~claimMask64)) == 0) {
+            ClearFullHintsUpward_LockFree(LEAF_DEPTH_INDEX, longIndex);
+        }
+        unsigned int count = 0;
+        while (claimMask64) {
+            const unsigned int bitIndex = boost::multiprecision::detail::find_lsb<uint64_t>(claimMask64);
+            claimMask64 &= (claimMask64 - 1); //clear lowest set bit
+            segmentIds[count++] = static_cast<segment_id_t>(firstSegmentIdOfLong | bitIndex);
+        }
+        return count;
+    }
+}
+
+/** Private function (lock-free mode) to free one segment.
+*
+* @param segmentId The segment to be freed.
+* @return True if the given segment number was freed, or False otherwise (invalid or already free).
+*/
+bool MemoryManagerTreeArray::FreeSegmentId_LockFree(const segment_id_t segmentId) {
+    if (segmentId >= M_MAX_SEGMENTS) return false;
+    const segment_id_t longIndex = segmentId >> 6; //divide by 64 bits per ui64
+    const uint64_t mask64 = (((uint64_t)1) << (segmentId & 63));
+    const uint64_t previousLeafLong = AtomicFetchOr64(&m_bitMasks[MAX_TREE_ARRAY_DEPTH - 1][longIndex], mask64);
+    if (previousLeafLong & mask64) {
+        return false; //already free
+    }
+    SetHintsUpward_LockFree(MAX_TREE_ARRAY_DEPTH - 1, longIndex);
+    SetWholeFreeHintIfWholeFree(longIndex, previousLeafLong | mask64);
+    return true;
+}
+
+bool MemoryManagerTreeArray::AllocateSegments_LockFree(segment_id_chain_vec_t & segmentVec) {
+    const std::size_t size = segmentVec.size();
+    std::size_t numAllocated = 0;
+
+    SegmentMagazine & magazine = GetThisThreadsMagazine();
+    if (magazine.m_mutex.try_lock()) { //if another thread shares and is using this magazine, bypass it rather than wait
+        while ((numAllocated < size) && magazine.m_size) {
+            segmentVec[numAllocated++] = magazine.m_segmentIds[--magazine.m_size];
+        }
+        while (numAllocated < size) {
+            const unsigned int count = ClaimSegmentsFromTree_LockFree(size - numAllocated, &segmentVec[numAllocated]);
+            if (count == 0) {
+                break;
+            }
+            numAllocated += count;
+        }
+        if ((numAllocated == size) && (magazine.m_size == 0)) { //refill for the next small bundle
+            magazine.m_size = ClaimSegmentsFromTree_LockFree(SEGMENT_MAGAZINE_CAPACITY, magazine.m_segmentIds);
+        }
+        magazine.m_mutex.unlock();
+    }
+
+    while (numAllocated < size) {
+        unsigned int count = ClaimSegmentsFromTree_LockFree(size - numAllocated, &segmentVec[numAllocated]);
+        if (count == 0) { //appears full, but other magazines may be holding segments
+            ReturnCachedSegments_ThreadSafe();
+            count = ClaimSegmentsFromTree_LockFree(size - numAllocated, &segmentVec[numAllocated]);
+            if (count == 0) { //fail
+                for (std::size_t j = 0; j < numAllocated; ++j) {
+                    FreeSegmentId_LockFree(segmentVec[j]);
+                }
+                segmentVec.resize(0);
+                return false;
+            }
+        }
+        numAllocated += count;
+    }
+
+    //ascending order keeps a bundle's segments adjacent on disk where possible
+    std::sort(segmentVec.begin(), segmentVec.end());
+    return true;
+}
+
+bool MemoryManagerTreeArray::FreeSegments_LockFree(const segment_id_chain_vec_t & segmentVec) {
+    const std::size_t size = segmentVec.size();
+    bool success = true;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (!FreeSegmentId_LockFree(segmentVec[i])) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+void MemoryManagerTreeArray::ReturnCachedSegments_ThreadSafe() {
+    if (!M_USE_LOCK_FREE_ALLOCATION) {
+        return;
+    }
+    for (unsigned int i = 0; i < NUM_SEGMENT_MAGAZINES; ++i) {
+        SegmentMagazine & magazine = m_magazines[i];
+        boost::mutex::scoped_lock lock(magazine.m_mutex);
+        while (magazine.m_size) {
+            FreeSegmentId_LockFree(magazine.m_segmentIds[--magazine.m_size]);
+        }
+    }
+}
+
+void MemoryManagerTreeArray::AppendSegmentIdToExtents(segment_id_extent_vec_t & extentVec, const segment_id_t segmentId) {
+    if (!extentVec.empty()) {
+        segment_id_extent_t & lastExtent = extentVec.back();
+        if ((lastExtent.startSegmentId + lastExtent.numSegments) == segmentId) {
+            ++lastExtent.numSegments;
+            return;
+        }
+    }
+    extentVec.emplace_back(segmentId, 1);
+}
+
+uint64_t MemoryManagerTreeArray::GetNumSegmentsInExtents(const segment_id_extent_vec_t & extentVec) {
+    uint64_t numSegments = 0;
+    for (std::size_t i = 0; i < extentVec.size(); ++i) {
+        numSegments += extentVec[i].numSegments;
+    }
+    return numSegments;
+}
+
+/** Private function to mark the bits leading to a child word as (possibly) whole free all the way up to the root of the whole free hints.
+* The child word is either a whole free leaf uint64_t (depthIndex == MAX_TREE_ARRAY_DEPTH - 1) or a not empty row of m_wholeFreeHints.
+* Atomic in both modes, since FreeSegmentRun does not hold m_mutex in lock-free mode.
+*
+* @param depthIndex The tree row/depth index of the child word.
+* @param longIndex The index of the child word within its row.
+*/
+void MemoryManagerTreeArray::SetWholeFreeHintsUpward(segment_id_t depthIndex, segment_id_t longIndex) {
+    for (; depthIndex != 0; --depthIndex) {
+        const segment_id_t bitIndex = longIndex & 63;
+        longIndex >>= 6; //divide by 64 bits per ui64
+        uint64_t * const longPtr = &m_wholeFreeHints[depthIndex - 1][longIndex];
+        const uint64_t mask64 = (((uint64_t)1) << bitIndex);
+        if ((AtomicLoad64(longPtr) & mask64) == 0) { //avoid a read-modify-write if already set
+            AtomicFetchOr64(longPtr, mask64);
+        }
+    }
+}
+
+/** Private function to set the whole free hint of a leaf uint64_t that a free just made whole free (all 64 segments free).
+*
+* @param longIndex The index of the leaf uint64_t within the leaf row.
+* @param leafLong The value of the leaf uint64_t after the free.
+*/
+void MemoryManagerTreeArray::SetWholeFreeHintIfWholeFree(const segment_id_t longIndex, const uint64_t leafLong) {
+    if ((leafLong == UINT64_MAX) && (longIndex < (M_MAX_SEGMENTS >> 6))) { //a partial last leaf uint64_t is never whole
+        SetWholeFreeHintsUpward(MAX_TREE_ARRAY_DEPTH - 1, longIndex);
+    }
+}
+
+/** Private function to clear the whole free hint of a child word observed as not whole free (or empty), continuing upward while parents become empty.
+* Allocations never clear whole free hints, so hints are only cleared here (lazily, by the searcher that finds them stale).
+* A free always updates the leaf before setting the hints, and a clear always re-checks the child after clearing the hint,
+* so a hint can never remain cleared while its leaf uint64_t is whole free.
+*
+* @param depthIndex The tree row/depth index of the child word (MAX_TREE_ARRAY_DEPTH - 1 for a leaf uint64_t).
+* @param longIndex The index of the child word within its row.
+*/
+void MemoryManagerTreeArray::ClearWholeFreeHintsUpward(segment_id_t depthIndex, segment_id_t longIndex) {
+    static constexpr segment_id_t LEAF_DEPTH_INDEX = MAX_TREE_ARRAY_DEPTH - 1;
+    for (; depthIndex != 0; --depthIndex) {
+        const segment_id_t bitIndex = longIndex & 63;
+        const segment_id_t parentLongIndex = longIndex >> 6; //divide by 64 bits per ui64
+        uint64_t * const parentLongPtr = &m_wholeFreeHints[depthIndex - 1][parentLongIndex];
+        const uint64_t mask64 = (((uint64_t)1) << bitIndex);
+        const uint64_t parentLong = AtomicFetchAnd64(parentLongPtr, ~mask64) & (~mask64);
+        const bool childIsSet = (depthIndex == LEAF_DEPTH_INDEX) ?
+            (AtomicLoad64(&m_bitMasks[LEAF_DEPTH_INDEX][longIndex]) == UINT64_MAX) :
+            (AtomicLoad64(&m_wholeFreeHints[depthIndex][longIndex]) != 0);
+        if (childIsSet) { //child was freed concurrently, so undo
+            SetWholeFreeHintsUpward(depthIndex, longIndex);
+            return;
+        }
+        if (parentLong != 0) {
+            return;
+        }
+        longIndex = parentLongIndex;
+    }
+}
+
+/** Private function to claim leaf uint64_t's that have all 64 segments free (must hold m_mutex if not in lock-free mode).
+* The candidates are found by descending the whole free hints (first set bit of each row), like the allocators descend the tree,
+* so the cost is proportional to the tree depth (plus any stale hints cleared on the way) rather than to the size of the leaf row.
+*
+* @param maxLongs The max number of leaf uint64_t's to claim.
+* @param extentVec The extents to append the claimed segments to (neighboring leaf uint64_t's are merged into one extent).
+* @return The number of leaf uint64_t's claimed (i.e. 64 times fewer than the number of segments claimed).
+* @post The claimed segments are marked allocated in the internal data structures.
+*/
+uint64_t MemoryManagerTreeArray::ClaimWholeFreeLeafLongs(const uint64_t maxLongs, segment_id_extent_vec_t & extentVec) {
+    static constexpr segment_id_t LEAF_DEPTH_INDEX = MAX_TREE_ARRAY_DEPTH - 1;
+    std::vector<uint64_t> & leafRow = m_bitMasks[LEAF_DEPTH_INDEX];
+    uint64_t numClaimed = 0;
+    while (numClaimed < maxLongs) {
+        //descend by following the first whole free hint of each row
+        segment_id_t longIndex = 0;
+        bool restart = false;
+        for (segment_id_t depthIndex = 0; depthIndex < LEAF_DEPTH_INDEX; ++depthIndex) {
+            const uint64_t hintLong = AtomicLoad64(&m_wholeFreeHints[depthIndex][longIndex]);
+            if (hintLong == 0) {
+                if (depthIndex == 0) {
+                    return numClaimed; //no whole free leaf uint64_t's remain
+                }
+                ClearWholeFreeHintsUpward(depthIndex, longIndex); //stale hint
+                restart = true;
+                break;
+            }
+            longIndex = (longIndex << 6) | boost::multiprecision::detail::find_lsb<uint64_t>(hintLong);
+        }
+        if (restart) {
+            continue;
+        }
+
+        uint64_t * const leafLongPtr = &leafRow[longIndex];
+        bool claimed;
+        if (M_USE_LOCK_FREE_ALLOCATION) {
+            uint64_t expectedLeafLong = UINT64_MAX;
+            claimed = AtomicCompareExchange64(leafLongPtr, expectedLeafLong, 0);
+            if (claimed) {
+                ClearFullHintsUpward_LockFree(LEAF_DEPTH_INDEX, longIndex);
+            }
+        }
+        else {
+            claimed = (*leafLongPtr == UINT64_MAX);
+            if (claimed) {
+                *leafLongPtr = 0;
+                segment_id_t parentLongIndex = longIndex;
+                for (segment_id_t depth = LEAF_DEPTH_INDEX; depth != 0; --depth) { //mark full upward while parents become full
+                    const segment_id_t bitIndex = parentLongIndex & 63;
+                    parentLongIndex >>= 6; //divide by 64 bits per ui64
+                    uint64_t & longRef = m_bitMasks[depth - 1][parentLongIndex];
+                    longRef &= ~(((uint64_t)1) << bitIndex);
+                    if (longRef != 0) {
+                        break;
+                    }
+                }
+            }
+        }
+        ClearWholeFreeHintsUpward(LEAF_DEPTH_INDEX, longIndex); //no longer whole free (just claimed, or a stale hint)
+        if (!claimed) {
+            continue;
+        }
+        const segment_id_t startSegmentId = static_cast<segment_id_t>(longIndex << 6);
+        if ((!extentVec.empty()) && ((extentVec.back().startSegmentId + extentVec.back().numSegments) == startSegmentId)) {
+            extentVec.back().numSegments += 64;
+        }
+        else {
+            extentVec.emplace_back(startSegmentId, 64);
+        }
+        ++numClaimed;
+    }
+    return numClaimed;
+}
+
+/** Private function to free a run of consecutive segments (must hold m_mutex if not in lock-free mode), one leaf uint64_t at a time.
+*
+* @param startSegmentId The first segment of the run.
+* @param numSegments The number of segments in the run.
+* @return True if every segment of the run was freed, or False otherwise (invalid run or some were already free).
+*/
+bool MemoryManagerTreeArray::FreeSegmentRun(const segment_id_t startSegmentId, const segment_id_t numSegments) {
+    static constexpr segment_id_t LEAF_DEPTH_INDEX = MAX_TREE_ARRAY_DEPTH - 1;
+    const uint64_t endSegmentId = static_cast<uint64_t>(startSegmentId) + numSegments;
+    if (endSegmentId > M_MAX_SEGMENTS) {
+        return false;
+    }
+    bool success = true;
+    for (uint64_t segmentId = startSegmentId; segmentId < endSegmentId; ) {
+        const segment_id_t longIndex = static_cast<segment_id_t>(segmentId >> 6); //divide by 64 bits per ui64
+        const unsigned int firstBitIndex = static_cast<unsigned int>(segmentId & 63);
+        const uint64_t numBits = std::min<uint64_t>(64 - firstBitIndex, endSegmentId - segmentId);
+        const uint64_t mask64 = ((numBits == 64) ? UINT64_MAX : ((((uint64_t)1) << numBits) - 1)) << firstBitIndex;
+        uint64_t * const leafLongPtr = &m_bitMasks[LEAF_DEPTH_INDEX][longIndex];
+        if (M_USE_LOCK_FREE_ALLOCATION) {
+            const uint64_t previousLeafLong = AtomicFetchOr64(leafLongPtr, mask64);
+            if (previousLeafLong & mask64) {
+                success = false; //some were already free
+            }
+            SetHintsUpward_LockFree(LEAF_DEPTH_INDEX, longIndex);
+            SetWholeFreeHintIfWholeFree(longIndex, previousLeafLong | mask64);
+        }
+        else {
+            if ((*leafLongPtr) & mask64) {
+                success = false; //some were already free
+            }
+            *leafLongPtr |= mask64;
+            SetWholeFreeHintIfWholeFree(longIndex, *leafLongPtr);
+            segment_id_t parentLongIndex = longIndex;
+            for (segment_id_t depth = LEAF_DEPTH_INDEX; depth != 0; --depth) {
+                const segment_id_t bitIndex = parentLongIndex & 63;
+                parentLongIndex >>= 6; //divide by 64 bits per ui64
+                m_bitMasks[depth - 1][parentLongIndex] |= (((uint64_t)1) << bitIndex);
+            }
+        }
+        segmentId += numBits;
+    }
+    return success;
+}
+
+bool MemoryManagerTreeArray::AllocateSegmentExtents_ThreadSafe(const uint64_t numSegments, segment_id_extent_vec_t & extentVec) {
+    return AllocateSegmentExtents_ThreadSafe(numSegments, extentVec, false);
+}
+
+bool MemoryManagerTreeArray::AllocateSegmentExtents_ThreadSafe(const uint64_t numSegments, segment_id_extent_vec_t & extentVec, const bool roundUpToWholeLeaves) {
+    extentVec.clear();
+    boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+    if (!M_USE_LOCK_FREE_ALLOCATION) {
+        lock.lock();
+    }
+
+    const uint64_t numWholeLeafLongsWanted = roundUpToWholeLeaves ? ((numSegments + 63) >> 6) : (numSegments >> 6);
+    uint64_t numAllocated = ClaimWholeFreeLeafLongs(numWholeLeafLongsWanted, extentVec) << 6;
+    if (numAllocated > numSegments) { //give back the unused tail of the last (highest) whole leaf uint64_t
+        const segment_id_t numExcess = static_cast<segment_id_t>(numAllocated - numSegments);
+        segment_id_extent_t & lastExtent = extentVec.back();
+        lastExtent.numSegments -= numExcess;
+        FreeSegmentRun(lastExtent.startSegmentId + lastExtent.numSegments, numExcess);
+        numAllocated = numSegments;
+    }
+
+    //fill the remainder (and any shortage of whole free leaf uint64_t's) one segment at a time
+    if (M_USE_LOCK_FREE_ALLOCATION) {
+        segment_id_t segmentIds[64];
+        bool cachedSegmentsReturned = false;
+        while (numAllocated < numSegments) {
+            const uint64_t numRemaining = numSegments - numAllocated;
+            const unsigned int count = ClaimSegmentsFromTree_LockFree(static_cast<std::size_t>(std::min<uint64_t>(numRemaining, 64)), segmentIds);
+            if (count == 0) { //appears full, but magazines may be holding segments
+                if (cachedSegmentsReturned) {
+                    break;
+                }
+                ReturnCachedSegments_ThreadSafe();
+                cachedSegmentsReturned = true;
+                continue;
+            }
+            for (unsigned int i = 0; i < count; ++i) {
+                AppendSegmentIdToExtents(extentVec, segmentIds[i]);
+            }
+            numAllocated += count;
+        }
+    }
+    else {
+        while (numAllocated < numSegments) {
+            const segment_id_t segmentId = GetAndSetFirstFreeSegmentId_NotThreadSafe();
+            if (segmentId == SEGMENT_ID_FULL) {
+                break;
+            }
+            AppendSegmentIdToExtents(extentVec, segmentId);
+            ++numAllocated;
+        }
+    }
+
+    if (numAllocated < numSegments) { //fail
+        for (std::size_t i = 0; i < extentVec.size(); ++i) {
+            FreeSegmentRun(extentVec[i].startSegmentId, extentVec[i].numSegments);
+        }
+        extentVec.clear();
+        return false;
+    }
+    if (extentVec.empty()) {
+        return true;
+    }
+
+    //ascending order keeps a bundle's segments adjacent on disk where possible
+    std::sort(extentVec.begin(), extentVec.end(), [](const segment_id_extent_t & a, const segment_id_extent_t & b) {
+        return a.startSegmentId < b.startSegmentId;
+    });
+    std::size_t lastMergedIndex = 0;
+    for (std::size_t i = 1; i < extentVec.size(); ++i) {
+        segment_id_extent_t & lastMergedExtent = extentVec[lastMergedIndex];
+        if ((lastMergedExtent.startSegmentId + lastMergedExtent.numSegments) == extentVec[i].startSegmentId) {
+            lastMergedExtent.numSegments += extentVec[i].numSegments;
+        }
+        else {
+            extentVec[++lastMergedIndex] = extentVec[i];
+        }
+    }
+    extentVec.resize(lastMergedIndex + 1);
+    return true;
+}
+
+bool MemoryManagerTreeArray::FreeSegmentExtents_ThreadSafe(const segment_id_extent_vec_t & extentVec) {
+    boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+    if (!M_USE_LOCK_FREE_ALLOCATION) {
+        lock.lock();
+    }
+    bool success = true;
+    for (std::size_t i = 0; i < extentVec.size(); ++i) {
+        if (!FreeSegmentRun(extentVec[i].startSegmentId, extentVec[i].numSegments)) {
+            success = false;
+        }
+    }
+    return success;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file OpenAddressingHashMap.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "OpenAddressingHashMap.h"
+#include <boost/config.hpp>
+#include <new>
+#include <cstring>
+#include "CatalogEntry.h"
+
+#define CONTROL_EMPTY 0x80
+#define CONTROL_DELETED 0xFE //any control code below 0x80 is a full slot holding the low 7 bits of the key's hash
+#define INITIAL_CAPACITY 16
+#define MIN_NODE_CHUNK_SIZE 64
+#define MAX_NODE_CHUNK_SIZE 65536
+
+//murmur3 64-bit finalizer, so that both the low bits (control code) and high bits (probe start) depend on every key bit
+static BOOST_FORCEINLINE uint64_t MixHash64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+template <typename keyType, typename valueType>
+OpenAddressingHashMap<keyType, valueType>::OpenAddressingHashMap() :
+    m_numNodesUsedInLastChunk(0),
+    m_lastChunkNumNodes(0)
+{
+    InitTable(INITIAL_CAPACITY);
+}
+
+template <typename keyType, typename valueType>
+OpenAddressingHashMap<keyType, valueType>::~OpenAddressingHashMap() {
+    DestroyAllNodes();
+}
+
+template <typename keyType, typename valueType>
+uint64_t OpenAddressingHashMap<keyType, valueType>::GetHash(const cbhe_bundle_uuid_t & bundleUuid) {
+    uint64_t h = MixHash64(bundleUuid.creationSeconds);
+    h = MixHash64(h ^ bundleUuid.sequence);
+    h = MixHash64(h ^ bundleUuid.srcEid.nodeId);
+    h = MixHash64(h ^ bundleUuid.srcEid.serviceId);
+    h = MixHash64(h ^ bundleUuid.fragmentOffset);
+    return MixHash64(h ^ bundleUuid.dataLength);
+}
+
+template <typename keyType, typename valueType>
+uint64_t OpenAddressingHashMap<keyType, valueType>::GetHash(const cbhe_bundle_uuid_nofragment_t & bundleUuid) {
+    uint64_t h = MixHash64(bundleUuid.creationSeconds);
+    h = MixHash64(h ^ bundleUuid.sequence);
+    h = MixHash64(h ^ bundleUuid.srcEid.nodeId);
+    return MixHash64(h ^ bundleUuid.srcEid.serviceId);
+}
+
+template <typename keyType, typename valueType>
+uint64_t OpenAddressingHashMap<keyType, valueType>::GetHash(const uint64_t key) {
+    return MixHash64(key);
+}
+
+template <typename keyType, typename valueType>
+void OpenAddressingHashMap<keyType, valueType>::InitTable(const std::size_t capacity) {
+    m_capacity = capacity;
+    m_size = 0;
+    m_numDeleted = 0;
+    m_controls.reset(new uint8_t[capacity]);
+    m_slots.reset(new node_t*[capacity]);
+    memset(m_controls.get(), CONTROL_EMPTY, capacity);
+}
+
+//return slot index if exists, m_capacity if key doesn't exist in the map
+template <typename keyType, typename valueType>
+std::size_t OpenAddressingHashMap<keyType, valueType>::FindSlotIndex(const uint64_t hash, const keyType & key) const {
+    const uint8_t controlCode = static_cast<uint8_t>(hash & 0x7f);
+    const std::size_t mask = m_capacity - 1;
+    for (std::size_t i = static_cast<std::size_t>(hash >> 7) & mask; ; i = (i + 1) & mask) { //table is never full so this terminates
+        const uint8_t control = m_controls[i];
+        if (control == controlCode) {
+            if (m_slots[i]->keyValuePair.first == key) {
+                return i;
+            }
+        }
+        else if (control == CONTROL_EMPTY) {
+            return m_capacity;
+        }
+    }
+}
+
+template <typename keyType, typename valueType>
+void OpenAddressingHashMap<keyType, valueType>::Rehash(const std::size_t newCapacity) {
+    const std::size_t oldCapacity = m_capacity;
+    const std::size_t oldSize = m_size;
+    std::unique_ptr<uint8_t[]> oldControls(std::move(m_controls));
+    std::unique_ptr<node_t*[]> oldSlots(std::move(m_slots));
+    InitTable(newCapacity);
+    const std::size_t mask = m_capacity - 1;
+    for (std::size_t oldIndex = 0; oldIndex < oldCapacity; ++oldIndex) {
+        if (oldControls[oldIndex] < CONTROL_EMPTY) { //full
+            node_t * const node = oldSlots[oldIndex];
+            std::size_t i = static_cast<std::size_t>(node->hash >> 7) & mask;
+            while (m_controls[i] != CONTROL_EMPTY) {
+                i = (i + 1) & mask;
+            }
+            m_controls[i] = oldControls[oldIndex];
+            m_slots[i] = node;
+        }
+    }
+    m_size = oldSize;
+}
+
+//get memory for one node from the pool (free list first, otherwise the last chunk, allocating a larger chunk when exhausted)
+template <typename keyType, typename valueType>
+void * OpenAddressingHashMap<keyType, valueType>::AllocateNode() {
+    if (!m_freeNodes.empty()) {
+        node_t * const node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return node;
+    }
+    if (m_numNodesUsedInLastChunk == m_lastChunkNumNodes) {
+        m_lastChunkNumNodes = (m_lastChunkNumNodes == 0) ? MIN_NODE_CHUNK_SIZE :
+            (m_lastChunkNumNodes >= MAX_NODE_CHUNK_SIZE) ? MAX_NODE_CHUNK_SIZE : (m_lastChunkNumNodes * 2);
+        m_nodeChunks.emplace_back(new node_storage_t[m_lastChunkNumNodes]);
+        m_numNodesUsedInLastChunk = 0;
+    }
+    return &m_nodeChunks.back()[m_numNodesUsedInLastChunk++];
+}
+
+template <typename keyType, typename valueType>
+void OpenAddressingHashMap<keyType, valueType>::FreeNode(node_t * node) {
+    node->~node_t();
+    m_freeNodes.push_back(node);
+}
+
+template <typename keyType, typename valueType>
+void OpenAddressingHashMap<keyType, valueType>::DestroyAllNodes() {
+    for (std::size_t i = 0; i < m_capacity; ++i) {
+        if (m_controls[i] < CONTROL_EMPTY) { //full
+            m_slots[i]->~node_t();
+        }
+    }
+    m_nodeChunks.clear();
+    m_freeNodes.clear();
+    m_numNodesUsedInLastChunk = 0;
+    m_lastChunkNumNodes = 0;
+}
+
+//return ptr of inserted pair if inserted, NULL if already exists
+template <typename keyType, typename valueType>
+const typename OpenAddressingHashMap<keyType, valueType>::key_value_pair_t * OpenAddressingHashMap<keyType, valueType>::Insert(const keyType & key, const valueType & value) {
+    return Insert(GetHash(key), key, std::move(valueType(value)));
+}
+
+//return ptr of inserted pair if inserted, NULL if already exists
+template <typename keyType, typename valueType>
+const typename OpenAddressingHashMap<keyType, valueType>::key_value_pair_t * OpenAddressingHashMap<keyType, valueType>::Insert(const keyType & key, valueType && value) {
+    return Insert(GetHash(key), key, std::move(value));
+}
+
+//return ptr of inserted pair if inserted, NULL if already exists
+template <typename keyType, typename valueType>
+const typename OpenAddressingHashMap<keyType, valueType>::key_value_pair_t * OpenAddressingHashMap<keyType, valueType>::Insert(const uint64_t hash, const keyType & key, const valueType & value) {
+    return Insert(hash, key, std::move(valueType(value)));
+}
+
+//return ptr of inserted pair if inserted, NULL if already exists
+template <typename keyType, typename valueType>
+const typename OpenAddressingHashMap<keyType, valueType>::key_value_pair_t * OpenAddressingHashMap<keyType, valueType>::Insert(const uint64_t hash, const keyType & key, valueType && value) {
+    if (FindSlotIndex(hash, key) != m_capacity) { //already exists
+        return NULL;
+    }
+    if ((m_size + m_numDeleted + 1) > ((m_capacity / 8) * 7)) { //max load of 7/8 (deleted slots also lengthen probes)
+        //double if at least 7/16 full of live entries, otherwise the deleted slots are the problem so just purge them
+        Rehash(((m_size + 1) > ((m_capacity / 16) * 7)) ? (m_capacity * 2) : m_capacity);
+    }
+    const std::size_t mask = m_capacity - 1;
+    std::size_t i = static_cast<std::size_t>(hash >> 7) & mask;
+    while (m_controls[i] < CONTROL_EMPTY) { //reuse the first empty or deleted slot
+        i = (i + 1) & mask;
+    }
+    if (m_controls[i] == CONTROL_DELETED) {
+        --m_numDeleted;
+    }
+    node_t * const node = new (AllocateNode()) node_t(hash, key, std::move(value));
+    m_controls[i] = static_cast<uint8_t>(hash & 0x7f);
+    m_slots[i] = node;
+    ++m_size;
+    return &node->keyValuePair;
+}
+
+//return true if exists, false if key doesn't exist in the map
+template <typename keyType, typename valueType>
+bool OpenAddressingHashMap<keyType, valueType>::GetValueAndRemove(const keyType & key, valueType & value) {
+    return GetValueAndRemove(GetHash(key), key, value);
+}
+
+//return true if exists, false if key doesn't exist in the map
+template <typename keyType, typename valueType>
+bool OpenAddressingHashMap<keyType, valueType>::GetValueAndRemove(const uint64_t hash, const keyType & key, valueType & value) {
+    const std::size_t i = FindSlotIndex(hash, key);
+    if (i == m_capacity) {
+        return false;
+    }
+    node_t * const node = m_slots[i];
+    value = std::move(node->keyValuePair.second);
+    FreeNode(node);
+    //if the next slot is empty, no probe sequence continues through this slot, so it can be marked empty rather than deleted
+    if (m_controls[(i + 1) & (m_capacity - 1)] == CONTROL_EMPTY) {
+        m_controls[i] = CONTROL_EMPTY;
+    }
+    else {
+        m_controls[i] = CONTROL_DELETED;
+        ++m_numDeleted;
+    }
+    --m_size;
+    return true;
+}
+
+//return ptr if exists, NULL if key doesn't exist in the map
+template <typename keyType, typename valueType>
+valueType * OpenAddressingHashMap<keyType, valueType>::GetValuePtr(const keyType & key) {
+    return GetValuePtr(GetHash(key), key);
+}
+
+//return ptr if exists, NULL if key doesn't exist in the map
+template <typename keyType, typename valueType>
+valueType * OpenAddressingHashMap<keyType, valueType>::GetValuePtr(const uint64_t hash, const keyType & key) {
+    const std::size_t i = FindSlotIndex(hash, key);
+    if (i == m_capacity) {
+        return NULL;
+    }
+    return &(m_slots[i]->keyValuePair.second);
+}
+
+template <typename keyType, typename valueType>
+std::size_t OpenAddressingHashMap<keyType, valueType>::GetSize() const {
+    return m_size;
+}
+
+template <typename keyType, typename valueType>
+std::size_t OpenAddressingHashMap<keyType, valueType>::GetCapacity() const {
+    return m_capacity;
+}
+
+template <typename keyType, typename valueType>
+void OpenAddressingHashMap<keyType, valueType>::Clear() {
+    DestroyAllNodes();
+    InitTable(INITIAL_CAPACITY);
+}
+
+// Explicit template instantiation
+template class OpenAddressingHashMap<cbhe_bundle_uuid_t, uint64_t>;
+template class OpenAddressingHashMap<cbhe_bundle_uuid_nofragment_t, uint64_t>;
+template class OpenAddressingHashMap<uint64_t, catalog_entry_t>;
+template class OpenAddressingHashMap<uint64_t, uint64_t>;
@@ -0,0 +1,88 @@
+/**
+ * @file ReadAheadSessions.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "ReadAheadSessions.h"
+#include "Logger.h"
+#include <boost/make_unique.hpp>
+
+static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
+
+ReadAheadSessions::ReadAheadSessions(const std::size_t maxBundlesPerQueue, const std::size_t maxSessions) :
+    M_MAX_BUNDLES_PER_QUEUE(maxBundlesPerQueue),
+    M_MAX_SESSIONS(maxSessions),
+    m_numSessionsAllocated(0)
+{
+    m_freeSessions.reserve(maxSessions);
+}
+
+ReadAheadSessions::~ReadAheadSessions() {}
+
+void ReadAheadSessions::Fill(BundleStorageManagerBase & bsm, queue_t & queue, const uint64_t releaseIndexId) {
+    while (queue.size() < M_MAX_BUNDLES_PER_QUEUE) {
+        session_ptr_t sessionPtr;
+        if (!m_freeSessions.empty()) {
+            sessionPtr = std::move(m_freeSessions.back());
+            m_freeSessions.pop_back();
+        }
+        else if (m_numSessionsAllocated < M_MAX_SESSIONS) {
+            sessionPtr = boost::make_unique<BundleStorageManagerSession_ReadFromDisk>();
+            ++m_numSessionsAllocated;
+        }
+        else {
+            return; //all read-ahead buffers in use
+        }
+        if (bsm.PopTopFromReleaseIndex(*sessionPtr, releaseIndexId) == 0) {
+            m_freeSessions.push_back(std::move(sessionPtr));
+            return; //no more bundles for this link
+        }
+        bsm.ReadAhead(*sessionPtr);
+        queue.push_back(std::move(sessionPtr));
+    }
+}
+
+void ReadAheadSessions::Free(session_ptr_t && sessionPtr) {
+    m_freeSessions.push_back(std::move(sessionPtr));
+}
+
+void ReadAheadSessions::ReturnAll(BundleStorageManagerBase & bsm, queue_t & queue) {
+    while (!queue.empty()) {
+        BundleStorageManagerSession_ReadFromDisk & session = *queue.back();
+        bsm.WaitForReadAhead(session); //the disks no longer write into the session
+        if (!bsm.ReturnTop(session)) {
+            LOG_ERROR(subprocess) << "unable to return read-ahead custody id " << session.custodyId << " to the awaiting send";
+        }
+        m_freeSessions.push_back(std::move(queue.back()));
+        queue.pop_back();
+    }
+}
+
+bool ReadAheadSessions::Cancel(BundleStorageManagerBase & bsm, queue_t & queue, const uint64_t custodyId) {
+    for (queue_t::iterator it = queue.begin(); it != queue.end(); ++it) {
+        if ((*it)->custodyId == custodyId) {
+            bsm.WaitForReadAhead(**it); //the disks no longer write into the session
+            m_freeSessions.push_back(std::move(*it));
+            queue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t ReadAheadSessions::GetNumSessionsAllocated() const {
+    return m_numSessionsAllocated;
+}
+
+std::size_t ReadAheadSessions::GetNumFreeSessions() const {
+    return m_freeSessions.size();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file ReleaseBufferPool.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright © 2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include "ReleaseBufferPool.h"
+#include <vector>
+#include <memory>
+#include <boost/thread.hpp>
+
+#define RELEASE_BUFFER_POOL_MIN_SIZE_CLASS_SHIFT 12 //4KB
+#define RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES 15 //4KB to 64MB, larger buffers are not pooled
+
+struct PooledReleaseBuffer;
+
+struct ReleaseBufferPool::Shared {
+    Shared(const uint64_t paramMaxFreeBytes) :
+        freeListsBySizeClass(RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES),
+        maxFreeBytes(paramMaxFreeBytes),
+        freeBytes(0),
+        numBuffersAllocated(0),
+        numBuffersReused(0),
+        numBuffersOutstanding(0),
+        poolDestroyed(false) {}
+    ~Shared();
+
+    mutable boost::mutex mutex;
+    std::vector<std::vector<PooledReleaseBuffer *> > freeListsBySizeClass;
+    const uint64_t maxFreeBytes;
+    uint64_t freeBytes;
+    uint64_t numBuffersAllocated;
+    uint64_t numBuffersReused;
+    uint64_t numBuffersOutstanding;
+    bool poolDestroyed;
+};
+
+struct PooledReleaseBuffer {
+    PooledReleaseBuffer(const std::size_t paramCapacity, const unsigned int paramSizeClass, ReleaseBufferPool::Shared * paramSharedPtr) :
+        data(new uint8_t[paramCapacity]), //not value initialized, the whole bundle is read into it
+        capacity(paramCapacity),
+        sizeClass(paramSizeClass),
+        sharedPtr(paramSharedPtr) {}
+
+    std::unique_ptr<uint8_t[]> data;
+    const std::size_t capacity;
+    const unsigned int sizeClass; //RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES if not pooled
+    ReleaseBufferPool::Shared * const sharedPtr;
+};
+
+ReleaseBufferPool::Shared::~Shared() {
+    for (std::size_t i = 0; i < freeListsBySizeClass.size(); ++i) {
+        for (std::size_t j = 0; j < freeListsBySizeClass[i].size(); ++j) {
+            delete freeListsBySizeClass[i][j];
+        }
+    }
+}
+
+//zmq free function, called from whichever thread closes the message
+static void ReturnPooledReleaseBuffer(void * data, void * hint) {
+    (void)data;
+    PooledReleaseBuffer * bufferPtr = static_cast<PooledReleaseBuffer *>(hint);
+    ReleaseBufferPool::Shared * const sharedPtr = bufferPtr->sharedPtr;
+    bool deleteShared;
+    {
+        boost::mutex::scoped_lock lock(sharedPtr->mutex);
+        --sharedPtr->numBuffersOutstanding;
+        if ((!sharedPtr->poolDestroyed) && (bufferPtr->sizeClass < RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES)
+            && ((sharedPtr->freeBytes + bufferPtr->capacity) <= sharedPtr->maxFreeBytes))
+        {
+            sharedPtr->freeListsBySizeClass[bufferPtr->sizeClass].push_back(bufferPtr);
+            sharedPtr->freeBytes += bufferPtr->capacity;
+            bufferPtr = NULL;
+        }
+        deleteShared = sharedPtr->poolDestroyed && (sharedPtr->numBuffersOutstanding == 0);
+    }
+    delete bufferPtr;
+    if (deleteShared) {
+        delete sharedPtr;
+    }
+}
+
+ReleaseBufferPool::ReleaseBufferPool(const uint64_t maxFreeBytes) : m_sharedPtr(new Shared(maxFreeBytes)) {}
+
+ReleaseBufferPool::~ReleaseBufferPool() {
+    bool deleteShared;
+    {
+        boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+        m_sharedPtr->poolDestroyed = true;
+        deleteShared = (m_sharedPtr->numBuffersOutstanding == 0);
+    }
+    if (deleteShared) {
+        delete m_sharedPtr;
+    }
+}
+
+zmq::message_t ReleaseBufferPool::AllocateMessage(const std::size_t size) {
+    unsigned int sizeClass = 0;
+    while ((sizeClass < RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES) && ((static_cast<std::size_t>(1) << (RELEASE_BUFFER_POOL_MIN_SIZE_CLASS_SHIFT + sizeClass)) < size)) {
+        ++sizeClass;
+    }
+    PooledReleaseBuffer * bufferPtr = NULL;
+    {
+        boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+        ++m_sharedPtr->numBuffersOutstanding;
+        if (sizeClass < RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES) {
+            std::vector<PooledReleaseBuffer *> & freeList = m_sharedPtr->freeListsBySizeClass[sizeClass];
+            if (!freeList.empty()) {
+                bufferPtr = freeList.back();
+                freeList.pop_back();
+                m_sharedPtr->freeBytes -= bufferPtr->capacity;
+                ++m_sharedPtr->numBuffersReused;
+            }
+        }
+        if (bufferPtr == NULL) {
+            ++m_sharedPtr->numBuffersAllocated;
+        }
+    }
+    if (bufferPtr == NULL) {
+        const std::size_t capacity = (sizeClass < RELEASE_BUFFER_POOL_NUM_SIZE_CLASSES) ?
+            (static_cast<std::size_t>(1) << (RELEASE_BUFFER_POOL_MIN_SIZE_CLASS_SHIFT + sizeClass)) : size;
+        bufferPtr = new PooledReleaseBuffer(capacity, sizeClass, m_sharedPtr);
+    }
+    return zmq::message_t(bufferPtr->data.get(), size, ReturnPooledReleaseBuffer, bufferPtr);
+}
+
+uint64_t ReleaseBufferPool::GetNumBuffersAllocated() const {
+    boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+    return m_sharedPtr->numBuffersAllocated;
+}
+uint64_t ReleaseBufferPool::GetNumBuffersReused() const {
+    boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+    return m_sharedPtr->numBuffersReused;
+}
+uint64_t ReleaseBufferPool::GetNumBuffersOutstanding() const {
+    boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+    return m_sharedPtr->numBuffersOutstanding;
+}
+uint64_t ReleaseBufferPool::GetFreeBytes() const {
+    boost::mutex::scoped_lock lock(m_sharedPtr->mutex);
+    return m_sharedPtr->freeBytes;
+}
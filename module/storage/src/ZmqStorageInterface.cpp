@@ -16,6 +16,9 @@
 #include "message.hpp"
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+#include "BundleStorageManagerIoUring.h"
+#endif
 #include "Logger.h"
 #include <map>
 #include <string>
@@ -28,17 +31,40 @@
 #include <boost/core/noncopyable.hpp>
 #include <set>
 #include <unordered_map>
+#include <deque>
 #include <boost/lexical_cast.hpp>
 #include <boost/make_unique.hpp>
 #include "codec/CustodyIdAllocator.h"
 #include "codec/CustodyTransferManager.h"
 #include "Uri.h"
 #include "CustodyTimers.h"
+#include "ReleaseBufferPool.h"
+#include "ReadAheadSessions.h"
+#include "SlotQueueSingleProducerSingleConsumer.h"
+#include "bundle_rings.hpp"
+#include "SharedMemoryBundleArena.h"
 #include "codec/BundleViewV7.h"
 
 typedef std::pair<cbhe_eid_t, bool> eid_plus_isanyserviceid_pair_t;
 static constexpr hdtn::Logger::SubProcess subprocess = hdtn::Logger::SubProcess::storage;
 
+#define EXPIRED_BUNDLE_REAPER_PERIOD_MILLISECONDS 1000
+#define EXPIRED_BUNDLE_REAPER_MAX_BUNDLES_PER_BATCH 1000 //bounds the time the reaper holds up the storage loop
+#define RELEASE_BUFFER_POOL_MAX_FREE_BYTES (64ULL * 1024 * 1024) //idle bundle buffers kept for reuse by ReleaseOne_NoBlock
+#define STORAGE_STAGE_QUEUE_SIZE 1000 //messages in flight from one storage pipeline stage to the next before the producing stage blocks
+#define STORAGE_STAGE_QUEUE_FULL_WAIT_MILLISECONDS 250 //how often a stage blocked on a full queue checks whether storage is stopping
+#define STORAGE_READ_AHEAD_BUNDLES_PER_LINK 4 //bundles popped for an up link and being read from disk ahead of their release
+#define STORAGE_READ_AHEAD_MAX_SESSIONS 32 //bounds the read-ahead buffers (each a session read cache of READ_CACHE_NUM_SEGMENTS_PER_SESSION segments)
+static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
+
+//Storage is a pipeline of three threads linked by single producer single consumer queues (SlotQueueSingleProducerSingleConsumer):
+// - writer stage: receives bundles from ingress, parses them, and copies their segments into the disk circular buffers
+// - custody stage: processes bundles requesting custody and admin records (custody signals), and generates ACS bundles
+// - release stage (ThreadFunc): sole owner of the storage catalog and custody timers; catalogs the bundles written by the
+//   other stages, applies custody signals, releases bundles to egress, handles egress acks, link changes, and telemetry,
+//   and sends all acks to ingress
+//Because only the release stage touches the catalog, no stage locks it.
+
 struct ZmqStorageInterface::Impl : private boost::noncopyable {
     struct CutThroughQueueData : private boost::noncopyable {
         CutThroughQueueData() = delete;
@@ -62,7 +88,7 @@ struct ZmqStorageInterface::Impl : private boost::noncopyable {
     typedef std::unordered_map<uint64_t, uint64_t> custodyid_to_size_map_t;
     typedef std::unordered_map<uint64_t, CutThroughMapAckData> map_id_to_ackdata_t;
     struct OutductInfo_t : private boost::noncopyable {
-        OutductInfo_t() : linkIsUp(false), stateTryCutThrough(false), bytesInPipeline(0) {}
+        OutductInfo_t() : linkIsUp(false), stateTryCutThrough(false), bytesInPipeline(0), releaseIndexId(0) {}
         uint64_t maxBundlesInPipeline;
         uint64_t maxBundleSizeBytesInPipeline;
         uint64_t nextHopNodeId;
@@ -74,29 +100,89 @@ struct ZmqStorageInterface::Impl : private boost::noncopyable {
         map_id_to_ackdata_t mapIngressUniqueIdToIngressAckData;
         cut_through_queue_t cutThroughQueue;
         uint64_t bytesInPipeline;
+        uint64_t releaseIndexId; //storage catalog release index of eidVec while the link is up, 0 if none
+        ReadAheadSessions::queue_t readAheadQueue; //bundles popped from releaseIndexId whose reads are in flight, in release order
         friend std::ostream& operator<<(std::ostream& os, const OutductInfo_t& o);
         
     };
     typedef std::unique_ptr<OutductInfo_t> OutductInfoPtr_t;
+    struct StageMessage : private boost::noncopyable { //a message from one storage pipeline stage to another
+        enum class TYPE {
+            //writer or custody stage to release stage
+            CATALOG_WRITTEN_BUNDLE = 0, //catalogEntry, bundleUuid, custodyId of a bundle whose segments are written but not cataloged
+            ACK_TO_INGRESS_ONLY,
+            CUT_THROUGH_BUNDLE, //toStorageHdr, bundle
+            ADD_OPPORTUNISTIC_LINK, //toStorageHdr
+            REMOVE_OPPORTUNISTIC_LINK, //toStorageHdr
+            ACS_CUSTODY_TRANSFER, //custodyIdFills
+            RFC5050_CUSTODY_TRANSFER, //bundleUuid, isFragment
+            //writer stage to custody stage
+            CUSTODY_OR_ADMIN_BUNDLE //bundle, ackToIngress
+        };
+        StageMessage() : type(TYPE::ACK_TO_INGRESS_ONLY), hasAckToIngress(false), isFragment(false), custodyId(0) {}
+        TYPE type;
+        bool hasAckToIngress; //release stage sends ackToIngress to ingress after processing the message
+        bool isFragment;
+        uint64_t custodyId;
+        hdtn::ToStorageHdr toStorageHdr;
+        cbhe_bundle_uuid_t bundleUuid;
+        catalog_entry_t catalogEntry;
+        std::vector<FragmentSet::data_fragment_t> custodyIdFills;
+        zmq::message_t bundle;
+        zmq::message_t ackToIngress;
+    };
+    struct StageLink : private boost::noncopyable { //one way link from a producing stage to a consuming stage
+        StageLink() : queue(STORAGE_STAGE_QUEUE_SIZE) {}
+        SlotQueueSingleProducerSingleConsumer<StageMessage> queue;
+        std::unique_ptr<zmq::socket_t> wakeConsumerSockPtr; //used only by the producing stage to wake the consumer from zmq::poll
+    };
 
     Impl();
     ~Impl();
     void Stop();
-    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr);
+    bool Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, hdtn::OneProcessBundleRings* hdtnOneProcessBundleRingsPtr);
     std::size_t GetCurrentNumberOfBundlesDeletedFromStorage();
 
 private:
-    bool WriteAcsBundle(const Bpv6CbhePrimaryBlock& primary, const std::vector<uint8_t>& acsBundleSerialized);
+    //The Write functions catalog the bundles they write (and apply custody signals) immediately if catalogStageLinkPtr is NULL
+    //(i.e. when called by the release stage), otherwise they post them to the release stage over catalogStageLinkPtr.
+    //When posting, the ack to ingress (if ackToIngressPtr is not NULL) is attached to the last message posted and
+    //ackToIngressPtr is set to NULL; if ackToIngressPtr is still not NULL on return, the caller must post the ack.
+    bool WriteAcsBundle(const Bpv6CbhePrimaryBlock& primary, const std::vector<uint8_t>& acsBundleSerialized, StageLink* catalogStageLinkPtr);
     bool Write(zmq::message_t* message,
-        cbhe_eid_t& finalDestEidReturned, ZmqStorageInterface::Impl* forStats, bool dontWriteIfCustodyFlagSet,
-        bool isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord);
+        cbhe_eid_t& finalDestEidReturned, bool dontWriteIfCustodyFlagSet,
+        bool isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord,
+        StageLink* catalogStageLinkPtr, zmq::message_t*& ackToIngressPtr);
     bool WriteBundle(const PrimaryBlock& bundlePrimaryBlock,
-        const uint64_t newCustodyId, const uint8_t* allData, const std::size_t allDataSize);
-    uint64_t PeekOne(const std::vector<eid_plus_isanyserviceid_pair_t>& availableDestLinks);
-    bool ReleaseOne_NoBlock(const OutductInfo_t& info, const uint64_t outductIndex, const uint64_t maxBundleSizeToRead, uint64_t& returnedBundleSize);
+        const uint64_t newCustodyId, const uint8_t* allData, const std::size_t allDataSize,
+        StageLink* catalogStageLinkPtr, zmq::message_t*& ackToIngressPtr);
+    uint64_t GetNextCustodyId(const cbhe_eid_t& bundleSrcEid);
+    void ApplyAcsCustodyTransfer(const std::vector<FragmentSet::data_fragment_t>& custodyIdFills);
+    bool ApplyRfc5050CustodyTransfer(const cbhe_bundle_uuid_t& bundleUuid, const bool isFragment);
+    StageMessage* GetStageMessageForWrite(StageLink& link, const StageMessage::TYPE type);
+    void CommitStageMessage(StageLink& link);
+    void TakeAckToIngress(StageMessage& msg, zmq::message_t*& ackToIngressPtr);
+    void PostAckToIngress(StageLink& link, zmq::message_t*& ackToIngressPtr);
+    void ProcessStageMessage(StageMessage& msg);
+    std::size_t ProcessStageMessages(StageLink& link);
+    uint64_t PeekOne(const OutductInfo_t& info);
+    bool SendBundleToEgress(const hdtn::ToEgressHdr& toEgressHdr, zmq::message_t& bundle);
+    bool SendSharedMemoryBundleToEgress(hdtn::ToEgressHdr toEgressHdr, const SharedMemoryBundleArena::Descriptor& descriptor);
+    bool ReleaseOne_NoBlock(OutductInfo_t& info, const uint64_t outductIndex, const uint64_t maxBundleSizeToRead, uint64_t& returnedBundleSize,
+        uint64_t& returnedCustodyId, const catalog_entry_t*& returnedCatalogEntryPtr);
+    void ReadAhead(OutductInfo_t& info);
+    void ReturnReadAhead(OutductInfo_t& info);
+    void CancelReadAhead(const uint64_t custodyId);
     void RepopulateUpLinksVec();
+    void DeleteReleaseIndex(OutductInfo_t & info);
     void SetLinkDown(OutductInfo_t & info);
     void ThreadFunc();
+    void WriterStageThreadFunc();
+    bool WriterStageProcessBundle(const hdtn::ToStorageHdr& toStorageHeader, zmq::message_t& zmqBundleDataReceived);
+    std::size_t WriterStageProcessBundleRing();
+    void QueueAckToIngress(zmq::message_t& ackToIngress);
+    void FlushAcksToIngress();
+    void CustodyStageThreadFunc();
 
 public:
     std::size_t m_totalBundlesErasedFromStorageNoCustodyTransfer;
@@ -107,6 +193,11 @@ public:
     uint64_t m_numRfc5050CustodyTransfers;
     uint64_t m_numAcsCustodyTransfers;
     uint64_t m_numAcsPacketsReceived;
+    uint64_t m_totalBundlesExpiredFromStorage;
+    uint64_t m_totalBytesReclaimedFromExpiredBundles;
+    uint64_t m_totalBundlesReleasedFromReadAhead;
+    uint64_t m_totalAcksToIngress;
+    uint64_t m_totalAckMessagesToIngress;
     cbhe_eid_t M_HDTN_EID_CUSTODY;
 
 private:
@@ -119,27 +210,48 @@ private:
 
     std::unique_ptr<zmq::socket_t> m_zmqRepSock_connectingGuiToFromBoundStoragePtr;
     std::unique_ptr<zmq::socket_t> m_zmqRepSock_connectingUisToFromBoundStoragePtr;
+    std::unique_ptr<zmq::socket_t> m_zmqPullSock_wakeReleaseStagePtr;
+    std::unique_ptr<zmq::socket_t> m_zmqPullSock_wakeCustodyStagePtr;
 
     HdtnConfig m_hdtnConfig;
 
     zmq::context_t* m_hdtnOneProcessZmqInprocContextPtr;
+    hdtn::OneProcessBundleRings* m_bundleRingsPtr; //if not NULL, bundles from ingress and to egress go over these instead of the inproc sockets
+    std::unique_ptr<SharedMemoryBundleArena> m_sharedMemoryBundleArenaPtr; //separate processes only, declared before the stage links to outlive the bundles they hold
+    SharedMemoryBundleArena* m_sharedMemoryToEgressArenaPtr; //if not NULL, bundles to egress that fit in a slot are sent as descriptors of this arena
     std::unique_ptr<boost::thread> m_threadPtr;
     volatile bool m_running;
     volatile bool m_threadStartupComplete;
-
-    //variables initialized and used only by ThreadFunc()
-    std::unique_ptr<BundleStorageManagerBase> m_bsmPtr;
+    std::unique_ptr<boost::thread> m_writerStageThreadPtr;
+    std::unique_ptr<boost::thread> m_custodyStageThreadPtr;
+    volatile bool m_stagesRunning;
+    StageLink m_writerToReleaseStageLink;
+    StageLink m_custodyToReleaseStageLink;
+    StageLink m_writerToCustodyStageLink;
+
+    //variables initialized by ThreadFunc() before the writer and custody stages are started
+    std::unique_ptr<BundleStorageManagerBase> m_bsmPtr; //thread safe to write from any stage, but its catalog is used only by the release stage
     std::unique_ptr<CustodyIdAllocator> m_custodyIdAllocatorPtr;
-    std::unique_ptr<CustodyTransferManager> m_ctmPtr;
-    std::unique_ptr<CustodyTimers> m_custodyTimersPtr;
-    BundleViewV6 m_custodySignalRfc5050RenderedBundleView;
+    boost::mutex m_custodyIdAllocatorMutex;
+    std::unique_ptr<CustodyTransferManager> m_ctmPtr; //custody stage only
+    std::unique_ptr<CustodyTimers> m_custodyTimersPtr; //release stage only
+    BundleViewV6 m_custodySignalRfc5050RenderedBundleView; //custody stage only
     BundleStorageManagerSession_ReadFromDisk m_sessionRead; //reuse this due to expensive heap allocation
+    ReadAheadSessions m_readAheadSessions; //sessions of all up links' readAheadQueue, also reused due to expensive heap allocation
+    ReleaseBufferPool m_releaseBufferPool; //bundles read from disk are sent to egress in these buffers
     std::vector<OutductInfoPtr_t> m_vectorOutductInfo; //outductIndex to info
     std::map<uint64_t, OutductInfoPtr_t> m_mapOpportunisticNextHopNodeIdToOutductInfo;
     std::vector<OutductInfo_t*> m_vectorUpLinksOutductInfoPtrs; //outductIndex to info
+    std::vector<hdtn::StorageAckHdr> m_acksToIngress; //release stage only, acks queued until FlushAcksToIngress
 };
 
-ZmqStorageInterface::Impl::Impl() : m_running(false) {}
+ZmqStorageInterface::Impl::Impl() :
+    m_bundleRingsPtr(NULL),
+    m_sharedMemoryToEgressArenaPtr(NULL),
+    m_running(false),
+    m_stagesRunning(false),
+    m_readAheadSessions(STORAGE_READ_AHEAD_BUNDLES_PER_LINK, STORAGE_READ_AHEAD_MAX_SESSIONS),
+    m_releaseBufferPool(RELEASE_BUFFER_POOL_MAX_FREE_BYTES) {}
 
 ZmqStorageInterface::Impl::~Impl() {
     Stop();
@@ -155,7 +267,9 @@ ZmqStorageInterface::ZmqStorageInterface() :
     m_totalBundlesSentToEgressFromStorageForwardCutThrough(m_pimpl->m_totalBundlesSentToEgressFromStorageForwardCutThrough),
     m_numRfc5050CustodyTransfers(m_pimpl->m_numRfc5050CustodyTransfers),
     m_numAcsCustodyTransfers(m_pimpl->m_numAcsCustodyTransfers),
-    m_numAcsPacketsReceived(m_pimpl->m_numAcsPacketsReceived) {}
+    m_numAcsPacketsReceived(m_pimpl->m_numAcsPacketsReceived),
+    m_totalBundlesExpiredFromStorage(m_pimpl->m_totalBundlesExpiredFromStorage),
+    m_totalBytesReclaimedFromExpiredBundles(m_pimpl->m_totalBytesReclaimedFromExpiredBundles) {}
 
 ZmqStorageInterface::~ZmqStorageInterface() {
     Stop();
@@ -172,10 +286,10 @@ void ZmqStorageInterface::Impl::Stop() {
     }
 }
 
-bool ZmqStorageInterface::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr) {
-    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr);
+bool ZmqStorageInterface::Init(const HdtnConfig& hdtnConfig, zmq::context_t* hdtnOneProcessZmqInprocContextPtr, hdtn::OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
+    return m_pimpl->Init(hdtnConfig, hdtnOneProcessZmqInprocContextPtr, hdtnOneProcessBundleRingsPtr);
 }
-bool ZmqStorageInterface::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+bool ZmqStorageInterface::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr, hdtn::OneProcessBundleRings* hdtnOneProcessBundleRingsPtr) {
     m_hdtnConfig = hdtnConfig;
     //according to ION.pdf v4.0.1 on page 100 it says:
     //  Remember that the format for this argument is ipn:element_number.0 and that
@@ -183,6 +297,17 @@ bool ZmqStorageInterface::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context
     //HDTN shall default m_myCustodialServiceId to 0 although it is changeable in the hdtn config json file
     M_HDTN_EID_CUSTODY.Set(m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_myCustodialServiceId);
     m_hdtnOneProcessZmqInprocContextPtr = hdtnOneProcessZmqInprocContextPtr;
+    m_bundleRingsPtr = (hdtnOneProcessZmqInprocContextPtr) ? hdtnOneProcessBundleRingsPtr : NULL;
+    if ((!hdtnOneProcessZmqInprocContextPtr) && (!m_hdtnConfig.m_sharedMemoryBundleArenaName.empty())
+        && (m_hdtnConfig.m_sharedMemoryIngressToStorage || m_hdtnConfig.m_sharedMemoryStorageToEgress) && (!m_sharedMemoryBundleArenaPtr))
+    {
+        m_sharedMemoryBundleArenaPtr = SharedMemoryBundleArena::Open(m_hdtnConfig.m_sharedMemoryBundleArenaName,
+            m_hdtnConfig.m_sharedMemoryBundleArenaNumSlots, m_hdtnConfig.m_sharedMemoryBundleArenaSlotSizeBytes, SharedMemoryBundleArena::PROCESS::STORAGE);
+        if (!m_sharedMemoryBundleArenaPtr) {
+            return false;
+        }
+        m_sharedMemoryToEgressArenaPtr = (m_hdtnConfig.m_sharedMemoryStorageToEgress) ? m_sharedMemoryBundleArenaPtr.get() : NULL;
+    }
 
     //{
 
@@ -292,6 +417,24 @@ bool ZmqStorageInterface::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context
         return false;
     }
 
+    //sockets (of this instance's own context) that wake a pipeline stage when its incoming queues become non-empty
+    m_zmqPullSock_wakeReleaseStagePtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::pull);
+    m_zmqPullSock_wakeCustodyStagePtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::pull);
+    m_writerToReleaseStageLink.wakeConsumerSockPtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::push);
+    m_custodyToReleaseStageLink.wakeConsumerSockPtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::push);
+    m_writerToCustodyStageLink.wakeConsumerSockPtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::push);
+    try {
+        m_zmqPullSock_wakeReleaseStagePtr->bind(std::string("inproc://wake_storage_release_stage"));
+        m_zmqPullSock_wakeCustodyStagePtr->bind(std::string("inproc://wake_storage_custody_stage"));
+        m_writerToReleaseStageLink.wakeConsumerSockPtr->connect(std::string("inproc://wake_storage_release_stage"));
+        m_custodyToReleaseStageLink.wakeConsumerSockPtr->connect(std::string("inproc://wake_storage_release_stage"));
+        m_writerToCustodyStageLink.wakeConsumerSockPtr->connect(std::string("inproc://wake_storage_custody_stage"));
+    }
+    catch (const zmq::error_t& ex) {
+        LOG_ERROR(subprocess) << "error: cannot set up storage pipeline stage sockets: " << ex.what();
+        return false;
+    }
+
     // Use a form of receive that times out so we can terminate cleanly.
     try {
         static const int timeout = 250;  // milliseconds
@@ -330,31 +473,85 @@ bool ZmqStorageInterface::Impl::Init(const HdtnConfig & hdtnConfig, zmq::context
     return true;
 }
 
-bool ZmqStorageInterface::Impl::WriteAcsBundle(const Bpv6CbhePrimaryBlock & primary, const std::vector<uint8_t> & acsBundleSerialized)
+bool ZmqStorageInterface::Impl::WriteAcsBundle(const Bpv6CbhePrimaryBlock & primary, const std::vector<uint8_t> & acsBundleSerialized, StageLink * catalogStageLinkPtr)
 {
     const cbhe_eid_t & hdtnSrcEid = primary.m_sourceNodeId;
-    const uint64_t newCustodyIdForAcsCustodySignal = m_custodyIdAllocatorPtr->GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
+    const uint64_t newCustodyIdForAcsCustodySignal = GetNextCustodyId(hdtnSrcEid);
 
     //write custody signal to disk
-    BundleStorageManagerSession_WriteToDisk sessionWrite;
-    const uint64_t totalSegmentsRequired = m_bsmPtr->Push(sessionWrite, primary, acsBundleSerialized.size());
-    if (totalSegmentsRequired == 0) {
-        LOG_ERROR(subprocess) << "out of space for acs custody signal";
+    zmq::message_t * noAckToIngressPtr = NULL;
+    if (!WriteBundle(primary, newCustodyIdForAcsCustodySignal, acsBundleSerialized.data(), acsBundleSerialized.size(), catalogStageLinkPtr, noAckToIngressPtr)) {
+        LOG_ERROR(subprocess) << "unable to write acs custody signal";
         return false;
     }
+    return true;
+}
+
+uint64_t ZmqStorageInterface::Impl::GetNextCustodyId(const cbhe_eid_t & bundleSrcEid) {
+    boost::mutex::scoped_lock lock(m_custodyIdAllocatorMutex); //writer, custody, and release stages all allocate custody ids
+    return m_custodyIdAllocatorPtr->GetNextCustodyIdForNextHopCtebToSend(bundleSrcEid);
+}
+
+void ZmqStorageInterface::Impl::ApplyAcsCustodyTransfer(const std::vector<FragmentSet::data_fragment_t> & custodyIdFills) {
+    for (std::size_t i = 0; i < custodyIdFills.size(); ++i) {
+        const FragmentSet::data_fragment_t & fill = custodyIdFills[i];
+        m_numAcsCustodyTransfers += (fill.endIndex + 1) - fill.beginIndex;
+        {
+            boost::mutex::scoped_lock lock(m_custodyIdAllocatorMutex);
+            m_custodyIdAllocatorPtr->FreeCustodyIdRange(fill.beginIndex, fill.endIndex);
+        }
+        for (uint64_t currentCustodyId = fill.beginIndex; currentCustodyId <= fill.endIndex; ++currentCustodyId) {
+            catalog_entry_t* catalogEntryPtr = m_bsmPtr->GetCatalogEntryPtrFromCustodyId(currentCustodyId);
+            if (catalogEntryPtr == NULL) {
+                LOG_ERROR(subprocess) << "error finding catalog entry for bundle identified by acs custody signal";
+                continue;
+            }
+            if (!m_custodyTimersPtr->CancelCustodyTransferTimer(catalogEntryPtr->destEid, currentCustodyId)) {
+                LOG_WARNING(subprocess) << "can't find custody timer associated with bundle identified by acs custody signal";
+            }
+            CancelReadAhead(currentCustodyId);
+            if (!m_bsmPtr->RemoveReadBundleFromDisk(catalogEntryPtr, currentCustodyId)) {
+                LOG_ERROR(subprocess) << "error freeing bundle identified by acs custody signal from disk";
+                continue;
+            }
+            ++m_totalBundlesErasedFromStorageWithCustodyTransfer;
+        }
+    }
+}
 
-    const uint64_t totalBytesPushed = m_bsmPtr->PushAllSegments(sessionWrite, primary,
-        newCustodyIdForAcsCustodySignal, acsBundleSerialized.data(), acsBundleSerialized.size());
-    if (totalBytesPushed != acsBundleSerialized.size()) {
-        LOG_ERROR(subprocess) << "totalBytesPushed != acsBundleSerialized.size";
+bool ZmqStorageInterface::Impl::ApplyRfc5050CustodyTransfer(const cbhe_bundle_uuid_t & bundleUuid, const bool isFragment) {
+    uint64_t* custodyIdPtr = (isFragment) ? m_bsmPtr->GetCustodyIdFromUuid(bundleUuid) : m_bsmPtr->GetCustodyIdFromUuid(cbhe_bundle_uuid_nofragment_t(bundleUuid));
+    if (custodyIdPtr == NULL) {
+        LOG_ERROR(subprocess) << "error custody signal does not match a bundle in the storage database";
+        return false;
+    }
+    const uint64_t custodyIdFromRfc5050 = *custodyIdPtr;
+    {
+        boost::mutex::scoped_lock lock(m_custodyIdAllocatorMutex);
+        m_custodyIdAllocatorPtr->FreeCustodyId(custodyIdFromRfc5050);
+    }
+    catalog_entry_t* catalogEntryPtr = m_bsmPtr->GetCatalogEntryPtrFromCustodyId(custodyIdFromRfc5050);
+    if (catalogEntryPtr == NULL) {
+        LOG_ERROR(subprocess) << "error finding catalog entry for bundle identified by rfc5050 custody signal";
         return false;
     }
+    if (!m_custodyTimersPtr->CancelCustodyTransferTimer(catalogEntryPtr->destEid, custodyIdFromRfc5050)) {
+        LOG_WARNING(subprocess) << "notice: can't find custody timer associated with bundle identified by rfc5050 custody signal";
+    }
+    CancelReadAhead(custodyIdFromRfc5050);
+    if (!m_bsmPtr->RemoveReadBundleFromDisk(catalogEntryPtr, custodyIdFromRfc5050)) {
+        LOG_ERROR(subprocess) << "error freeing bundle identified by rfc5050 custody signal from disk";
+        return false;
+    }
+    ++m_totalBundlesErasedFromStorageWithCustodyTransfer;
+    ++m_numRfc5050CustodyTransfers;
     return true;
 }
 
 bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
-    cbhe_eid_t & finalDestEidReturned, ZmqStorageInterface::Impl * forStats, bool dontWriteIfCustodyFlagSet,
-    bool isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord)
+    cbhe_eid_t & finalDestEidReturned, bool dontWriteIfCustodyFlagSet,
+    bool isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord,
+    StageLink * catalogStageLinkPtr, zmq::message_t *& ackToIngressPtr)
 {
     
     
@@ -370,9 +567,9 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
         }
         const Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
         finalDestEidReturned = primary.m_destinationEid;
-        const uint64_t newCustodyId = m_custodyIdAllocatorPtr->GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+        const uint64_t newCustodyId = GetNextCustodyId(primary.m_sourceNodeId);
 
-        if (!loadPrimaryBlockOnly) {
+        if (!loadPrimaryBlockOnly) { //custody stage
             static const BPV6_BUNDLEFLAG requiredPrimaryFlagsForCustody = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::CUSTODY_REQUESTED;
             const bool bpv6CustodyIsRequested = ((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForCustody) == requiredPrimaryFlagsForCustody);
             if (bpv6CustodyIsRequested && dontWriteIfCustodyFlagSet) { //don't rewrite a bundle because it will already be stored and eventually deleted on a custody signal
@@ -382,7 +579,7 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
 
             //admin records pertaining to this hdtn node do not get written to disk.. they signal a deletion from disk
             static const BPV6_BUNDLEFLAG requiredPrimaryFlagsForAdminRecord = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::ADMINRECORD;
-            if (((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForAdminRecord) == requiredPrimaryFlagsForAdminRecord) && (finalDestEidReturned == forStats->M_HDTN_EID_CUSTODY)) {
+            if (((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForAdminRecord) == requiredPrimaryFlagsForAdminRecord) && (finalDestEidReturned == M_HDTN_EID_CUSTODY)) {
                 std::vector<BundleViewV6::Bpv6CanonicalBlockView*> blocks;
                 bv.GetCanonicalBlocksByType(BPV6_BLOCK_TYPE_CODE::PAYLOAD, blocks);
                 if (blocks.size() != 1) {
@@ -397,7 +594,7 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
                 const BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE adminRecordType = adminRecordBlockPtr->m_adminRecordTypeCode;
 
                 if (adminRecordType == BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::AGGREGATE_CUSTODY_SIGNAL) {
-                    ++forStats->m_numAcsPacketsReceived;
+                    ++m_numAcsPacketsReceived;
                     //check acs
                     Bpv6AdministrativeRecordContentAggregateCustodySignal* acsPtr = dynamic_cast<Bpv6AdministrativeRecordContentAggregateCustodySignal*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
                     if (acsPtr == NULL) {
@@ -411,24 +608,13 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
                     }
 
                     //todo figure out what to do with failed custody from next hop
-                    for (std::set<FragmentSet::data_fragment_t>::const_iterator it = acs.m_custodyIdFills.cbegin(); it != acs.m_custodyIdFills.cend(); ++it) {
-                        forStats->m_numAcsCustodyTransfers += (it->endIndex + 1) - it->beginIndex;
-                        m_custodyIdAllocatorPtr->FreeCustodyIdRange(it->beginIndex, it->endIndex);
-                        for (uint64_t currentCustodyId = it->beginIndex; currentCustodyId <= it->endIndex; ++currentCustodyId) {
-                            catalog_entry_t* catalogEntryPtr = m_bsmPtr->GetCatalogEntryPtrFromCustodyId(currentCustodyId);
-                            if (catalogEntryPtr == NULL) {
-                                LOG_ERROR(subprocess) << "error finding catalog entry for bundle identified by acs custody signal";
-                                continue;
-                            }
-                            if (!m_custodyTimersPtr->CancelCustodyTransferTimer(catalogEntryPtr->destEid, currentCustodyId)) {
-                                LOG_WARNING(subprocess) << "can't find custody timer associated with bundle identified by acs custody signal";
-                            }
-                            if (!m_bsmPtr->RemoveReadBundleFromDisk(catalogEntryPtr, currentCustodyId)) {
-                                LOG_ERROR(subprocess) << "error freeing bundle identified by acs custody signal from disk";
-                                continue;
-                            }
-                            ++forStats->m_totalBundlesErasedFromStorageWithCustodyTransfer;
-                        }
+                    if (catalogStageLinkPtr == NULL) {
+                        ApplyAcsCustodyTransfer(std::vector<FragmentSet::data_fragment_t>(acs.m_custodyIdFills.cbegin(), acs.m_custodyIdFills.cend()));
+                    }
+                    else if (StageMessage* msgPtr = GetStageMessageForWrite(*catalogStageLinkPtr, StageMessage::TYPE::ACS_CUSTODY_TRANSFER)) {
+                        msgPtr->custodyIdFills.assign(acs.m_custodyIdFills.cbegin(), acs.m_custodyIdFills.cend());
+                        TakeAckToIngress(*msgPtr, ackToIngressPtr);
+                        CommitStageMessage(*catalogStageLinkPtr);
                     }
                 }
                 else if (adminRecordType == BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::CUSTODY_SIGNAL) { //rfc5050 style custody transfer
@@ -443,49 +629,24 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
                         LOG_ERROR(subprocess) << "custody transfer failed with reason code " << cs.GetReasonCode();
                         return false;
                     }
-                    uint64_t* custodyIdPtr;
-                    if (cs.m_isFragment) {
-                        cbhe_bundle_uuid_t uuid;
-                        if (!Uri::ParseIpnUriString(cs.m_bundleSourceEid, uuid.srcEid.nodeId, uuid.srcEid.serviceId)) {
-                            LOG_ERROR(subprocess) << "error custody signal with bad ipn string";
-                            return false;
-                        }
-                        uuid.creationSeconds = cs.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000;
-                        uuid.sequence = cs.m_copyOfBundleCreationTimestamp.sequenceNumber;
-                        uuid.fragmentOffset = cs.m_fragmentOffsetIfPresent;
-                        uuid.dataLength = cs.m_fragmentLengthIfPresent;
-                        custodyIdPtr = m_bsmPtr->GetCustodyIdFromUuid(uuid);
-                    }
-                    else {
-                        cbhe_bundle_uuid_nofragment_t uuid;
-                        if (!Uri::ParseIpnUriString(cs.m_bundleSourceEid, uuid.srcEid.nodeId, uuid.srcEid.serviceId)) {
-                            LOG_ERROR(subprocess) << "error custody signal with bad ipn string";
-                            return false;
-                        }
-                        uuid.creationSeconds = cs.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000;
-                        uuid.sequence = cs.m_copyOfBundleCreationTimestamp.sequenceNumber;
-                        custodyIdPtr = m_bsmPtr->GetCustodyIdFromUuid(uuid);
-                    }
-                    if (custodyIdPtr == NULL) {
-                        LOG_ERROR(subprocess) << "error custody signal does not match a bundle in the storage database";
+                    cbhe_bundle_uuid_t uuid;
+                    if (!Uri::ParseIpnUriString(cs.m_bundleSourceEid, uuid.srcEid.nodeId, uuid.srcEid.serviceId)) {
+                        LOG_ERROR(subprocess) << "error custody signal with bad ipn string";
                         return false;
                     }
-                    const uint64_t custodyIdFromRfc5050 = *custodyIdPtr;
-                    m_custodyIdAllocatorPtr->FreeCustodyId(custodyIdFromRfc5050);
-                    catalog_entry_t* catalogEntryPtr = m_bsmPtr->GetCatalogEntryPtrFromCustodyId(custodyIdFromRfc5050);
-                    if (catalogEntryPtr == NULL) {
-                        LOG_ERROR(subprocess) << "error finding catalog entry for bundle identified by rfc5050 custody signal";
-                        return false;
+                    uuid.creationSeconds = cs.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000;
+                    uuid.sequence = cs.m_copyOfBundleCreationTimestamp.sequenceNumber;
+                    uuid.fragmentOffset = (cs.m_isFragment) ? cs.m_fragmentOffsetIfPresent : 0;
+                    uuid.dataLength = (cs.m_isFragment) ? cs.m_fragmentLengthIfPresent : 0;
+                    if (catalogStageLinkPtr == NULL) {
+                        return ApplyRfc5050CustodyTransfer(uuid, cs.m_isFragment);
                     }
-                    if (!m_custodyTimersPtr->CancelCustodyTransferTimer(catalogEntryPtr->destEid, custodyIdFromRfc5050)) {
-                        LOG_WARNING(subprocess) << "notice: can't find custody timer associated with bundle identified by rfc5050 custody signal";
+                    else if (StageMessage* msgPtr = GetStageMessageForWrite(*catalogStageLinkPtr, StageMessage::TYPE::RFC5050_CUSTODY_TRANSFER)) {
+                        msgPtr->bundleUuid = uuid;
+                        msgPtr->isFragment = cs.m_isFragment;
+                        TakeAckToIngress(*msgPtr, ackToIngressPtr);
+                        CommitStageMessage(*catalogStageLinkPtr);
                     }
-                    if (!m_bsmPtr->RemoveReadBundleFromDisk(catalogEntryPtr, custodyIdFromRfc5050)) {
-                        LOG_ERROR(subprocess) << "error freeing bundle identified by rfc5050 custody signal from disk";
-                        return false;
-                    }
-                    ++forStats->m_totalBundlesErasedFromStorageWithCustodyTransfer;
-                    ++forStats->m_numRfc5050CustodyTransfers;
                 }
                 else {
                     LOG_ERROR(subprocess) << "error unknown admin record type";
@@ -506,23 +667,15 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
                 else {
                     if (m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()) {
                         const cbhe_eid_t& hdtnSrcEid = m_custodySignalRfc5050RenderedBundleView.m_primaryBlockView.header.m_sourceNodeId;
-                        const uint64_t newCustodyIdFor5050CustodySignal = m_custodyIdAllocatorPtr->GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
+                        const uint64_t newCustodyIdFor5050CustodySignal = GetNextCustodyId(hdtnSrcEid);
 
                         //write custody signal to disk
-                        BundleStorageManagerSession_WriteToDisk sessionWrite;
-                        const uint64_t totalSegmentsRequired = m_bsmPtr->Push(sessionWrite,
-                            m_custodySignalRfc5050RenderedBundleView.m_primaryBlockView.header,
-                            m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.size());
-                        if (totalSegmentsRequired == 0) {
-                            LOG_ERROR(subprocess) << "out of space for custody signal";
-                            return false;
-                        }
-
-                        const uint64_t totalBytesPushed = m_bsmPtr->PushAllSegments(sessionWrite, m_custodySignalRfc5050RenderedBundleView.m_primaryBlockView.header,
-                            newCustodyIdFor5050CustodySignal, (const uint8_t*)m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.data(),
-                            m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.size());
-                        if (totalBytesPushed != m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()) {
-                            LOG_ERROR(subprocess) << "totalBytesPushed != custodySignalRfc5050RenderedBundleView.m_renderedBundle.size()";
+                        zmq::message_t * noAckToIngressPtr = NULL;
+                        if (!WriteBundle(m_custodySignalRfc5050RenderedBundleView.m_primaryBlockView.header, newCustodyIdFor5050CustodySignal,
+                            (const uint8_t*)m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.data(),
+                            m_custodySignalRfc5050RenderedBundleView.m_renderedBundle.size(), catalogStageLinkPtr, noAckToIngressPtr))
+                        {
+                            LOG_ERROR(subprocess) << "unable to write custody signal";
                             return false;
                         }
                     }
@@ -531,7 +684,7 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
         }
 
         //write bundle (modified by hdtn if custody requested) to disk
-        return WriteBundle(primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size());
+        return WriteBundle(primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size(), catalogStageLinkPtr, ackToIngressPtr);
     }
     else if (isBpVersion7) {
         BundleViewV7 bv;
@@ -542,10 +695,10 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
         const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
         finalDestEidReturned = primary.m_destinationEid;
 
-        const uint64_t newCustodyId = m_custodyIdAllocatorPtr->GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+        const uint64_t newCustodyId = GetNextCustodyId(primary.m_sourceNodeId);
 
         //write bundle
-        return WriteBundle(primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size());
+        return WriteBundle(primary, newCustodyId, (const uint8_t*)bv.m_renderedBundle.data(), bv.m_renderedBundle.size(), catalogStageLinkPtr, ackToIngressPtr);
     }
     else {
         LOG_ERROR(subprocess) << "error in ZmqStorageInterface Write: unsupported bundle version detected";
@@ -555,7 +708,8 @@ bool ZmqStorageInterface::Impl::Write(zmq::message_t *message,
 }
 
 bool ZmqStorageInterface::Impl::WriteBundle(const PrimaryBlock& bundlePrimaryBlock,
-    const uint64_t newCustodyId, const uint8_t* allData, const std::size_t allDataSize)
+    const uint64_t newCustodyId, const uint8_t* allData, const std::size_t allDataSize,
+    StageLink * catalogStageLinkPtr, zmq::message_t *& ackToIngressPtr)
 {
     //write bundle
     BundleStorageManagerSession_WriteToDisk sessionWrite;
@@ -566,18 +720,113 @@ bool ZmqStorageInterface::Impl::WriteBundle(const PrimaryBlock& bundlePrimaryBlo
     }
     //totalSegmentsStoredOnDisk += totalSegmentsRequired;
     //totalBytesWrittenThisTest += size;
-    const uint64_t totalBytesPushed = m_bsmPtr->PushAllSegments(sessionWrite, bundlePrimaryBlock, newCustodyId, allData, allDataSize);
+    if (catalogStageLinkPtr == NULL) { //release stage owns the catalog
+        const uint64_t totalBytesPushed = m_bsmPtr->PushAllSegments(sessionWrite, bundlePrimaryBlock, newCustodyId, allData, allDataSize);
+        if (totalBytesPushed != allDataSize) {
+            LOG_ERROR(subprocess) << "totalBytesPushed != size";
+            return false;
+        }
+        return true;
+    }
+    const uint64_t totalBytesPushed = m_bsmPtr->PushAllSegmentsWithoutCatalog(sessionWrite, newCustodyId, allData, allDataSize);
     if (totalBytesPushed != allDataSize) {
         LOG_ERROR(subprocess) << "totalBytesPushed != size";
         return false;
     }
+    StageMessage* msgPtr = GetStageMessageForWrite(*catalogStageLinkPtr, StageMessage::TYPE::CATALOG_WRITTEN_BUNDLE);
+    if (msgPtr == NULL) {
+        LOG_ERROR(subprocess) << "storage stopping, bundle with custody id " << newCustodyId << " written to disk but not cataloged";
+        return false;
+    }
+    msgPtr->catalogEntry = std::move(sessionWrite.catalogEntry);
+    msgPtr->bundleUuid = bundlePrimaryBlock.GetCbheBundleUuidFromPrimary();
+    msgPtr->custodyId = newCustodyId;
+    TakeAckToIngress(*msgPtr, ackToIngressPtr);
+    CommitStageMessage(*catalogStageLinkPtr);
     return true;
 }
 
+ZmqStorageInterface::Impl::StageMessage* ZmqStorageInterface::Impl::GetStageMessageForWrite(StageLink & link, const StageMessage::TYPE type) {
+    static const boost::posix_time::time_duration fullQueueWaitTimeout = boost::posix_time::milliseconds(STORAGE_STAGE_QUEUE_FULL_WAIT_MILLISECONDS);
+    StageMessage* msgPtr;
+    while ((msgPtr = link.queue.GetSlotForWrite(fullQueueWaitTimeout)) == NULL) {
+        if (!m_stagesRunning) {
+            return NULL;
+        }
+    }
+    msgPtr->type = type;
+    msgPtr->hasAckToIngress = false;
+    return msgPtr;
+}
+
+void ZmqStorageInterface::Impl::CommitStageMessage(StageLink & link) {
+    if (link.queue.CommitWrite()) { //the consumer may be (or be about to be) blocked in zmq::poll
+        static const uint8_t wakeByte = 0;
+        if (!link.wakeConsumerSockPtr->send(zmq::const_buffer(&wakeByte, sizeof(wakeByte)), zmq::send_flags::dontwait)) {
+            //unread wake messages are already waiting for the consumer
+        }
+    }
+}
+
+void ZmqStorageInterface::Impl::TakeAckToIngress(StageMessage & msg, zmq::message_t *& ackToIngressPtr) {
+    if (ackToIngressPtr) {
+        msg.ackToIngress = std::move(*ackToIngressPtr);
+        msg.hasAckToIngress = true;
+        ackToIngressPtr = NULL;
+    }
+}
+
+void ZmqStorageInterface::Impl::PostAckToIngress(StageLink & link, zmq::message_t *& ackToIngressPtr) {
+    if (StageMessage* msgPtr = GetStageMessageForWrite(link, StageMessage::TYPE::ACK_TO_INGRESS_ONLY)) {
+        TakeAckToIngress(*msgPtr, ackToIngressPtr);
+        CommitStageMessage(link);
+    }
+}
+
+//release stage
+void ZmqStorageInterface::Impl::QueueAckToIngress(zmq::message_t & ackToIngress) {
+    m_acksToIngress.emplace_back();
+    memcpy(&m_acksToIngress.back(), ackToIngress.data(), sizeof(hdtn::StorageAckHdr));
+    ackToIngress.rebuild(); //release it now rather than when its owner is reused
+}
+
+//release stage: a single ack when idle, otherwise one batched ack message for everything queued
+void ZmqStorageInterface::Impl::FlushAcksToIngress() {
+    if (m_acksToIngress.empty()) {
+        return;
+    }
+    zmq::message_t zmqAckMessage;
+    if (m_acksToIngress.size() == 1) {
+        zmqAckMessage.rebuild(&m_acksToIngress[0], sizeof(hdtn::StorageAckHdr));
+    }
+    else {
+        const std::size_t acksSize = m_acksToIngress.size() * sizeof(hdtn::StorageAckHdr);
+        zmqAckMessage.rebuild(sizeof(hdtn::BatchHdr) + acksSize);
+        memcpy(hdtn::WriteBatchHdr(zmqAckMessage.data(), HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS, static_cast<uint32_t>(m_acksToIngress.size())),
+            m_acksToIngress.data(), acksSize);
+    }
+    if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(zmqAckMessage), zmq::send_flags::dontwait)) {
+        LOG_ERROR(subprocess) << "zmq could not send ingress " << m_acksToIngress.size() << " acks from storage";
+    }
+    else {
+        m_totalAcksToIngress += m_acksToIngress.size();
+        ++m_totalAckMessagesToIngress;
+    }
+    m_acksToIngress.clear();
+}
+
+static void DrainWakeSocket(zmq::socket_t & wakeSock) {
+    uint8_t wakeByte;
+    while (wakeSock.recv(zmq::mutable_buffer(&wakeByte, sizeof(wakeByte)), zmq::recv_flags::dontwait)) {}
+}
+
 
 //return number of bytes to read for specified links
-uint64_t ZmqStorageInterface::Impl::PeekOne(const std::vector<eid_plus_isanyserviceid_pair_t> & availableDestLinks) {
-    const uint64_t bytesToReadFromDisk = m_bsmPtr->PopTop(m_sessionRead, availableDestLinks);
+uint64_t ZmqStorageInterface::Impl::PeekOne(const OutductInfo_t& info) {
+    if (!info.readAheadQueue.empty()) {
+        return info.readAheadQueue.front()->catalogEntryPtr->bundleSizeBytes;
+    }
+    const uint64_t bytesToReadFromDisk = m_bsmPtr->PopTopFromReleaseIndex(m_sessionRead, info.releaseIndexId);
     if (bytesToReadFromDisk == 0) { //no more of these links to read
         return 0; //no bytes to read
     }
@@ -587,9 +836,6 @@ uint64_t ZmqStorageInterface::Impl::PeekOne(const std::vector<eid_plus_isanyserv
     return bytesToReadFromDisk;
 }
 
-static void CustomCleanupToEgressHdr(void *data, void *hint) {
-    delete static_cast<hdtn::ToEgressHdr*>(hint);
-}
 static void CustomCleanupStorageAckHdr(void *data, void *hint) {
     delete static_cast<hdtn::StorageAckHdr*>(hint);
 }
@@ -597,58 +843,113 @@ static void CustomCleanupStdVecUint8(void *data, void *hint) {
     delete static_cast<std::vector<uint8_t>*>(hint);
 }
 
-bool ZmqStorageInterface::Impl::ReleaseOne_NoBlock(const OutductInfo_t& info, const uint64_t outductIndex, const uint64_t maxBundleSizeToRead, uint64_t& returnedBundleSize)
-{
-    const uint64_t bytesToReadFromDisk = m_bsmPtr->PopTop(m_sessionRead, info.eidVec);
-    if (bytesToReadFromDisk == 0) { //no more of these links to read
+//release stage, returns false (leaving the bundle unmoved if the header could not be sent) if the bundle could not be sent
+bool ZmqStorageInterface::Impl::SendBundleToEgress(const hdtn::ToEgressHdr& toEgressHdr, zmq::message_t& bundle) {
+    if (m_bundleRingsPtr) {
+        bool needsWake = false;
+        if (!hdtn::PushToBundleRing(m_bundleRingsPtr->storageToEgress, toEgressHdr, bundle, needsWake)) {
+            return false;
+        }
+        if (needsWake && (!hdtn::SendBundleRingWake(*m_zmqPushSock_connectingStorageToBoundEgressPtr))) {
+            LOG_ERROR(subprocess) << "can't send bundle ring wake message, egress will drain the ring on its next poll timeout";
+        }
+        return true;
+    }
+    SharedMemoryBundleArena::Descriptor descriptor;
+    if (m_sharedMemoryToEgressArenaPtr && m_sharedMemoryToEgressArenaPtr->CopyIn(bundle, descriptor)) {
+        if (!SendSharedMemoryBundleToEgress(toEgressHdr, descriptor)) {
+            return false;
+        }
+        bundle.rebuild(); //its copy in the arena was sent
+        return true;
+    }
+    if (!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(zmq::const_buffer(&toEgressHdr, sizeof(hdtn::ToEgressHdr)), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
         return false;
     }
+    return static_cast<bool>(m_zmqPushSock_connectingStorageToBoundEgressPtr->send(std::move(bundle), zmq::send_flags::dontwait));
+}
 
-    //this link has a bundle in the fifo
-        
-
-    //IF YOU DECIDE YOU DON'T WANT TO READ THE BUNDLE AFTER PEEKING AT IT (MAYBE IT'S TOO BIG RIGHT NOW)
-    if (bytesToReadFromDisk > maxBundleSizeToRead) {
-        LOG_DEBUG(subprocess) << "bundle to read from disk (size=" << bytesToReadFromDisk << " bytes) is too large right now, exceeds " << maxBundleSizeToRead << " bytes";
-        m_bsmPtr->ReturnTop(m_sessionRead);
+//release stage, sends the descriptor of a bundle in the arena in place of the bundle, returns false (freeing the slot) if it could not be sent
+bool ZmqStorageInterface::Impl::SendSharedMemoryBundleToEgress(hdtn::ToEgressHdr toEgressHdr, const SharedMemoryBundleArena::Descriptor& descriptor) {
+    toEgressHdr.base.flags |= HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+    if ((!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(zmq::const_buffer(&toEgressHdr, sizeof(hdtn::ToEgressHdr)), zmq::send_flags::sndmore | zmq::send_flags::dontwait))
+        || (!m_sharedMemoryToEgressArenaPtr->SendDescriptor(*m_zmqPushSock_connectingStorageToBoundEgressPtr, descriptor, SharedMemoryBundleArena::PROCESS::EGRESS, zmq::send_flags::dontwait)))
+    {
+        m_sharedMemoryToEgressArenaPtr->Free(descriptor);
         return false;
-        //bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks); //get it back
     }
+    return true;
+}
+
+bool ZmqStorageInterface::Impl::ReleaseOne_NoBlock(OutductInfo_t& info, const uint64_t outductIndex, const uint64_t maxBundleSizeToRead, uint64_t& returnedBundleSize,
+    uint64_t& returnedCustodyId, const catalog_entry_t*& returnedCatalogEntryPtr)
+{
+    ReadAheadSessions::session_ptr_t readAheadSessionPtr;
+    uint64_t bytesToReadFromDisk;
+    if (!info.readAheadQueue.empty()) { //this link's next bundle is already being read
+        bytesToReadFromDisk = info.readAheadQueue.front()->catalogEntryPtr->bundleSizeBytes;
+        if (bytesToReadFromDisk > maxBundleSizeToRead) {
+            LOG_DEBUG(subprocess) << "bundle to read from disk (size=" << bytesToReadFromDisk << " bytes) is too large right now, exceeds " << maxBundleSizeToRead << " bytes";
+            return false; //remains next in the read-ahead queue
+        }
+        readAheadSessionPtr = std::move(info.readAheadQueue.front());
+        info.readAheadQueue.pop_front();
+        ++m_totalBundlesReleasedFromReadAhead;
+    }
+    else {
+        bytesToReadFromDisk = m_bsmPtr->PopTopFromReleaseIndex(m_sessionRead, info.releaseIndexId);
+        if (bytesToReadFromDisk == 0) { //no more of these links to read
+            return false;
+        }
+
+        //this link has a bundle in the fifo
+
+
+        //IF YOU DECIDE YOU DON'T WANT TO READ THE BUNDLE AFTER PEEKING AT IT (MAYBE IT'S TOO BIG RIGHT NOW)
+        if (bytesToReadFromDisk > maxBundleSizeToRead) {
+            LOG_DEBUG(subprocess) << "bundle to read from disk (size=" << bytesToReadFromDisk << " bytes) is too large right now, exceeds " << maxBundleSizeToRead << " bytes";
+            m_bsmPtr->ReturnTop(m_sessionRead);
+            return false;
+            //bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks); //get it back
+        }
+    }
+    BundleStorageManagerSession_ReadFromDisk & sessionRead = (readAheadSessionPtr) ? *readAheadSessionPtr : m_sessionRead;
         
-    std::vector<uint8_t> * vecUint8BundleDataRawPointer = new std::vector<uint8_t>();
-    const bool successReadAllSegments = m_bsmPtr->ReadAllSegments(m_sessionRead, *vecUint8BundleDataRawPointer);
-    zmq::message_t zmqBundleDataMessageWithDataStolen(vecUint8BundleDataRawPointer->data(), vecUint8BundleDataRawPointer->size(), CustomCleanupStdVecUint8, vecUint8BundleDataRawPointer);
+    //read the segment payloads straight into the message's pooled buffer, which is recycled once egress is done with the bundle,
+    //or (when the bundle goes to egress through the shared memory bundle arena) straight into an arena slot
+    SharedMemoryBundleArena::Descriptor descriptor;
+    uint8_t* const slotData = (m_sharedMemoryToEgressArenaPtr) ? m_sharedMemoryToEgressArenaPtr->Allocate(bytesToReadFromDisk, descriptor) : NULL;
+    zmq::message_t zmqBundleDataMessageWithDataStolen = (slotData) ? zmq::message_t() : m_releaseBufferPool.AllocateMessage(bytesToReadFromDisk);
+    const bool successReadAllSegments = m_bsmPtr->ReadAllSegments(sessionRead, (slotData) ? slotData : static_cast<uint8_t*>(zmqBundleDataMessageWithDataStolen.data()));
+    if (readAheadSessionPtr) { //no reads in flight, so back to the free list (sessionRead stays valid until the next ReadAhead reuses it)
+        m_readAheadSessions.Free(std::move(readAheadSessionPtr));
+    }
         
     if (!successReadAllSegments) {
         LOG_ERROR(subprocess) << "unable to read all segments from disk";
+        if (slotData) {
+            m_sharedMemoryToEgressArenaPtr->Free(descriptor);
+        }
         return false;
     }
 
 
-    //force natural/64-bit alignment
-    hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
-    zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
-
+    hdtn::ToEgressHdr toEgressHdr;
     //memset 0 not needed because all values set below
-    toEgressHdr->base.type = HDTN_MSGTYPE_EGRESS;
-    toEgressHdr->base.flags = 0;
-    toEgressHdr->nextHopNodeId = info.nextHopNodeId;
-    toEgressHdr->finalDestEid = m_sessionRead.catalogEntryPtr->destEid;
-    toEgressHdr->hasCustody = m_sessionRead.catalogEntryPtr->HasCustody();
-    toEgressHdr->isCutThroughFromIngress = 0;
-    toEgressHdr->isOpportunisticFromStorage = info.isOpportunisticLink;
-    toEgressHdr->isCutThroughFromStorage = 0;
-    toEgressHdr->custodyId = m_sessionRead.custodyId;
-    toEgressHdr->outductIndex = outductIndex;
+    toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+    toEgressHdr.base.flags = 0;
+    toEgressHdr.nextHopNodeId = info.nextHopNodeId;
+    toEgressHdr.finalDestEid = sessionRead.catalogEntryPtr->destEid;
+    toEgressHdr.hasCustody = sessionRead.catalogEntryPtr->HasCustody();
+    toEgressHdr.isCutThroughFromIngress = 0;
+    toEgressHdr.isOpportunisticFromStorage = info.isOpportunisticLink;
+    toEgressHdr.isCutThroughFromStorage = 0;
+    toEgressHdr.custodyId = sessionRead.custodyId;
+    toEgressHdr.outductIndex = outductIndex;
     
-    if (!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-        LOG_ERROR(subprocess) << "zmq could not send";
-        m_bsmPtr->ReturnTop(m_sessionRead);
-        return false;
-    }
-    if (!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(std::move(zmqBundleDataMessageWithDataStolen), zmq::send_flags::dontwait)) {
-        LOG_ERROR(subprocess) << "zmq could not send bundle";
-        m_bsmPtr->ReturnTop(m_sessionRead);
+    if (!((slotData) ? SendSharedMemoryBundleToEgress(toEgressHdr, descriptor) : SendBundleToEgress(toEgressHdr, zmqBundleDataMessageWithDataStolen))) {
+        LOG_ERROR(subprocess) << "could not send bundle to egress";
+        m_bsmPtr->ReturnTop(sessionRead);
         return false;
     }
     /*
@@ -662,10 +963,34 @@ bool ZmqStorageInterface::Impl::ReleaseOne_NoBlock(const OutductInfo_t& info, co
         */
         
     returnedBundleSize = bytesToReadFromDisk;
+    returnedCustodyId = sessionRead.custodyId;
+    returnedCatalogEntryPtr = sessionRead.catalogEntryPtr;
     return true;
 
 }
 
+//pop an up link's next bundles ahead of their release and start reading them from disk, so that
+//the link's outduct pipeline is refilled at disk throughput rather than at one disk latency per bundle
+//(their order may differ from PopTop's by bundles stored after they were popped)
+void ZmqStorageInterface::Impl::ReadAhead(OutductInfo_t& info) {
+    m_readAheadSessions.Fill(*m_bsmPtr, info.readAheadQueue, info.releaseIndexId);
+}
+
+//return the bundles read ahead for a link to the awaiting send (e.g. on link down), most recently popped first so that they keep their order
+void ZmqStorageInterface::Impl::ReturnReadAhead(OutductInfo_t& info) {
+    m_readAheadSessions.ReturnAll(*m_bsmPtr, info.readAheadQueue);
+}
+
+//drop a bundle about to be removed from storage (e.g. by a custody signal) from the read-ahead of whichever up link popped it,
+//so that no read is in flight into its freed segments and no read-ahead session is left pointing at its freed catalog entry
+void ZmqStorageInterface::Impl::CancelReadAhead(const uint64_t custodyId) {
+    for (std::size_t i = 0; i < m_vectorUpLinksOutductInfoPtrs.size(); ++i) {
+        if (m_readAheadSessions.Cancel(*m_bsmPtr, m_vectorUpLinksOutductInfoPtrs[i]->readAheadQueue, custodyId)) {
+            return; //popped by one link only
+        }
+    }
+}
+
 
 std::ostream& operator<<(std::ostream& os, const ZmqStorageInterface::Impl::OutductInfo_t& o) {
     os << "Currently " << ((o.linkIsUp) ? "" : "NOT")
@@ -684,21 +1009,44 @@ std::ostream& operator<<(std::ostream& os, const ZmqStorageInterface::Impl::Outd
     return os;
 }
 
+//also creates the storage release index of links that came up and deletes the release index of links that went down
 void ZmqStorageInterface::Impl::RepopulateUpLinksVec() {
     m_vectorUpLinksOutductInfoPtrs.clear();
     for (std::size_t i = 0; i < m_vectorOutductInfo.size(); ++i) {
         OutductInfo_t& info = *(m_vectorOutductInfo[i]);
         if (info.linkIsUp) {
+            if (info.releaseIndexId == 0) {
+                info.releaseIndexId = m_bsmPtr->CreateReleaseIndex(info.eidVec);
+            }
             m_vectorUpLinksOutductInfoPtrs.push_back(&info);
         }
+        else {
+            DeleteReleaseIndex(info);
+        }
     }
     for (std::map<uint64_t, OutductInfoPtr_t>::iterator it = m_mapOpportunisticNextHopNodeIdToOutductInfo.begin();
         it != m_mapOpportunisticNextHopNodeIdToOutductInfo.end(); ++it)
     {
         OutductInfo_t& info = *(it->second);
         if (info.linkIsUp) {
+            if (info.releaseIndexId == 0) {
+                info.releaseIndexId = m_bsmPtr->CreateReleaseIndex(info.eidVec);
+            }
             m_vectorUpLinksOutductInfoPtrs.push_back(&info);
         }
+        else {
+            DeleteReleaseIndex(info);
+        }
+    }
+}
+
+void ZmqStorageInterface::Impl::DeleteReleaseIndex(OutductInfo_t & info) {
+    ReturnReadAhead(info);
+    if (info.releaseIndexId) {
+        if (!m_bsmPtr->DeleteReleaseIndex(info.releaseIndexId)) {
+            LOG_ERROR(subprocess) << "unable to delete storage release index " << info.releaseIndexId;
+        }
+        info.releaseIndexId = 0;
     }
 }
 
@@ -709,12 +1057,11 @@ void ZmqStorageInterface::Impl::SetLinkDown(OutductInfo_t & info) {
             LOG_INFO(subprocess) << "Link down event dumping " << info.cutThroughQueue.size() << " queued cut-through bundles to disk";
             while (!info.cutThroughQueue.empty()) {
                 cbhe_eid_t finalDestEidReturnedFromWrite;
-                Write(&info.cutThroughQueue.front().bundleToEgress, finalDestEidReturnedFromWrite, this, true, true); //last true because if cut through then definitely no custody or not admin record
+                zmq::message_t* noAckToIngressPtr = NULL;
+                Write(&info.cutThroughQueue.front().bundleToEgress, finalDestEidReturnedFromWrite, true, true, NULL, noAckToIngressPtr); //true because if cut through then definitely no custody or not admin record
                 hdtn::StorageAckHdr* storageAckHdr = (hdtn::StorageAckHdr*)info.cutThroughQueue.front().ackToIngress.data();
                 storageAckHdr->error = 1;
-                if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(info.cutThroughQueue.front().ackToIngress), zmq::send_flags::dontwait)) {
-                    LOG_ERROR(subprocess) << "zmq could not send ingress an ack from storage";
-                }
+                QueueAckToIngress(info.cutThroughQueue.front().ackToIngress);
                 info.cutThroughQueue.pop();
             }
         }
@@ -723,6 +1070,279 @@ void ZmqStorageInterface::Impl::SetLinkDown(OutductInfo_t & info) {
     }
 }
 
+//release stage
+void ZmqStorageInterface::Impl::ProcessStageMessage(StageMessage & msg) {
+    if (msg.type == StageMessage::TYPE::CATALOG_WRITTEN_BUNDLE) {
+        if (!m_bsmPtr->CatalogPushedBundle(msg.catalogEntry, msg.bundleUuid, msg.custodyId)) {
+            LOG_ERROR(subprocess) << "unable to catalog written bundle with custody id " << msg.custodyId;
+        }
+    }
+    else if (msg.type == StageMessage::TYPE::CUT_THROUGH_BUNDLE) {
+        const hdtn::ToStorageHdr & toStorageHeader = msg.toStorageHdr;
+        if ((toStorageHeader.outductIndex < m_vectorOutductInfo.size()) //if outductIndex is UINT64_MAX then bundle needs stored
+            && m_vectorOutductInfo[toStorageHeader.outductIndex]->linkIsUp)
+        {
+            OutductInfo_t& info = *(m_vectorOutductInfo[toStorageHeader.outductIndex]);
+            info.cutThroughQueue.emplace(std::move(msg.bundle),
+                std::move(msg.ackToIngress), toStorageHeader.finalDestEid, toStorageHeader.ingressUniqueId);
+            msg.hasAckToIngress = false; //sent when egress acks the cut-through bundle
+        }
+        else {
+            cbhe_eid_t finalDestEidReturnedFromWrite;
+            zmq::message_t * noAckToIngressPtr = NULL;
+            Write(&msg.bundle, finalDestEidReturnedFromWrite, false, true, NULL, noAckToIngressPtr); //true because if cut through then definitely no custody or not admin record
+        }
+        msg.bundle.rebuild(); //release the bundle now rather than when the slot is reused
+    }
+    else if (msg.type == StageMessage::TYPE::ADD_OPPORTUNISTIC_LINK) {
+        const uint64_t nodeId = msg.toStorageHdr.ingressUniqueId;
+        
+        std::pair<std::map<uint64_t, OutductInfoPtr_t>::iterator, bool> ret = m_mapOpportunisticNextHopNodeIdToOutductInfo.
+#if (__cplusplus >= 201703L) //try_emplace would be most ideal so it doesnt create and destroy element if exists
+            try_emplace( 
+#else
+            emplace(
+#endif
+        nodeId, boost::make_unique<OutductInfo_t>());
+        //(true if insertion happened, false if it did not).
+        if (ret.second) {
+            OutductInfo_t& info = *(ret.first->second);
+            info.eidVec.resize(1);
+            const eid_plus_isanyserviceid_pair_t key(cbhe_eid_t(nodeId, 0), true); //true => any service id.. 0 is don't care
+            info.eidVec[0] = key;
+            info.nextHopNodeId = nodeId;
+            info.linkIsUp = true;
+            info.isOpportunisticLink = true;
+            info.maxBundlesInPipeline = 5; //TODO
+            info.maxBundleSizeBytesInPipeline = info.maxBundlesInPipeline * m_hdtnConfig.m_maxBundleSizeBytes;
+            RepopulateUpLinksVec();
+            LOG_INFO(subprocess) << "Adding Opportunistic link from ingress connection.. " << info;
+        }
+        else {
+            LOG_ERROR(subprocess) << "Ignoring Duplicate Message for adding Opportunistic link from ingress connection.. ";
+        }
+    }
+    else if (msg.type == StageMessage::TYPE::REMOVE_OPPORTUNISTIC_LINK) {
+        const uint64_t nodeId = msg.toStorageHdr.ingressUniqueId;
+        std::map<uint64_t, OutductInfoPtr_t>::iterator it = m_mapOpportunisticNextHopNodeIdToOutductInfo.find(nodeId);
+        const bool wasErased = (it != m_mapOpportunisticNextHopNodeIdToOutductInfo.end());
+        if (wasErased) {
+            DeleteReleaseIndex(*(it->second));
+            m_mapOpportunisticNextHopNodeIdToOutductInfo.erase(it);
+        }
+        if (wasErased) {
+            RepopulateUpLinksVec();
+        }
+        LOG_INFO(subprocess) << "Removing Opportunistic link from ingress connection.. finalDestEid ("
+            << Uri::GetIpnUriStringAnyServiceNumber(nodeId)
+            << ") will " << ((wasErased) ? "STOP" : "REMAIN STOPPED FROM") << " being released from storage";
+    }
+    else if (msg.type == StageMessage::TYPE::ACS_CUSTODY_TRANSFER) {
+        ApplyAcsCustodyTransfer(msg.custodyIdFills);
+    }
+    else if (msg.type == StageMessage::TYPE::RFC5050_CUSTODY_TRANSFER) {
+        ApplyRfc5050CustodyTransfer(msg.bundleUuid, msg.isFragment);
+    }
+    else if (msg.type != StageMessage::TYPE::ACK_TO_INGRESS_ONLY) {
+        LOG_ERROR(subprocess) << "release stage got unexpected stage message type " << static_cast<unsigned int>(msg.type);
+    }
+
+    if (msg.hasAckToIngress) {
+        msg.hasAckToIngress = false;
+        QueueAckToIngress(msg.ackToIngress);
+    }
+}
+
+//release stage, returns the number of messages processed
+std::size_t ZmqStorageInterface::Impl::ProcessStageMessages(StageLink & link) {
+    std::size_t numProcessed = 0;
+    //bounded so that egress acks and releases aren't starved by a busy writer stage
+    for (StageMessage* msgPtr; (numProcessed < STORAGE_STAGE_QUEUE_SIZE) && ((msgPtr = link.queue.GetSlotForRead()) != NULL); ++numProcessed) {
+        ProcessStageMessage(*msgPtr);
+        link.queue.CommitRead();
+    }
+    return numProcessed;
+}
+
+void ZmqStorageInterface::Impl::WriterStageThreadFunc() {
+    zmq::pollitem_t pollItems[1] = {
+        {m_zmqPullSock_boundIngressToConnectingStoragePtr->handle(), 0, ZMQ_POLLIN, 0}
+    };
+    std::size_t numBundlesWritten = 0;
+    while (m_stagesRunning) {
+        int rc = 0;
+        try {
+            rc = zmq::poll(pollItems, 1, DEFAULT_BIG_TIMEOUT_POLL);
+        }
+        catch (zmq::error_t & e) {
+            LOG_ERROR(subprocess) << "caught zmq::error_t in hdtn::ZmqStorageInterface::WriterStageThreadFunc: " << e.what();
+            continue;
+        }
+        if ((rc == 0) && m_bundleRingsPtr) { //a wake message is dropped if its socket is full, so also drain the ring on every poll timeout
+            numBundlesWritten += WriterStageProcessBundleRing();
+        }
+        if ((rc <= 0) || ((pollItems[0].revents & ZMQ_POLLIN) == 0)) {
+            continue;
+        }
+        //either a single or a batch of HDTN_MSGTYPE_STORE headers (each followed by its bundle frame), or an opportunistic link message
+        zmq::message_t zmqHeadersMessage;
+        const uint8_t* firstToStorageHdrPtr;
+        uint32_t numToStorageHdrs;
+        if (!m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmqHeadersMessage, zmq::recv_flags::none)) {
+            LOG_ERROR(subprocess) << "error in hdtn::ZmqStorageInterface::WriterStageThreadFunc (from ingress bundle data) message hdr not received";
+        }
+        else if ((numToStorageHdrs = hdtn::GetHeadersOfSingleOrBatchMessage<hdtn::ToStorageHdr>(zmqHeadersMessage.data(), zmqHeadersMessage.size(),
+            HDTN_MSGTYPE_STORE, HDTN_MSGTYPE_STORE_BATCH, firstToStorageHdrPtr)) != 0)
+        {
+            for (uint32_t i = 0; i < numToStorageHdrs; ++i) {
+                hdtn::ToStorageHdr toStorageHeader;
+                memcpy(&toStorageHeader, firstToStorageHdrPtr + (i * sizeof(hdtn::ToStorageHdr)), sizeof(hdtn::ToStorageHdr));
+                zmq::message_t zmqBundleDataReceived;
+                if (!m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmqBundleDataReceived, zmq::recv_flags::none)) {
+                    LOG_ERROR(subprocess) << "hdtn::ZmqStorageInterface::WriterStageThreadFunc (from ingress bundle data) message not received";
+                    break;
+                }
+                if (toStorageHeader.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) { //the frame is a descriptor of the bundle in the arena
+                    if ((!m_sharedMemoryBundleArenaPtr) || (!m_sharedMemoryBundleArenaPtr->DescriptorMessageToBundle(zmqBundleDataReceived))) {
+                        LOG_ERROR(subprocess) << "cannot get bundle from the shared memory bundle arena, this bundle will be lost";
+                        continue;
+                    }
+                    toStorageHeader.base.flags &= ~HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+                }
+                if (WriterStageProcessBundle(toStorageHeader, zmqBundleDataReceived)) {
+                    ++numBundlesWritten;
+                }
+            }
+        }
+        else if (m_bundleRingsPtr && hdtn::IsBundleRingWake(zmqHeadersMessage)) {
+            numBundlesWritten += WriterStageProcessBundleRing();
+        }
+        else if (zmqHeadersMessage.size() != sizeof(hdtn::ToStorageHdr)) {
+            LOG_ERROR(subprocess) << "error in hdtn::ZmqStorageInterface::WriterStageThreadFunc (from ingress bundle data) rhdr.size() != sizeof(hdtn::ToStorageHdr)";
+        }
+        else {
+            hdtn::ToStorageHdr toStorageHeader;
+            memcpy(&toStorageHeader, zmqHeadersMessage.data(), sizeof(hdtn::ToStorageHdr));
+            if ((toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK) || (toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_REMOVE_OPPORTUNISTIC_LINK)) {
+                if (StageMessage* msgPtr = GetStageMessageForWrite(m_writerToReleaseStageLink, (toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK) ?
+                    StageMessage::TYPE::ADD_OPPORTUNISTIC_LINK : StageMessage::TYPE::REMOVE_OPPORTUNISTIC_LINK))
+                {
+                    msgPtr->toStorageHdr = toStorageHeader;
+                    CommitStageMessage(m_writerToReleaseStageLink);
+                }
+            }
+            else {
+                LOG_ERROR(subprocess) << "hdtn::ZmqStorageInterface::WriterStageThreadFunc (from ingress bundle data) unknown message type";
+            }
+        }
+    }
+    LOG_DEBUG(subprocess) << "storage writer stage bundles written: " << numBundlesWritten;
+}
+
+//writer stage, returns the number of bundles from the ingress bundle ring written by this stage
+std::size_t ZmqStorageInterface::Impl::WriterStageProcessBundleRing() {
+    std::size_t numBundlesWritten = 0;
+    hdtn::ToStorageHdr toStorageHeader;
+    zmq::message_t zmqBundleDataReceived;
+    while (hdtn::PopFromBundleRing(m_bundleRingsPtr->ingressToStorage, toStorageHeader, zmqBundleDataReceived)) {
+        if (WriterStageProcessBundle(toStorageHeader, zmqBundleDataReceived)) {
+            ++numBundlesWritten;
+        }
+    }
+    return numBundlesWritten;
+}
+
+//writer stage, returns true if the bundle was written by this stage
+bool ZmqStorageInterface::Impl::WriterStageProcessBundle(const hdtn::ToStorageHdr & toStorageHeader, zmq::message_t & zmqBundleDataReceived) {
+    //ack message to ingress (sent by the release stage)
+    //force natural/64-bit alignment
+    hdtn::StorageAckHdr* storageAckHdr = new hdtn::StorageAckHdr();
+    zmq::message_t zmqMessageStorageAckHdrWithDataStolen(storageAckHdr, sizeof(hdtn::StorageAckHdr), CustomCleanupStorageAckHdr, storageAckHdr);
+
+    //memset 0 not needed because all values set below
+    storageAckHdr->base.type = HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS;
+    storageAckHdr->base.flags = 0;
+    storageAckHdr->error = 0;
+    storageAckHdr->ingressUniqueId = toStorageHeader.ingressUniqueId;
+    storageAckHdr->outductIndex = toStorageHeader.outductIndex;
+    zmq::message_t* ackToIngressPtr = &zmqMessageStorageAckHdrWithDataStolen;
+
+    if (toStorageHeader.dontStoreBundle) { //the release stage owns the outduct info, so it decides whether the link is still up
+        if (StageMessage* msgPtr = GetStageMessageForWrite(m_writerToReleaseStageLink, StageMessage::TYPE::CUT_THROUGH_BUNDLE)) {
+            msgPtr->toStorageHdr = toStorageHeader;
+            msgPtr->bundle = std::move(zmqBundleDataReceived);
+            TakeAckToIngress(*msgPtr, ackToIngressPtr);
+            CommitStageMessage(m_writerToReleaseStageLink);
+        }
+    }
+    else if (toStorageHeader.isCustodyOrAdminRecord) {
+        if (StageMessage* msgPtr = GetStageMessageForWrite(m_writerToCustodyStageLink, StageMessage::TYPE::CUSTODY_OR_ADMIN_BUNDLE)) {
+            msgPtr->bundle = std::move(zmqBundleDataReceived);
+            msgPtr->ackToIngress = std::move(zmqMessageStorageAckHdrWithDataStolen);
+            CommitStageMessage(m_writerToCustodyStageLink);
+        }
+    }
+    else {
+        cbhe_eid_t finalDestEidReturnedFromWrite;
+        Write(&zmqBundleDataReceived, finalDestEidReturnedFromWrite, false, true, &m_writerToReleaseStageLink, ackToIngressPtr);
+        if (ackToIngressPtr) { //write failed
+            PostAckToIngress(m_writerToReleaseStageLink, ackToIngressPtr);
+        }
+        return true;
+    }
+    return false;
+}
+
+void ZmqStorageInterface::Impl::CustodyStageThreadFunc() {
+    const uint64_t ACS_MAX_FILLS_PER_ACS_PACKET = m_hdtnConfig.m_acsMaxFillsPerAcsPacket;
+    const boost::posix_time::time_duration ACS_SEND_PERIOD = boost::posix_time::milliseconds(m_hdtnConfig.m_acsSendPeriodMilliseconds);
+    zmq::pollitem_t pollItems[1] = {
+        {m_zmqPullSock_wakeCustodyStagePtr->handle(), 0, ZMQ_POLLIN, 0}
+    };
+    long timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL; //0 => no blocking
+    boost::posix_time::ptime acsSendNowExpiry = boost::posix_time::microsec_clock::universal_time() + ACS_SEND_PERIOD;
+    while (m_stagesRunning) {
+        int rc = 0;
+        try {
+            rc = zmq::poll(pollItems, 1, timeoutPoll);
+        }
+        catch (zmq::error_t & e) {
+            LOG_ERROR(subprocess) << "caught zmq::error_t in hdtn::ZmqStorageInterface::CustodyStageThreadFunc: " << e.what();
+            continue;
+        }
+        if ((rc > 0) && (pollItems[0].revents & ZMQ_POLLIN)) {
+            DrainWakeSocket(*m_zmqPullSock_wakeCustodyStagePtr);
+        }
+        for (std::size_t numProcessed = 0; numProcessed < STORAGE_STAGE_QUEUE_SIZE; ++numProcessed) {
+            StageMessage* msgPtr = m_writerToCustodyStageLink.queue.GetSlotForRead();
+            if (msgPtr == NULL) {
+                break;
+            }
+            cbhe_eid_t finalDestEidReturnedFromWrite;
+            zmq::message_t* ackToIngressPtr = &msgPtr->ackToIngress;
+            Write(&msgPtr->bundle, finalDestEidReturnedFromWrite, false, false, &m_custodyToReleaseStageLink, ackToIngressPtr);
+            if (ackToIngressPtr) { //custody signal applied by this stage or write failed
+                PostAckToIngress(m_custodyToReleaseStageLink, ackToIngressPtr);
+            }
+            msgPtr->bundle.rebuild(); //release the bundle now rather than when the slot is reused
+            m_writerToCustodyStageLink.queue.CommitRead();
+        }
+
+        const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+        if ((acsSendNowExpiry <= nowPtime) || (m_ctmPtr->GetLargestNumberOfFills() > ACS_MAX_FILLS_PER_ACS_PACKET)) {
+            //test with generate all
+            std::list<BundleViewV6> newAcsRenderedBundleViewList;
+            if (m_ctmPtr->GenerateAllAcsBundlesAndClear(newAcsRenderedBundleViewList)) {
+                for(std::list<BundleViewV6>::iterator it = newAcsRenderedBundleViewList.begin(); it != newAcsRenderedBundleViewList.end(); ++it) {
+                    WriteAcsBundle(it->m_primaryBlockView.header, it->m_frontBuffer, &m_custodyToReleaseStageLink);
+                }
+            }
+            acsSendNowExpiry = nowPtime + ACS_SEND_PERIOD;
+        }
+        timeoutPoll = (m_writerToCustodyStageLink.queue.Size()) ? 0 : DEFAULT_BIG_TIMEOUT_POLL;
+    }
+}
+
 void ZmqStorageInterface::Impl::ThreadFunc() {
     
     
@@ -731,9 +1351,7 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
     m_custodyIdAllocatorPtr = boost::make_unique<CustodyIdAllocator>();
     m_custodyTimersPtr = boost::make_unique<CustodyTimers>(boost::posix_time::milliseconds(m_hdtnConfig.m_retransmitBundleAfterNoCustodySignalMilliseconds));
     const bool IS_HDTN_ACS_AWARE = m_hdtnConfig.m_isAcsAware;
-    const uint64_t ACS_MAX_FILLS_PER_ACS_PACKET = m_hdtnConfig.m_acsMaxFillsPerAcsPacket;
     
-    static const boost::posix_time::time_duration ACS_SEND_PERIOD = boost::posix_time::milliseconds(m_hdtnConfig.m_acsSendPeriodMilliseconds);
     m_ctmPtr = boost::make_unique<CustodyTransferManager>(IS_HDTN_ACS_AWARE, M_HDTN_EID_CUSTODY.nodeId, M_HDTN_EID_CUSTODY.serviceId);
     LOG_INFO(subprocess) << "Worker thread starting up.";
 
@@ -749,6 +1367,12 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
         LOG_INFO(subprocess) << "[ZmqStorageInterface] Initializing BundleStorageManagerAsio ... ";
         m_bsmPtr = boost::make_unique<BundleStorageManagerAsio>(std::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
     }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+    else if (m_hdtnConfig.m_storageConfig.m_storageImplementation == "io_uring") {
+        LOG_INFO(subprocess) << "[ZmqStorageInterface] Initializing BundleStorageManagerIoUring ... ";
+        m_bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(std::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
+    }
+#endif
     else {
         LOG_ERROR(subprocess) << "error in hdtn::ZmqStorageInterface::ThreadFunc: invalid storage implementation " << m_hdtnConfig.m_storageConfig.m_storageImplementation;
         return;
@@ -764,6 +1388,11 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
     m_numRfc5050CustodyTransfers = 0;
     m_numAcsCustodyTransfers = 0;
     m_numAcsPacketsReceived = 0;
+    m_totalBundlesExpiredFromStorage = 0;
+    m_totalBytesReclaimedFromExpiredBundles = 0;
+    m_totalBundlesReleasedFromReadAhead = 0;
+    m_totalAcksToIngress = 0;
+    m_totalAckMessagesToIngress = 0;
     std::size_t totalEventsNoDataInStorageForAvailableLinks = 0;
     std::size_t totalEventsDataInStorageForCloggedLinks = 0;
     std::size_t numCustodyTransferTimeouts = 0;
@@ -779,14 +1408,19 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
 
     zmq::pollitem_t pollItems[5] = {
         {m_zmqPullSock_boundEgressToConnectingStoragePtr->handle(), 0, ZMQ_POLLIN, 0},
-        {m_zmqPullSock_boundIngressToConnectingStoragePtr->handle(), 0, ZMQ_POLLIN, 0},
+        {m_zmqPullSock_wakeReleaseStagePtr->handle(), 0, ZMQ_POLLIN, 0},
         {m_zmqSubSock_boundReleaseToConnectingStoragePtr->handle(), 0, ZMQ_POLLIN, 0},
         {m_zmqRepSock_connectingGuiToFromBoundStoragePtr->handle(), 0, ZMQ_POLLIN, 0},
         {m_zmqRepSock_connectingUisToFromBoundStoragePtr->handle(), 0, ZMQ_POLLIN, 0}
     };
-    static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
     long timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL; //0 => no blocking
-    boost::posix_time::ptime acsSendNowExpiry = boost::posix_time::microsec_clock::universal_time() + ACS_SEND_PERIOD;
+    boost::posix_time::ptime expiredBundleReaperNextRun = boost::posix_time::microsec_clock::universal_time();
+    std::vector<std::pair<uint64_t, cbhe_eid_t> > reapedCustodyIdsAndDestEids;
+    m_stagesRunning = true;
+    m_writerStageThreadPtr = boost::make_unique<boost::thread>(
+        boost::bind(&ZmqStorageInterface::Impl::WriterStageThreadFunc, this)); //create and start the writer stage thread
+    m_custodyStageThreadPtr = boost::make_unique<boost::thread>(
+        boost::bind(&ZmqStorageInterface::Impl::CustodyStageThreadFunc, this)); //create and start the custody stage thread
     m_threadStartupComplete = true;
     while (m_running) {
         int rc = 0;
@@ -844,9 +1478,7 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                                         hdtn::StorageAckHdr* storageAckHdr = (hdtn::StorageAckHdr*)it->second.ackToIngress.data();
                                         storageAckHdr->error = 1;
                                     }
-                                    if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(it->second.ackToIngress), zmq::send_flags::dontwait)) {
-                                        LOG_ERROR(subprocess) << "zmq could not send ingress a cut-through ack from storage";
-                                    }
+                                    QueueAckToIngress(it->second.ackToIngress);
                                     info.bytesInPipeline -= it->second.bundleSizeBytes;
                                     mapIdToAckData.erase(it);
                                 }
@@ -903,7 +1535,8 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                     }
                     else {
                         cbhe_eid_t finalDestEidReturnedFromWrite;
-                        Write(&zmqBundleDataReceived, finalDestEidReturnedFromWrite, this, true, true); //last true because if cut through then definitely no custody or not admin record
+                        zmq::message_t* noAckToIngressPtr = NULL;
+                        Write(&zmqBundleDataReceived, finalDestEidReturnedFromWrite, true, true, NULL, noAckToIngressPtr); //true because if cut through then definitely no custody or not admin record
                         ++m_totalBundlesRewrittenToStorageFromFailedEgressSend;
                         finalDestEidReturnedFromWrite.serviceId = 0;
                         if (egressFullyInitialized) {
@@ -956,6 +1589,7 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                                 //outductInfo.linkIsUp = false; set by constructor
                                 //outductInfo.bytesInPipeline set to zero by constructor (initialized when vector.resize()
                                 outductInfo.isOpportunisticLink = false;
+                                DeleteReleaseIndex(outductInfo); //final destinations may have changed, so recreated by RepopulateUpLinksVec() below
                                 outductInfo.eidVec.clear();
                                 outductInfo.eidVec.reserve(oct.finalDestinationEidList.size() + oct.finalDestinationNodeIdList.size());
                                 for (std::list<cbhe_eid_t>::const_iterator it = oct.finalDestinationEidList.cbegin(); it != oct.finalDestinationEidList.cend(); ++it) {
@@ -1004,100 +1638,8 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                     LOG_ERROR(subprocess) << "EgressAckHdr unknown type, got " << egressAckHdr.base.type;
                 }
             }
-            if (pollItems[1].revents & ZMQ_POLLIN) { //from ingress bundle data
-                hdtn::ToStorageHdr toStorageHeader;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmq::mutable_buffer(&toStorageHeader, sizeof(hdtn::ToStorageHdr)), zmq::recv_flags::none);
-                if (!res) {
-                    LOG_ERROR(subprocess) << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message hdr not received";
-                }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::ToStorageHdr))) {
-                    LOG_ERROR(subprocess) << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) rhdr.size() != sizeof(hdtn::ToStorageHdr)";
-                }
-                else if (toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK) {
-                    const uint64_t nodeId = toStorageHeader.ingressUniqueId;
-                    
-                    std::pair<std::map<uint64_t, OutductInfoPtr_t>::iterator, bool> ret = m_mapOpportunisticNextHopNodeIdToOutductInfo.
-#if (__cplusplus >= 201703L) //try_emplace would be most ideal so it doesnt create and destroy element if exists
-                        try_emplace( 
-#else
-                        emplace(
-#endif
-                    nodeId, boost::make_unique<OutductInfo_t>());
-                    //(true if insertion happened, false if it did not).
-                    if (ret.second) {
-                        OutductInfo_t& info = *(ret.first->second);
-                        info.eidVec.resize(1);
-                        const eid_plus_isanyserviceid_pair_t key(cbhe_eid_t(nodeId, 0), true); //true => any service id.. 0 is don't care
-                        info.eidVec[0] = key;
-                        info.nextHopNodeId = nodeId;
-                        info.linkIsUp = true;
-                        info.isOpportunisticLink = true;
-                        info.maxBundlesInPipeline = 5; //TODO
-                        info.maxBundleSizeBytesInPipeline = info.maxBundlesInPipeline * m_hdtnConfig.m_maxBundleSizeBytes;
-                        RepopulateUpLinksVec();
-                        LOG_INFO(subprocess) << "Adding Opportunistic link from ingress connection.. " << info;
-                    }
-                    else {
-                        LOG_ERROR(subprocess) << "Ignoring Duplicate Message for adding Opportunistic link from ingress connection.. ";
-                    }
-                }
-                else if (toStorageHeader.base.type == HDTN_MSGTYPE_STORAGE_REMOVE_OPPORTUNISTIC_LINK) {
-                    const uint64_t nodeId = toStorageHeader.ingressUniqueId;
-                    const bool wasErased = (m_mapOpportunisticNextHopNodeIdToOutductInfo.erase(nodeId) == 1);
-                    if (wasErased) {
-                        RepopulateUpLinksVec();
-                    }
-                    LOG_INFO(subprocess) << "Removing Opportunistic link from ingress connection.. finalDestEid ("
-                        << Uri::GetIpnUriStringAnyServiceNumber(nodeId)
-                        << ") will " << ((wasErased) ? "STOP" : "REMAIN STOPPED FROM") << " being released from storage";
-                }
-                else if (toStorageHeader.base.type == HDTN_MSGTYPE_STORE) {
-                    //storageStats.inBytes += sizeof(hdtn::ToStorageHdr);
-                    //++storageStats.inMsg;
-
-                    zmq::message_t zmqBundleDataReceived;
-                    if (!m_zmqPullSock_boundIngressToConnectingStoragePtr->recv(zmqBundleDataReceived, zmq::recv_flags::none)) {
-                        LOG_ERROR(subprocess) << "hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message not received";
-                    }
-                    else {
-                        //send ack message to ingress
-                        //force natural/64-bit alignment
-                        hdtn::StorageAckHdr* storageAckHdr = new hdtn::StorageAckHdr();
-                        zmq::message_t zmqMessageStorageAckHdrWithDataStolen(storageAckHdr, sizeof(hdtn::StorageAckHdr), CustomCleanupStorageAckHdr, storageAckHdr);
-
-                        //memset 0 not needed because all values set below
-                        storageAckHdr->base.type = HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS;
-                        storageAckHdr->base.flags = 0;
-                        storageAckHdr->error = 0;
-                        storageAckHdr->ingressUniqueId = toStorageHeader.ingressUniqueId;
-                        storageAckHdr->outductIndex = toStorageHeader.outductIndex;
-
-                        if ((toStorageHeader.dontStoreBundle)
-                            && (toStorageHeader.outductIndex < m_vectorOutductInfo.size()) //if outductIndex is UINT64_MAX then bundle needs stored
-                            && m_vectorOutductInfo[toStorageHeader.outductIndex]->linkIsUp)
-                        {
-                            OutductInfo_t& info = *(m_vectorOutductInfo[toStorageHeader.outductIndex]);
-                            info.cutThroughQueue.emplace(std::move(zmqBundleDataReceived),
-                                std::move(zmqMessageStorageAckHdrWithDataStolen), toStorageHeader.finalDestEid, toStorageHeader.ingressUniqueId);
-                        }
-                        else {
-                            //storageStats.inBytes += zmqBundleDataReceived.size();
-
-                            cbhe_eid_t finalDestEidReturnedFromWrite;
-                            const bool isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord = (toStorageHeader.isCustodyOrAdminRecord == 0);
-                            Write(&zmqBundleDataReceived, finalDestEidReturnedFromWrite, this, false, isCertainThatThisBundleHasNoCustodyOrIsNotAdminRecord);
-
-                            //storageAckHdr->finalDestEid = finalDestEidReturnedFromWrite; //no longer needed as ingress decodes that
-
-                            if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(zmqMessageStorageAckHdrWithDataStolen), zmq::send_flags::dontwait)) {
-                                LOG_ERROR(subprocess) << "zmq could not send ingress an ack from storage";
-                            }
-                        }
-                    }
-                }
-                else {
-                    LOG_ERROR(subprocess) << "hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) unknown message type";
-                }
+            if (pollItems[1].revents & ZMQ_POLLIN) { //the writer or custody stage posted messages
+                DrainWakeSocket(*m_zmqPullSock_wakeReleaseStagePtr);
             }
             if (pollItems[2].revents & ZMQ_POLLIN) { //release messages
                 hdtn::IreleaseChangeHdr releaseChangeHdr;
@@ -1167,6 +1709,12 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                     StorageTelemetry_t telem;
                     telem.totalBundlesErasedFromStorage = GetCurrentNumberOfBundlesDeletedFromStorage();
                     telem.totalBundlesSentToEgressFromStorage = m_totalBundlesSentToEgressFromStorageReadFromDisk; //+ m_totalBundlesSentToEgressFromStorageForwardCutThrough;
+                    telem.totalBundlesExpiredFromStorage = m_totalBundlesExpiredFromStorage;
+                    telem.totalBytesReclaimedFromExpiredBundles = m_totalBytesReclaimedFromExpiredBundles;
+                    telem.hotTierHits = m_bsmPtr->GetNumHotTierHits();
+                    telem.hotTierMisses = m_bsmPtr->GetNumHotTierMisses();
+                    telem.hotTierEvictions = m_bsmPtr->GetNumHotTierEvictions();
+                    telem.hotTierWriteBacksCancelled = m_bsmPtr->GetNumHotTierWriteBacksCancelled();
 
                     std::vector<uint8_t>* vecUint8RawPointer = new std::vector<uint8_t>(sizeof(StorageTelemetry_t)); //will be 64-bit aligned
                     uint8_t* telemPtr = vecUint8RawPointer->data();
@@ -1265,17 +1813,6 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
         }
 
         const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
-        if ((acsSendNowExpiry <= nowPtime) || (m_ctmPtr->GetLargestNumberOfFills() > ACS_MAX_FILLS_PER_ACS_PACKET)) {
-            //test with generate all
-            std::list<BundleViewV6> newAcsRenderedBundleViewList;
-            if (m_ctmPtr->GenerateAllAcsBundlesAndClear(newAcsRenderedBundleViewList)) {
-                for(std::list<BundleViewV6>::iterator it = newAcsRenderedBundleViewList.begin(); it != newAcsRenderedBundleViewList.end(); ++it) {
-                    WriteAcsBundle(it->m_primaryBlockView.header, it->m_frontBuffer);
-                }
-            }
-            acsSendNowExpiry = nowPtime + ACS_SEND_PERIOD;
-        }
-
         uint64_t custodyIdExpiredAndNeedingResent;
         while (m_custodyTimersPtr->PollOneAndPopAnyExpiredCustodyTimer(custodyIdExpiredAndNeedingResent, nowPtime)) {
             if (m_bsmPtr->ReturnCustodyIdToAwaitingSend(custodyIdExpiredAndNeedingResent)) {
@@ -1286,6 +1823,29 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
             }
         }
 
+        //catalog the bundles written and apply the custody signals received by the writer and custody stages
+        //before releasing, so that they may be released this time around the loop
+        ProcessStageMessages(m_writerToReleaseStageLink);
+        ProcessStageMessages(m_custodyToReleaseStageLink);
+        FlushAcksToIngress(); //everything acked this time around the loop goes to ingress in one message
+
+        //incrementally delete the bundles awaiting send whose lifetimes have passed, so that a long disconnection
+        //doesn't fill the disks with dead bundles (bundles in the egress pipeline are left alone)
+        if (expiredBundleReaperNextRun <= nowPtime) {
+            m_totalBytesReclaimedFromExpiredBundles += m_bsmPtr->ReapExpiredBundles(TimestampUtil::GetSecondsSinceEpochRfc5050(nowPtime),
+                EXPIRED_BUNDLE_REAPER_MAX_BUNDLES_PER_BATCH, reapedCustodyIdsAndDestEids);
+            for (std::size_t i = 0; i < reapedCustodyIdsAndDestEids.size(); ++i) {
+                m_custodyTimersPtr->CancelCustodyTransferTimer(reapedCustodyIdsAndDestEids[i].second, reapedCustodyIdsAndDestEids[i].first);
+            }
+            m_totalBundlesExpiredFromStorage += reapedCustodyIdsAndDestEids.size();
+            if (reapedCustodyIdsAndDestEids.size() < EXPIRED_BUNDLE_REAPER_MAX_BUNDLES_PER_BATCH) {
+                expiredBundleReaperNextRun = nowPtime + boost::posix_time::milliseconds(EXPIRED_BUNDLE_REAPER_PERIOD_MILLISECONDS);
+            } //else full batch, so continue next time around the loop
+        }
+
+        //bundles not yet released or deleted from the RAM hot tier (if enabled) are written to disk after a while
+        m_bsmPtr->WriteBackAgedHotTierBundles();
+
         //For each outduct or opportunistic induct, send to Egress the bundles read from disk or the
         //bundles forwarded over the cut-through path from ingress, alternating/multiplexing between the two.
         //Maintain up to that outduct's own sending pipeline limit,
@@ -1309,34 +1869,30 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
             const std::size_t totalInPipelineStorageToEgressThisLink = info.mapOpenCustodyIdToBundleSizeBytes.size() + info.mapIngressUniqueIdToIngressAckData.size();
             const uint64_t maxBundleSizeToRead = info.maxBundleSizeBytesInPipeline - info.bytesInPipeline;
             uint64_t returnedBundleSizeReadFromDisk;
+            uint64_t releasedCustodyId;
+            const catalog_entry_t* releasedCatalogEntryPtr;
             if (totalInPipelineStorageToEgressThisLink < info.maxBundlesInPipeline) { //not clogged by bundle count in pipeline
                 if (info.stateTryCutThrough && (!info.cutThroughQueue.empty())
                     && (info.cutThroughQueue.front().bundleToEgress.size() <= maxBundleSizeToRead))
                 { //not clogged by bundle total bytes in pipeline
                     CutThroughQueueData& qd = info.cutThroughQueue.front();
                     
-                    //force natural/64-bit alignment
-                    hdtn::ToEgressHdr* toEgressHdr = new hdtn::ToEgressHdr();
-                    zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
-
+                    hdtn::ToEgressHdr toEgressHdr;
                     //memset 0 not needed because all values set below
-                    toEgressHdr->base.type = HDTN_MSGTYPE_EGRESS;
-                    toEgressHdr->base.flags = 0;
-                    toEgressHdr->nextHopNodeId = info.nextHopNodeId;
-                    toEgressHdr->finalDestEid = qd.finalDestEid;
-                    toEgressHdr->hasCustody = 0;
-                    toEgressHdr->isCutThroughFromIngress = 0;
-                    toEgressHdr->isOpportunisticFromStorage = info.isOpportunisticLink;
-                    toEgressHdr->isCutThroughFromStorage = 1;
-                    toEgressHdr->custodyId = qd.ingressUniqueId;
-                    toEgressHdr->outductIndex = lastIndexToUpLinkVectorOutductInfoRoundRobin;
+                    toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+                    toEgressHdr.base.flags = 0;
+                    toEgressHdr.nextHopNodeId = info.nextHopNodeId;
+                    toEgressHdr.finalDestEid = qd.finalDestEid;
+                    toEgressHdr.hasCustody = 0;
+                    toEgressHdr.isCutThroughFromIngress = 0;
+                    toEgressHdr.isOpportunisticFromStorage = info.isOpportunisticLink;
+                    toEgressHdr.isCutThroughFromStorage = 1;
+                    toEgressHdr.custodyId = qd.ingressUniqueId;
+                    toEgressHdr.outductIndex = lastIndexToUpLinkVectorOutductInfoRoundRobin;
 
                     const uint64_t bundleSizeBytes = qd.bundleToEgress.size(); //capture before move
 
-                    if (!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-                        LOG_ERROR(subprocess) << "could not forward header of cut-through bundle to egress";
-                    }
-                    else if (!m_zmqPushSock_connectingStorageToBoundEgressPtr->send(std::move(qd.bundleToEgress), zmq::send_flags::dontwait)) {
+                    if (!SendBundleToEgress(toEgressHdr, qd.bundleToEgress)) {
                         LOG_ERROR(subprocess) << "could not forward cut-through bundle to egress";
                     }
                     //with cut through bundles, don't send an ack to ingress until fully sent confirmation ack from egress, hence the map below to defer that
@@ -1354,10 +1910,12 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                     }
                     info.cutThroughQueue.pop();
                 }
-                else if (ReleaseOne_NoBlock(info, lastIndexToUpLinkVectorOutductInfoRoundRobin, maxBundleSizeToRead, returnedBundleSizeReadFromDisk)) { //true => (successfully sent to egress)
-                    if (info.mapOpenCustodyIdToBundleSizeBytes.emplace(m_sessionRead.custodyId, returnedBundleSizeReadFromDisk).second) {
-                        if (m_sessionRead.catalogEntryPtr->HasCustody()) {
-                            m_custodyTimersPtr->StartCustodyTransferTimer(m_sessionRead.catalogEntryPtr->destEid, m_sessionRead.custodyId);
+                else if (ReleaseOne_NoBlock(info, lastIndexToUpLinkVectorOutductInfoRoundRobin, maxBundleSizeToRead, returnedBundleSizeReadFromDisk,
+                    releasedCustodyId, releasedCatalogEntryPtr)) //true => (successfully sent to egress)
+                {
+                    if (info.mapOpenCustodyIdToBundleSizeBytes.emplace(releasedCustodyId, returnedBundleSizeReadFromDisk).second) {
+                        if (releasedCatalogEntryPtr->HasCustody()) {
+                            m_custodyTimersPtr->StartCustodyTransferTimer(releasedCatalogEntryPtr->destEid, releasedCustodyId);
                         }
                         info.bytesInPipeline += returnedBundleSizeReadFromDisk;
                         timeoutPoll = 0; //no timeout as we need to keep feeding to egress
@@ -1373,7 +1931,7 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                 break; //return to zmq loop with zero timeout
             }
             else if (timeoutPoll != shortestTimeoutPoll1Ms) { //potentially clogged
-                if (PeekOne(info.eidVec) > 0) { //data available in storage for clogged links
+                if (PeekOne(info) > 0) { //data available in storage for clogged links
                     timeoutPoll = shortestTimeoutPoll1Ms; //shortest timeout 1ms as we wait for acks
                     ++totalEventsDataInStorageForCloggedLinks;
                 }
@@ -1383,7 +1941,24 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
                 }
             }
         }
+        for (std::size_t i = 0; i < m_vectorUpLinksOutductInfoPtrs.size(); ++i) {
+            ReadAhead(*(m_vectorUpLinksOutductInfoPtrs[i])); //refill what was just released, or start on links that came up
+        }
+        if (m_writerToReleaseStageLink.queue.Size() || m_custodyToReleaseStageLink.queue.Size()) {
+            timeoutPoll = 0; //more than one batch was posted, the wake messages are already drained
+        }
+    }
+    for (std::size_t i = 0; i < m_vectorUpLinksOutductInfoPtrs.size(); ++i) {
+        ReturnReadAhead(*(m_vectorUpLinksOutductInfoPtrs[i]));
     }
+    m_stagesRunning = false;
+    m_writerStageThreadPtr->join();
+    m_writerStageThreadPtr.reset(); //delete it
+    m_custodyStageThreadPtr->join();
+    m_custodyStageThreadPtr.reset(); //delete it
+    //catalog the bundles already written to disk so that they survive in the catalog journal
+    while (ProcessStageMessages(m_writerToReleaseStageLink) + ProcessStageMessages(m_custodyToReleaseStageLink)) {}
+    FlushAcksToIngress();
     LOG_DEBUG(subprocess) << "Storage bundles sent: FromDisk=" << m_totalBundlesSentToEgressFromStorageReadFromDisk
         << "  FromCutThroughForward=" << m_totalBundlesSentToEgressFromStorageForwardCutThrough;
     LOG_DEBUG(subprocess) << "totalEventsNoDataInStorageForAvailableLinks: " << totalEventsNoDataInStorageForAvailableLinks;
@@ -1391,6 +1966,16 @@ void ZmqStorageInterface::Impl::ThreadFunc() {
     LOG_DEBUG(subprocess) << "m_numRfc5050CustodyTransfers: " << m_numRfc5050CustodyTransfers;
     LOG_DEBUG(subprocess) << "m_numAcsCustodyTransfers: " << m_numAcsCustodyTransfers;
     LOG_DEBUG(subprocess) << "m_numAcsPacketsReceived: " << m_numAcsPacketsReceived;
+    LOG_DEBUG(subprocess) << "m_totalBundlesExpiredFromStorage: " << m_totalBundlesExpiredFromStorage
+        << "  bytes reclaimed: " << m_totalBytesReclaimedFromExpiredBundles;
+    LOG_DEBUG(subprocess) << "hot tier hits: " << m_bsmPtr->GetNumHotTierHits()
+        << "  misses: " << m_bsmPtr->GetNumHotTierMisses()
+        << "  evictions: " << m_bsmPtr->GetNumHotTierEvictions()
+        << "  write backs cancelled: " << m_bsmPtr->GetNumHotTierWriteBacksCancelled();
+    LOG_DEBUG(subprocess) << "m_totalBundlesReleasedFromReadAhead: " << m_totalBundlesReleasedFromReadAhead;
+    LOG_DEBUG(subprocess) << "acks to ingress: " << m_totalAcksToIngress << "  in messages: " << m_totalAckMessagesToIngress;
+    LOG_DEBUG(subprocess) << "release buffers allocated: " << m_releaseBufferPool.GetNumBuffersAllocated()
+        << "  reused: " << m_releaseBufferPool.GetNumBuffersReused();
     LOG_DEBUG(subprocess) << "m_totalBundlesErasedFromStorageNoCustodyTransfer: " << m_totalBundlesErasedFromStorageNoCustodyTransfer;
     LOG_DEBUG(subprocess) << "m_totalBundlesErasedFromStorageWithCustodyTransfer: " << m_totalBundlesErasedFromStorageWithCustodyTransfer;
     LOG_DEBUG(subprocess) << "numCustodyTransferTimeouts: " << numCustodyTransferTimeouts;
@@ -15,6 +15,9 @@
 #include <string>
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+#include "BundleStorageManagerIoUring.h"
+#endif
 #include <boost/make_unique.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
@@ -57,7 +60,7 @@ struct TestFile {
 //two days
 #define NUMBER_OF_EXPIRATIONS (86400*2)
 
-bool TestSpeed(BundleStorageManagerBase & bsm) {
+bool TestSpeed(BundleStorageManagerBase & bsm, double & gigaBitsPerSecReadAvg, double & gigaBitsPerSecWriteAvg) {
     boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
     const boost::random::uniform_int_distribution<> distLinkId(0, 9);
     const boost::random::uniform_int_distribution<> distFileId(0, 9);
@@ -65,8 +68,6 @@ bool TestSpeed(BundleStorageManagerBase & bsm) {
     const boost::random::uniform_int_distribution<> distAbsExpiration(0, NUMBER_OF_EXPIRATIONS - 1);
     const boost::random::uniform_int_distribution<> distTotalBundleSize(1, 65536);
 
-    g_sigHandler.Start();
-
     static const cbhe_eid_t DEST_LINKS[10] = {
         cbhe_eid_t(1,1),
         cbhe_eid_t(2,1),
@@ -185,7 +186,7 @@ bool TestSpeed(BundleStorageManagerBase & bsm) {
                 std::vector<boost::uint8_t> dataReadBack(bytesToReadFromDisk);
                 TestFile & originalFile = *fileMap[bytesToReadFromDisk];
 
-                const std::size_t numSegmentsToRead = sessionRead.catalogEntryPtr->segmentIdChainVec.size();
+                const std::size_t numSegmentsToRead = sessionRead.catalogEntryPtr->GetNumSegments();
                 bsm.ReadAllSegments(sessionRead, dataReadBack);
                 const std::size_t totalBytesRead = dataReadBack.size();
                 
@@ -214,24 +215,65 @@ bool TestSpeed(BundleStorageManagerBase & bsm) {
         }
     }
 
+    gigaBitsPerSecReadAvg = gigaBitsPerSecReadDoubleAvg / NUM_TESTS;
+    gigaBitsPerSecWriteAvg = gigaBitsPerSecWriteDoubleAvg / NUM_TESTS;
     if (g_running) {
-        LOG_DEBUG(subprocess) << "Read avg GBits/sec=" << gigaBitsPerSecReadDoubleAvg / NUM_TESTS;
-        LOG_DEBUG(subprocess) << "Write avg GBits/sec=" << gigaBitsPerSecWriteDoubleAvg / NUM_TESTS;
+        LOG_DEBUG(subprocess) << "Read avg GBits/sec=" << gigaBitsPerSecReadAvg;
+        LOG_DEBUG(subprocess) << "Write avg GBits/sec=" << gigaBitsPerSecWriteAvg;
     }
-    return true;
+    return g_running;
 
 }
 
 
-int main() {
+//usage: storage-speedtest [storageConfig.json]
+//runs the same test against every compiled in storage implementation and compares them to the stdio_multi_threaded baseline
+int main(int argc, const char* argv[]) {
     hdtn::Logger::initializeWithProcess(hdtn::Logger::Process::storagespeedtest);
-    std::unique_ptr<BundleStorageManagerBase> bsmPtr;
-    if (true) {
-        boost::make_unique<BundleStorageManagerMT>();
+    const std::string jsonConfigFileName = (argc > 1) ? argv[1] : "storageConfig.json";
+    g_sigHandler.Start();
+
+    std::vector<std::string> implementationNames = { "stdio_multi_threaded", "asio_single_threaded" };
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+    implementationNames.push_back("io_uring");
+#endif
+    std::vector<double> readGbpsVec(implementationNames.size(), 0.0);
+    std::vector<double> writeGbpsVec(implementationNames.size(), 0.0);
+    for (std::size_t i = 0; (i < implementationNames.size()) && g_running; ++i) {
+        StorageConfig_ptr storageConfigPtr = StorageConfig::CreateFromJsonFile(jsonConfigFileName);
+        if (!storageConfigPtr) {
+            LOG_ERROR(subprocess) << "cannot open storage json config file: " << jsonConfigFileName;
+            return 1;
+        }
+        storageConfigPtr->m_tryToRestoreFromDisk = false;
+        storageConfigPtr->m_autoDeleteFilesOnExit = true;
+        storageConfigPtr->m_storageImplementation = implementationNames[i];
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+        if (implementationNames[i] == "stdio_multi_threaded") {
+            bsmPtr = boost::make_unique<BundleStorageManagerMT>(storageConfigPtr);
+        }
+        else if (implementationNames[i] == "asio_single_threaded") {
+            bsmPtr = boost::make_unique<BundleStorageManagerAsio>(storageConfigPtr);
+        }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+        else if (implementationNames[i] == "io_uring") {
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(storageConfigPtr);
+        }
+#endif
+        LOG_INFO(subprocess) << "testing storage implementation " << implementationNames[i];
+        if (!TestSpeed(*bsmPtr, readGbpsVec[i], writeGbpsVec[i])) {
+            LOG_ERROR(subprocess) << "storage implementation " << implementationNames[i] << " failed";
+            return 1;
+        }
     }
-    else {
-        boost::make_unique<BundleStorageManagerAsio>();
+
+    for (std::size_t i = 0; i < implementationNames.size(); ++i) {
+        LOG_INFO(subprocess) << implementationNames[i] << ": Read avg GBits/sec=" << readGbpsVec[i] << " Write avg GBits/sec=" << writeGbpsVec[i];
+        for (std::size_t j = 0; j < i; ++j) {
+            LOG_INFO(subprocess) << "    vs " << implementationNames[j]
+                << ": read speedup=" << ((readGbpsVec[j] > 0.0) ? (readGbpsVec[i] / readGbpsVec[j]) : 0.0)
+                << "x write speedup=" << ((writeGbpsVec[j] > 0.0) ? (writeGbpsVec[i] / writeGbpsVec[j]) : 0.0) << "x";
+        }
     }
-    LOG_INFO(subprocess) << TestSpeed(*bsmPtr);
     return 0;
 }
@@ -15,6 +15,12 @@
 #include <boost/test/unit_test.hpp>
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+#include "BundleStorageManagerIoUring.h"
+#define NUM_BSM_IMPLEMENTATIONS_TO_TEST 3
+#else
+#define NUM_BSM_IMPLEMENTATIONS_TO_TEST 2
+#endif
 #include <iostream>
 #include <string>
 #include <boost/filesystem.hpp>
@@ -99,7 +105,7 @@ static bool GenerateBundleV7(std::vector<uint8_t> & bundle, const Bpv7CbhePrimar
 
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 {
-    for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+    for (unsigned int whichBsm = 0; whichBsm < NUM_BSM_IMPLEMENTATIONS_TO_TEST; ++whichBsm) {
         boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
         const boost::random::uniform_int_distribution<> distRandomData(0, 255);
         const boost::random::uniform_int_distribution<> distLinkId(0, 9);
@@ -141,10 +147,16 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
             std::cout << "create BundleStorageManagerMT" << std::endl;
             bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
         }
-        else {
+        else if (whichBsm == 1) {
             std::cout << "create BundleStorageManagerAsio" << std::endl;
             bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
         }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+        else {
+            std::cout << "create BundleStorageManagerIoUring" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
+#endif
         BundleStorageManagerBase & bsm = *bsmPtr;
 
         bsm.Start();
@@ -250,7 +262,11 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
 {
     for (unsigned int whichBundleVersion = 6; whichBundleVersion <= 7; ++whichBundleVersion) {
-        for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+        //journal mode 0: no catalog journal, 1: restore from the catalog journal, 2: corrupt catalog journal (falls back to reading every segment)
+        for (unsigned int whichBsmAndJournalMode = 0; whichBsmAndJournalMode < (NUM_BSM_IMPLEMENTATIONS_TO_TEST * 3); ++whichBsmAndJournalMode) {
+            const unsigned int whichBsm = whichBsmAndJournalMode % NUM_BSM_IMPLEMENTATIONS_TO_TEST;
+            const unsigned int whichJournalMode = whichBsmAndJournalMode / NUM_BSM_IMPLEMENTATIONS_TO_TEST;
+            const std::string catalogJournalFilePath = (whichJournalMode == 0) ? "" : "catalogJournal.bin";
             boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
             const boost::random::uniform_int_distribution<> distRandomData(0, 255);
             const boost::random::uniform_int_distribution<> distPriorityIndex(0, 2);
@@ -314,14 +330,21 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                 StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
                 ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
                 ptrStorageConfig->m_autoDeleteFilesOnExit = false; //manually set this json entry
+                ptrStorageConfig->m_catalogJournalFilePath = catalogJournalFilePath;
                 if (whichBsm == 0) {
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
-                else {
+                else if (whichBsm == 1) {
                     std::cout << "create BundleStorageManagerAsio for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
                 }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+                else {
+                    std::cout << "create BundleStorageManagerIoUring for Restore" << std::endl;
+                    bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+                }
+#endif
                 BundleStorageManagerBase & bsm = *bsmPtr;
 
                 bsm.Start();
@@ -402,6 +425,12 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
             }
 
             std::cout << "wrote bundles but leaving files\n";
+            if (whichJournalMode == 2) { //corrupt the catalog journal header
+                FILE * fileHandle = fopen(catalogJournalFilePath.c_str(), "r+b");
+                BOOST_REQUIRE(fileHandle != NULL);
+                fputc(0, fileHandle);
+                fclose(fileHandle);
+            }
             //boost::this_thread::sleep(boost::posix_time::milliseconds(500));
             std::cout << "restoring...\n";
             {
@@ -409,20 +438,28 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                 StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
                 ptrStorageConfig->m_tryToRestoreFromDisk = true; //manually set this json entry
                 ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+                ptrStorageConfig->m_catalogJournalFilePath = catalogJournalFilePath;
                 if (whichBsm == 0) {
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
-                else {
+                else if (whichBsm == 1) {
                     std::cout << "create BundleStorageManagerAsio for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
                 }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+                else {
+                    std::cout << "create BundleStorageManagerIoUring for Restore" << std::endl;
+                    bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+                }
+#endif
                 BundleStorageManagerBase & bsm = *bsmPtr;
 
 
 
                 //BOOST_REQUIRE(!bsm.GetMemoryManagerConstRef().IsBackupEqual(backup));
                 BOOST_REQUIRE_MESSAGE(bsm.m_successfullyRestoredFromDisk, "error restoring from disk");
+                BOOST_REQUIRE_EQUAL(bsm.m_restoredFromCatalogJournal, (whichJournalMode == 1));
                 BOOST_REQUIRE(bsm.GetMemoryManagerConstRef().IsBackupEqual(backup));
                 std::cout << "restored\n";
                 BOOST_REQUIRE_EQUAL(bsm.m_totalBundlesRestored, (15 - 1));
@@ -446,7 +483,7 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                     std::vector<boost::uint8_t> dataReadBack(bytesToReadFromDisk);
                     totalBytesReadFromRestored += bytesToReadFromDisk;
 
-                    const std::size_t numSegmentsToRead = sessionRead.catalogEntryPtr->segmentIdChainVec.size();
+                    const std::size_t numSegmentsToRead = sessionRead.catalogEntryPtr->GetNumSegments();
                     totalSegmentsReadFromRestored += numSegmentsToRead;
 
                     BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
@@ -473,3 +510,407 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_HotTier_TestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < NUM_BSM_IMPLEMENTATIONS_TO_TEST; ++whichBsm) {
+        //3 segment bundles, of which the hot tier holds 2
+        const uint64_t bundleSize = 2 * BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1;
+        static const cbhe_eid_t DEST_LINKS[5] = { cbhe_eid_t(1,1), cbhe_eid_t(2,1), cbhe_eid_t(3,1), cbhe_eid_t(4,1), cbhe_eid_t(5,1) };
+        std::vector<uint8_t> bundles[5];
+        std::unique_ptr<PrimaryBlock> primaries[5];
+        for (unsigned int i = 0; i < 5; ++i) {
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid = DEST_LINKS[i];
+            primary.m_custodianEid.SetZero();
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            primaries[i] = boost::make_unique<Bpv6CbhePrimaryBlock>(primary);
+            BOOST_REQUIRE(GenerateBundle(bundles[i], primary, bundleSize, static_cast<uint8_t>(i)));
+        }
+
+        {
+            std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+            StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+            ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+            ptrStorageConfig->m_autoDeleteFilesOnExit = false; //manually set this json entry
+            ptrStorageConfig->m_hotTierCacheBytes = 2 * bundleSize;
+            ptrStorageConfig->m_hotTierWriteBackDelayMilliseconds = 60000;
+            if (whichBsm == 0) {
+                std::cout << "create BundleStorageManagerMT for HotTier" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+            }
+            else if (whichBsm == 1) {
+                std::cout << "create BundleStorageManagerAsio for HotTier" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+            }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+            else {
+                std::cout << "create BundleStorageManagerIoUring for HotTier" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+            }
+#endif
+            BundleStorageManagerBase & bsm = *bsmPtr;
+            bsm.Start();
+
+            //the third bundle evicts (writes back) the first
+            for (unsigned int i = 0; i < 3; ++i) {
+                BundleStorageManagerSession_WriteToDisk sessionWrite;
+                BOOST_REQUIRE_NE(bsm.Push(sessionWrite, *primaries[i], bundleSize), 0);
+                BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, *primaries[i], i, bundles[i].data(), bundleSize), bundleSize);
+            }
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierEvictions(), 1);
+            BOOST_REQUIRE_EQUAL(bsm.WriteBackAgedHotTierBundles(), 0);
+
+            BundleStorageManagerSession_ReadFromDisk sessionRead; //has a heap allocation so reuse it
+            std::vector<uint8_t> dataReadBack;
+
+            //in memory
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, DEST_LINKS[2])), bundleSize);
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+            BOOST_REQUIRE(dataReadBack == bundles[2]);
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierHits(), 1);
+            BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing bundle from hot tier");
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierWriteBacksCancelled(), 1);
+
+            //written back
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, DEST_LINKS[0])), bundleSize);
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+            BOOST_REQUIRE(dataReadBack == bundles[0]);
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierMisses(), 1);
+            BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing bundle from disk");
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierWriteBacksCancelled(), 1);
+
+            //segment by segment reads write the bundle back first
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, DEST_LINKS[1])), bundleSize);
+            dataReadBack.assign(bundleSize, 0);
+            std::size_t totalBytesRead = 0;
+            for (std::size_t i = 0; i < 3; ++i) {
+                totalBytesRead += bsm.TopSegment(sessionRead, &dataReadBack[i * BUNDLE_STORAGE_PER_SEGMENT_SIZE]);
+            }
+            BOOST_REQUIRE_EQUAL(totalBytesRead, bundleSize);
+            BOOST_REQUIRE(dataReadBack == bundles[1]);
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierEvictions(), 2);
+            BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing bundle from disk");
+
+            //left in the hot tier, to be written back by the destructor
+            for (unsigned int i = 3; i < 5; ++i) {
+                BundleStorageManagerSession_WriteToDisk sessionWrite;
+                BOOST_REQUIRE_NE(bsm.Push(sessionWrite, *primaries[i], bundleSize), 0);
+                BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, *primaries[i], i, bundles[i].data(), bundleSize), bundleSize);
+            }
+            BOOST_REQUIRE_EQUAL(bsm.GetNumHotTierEvictions(), 2);
+        }
+
+        {
+            std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+            StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+            ptrStorageConfig->m_tryToRestoreFromDisk = true; //manually set this json entry
+            ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+            if (whichBsm == 0) {
+                bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+            }
+            else if (whichBsm == 1) {
+                bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+            }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+            else {
+                bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+            }
+#endif
+            BundleStorageManagerBase & bsm = *bsmPtr;
+            BOOST_REQUIRE_MESSAGE(bsm.m_successfullyRestoredFromDisk, "error restoring from disk");
+            BOOST_REQUIRE_EQUAL(bsm.m_totalBundlesRestored, 2);
+            bsm.Start();
+            BundleStorageManagerSession_ReadFromDisk sessionRead;
+            std::vector<uint8_t> dataReadBack;
+            for (unsigned int i = 3; i < 5; ++i) {
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, DEST_LINKS[i])), bundleSize);
+                BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+                BOOST_REQUIRE(dataReadBack == bundles[i]);
+                BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing bundle from disk");
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_ReadAhead_TestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < NUM_BSM_IMPLEMENTATIONS_TO_TEST; ++whichBsm) {
+        boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
+        const boost::random::uniform_int_distribution<> distRandomData(0, 255);
+        const std::vector<cbhe_eid_t> availableDestLinks = { cbhe_eid_t(1,1) };
+
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+        StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+        ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+        ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+        if (whichBsm == 0) {
+            std::cout << "create BundleStorageManagerMT for ReadAhead" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+        }
+        else if (whichBsm == 1) {
+            std::cout << "create BundleStorageManagerAsio for ReadAhead" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+        }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+        else {
+            std::cout << "create BundleStorageManagerIoUring for ReadAhead" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
+#endif
+        BundleStorageManagerBase & bsm = *bsmPtr;
+        bsm.Start();
+
+        //the largest bundles are read ahead only in part (the read cache and disk queues are smaller than them)
+        static const uint64_t sizes[5] = {
+            1,
+            BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1,
+            1000 * BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1,
+            2 * BUNDLE_STORAGE_PER_SEGMENT_SIZE - 1,
+            100 * BUNDLE_STORAGE_PER_SEGMENT_SIZE
+        };
+        std::vector<uint8_t> bundles[5];
+        for (unsigned int i = 0; i < 5; ++i) {
+            bundles[i].resize(sizes[i]);
+            for (std::size_t j = 0; j < sizes[i]; ++j) {
+                bundles[i][j] = distRandomData(gen);
+            }
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid = availableDestLinks[0];
+            primary.m_custodianEid.SetZero();
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, sizes[i]), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, i, bundles[i].data(), sizes[i]), sizes[i]);
+        }
+
+        //pop and read ahead 4 bundles, read 3 of them, and return the 4th unread
+        BundleStorageManagerSession_ReadFromDisk sessions[4];
+        for (unsigned int i = 0; i < 4; ++i) {
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[i], availableDestLinks), sizes[i]);
+            bsm.ReadAhead(sessions[i]);
+        }
+        std::vector<uint8_t> dataReadBack;
+        for (unsigned int i = 0; i < 3; ++i) {
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessions[i], dataReadBack));
+            BOOST_REQUIRE(dataReadBack == bundles[i]);
+            BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessions[i]), "error freeing bundle from disk");
+        }
+        bsm.WaitForReadAhead(sessions[3]);
+        BOOST_REQUIRE(bsm.ReturnTop(sessions[3]));
+
+        //the returned bundle is popped again before the 5th
+        for (unsigned int i = 3; i < 5; ++i) {
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[0], availableDestLinks), sizes[i]);
+            bsm.ReadAhead(sessions[0]);
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessions[0], dataReadBack));
+            BOOST_REQUIRE(dataReadBack == bundles[i]);
+            BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessions[0]), "error freeing bundle from disk");
+        }
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[0], availableDestLinks), 0);
+
+        //a custody signal for a bundle still being read ahead: the read ahead is waited on before the bundle is removed,
+        //and a bundle then stored in its freed segments is read back intact
+        static const uint64_t CUSTODY_SIGNAL_BUNDLE_SIZE = 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+        for (unsigned int i = 0; i < 2; ++i) {
+            bundles[i].resize(CUSTODY_SIGNAL_BUNDLE_SIZE);
+            for (std::size_t j = 0; j < CUSTODY_SIGNAL_BUNDLE_SIZE; ++j) {
+                bundles[i][j] = distRandomData(gen);
+            }
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid = availableDestLinks[0];
+            primary.m_custodianEid.SetZero();
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, CUSTODY_SIGNAL_BUNDLE_SIZE), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, 5 + i, bundles[i].data(), CUSTODY_SIGNAL_BUNDLE_SIZE), CUSTODY_SIGNAL_BUNDLE_SIZE);
+            if (i == 0) {
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[1], availableDestLinks), CUSTODY_SIGNAL_BUNDLE_SIZE);
+                bsm.ReadAhead(sessions[1]);
+                bsm.WaitForReadAhead(sessions[1]);
+                BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessions[1].catalogEntryPtr, sessions[1].custodyId));
+                BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(5) == NULL);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[0], availableDestLinks), CUSTODY_SIGNAL_BUNDLE_SIZE);
+        BOOST_REQUIRE_EQUAL(sessions[0].custodyId, 6);
+        bsm.ReadAhead(sessions[0]);
+        BOOST_REQUIRE(bsm.ReadAllSegments(sessions[0], dataReadBack));
+        BOOST_REQUIRE(dataReadBack == bundles[1]);
+        BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessions[0]), "error freeing bundle from disk");
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[0], availableDestLinks), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_SizeClasses_TestCase)
+{
+    for (unsigned int whichBsmAndJournalMode = 0; whichBsmAndJournalMode < (NUM_BSM_IMPLEMENTATIONS_TO_TEST * 2); ++whichBsmAndJournalMode) {
+        const unsigned int whichBsm = whichBsmAndJournalMode % NUM_BSM_IMPLEMENTATIONS_TO_TEST;
+        const std::string catalogJournalFilePath = ((whichBsmAndJournalMode / NUM_BSM_IMPLEMENTATIONS_TO_TEST) == 0) ? "" : "catalogJournal.bin";
+        static const uint64_t SLAB_SLOT_SIZE_BYTES = 512;
+        const uint64_t numSlotsPerSlab = std::min<uint64_t>(64, (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE) / SLAB_SLOT_SIZE_BYTES);
+        const uint64_t largeBundleExtentMinBytes = 64 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+
+        //telemetry sized bundles packed into slabs (the last is pushed after some are removed), then one normal and two large bundles
+        static const unsigned int NUM_SMALL = 3 * 7;
+        static const unsigned int NUM_BUNDLES = NUM_SMALL + 3;
+        std::vector<uint64_t> sizes(NUM_BUNDLES);
+        for (unsigned int i = 0; i < NUM_SMALL; ++i) {
+            sizes[i] = 200 + ((i % 4) * 50);
+        }
+        sizes[NUM_SMALL] = 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+        sizes[NUM_SMALL + 1] = largeBundleExtentMinBytes + 1;
+        sizes[NUM_SMALL + 2] = 130 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+        std::vector<std::vector<uint8_t> > bundles(NUM_BUNDLES);
+        std::vector<std::unique_ptr<PrimaryBlock> > primaries(NUM_BUNDLES);
+        for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid.Set(i + 1, 1); //one destination per bundle
+            primary.m_custodianEid.SetZero();
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            primaries[i] = boost::make_unique<Bpv6CbhePrimaryBlock>(primary);
+            BOOST_REQUIRE(GenerateBundle(bundles[i], primary, sizes[i], static_cast<uint8_t>(i)));
+        }
+        const unsigned int lastSmall = NUM_SMALL - 1;
+        std::vector<bool> isRemoved(NUM_BUNDLES, false);
+
+        for (unsigned int whichRun = 0; whichRun < 2; ++whichRun) {
+            std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+            StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+            ptrStorageConfig->m_tryToRestoreFromDisk = (whichRun == 1); //manually set this json entry
+            ptrStorageConfig->m_autoDeleteFilesOnExit = (whichRun == 1); //manually set this json entry
+            ptrStorageConfig->m_catalogJournalFilePath = catalogJournalFilePath;
+            ptrStorageConfig->m_slabSlotSizeBytes = SLAB_SLOT_SIZE_BYTES;
+            ptrStorageConfig->m_largeBundleExtentMinBytes = largeBundleExtentMinBytes;
+            if (whichBsm == 0) {
+                std::cout << "create BundleStorageManagerMT for SizeClasses" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+            }
+            else if (whichBsm == 1) {
+                std::cout << "create BundleStorageManagerAsio for SizeClasses" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+            }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+            else {
+                std::cout << "create BundleStorageManagerIoUring for SizeClasses" << std::endl;
+                bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+            }
+#endif
+            BundleStorageManagerBase & bsm = *bsmPtr;
+            const MemoryManagerTreeArray & memoryManager = bsm.GetMemoryManagerConstRef();
+            uint64_t numSegmentsAllocated = 0;
+            for (segment_id_t segmentId = 0; segmentId < bsm.M_MAX_SEGMENTS; ++segmentId) {
+                numSegmentsAllocated += (!memoryManager.IsSegmentFree(segmentId));
+            }
+            const uint64_t numSegmentsNonSmall = 3 + 65 + 130;
+            BundleStorageManagerSession_ReadFromDisk sessionRead;
+            std::vector<uint8_t> dataReadBack;
+
+            if (whichRun == 0) {
+                BOOST_REQUIRE_EQUAL(numSegmentsAllocated, 0);
+                bsm.Start();
+                for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+                    if (i == lastSmall) {
+                        continue;
+                    }
+                    BundleStorageManagerSession_WriteToDisk sessionWrite;
+                    BOOST_REQUIRE_NE(bsm.Push(sessionWrite, *primaries[i], sizes[i]), 0);
+                    BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, *primaries[i], i, bundles[i].data(), sizes[i]), sizes[i]);
+                    const catalog_entry_t * catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(i);
+                    BOOST_REQUIRE(catalogEntryPtr);
+                    BOOST_REQUIRE_EQUAL(catalogEntryPtr->IsInSlab(), (i < NUM_SMALL));
+                    if (i < NUM_SMALL) { //consecutive slots, numSlotsPerSlab per segment
+                        BOOST_REQUIRE_EQUAL(catalogEntryPtr->slabSlotOffset, SEGMENT_RESERVED_SPACE + ((i % numSlotsPerSlab) * SLAB_SLOT_SIZE_BYTES));
+                    }
+                    else if (i > NUM_SMALL) { //large bundles are one extent (the tail is not scattered)
+                        BOOST_REQUIRE_EQUAL(catalogEntryPtr->segmentIdExtentVec.size(), 1);
+                    }
+                }
+                numSegmentsAllocated = 0;
+                for (segment_id_t segmentId = 0; segmentId < bsm.M_MAX_SEGMENTS; ++segmentId) {
+                    numSegmentsAllocated += (!memoryManager.IsSegmentFree(segmentId));
+                }
+                const uint64_t numSlabs = ((NUM_SMALL - 1) + (numSlotsPerSlab - 1)) / numSlotsPerSlab;
+                BOOST_REQUIRE_EQUAL(numSegmentsAllocated, numSlabs + numSegmentsNonSmall);
+
+                //free every slot of the first (sealed) slab, the last of which frees its segment
+                const segment_id_t firstSlabSegmentId = bsm.GetCatalogEntryPtrFromCustodyId(0)->segmentIdExtentVec[0].startSegmentId;
+                for (unsigned int i = 0; i < numSlotsPerSlab; ++i) {
+                    BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(i + 1, 1))), sizes[i]);
+                    BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+                    BOOST_REQUIRE(dataReadBack == bundles[i]);
+                    BOOST_REQUIRE(!memoryManager.IsSegmentFree(firstSlabSegmentId));
+                    BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing slab bundle");
+                    isRemoved[i] = true;
+                }
+                BOOST_REQUIRE(memoryManager.IsSegmentFree(firstSlabSegmentId));
+
+                //a slot freed in the open slab is reused by the next small bundle
+                const unsigned int openSlabBundle = lastSmall - 1;
+                const uint32_t freedSlabSlotOffset = bsm.GetCatalogEntryPtrFromCustodyId(openSlabBundle)->slabSlotOffset;
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(openSlabBundle + 1, 1))), sizes[openSlabBundle]);
+                BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing slab bundle");
+                isRemoved[openSlabBundle] = true;
+                BundleStorageManagerSession_WriteToDisk sessionWrite;
+                BOOST_REQUIRE_EQUAL(bsm.Push(sessionWrite, *primaries[lastSmall], sizes[lastSmall]), 1);
+                BOOST_REQUIRE_EQUAL(sessionWrite.catalogEntry.slabSlotOffset, freedSlabSlotOffset);
+                BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, *primaries[lastSmall], lastSmall, bundles[lastSmall].data(), sizes[lastSmall]), sizes[lastSmall]);
+
+                //a slot freed in a sealed slab (rewritten from its cached image) does not disturb its neighbors
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(numSlotsPerSlab + 2, 1))), sizes[numSlotsPerSlab + 1]);
+                BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing slab bundle");
+                isRemoved[numSlotsPerSlab + 1] = true;
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(numSlotsPerSlab + 1, 1))), sizes[numSlotsPerSlab]);
+                BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+                BOOST_REQUIRE(dataReadBack == bundles[numSlotsPerSlab]);
+                BOOST_REQUIRE(bsm.ReturnTop(sessionRead));
+            }
+            else {
+                BOOST_REQUIRE_MESSAGE(bsm.m_successfullyRestoredFromDisk, "error restoring from disk");
+                BOOST_REQUIRE_EQUAL(bsm.m_restoredFromCatalogJournal, !catalogJournalFilePath.empty());
+                const uint64_t numSmallRemaining = static_cast<uint64_t>(std::count(isRemoved.begin(), isRemoved.begin() + NUM_SMALL, false));
+                BOOST_REQUIRE_EQUAL(bsm.m_totalBundlesRestored, numSmallRemaining + 3);
+                BOOST_REQUIRE_EQUAL(bsm.m_totalSegmentsRestored, 2 + numSegmentsNonSmall);
+                BOOST_REQUIRE_EQUAL(numSegmentsAllocated, 2 + numSegmentsNonSmall);
+                bsm.Start();
+                for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+                    if (isRemoved[i]) {
+                        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(i + 1, 1))), 0);
+                        continue;
+                    }
+                    BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, std::vector<cbhe_eid_t>(1, cbhe_eid_t(i + 1, 1))), sizes[i]);
+                    BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+                    BOOST_REQUIRE(dataReadBack == bundles[i]);
+                    BOOST_REQUIRE_MESSAGE(bsm.RemoveReadBundleFromDisk(sessionRead), "error freeing restored bundle");
+                }
+                //slots freed in restored slabs (whose images are read back from the disk) did not disturb their neighbors,
+                //and restored slabs are freed with their last slot
+                numSegmentsAllocated = 0;
+                for (segment_id_t segmentId = 0; segmentId < bsm.M_MAX_SEGMENTS; ++segmentId) {
+                    numSegmentsAllocated += (!memoryManager.IsSegmentFree(segmentId));
+                }
+                BOOST_REQUIRE_EQUAL(numSegmentsAllocated, 0);
+            }
+        }
+    }
+}
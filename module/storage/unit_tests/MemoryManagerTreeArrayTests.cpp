@@ -19,6 +19,10 @@
 #include <iostream>
 #include <string>
 #include <inttypes.h>
+#include <atomic>
+#include <memory>
+#include <boost/thread.hpp>
+#include <boost/timer/timer.hpp>
 
 BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayIsSegmentFreeTestCase)
 {
@@ -244,3 +248,194 @@ BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayFullTestCase)
         BOOST_REQUIRE(t.AllocateSegmentId_NotThreadSafe(i));
     }
 }
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayLockFreeTestCase)
+{
+    //single threaded behavior must match the mutex mode
+    const uint64_t MAX_SEGMENTS = 64 * 64 + 11;
+    MemoryManagerTreeArray t(MAX_SEGMENTS, true);
+    BOOST_REQUIRE(t.IsLockFreeAllocation());
+    BOOST_REQUIRE(!MemoryManagerTreeArray(MAX_SEGMENTS).IsLockFreeAllocation());
+    memmanager_t backupEmpty;
+    t.BackupDataToVector(backupEmpty);
+
+    //compatible with restore
+    BOOST_REQUIRE(t.AllocateSegmentId_NotThreadSafe(5));
+    segment_id_chain_vec_t segmentVec(10);
+    BOOST_REQUIRE(t.AllocateSegments_ThreadSafe(segmentVec));
+    BOOST_REQUIRE_EQUAL(segmentVec.size(), 10);
+    for (std::size_t i = 0; i < segmentVec.size(); ++i) {
+        BOOST_REQUIRE_NE(segmentVec[i], 5);
+        BOOST_REQUIRE(!t.IsSegmentFree(segmentVec[i]));
+        if (i) {
+            BOOST_REQUIRE_GT(segmentVec[i], segmentVec[i - 1]); //ascending
+        }
+    }
+    BOOST_REQUIRE(t.FreeSegments_ThreadSafe(segmentVec));
+    BOOST_REQUIRE(!t.FreeSegments_ThreadSafe(segmentVec)); //already freed
+    BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(5));
+
+    //fill up completely (including segments held by the magazine)
+    segment_id_chain_vec_t allVec(MAX_SEGMENTS);
+    BOOST_REQUIRE(t.AllocateSegments_ThreadSafe(allVec));
+    for (segment_id_t i = 0; i < MAX_SEGMENTS; ++i) {
+        BOOST_REQUIRE_EQUAL(allVec[i], i);
+    }
+    segment_id_chain_vec_t oneVec(1);
+    BOOST_REQUIRE(!t.AllocateSegments_ThreadSafe(oneVec));
+    BOOST_REQUIRE_EQUAL(oneVec.size(), 0);
+    BOOST_REQUIRE(t.FreeSegments_ThreadSafe(allVec));
+    t.ReturnCachedSegments_ThreadSafe();
+    BOOST_REQUIRE(t.IsBackupEqual(backupEmpty));
+}
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayExtentsTestCase)
+{
+    const uint64_t MAX_SEGMENTS = 64 * 100 + 11;
+    for (unsigned int useLockFreeAllocation = 0; useLockFreeAllocation <= 1; ++useLockFreeAllocation) {
+        MemoryManagerTreeArray t(MAX_SEGMENTS, (useLockFreeAllocation != 0));
+        memmanager_t backupEmpty;
+        t.BackupDataToVector(backupEmpty);
+
+        //leave the first leaf uint64_t partially allocated
+        BOOST_REQUIRE(t.AllocateSegmentId_NotThreadSafe(0));
+
+        //whole free leaf uint64_t's merged into one extent, remainder from the first free segments
+        segment_id_extent_vec_t extentVec;
+        BOOST_REQUIRE(t.AllocateSegmentExtents_ThreadSafe(64 * 3 + 8, extentVec));
+        BOOST_REQUIRE(extentVec == segment_id_extent_vec_t({ segment_id_extent_t(1, 8), segment_id_extent_t(64, 64 * 3) }));
+        BOOST_REQUIRE_EQUAL(MemoryManagerTreeArray::GetNumSegmentsInExtents(extentVec), 64 * 3 + 8);
+        std::vector<segment_id_t> walkedSegmentIds;
+        segment_id_extent_cursor_t cursor;
+        for (segment_id_t segmentId = cursor.Get(extentVec); segmentId != SEGMENT_ID_LAST; segmentId = cursor.Get(extentVec)) {
+            BOOST_REQUIRE(!t.IsSegmentFree(segmentId));
+            walkedSegmentIds.push_back(segmentId);
+            cursor.Advance(extentVec);
+        }
+        BOOST_REQUIRE_EQUAL(walkedSegmentIds.size(), 64 * 3 + 8);
+        BOOST_REQUIRE_EQUAL(walkedSegmentIds[0], 1);
+        BOOST_REQUIRE_EQUAL(walkedSegmentIds[7], 8);
+        BOOST_REQUIRE_EQUAL(walkedSegmentIds[8], 64);
+        BOOST_REQUIRE_EQUAL(walkedSegmentIds.back(), 64 * 4 - 1);
+        BOOST_REQUIRE(t.IsSegmentFree(9));
+
+        //a failed allocation leaves the tree unchanged
+        memmanager_t backupBeforeFailure;
+        t.BackupDataToVector(backupBeforeFailure);
+        segment_id_extent_vec_t tooLargeVec;
+        BOOST_REQUIRE(!t.AllocateSegmentExtents_ThreadSafe(MAX_SEGMENTS, tooLargeVec));
+        BOOST_REQUIRE(tooLargeVec.empty());
+        t.ReturnCachedSegments_ThreadSafe();
+        BOOST_REQUIRE(t.IsBackupEqual(backupBeforeFailure));
+
+        //the rest of the segments fit exactly
+        segment_id_extent_vec_t restVec;
+        BOOST_REQUIRE(t.AllocateSegmentExtents_ThreadSafe(MAX_SEGMENTS - (64 * 3 + 8) - 1, restVec));
+        BOOST_REQUIRE_EQUAL(MemoryManagerTreeArray::GetNumSegmentsInExtents(restVec), MAX_SEGMENTS - (64 * 3 + 8) - 1);
+        for (std::size_t i = 1; i < restVec.size(); ++i) {
+            BOOST_REQUIRE_GT(restVec[i].startSegmentId, restVec[i - 1].startSegmentId + restVec[i - 1].numSegments); //sorted and merged
+        }
+        for (segment_id_t i = 0; i < MAX_SEGMENTS; ++i) {
+            BOOST_REQUIRE(!t.IsSegmentFree(i));
+        }
+        segment_id_chain_vec_t oneVec(1);
+        BOOST_REQUIRE(!t.AllocateSegments_ThreadSafe(oneVec));
+
+        BOOST_REQUIRE(t.FreeSegmentExtents_ThreadSafe(extentVec));
+        BOOST_REQUIRE(!t.FreeSegmentExtents_ThreadSafe(extentVec)); //already freed
+        BOOST_REQUIRE(t.FreeSegmentExtents_ThreadSafe(restVec));
+        BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(0));
+        t.ReturnCachedSegments_ThreadSafe();
+        BOOST_REQUIRE(t.IsBackupEqual(backupEmpty));
+
+        //rounded up to whole leaf uint64_t's, the remainder continues the same run and the unused tail is freed
+        BOOST_REQUIRE(t.AllocateSegmentId_NotThreadSafe(0));
+        segment_id_extent_vec_t largeVec;
+        BOOST_REQUIRE(t.AllocateSegmentExtents_ThreadSafe(64 * 2 + 8, largeVec, true));
+        BOOST_REQUIRE(largeVec == segment_id_extent_vec_t({ segment_id_extent_t(64, 64 * 2 + 8) }));
+        BOOST_REQUIRE(!t.IsSegmentFree(64 * 3 + 7));
+        BOOST_REQUIRE(t.IsSegmentFree(64 * 3 + 8));
+        BOOST_REQUIRE(t.IsSegmentFree(1));
+        segment_id_extent_vec_t smallVec;
+        BOOST_REQUIRE(t.AllocateSegmentExtents_ThreadSafe(8, smallVec, true)); //a single leaf uint64_t
+        BOOST_REQUIRE(smallVec == segment_id_extent_vec_t({ segment_id_extent_t(64 * 4, 8) }));
+        BOOST_REQUIRE(t.FreeSegmentExtents_ThreadSafe(largeVec));
+        BOOST_REQUIRE(t.FreeSegmentExtents_ThreadSafe(smallVec));
+        BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(0));
+        t.ReturnCachedSegments_ThreadSafe();
+        BOOST_REQUIRE(t.IsBackupEqual(backupEmpty));
+
+        //whole free leaf uint64_t's are found wherever a free (of single segments or of a run) leaves them, and partially free ones are skipped
+        segment_id_chain_vec_t allVec(MAX_SEGMENTS);
+        BOOST_REQUIRE(t.AllocateSegments_ThreadSafe(allVec));
+        for (segment_id_t i = 0; i < 64; ++i) {
+            BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(64 * 50 + i));
+        }
+        BOOST_REQUIRE(t.FreeSegmentExtents_ThreadSafe(segment_id_extent_vec_t({ segment_id_extent_t(64 * 10 + 5, 1), segment_id_extent_t(64 * 90, 64) })));
+        segment_id_extent_vec_t wholeVec;
+        BOOST_REQUIRE(t.AllocateSegmentExtents_ThreadSafe(64 * 2 + 1, wholeVec));
+        BOOST_REQUIRE(wholeVec == segment_id_extent_vec_t({ segment_id_extent_t(64 * 10 + 5, 1), segment_id_extent_t(64 * 50, 64), segment_id_extent_t(64 * 90, 64) }));
+        segment_id_extent_vec_t noneVec;
+        BOOST_REQUIRE(!t.AllocateSegmentExtents_ThreadSafe(1, noneVec));
+        BOOST_REQUIRE(t.FreeSegments_ThreadSafe(allVec));
+        t.ReturnCachedSegments_ThreadSafe();
+        BOOST_REQUIRE(t.IsBackupEqual(backupEmpty));
+    }
+}
+
+static void MemoryManagerContentionThreadFunc(MemoryManagerTreeArray * t, std::atomic<uint8_t> * owners,
+    const unsigned int threadId, const unsigned int numIterations, std::atomic<bool> * success)
+{
+    segment_id_chain_vec_t segmentVec;
+    for (unsigned int i = 0; i < numIterations; ++i) {
+        segmentVec.resize(1 + ((i * 7 + threadId) % 8)); //1 to 8 segments (small bundles)
+        if (!t->AllocateSegments_ThreadSafe(segmentVec)) {
+            *success = false;
+            return;
+        }
+        for (std::size_t j = 0; j < segmentVec.size(); ++j) {
+            if (owners[segmentVec[j]].exchange(1) != 0) { //segment handed out twice
+                *success = false;
+            }
+        }
+        for (std::size_t j = 0; j < segmentVec.size(); ++j) {
+            owners[segmentVec[j]] = 0;
+        }
+        if (!t->FreeSegments_ThreadSafe(segmentVec)) {
+            *success = false;
+            return;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayContentionBenchmarkTestCase)
+{
+    const uint64_t MAX_SEGMENTS = 64 * 64 * 4;
+    const unsigned int NUM_ITERATIONS_PER_THREAD = 100000;
+    const unsigned int numThreads = std::max(4u, boost::thread::hardware_concurrency());
+    for (unsigned int useLockFree = 0; useLockFree < 2; ++useLockFree) {
+        MemoryManagerTreeArray t(MAX_SEGMENTS, useLockFree != 0);
+        memmanager_t backupEmpty;
+        t.BackupDataToVector(backupEmpty);
+        std::unique_ptr<std::atomic<uint8_t>[]> owners(new std::atomic<uint8_t>[MAX_SEGMENTS]);
+        for (uint64_t i = 0; i < MAX_SEGMENTS; ++i) {
+            owners[i] = 0;
+        }
+        std::atomic<bool> success(true);
+        boost::timer::cpu_timer timer;
+        {
+            boost::thread_group threads;
+            for (unsigned int threadId = 0; threadId < numThreads; ++threadId) {
+                threads.create_thread(boost::bind(&MemoryManagerContentionThreadFunc, &t, owners.get(), threadId, NUM_ITERATIONS_PER_THREAD, &success));
+            }
+            threads.join_all();
+        }
+        const boost::uint64_t nanoSecWall = timer.elapsed().wall;
+        BOOST_REQUIRE(success);
+        t.ReturnCachedSegments_ThreadSafe();
+        BOOST_REQUIRE(t.IsBackupEqual(backupEmpty));
+        const double allocFreePairsPerSecond = (static_cast<double>(numThreads) * NUM_ITERATIONS_PER_THREAD) / (static_cast<double>(nanoSecWall) * 1e-9);
+        std::cout << "MemoryManagerTreeArray " << ((useLockFree) ? "lock-free" : "mutex") << " mode: " << numThreads << " threads, "
+            << allocFreePairsPerSecond << " allocate+free pairs per second\n" << std::flush;
+    }
+}
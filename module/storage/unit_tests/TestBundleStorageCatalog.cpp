@@ -18,6 +18,8 @@
 #include <string>
 #include <inttypes.h>
 #include <set>
+#include <tuple>
+#include <boost/timer/timer.hpp>
 #include "codec/bpv6.h"
 #include "codec/bpv7.h"
 
@@ -82,14 +84,14 @@ BOOST_AUTO_TEST_CASE(BundleStorageCatalogTestCase)
                 primaries.push_back(&primariesV7[i]);
             }
             catalog_entry_t catalogEntryToTake;
-            catalogEntryToTake.Init(*primaries[i], 1000 + i, 1, NULL);
-            catalogEntryToTake.segmentIdChainVec = { static_cast<segment_id_t>(i) };
+            catalogEntryToTake.Init(*primaries[i], 1000 + i, NULL);
+            catalogEntryToTake.segmentIdExtentVec = { segment_id_extent_t(static_cast<segment_id_t>(i), 1) };
             catalogEntryCopiesForVerification.push_back(catalogEntryToTake); //make a copy for verification
             const uint64_t custodyId = i;
-            BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdChainVec.size(), 1); //verify before move
+            BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdExtentVec.size(), 1); //verify before move
             BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, *primaries[i], custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
             catalogEntryCopiesForVerification.back().ptrUuidKeyInMap = catalogEntryToTake.ptrUuidKeyInMap; //was potentially modified at CatalogIncomingBundleForStore
-            BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdChainVec.size(), 0); //verify was moved
+            BOOST_REQUIRE_EQUAL(catalogEntryToTake.segmentIdExtentVec.size(), 0); //verify was moved
         }
         const std::vector<cbhe_eid_t> availableDestinationEids({ cbhe_eid_t(501, 501) });
         for (std::size_t i = 0; i < 10; ++i) {
@@ -150,3 +152,227 @@ BOOST_AUTO_TEST_CASE(BundleStorageCatalogTestCase)
 
     
 }
+
+static void CatalogBundleWithPriority(BundleStorageCatalog & bsc, const cbhe_eid_t & destEid, const uint64_t creation,
+    const uint64_t sequence, const BPV6_BUNDLEFLAG priorityFlag, const uint64_t custodyId)
+{
+    Bpv6CbhePrimaryBlock primary;
+    CreatePrimaryV6(primary, cbhe_eid_t(500, 500), destEid, false, creation, sequence);
+    primary.m_bundleProcessingControlFlags |= priorityFlag;
+    catalog_entry_t catalogEntryToTake;
+    catalogEntryToTake.Init(primary, 1000, NULL);
+    catalogEntryToTake.segmentIdExtentVec = { segment_id_extent_t(static_cast<segment_id_t>(custodyId), 1) };
+    BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primary, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+}
+
+typedef std::set<std::tuple<unsigned int, uint64_t, uint64_t> > priority_expiration_custid_set_t;
+
+//the popped bundle must have the highest priority, then the earliest expiration, of all remaining bundles, then remove it from the reference
+static void RequireNextToReleaseAndErase(priority_expiration_custid_set_t & expectedSet, const catalog_entry_t * entryPtr, const uint64_t custodyId) {
+    BOOST_REQUIRE(entryPtr != NULL);
+    BOOST_REQUIRE(!expectedSet.empty());
+    const unsigned int highestPriorityIndex = std::get<0>(*expectedSet.rbegin());
+    const std::tuple<unsigned int, uint64_t, uint64_t> & next = *expectedSet.lower_bound(std::make_tuple(highestPriorityIndex, uint64_t(0), uint64_t(0)));
+    BOOST_REQUIRE_EQUAL(static_cast<unsigned int>(entryPtr->GetPriorityIndex()), std::get<0>(next));
+    BOOST_REQUIRE_EQUAL(entryPtr->GetAbsExpiration(), std::get<1>(next));
+    BOOST_REQUIRE_EQUAL(expectedSet.erase(std::make_tuple(static_cast<unsigned int>(entryPtr->GetPriorityIndex()), entryPtr->GetAbsExpiration(), custodyId)), 1);
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogReleaseIndexTestCase)
+{
+    static const BPV6_BUNDLEFLAG PRIORITY_FLAGS[3] = { BPV6_BUNDLEFLAG::PRIORITY_BULK, BPV6_BUNDLEFLAG::PRIORITY_NORMAL, BPV6_BUNDLEFLAG::PRIORITY_EXPEDITED };
+    BundleStorageCatalog bsc;
+    //the release index covers any service id of node 5, node 6 service 1 only, and node 7 service 1 listed twice (fully qualified and any service id)
+    const std::vector<std::pair<cbhe_eid_t, bool> > releaseIndexDests({
+        std::pair<cbhe_eid_t, bool>(cbhe_eid_t(5, 0), true),
+        std::pair<cbhe_eid_t, bool>(cbhe_eid_t(6, 1), false),
+        std::pair<cbhe_eid_t, bool>(cbhe_eid_t(7, 1), false),
+        std::pair<cbhe_eid_t, bool>(cbhe_eid_t(7, 0), true)
+    });
+    //reference of (priority, expiration, custodyId) of every bundle that the release index can pop
+    priority_expiration_custid_set_t expectedSet;
+    std::vector<std::pair<uint64_t, catalog_entry_t *> > poppedEntries;
+    uint64_t nextCustodyId = 0;
+    uint64_t releaseIndexId = 0;
+    uint64_t seed = 12345;
+    for (unsigned int round = 0; round < 2; ++round) {
+        //bundles are added both before (some destinations not yet existing) and after the release index is created
+        for (unsigned int i = 0; i < 600; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            const uint64_t nodeId = 4 + ((seed >> 33) % 5); //4 to 8
+            const uint64_t serviceId = 1 + ((seed >> 40) % 3); //1 to 3
+            const unsigned int priorityIndex = static_cast<unsigned int>((seed >> 45) % 3);
+            const uint64_t creation = 1000 + ((seed >> 50) % 50); //many duplicate expirations
+            const uint64_t custodyId = nextCustodyId++;
+            CatalogBundleWithPriority(bsc, cbhe_eid_t(nodeId, serviceId), creation, i, PRIORITY_FLAGS[priorityIndex], custodyId);
+            if ((nodeId == 5) || ((nodeId == 6) && (serviceId == 1)) || (nodeId == 7)) {
+                expectedSet.emplace(priorityIndex, creation + 1000, custodyId);
+            }
+        }
+        if (round == 0) {
+            releaseIndexId = bsc.CreateReleaseIndex(releaseIndexDests);
+            BOOST_REQUIRE_NE(releaseIndexId, 0);
+        }
+        //pop half of them, occasionally returning what was popped or removing a bundle that was never popped
+        const std::size_t numToPop = expectedSet.size() / 2;
+        for (std::size_t i = 0; i < numToPop; ++i) {
+            uint64_t custodyId;
+            catalog_entry_t * entryPtr = bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId);
+            RequireNextToReleaseAndErase(expectedSet, entryPtr, custodyId);
+            if ((i % 7) == 0) {
+                BOOST_REQUIRE(bsc.ReturnEntryToAwaitingSend(*entryPtr, custodyId));
+                expectedSet.emplace(entryPtr->GetPriorityIndex(), entryPtr->GetAbsExpiration(), custodyId);
+            }
+            else {
+                poppedEntries.emplace_back(custodyId, entryPtr);
+            }
+            if (((i % 11) == 0) && (!expectedSet.empty())) {
+                //remove the latest expiring bundle of the lowest priority (an entry in the middle or back of its destination's map)
+                const uint64_t custodyIdToRemove = std::get<2>(*expectedSet.begin());
+                expectedSet.erase(expectedSet.begin());
+                BOOST_REQUIRE(bsc.Remove(custodyIdToRemove, true).first);
+            }
+        }
+    }
+    //the vector based pop with the same destinations shall agree with the release index, then drain the rest with the release index
+    {
+        uint64_t custodyId;
+        catalog_entry_t * entryPtr = bsc.PopEntryFromAwaitingSend(custodyId, releaseIndexDests);
+        RequireNextToReleaseAndErase(expectedSet, entryPtr, custodyId);
+    }
+    while (!expectedSet.empty()) {
+        uint64_t custodyId;
+        catalog_entry_t * entryPtr = bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId);
+        RequireNextToReleaseAndErase(expectedSet, entryPtr, custodyId);
+    }
+    uint64_t custodyId;
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId) == NULL);
+    //destinations outside of the release index still have their bundles
+    BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, std::vector<uint64_t>({ 4, 6, 8 })) != NULL);
+
+    //a returned bundle is seen again by the release index, but not after the release index is deleted
+    BOOST_REQUIRE(!poppedEntries.empty());
+    BOOST_REQUIRE(bsc.ReturnEntryToAwaitingSend(*poppedEntries.back().second, poppedEntries.back().first));
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId) != NULL);
+    BOOST_REQUIRE_EQUAL(custodyId, poppedEntries.back().first);
+    BOOST_REQUIRE(bsc.ReturnEntryToAwaitingSend(*poppedEntries.back().second, poppedEntries.back().first));
+    BOOST_REQUIRE(bsc.DeleteReleaseIndex(releaseIndexId));
+    BOOST_REQUIRE(!bsc.DeleteReleaseIndex(releaseIndexId));
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId) == NULL);
+    //a new release index sees the returned bundle
+    const uint64_t releaseIndexId2 = bsc.CreateReleaseIndex(releaseIndexDests);
+    BOOST_REQUIRE_NE(releaseIndexId2, releaseIndexId);
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId2) != NULL);
+    BOOST_REQUIRE_EQUAL(custodyId, poppedEntries.back().first);
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId2) == NULL);
+    BOOST_REQUIRE(bsc.DeleteReleaseIndex(releaseIndexId2));
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogExpiredBundlesTestCase)
+{
+    static const BPV6_BUNDLEFLAG PRIORITY_FLAGS[3] = { BPV6_BUNDLEFLAG::PRIORITY_BULK, BPV6_BUNDLEFLAG::PRIORITY_NORMAL, BPV6_BUNDLEFLAG::PRIORITY_EXPEDITED };
+    BundleStorageCatalog bsc;
+    const std::vector<std::pair<cbhe_eid_t, bool> > releaseIndexDests({ std::pair<cbhe_eid_t, bool>(cbhe_eid_t(0, 0), true) });
+    priority_expiration_custid_set_t unexpiredSet;
+    std::set<uint64_t> expiredCustodyIdsSet;
+    for (uint64_t custodyId = 0; custodyId < 300; ++custodyId) {
+        const uint64_t creation = 1000 + (custodyId % 30); //expires 2000 to 2029
+        const unsigned int priorityIndex = static_cast<unsigned int>(custodyId % 3);
+        CatalogBundleWithPriority(bsc, cbhe_eid_t(((custodyId % 4) == 0) ? 0 : (1 + (custodyId % 7)), 1), creation, custodyId, PRIORITY_FLAGS[priorityIndex], custodyId);
+        if ((creation + 1000) < 2015) {
+            expiredCustodyIdsSet.insert(custodyId);
+        }
+        else if ((custodyId % 4) == 0) {
+            unexpiredSet.emplace(priorityIndex, creation + 1000, custodyId);
+        }
+    }
+    const uint64_t releaseIndexId = bsc.CreateReleaseIndex(releaseIndexDests);
+
+    //popped in bounded batches, each expired bundle exactly once, and they stay in the catalog
+    std::vector<uint64_t> custodyIds;
+    std::size_t numPopped = 0;
+    for (std::size_t numBatches = 0; numBatches < 100; ++numBatches) {
+        const std::size_t n = bsc.PopExpiredEntriesFromAwaitingSend(2015, 7, custodyIds);
+        BOOST_REQUIRE_EQUAL(n, custodyIds.size());
+        BOOST_REQUIRE_LE(n, 7);
+        if (n == 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < custodyIds.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(expiredCustodyIdsSet.count(custodyIds[i]), 1);
+            BOOST_REQUIRE(bsc.GetEntryFromCustodyId(custodyIds[i]) != NULL);
+            BOOST_REQUIRE(bsc.Remove(custodyIds[i], false).first);
+            ++numPopped;
+        }
+    }
+    BOOST_REQUIRE_EQUAL(numPopped, expiredCustodyIdsSet.size());
+    BOOST_REQUIRE_EQUAL(bsc.PopExpiredEntriesFromAwaitingSend(2015, 7, custodyIds), 0);
+
+    //the release index only sees the unexpired bundles of its destination
+    while (!unexpiredSet.empty()) {
+        uint64_t custodyId;
+        catalog_entry_t * entryPtr = bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId);
+        RequireNextToReleaseAndErase(unexpiredSet, entryPtr, custodyId);
+    }
+    uint64_t custodyId;
+    BOOST_REQUIRE(bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogFailedInsertTestCase)
+{
+    BundleStorageCatalog bsc;
+    const std::vector<cbhe_eid_t> availableDestinationEids({ cbhe_eid_t(2, 1) });
+    Bpv6CbhePrimaryBlock primaries[2];
+    catalog_entry_t catalogEntries[2];
+    for (unsigned int i = 0; i < 2; ++i) {
+        CreatePrimaryV6(primaries[i], cbhe_eid_t(500, 500), cbhe_eid_t(2, 1), true, 1000, i);
+        catalogEntries[i].Init(primaries[i], 1000, NULL);
+        catalogEntries[i].segmentIdExtentVec = { segment_id_extent_t(static_cast<segment_id_t>(i), 1) };
+    }
+    BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntries[0], primaries[0], 5, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+    //same custody id again must fail and leave neither its uuid nor its awaiting send entry behind
+    BOOST_REQUIRE(!bsc.CatalogIncomingBundleForStore(catalogEntries[1], primaries[1], 5, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+    BOOST_REQUIRE(catalogEntries[1].ptrUuidKeyInMap == NULL);
+    BOOST_REQUIRE(bsc.GetCustodyIdFromUuid(primaries[1].GetCbheBundleUuidNoFragmentFromPrimary()) == NULL);
+    uint64_t * const cidPtr = bsc.GetCustodyIdFromUuid(primaries[0].GetCbheBundleUuidNoFragmentFromPrimary());
+    BOOST_REQUIRE(cidPtr != NULL);
+    BOOST_REQUIRE_EQUAL(*cidPtr, 5);
+    uint64_t custodyId;
+    BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids) != NULL);
+    BOOST_REQUIRE_EQUAL(custodyId, 5);
+    BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestinationEids) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogReleaseSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_DESTINATIONS = 10000;
+    static const uint64_t NUM_BUNDLES_PER_DESTINATION = 10;
+    static const uint64_t NUM_POPS = 20000;
+    static const BPV6_BUNDLEFLAG PRIORITY_FLAGS[3] = { BPV6_BUNDLEFLAG::PRIORITY_BULK, BPV6_BUNDLEFLAG::PRIORITY_NORMAL, BPV6_BUNDLEFLAG::PRIORITY_EXPEDITED };
+    for (unsigned int useReleaseIndex = 0; useReleaseIndex <= 1; ++useReleaseIndex) {
+        BundleStorageCatalog bsc;
+        std::vector<std::pair<cbhe_eid_t, bool> > availableDests;
+        availableDests.reserve(NUM_DESTINATIONS);
+        for (uint64_t d = 0; d < NUM_DESTINATIONS; ++d) {
+            availableDests.emplace_back(cbhe_eid_t(d + 1, 1), false);
+        }
+        uint64_t custodyId = 0;
+        for (uint64_t i = 0; i < NUM_BUNDLES_PER_DESTINATION; ++i) {
+            for (uint64_t d = 0; d < NUM_DESTINATIONS; ++d) {
+                const uint64_t creation = 1000 + ((d * 7919 + i * 104729) % 100000);
+                CatalogBundleWithPriority(bsc, availableDests[d].first, creation, i, PRIORITY_FLAGS[(d + i) % 3], custodyId);
+                ++custodyId;
+            }
+        }
+        const uint64_t releaseIndexId = (useReleaseIndex) ? bsc.CreateReleaseIndex(availableDests) : 0;
+        boost::timer::cpu_timer timer;
+        for (uint64_t i = 0; i < NUM_POPS; ++i) {
+            catalog_entry_t * entryPtr = (useReleaseIndex) ?
+                bsc.PopEntryFromReleaseIndex(custodyId, releaseIndexId) : bsc.PopEntryFromAwaitingSend(custodyId, availableDests);
+            BOOST_REQUIRE(entryPtr != NULL);
+        }
+        const double seconds = timer.elapsed().wall * 1e-9;
+        std::cout << ((useReleaseIndex) ? "PopEntryFromReleaseIndex" : "PopEntryFromAwaitingSend") << " " << NUM_DESTINATIONS << " destinations: "
+            << (NUM_POPS / seconds) << " pops/s" << std::endl;
+    }
+}
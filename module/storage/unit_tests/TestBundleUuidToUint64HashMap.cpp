@@ -14,13 +14,20 @@
 
 #include <boost/test/unit_test.hpp>
 #include "HashMap16BitFixedSize.h"
+#include "OpenAddressingHashMap.h"
 #include <iostream>
 #include <string>
 #include <inttypes.h>
 #include <set>
+#include <map>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/timer/timer.hpp>
 
 extern template class HashMap16BitFixedSize<cbhe_bundle_uuid_t, uint64_t>;
 extern template class HashMap16BitFixedSize<cbhe_bundle_uuid_nofragment_t, uint64_t>;
+extern template class OpenAddressingHashMap<cbhe_bundle_uuid_t, uint64_t>;
+extern template class OpenAddressingHashMap<cbhe_bundle_uuid_nofragment_t, uint64_t>;
 template <class uuidType>
 static void DoTest() {
     typedef typename HashMap16BitFixedSize<uuidType, uint64_t>::key_value_pair_t uuid_u64_t;
@@ -350,3 +357,159 @@ BOOST_AUTO_TEST_CASE(BundleUuidToUint64HashMapTestCase)
     DoTest<cbhe_bundle_uuid_t>();
     DoTest<cbhe_bundle_uuid_nofragment_t>();
 }
+
+//deterministic bundle uuid for the i'th bundle (many bundles per creation second from a few sources)
+static cbhe_bundle_uuid_t MakeTestUuid(const uint64_t i) {
+    return cbhe_bundle_uuid_t(
+        1000 + (i / 1000), //creationSeconds
+        i, // sequence,
+        10 + (i % 7), // srcNodeId,
+        20, // srcServiceId,
+        0, // fragmentOffset,
+        0 // dataLength
+    );
+}
+
+template <class uuidType>
+static void DoOpenAddressingTest() {
+    typedef OpenAddressingHashMap<uuidType, uint64_t> hashmap_t;
+    typedef typename hashmap_t::key_value_pair_t uuid_u64_t;
+
+    //insert twice (second time failing), get, and remove, both with real hashes and with every key forced to the same hash
+    for (unsigned int useSameHash = 0; useSameHash <= 1; ++useSameHash) {
+        hashmap_t hm;
+        uint64_t value = 0;
+        for (uint64_t i = 0; i < 100; ++i) {
+            const uuidType uuid(MakeTestUuid(i));
+            const uint64_t hash = (useSameHash) ? 1 : hashmap_t::GetHash(uuid);
+            const uuid_u64_t * p = hm.Insert(hash, uuid, i);
+            BOOST_REQUIRE(p != NULL);
+            BOOST_REQUIRE(p->first == uuid);
+            BOOST_REQUIRE_EQUAL(p->second, i);
+            BOOST_REQUIRE(hm.Insert(hash, uuid, i + 1) == NULL);
+        }
+        BOOST_REQUIRE_EQUAL(hm.GetSize(), 100);
+        for (uint64_t i = 0; i < 100; i += 2) {
+            const uuidType uuid(MakeTestUuid(i));
+            const uint64_t hash = (useSameHash) ? 1 : hashmap_t::GetHash(uuid);
+            BOOST_REQUIRE(hm.GetValueAndRemove(hash, uuid, value));
+            BOOST_REQUIRE_EQUAL(value, i);
+            BOOST_REQUIRE(!hm.GetValueAndRemove(hash, uuid, value)); //already removed
+        }
+        BOOST_REQUIRE_EQUAL(hm.GetSize(), 50);
+        for (uint64_t i = 0; i < 100; ++i) {
+            const uuidType uuid(MakeTestUuid(i));
+            const uint64_t hash = (useSameHash) ? 1 : hashmap_t::GetHash(uuid);
+            uint64_t * valuePtr = hm.GetValuePtr(hash, uuid);
+            if (i & 1) {
+                BOOST_REQUIRE(valuePtr != NULL);
+                BOOST_REQUIRE_EQUAL(*valuePtr, i);
+            }
+            else {
+                BOOST_REQUIRE(valuePtr == NULL);
+            }
+        }
+        hm.Clear();
+        BOOST_REQUIRE_EQUAL(hm.GetSize(), 0);
+        BOOST_REQUIRE(hm.GetValuePtr(MakeTestUuid(1)) == NULL);
+    }
+
+    //random inserts and removals checked against a std::map, with pointers returned by Insert staying valid as the table grows
+    {
+        hashmap_t hm;
+        std::map<uuidType, std::pair<uint64_t, const uuid_u64_t *> > referenceMap;
+        boost::random::mt19937 gen(12345);
+        boost::random::uniform_int_distribution<uint64_t> keyDist(0, 50000);
+        boost::random::uniform_int_distribution<unsigned int> opDist(0, 2);
+        for (unsigned int opCount = 0; opCount < 300000; ++opCount) {
+            const uint64_t i = keyDist(gen);
+            const uuidType uuid(MakeTestUuid(i));
+            const unsigned int op = opDist(gen);
+            if (op < 2) { //insert twice as often as remove so that the table grows
+                const uuid_u64_t * p = hm.Insert(uuid, opCount);
+                typename std::map<uuidType, std::pair<uint64_t, const uuid_u64_t *> >::iterator it = referenceMap.find(uuid);
+                if (it == referenceMap.end()) {
+                    BOOST_REQUIRE(p != NULL);
+                    referenceMap.emplace(uuid, std::pair<uint64_t, const uuid_u64_t *>(opCount, p));
+                }
+                else {
+                    BOOST_REQUIRE(p == NULL);
+                }
+            }
+            else {
+                uint64_t value;
+                const bool removed = hm.GetValueAndRemove(uuid, value);
+                typename std::map<uuidType, std::pair<uint64_t, const uuid_u64_t *> >::iterator it = referenceMap.find(uuid);
+                BOOST_REQUIRE_EQUAL(removed, (it != referenceMap.end()));
+                if (removed) {
+                    BOOST_REQUIRE_EQUAL(value, it->second.first);
+                    referenceMap.erase(it);
+                }
+            }
+        }
+        BOOST_REQUIRE_EQUAL(hm.GetSize(), referenceMap.size());
+        BOOST_REQUIRE_LE(hm.GetSize(), (hm.GetCapacity() / 8) * 7);
+        for (typename std::map<uuidType, std::pair<uint64_t, const uuid_u64_t *> >::const_iterator it = referenceMap.cbegin(); it != referenceMap.cend(); ++it) {
+            const uint64_t * valuePtr = hm.GetValuePtr(it->first);
+            BOOST_REQUIRE(valuePtr != NULL);
+            BOOST_REQUIRE_EQUAL(*valuePtr, it->second.first);
+            BOOST_REQUIRE(valuePtr == &it->second.second->second); //same address as returned by Insert
+            BOOST_REQUIRE(it->second.second->first == it->first);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(OpenAddressingHashMapTestCase)
+{
+    DoOpenAddressingTest<cbhe_bundle_uuid_t>();
+    DoOpenAddressingTest<cbhe_bundle_uuid_nofragment_t>();
+}
+
+template <class hashMapType>
+static void DoHashMapSpeedTest(const char * hashMapName, const uint64_t numEntries) {
+    std::unique_ptr<hashMapType> hmPtr(new hashMapType());
+    hashMapType & hm = *hmPtr;
+    double insertSeconds, lookupSeconds, eraseSeconds;
+    {
+        boost::timer::cpu_timer timer;
+        for (uint64_t i = 0; i < numEntries; ++i) {
+            BOOST_REQUIRE(hm.Insert(MakeTestUuid(i), i) != NULL);
+        }
+        insertSeconds = timer.elapsed().wall * 1e-9;
+    }
+    {
+        //look up in a different order than inserted
+        boost::timer::cpu_timer timer;
+        for (uint64_t j = 0; j < numEntries; ++j) {
+            const uint64_t i = (j * 7919) % numEntries; //7919 is prime so visits every entry
+            const uint64_t * valuePtr = hm.GetValuePtr(MakeTestUuid(i));
+            BOOST_REQUIRE(valuePtr != NULL);
+            BOOST_REQUIRE_EQUAL(*valuePtr, i);
+        }
+        lookupSeconds = timer.elapsed().wall * 1e-9;
+    }
+    {
+        boost::timer::cpu_timer timer;
+        uint64_t value;
+        for (uint64_t i = 0; i < numEntries; ++i) {
+            BOOST_REQUIRE(hm.GetValueAndRemove(MakeTestUuid(i), value));
+        }
+        eraseSeconds = timer.elapsed().wall * 1e-9;
+    }
+    std::cout << hashMapName << " " << numEntries << " entries: insert " << (numEntries / insertSeconds) * 1e-6
+        << " Mops/s, lookup " << (numEntries / lookupSeconds) * 1e-6
+        << " Mops/s, erase " << (numEntries / eraseSeconds) * 1e-6 << " Mops/s" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(BundleUuidToUint64HashMapSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_ENTRIES[] = { 1000000, 5000000, 10000000, 50000000 };
+    //the fixed 2^16 bucket map takes hours beyond this (every operation walks a list of numEntries/65536 entries)
+    static const uint64_t MAX_ENTRIES_HASHMAP16BITFIXEDSIZE = 5000000;
+    for (std::size_t i = 0; i < (sizeof(NUM_ENTRIES) / sizeof(NUM_ENTRIES[0])); ++i) {
+        if (NUM_ENTRIES[i] <= MAX_ENTRIES_HASHMAP16BITFIXEDSIZE) {
+            DoHashMapSpeedTest<HashMap16BitFixedSize<cbhe_bundle_uuid_t, uint64_t> >("HashMap16BitFixedSize", NUM_ENTRIES[i]);
+        }
+        DoHashMapSpeedTest<OpenAddressingHashMap<cbhe_bundle_uuid_t, uint64_t> >("OpenAddressingHashMap", NUM_ENTRIES[i]);
+    }
+}
@@ -0,0 +1,175 @@
+/**
+ * @file TestCatalogJournal.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <cstdio>
+#include <boost/filesystem.hpp>
+#include "CatalogJournal.h"
+
+static catalog_journal_entry_t MakeJournalEntry(const uint64_t custodyId) {
+    catalog_journal_entry_t entry;
+    entry.custodyId = custodyId;
+    entry.bundleUuid.creationSeconds = 1000 + custodyId;
+    entry.bundleUuid.sequence = custodyId;
+    entry.bundleUuid.srcEid.Set(1, 1);
+    entry.bundleUuid.fragmentOffset = 0;
+    entry.bundleUuid.dataLength = 0;
+    catalog_entry_t & catalogEntry = entry.catalogEntry;
+    catalogEntry.bundleSizeBytes = 500 + custodyId;
+    catalogEntry.segmentIdExtentVec.clear();
+    for (uint64_t i = 0; i <= (custodyId % 3); ++i) { //1 to 3 extents
+        catalogEntry.segmentIdExtentVec.emplace_back(static_cast<segment_id_t>((custodyId * 100) + (i * 10)), static_cast<segment_id_t>(i + 1));
+    }
+    catalogEntry.destEid.Set(2 + (custodyId % 5), 1);
+    catalogEntry.encodedAbsExpirationAndCustodyAndPriority = (custodyId << 4) | (custodyId % 3);
+    catalogEntry.sequence = custodyId;
+    catalogEntry.ptrUuidKeyInMap = NULL;
+    return entry;
+}
+
+static void RequireLiveEntries(const CatalogJournal & journal, const std::vector<uint64_t> & expectedCustodyIds) {
+    std::vector<catalog_journal_entry_t> liveEntries;
+    BOOST_REQUIRE(journal.ReadLiveEntries(liveEntries));
+    BOOST_REQUIRE_EQUAL(liveEntries.size(), expectedCustodyIds.size());
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        const catalog_journal_entry_t expected = MakeJournalEntry(expectedCustodyIds[i]);
+        BOOST_REQUIRE_EQUAL(liveEntries[i].custodyId, expected.custodyId);
+        BOOST_REQUIRE(liveEntries[i].bundleUuid == expected.bundleUuid);
+        BOOST_REQUIRE(liveEntries[i].catalogEntry == expected.catalogEntry);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CatalogJournalTestCase)
+{
+    const std::string journalPath = "catalogJournalUnitTest.bin";
+    const std::string checkpointPath = journalPath + ".checkpoint";
+    const uint64_t capacity = 8192000000;
+    std::vector<uint64_t> expectedCustodyIds;
+    uint64_t usedBytes;
+    {
+        CatalogJournal journal(journalPath, 2, capacity);
+        std::vector<catalog_journal_entry_t> liveEntries;
+        boost::filesystem::remove(journalPath);
+        BOOST_REQUIRE(!journal.ReadLiveEntries(liveEntries)); //doesn't exist
+        BOOST_REQUIRE(journal.BeginCheckpoint());
+        for (uint64_t custodyId = 0; custodyId < 100; ++custodyId) {
+            const catalog_journal_entry_t entry = MakeJournalEntry(custodyId);
+            BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+        }
+        BOOST_REQUIRE(!journal.ReadLiveEntries(liveEntries)); //checkpoint not committed
+        BOOST_REQUIRE(journal.CommitCheckpoint());
+        BOOST_REQUIRE(!boost::filesystem::exists(checkpointPath));
+        for (uint64_t custodyId = 0; custodyId < 100; custodyId += 2) {
+            BOOST_REQUIRE(journal.AppendRemove(custodyId));
+        }
+        BOOST_REQUIRE(!journal.AppendRemove(0)); //already removed
+        for (uint64_t custodyId = 100; custodyId < 200; ++custodyId) {
+            const catalog_journal_entry_t entry = MakeJournalEntry(custodyId);
+            BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+        }
+        BOOST_REQUIRE(!journal.AppendInsert(150, MakeJournalEntry(150).catalogEntry, MakeJournalEntry(150).bundleUuid)); //duplicate
+        for (uint64_t custodyId = 1; custodyId < 100; custodyId += 2) {
+            expectedCustodyIds.push_back(custodyId);
+        }
+        for (uint64_t custodyId = 100; custodyId < 200; ++custodyId) {
+            expectedCustodyIds.push_back(custodyId);
+        }
+        BOOST_REQUIRE_EQUAL(journal.GetNumLiveEntries(), expectedCustodyIds.size());
+        RequireLiveEntries(journal, expectedCustodyIds);
+        BOOST_REQUIRE_EQUAL(journal.GetNumCompactions(), 0);
+
+        //many short lived bundles fill the journal with removed bundles, forcing compactions which keep the live bundles in order
+        for (uint64_t custodyId = 1000; custodyId < 100000; ++custodyId) {
+            const catalog_journal_entry_t entry = MakeJournalEntry(custodyId);
+            BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+            if ((custodyId % 1000) == 0) {
+                expectedCustodyIds.push_back(custodyId);
+            }
+            else {
+                BOOST_REQUIRE(journal.AppendRemove(custodyId));
+            }
+        }
+        BOOST_REQUIRE_GT(journal.GetNumCompactions(), 0);
+        BOOST_REQUIRE_EQUAL(journal.GetNumLiveEntries(), expectedCustodyIds.size());
+        BOOST_REQUIRE_LT(journal.GetSizeBytes(), 4 * 1024 * 1024);
+        RequireLiveEntries(journal, expectedCustodyIds);
+
+        //one more bundle which will be torn
+        const catalog_journal_entry_t entry = MakeJournalEntry(200000);
+        BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+        usedBytes = journal.GetUsedBytes();
+    }
+
+    //a crash mid append leaves a torn last record, which ends the journal
+    {
+        FILE * fileHandle = fopen(journalPath.c_str(), "r+b");
+        BOOST_REQUIRE(fileHandle != NULL);
+        fseek(fileHandle, static_cast<long>(usedBytes - 1), SEEK_SET);
+        const uint8_t lastByte = static_cast<uint8_t>(fgetc(fileHandle));
+        fseek(fileHandle, static_cast<long>(usedBytes - 1), SEEK_SET);
+        fputc(lastByte ^ 0xff, fileHandle);
+        fclose(fileHandle);
+        CatalogJournal journal(journalPath, 2, capacity);
+        RequireLiveEntries(journal, expectedCustodyIds);
+    }
+
+    //a crash while writing a checkpoint leaves the journal intact
+    {
+        CatalogJournal journal(journalPath, 2, capacity);
+        BOOST_REQUIRE(journal.BeginCheckpoint());
+        const catalog_journal_entry_t entry = MakeJournalEntry(7);
+        BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+    }
+    BOOST_REQUIRE(boost::filesystem::exists(checkpointPath));
+    {
+        CatalogJournal journal(journalPath, 2, capacity);
+        RequireLiveEntries(journal, expectedCustodyIds);
+    }
+
+    //a journal written for a different storage configuration, or with a corrupt header, is rejected
+    {
+        std::vector<catalog_journal_entry_t> liveEntries;
+        CatalogJournal journalDifferentDisks(journalPath, 3, capacity);
+        BOOST_REQUIRE(!journalDifferentDisks.ReadLiveEntries(liveEntries));
+        CatalogJournal journalDifferentCapacity(journalPath, 2, capacity * 2);
+        BOOST_REQUIRE(!journalDifferentCapacity.ReadLiveEntries(liveEntries));
+
+        FILE * fileHandle = fopen(journalPath.c_str(), "r+b");
+        BOOST_REQUIRE(fileHandle != NULL);
+        fseek(fileHandle, 12, SEEK_SET);
+        fputc(3, fileHandle); //change number of disks without updating the header crc
+        fclose(fileHandle);
+        CatalogJournal journalCorruptHeader(journalPath, 3, capacity);
+        BOOST_REQUIRE(!journalCorruptHeader.ReadLiveEntries(liveEntries));
+    }
+
+    //a journal deleted after a failed write (here mid checkpoint) can never be replayed, and every later write fails
+    {
+        CatalogJournal journal(journalPath, 2, capacity);
+        BOOST_REQUIRE(journal.BeginCheckpoint());
+        const catalog_journal_entry_t entry = MakeJournalEntry(7);
+        BOOST_REQUIRE(journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+        journal.Delete();
+        BOOST_REQUIRE(!boost::filesystem::exists(journalPath));
+        BOOST_REQUIRE(!boost::filesystem::exists(checkpointPath));
+        BOOST_REQUIRE(!journal.AppendInsert(entry.custodyId, entry.catalogEntry, entry.bundleUuid));
+        BOOST_REQUIRE(!journal.AppendRemove(entry.custodyId));
+        BOOST_REQUIRE(!journal.CommitCheckpoint());
+        std::vector<catalog_journal_entry_t> liveEntries;
+        BOOST_REQUIRE(!journal.ReadLiveEntries(liveEntries));
+    }
+    boost::filesystem::remove(journalPath);
+    boost::filesystem::remove(checkpointPath);
+}
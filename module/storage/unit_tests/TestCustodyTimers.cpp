@@ -16,6 +16,7 @@
 #include <iostream>
 #include "CustodyTimers.h"
 #include <boost/thread.hpp>
+#include <boost/timer/timer.hpp>
 
     
 BOOST_AUTO_TEST_CASE(CustodyTimersTestCase)
@@ -161,3 +162,101 @@ BOOST_AUTO_TEST_CASE(CustodyTimersTestCase)
 
 
 }
+
+BOOST_AUTO_TEST_CASE(CustodyTimersWheelCascadeTestCase)
+{
+    static const cbhe_eid_t EID1(5, 5);
+    static const cbhe_eid_t EID2(10, 5);
+    static const std::vector<cbhe_eid_t> JUST_EID1_AVAILABLE_VEC = { EID1 };
+
+    //10 second timeout lands in the third level of the wheel and must cascade down twice
+    {
+        const boost::posix_time::time_duration timeout = boost::posix_time::seconds(10);
+        CustodyTimers ct(timeout);
+        const boost::posix_time::ptime startPtime = boost::posix_time::microsec_clock::universal_time();
+        for (uint64_t cid = 1; cid <= 100; ++cid) {
+            BOOST_REQUIRE(ct.StartCustodyTransferTimer(((cid & 1) ? EID1 : EID2), cid));
+        }
+        BOOST_REQUIRE(!ct.CancelCustodyTransferTimer(EID2, 1)); //wrong destination
+        BOOST_REQUIRE(ct.CancelCustodyTransferTimer(EID1, 51));
+        BOOST_REQUIRE_EQUAL(ct.GetNumCustodyTransferTimers(), 99);
+        uint64_t returnedCid;
+        BOOST_REQUIRE(!ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, startPtime + boost::posix_time::seconds(5)));
+        BOOST_REQUIRE(!ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, startPtime + timeout - boost::posix_time::milliseconds(1)));
+        const boost::posix_time::ptime expiredPtime = boost::posix_time::microsec_clock::universal_time() + timeout + boost::posix_time::milliseconds(1);
+        BOOST_REQUIRE(ct.PollOneAndPopExpiredCustodyTimer(returnedCid, JUST_EID1_AVAILABLE_VEC, expiredPtime));
+        BOOST_REQUIRE_EQUAL(returnedCid, 1);
+        for (uint64_t cid = 2; cid <= 100; ++cid) {
+            if (cid == 51) {
+                continue;
+            }
+            BOOST_REQUIRE(ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, expiredPtime));
+            BOOST_REQUIRE_EQUAL(returnedCid, cid); //fifo order across levels
+        }
+        BOOST_REQUIRE(!ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, expiredPtime));
+        BOOST_REQUIRE_EQUAL(ct.GetNumCustodyTransferTimers(), 0);
+        BOOST_REQUIRE_EQUAL(ct.GetNumCustodyTransferTimers(EID1), 0);
+
+        //node reuse after the wheel has advanced
+        BOOST_REQUIRE(ct.StartCustodyTransferTimer(EID2, 1));
+        BOOST_REQUIRE_EQUAL(ct.GetNumCustodyTransferTimers(EID2), 1);
+        BOOST_REQUIRE(!ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, boost::posix_time::microsec_clock::universal_time()));
+        BOOST_REQUIRE(ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, boost::posix_time::microsec_clock::universal_time() + timeout + boost::posix_time::milliseconds(1)));
+        BOOST_REQUIRE_EQUAL(returnedCid, 1);
+    }
+
+    //timeout beyond the horizon of the wheel
+    {
+        const boost::posix_time::time_duration timeout = boost::posix_time::hours(24 * 365 * 3);
+        CustodyTimers ct(timeout);
+        BOOST_REQUIRE(ct.StartCustodyTransferTimer(EID1, 1));
+        const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+        uint64_t returnedCid;
+        BOOST_REQUIRE(!ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, nowPtime + boost::posix_time::hours(24 * 365 * 2)));
+        BOOST_REQUIRE(ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, nowPtime + timeout + boost::posix_time::milliseconds(1)));
+        BOOST_REQUIRE_EQUAL(returnedCid, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CustodyTimersBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_TIMERS = 2000000;
+    static const uint64_t NUM_DEST_EIDS = 100;
+    std::vector<cbhe_eid_t> destEids;
+    for (uint64_t i = 0; i < NUM_DEST_EIDS; ++i) {
+        destEids.emplace_back(i + 1, 1);
+    }
+    const boost::posix_time::time_duration timeout = boost::posix_time::seconds(10);
+    CustodyTimers ct(timeout);
+    double startSeconds, cancelSeconds, expireSeconds;
+    {
+        boost::timer::cpu_timer timer;
+        for (uint64_t cid = 0; cid < NUM_TIMERS; ++cid) {
+            ct.StartCustodyTransferTimer(destEids[cid % NUM_DEST_EIDS], cid);
+        }
+        startSeconds = timer.elapsed().wall * 1e-9;
+    }
+    {
+        //custody signals for every other bundle
+        boost::timer::cpu_timer timer;
+        for (uint64_t cid = 0; cid < NUM_TIMERS; cid += 2) {
+            ct.CancelCustodyTransferTimer(destEids[cid % NUM_DEST_EIDS], cid);
+        }
+        cancelSeconds = timer.elapsed().wall * 1e-9;
+    }
+    uint64_t countPops = 0;
+    {
+        const boost::posix_time::ptime expiredPtime = boost::posix_time::microsec_clock::universal_time() + timeout + boost::posix_time::seconds(1);
+        boost::timer::cpu_timer timer;
+        uint64_t returnedCid;
+        while (ct.PollOneAndPopAnyExpiredCustodyTimer(returnedCid, expiredPtime)) {
+            ++countPops;
+        }
+        expireSeconds = timer.elapsed().wall * 1e-9;
+    }
+    BOOST_REQUIRE_EQUAL(countPops, NUM_TIMERS / 2);
+    BOOST_REQUIRE_EQUAL(ct.GetNumCustodyTransferTimers(), 0);
+    std::cout << "CustodyTimers " << NUM_TIMERS << " timers across " << NUM_DEST_EIDS << " destinations: start " << (NUM_TIMERS / startSeconds) * 1e-6
+        << " Mops/s, cancel " << ((NUM_TIMERS / 2) / cancelSeconds) * 1e-6
+        << " Mops/s, expire " << ((NUM_TIMERS / 2) / expireSeconds) * 1e-6 << " Mops/s" << std::endl;
+}
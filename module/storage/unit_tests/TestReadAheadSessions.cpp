@@ -0,0 +1,168 @@
+/**
+ * @file TestReadAheadSessions.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <boost/make_unique.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include "ReadAheadSessions.h"
+#include "BundleStorageManagerMT.h"
+#include "BundleStorageManagerAsio.h"
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+#include "BundleStorageManagerIoUring.h"
+#define NUM_BSM_IMPLEMENTATIONS_TO_TEST 3
+#else
+#define NUM_BSM_IMPLEMENTATIONS_TO_TEST 2
+#endif
+#include "Environment.h"
+
+//the read-ahead of storage's release stage, with a custody signal removing a bundle whose read is in flight
+BOOST_AUTO_TEST_CASE(ReadAheadSessionsCancelTestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < NUM_BSM_IMPLEMENTATIONS_TO_TEST; ++whichBsm) {
+        boost::random::mt19937 gen(static_cast<unsigned int>(whichBsm));
+        const boost::random::uniform_int_distribution<> distRandomData(0, 255);
+        const cbhe_eid_t linkDestEid(1, 1);
+        const cbhe_eid_t otherLinkDestEid(2, 1);
+
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+        StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+        ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+        ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+        if (whichBsm == 0) {
+            std::cout << "create BundleStorageManagerMT for ReadAheadSessions" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+        }
+        else if (whichBsm == 1) {
+            std::cout << "create BundleStorageManagerAsio for ReadAheadSessions" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+        }
+#ifdef STORAGE_IO_URING_SUPPORT_ENABLED
+        else {
+            std::cout << "create BundleStorageManagerIoUring for ReadAheadSessions" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
+#endif
+        BundleStorageManagerBase & bsm = *bsmPtr;
+        bsm.Start();
+
+        //4 bundles for the link, custody ids 0 to 3
+        static const uint64_t BUNDLE_SIZE = 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+        std::vector<uint8_t> bundles[4];
+        for (unsigned int i = 0; i < 4; ++i) {
+            bundles[i].resize(BUNDLE_SIZE);
+            for (std::size_t j = 0; j < BUNDLE_SIZE; ++j) {
+                bundles[i][j] = distRandomData(gen);
+            }
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(100, 1);
+            primary.m_destinationEid = linkDestEid;
+            primary.m_custodianEid.SetZero();
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = i;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, BUNDLE_SIZE), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, i, bundles[i].data(), BUNDLE_SIZE), BUNDLE_SIZE);
+        }
+
+        //link up: 3 sessions for up to 4 bundles per link, so the 4th bundle waits for a session
+        const uint64_t releaseIndexId = bsm.CreateReleaseIndex(std::vector<std::pair<cbhe_eid_t, bool> >(1, std::pair<cbhe_eid_t, bool>(linkDestEid, false)));
+        const uint64_t otherReleaseIndexId = bsm.CreateReleaseIndex(std::vector<std::pair<cbhe_eid_t, bool> >(1, std::pair<cbhe_eid_t, bool>(otherLinkDestEid, false)));
+        BOOST_REQUIRE_NE(releaseIndexId, 0);
+        BOOST_REQUIRE_NE(otherReleaseIndexId, 0);
+        ReadAheadSessions readAheadSessions(4, 3);
+        ReadAheadSessions::queue_t readAheadQueue;
+        ReadAheadSessions::queue_t otherReadAheadQueue;
+        readAheadSessions.Fill(bsm, readAheadQueue, releaseIndexId);
+        readAheadSessions.Fill(bsm, otherReadAheadQueue, otherReleaseIndexId);
+        BOOST_REQUIRE_EQUAL(readAheadQueue.size(), 3);
+        BOOST_REQUIRE(otherReadAheadQueue.empty());
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumSessionsAllocated(), 3);
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumFreeSessions(), 0);
+        for (unsigned int i = 0; i < 3; ++i) {
+            BOOST_REQUIRE_EQUAL(readAheadQueue[i]->custodyId, i);
+        }
+
+        //a custody signal for custody id 1 (as applied by ZmqStorageInterface): cancel its read-ahead, then remove it from disk
+        catalog_entry_t * const catalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(1);
+        BOOST_REQUIRE(catalogEntryPtr != NULL);
+        BOOST_REQUIRE(!readAheadSessions.Cancel(bsm, otherReadAheadQueue, 1)); //not popped by the other link
+        BOOST_REQUIRE(readAheadSessions.Cancel(bsm, readAheadQueue, 1));
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(catalogEntryPtr, 1));
+        BOOST_REQUIRE(bsm.GetCatalogEntryPtrFromCustodyId(1) == NULL);
+        BOOST_REQUIRE(!readAheadSessions.Cancel(bsm, readAheadQueue, 1)); //already gone
+        BOOST_REQUIRE_EQUAL(readAheadQueue.size(), 2);
+        BOOST_REQUIRE_EQUAL(readAheadQueue[0]->custodyId, 0);
+        BOOST_REQUIRE_EQUAL(readAheadQueue[1]->custodyId, 2);
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumFreeSessions(), 1);
+
+        //the freed session reads ahead the 4th bundle, and the removed bundle is not popped again
+        readAheadSessions.Fill(bsm, readAheadQueue, releaseIndexId);
+        BOOST_REQUIRE_EQUAL(readAheadQueue.size(), 3);
+        BOOST_REQUIRE_EQUAL(readAheadQueue[2]->custodyId, 3);
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumSessionsAllocated(), 3);
+
+        //release the link's bundles (as ZmqStorageInterface's ReleaseOne_NoBlock does): the cancelled bundle is never released
+        static const uint64_t expectedReleasedCustodyIds[3] = { 0, 2, 3 };
+        std::vector<uint8_t> dataReadBack;
+        for (unsigned int i = 0; i < 3; ++i) {
+            ReadAheadSessions::session_ptr_t sessionPtr = std::move(readAheadQueue.front());
+            readAheadQueue.pop_front();
+            const uint64_t custodyId = sessionPtr->custodyId;
+            BOOST_REQUIRE_EQUAL(custodyId, expectedReleasedCustodyIds[i]);
+            BOOST_REQUIRE(bsm.ReadAllSegments(*sessionPtr, dataReadBack));
+            BOOST_REQUIRE(dataReadBack == bundles[custodyId]);
+            BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(*sessionPtr));
+            readAheadSessions.Free(std::move(sessionPtr));
+            readAheadSessions.Fill(bsm, readAheadQueue, releaseIndexId);
+        }
+        BOOST_REQUIRE(readAheadQueue.empty());
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumFreeSessions(), 3);
+
+        //link down with a bundle read ahead: it is returned to the awaiting send and popped again
+        {
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | (BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT);
+            primary.m_sourceNodeId.Set(100, 1);
+            primary.m_destinationEid = linkDestEid;
+            primary.m_custodianEid.SetZero();
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = 4;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, BUNDLE_SIZE), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, 4, bundles[0].data(), BUNDLE_SIZE), BUNDLE_SIZE);
+        }
+        readAheadSessions.Fill(bsm, readAheadQueue, releaseIndexId);
+        BOOST_REQUIRE_EQUAL(readAheadQueue.size(), 1);
+        readAheadSessions.ReturnAll(bsm, readAheadQueue);
+        BOOST_REQUIRE(readAheadQueue.empty());
+        BOOST_REQUIRE_EQUAL(readAheadSessions.GetNumFreeSessions(), 3);
+        BundleStorageManagerSession_ReadFromDisk sessionRead;
+        BOOST_REQUIRE_EQUAL(bsm.PopTopFromReleaseIndex(sessionRead, releaseIndexId), BUNDLE_SIZE);
+        BOOST_REQUIRE_EQUAL(sessionRead.custodyId, 4);
+        BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+        BOOST_REQUIRE(dataReadBack == bundles[0]);
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+        BOOST_REQUIRE_EQUAL(bsm.PopTopFromReleaseIndex(sessionRead, releaseIndexId), 0);
+        BOOST_REQUIRE(bsm.DeleteReleaseIndex(releaseIndexId));
+        BOOST_REQUIRE(bsm.DeleteReleaseIndex(otherReleaseIndexId));
+    }
+}
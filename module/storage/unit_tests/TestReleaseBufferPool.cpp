@@ -0,0 +1,88 @@
+/**
+ * @file TestReleaseBufferPool.cpp
+ * @author  Brian Tomko <brian.j.tomko@nasa.gov>
+ *
+ * @copyright Copyright  2021 United States Government as represented by
+ * the National Aeronautics and Space Administration.
+ * No copyright is claimed in the United States under Title 17, U.S.Code.
+ * All Other Rights Reserved.
+ *
+ * @section LICENSE
+ * Released under the NASA Open Source Agreement (NOSA)
+ * See LICENSE.md in the source root directory for more information.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <boost/thread.hpp>
+#include "ReleaseBufferPool.h"
+
+BOOST_AUTO_TEST_CASE(ReleaseBufferPoolTestCase)
+{
+    {
+        ReleaseBufferPool pool(100000);
+        const void * firstBufferData;
+        {
+            zmq::message_t message = pool.AllocateMessage(5000);
+            BOOST_REQUIRE_EQUAL(message.size(), 5000);
+            memset(message.data(), 0xab, message.size());
+            firstBufferData = message.data();
+            BOOST_REQUIRE_EQUAL(pool.GetNumBuffersOutstanding(), 1);
+            BOOST_REQUIRE_EQUAL(pool.GetFreeBytes(), 0);
+        }
+        //freeing the message returns the 8KB buffer to its free list
+        BOOST_REQUIRE_EQUAL(pool.GetNumBuffersOutstanding(), 0);
+        BOOST_REQUIRE_EQUAL(pool.GetFreeBytes(), 8192);
+        {
+            zmq::message_t messageSameSizeClass = pool.AllocateMessage(8000);
+            BOOST_REQUIRE_EQUAL(messageSameSizeClass.size(), 8000);
+            BOOST_REQUIRE(messageSameSizeClass.data() == firstBufferData);
+            BOOST_REQUIRE_EQUAL(pool.GetNumBuffersReused(), 1);
+            zmq::message_t messageOtherSizeClass = pool.AllocateMessage(100);
+            BOOST_REQUIRE(messageOtherSizeClass.data() != firstBufferData);
+            BOOST_REQUIRE_EQUAL(pool.GetNumBuffersAllocated(), 2);
+            BOOST_REQUIRE_EQUAL(pool.GetFreeBytes(), 0);
+        }
+        BOOST_REQUIRE_EQUAL(pool.GetFreeBytes(), 8192 + 4096);
+
+        //returned buffers beyond maxFreeBytes are deleted
+        {
+            std::vector<zmq::message_t> messages;
+            for (unsigned int i = 0; i < 20; ++i) {
+                messages.push_back(pool.AllocateMessage(8192));
+            }
+            BOOST_REQUIRE_EQUAL(pool.GetFreeBytes(), 4096);
+        }
+        BOOST_REQUIRE_EQUAL(pool.GetNumBuffersOutstanding(), 0);
+        BOOST_REQUIRE_LE(pool.GetFreeBytes(), 100000);
+        BOOST_REQUIRE_GT(pool.GetFreeBytes(), 100000 - 8192);
+
+        //messages larger than the largest size class are not pooled
+        {
+            zmq::message_t message = pool.AllocateMessage(100000000);
+            BOOST_REQUIRE_EQUAL(message.size(), 100000000);
+        }
+        BOOST_REQUIRE_LE(pool.GetFreeBytes(), 100000);
+    }
+
+    //messages may be freed on other threads, and after the pool is destroyed
+    {
+        std::unique_ptr<zmq::message_t> outlivingMessagePtr;
+        {
+            ReleaseBufferPool pool(1000000);
+            std::vector<zmq::message_t> messages;
+            for (unsigned int i = 0; i < 100; ++i) {
+                messages.push_back(pool.AllocateMessage(1000 + (i * 100)));
+            }
+            boost::thread freeingThread([&messages]() { messages.clear(); });
+            freeingThread.join();
+            BOOST_REQUIRE_EQUAL(pool.GetNumBuffersOutstanding(), 0);
+            outlivingMessagePtr.reset(new zmq::message_t(pool.AllocateMessage(4096)));
+            BOOST_REQUIRE_EQUAL(pool.GetNumBuffersOutstanding(), 1);
+        }
+        memset(outlivingMessagePtr->data(), 0, outlivingMessagePtr->size());
+        outlivingMessagePtr.reset();
+    }
+}